@@ -41,6 +41,15 @@ namespace itk
  *  array view. This permits passing image buffers into python arrays from
  *  the NumPy python package.
  *
+ *  No memory is copied in either direction. An image viewing an array
+ *  holds the buffer of the array in a PyImportImageContainer, which keeps
+ *  the array alive for as long as the image uses it. An array viewing an
+ *  image can hold a reference to the pixel container of the image, which
+ *  keeps the memory valid after the image is destroyed or releases its
+ *  pixel container, e.g. by Initialize(). The view is invalidated when the
+ *  buffer of the container is reallocated, e.g. by Allocate() for a larger
+ *  region, since the container then frees its previous memory.
+ *
  *  \ingroup ITKBridgeNumPy
  */
 template <typename TImage>
@@ -59,6 +68,7 @@ public:
   using PointType = typename ImageType::PointType;
   using SpacingType = typename ImageType::SpacingType;
   using ImagePointer = typename ImageType::Pointer;
+  using PixelContainerType = typename ImageType::PixelContainer;
   using ComponentType = typename DefaultConvertPixelTraits<PixelType>::ComponentType;
 
   /** Image dimension. */
@@ -72,11 +82,23 @@ public:
   static PyObject *
   _GetArrayViewFromImage(ImageType * image);
 
+  /**
+   * Get a Python capsule holding a reference to the pixel container of the
+   * image. The pixel container, and thus the memory of an array view of the
+   * image, lives at least as long as the capsule.
+   */
+  static PyObject *
+  _GetPixelContainerReferenceFromImage(ImageType * image);
+
   /**
    * Get an ITK image from a Python array
    */
   static const OutputImagePointer
   _GetImageViewFromArray(PyObject * arr, PyObject * shape, PyObject * numOfComponent);
+
+private:
+  static void
+  ReleasePixelContainerReference(PyObject * capsule);
 };
 
 } // namespace itk
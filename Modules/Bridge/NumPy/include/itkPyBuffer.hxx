@@ -20,7 +20,7 @@
 
 #include "itkPyBuffer.h"
 
-#include "itkImportImageContainer.h"
+#include "itkPyImportImageContainer.h"
 
 namespace itk
 {
@@ -69,6 +69,37 @@ PyBuffer<TImage>::_GetArrayViewFromImage(ImageType * image)
   return memoryView;
 }
 
+template <class TImage>
+PyObject *
+PyBuffer<TImage>::_GetPixelContainerReferenceFromImage(ImageType * image)
+{
+  if (!image)
+  {
+    throw std::runtime_error("Input image is null");
+  }
+
+  PixelContainerType * container = image->GetPixelContainer();
+  container->Register();
+
+  PyObject * capsule = PyCapsule_New(static_cast<void *>(container), nullptr, &Self::ReleasePixelContainerReference);
+  if (capsule == nullptr)
+  {
+    container->UnRegister();
+  }
+  return capsule;
+}
+
+template <class TImage>
+void
+PyBuffer<TImage>::ReleasePixelContainerReference(PyObject * capsule)
+{
+  auto * container = static_cast<PixelContainerType *>(PyCapsule_GetPointer(capsule, nullptr));
+  if (container)
+  {
+    container->UnRegister();
+  }
+}
+
 template <class TImage>
 const typename PyBuffer<TImage>::OutputImagePointer
 PyBuffer<TImage>::_GetImageViewFromArray(PyObject * arr, PyObject * shape, PyObject * numOfComponent)
@@ -76,16 +107,13 @@ PyBuffer<TImage>::_GetImageViewFromArray(PyObject * arr, PyObject * shape, PyObj
   PyObject * shapeseq = NULL;
   PyObject * item = NULL;
 
-  Py_ssize_t bufferLength;
-  Py_buffer  pyBuffer;
+  Py_buffer pyBuffer;
   memset(&pyBuffer, 0, sizeof(Py_buffer));
 
   SizeType      size;
   SizeType      sizeFortran;
   SizeValueType numberOfPixels = 1;
 
-  const void * buffer;
-
   long         numberOfComponents = 1;
   unsigned int dimension = 0;
 
@@ -93,18 +121,13 @@ PyBuffer<TImage>::_GetImageViewFromArray(PyObject * arr, PyObject * shape, PyObj
   size_t pixelSize = sizeof(ComponentType);
   size_t len = 1;
 
+  // The buffer view is held by the pixel container of the image, which
+  // keeps the array alive and prevents it from resizing its memory
   if (PyObject_GetBuffer(arr, &pyBuffer, PyBUF_ND | PyBUF_ANY_CONTIGUOUS) == -1)
   {
     PyErr_SetString(PyExc_RuntimeError, "Cannot get an instance of NumPy array.");
-    PyBuffer_Release(&pyBuffer);
     return nullptr;
   }
-  else
-  {
-    bufferLength = pyBuffer.len;
-    buffer = pyBuffer.buf;
-  }
-  PyBuffer_Release(&pyBuffer);
 
   shapeseq = PySequence_Fast(shape, "expected sequence");
   dimension = PySequence_Size(shape);
@@ -126,7 +149,7 @@ PyBuffer<TImage>::_GetImageViewFromArray(PyObject * arr, PyObject * shape, PyObj
   }
 
   len = numberOfPixels * numberOfComponents * pixelSize;
-  if (bufferLength != len)
+  if (static_cast<size_t>(pyBuffer.len) != len)
   {
     PyErr_SetString(PyExc_RuntimeError, "Size mismatch of image and Buffer.");
     PyBuffer_Release(&pyBuffer);
@@ -155,22 +178,21 @@ PyBuffer<TImage>::_GetImageViewFromArray(PyObject * arr, PyObject * shape, PyObj
   SpacingType spacing;
   spacing.Fill(1.0);
 
+  // The number of elements of the container is the number of pixels for
+  // Image, and the number of pixel components for VectorImage
   using InternalPixelType = typename TImage::InternalPixelType;
-  using ImporterType = ImportImageContainer<SizeValueType, InternalPixelType>;
-  typename ImporterType::Pointer importer = ImporterType::New();
-  constexpr bool                 importImageFilterWillOwnTheBuffer = false;
-  InternalPixelType *            data = (InternalPixelType *)buffer;
-  importer->SetImportPointer(data, numberOfPixels, importImageFilterWillOwnTheBuffer);
+  using ContainerType = PyImportImageContainer<SizeValueType, InternalPixelType>;
+  typename ContainerType::Pointer container = ContainerType::New();
+  container->SetImportBuffer(pyBuffer);
 
   OutputImagePointer output = TImage::New();
   output->SetRegions(region);
   output->SetOrigin(origin);
   output->SetSpacing(spacing);
-  output->SetPixelContainer(importer);
+  output->SetPixelContainer(container);
   output->SetNumberOfComponentsPerPixel(numberOfComponents);
 
   Py_DECREF(shapeseq);
-  PyBuffer_Release(&pyBuffer);
 
   return output;
 }
@@ -0,0 +1,110 @@
+/*=========================================================================
+ *
+ *  Copyright NumFOCUS
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#ifndef itkPyImportImageContainer_h
+#define itkPyImportImageContainer_h
+
+#include "itkImportImageContainer.h"
+
+// The python header defines _POSIX_C_SOURCE without a preceding #undef
+#undef _POSIX_C_SOURCE
+#undef _XOPEN_SOURCE
+#include <Python.h>
+
+namespace itk
+{
+
+/**
+ *\class PyImportImageContainer
+ *
+ *  \brief Image container viewing the memory of a Python buffer.
+ *
+ *  This container imports the memory exported by a Python object through
+ *  the buffer protocol, e.g. a NumPy array, without copying it. The
+ *  container holds the buffer view for as long as it uses the memory, so
+ *  the exporting object is kept alive, and cannot resize its memory, for
+ *  as long as any image refers to the container, even after the Python
+ *  reference to the image has been dropped.
+ *
+ *  The view is released when the container is destroyed or when it
+ *  stops using the imported memory, e.g. after Initialize() or a Reserve()
+ *  which reallocates the buffer.
+ *
+ *  \ingroup ITKBridgeNumPy
+ */
+template <typename TElementIdentifier, typename TElement>
+class ITK_TEMPLATE_EXPORT PyImportImageContainer : public ImportImageContainer<TElementIdentifier, TElement>
+{
+public:
+  ITK_DISALLOW_COPY_AND_ASSIGN(PyImportImageContainer);
+
+  /** Standard class type aliases. */
+  using Self = PyImportImageContainer;
+  using Superclass = ImportImageContainer<TElementIdentifier, TElement>;
+  using Pointer = SmartPointer<Self>;
+  using ConstPointer = SmartPointer<const Self>;
+
+  /** Save the template parameters. */
+  using ElementIdentifier = TElementIdentifier;
+  using Element = TElement;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro(Self);
+
+  /** Standard part of every itk Object. */
+  itkTypeMacro(PyImportImageContainer, ImportImageContainer);
+
+  /** Import the memory of a buffer view obtained with PyObject_GetBuffer().
+   * The container takes over the view: it is released by the container,
+   * and the obj member of the given view is reset so that the caller does
+   * not release it a second time. The number of elements is the length
+   * of the buffer divided by the size of an element. */
+  void
+  SetImportBuffer(Py_buffer & buffer);
+
+  /** Return true while the container holds a buffer view. */
+  bool
+  HasImportBuffer() const
+  {
+    return m_Buffer.obj != nullptr;
+  }
+
+protected:
+  PyImportImageContainer();
+  ~PyImportImageContainer() override;
+
+  void
+  PrintSelf(std::ostream & os, Indent indent) const override;
+
+  /** Release the buffer view in addition to the managed memory. */
+  void
+  DeallocateManagedMemory() override;
+
+private:
+  void
+  ReleaseBuffer();
+
+  Py_buffer m_Buffer;
+};
+} // end namespace itk
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#  include "itkPyImportImageContainer.hxx"
+#endif
+
+#endif
@@ -0,0 +1,90 @@
+/*=========================================================================
+ *
+ *  Copyright NumFOCUS
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkPyImportImageContainer_hxx
+#define itkPyImportImageContainer_hxx
+
+#include "itkPyImportImageContainer.h"
+
+namespace itk
+{
+template <typename TElementIdentifier, typename TElement>
+PyImportImageContainer<TElementIdentifier, TElement>::PyImportImageContainer()
+{
+  memset(&m_Buffer, 0, sizeof(Py_buffer));
+}
+
+template <typename TElementIdentifier, typename TElement>
+PyImportImageContainer<TElementIdentifier, TElement>::~PyImportImageContainer()
+{
+  // The destructor of the superclass does not call the override of
+  // DeallocateManagedMemory
+  this->ReleaseBuffer();
+}
+
+template <typename TElementIdentifier, typename TElement>
+void
+PyImportImageContainer<TElementIdentifier, TElement>::SetImportBuffer(Py_buffer & buffer)
+{
+  // Releases a previously imported view before taking over the new one
+  const auto numberOfElements = static_cast<TElementIdentifier>(buffer.len / sizeof(TElement));
+  this->SetImportPointer(static_cast<TElement *>(buffer.buf), numberOfElements, false);
+
+  m_Buffer = buffer;
+  buffer.obj = nullptr;
+}
+
+template <typename TElementIdentifier, typename TElement>
+void
+PyImportImageContainer<TElementIdentifier, TElement>::DeallocateManagedMemory()
+{
+  Superclass::DeallocateManagedMemory();
+  this->ReleaseBuffer();
+}
+
+template <typename TElementIdentifier, typename TElement>
+void
+PyImportImageContainer<TElementIdentifier, TElement>::ReleaseBuffer()
+{
+  if (m_Buffer.obj == nullptr)
+  {
+    return;
+  }
+
+  // The last reference to the container may be dropped by a thread which
+  // does not hold the GIL, e.g. when a pipeline is destroyed in C++. After
+  // the interpreter is finalized, the exporting object is already gone.
+  if (Py_IsInitialized())
+  {
+    const PyGILState_STATE gilState = PyGILState_Ensure();
+    PyBuffer_Release(&m_Buffer);
+    PyGILState_Release(gilState);
+  }
+  memset(&m_Buffer, 0, sizeof(Py_buffer));
+}
+
+template <typename TElementIdentifier, typename TElement>
+void
+PyImportImageContainer<TElementIdentifier, TElement>::PrintSelf(std::ostream & os, Indent indent) const
+{
+  Superclass::PrintSelf(os, indent);
+
+  os << indent << "Holds Python buffer: " << (this->HasImportBuffer() ? "true" : "false") << std::endl;
+}
+} // end namespace itk
+
+#endif
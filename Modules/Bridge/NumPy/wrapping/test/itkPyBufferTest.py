@@ -19,6 +19,8 @@
 import sys
 import unittest
 import datetime as dt
+import gc
+import weakref
 
 import itk
 import numpy as np
@@ -237,5 +239,76 @@ class TestNumpyITKMemoryviewInterface(unittest.TestCase):
         assert not data.flags['F_CONTIGUOUS']
         image = itk.image_from_array(data)
 
+    def test_NumPyBridge_ImageViewOwnsArray(self):
+        "Check that the pixel container of an image view keeps the array alive"
+
+        Dimension = 2
+        ImageType = itk.Image[itk.F, Dimension]
+
+        arr = np.arange(20, dtype=np.float32).reshape(4, 5)
+        arr_ref = weakref.ref(arr)
+        image = itk.PyBuffer[ImageType].GetImageViewFromArray(arr)
+
+        duplicator = itk.ImageDuplicator[ImageType].New()
+        duplicator.SetInputImage(image)
+        del image
+        del arr
+        gc.collect()
+        self.assertIsNotNone(arr_ref())
+
+        duplicator.Update()
+        result = itk.PyBuffer[ImageType].GetArrayFromImage(duplicator.GetOutput())
+        self.assertTrue(np.array_equal(result, np.arange(20, dtype=np.float32).reshape(4, 5)))
+
+        del duplicator
+        gc.collect()
+        self.assertIsNone(arr_ref())
+
+    def test_NumPyBridge_ArrayViewOwnsPixelContainer(self):
+        "Check that an array view stays valid after the image drops its buffer"
+
+        Dimension = 2
+        ImageType = itk.Image[itk.F, Dimension]
+
+        region = itk.ImageRegion[Dimension]()
+        region.SetSize(0, 5)
+        region.SetSize(1, 4)
+
+        image = ImageType.New()
+        image.SetRegions(region)
+        image.Allocate()
+        image.FillBuffer(7.0)
+
+        view = itk.PyBuffer[ImageType].GetArrayViewFromImage(image)
+        self.assertTrue(hasattr(view, 'itk_buffer'))
+        self.assertIsNotNone(view[1:].itk_buffer)
+
+        image.Initialize()
+        del image
+        gc.collect()
+        self.assertTrue(np.all(view == 7.0))
+
+    def test_NumPyBridge_VectorImageViewSharesMemory(self):
+        "Check that a VectorImage view and its array share their memory"
+
+        Dimension = 2
+        VectorImageType = itk.VectorImage[itk.F, Dimension]
+
+        arr = np.zeros((4, 5, 3), dtype=np.float32)
+        image = itk.PyBuffer[VectorImageType].GetImageViewFromArray(arr, is_vector=True)
+        self.assertEqual(image.GetNumberOfComponentsPerPixel(), 3)
+
+        arr[2, 1, 0] = 5.0
+        arr[2, 1, 2] = 6.0
+        index = itk.Index[Dimension]()
+        index[0] = 1
+        index[1] = 2
+        pixel = image.GetPixel(index)
+        self.assertEqual(pixel.GetElement(0), 5.0)
+        self.assertEqual(pixel.GetElement(2), 6.0)
+
+        view = itk.PyBuffer[VectorImageType].GetArrayViewFromImage(image)
+        self.assertTrue(np.shares_memory(view, arr))
+
 if __name__ == '__main__':
     unittest.main(verbosity=2)
@@ -0,0 +1,290 @@
+/*=========================================================================
+ *
+ *  Copyright NumFOCUS
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkRLEImage_h
+#define itkRLEImage_h
+
+#include "itkImage.h"
+#include "itkVectorContainer.h"
+
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace itk
+{
+/**
+ * \class RLEImage
+ *
+ * \brief Run-length encoded image, mostly useful for label images.
+ *
+ * \par
+ * Each line of the buffered region along the first axis is stored as a
+ * sequence of runs, a run being a pair made of a number of pixels and of
+ * their value. Label images with large homogeneous areas, such as the ones
+ * produced by LabelMapToLabelImageFilter, then take a tiny fraction of the
+ * memory of an equivalent Image.
+ *
+ * \par
+ * The lines are indexed by the coordinates along the other axes, which gives
+ * a constant time access to a line. Random access to a pixel with GetPixel()
+ * and SetPixel() is linear in the number of runs of its line; SetPixel()
+ * should only be used for sparse modifications.
+ *
+ * \par
+ * Filters access the pixels through specializations of the region, scanline
+ * and linear iterators for this class, which decode a single line at a time
+ * and encode it back when the iterator leaves it. Any filter using only those
+ * iterators, such as the functor based filters (thresholding, casting...),
+ * LabelStatisticsImageFilter, LabelImageToLabelMapFilter and
+ * LabelMapToLabelImageFilter, consumes and produces an RLEImage without
+ * expanding it. ImageFileWriter expands the region written at once. Filters
+ * which need a dense image, like the ones based on neighborhood iterators,
+ * are connected through a CastImageFilter to Image, and the pipeline
+ * streaming then bounds the size of the expanded region.
+ *
+ * \par
+ * Each line is locked while it is decoded or encoded by GetLineValues(),
+ * SetLineValues() and FillLineValues(). The iterators use the first two.
+ * Multithreaded filters are then safe even when the regions of the threads
+ * share lines, as when the default region splitter splits a region made of a
+ * single line along the first axis: the spans of the threads are encoded one
+ * after the other, and the runs outside of a span are kept. The lines are not
+ * locked by GetPixel(), SetPixel() and GetLine().
+ *
+ * \tparam TPixel the pixel type, which must be comparable with operator==
+ * \tparam VImageDimension the image dimension
+ * \tparam CounterType the type used to store the length of a run. Runs
+ * longer than its maximum value are split.
+ *
+ * \sa Image
+ * \sa LabelMap
+ *
+ * \ingroup ImageObjects
+ * \ingroup ITKCommon
+ */
+template <typename TPixel, unsigned int VImageDimension = 3, typename CounterType = unsigned short>
+class ITK_TEMPLATE_EXPORT RLEImage : public ImageBase<VImageDimension>
+{
+public:
+  ITK_DISALLOW_COPY_AND_ASSIGN(RLEImage);
+
+  /** Standard class type aliases */
+  using Self = RLEImage;
+  using Superclass = ImageBase<VImageDimension>;
+  using Pointer = SmartPointer<Self>;
+  using ConstPointer = SmartPointer<const Self>;
+  using ConstWeakPointer = WeakPointer<const Self>;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro(Self);
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro(RLEImage, ImageBase);
+
+  /** Pixel type alias support. */
+  using PixelType = TPixel;
+  using ValueType = TPixel;
+  using InternalPixelType = TPixel;
+  using IOPixelType = PixelType;
+
+  /** Accessor type that convert data between internal and external
+   *  representations. */
+  using AccessorType = DefaultPixelAccessor<PixelType>;
+  using AccessorFunctorType = DefaultPixelAccessorFunctor<Self>;
+
+  /** Dimension of the image. */
+  static constexpr unsigned int ImageDimension = VImageDimension;
+
+  /** Types derived from the Superclass */
+  using IndexType = typename Superclass::IndexType;
+  using IndexValueType = typename Superclass::IndexValueType;
+  using OffsetType = typename Superclass::OffsetType;
+  using OffsetValueType = typename Superclass::OffsetValueType;
+  using SizeType = typename Superclass::SizeType;
+  using SizeValueType = typename Superclass::SizeValueType;
+  using DirectionType = typename Superclass::DirectionType;
+  using RegionType = typename Superclass::RegionType;
+  using SpacingType = typename Superclass::SpacingType;
+  using SpacingValueType = typename Superclass::SpacingValueType;
+  using PointType = typename Superclass::PointType;
+
+  /** A run of pixels with the same value, and a line made of runs. */
+  using RunLengthCounterType = CounterType;
+  using RLSegment = std::pair<CounterType, PixelType>;
+  using RLLine = std::vector<RLSegment>;
+
+  /** Container of the lines of the buffered region. */
+  using LineContainerType = VectorContainer<SizeValueType, RLLine>;
+  using LineContainerPointer = typename LineContainerType::Pointer;
+
+  /** Dense image type with the same pixel type and dimension, to which the
+   * image is expanded when it is written by ImageFileWriter. */
+  using DenseImageType = Image<PixelType, VImageDimension>;
+
+  template <typename UPixelType, unsigned int NUImageDimension = VImageDimension>
+  struct Rebind
+  {
+    using Type = RLEImage<UPixelType, NUImageDimension, CounterType>;
+  };
+
+  template <typename UPixelType, unsigned int NUImageDimension = VImageDimension>
+  using RebindImageType = RLEImage<UPixelType, NUImageDimension, CounterType>;
+
+  /** Allocate the lines of the buffered region. Each line is initialized with
+   * a single run of zero valued pixels, whatever initializePixels. */
+  void
+  Allocate(bool initializePixels = false) override;
+
+  /** Restore the data object to its initial state, releasing the lines. */
+  void
+  Initialize() override;
+
+  /** Fill the buffered region with a value, which makes each line a single
+   * run. */
+  void
+  FillBuffer(const TPixel & value);
+
+  /** Set a pixel value. Linear in the number of runs of the line. */
+  void
+  SetPixel(const IndexType & index, const TPixel & value);
+
+  /** Get a pixel value. Linear in the number of runs of the line. */
+  const TPixel &
+  GetPixel(const IndexType & index) const;
+
+  /** Index of the line of a pixel in the line container. */
+  SizeValueType
+  ComputeLineNumber(const IndexType & index) const
+  {
+    const RegionType & bufferedRegion = this->GetBufferedRegion();
+    SizeValueType      lineNumber = 0;
+    SizeValueType      stride = 1;
+    for (unsigned int d = 1; d < VImageDimension; ++d)
+    {
+      lineNumber += static_cast<SizeValueType>(index[d] - bufferedRegion.GetIndex(d)) * stride;
+      stride *= bufferedRegion.GetSize(d);
+    }
+    return lineNumber;
+  }
+
+  /** Get the runs of the line containing a pixel. */
+  RLLine &
+  GetLine(const IndexType & index)
+  {
+    return m_Lines->ElementAt(this->ComputeLineNumber(index));
+  }
+  const RLLine &
+  GetLine(const IndexType & index) const
+  {
+    return m_Lines->ElementAt(this->ComputeLineNumber(index));
+  }
+
+  /** Decode length pixels of a line, starting at index, into values. */
+  void
+  GetLineValues(const IndexType & index, TPixel * values, SizeValueType length) const;
+
+  /** Encode length values into a line, starting at index. The runs of the
+   * line outside of the span are kept, and merged with the new runs when
+   * they have the same value. */
+  void
+  SetLineValues(const IndexType & index, const TPixel * values, SizeValueType length);
+
+  /** Set length pixels of a line, starting at index, to value. */
+  void
+  FillLineValues(const IndexType & index, const TPixel & value, SizeValueType length);
+
+  /** Get the total number of runs in the buffered region. */
+  SizeValueType
+  GetNumberOfSegments() const;
+
+  /** Get/Set the container of the lines. */
+  LineContainerType *
+  GetLineContainer()
+  {
+    return m_Lines.GetPointer();
+  }
+  const LineContainerType *
+  GetLineContainer() const
+  {
+    return m_Lines.GetPointer();
+  }
+  void
+  SetLineContainer(LineContainerType * container);
+
+  /** Graft the data and information from one image to another. The lines are
+   * shared by both images. */
+  virtual void
+  Graft(const Self * data);
+
+  /** Return the pixel accessor. */
+  AccessorType
+  GetPixelAccessor()
+  {
+    return AccessorType();
+  }
+  const AccessorType
+  GetPixelAccessor() const
+  {
+    return AccessorType();
+  }
+
+  unsigned int
+  GetNumberOfComponentsPerPixel() const override
+  {
+    return 1;
+  }
+
+protected:
+  RLEImage();
+  ~RLEImage() override = default;
+
+  void
+  PrintSelf(std::ostream & os, Indent indent) const override;
+
+  void
+  Graft(const DataObject * data) override;
+  using Superclass::Graft;
+
+private:
+  /** Append count pixels with value to a line, merging them with the last
+   * run when possible. */
+  static void
+  AppendRun(RLLine & line, const TPixel & value, SizeValueType count);
+
+  /** Replace length pixels of a line, starting at index, with the runs of
+   * span. */
+  void
+  SpliceLine(const IndexType & index, const RLLine & span, SizeValueType length);
+
+  /** Get the mutex locking a line. */
+  static std::mutex &
+  GetLineMutex(const RLLine & line);
+
+  LineContainerPointer m_Lines;
+};
+} // end namespace itk
+
+#include "itkRLEImageConstIterator.h"
+#include "itkRLEImageScanlineIterator.h"
+#include "itkRLEImageRegionIterator.h"
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#  include "itkRLEImage.hxx"
+#endif
+
+#endif
@@ -0,0 +1,340 @@
+/*=========================================================================
+ *
+ *  Copyright NumFOCUS
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkRLEImage_hxx
+#define itkRLEImage_hxx
+
+#include "itkRLEImage.h"
+
+#include <algorithm>
+#include <cstdint>
+
+namespace itk
+{
+
+template <typename TPixel, unsigned int VImageDimension, typename CounterType>
+RLEImage<TPixel, VImageDimension, CounterType>::RLEImage()
+{
+  m_Lines = LineContainerType::New();
+}
+
+
+template <typename TPixel, unsigned int VImageDimension, typename CounterType>
+void
+RLEImage<TPixel, VImageDimension, CounterType>::Allocate(bool)
+{
+  this->ComputeOffsetTable();
+
+  const RegionType & bufferedRegion = this->GetBufferedRegion();
+  SizeValueType      numberOfLines = 1;
+  for (unsigned int d = 1; d < VImageDimension; ++d)
+  {
+    numberOfLines *= bufferedRegion.GetSize(d);
+  }
+  if (bufferedRegion.GetSize(0) == 0)
+  {
+    numberOfLines = 0;
+  }
+
+  m_Lines->Initialize();
+  m_Lines->resize(numberOfLines);
+  this->FillBuffer(NumericTraits<TPixel>::ZeroValue());
+}
+
+
+template <typename TPixel, unsigned int VImageDimension, typename CounterType>
+void
+RLEImage<TPixel, VImageDimension, CounterType>::Initialize()
+{
+  Superclass::Initialize();
+
+  // The lines may be shared with a grafted image, so they are replaced
+  // rather than cleared
+  m_Lines = LineContainerType::New();
+}
+
+
+template <typename TPixel, unsigned int VImageDimension, typename CounterType>
+void
+RLEImage<TPixel, VImageDimension, CounterType>::FillBuffer(const TPixel & value)
+{
+  const SizeValueType lineLength = this->GetBufferedRegion().GetSize(0);
+  for (auto & line : m_Lines->CastToSTLContainer())
+  {
+    line.clear();
+    AppendRun(line, value, lineLength);
+  }
+}
+
+
+template <typename TPixel, unsigned int VImageDimension, typename CounterType>
+void
+RLEImage<TPixel, VImageDimension, CounterType>::SetPixel(const IndexType & index, const TPixel & value)
+{
+  this->SetLineValues(index, &value, 1);
+}
+
+
+template <typename TPixel, unsigned int VImageDimension, typename CounterType>
+const TPixel &
+RLEImage<TPixel, VImageDimension, CounterType>::GetPixel(const IndexType & index) const
+{
+  const RLLine & line = this->GetLine(index);
+  SizeValueType  x = static_cast<SizeValueType>(index[0] - this->GetBufferedRegion().GetIndex(0));
+  auto           run = line.begin();
+  while (x >= run->first)
+  {
+    x -= run->first;
+    ++run;
+  }
+  return run->second;
+}
+
+
+template <typename TPixel, unsigned int VImageDimension, typename CounterType>
+void
+RLEImage<TPixel, VImageDimension, CounterType>::GetLineValues(const IndexType & index,
+                                                              TPixel *          values,
+                                                              SizeValueType     length) const
+{
+  const RLLine &              line = this->GetLine(index);
+  std::lock_guard<std::mutex> lock(GetLineMutex(line));
+  SizeValueType               x = static_cast<SizeValueType>(index[0] - this->GetBufferedRegion().GetIndex(0));
+  auto                        run = line.begin();
+
+  // find the run containing the first pixel
+  while (x >= run->first)
+  {
+    x -= run->first;
+    ++run;
+  }
+
+  SizeValueType count = std::min(static_cast<SizeValueType>(run->first) - x, length);
+  while (length > 0)
+  {
+    values = std::fill_n(values, count, run->second);
+    length -= count;
+    if (length > 0)
+    {
+      ++run;
+      count = std::min(static_cast<SizeValueType>(run->first), length);
+    }
+  }
+}
+
+
+template <typename TPixel, unsigned int VImageDimension, typename CounterType>
+void
+RLEImage<TPixel, VImageDimension, CounterType>::SetLineValues(const IndexType & index,
+                                                              const TPixel *    values,
+                                                              SizeValueType     length)
+{
+  RLLine        span;
+  SizeValueType i = 0;
+  while (i < length)
+  {
+    SizeValueType count = 1;
+    while (i + count < length && values[i + count] == values[i])
+    {
+      ++count;
+    }
+    AppendRun(span, values[i], count);
+    i += count;
+  }
+  this->SpliceLine(index, span, length);
+}
+
+
+template <typename TPixel, unsigned int VImageDimension, typename CounterType>
+void
+RLEImage<TPixel, VImageDimension, CounterType>::FillLineValues(const IndexType & index,
+                                                               const TPixel &    value,
+                                                               SizeValueType     length)
+{
+  RLLine span;
+  AppendRun(span, value, length);
+  this->SpliceLine(index, span, length);
+}
+
+
+template <typename TPixel, unsigned int VImageDimension, typename CounterType>
+void
+RLEImage<TPixel, VImageDimension, CounterType>::SpliceLine(const IndexType & index,
+                                                           const RLLine &    span,
+                                                           SizeValueType     length)
+{
+  if (length == 0)
+  {
+    return;
+  }
+
+  RLLine &                    line = this->GetLine(index);
+  std::lock_guard<std::mutex> lock(GetLineMutex(line));
+  const SizeValueType         begin = static_cast<SizeValueType>(index[0] - this->GetBufferedRegion().GetIndex(0));
+  const SizeValueType         end = begin + length;
+
+  RLLine result;
+  result.reserve(line.size() + span.size() + 1);
+
+  // keep the runs before the span, cutting the one containing its beginning
+  SizeValueType x = 0;
+  auto          run = line.begin();
+  for (; x + run->first <= begin; ++run)
+  {
+    result.push_back(*run);
+    x += run->first;
+  }
+  if (x < begin)
+  {
+    result.emplace_back(static_cast<CounterType>(begin - x), run->second);
+  }
+
+  for (const auto & segment : span)
+  {
+    AppendRun(result, segment.second, segment.first);
+  }
+
+  // keep the runs after the span, cutting the one containing its end
+  for (; run != line.end() && x + run->first <= end; ++run)
+  {
+    x += run->first;
+  }
+  if (run != line.end())
+  {
+    AppendRun(result, run->second, x + run->first - end);
+    for (++run; run != line.end(); ++run)
+    {
+      AppendRun(result, run->second, run->first);
+    }
+  }
+
+  line.swap(result);
+}
+
+
+template <typename TPixel, unsigned int VImageDimension, typename CounterType>
+void
+RLEImage<TPixel, VImageDimension, CounterType>::AppendRun(RLLine & line, const TPixel & value, SizeValueType count)
+{
+  constexpr SizeValueType maximumCount = NumericTraits<CounterType>::max();
+  while (count > 0)
+  {
+    if (!line.empty() && line.back().second == value && line.back().first < maximumCount)
+    {
+      const SizeValueType added = std::min(count, maximumCount - line.back().first);
+      line.back().first += static_cast<CounterType>(added);
+      count -= added;
+    }
+    else
+    {
+      const SizeValueType added = std::min(count, maximumCount);
+      line.emplace_back(static_cast<CounterType>(added), value);
+      count -= added;
+    }
+  }
+}
+
+
+template <typename TPixel, unsigned int VImageDimension, typename CounterType>
+std::mutex &
+RLEImage<TPixel, VImageDimension, CounterType>::GetLineMutex(const RLLine & line)
+{
+  // The mutexes are indexed by the address of the line, so that the images
+  // sharing their lines, e.g. the input and the output of an in place filter,
+  // lock the same mutex
+  constexpr size_t  numberOfMutexes = 64;
+  static std::mutex mutexes[numberOfMutexes];
+  return mutexes[(reinterpret_cast<std::uintptr_t>(&line) / sizeof(RLLine)) % numberOfMutexes];
+}
+
+
+template <typename TPixel, unsigned int VImageDimension, typename CounterType>
+auto
+RLEImage<TPixel, VImageDimension, CounterType>::GetNumberOfSegments() const -> SizeValueType
+{
+  SizeValueType numberOfSegments = 0;
+  for (const auto & line : m_Lines->CastToSTLConstContainer())
+  {
+    numberOfSegments += line.size();
+  }
+  return numberOfSegments;
+}
+
+
+template <typename TPixel, unsigned int VImageDimension, typename CounterType>
+void
+RLEImage<TPixel, VImageDimension, CounterType>::SetLineContainer(LineContainerType * container)
+{
+  if (m_Lines != container)
+  {
+    m_Lines = container;
+    this->Modified();
+  }
+}
+
+
+template <typename TPixel, unsigned int VImageDimension, typename CounterType>
+void
+RLEImage<TPixel, VImageDimension, CounterType>::Graft(const Self * image)
+{
+  // call the superclass' implementation
+  Superclass::Graft(image);
+
+  if (image)
+  {
+    // Now copy anything remaining that is needed
+    this->SetLineContainer(const_cast<LineContainerType *>(image->GetLineContainer()));
+  }
+}
+
+
+template <typename TPixel, unsigned int VImageDimension, typename CounterType>
+void
+RLEImage<TPixel, VImageDimension, CounterType>::Graft(const DataObject * data)
+{
+  if (data)
+  {
+    // Attempt to cast data to an RLEImage
+    const auto * const imgData = dynamic_cast<const Self *>(data);
+
+    if (imgData != nullptr)
+    {
+      this->Graft(imgData);
+    }
+    else
+    {
+      // pointer could not be cast back down
+      itkExceptionMacro(<< "itk::RLEImage::Graft() cannot cast " << typeid(data).name() << " to "
+                        << typeid(const Self *).name());
+    }
+  }
+}
+
+
+template <typename TPixel, unsigned int VImageDimension, typename CounterType>
+void
+RLEImage<TPixel, VImageDimension, CounterType>::PrintSelf(std::ostream & os, Indent indent) const
+{
+  Superclass::PrintSelf(os, indent);
+
+  os << indent << "NumberOfLines: " << m_Lines->Size() << std::endl;
+  os << indent << "NumberOfSegments: " << this->GetNumberOfSegments() << std::endl;
+}
+
+} // end namespace itk
+
+#endif
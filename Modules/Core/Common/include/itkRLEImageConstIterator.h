@@ -0,0 +1,330 @@
+/*=========================================================================
+ *
+ *  Copyright NumFOCUS
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkRLEImageConstIterator_h
+#define itkRLEImageConstIterator_h
+
+#include "itkImageConstIterator.h"
+
+#include <vector>
+
+namespace itk
+{
+template <typename TPixel, unsigned int VImageDimension, typename CounterType>
+class RLEImage;
+
+/**
+ * \class ImageConstIterator<RLEImage<TPixel, VImageDimension, CounterType>>
+ * \brief Base of the iterators over an RLEImage.
+ *
+ * The iterator decodes the part of the current line which is inside of its
+ * region into a buffer. The iterators which can modify the image mark the
+ * buffer as modified, and the buffer is encoded back into the image when the
+ * iterator moves to another line, is copied or is destroyed. Two iterators
+ * must then not modify the same pixels at the same time, and an iterator only
+ * sees the modifications of the lines which were left by the others.
+ *
+ * This class is used through RLEImage, and should not be included directly.
+ *
+ * \sa RLEImage
+ *
+ * \ingroup ImageIterators
+ * \ingroup ITKCommon
+ */
+template <typename TPixel, unsigned int VImageDimension, typename CounterType>
+class ImageConstIterator<RLEImage<TPixel, VImageDimension, CounterType>>
+{
+public:
+  /** Standard class type aliases. */
+  using Self = ImageConstIterator;
+
+  /** Dimension of the image the iterator walks. */
+  static constexpr unsigned int ImageIteratorDimension = VImageDimension;
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacroNoParent(ImageConstIterator);
+
+  /** Image type alias support. */
+  using ImageType = RLEImage<TPixel, VImageDimension, CounterType>;
+  using IndexType = typename ImageType::IndexType;
+  using IndexValueType = typename ImageType::IndexValueType;
+  using SizeType = typename ImageType::SizeType;
+  using SizeValueType = typename ImageType::SizeValueType;
+  using OffsetType = typename ImageType::OffsetType;
+  using RegionType = typename ImageType::RegionType;
+  using InternalPixelType = typename ImageType::InternalPixelType;
+  using PixelType = typename ImageType::PixelType;
+  using AccessorType = typename ImageType::AccessorType;
+  using AccessorFunctorType = typename ImageType::AccessorFunctorType;
+
+  /** Default Constructor. Need to provide a default constructor since we
+   * provide a copy constructor. */
+  ImageConstIterator() = default;
+
+  /** Constructor establishes an iterator to walk a particular image and a
+   * particular region of that image. */
+  ImageConstIterator(const ImageType * ptr, const RegionType & region)
+    : m_Image(ptr)
+  {
+    this->SetRegion(region);
+  }
+
+  /** Copy Constructor. The modifications of the current line by the other
+   * iterator are encoded before it is copied, so that the two iterators do
+   * not both encode them later. */
+  ImageConstIterator(const Self & it)
+  {
+    const_cast<Self &>(it).WriteLine();
+    m_Image = it.m_Image;
+    m_Region = it.m_Region;
+    m_LineIndex = it.m_LineIndex;
+    m_Position = it.m_Position;
+    m_Line = it.m_Line;
+    m_IsAtEnd = it.m_IsAtEnd;
+  }
+
+  /** Default Destructor, which encodes the current line if it was
+   * modified. */
+  virtual ~ImageConstIterator() { this->WriteLine(); }
+
+  /** operator= encodes the current lines of both iterators if they were
+   * modified before copying the state of the other iterator. */
+  Self &
+  operator=(const Self & it)
+  {
+    if (this != &it)
+    {
+      this->WriteLine();
+      const_cast<Self &>(it).WriteLine();
+      m_Image = it.m_Image;
+      m_Region = it.m_Region;
+      m_LineIndex = it.m_LineIndex;
+      m_Position = it.m_Position;
+      m_Line = it.m_Line;
+      m_IsAtEnd = it.m_IsAtEnd;
+    }
+    return *this;
+  }
+
+  /** Set the region of the image to iterate over, and move to its
+   * beginning. */
+  virtual void
+  SetRegion(const RegionType & region)
+  {
+    this->WriteLine();
+    m_Region = region;
+    m_Line.resize(region.GetSize(0));
+    this->GoToBegin();
+  }
+
+  /** Get the dimension (size) of the index. */
+  static unsigned int
+  GetImageIteratorDimension()
+  {
+    return VImageDimension;
+  }
+
+  bool
+  operator==(const Self & it) const
+  {
+    return m_IsAtEnd == it.m_IsAtEnd && (m_IsAtEnd || this->GetIndex() == it.GetIndex());
+  }
+
+  bool
+  operator!=(const Self & it) const
+  {
+    return !(*this == it);
+  }
+
+  /** Get the index of the current pixel. */
+  const IndexType
+  GetIndex() const
+  {
+    IndexType index = m_LineIndex;
+    index[0] += static_cast<IndexValueType>(m_Position);
+    return index;
+  }
+
+  /** Move to a pixel of the region. */
+  virtual void
+  SetIndex(const IndexType & ind)
+  {
+    IndexType lineIndex = ind;
+    lineIndex[0] = m_Region.GetIndex(0);
+    if (m_IsAtEnd || lineIndex != m_LineIndex)
+    {
+      this->WriteLine();
+      m_LineIndex = lineIndex;
+      m_IsAtEnd = false;
+      this->ReadLine();
+    }
+    m_Position = static_cast<SizeValueType>(ind[0] - m_Region.GetIndex(0));
+  }
+
+  /** Get the region that this iterator walks. */
+  const RegionType &
+  GetRegion() const
+  {
+    return m_Region;
+  }
+
+  /** Get the image that this iterator walks. */
+  const ImageType *
+  GetImage() const
+  {
+    return m_Image;
+  }
+
+  /** Get the pixel value */
+  PixelType
+  Get() const
+  {
+    return m_Line[m_Position];
+  }
+
+  /** Return a const reference to the pixel, which is valid as long as the
+   * iterator stays on the same line. */
+  const PixelType &
+  Value() const
+  {
+    return m_Line[m_Position];
+  }
+
+  /** Move an iterator to the beginning of the region. */
+  void
+  GoToBegin()
+  {
+    this->WriteLine();
+    m_LineIndex = m_Region.GetIndex();
+    m_Position = 0;
+    m_IsAtEnd = m_Region.GetNumberOfPixels() == 0;
+    this->ReadLine();
+  }
+
+  /** Move an iterator to the end of the region. */
+  void
+  GoToEnd()
+  {
+    this->WriteLine();
+    m_LineIndex = m_Region.GetIndex();
+    m_LineIndex[VImageDimension - 1] += static_cast<IndexValueType>(m_Region.GetSize(VImageDimension - 1));
+    m_Position = 0;
+    m_IsAtEnd = true;
+  }
+
+  /** Is the iterator at the beginning of the region? */
+  bool
+  IsAtBegin() const
+  {
+    return !m_IsAtEnd && m_Position == 0 && m_LineIndex == m_Region.GetIndex();
+  }
+
+  /** Is the iterator at the end of the region? */
+  bool
+  IsAtEnd() const
+  {
+    return m_IsAtEnd;
+  }
+
+protected:
+  /** Move to the beginning of the next line of the region. */
+  void
+  NextLineInRegion()
+  {
+    this->WriteLine();
+    m_Position = 0;
+
+    unsigned int d = 1;
+    for (; d < VImageDimension; ++d)
+    {
+      ++m_LineIndex[d];
+      if (m_LineIndex[d] < m_Region.GetIndex(d) + static_cast<IndexValueType>(m_Region.GetSize(d)))
+      {
+        break;
+      }
+      if (d < VImageDimension - 1)
+      {
+        m_LineIndex[d] = m_Region.GetIndex(d);
+      }
+    }
+
+    if (d == VImageDimension)
+    {
+      this->GoToEnd();
+    }
+    else
+    {
+      this->ReadLine();
+    }
+  }
+
+  /** Set the current pixel, marking the line as modified. */
+  void
+  SetValue(const PixelType & value)
+  {
+    m_Line[m_Position] = value;
+    m_Dirty = true;
+  }
+
+  /** Get a reference to the current pixel, marking the line as modified. */
+  PixelType &
+  GetValueReference()
+  {
+    m_Dirty = true;
+    return m_Line[m_Position];
+  }
+
+  /** Decode the current line. */
+  void
+  ReadLine()
+  {
+    if (!m_IsAtEnd)
+    {
+      m_Image->GetLineValues(m_LineIndex, m_Line.data(), m_Line.size());
+    }
+  }
+
+  /** Encode the current line if it was modified. */
+  void
+  WriteLine()
+  {
+    if (m_Dirty)
+    {
+      const_cast<ImageType *>(m_Image)->SetLineValues(m_LineIndex, m_Line.data(), m_Line.size());
+      m_Dirty = false;
+    }
+  }
+
+  const ImageType * m_Image{ nullptr };
+
+  RegionType m_Region;
+
+  /** Index of the first pixel of the current line in the region */
+  IndexType m_LineIndex{ { 0 } };
+
+  /** Position of the current pixel in the current line */
+  SizeValueType m_Position{ 0 };
+
+  /** Decoded pixels of the current line in the region */
+  std::vector<PixelType> m_Line;
+
+  bool m_Dirty{ false };
+  bool m_IsAtEnd{ true };
+};
+} // end namespace itk
+
+#endif
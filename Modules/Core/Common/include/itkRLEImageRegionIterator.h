@@ -0,0 +1,246 @@
+/*=========================================================================
+ *
+ *  Copyright NumFOCUS
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkRLEImageRegionIterator_h
+#define itkRLEImageRegionIterator_h
+
+#include "itkRLEImageConstIterator.h"
+#include "itkImageRegionIterator.h"
+#include "itkImageRegionIteratorWithIndex.h"
+
+namespace itk
+{
+/**
+ * \class ImageRegionConstIterator<RLEImage<TPixel, VImageDimension, CounterType>>
+ * \brief Region iterator over an RLEImage, decoding one line at a time.
+ *
+ * This class is used through RLEImage, and should not be included directly.
+ *
+ * \sa RLEImage
+ *
+ * \ingroup ImageIterators
+ * \ingroup ITKCommon
+ */
+template <typename TPixel, unsigned int VImageDimension, typename CounterType>
+class ImageRegionConstIterator<RLEImage<TPixel, VImageDimension, CounterType>>
+  : public ImageConstIterator<RLEImage<TPixel, VImageDimension, CounterType>>
+{
+public:
+  /** Standard class type aliases. */
+  using Self = ImageRegionConstIterator;
+  using Superclass = ImageConstIterator<RLEImage<TPixel, VImageDimension, CounterType>>;
+
+  /** Types inherited from the Superclass */
+  using ImageType = typename Superclass::ImageType;
+  using IndexType = typename Superclass::IndexType;
+  using SizeType = typename Superclass::SizeType;
+  using OffsetType = typename Superclass::OffsetType;
+  using RegionType = typename Superclass::RegionType;
+  using InternalPixelType = typename Superclass::InternalPixelType;
+  using PixelType = typename Superclass::PixelType;
+  using AccessorType = typename Superclass::AccessorType;
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro(ImageRegionConstIterator, ImageConstIterator);
+
+  /** Default constructor. */
+  ImageRegionConstIterator() = default;
+
+  /** Constructor establishes an iterator to walk a particular image and a
+   * particular region of that image. */
+  ImageRegionConstIterator(const ImageType * ptr, const RegionType & region)
+    : Superclass(ptr, region)
+  {}
+
+  /** Increment (prefix) the fastest moving dimension of the iterator's
+   * index, moving to the next line at its end. */
+  Self &
+  operator++()
+  {
+    if (++this->m_Position == this->m_Line.size())
+    {
+      this->NextLineInRegion();
+    }
+    return *this;
+  }
+};
+
+/**
+ * \class ImageRegionIterator<RLEImage<TPixel, VImageDimension, CounterType>>
+ * \brief Region iterator modifying an RLEImage, encoding each line when
+ * leaving it.
+ *
+ * This class is used through RLEImage, and should not be included directly.
+ *
+ * \sa RLEImage
+ *
+ * \ingroup ImageIterators
+ * \ingroup ITKCommon
+ */
+template <typename TPixel, unsigned int VImageDimension, typename CounterType>
+class ImageRegionIterator<RLEImage<TPixel, VImageDimension, CounterType>>
+  : public ImageRegionConstIterator<RLEImage<TPixel, VImageDimension, CounterType>>
+{
+public:
+  /** Standard class type aliases. */
+  using Self = ImageRegionIterator;
+  using Superclass = ImageRegionConstIterator<RLEImage<TPixel, VImageDimension, CounterType>>;
+
+  /** Types inherited from the Superclass */
+  using ImageType = typename Superclass::ImageType;
+  using RegionType = typename Superclass::RegionType;
+  using PixelType = typename Superclass::PixelType;
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro(ImageRegionIterator, ImageRegionConstIterator);
+
+  /** Default constructor. */
+  ImageRegionIterator() = default;
+
+  /** Constructor establishes an iterator to walk a particular image and a
+   * particular region of that image. */
+  ImageRegionIterator(ImageType * ptr, const RegionType & region)
+    : Superclass(ptr, region)
+  {}
+
+  /** Set the pixel value */
+  void
+  Set(const PixelType & value)
+  {
+    this->SetValue(value);
+  }
+
+  /** Return a reference to the pixel, which is valid as long as the iterator
+   * stays on the same line. */
+  PixelType &
+  Value()
+  {
+    return this->GetValueReference();
+  }
+
+  /** Get the image that this iterator walks. */
+  ImageType *
+  GetImage() const
+  {
+    return const_cast<ImageType *>(this->m_Image);
+  }
+};
+
+/**
+ * \class ImageRegionConstIteratorWithIndex<RLEImage<TPixel, VImageDimension, CounterType>>
+ * \brief Region iterator over an RLEImage, decoding one line at a time.
+ *
+ * The index of the current pixel is always known by the iterators over an
+ * RLEImage, so this class only exists to be picked by the filters which use
+ * an iterator with index.
+ *
+ * This class is used through RLEImage, and should not be included directly.
+ *
+ * \sa RLEImage
+ *
+ * \ingroup ImageIterators
+ * \ingroup ITKCommon
+ */
+template <typename TPixel, unsigned int VImageDimension, typename CounterType>
+class ImageRegionConstIteratorWithIndex<RLEImage<TPixel, VImageDimension, CounterType>>
+  : public ImageRegionConstIterator<RLEImage<TPixel, VImageDimension, CounterType>>
+{
+public:
+  /** Standard class type aliases. */
+  using Self = ImageRegionConstIteratorWithIndex;
+  using Superclass = ImageRegionConstIterator<RLEImage<TPixel, VImageDimension, CounterType>>;
+
+  /** Types inherited from the Superclass */
+  using ImageType = typename Superclass::ImageType;
+  using RegionType = typename Superclass::RegionType;
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro(ImageRegionConstIteratorWithIndex, ImageRegionConstIterator);
+
+  /** Default constructor. */
+  ImageRegionConstIteratorWithIndex() = default;
+
+  /** Constructor establishes an iterator to walk a particular image and a
+   * particular region of that image. */
+  ImageRegionConstIteratorWithIndex(const ImageType * ptr, const RegionType & region)
+    : Superclass(ptr, region)
+  {}
+};
+
+/**
+ * \class ImageRegionIteratorWithIndex<RLEImage<TPixel, VImageDimension, CounterType>>
+ * \brief Region iterator modifying an RLEImage, encoding each line when
+ * leaving it.
+ *
+ * This class is used through RLEImage, and should not be included directly.
+ *
+ * \sa RLEImage
+ *
+ * \ingroup ImageIterators
+ * \ingroup ITKCommon
+ */
+template <typename TPixel, unsigned int VImageDimension, typename CounterType>
+class ImageRegionIteratorWithIndex<RLEImage<TPixel, VImageDimension, CounterType>>
+  : public ImageRegionConstIteratorWithIndex<RLEImage<TPixel, VImageDimension, CounterType>>
+{
+public:
+  /** Standard class type aliases. */
+  using Self = ImageRegionIteratorWithIndex;
+  using Superclass = ImageRegionConstIteratorWithIndex<RLEImage<TPixel, VImageDimension, CounterType>>;
+
+  /** Types inherited from the Superclass */
+  using ImageType = typename Superclass::ImageType;
+  using RegionType = typename Superclass::RegionType;
+  using PixelType = typename Superclass::PixelType;
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro(ImageRegionIteratorWithIndex, ImageRegionConstIteratorWithIndex);
+
+  /** Default constructor. */
+  ImageRegionIteratorWithIndex() = default;
+
+  /** Constructor establishes an iterator to walk a particular image and a
+   * particular region of that image. */
+  ImageRegionIteratorWithIndex(ImageType * ptr, const RegionType & region)
+    : Superclass(ptr, region)
+  {}
+
+  /** Set the pixel value */
+  void
+  Set(const PixelType & value)
+  {
+    this->SetValue(value);
+  }
+
+  /** Return a reference to the pixel, which is valid as long as the iterator
+   * stays on the same line. */
+  PixelType &
+  Value()
+  {
+    return this->GetValueReference();
+  }
+
+  /** Get the image that this iterator walks. */
+  ImageType *
+  GetImage() const
+  {
+    return const_cast<ImageType *>(this->m_Image);
+  }
+};
+} // end namespace itk
+
+#endif
@@ -0,0 +1,294 @@
+/*=========================================================================
+ *
+ *  Copyright NumFOCUS
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkRLEImageScanlineIterator_h
+#define itkRLEImageScanlineIterator_h
+
+#include "itkRLEImageConstIterator.h"
+#include "itkImageScanlineIterator.h"
+#include "itkImageLinearIteratorWithIndex.h"
+
+namespace itk
+{
+/**
+ * \class ImageScanlineConstIterator<RLEImage<TPixel, VImageDimension, CounterType>>
+ * \brief Scanline iterator over an RLEImage, decoding one line at a time.
+ *
+ * This class is used through RLEImage, and should not be included directly.
+ *
+ * \sa RLEImage
+ *
+ * \ingroup ImageIterators
+ * \ingroup ITKCommon
+ */
+template <typename TPixel, unsigned int VImageDimension, typename CounterType>
+class ImageScanlineConstIterator<RLEImage<TPixel, VImageDimension, CounterType>>
+  : public ImageConstIterator<RLEImage<TPixel, VImageDimension, CounterType>>
+{
+public:
+  /** Standard class type aliases. */
+  using Self = ImageScanlineConstIterator;
+  using Superclass = ImageConstIterator<RLEImage<TPixel, VImageDimension, CounterType>>;
+
+  /** Types inherited from the Superclass */
+  using ImageType = typename Superclass::ImageType;
+  using IndexType = typename Superclass::IndexType;
+  using SizeType = typename Superclass::SizeType;
+  using OffsetType = typename Superclass::OffsetType;
+  using RegionType = typename Superclass::RegionType;
+  using InternalPixelType = typename Superclass::InternalPixelType;
+  using PixelType = typename Superclass::PixelType;
+  using AccessorType = typename Superclass::AccessorType;
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro(ImageScanlineConstIterator, ImageConstIterator);
+
+  /** Default constructor. */
+  ImageScanlineConstIterator() = default;
+
+  /** Constructor establishes an iterator to walk a particular image and a
+   * particular region of that image. */
+  ImageScanlineConstIterator(const ImageType * ptr, const RegionType & region)
+    : Superclass(ptr, region)
+  {}
+
+  /** Go to the beginning pixel of the current line. */
+  void
+  GoToBeginOfLine()
+  {
+    this->m_Position = 0;
+  }
+
+  /** Go to the past end pixel of the current line. */
+  void
+  GoToEndOfLine()
+  {
+    this->m_Position = this->m_Line.size();
+  }
+
+  /** Test if the index is at the end of line. */
+  bool
+  IsAtEndOfLine() const
+  {
+    return this->m_Position >= this->m_Line.size();
+  }
+
+  /** Go to the next line. */
+  void
+  NextLine()
+  {
+    this->NextLineInRegion();
+  }
+
+  /** Increment (prefix) along the scanline. */
+  Self &
+  operator++()
+  {
+    itkAssertInDebugAndIgnoreInReleaseMacro(!this->IsAtEndOfLine());
+    ++this->m_Position;
+    return *this;
+  }
+
+  /** Decrement (prefix) along the scanline. */
+  Self &
+  operator--()
+  {
+    itkAssertInDebugAndIgnoreInReleaseMacro(this->m_Position > 0);
+    --this->m_Position;
+    return *this;
+  }
+};
+
+/**
+ * \class ImageScanlineIterator<RLEImage<TPixel, VImageDimension, CounterType>>
+ * \brief Scanline iterator modifying an RLEImage, encoding each line when
+ * leaving it.
+ *
+ * This class is used through RLEImage, and should not be included directly.
+ *
+ * \sa RLEImage
+ *
+ * \ingroup ImageIterators
+ * \ingroup ITKCommon
+ */
+template <typename TPixel, unsigned int VImageDimension, typename CounterType>
+class ImageScanlineIterator<RLEImage<TPixel, VImageDimension, CounterType>>
+  : public ImageScanlineConstIterator<RLEImage<TPixel, VImageDimension, CounterType>>
+{
+public:
+  /** Standard class type aliases. */
+  using Self = ImageScanlineIterator;
+  using Superclass = ImageScanlineConstIterator<RLEImage<TPixel, VImageDimension, CounterType>>;
+
+  /** Types inherited from the Superclass */
+  using ImageType = typename Superclass::ImageType;
+  using RegionType = typename Superclass::RegionType;
+  using PixelType = typename Superclass::PixelType;
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro(ImageScanlineIterator, ImageScanlineConstIterator);
+
+  /** Default constructor. */
+  ImageScanlineIterator() = default;
+
+  /** Constructor establishes an iterator to walk a particular image and a
+   * particular region of that image. */
+  ImageScanlineIterator(ImageType * ptr, const RegionType & region)
+    : Superclass(ptr, region)
+  {}
+
+  /** Set the pixel value */
+  void
+  Set(const PixelType & value)
+  {
+    this->SetValue(value);
+  }
+
+  /** Return a reference to the pixel, which is valid as long as the iterator
+   * stays on the same line. */
+  PixelType &
+  Value()
+  {
+    return this->GetValueReference();
+  }
+
+  /** Get the image that this iterator walks. */
+  ImageType *
+  GetImage() const
+  {
+    return const_cast<ImageType *>(this->m_Image);
+  }
+};
+
+/**
+ * \class ImageLinearConstIteratorWithIndex<RLEImage<TPixel, VImageDimension, CounterType>>
+ * \brief Linear iterator over an RLEImage, along the first axis only.
+ *
+ * This class is used through RLEImage, and should not be included directly.
+ *
+ * \sa RLEImage
+ *
+ * \ingroup ImageIterators
+ * \ingroup ITKCommon
+ */
+template <typename TPixel, unsigned int VImageDimension, typename CounterType>
+class ImageLinearConstIteratorWithIndex<RLEImage<TPixel, VImageDimension, CounterType>>
+  : public ImageScanlineConstIterator<RLEImage<TPixel, VImageDimension, CounterType>>
+{
+public:
+  /** Standard class type aliases. */
+  using Self = ImageLinearConstIteratorWithIndex;
+  using Superclass = ImageScanlineConstIterator<RLEImage<TPixel, VImageDimension, CounterType>>;
+
+  /** Types inherited from the Superclass */
+  using ImageType = typename Superclass::ImageType;
+  using RegionType = typename Superclass::RegionType;
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro(ImageLinearConstIteratorWithIndex, ImageScanlineConstIterator);
+
+  /** Default constructor. */
+  ImageLinearConstIteratorWithIndex() = default;
+
+  /** Constructor establishes an iterator to walk a particular image and a
+   * particular region of that image. */
+  ImageLinearConstIteratorWithIndex(const ImageType * ptr, const RegionType & region)
+    : Superclass(ptr, region)
+  {}
+
+  /** Set the direction of movement. The lines of an RLEImage can only be
+   * walked along the first axis. */
+  void
+  SetDirection(unsigned int direction)
+  {
+    if (direction != 0)
+    {
+      itkGenericExceptionMacro(<< "In image of dimension " << VImageDimension << " Direction " << direction
+                               << " was selected, but an RLEImage can only be walked along direction 0");
+    }
+  }
+
+  /** Get the direction of movement. */
+  unsigned int
+  GetDirection()
+  {
+    return 0;
+  }
+};
+
+/**
+ * \class ImageLinearIteratorWithIndex<RLEImage<TPixel, VImageDimension, CounterType>>
+ * \brief Linear iterator modifying an RLEImage, along the first axis only.
+ *
+ * This class is used through RLEImage, and should not be included directly.
+ *
+ * \sa RLEImage
+ *
+ * \ingroup ImageIterators
+ * \ingroup ITKCommon
+ */
+template <typename TPixel, unsigned int VImageDimension, typename CounterType>
+class ImageLinearIteratorWithIndex<RLEImage<TPixel, VImageDimension, CounterType>>
+  : public ImageLinearConstIteratorWithIndex<RLEImage<TPixel, VImageDimension, CounterType>>
+{
+public:
+  /** Standard class type aliases. */
+  using Self = ImageLinearIteratorWithIndex;
+  using Superclass = ImageLinearConstIteratorWithIndex<RLEImage<TPixel, VImageDimension, CounterType>>;
+
+  /** Types inherited from the Superclass */
+  using ImageType = typename Superclass::ImageType;
+  using RegionType = typename Superclass::RegionType;
+  using PixelType = typename Superclass::PixelType;
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro(ImageLinearIteratorWithIndex, ImageLinearConstIteratorWithIndex);
+
+  /** Default constructor. */
+  ImageLinearIteratorWithIndex() = default;
+
+  /** Constructor establishes an iterator to walk a particular image and a
+   * particular region of that image. */
+  ImageLinearIteratorWithIndex(ImageType * ptr, const RegionType & region)
+    : Superclass(ptr, region)
+  {}
+
+  /** Set the pixel value */
+  void
+  Set(const PixelType & value)
+  {
+    this->SetValue(value);
+  }
+
+  /** Return a reference to the pixel, which is valid as long as the iterator
+   * stays on the same line. */
+  PixelType &
+  Value()
+  {
+    return this->GetValueReference();
+  }
+
+  /** Get the image that this iterator walks. */
+  ImageType *
+  GetImage() const
+  {
+    return const_cast<ImageType *>(this->m_Image);
+  }
+};
+} // end namespace itk
+
+#endif
@@ -0,0 +1,232 @@
+/*=========================================================================
+ *
+ *  Copyright NumFOCUS
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include "itkRLEImage.h"
+#include "itkImageAlgorithm.h"
+#include "itkMultiThreaderBase.h"
+#include "itkTestingMacros.h"
+
+namespace
+{
+constexpr unsigned int Dimension = 3;
+using PixelType = short;
+// A small counter type to test the splitting of the long runs
+using RLEImageType = itk::RLEImage<PixelType, Dimension, unsigned char>;
+using ImageType = itk::Image<PixelType, Dimension>;
+
+// Compares all the pixels of an RLEImage with the ones of an Image, with
+// random access and with an iterator
+bool
+CompareImages(const RLEImageType * rleImage, const ImageType * image)
+{
+  itk::ImageRegionConstIteratorWithIndex<RLEImageType> rleIt(rleImage, rleImage->GetBufferedRegion());
+  itk::ImageRegionConstIterator<ImageType>             it(image, rleImage->GetBufferedRegion());
+  for (; !it.IsAtEnd(); ++it, ++rleIt)
+  {
+    if (rleIt.IsAtEnd() || rleIt.Get() != it.Get() || rleImage->GetPixel(rleIt.GetIndex()) != it.Get())
+    {
+      std::cerr << "Test failed!" << std::endl;
+      std::cerr << "Error at index " << rleIt.GetIndex() << std::endl;
+      std::cerr << "Expected: " << it.Get() << ", but got: " << rleIt.Get() << std::endl;
+      return false;
+    }
+  }
+  return rleIt.IsAtEnd();
+}
+} // namespace
+
+int
+itkRLEImageTest(int, char *[])
+{
+  // Lines longer than the maximum run length, in a region which does not
+  // start at the origin
+  ImageType::IndexType index = { { 5, -2, 3 } };
+  ImageType::SizeType  size = { { 600, 7, 4 } };
+  ImageType::RegionType region(index, size);
+
+  RLEImageType::Pointer rleImage = RLEImageType::New();
+
+  ITK_EXERCISE_BASIC_OBJECT_METHODS(rleImage, RLEImage, ImageBase);
+
+  rleImage->SetRegions(region);
+  rleImage->Allocate();
+
+  ImageType::Pointer image = ImageType::New();
+  image->SetRegions(region);
+  image->Allocate(true);
+
+  ITK_TEST_EXPECT_TRUE(CompareImages(rleImage, image));
+  // Each line is split in runs of at most 255 pixels
+  ITK_TEST_EXPECT_EQUAL(rleImage->GetNumberOfSegments(), 3u * 7 * 4);
+
+  // Piecewise constant labels
+  itk::ImageRegionIteratorWithIndex<ImageType> it(image, region);
+  for (; !it.IsAtEnd(); ++it)
+  {
+    const ImageType::IndexType & idx = it.GetIndex();
+    it.Set(static_cast<PixelType>(((idx[0] / 37) * 3 + idx[1] * idx[2]) % 5));
+  }
+
+  itk::ImageRegionIterator<RLEImageType> rleIt(rleImage, region);
+  for (it.GoToBegin(); !it.IsAtEnd(); ++it, ++rleIt)
+  {
+    rleIt.Set(it.Get());
+  }
+  ITK_TEST_EXPECT_TRUE(rleIt.IsAtEnd());
+  // The last line is encoded when the iterator leaves it
+  ITK_TEST_EXPECT_TRUE(CompareImages(rleImage, image));
+
+  const itk::SizeValueType numberOfSegments = rleImage->GetNumberOfSegments();
+  std::cout << "Number of segments: " << numberOfSegments << std::endl;
+  ITK_TEST_EXPECT_TRUE(numberOfSegments < region.GetNumberOfPixels() / 20);
+
+  // Modify a sub-region with a scanline iterator
+  ImageType::IndexType  subIndex = { { 100, 0, 4 } };
+  ImageType::SizeType   subSize = { { 230, 3, 2 } };
+  ImageType::RegionType subRegion(subIndex, subSize);
+  {
+    itk::ImageScanlineIterator<RLEImageType> scanIt(rleImage, subRegion);
+    while (!scanIt.IsAtEnd())
+    {
+      while (!scanIt.IsAtEndOfLine())
+      {
+        const ImageType::IndexType & idx = scanIt.GetIndex();
+        const PixelType              value = (idx[0] % 50 < 25) ? scanIt.Get() : static_cast<PixelType>(7);
+        scanIt.Set(value);
+        image->SetPixel(idx, value);
+        ++scanIt;
+      }
+      scanIt.NextLine();
+    }
+  }
+  ITK_TEST_EXPECT_TRUE(CompareImages(rleImage, image));
+
+  // Random access
+  ImageType::IndexType pixelIndex = { { 6, 1, 5 } };
+  rleImage->SetPixel(pixelIndex, 9);
+  image->SetPixel(pixelIndex, 9);
+  pixelIndex[0] = 604;
+  rleImage->SetPixel(pixelIndex, 8);
+  image->SetPixel(pixelIndex, 8);
+  ITK_TEST_EXPECT_EQUAL(rleImage->GetPixel(pixelIndex), 8);
+
+  pixelIndex[0] = 200;
+  rleImage->FillLineValues(pixelIndex, 4, 300);
+  for (unsigned int i = 0; i < 300; ++i)
+  {
+    image->SetPixel(pixelIndex, 4);
+    ++pixelIndex[0];
+  }
+  ITK_TEST_EXPECT_TRUE(CompareImages(rleImage, image));
+
+  // Moving with SetIndex
+  {
+    itk::ImageRegionIterator<RLEImageType> indexIt(rleImage, region);
+    ImageType::IndexType                   idx = { { 50, 4, 6 } };
+    indexIt.SetIndex(idx);
+    ITK_TEST_EXPECT_EQUAL(indexIt.GetIndex(), idx);
+    ITK_TEST_EXPECT_EQUAL(indexIt.Get(), image->GetPixel(idx));
+    indexIt.Set(3);
+    image->SetPixel(idx, 3);
+  }
+  ITK_TEST_EXPECT_TRUE(CompareImages(rleImage, image));
+
+  // A copy of an iterator does not encode the modifications of the original
+  // iterator again
+  {
+    itk::ImageRegionIterator<RLEImageType> originalIt(rleImage, subRegion);
+    originalIt.Set(11);
+    itk::ImageRegionIterator<RLEImageType> copiedIt(originalIt);
+    itk::ImageRegionIterator<RLEImageType> assignedIt;
+    assignedIt = originalIt;
+    ITK_TEST_EXPECT_EQUAL(copiedIt.Get(), 11);
+    ITK_TEST_EXPECT_EQUAL(assignedIt.Get(), 11);
+    ++originalIt;
+    originalIt.Set(12);
+    originalIt.GoToEnd();
+  }
+  image->SetPixel(subIndex, 11);
+  ImageType::IndexType nextIndex = subIndex;
+  ++nextIndex[0];
+  image->SetPixel(nextIndex, 12);
+  ITK_TEST_EXPECT_TRUE(CompareImages(rleImage, image));
+
+  // Work units sharing a line, as when a region made of a single line is
+  // split along the first axis
+  {
+    ImageType::IndexType  lineIndex = { { 5, 3, 6 } };
+    ImageType::SizeType   lineSize = { { 600, 1, 1 } };
+    ImageType::RegionType lineRegion(lineIndex, lineSize);
+
+    itk::MultiThreaderBase::Pointer multiThreader = itk::MultiThreaderBase::New();
+    multiThreader->SetNumberOfWorkUnits(8);
+    multiThreader->ParallelizeImageRegion<Dimension>(
+      lineRegion,
+      [rleImage](const ImageType::RegionType & regionForThread) {
+        itk::ImageRegionIteratorWithIndex<RLEImageType> lineIt(rleImage, regionForThread);
+        for (; !lineIt.IsAtEnd(); ++lineIt)
+        {
+          lineIt.Set(static_cast<PixelType>((lineIt.GetIndex()[0] / 3) % 4));
+        }
+      },
+      nullptr);
+
+    itk::ImageRegionIteratorWithIndex<ImageType> lineIt(image, lineRegion);
+    for (; !lineIt.IsAtEnd(); ++lineIt)
+    {
+      lineIt.Set(static_cast<PixelType>((lineIt.GetIndex()[0] / 3) % 4));
+    }
+  }
+  ITK_TEST_EXPECT_TRUE(CompareImages(rleImage, image));
+
+  // Linear iterators only walk along the lines
+  itk::ImageLinearConstIteratorWithIndex<RLEImageType> linearIt(rleImage, subRegion);
+  ITK_TRY_EXPECT_EXCEPTION(linearIt.SetDirection(1));
+  ITK_TRY_EXPECT_NO_EXCEPTION(linearIt.SetDirection(0));
+
+  // Conversions through the scanline iterators
+  ImageType::Pointer copy = ImageType::New();
+  copy->SetRegions(region);
+  copy->Allocate();
+  itk::ImageAlgorithm::Copy(rleImage.GetPointer(), copy.GetPointer(), region, region);
+  ITK_TEST_EXPECT_TRUE(CompareImages(rleImage, copy));
+
+  RLEImageType::Pointer rleCopy = RLEImageType::New();
+  rleCopy->SetRegions(region);
+  rleCopy->Allocate();
+  itk::ImageAlgorithm::Copy(image.GetPointer(), rleCopy.GetPointer(), region, region);
+  ITK_TEST_EXPECT_TRUE(CompareImages(rleCopy, image));
+  ITK_TEST_EXPECT_EQUAL(rleCopy->GetNumberOfSegments(), rleImage->GetNumberOfSegments());
+
+  // Grafted images share their lines
+  RLEImageType::Pointer grafted = RLEImageType::New();
+  grafted->Graft(rleImage);
+  ITK_TEST_EXPECT_EQUAL(grafted->GetLineContainer(), rleImage->GetLineContainer());
+  ITK_TEST_EXPECT_EQUAL(grafted->GetBufferedRegion(), region);
+
+  rleImage->FillBuffer(2);
+  ITK_TEST_EXPECT_EQUAL(grafted->GetNumberOfSegments(), 3u * 7 * 4);
+  ITK_TEST_EXPECT_EQUAL(grafted->GetPixel(index), 2);
+
+  rleImage->Initialize();
+  ITK_TEST_EXPECT_EQUAL(rleImage->GetNumberOfSegments(), 0u);
+  ITK_TEST_EXPECT_EQUAL(grafted->GetNumberOfSegments(), 3u * 7 * 4);
+
+  std::cout << "Test finished." << std::endl;
+  return EXIT_SUCCESS;
+}
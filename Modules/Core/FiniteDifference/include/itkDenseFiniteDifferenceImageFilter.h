@@ -54,6 +54,19 @@ namespace itk
  * This is an image to image filter.  The specific types of the images are not
  * fixed at this level in the hierarchy.
  *
+ * \par Fused update
+ * When the time step is known before the change is calculated, as for the
+ * filters which use a fixed time step, UseFusedUpdateOn() calculates the
+ * change and applies it in a single pass over the image: the updated
+ * solution is written into the update buffer, which is then swapped with the
+ * output, instead of writing the change into the update buffer and adding it
+ * to the output in a second pass.  When, in addition, the difference function
+ * is the same at every iteration, NumberOfFusedIterations iterations are
+ * computed on each small tile of the image, with a halo of the radius of the
+ * function per iteration, before moving on to the next tile, so that the
+ * tiles stay in cache over these iterations.  The results are the same as
+ * without the fused update.
+ *
  * \par How to use this class
  * This filter is only one layer in a branch the finite difference solver
  * hierarchy.  It does not define the function used in the CalculateChange() and
@@ -101,6 +114,22 @@ public:
   /** The container type for the update buffer. */
   using UpdateBufferType = OutputImageType;
 
+  /** Set/Get whether the change is calculated and applied in a single pass
+   * over the image.  Only used by the filters whose time step is fixed (see
+   * TimeStepIsFixed()), and ignored by the others.  Off by default. */
+  itkSetMacro(UseFusedUpdate, bool);
+  itkGetConstMacro(UseFusedUpdate, bool);
+  itkBooleanMacro(UseFusedUpdate);
+
+  /** Set/Get the number of iterations computed on each tile of the image in
+   * a fused update, when the difference function does not change between
+   * iterations (see DifferenceFunctionIsFixed()).  Larger values keep the
+   * tiles in cache over more iterations, at the cost of computing larger
+   * halos.  The IterationEvent is then invoked once per pass over the image.
+   * Defaults to 1. */
+  itkSetClampMacro(NumberOfFusedIterations, unsigned int, 1, NumericTraits<unsigned int>::max());
+  itkGetConstMacro(NumberOfFusedIterations, unsigned int);
+
 #ifdef ITK_USE_CONCEPT_CHECKING
   // Begin concept checking
   itkConceptMacro(OutputTimesDoubleCheck, (Concept::MultiplyOperator<PixelType, double>));
@@ -124,7 +153,9 @@ protected:
 
   /** This method applies changes from the m_UpdateBuffer to the output using
    * the ThreadedApplyUpdate() method and a multithreading mechanism.  "dt" is
-   * the time step to use for the update of each pixel. */
+   * the time step to use for the update of each pixel.  With the fused
+   * update, it swaps the update buffer, which holds the updated solution,
+   * with the output. */
   void
   ApplyUpdate(const TimeStepType & dt) override;
 
@@ -138,7 +169,9 @@ protected:
 
   /** This method populates an update buffer with changes for each pixel in the
    * output using the ThreadedCalculateChange() method and a multithreading
-   * mechanism. Returns value is a time step to be used for the update. */
+   * mechanism. Returns value is a time step to be used for the update.  With
+   * the fused update, it populates the update buffer with the updated
+   * solution using the ThreadedFusedUpdate() method instead. */
   TimeStepType
   CalculateChange() override;
 
@@ -164,6 +197,36 @@ protected:
   virtual TimeStepType
   ThreadedCalculateChange(const ThreadRegionType & regionToProcess, ThreadIdType threadId);
 
+  /** Does the actual work of the fused update over a region supplied by the
+   * multithreading mechanism: writes into the update buffer the output
+   * updated by the given number of iterations.
+   * \sa CalculateChange */
+  virtual void
+  ThreadedFusedUpdate(const TimeStepType &     dt,
+                      unsigned int             numberOfIterations,
+                      const ThreadRegionType & regionToProcess,
+                      ThreadIdType             threadId);
+
+  /** Returns whether the time step returned by the difference function is
+   * known before the change is calculated, which the fused update requires.
+   * Subclasses whose difference function returns a fixed time step, and
+   * which do not override the threaded methods, return true. */
+  virtual bool
+  TimeStepIsFixed() const
+  {
+    return false;
+  }
+
+  /** Returns whether the difference function is the same at every
+   * iteration, that is, whether InitializeIteration() does not compute
+   * anything from the output, which the fused update of several iterations
+   * at once requires. */
+  virtual bool
+  DifferenceFunctionIsFixed() const
+  {
+    return false;
+  }
+
 private:
   /** Structure for passing information into static callback methods.  Used in
    * the subclasses' threading mechanisms. */
@@ -171,6 +234,7 @@ private:
   {
     DenseFiniteDifferenceImageFilter * Filter;
     TimeStepType                       TimeStep;
+    unsigned int                       NumberOfIterations;
     std::vector<TimeStepType>          TimeStepList;
     std::vector<bool>                  ValidTimeStepList;
   };
@@ -185,8 +249,34 @@ private:
   static ITK_THREAD_RETURN_FUNCTION_CALL_CONVENTION
   CalculateChangeThreaderCallback(void * arg);
 
+  /** This callback method uses SplitRequestedRegion to acquire a region
+   * which it then passes to ThreadedFusedUpdate for processing. */
+  static ITK_THREAD_RETURN_FUNCTION_CALL_CONVENTION
+  FusedUpdateThreaderCallback(void * arg);
+
+  /** Whether the update is fused in this execution. */
+  bool
+  IsUpdateFused() const
+  {
+    return m_UseFusedUpdate && this->TimeStepIsFixed();
+  }
+
+  /** Writes into next the image updated by one iteration over the region. */
+  void
+  FusedUpdateRegion(const OutputImageType *  image,
+                    UpdateBufferType *       next,
+                    const ThreadRegionType & region,
+                    const TimeStepType &     dt,
+                    void *                   globalData);
+
   /** The buffer that holds the updates for an iteration of the algorithm. */
   typename UpdateBufferType::Pointer m_UpdateBuffer;
+
+  bool         m_UseFusedUpdate{ false };
+  unsigned int m_NumberOfFusedIterations{ 1 };
+
+  /** The number of iterations computed by the last fused update. */
+  unsigned int m_NumberOfIterationsInFusedUpdate{ 1 };
 };
 } // end namespace itk
 
@@ -19,8 +19,13 @@
 #define itkDenseFiniteDifferenceImageFilter_hxx
 #include "itkDenseFiniteDifferenceImageFilter.h"
 
+#include <algorithm>
 #include <list>
+#include <vector>
+#include "itkImageAlgorithm.h"
 #include "itkImageRegionIterator.h"
+#include "itkImageRegionSplitterMultidimensional.h"
+#include "itkImageScanlineIterator.h"
 #include "itkNumericTraits.h"
 #include "itkNeighborhoodAlgorithm.h"
 
@@ -75,12 +80,33 @@ DenseFiniteDifferenceImageFilter<TInputImage, TOutputImage>::AllocateUpdateBuffe
   m_UpdateBuffer->SetRequestedRegion(output->GetRequestedRegion());
   m_UpdateBuffer->SetBufferedRegion(output->GetBufferedRegion());
   m_UpdateBuffer->Allocate();
+
+  // The fused update swaps the update buffer with the output after each
+  // iteration, so the pixels outside of the requested region, which are
+  // never updated, must be in both
+  if (this->IsUpdateFused() && output->GetRequestedRegion() != output->GetBufferedRegion())
+  {
+    ImageAlgorithm::Copy(
+      output.GetPointer(), m_UpdateBuffer.GetPointer(), output->GetBufferedRegion(), output->GetBufferedRegion());
+  }
 }
 
 template <typename TInputImage, typename TOutputImage>
 void
 DenseFiniteDifferenceImageFilter<TInputImage, TOutputImage>::ApplyUpdate(const TimeStepType & dt)
 {
+  if (this->IsUpdateFused())
+  {
+    // The update buffer holds the updated solution
+    const typename OutputImageType::PixelContainerPointer container = this->GetOutput()->GetPixelContainer();
+    this->GetOutput()->SetPixelContainer(m_UpdateBuffer->GetPixelContainer());
+    m_UpdateBuffer->SetPixelContainer(container);
+
+    // The superclass counts one iteration
+    this->SetElapsedIterations(this->GetElapsedIterations() + m_NumberOfIterationsInFusedUpdate - 1);
+    return;
+  }
+
   // Set up for multithreaded processing.
   DenseFDThreadStruct str;
 
@@ -128,6 +154,33 @@ DenseFiniteDifferenceImageFilter<TInputImage, TOutputImage>::CalculateChange()
   // Set up for multithreaded processing.
   DenseFDThreadStruct str;
 
+  if (this->IsUpdateFused())
+  {
+    const typename FiniteDifferenceFunctionType::Pointer df = this->GetDifferenceFunction();
+    void *                                               globalData = df->GetGlobalDataPointer();
+    const TimeStepType                                   dt = df->ComputeGlobalTimeStep(globalData);
+    df->ReleaseGlobalDataPointer(globalData);
+
+    // Several iterations are only computed at once when nothing is
+    // recalculated from the output between them
+    m_NumberOfIterationsInFusedUpdate = 1;
+    if (this->DifferenceFunctionIsFixed() && this->GetNumberOfIterations() > this->GetElapsedIterations())
+    {
+      m_NumberOfIterationsInFusedUpdate = static_cast<unsigned int>(std::min<IdentifierType>(
+        m_NumberOfFusedIterations, this->GetNumberOfIterations() - this->GetElapsedIterations()));
+    }
+
+    str.Filter = this;
+    str.TimeStep = dt;
+    str.NumberOfIterations = m_NumberOfIterationsInFusedUpdate;
+    this->GetMultiThreader()->SetNumberOfWorkUnits(this->GetNumberOfWorkUnits());
+    this->GetMultiThreader()->SetSingleMethod(this->FusedUpdateThreaderCallback, &str);
+    this->GetMultiThreader()->SingleMethodExecute();
+
+    this->m_UpdateBuffer->Modified();
+    return dt;
+  }
+
   str.Filter = this;
   str.TimeStep = NumericTraits<TimeStepType>::ZeroValue(); // Not used during the
   // calculate change step.
@@ -185,6 +238,26 @@ DenseFiniteDifferenceImageFilter<TInputImage, TOutputImage>::CalculateChangeThre
   return ITK_THREAD_RETURN_DEFAULT_VALUE;
 }
 
+template <typename TInputImage, typename TOutputImage>
+ITK_THREAD_RETURN_FUNCTION_CALL_CONVENTION
+DenseFiniteDifferenceImageFilter<TInputImage, TOutputImage>::FusedUpdateThreaderCallback(void * arg)
+{
+  ThreadIdType threadId = ((MultiThreaderBase::WorkUnitInfo *)(arg))->WorkUnitID;
+  ThreadIdType threadCount = ((MultiThreaderBase::WorkUnitInfo *)(arg))->NumberOfWorkUnits;
+
+  auto * str = (DenseFDThreadStruct *)(((MultiThreaderBase::WorkUnitInfo *)(arg))->UserData);
+
+  ThreadRegionType splitRegion;
+  ThreadIdType     total = str->Filter->SplitRequestedRegion(threadId, threadCount, splitRegion);
+
+  if (threadId < total)
+  {
+    str->Filter->ThreadedFusedUpdate(str->TimeStep, str->NumberOfIterations, splitRegion, threadId);
+  }
+
+  return ITK_THREAD_RETURN_DEFAULT_VALUE;
+}
+
 template <typename TInputImage, typename TOutputImage>
 void
 DenseFiniteDifferenceImageFilter<TInputImage, TOutputImage>::ThreadedApplyUpdate(
@@ -217,6 +290,7 @@ DenseFiniteDifferenceImageFilter<TInputImage, TOutputImage>::ThreadedCalculateCh
   using NeighborhoodIteratorType = typename FiniteDifferenceFunctionType::NeighborhoodType;
 
   using UpdateIteratorType = ImageRegionIterator<UpdateBufferType>;
+  using UpdateScanlineIteratorType = ImageScanlineIterator<UpdateBufferType>;
 
   typename OutputImageType::Pointer output = this->GetOutput();
 
@@ -245,15 +319,32 @@ DenseFiniteDifferenceImageFilter<TInputImage, TOutputImage>::ThreadedCalculateCh
   auto         fIt = faceList.begin();
   auto         fEnd = faceList.end();
 
-  // Process the non-boundary region.
-  NeighborhoodIteratorType nD(radius, output, *fIt);
-  UpdateIteratorType       nU(m_UpdateBuffer, *fIt);
-  nD.GoToBegin();
-  while (!nD.IsAtEnd())
+  // Process the non-boundary region, a line at a time if the function
+  // computes the updates of whole lines, and else a pixel at a time.
+  if (df->SupportsComputeUpdateSpan() && fIt->GetNumberOfPixels() > 0)
+  {
+    std::vector<PixelType>     updates(fIt->GetSize(0));
+    UpdateScanlineIteratorType nL(m_UpdateBuffer, *fIt);
+    for (; !nL.IsAtEnd(); nL.NextLine())
+    {
+      df->ComputeUpdateSpan(output, nL.GetIndex(), updates.size(), updates.data(), globalData);
+      for (auto update = updates.cbegin(); update != updates.cend(); ++update, ++nL)
+      {
+        nL.Set(*update);
+      }
+    }
+  }
+  else
   {
-    nU.Value() = df->ComputeUpdate(nD, globalData);
-    ++nD;
-    ++nU;
+    NeighborhoodIteratorType nD(radius, output, *fIt);
+    UpdateIteratorType       nU(m_UpdateBuffer, *fIt);
+    nD.GoToBegin();
+    while (!nD.IsAtEnd())
+    {
+      nU.Value() = df->ComputeUpdate(nD, globalData);
+      ++nD;
+      ++nU;
+    }
   }
 
   // Process each of the boundary faces.
@@ -281,11 +372,149 @@ DenseFiniteDifferenceImageFilter<TInputImage, TOutputImage>::ThreadedCalculateCh
   return timeStep;
 }
 
+template <typename TInputImage, typename TOutputImage>
+void
+DenseFiniteDifferenceImageFilter<TInputImage, TOutputImage>::ThreadedFusedUpdate(
+  const TimeStepType &     dt,
+  unsigned int             numberOfIterations,
+  const ThreadRegionType & regionToProcess,
+  ThreadIdType)
+{
+  const OutputImageType * output = this->GetOutput();
+
+  const typename FiniteDifferenceFunctionType::Pointer df = this->GetDifferenceFunction();
+  void *                                               globalData = df->GetGlobalDataPointer();
+
+  if (numberOfIterations == 1)
+  {
+    this->FusedUpdateRegion(output, m_UpdateBuffer, regionToProcess, dt, globalData);
+    df->ReleaseGlobalDataPointer(globalData);
+    return;
+  }
+
+  // Tiles small enough for the iterations over a tile and its halo to stay
+  // in cache
+  constexpr SizeValueType numberOfPixelsPerTile = 1 << 16;
+  const auto              requestedNumberOfTiles = static_cast<unsigned int>(std::min<SizeValueType>(
+    regionToProcess.GetNumberOfPixels() / numberOfPixelsPerTile + 1, NumericTraits<unsigned int>::max()));
+  const auto              splitter = ImageRegionSplitterMultidimensional::New();
+  const unsigned int      numberOfTiles = splitter->GetNumberOfSplits(regionToProcess, requestedNumberOfTiles);
+
+  // The radius of the function times a number of iterations
+  using FunctionRadiusType = typename FiniteDifferenceFunctionType::RadiusType;
+  const FunctionRadiusType radius = df->GetRadius();
+  const auto               scaledRadius = [&radius](unsigned int factor) {
+    FunctionRadiusType scaled;
+    for (unsigned int d = 0; d < ImageDimension; ++d)
+    {
+      scaled[d] = radius[d] * factor;
+    }
+    return scaled;
+  };
+
+  auto current = OutputImageType::New();
+  auto next = OutputImageType::New();
+  for (unsigned int t = 0; t < numberOfTiles; ++t)
+  {
+    ThreadRegionType tile = regionToProcess;
+    splitter->GetSplit(t, numberOfTiles, tile);
+
+    // On the boundary of the output buffer, the boundary condition applies
+    // as for the whole image.  Elsewhere, the values of the halo are wrong
+    // one radius further inside at each iteration, so only the tile is right
+    // after the last one.
+    ThreadRegionType haloRegion = tile;
+    haloRegion.PadByRadius(scaledRadius(numberOfIterations));
+    haloRegion.Crop(output->GetBufferedRegion());
+
+    // The pixels outside of the requested region are never updated, so both
+    // buffers start with the output
+    for (OutputImageType * buffer : { current.GetPointer(), next.GetPointer() })
+    {
+      buffer->CopyInformation(output);
+      buffer->SetRegions(haloRegion);
+      buffer->Allocate();
+      ImageAlgorithm::Copy(output, buffer, haloRegion, haloRegion);
+    }
+
+    for (unsigned int i = 1; i <= numberOfIterations; ++i)
+    {
+      ThreadRegionType region = tile;
+      region.PadByRadius(scaledRadius(numberOfIterations - i));
+      region.Crop(haloRegion);
+      region.Crop(output->GetRequestedRegion());
+
+      this->FusedUpdateRegion(current, next, region, dt, globalData);
+      std::swap(current, next);
+    }
+    ImageAlgorithm::Copy(current.GetPointer(), m_UpdateBuffer.GetPointer(), tile, tile);
+  }
+
+  df->ReleaseGlobalDataPointer(globalData);
+}
+
+template <typename TInputImage, typename TOutputImage>
+void
+DenseFiniteDifferenceImageFilter<TInputImage, TOutputImage>::FusedUpdateRegion(const OutputImageType *  image,
+                                                                               UpdateBufferType *       next,
+                                                                               const ThreadRegionType & region,
+                                                                               const TimeStepType &     dt,
+                                                                               void *                   globalData)
+{
+  using NeighborhoodIteratorType = typename FiniteDifferenceFunctionType::NeighborhoodType;
+  using UpdateIteratorType = ImageRegionIterator<UpdateBufferType>;
+  using FaceCalculatorType = NeighborhoodAlgorithm::ImageBoundaryFacesCalculator<OutputImageType>;
+
+  const typename FiniteDifferenceFunctionType::Pointer df = this->GetDifferenceFunction();
+  const typename FiniteDifferenceFunctionType::RadiusType radius = df->GetRadius();
+
+  // The same operations as the calculation of the change followed by its
+  // application, so that the results are the same.  The first face is the
+  // non-boundary region, processed a line at a time if the function can.
+  FaceCalculatorType     faceCalculator;
+  bool                   firstFace = true;
+  std::vector<PixelType> updates;
+  for (const ThreadRegionType & face : faceCalculator(image, region, radius))
+  {
+    const bool lineByLine = firstFace && df->SupportsComputeUpdateSpan() && face.GetNumberOfPixels() > 0;
+    firstFace = false;
+    if (lineByLine)
+    {
+      updates.resize(face.GetSize(0));
+      ImageScanlineConstIterator<OutputImageType> lineIt(image, face);
+      ImageScanlineIterator<UpdateBufferType>     nextLineIt(next, face);
+      for (; !nextLineIt.IsAtEnd(); lineIt.NextLine(), nextLineIt.NextLine())
+      {
+        df->ComputeUpdateSpan(image, nextLineIt.GetIndex(), updates.size(), updates.data(), globalData);
+        for (auto update = updates.cbegin(); update != updates.cend(); ++update, ++lineIt, ++nextLineIt)
+        {
+          PixelType value = lineIt.Get();
+          value += static_cast<PixelType>(*update * dt);
+          nextLineIt.Set(value);
+        }
+      }
+    }
+    else
+    {
+      NeighborhoodIteratorType it(radius, image, face);
+      UpdateIteratorType       nextIt(next, face);
+      for (; !it.IsAtEnd(); ++it, ++nextIt)
+      {
+        PixelType value = it.GetCenterPixel();
+        value += static_cast<PixelType>(df->ComputeUpdate(it, globalData) * dt);
+        nextIt.Value() = value;
+      }
+    }
+  }
+}
+
 template <typename TInputImage, typename TOutputImage>
 void
 DenseFiniteDifferenceImageFilter<TInputImage, TOutputImage>::PrintSelf(std::ostream & os, Indent indent) const
 {
   Superclass::PrintSelf(os, indent);
+  os << indent << "UseFusedUpdate: " << m_UseFusedUpdate << std::endl;
+  os << indent << "NumberOfFusedIterations: " << m_NumberOfFusedIterations << std::endl;
 }
 } // end namespace itk
 
@@ -81,6 +81,7 @@ public:
   using ImageType = TImageType;
   using PixelType = typename ImageType::PixelType;
   using PixelRealType = double;
+  using IndexType = typename ImageType::IndexType;
 
   /** Save image dimension. */
   static constexpr unsigned int ImageDimension = ImageType::ImageDimension;
@@ -138,6 +139,36 @@ public:
                 void *                   globalData,
                 const FloatOffsetType &  offset = FloatOffsetType(0.0)) = 0;
 
+  /** Whether the solver may call ComputeUpdateSpan() rather than
+   * ComputeUpdate() for the pixels which do not lie on a data set boundary.
+   * The default is false.  A class which implements ComputeUpdateSpan()
+   * only returns true when it is the most derived class of the function,
+   * since the span would bypass the ComputeUpdate() of a subclass.  A
+   * subclass which does not change the update opts in by overriding this
+   * method. */
+  virtual bool
+  SupportsComputeUpdateSpan() const
+  {
+    return false;
+  }
+
+  /** Computes the updates of a line of pixels along the first dimension,
+   * none of which lies on a data set boundary, starting at the given index
+   * of the image.  Implementations read the pixels and their neighbors
+   * directly from the buffer of the image, which avoids the overhead of a
+   * neighborhood iterator at each pixel and lets the compiler vectorize the
+   * stencils, and must give the same updates, and the same global data, as
+   * ComputeUpdate() at each pixel of the line in turn.  It is only called
+   * when SupportsComputeUpdateSpan() returns true. */
+  virtual void
+  ComputeUpdateSpan(const ImageType * itkNotUsed(image),
+                    const IndexType & itkNotUsed(index),
+                    SizeValueType     itkNotUsed(length),
+                    PixelType *       itkNotUsed(updates),
+                    void *            itkNotUsed(globalData))
+  {
+    itkExceptionMacro(<< "ComputeUpdateSpan() is not implemented");
+  }
 
   /** Sets the radius of the neighborhood this FiniteDifferenceFunction
    * needs to perform its calculations. */
@@ -149,6 +149,22 @@ protected:
   void
   InitializeIteration() override;
 
+  /** The time step is a parameter of the filter, so the update can be
+   * fused. */
+  bool
+  TimeStepIsFixed() const override
+  {
+    return true;
+  }
+
+  /** The difference function only changes between iterations when the
+   * average gradient magnitude is calculated from the output. */
+  bool
+  DifferenceFunctionIsFixed() const override
+  {
+    return m_GradientMagnitudeIsFixed;
+  }
+
   bool m_GradientMagnitudeIsFixed;
 
 private:
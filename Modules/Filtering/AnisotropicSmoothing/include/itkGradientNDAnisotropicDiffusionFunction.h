@@ -22,6 +22,7 @@
 #include "itkNeighborhoodAlgorithm.h"
 #include "itkNeighborhoodInnerProduct.h"
 #include "itkDerivativeOperator.h"
+#include <typeinfo>
 
 namespace itk
 {
@@ -83,6 +84,7 @@ public:
   using RadiusType = typename Superclass::RadiusType;
   using NeighborhoodType = typename Superclass::NeighborhoodType;
   using FloatOffsetType = typename Superclass::FloatOffsetType;
+  using IndexType = typename Superclass::IndexType;
 
   using NeighborhoodSizeValueType = SizeValueType;
 
@@ -95,6 +97,23 @@ public:
                 void *                   globalData,
                 const FloatOffsetType &  offset = FloatOffsetType(0.0)) override;
 
+  /** The span is only used when this class is the most derived class of the
+   * function, since it would bypass the ComputeUpdate() of a subclass. */
+  bool
+  SupportsComputeUpdateSpan() const override
+  {
+    return typeid(*this) == typeid(Self);
+  }
+
+  /** Compute the equation value along a line of pixels, from the pixel
+   * buffer, one dimension at a time over blocks of pixels. */
+  void
+  ComputeUpdateSpan(const ImageType * image,
+                    const IndexType & index,
+                    SizeValueType     length,
+                    PixelType *       updates,
+                    void *            globalData) override;
+
   /** This method is called prior to each iteration of the solver. */
   void
   InitializeIteration() override
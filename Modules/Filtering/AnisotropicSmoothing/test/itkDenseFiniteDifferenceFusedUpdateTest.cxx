@@ -0,0 +1,210 @@
+/*=========================================================================
+ *
+ *  Copyright NumFOCUS
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include "itkCurvatureAnisotropicDiffusionImageFilter.h"
+#include "itkCurvatureFlowImageFilter.h"
+#include "itkDefaultConvertPixelTraits.h"
+#include "itkGradientAnisotropicDiffusionImageFilter.h"
+#include "itkImageRegionIteratorWithIndex.h"
+#include "itkMinMaxCurvatureFlowImageFilter.h"
+#include "itkTestingMacros.h"
+#include "itkTimeProbe.h"
+#include "itkVectorGradientAnisotropicDiffusionImageFilter.h"
+
+namespace
+{
+// Noisy blocks of several intensities, with blocks of other sizes for each
+// component
+template <typename TImage>
+typename TImage::Pointer
+CreateImage(const typename TImage::SizeType & size)
+{
+  auto image = TImage::New();
+  image->SetRegions(size);
+  image->Allocate();
+
+  using PixelTraits = itk::DefaultConvertPixelTraits<typename TImage::PixelType>;
+  itk::ImageRegionIteratorWithIndex<TImage> it(image, image->GetLargestPossibleRegion());
+  unsigned int                              state = 8642;
+  for (; !it.IsAtEnd(); ++it)
+  {
+    typename TImage::PixelType pixel;
+    for (unsigned int c = 0; c < PixelTraits::GetNumberOfComponents(); ++c)
+    {
+      state = state * 1103515245u + 12345u;
+      double value = ((state >> 16) % 100) / 10.0;
+      for (unsigned int d = 0; d < TImage::ImageDimension; ++d)
+      {
+        value += 20.0 * ((it.GetIndex()[d] / (7 + c)) % 3);
+      }
+      PixelTraits::SetNthComponent(c, pixel, static_cast<typename PixelTraits::ComponentType>(value));
+    }
+    it.Set(pixel);
+  }
+  return image;
+}
+
+template <typename TImage>
+bool
+CompareImages(const TImage * image, const TImage * reference, const std::string & description)
+{
+  itk::ImageRegionConstIteratorWithIndex<TImage> it(image, reference->GetLargestPossibleRegion());
+  itk::ImageRegionConstIterator<TImage>          referenceIt(reference, reference->GetLargestPossibleRegion());
+  for (; !referenceIt.IsAtEnd(); ++it, ++referenceIt)
+  {
+    if (it.Get() != referenceIt.Get())
+    {
+      std::cerr << "Test failed for " << description << std::endl;
+      std::cerr << "Error at index " << it.GetIndex() << std::endl;
+      std::cerr << "Expected: " << referenceIt.Get() << ", but got: " << it.Get() << std::endl;
+      return false;
+    }
+  }
+  return true;
+}
+
+// Compares the fused update with the separate calculation and application
+// of the change, for several numbers of fused iterations and work units,
+// and prints the time of both
+template <typename TFilter>
+bool
+CheckFusedUpdate(typename TFilter::Pointer filter, const std::string & description)
+{
+  using ImageType = typename TFilter::OutputImageType;
+
+  filter->SetNumberOfIterations(5);
+  filter->SetUseFusedUpdate(false);
+
+  itk::TimeProbe referenceProbe;
+  referenceProbe.Start();
+  filter->Update();
+  referenceProbe.Stop();
+  const typename ImageType::Pointer reference = filter->GetOutput();
+  reference->DisconnectPipeline();
+
+  bool passed = true;
+  for (unsigned int numberOfFusedIterations : { 1, 2, 4, 7 })
+  {
+    for (itk::ThreadIdType numberOfWorkUnits : { 1, 3 })
+    {
+      const std::string name = description + ", " + std::to_string(numberOfFusedIterations) + " fused iterations, " +
+                               std::to_string(numberOfWorkUnits) + " work units";
+
+      filter->UseFusedUpdateOn();
+      filter->SetNumberOfFusedIterations(numberOfFusedIterations);
+      filter->SetNumberOfWorkUnits(numberOfWorkUnits);
+
+      itk::TimeProbe probe;
+      probe.Start();
+      filter->Update();
+      probe.Stop();
+
+      std::cout << name << ": " << probe.GetTotal() << " s, separate passes " << referenceProbe.GetTotal() << " s"
+                << std::endl;
+      if (filter->GetElapsedIterations() != 5u)
+      {
+        std::cerr << "Test failed for " << name << std::endl;
+        std::cerr << "Expected 5 elapsed iterations, but got " << filter->GetElapsedIterations() << std::endl;
+        passed = false;
+      }
+      passed &= CompareImages<ImageType>(filter->GetOutput(), reference, name);
+    }
+  }
+  return passed;
+}
+} // namespace
+
+// Checks that the fused update of the dense finite difference filters with a
+// fixed time step, with one or several iterations per pass over the image,
+// gives the same results as the separate calculation and application of
+// the change.
+int
+itkDenseFiniteDifferenceFusedUpdateTest(int, char *[])
+{
+  bool passed = true;
+
+  // 3D gradient anisotropic diffusion, with the average gradient magnitude
+  // recalculated at each iteration, so only one iteration per pass, and
+  // fixed
+  {
+    using ImageType = itk::Image<float, 3>;
+    using FilterType = itk::GradientAnisotropicDiffusionImageFilter<ImageType, ImageType>;
+    const ImageType::Pointer image = CreateImage<ImageType>(ImageType::SizeType{ { 67, 53, 41 } });
+
+    auto filter = FilterType::New();
+    filter->SetInput(image);
+    filter->SetTimeStep(0.0625);
+    filter->SetConductanceParameter(3.0);
+
+    ITK_TEST_SET_GET_BOOLEAN(filter, UseFusedUpdate, true);
+    filter->SetNumberOfFusedIterations(0);
+    ITK_TEST_SET_GET_VALUE(1u, filter->GetNumberOfFusedIterations());
+
+    passed &= CheckFusedUpdate<FilterType>(filter, "3D gradient anisotropic diffusion");
+    filter->SetFixedAverageGradientMagnitude(10.0);
+    passed &= CheckFusedUpdate<FilterType>(filter, "3D gradient anisotropic diffusion, fixed gradient magnitude");
+  }
+
+  // 2D curvature anisotropic diffusion
+  {
+    using ImageType = itk::Image<double, 2>;
+    using FilterType = itk::CurvatureAnisotropicDiffusionImageFilter<ImageType, ImageType>;
+    const ImageType::Pointer image = CreateImage<ImageType>(ImageType::SizeType{ { 301, 257 } });
+
+    auto filter = FilterType::New();
+    filter->SetInput(image);
+    filter->SetTimeStep(0.1);
+    filter->SetFixedAverageGradientMagnitude(5.0);
+    passed &= CheckFusedUpdate<FilterType>(filter, "2D curvature anisotropic diffusion");
+  }
+
+  // 2D vector gradient anisotropic diffusion
+  {
+    using ImageType = itk::Image<itk::Vector<float, 3>, 2>;
+    using FilterType = itk::VectorGradientAnisotropicDiffusionImageFilter<ImageType, ImageType>;
+    const ImageType::Pointer image = CreateImage<ImageType>(ImageType::SizeType{ { 90, 70 } });
+
+    auto filter = FilterType::New();
+    filter->SetInput(image);
+    filter->SetTimeStep(0.1);
+    filter->SetFixedAverageGradientMagnitude(5.0);
+    passed &= CheckFusedUpdate<FilterType>(filter, "2D vector gradient anisotropic diffusion");
+  }
+
+  // 3D curvature flow, and min/max curvature flow with a stencil radius of 2
+  {
+    using ImageType = itk::Image<float, 3>;
+    using FilterType = itk::CurvatureFlowImageFilter<ImageType, ImageType>;
+    using MinMaxFilterType = itk::MinMaxCurvatureFlowImageFilter<ImageType, ImageType>;
+    const ImageType::Pointer image = CreateImage<ImageType>(ImageType::SizeType{ { 61, 47, 45 } });
+
+    auto filter = FilterType::New();
+    filter->SetInput(image);
+    filter->SetTimeStep(0.1);
+    passed &= CheckFusedUpdate<FilterType>(filter, "3D curvature flow");
+
+    auto minMaxFilter = MinMaxFilterType::New();
+    minMaxFilter->SetInput(CreateImage<ImageType>(ImageType::SizeType{ { 31, 27, 25 } }));
+    minMaxFilter->SetTimeStep(0.1);
+    minMaxFilter->SetStencilRadius(2);
+    passed &= CheckFusedUpdate<MinMaxFilterType>(minMaxFilter, "3D min/max curvature flow");
+  }
+
+  std::cout << "Test finished." << std::endl;
+  return passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
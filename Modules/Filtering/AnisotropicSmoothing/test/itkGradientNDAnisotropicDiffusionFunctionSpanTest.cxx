@@ -0,0 +1,194 @@
+/*=========================================================================
+ *
+ *  Copyright NumFOCUS
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include "itkGradientAnisotropicDiffusionImageFilter.h"
+#include "itkImageRegionIteratorWithIndex.h"
+#include "itkTimeProbe.h"
+#include <atomic>
+
+namespace
+{
+// A subclass which only overrides ComputeUpdate(), so that the solver calls
+// it at each pixel rather than computing the updates of whole lines
+template <typename TImage>
+class PerPixelGradientNDAnisotropicDiffusionFunction : public itk::GradientNDAnisotropicDiffusionFunction<TImage>
+{
+public:
+  ITK_DISALLOW_COPY_AND_ASSIGN(PerPixelGradientNDAnisotropicDiffusionFunction);
+
+  using Self = PerPixelGradientNDAnisotropicDiffusionFunction;
+  using Superclass = itk::GradientNDAnisotropicDiffusionFunction<TImage>;
+  using Pointer = itk::SmartPointer<Self>;
+  using PixelType = typename Superclass::PixelType;
+  using NeighborhoodType = typename Superclass::NeighborhoodType;
+  using FloatOffsetType = typename Superclass::FloatOffsetType;
+
+  itkNewMacro(Self);
+
+  PixelType
+  ComputeUpdate(const NeighborhoodType & neighborhood,
+                void *                   globalData,
+                const FloatOffsetType &  offset = FloatOffsetType(0.0)) override
+  {
+    ++m_NumberOfComputedUpdates;
+    return Superclass::ComputeUpdate(neighborhood, globalData, offset);
+  }
+
+  std::atomic<itk::SizeValueType> m_NumberOfComputedUpdates{ 0 };
+
+protected:
+  PerPixelGradientNDAnisotropicDiffusionFunction() = default;
+};
+
+// Noisy blocks of several intensities
+template <typename TImage>
+typename TImage::Pointer
+CreateImage(const typename TImage::SizeType & size)
+{
+  auto image = TImage::New();
+  image->SetRegions(size);
+  image->Allocate();
+
+  itk::ImageRegionIteratorWithIndex<TImage> it(image, image->GetLargestPossibleRegion());
+  unsigned int                              state = 1357;
+  for (; !it.IsAtEnd(); ++it)
+  {
+    state = state * 1103515245u + 12345u;
+    double value = ((state >> 16) % 100) / 10.0;
+    for (unsigned int d = 0; d < TImage::ImageDimension; ++d)
+    {
+      value += 20.0 * ((it.GetIndex()[d] / 9) % 3);
+    }
+    it.Set(static_cast<typename TImage::PixelType>(value));
+  }
+  return image;
+}
+
+template <typename TImage>
+bool
+CompareImages(const TImage * image, const TImage * reference, const std::string & description)
+{
+  itk::ImageRegionConstIteratorWithIndex<TImage> it(image, reference->GetLargestPossibleRegion());
+  itk::ImageRegionConstIterator<TImage>          referenceIt(reference, reference->GetLargestPossibleRegion());
+  for (; !referenceIt.IsAtEnd(); ++it, ++referenceIt)
+  {
+    if (it.Get() != referenceIt.Get())
+    {
+      std::cerr << "Test failed for " << description << std::endl;
+      std::cerr << "Error at index " << it.GetIndex() << std::endl;
+      std::cerr << "Expected: " << referenceIt.Get() << ", but got: " << it.Get() << std::endl;
+      return false;
+    }
+  }
+  return true;
+}
+
+// Compares the diffusion computed a line at a time with the one computed a
+// pixel at a time, with and without the fused update, and prints the time
+// of both
+template <typename TImage>
+bool
+CheckSpans(const typename TImage::SizeType & size, bool useImageSpacing, const std::string & description)
+{
+  using FilterType = itk::GradientAnisotropicDiffusionImageFilter<TImage, TImage>;
+
+  const typename TImage::Pointer image = CreateImage<TImage>(size);
+  typename TImage::SpacingType   spacing;
+  for (unsigned int d = 0; d < TImage::ImageDimension; ++d)
+  {
+    spacing[d] = 0.5 + 0.25 * d;
+  }
+  image->SetSpacing(spacing);
+
+  bool passed = true;
+  for (bool useFusedUpdate : { false, true })
+  {
+    const std::string name = description + (useFusedUpdate ? ", fused update" : "");
+
+    auto filter = FilterType::New();
+    filter->SetInput(image);
+    filter->SetNumberOfIterations(4);
+    filter->SetTimeStep(0.015);
+    filter->SetConductanceParameter(2.0);
+    filter->SetUseImageSpacing(useImageSpacing);
+    filter->SetUseFusedUpdate(useFusedUpdate);
+
+    auto perPixelFilter = FilterType::New();
+    perPixelFilter->SetInput(image);
+    perPixelFilter->SetNumberOfIterations(4);
+    perPixelFilter->SetTimeStep(0.015);
+    perPixelFilter->SetConductanceParameter(2.0);
+    perPixelFilter->SetUseImageSpacing(useImageSpacing);
+    perPixelFilter->SetUseFusedUpdate(useFusedUpdate);
+    const auto perPixelFunction = PerPixelGradientNDAnisotropicDiffusionFunction<TImage>::New();
+    perPixelFilter->SetDifferenceFunction(perPixelFunction);
+
+    itk::TimeProbe perPixelProbe;
+    perPixelProbe.Start();
+    perPixelFilter->Update();
+    perPixelProbe.Stop();
+
+    itk::TimeProbe probe;
+    probe.Start();
+    filter->Update();
+    probe.Stop();
+
+    std::cout << name << ": " << probe.GetTotal() << " s, a pixel at a time " << perPixelProbe.GetTotal() << " s"
+              << std::endl;
+    passed &= CompareImages<TImage>(filter->GetOutput(), perPixelFilter->GetOutput(), name);
+
+    // The ComputeUpdate() of the subclass was not bypassed
+    const itk::SizeValueType numberOfUpdates = 4 * image->GetLargestPossibleRegion().GetNumberOfPixels();
+    if (perPixelFunction->m_NumberOfComputedUpdates != numberOfUpdates)
+    {
+      std::cerr << "Test failed for " << name << std::endl;
+      std::cerr << "The subclass computed " << perPixelFunction->m_NumberOfComputedUpdates << " updates instead of "
+                << numberOfUpdates << std::endl;
+      passed = false;
+    }
+  }
+  return passed;
+}
+} // namespace
+
+// Checks that the gradient anisotropic diffusion computed a line at a time
+// from the pixel buffer gives the same results as the one computed a pixel
+// at a time with a neighborhood iterator.
+int
+itkGradientNDAnisotropicDiffusionFunctionSpanTest(int, char *[])
+{
+  bool passed = true;
+
+  // Only the class which implements the span uses it
+  if (!itk::GradientNDAnisotropicDiffusionFunction<itk::Image<float, 2>>::New()->SupportsComputeUpdateSpan() ||
+      PerPixelGradientNDAnisotropicDiffusionFunction<itk::Image<float, 2>>::New()->SupportsComputeUpdateSpan())
+  {
+    std::cerr << "Test failed: the span is not used by the function only" << std::endl;
+    passed = false;
+  }
+
+  // Lines longer than a block, and lines shorter than the stencil
+  passed &= CheckSpans<itk::Image<float, 2>>(itk::Size<2>{ { 203, 150 } }, true, "2D");
+  passed &= CheckSpans<itk::Image<float, 2>>(itk::Size<2>{ { 3, 40 } }, true, "2D, narrow");
+  passed &= CheckSpans<itk::Image<float, 3>>(itk::Size<3>{ { 70, 45, 33 } }, true, "3D");
+  passed &= CheckSpans<itk::Image<double, 3>>(itk::Size<3>{ { 129, 20, 17 } }, false, "3D double, no spacing");
+  passed &= CheckSpans<itk::Image<float, 4>>(itk::Size<4>{ { 17, 12, 9, 8 } }, true, "4D");
+
+  std::cout << "Test finished." << std::endl;
+  return passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -401,7 +401,7 @@ private:
   /**
    * Sharpen the intensity histogram of the current estimate of the corrected
    * image and map those results to a new estimate of the unsmoothed corrected
-   * image.
+   * image.  The histogram is accumulated by the work units in parallel.
    */
   void
   SharpenImage(const RealImageType * uncorrected, RealImageType * sharpened) const;
@@ -412,7 +412,17 @@ private:
    * bias field estimate.
    */
   RealImagePointer
-  UpdateBiasFieldEstimate(RealImageType *, std::size_t);
+  UpdateBiasFieldEstimate(RealImageType *);
+
+  /**
+   * Fit the control point lattice of a single level B-spline to the
+   * included pixels of the unsmoothed estimate of the bias field, as
+   * BSplineScatteredDataPointSetToImageFilter does for a point set made of
+   * these pixels, but directly from the image grid.  The work units
+   * accumulate the contributions of the pixels to their own lattices.
+   */
+  typename BiasFieldControlPointLatticeType::Pointer
+  FitBiasFieldControlPointLattice(const RealImageType *, const ArrayType & numberOfControlPoints) const;
 
   /**
    * Convergence is determined by the coefficient of variation of the difference
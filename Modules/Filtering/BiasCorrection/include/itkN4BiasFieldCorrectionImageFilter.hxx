@@ -25,14 +25,14 @@
 #include "itkDivideImageFilter.h"
 #include "itkExpImageFilter.h"
 #include "itkImageBufferRange.h"
-#include "itkImageRegionConstIteratorWithIndex.h"
 #include "itkImageRegionIterator.h"
 #include "itkImageRegionIteratorWithIndex.h"
-#include "itkImportImageFilter.h"
 #include "itkIterationReporter.h"
-#include "itkSubtractImageFilter.h"
 #include "itkVectorIndexSelectionCastImageFilter.h"
 
+#include <algorithm>
+#include <vector>
+
 CLANG_PRAGMA_PUSH
 CLANG_SUPPRESS_Wfloat_equal
 #include "vnl/algo/vnl_fft_1d.h"
@@ -86,7 +86,8 @@ CLANG_SUPPRESS_Wfloat_equal
   template <typename TInputImage, typename TMaskImage, typename TOutputImage>
   void N4BiasFieldCorrectionImageFilter<TInputImage, TMaskImage, TOutputImage>::GenerateData()
   {
-    this->AllocateOutputs();
+    // The output is produced by a minipipeline at the end, so it is not
+    // allocated here, to save the memory of an image while iterating.
 
     const InputImageType * inputImage = this->GetInput();
     using RegionType = typename InputImageType::RegionType;
@@ -124,16 +125,12 @@ CLANG_SUPPRESS_Wfloat_equal
     const ImageBufferRange<RealImageType> logInputImageBufferRange{ *logInputImage };
     const std::size_t                     numberOfPixels = logInputImageBufferRange.size();
 
-    // Number of pixels of the input image that are included with the filter.
-    std::size_t numberOfIncludedPixels = 0;
-
     for (std::size_t indexValue = 0; indexValue < numberOfPixels; ++indexValue)
     {
       if ((maskImageBufferRange.empty() || (useMaskLabel && maskImageBufferRange[indexValue] == maskLabel) ||
            (!useMaskLabel && maskImageBufferRange[indexValue] != NumericTraits<MaskPixelType>::ZeroValue())) &&
           (confidenceImageBufferRange.empty() || confidenceImageBufferRange[indexValue] > 0.0))
       {
-        ++numberOfIncludedPixels;
         auto && logInputPixel = logInputImageBufferRange[indexValue];
 
         if (logInputPixel > NumericTraits<typename InputImageType::PixelType>::ZeroValue())
@@ -164,6 +161,9 @@ CLANG_SUPPRESS_Wfloat_equal
     logSharpenedImage->SetRegions(inputImage->GetLargestPossibleRegion());
     logSharpenedImage->Allocate(false);
 
+    MultiThreaderBase * multiThreader = this->GetMultiThreader();
+    multiThreader->SetNumberOfWorkUnits(this->GetNumberOfWorkUnits());
+
     // Iterate until convergence or iterative exhaustion.
     unsigned int maximumNumberOfLevels = 1;
     for (unsigned int d = 0; d < this->m_NumberOfFittingLevels.Size(); d++)
@@ -190,28 +190,42 @@ CLANG_SUPPRESS_Wfloat_equal
         // Sharpen the current estimate of the uncorrected image.
         this->SharpenImage(logUncorrectedImage, logSharpenedImage);
 
-        using SubtracterType = SubtractImageFilter<RealImageType, RealImageType, RealImageType>;
-        typename SubtracterType::Pointer subtracter1 = SubtracterType::New();
-        subtracter1->SetInput1(logUncorrectedImage);
-        subtracter1->SetInput2(logSharpenedImage);
-
-        RealImagePointer residualBiasField = subtracter1->GetOutput();
-        residualBiasField->Update();
+        // Compute the residual bias field in place of the sharpened image,
+        // which is computed again at the next iteration.
+        RealImagePointer residualBiasField = logSharpenedImage;
+        multiThreader->template ParallelizeImageRegion<ImageDimension>(
+          inputRegion,
+          [&](const RegionType & region) {
+            ImageRegionConstIterator<RealImageType> ItU(logUncorrectedImage, region);
+            ImageRegionIterator<RealImageType>      ItR(residualBiasField, region);
+            for (; !ItR.IsAtEnd(); ++ItU, ++ItR)
+            {
+              ItR.Set(ItU.Get() - ItR.Get());
+            }
+          },
+          nullptr);
 
         // Smooth the residual bias field estimate and add the resulting
         // control point grid to get the new total bias field estimate.
 
-        RealImagePointer newLogBiasField = this->UpdateBiasFieldEstimate(residualBiasField, numberOfIncludedPixels);
+        RealImagePointer newLogBiasField = this->UpdateBiasFieldEstimate(residualBiasField);
 
         this->m_CurrentConvergenceMeasurement = this->CalculateConvergenceMeasurement(logBiasField, newLogBiasField);
         logBiasField = newLogBiasField;
 
-        typename SubtracterType::Pointer subtracter2 = SubtracterType::New();
-        subtracter2->SetInput1(logInputImage);
-        subtracter2->SetInput2(logBiasField);
-
-        logUncorrectedImage = subtracter2->GetOutput();
-        logUncorrectedImage->Update();
+        // Update the uncorrected image in place.
+        multiThreader->template ParallelizeImageRegion<ImageDimension>(
+          inputRegion,
+          [&](const RegionType & region) {
+            ImageRegionConstIterator<RealImageType> ItI(logInputImage, region);
+            ImageRegionConstIterator<RealImageType> ItB(logBiasField, region);
+            ImageRegionIterator<RealImageType>      ItU(logUncorrectedImage, region);
+            for (; !ItU.IsAtEnd(); ++ItI, ++ItB, ++ItU)
+            {
+              ItU.Set(ItI.Get() - ItB.Get());
+            }
+          },
+          nullptr);
 
         reporter.CompletedStep();
       }
@@ -265,63 +279,95 @@ CLANG_SUPPRESS_Wfloat_equal
     const MaskPixelType maskLabel = this->GetMaskLabel();
     const bool          useMaskLabel = this->GetUseMaskLabel();
 
+    const auto isIncluded = [&](std::size_t indexValue) {
+      return (maskImageBufferRange.empty() || (useMaskLabel && maskImageBufferRange[indexValue] == maskLabel) ||
+              (!useMaskLabel && maskImageBufferRange[indexValue] != NumericTraits<MaskPixelType>::ZeroValue())) &&
+             (confidenceImageBufferRange.empty() || confidenceImageBufferRange[indexValue] > 0.0);
+    };
+
+    // The pixels are split in as many chunks as work units, which are
+    // processed in parallel, and whose results are then combined in order.
+    const auto          unsharpenedImageBufferRange = MakeImageBufferRange(unsharpenedImage);
+    const std::size_t   numberOfPixels = unsharpenedImageBufferRange.size();
+    const SizeValueType numberOfChunks = this->GetNumberOfWorkUnits();
+    MultiThreaderBase * multiThreader = this->GetMultiThreader();
+
+    const auto chunkBegin = [numberOfPixels, numberOfChunks](SizeValueType chunk) {
+      return static_cast<std::size_t>(chunk * numberOfPixels / numberOfChunks);
+    };
+
     // Build the histogram for the uncorrected image.  Store copy
     // in a vnl_vector to utilize vnl FFT routines.  Note that variables
     // in real space are denoted by a single uppercase letter whereas their
     // frequency counterparts are indicated by a trailing lowercase 'f'.
 
-    RealType binMaximum = NumericTraits<RealType>::NonpositiveMin();
-    RealType binMinimum = NumericTraits<RealType>::max();
-
-    const auto        unsharpenedImageBufferRange = MakeImageBufferRange(unsharpenedImage);
-    const std::size_t numberOfPixels = unsharpenedImageBufferRange.size();
+    std::vector<RealType> chunkBinMaxima(numberOfChunks, NumericTraits<RealType>::NonpositiveMin());
+    std::vector<RealType> chunkBinMinima(numberOfChunks, NumericTraits<RealType>::max());
 
-    for (std::size_t indexValue = 0; indexValue < numberOfPixels; ++indexValue)
-    {
-      if ((maskImageBufferRange.empty() || (useMaskLabel && maskImageBufferRange[indexValue] == maskLabel) ||
-           (!useMaskLabel && maskImageBufferRange[indexValue] != NumericTraits<MaskPixelType>::ZeroValue())) &&
-          (confidenceImageBufferRange.empty() || confidenceImageBufferRange[indexValue] > 0.0))
-      {
-        RealType pixel = unsharpenedImageBufferRange[indexValue];
-        if (pixel > binMaximum)
-        {
-          binMaximum = pixel;
-        }
-        else if (pixel < binMinimum)
+    multiThreader->ParallelizeArray(
+      0,
+      numberOfChunks,
+      [&](SizeValueType chunk) {
+        RealType binMaximum = NumericTraits<RealType>::NonpositiveMin();
+        RealType binMinimum = NumericTraits<RealType>::max();
+        for (std::size_t indexValue = chunkBegin(chunk); indexValue < chunkBegin(chunk + 1); ++indexValue)
         {
-          binMinimum = pixel;
+          if (isIncluded(indexValue))
+          {
+            const RealType pixel = unsharpenedImageBufferRange[indexValue];
+            binMaximum = std::max(binMaximum, pixel);
+            binMinimum = std::min(binMinimum, pixel);
+          }
         }
-      }
-    }
+        chunkBinMaxima[chunk] = binMaximum;
+        chunkBinMinima[chunk] = binMinimum;
+      },
+      nullptr);
+
+    const RealType binMaximum = *std::max_element(chunkBinMaxima.begin(), chunkBinMaxima.end());
+    const RealType binMinimum = *std::min_element(chunkBinMinima.begin(), chunkBinMinima.end());
     RealType histogramSlope = (binMaximum - binMinimum) / static_cast<RealType>(this->m_NumberOfHistogramBins - 1);
 
     // Create the intensity profile (within the masked region, if applicable)
     // using a triangular parzen windowing scheme.
 
-    vnl_vector<RealType> H(this->m_NumberOfHistogramBins, 0.0);
-
-    for (std::size_t indexValue = 0; indexValue < numberOfPixels; ++indexValue)
-    {
-      if ((maskImageBufferRange.empty() || (useMaskLabel && maskImageBufferRange[indexValue] == maskLabel) ||
-           (!useMaskLabel && maskImageBufferRange[indexValue] != NumericTraits<MaskPixelType>::ZeroValue())) &&
-          (confidenceImageBufferRange.empty() || confidenceImageBufferRange[indexValue] > 0.0))
-      {
-        RealType pixel = unsharpenedImageBufferRange[indexValue];
-
-        RealType     cidx = (static_cast<RealType>(pixel) - binMinimum) / histogramSlope;
-        unsigned int idx = itk::Math::floor(cidx);
-        RealType     offset = cidx - static_cast<RealType>(idx);
+    std::vector<vnl_vector<RealType>> chunkHistograms(numberOfChunks);
 
-        if (offset == 0.0)
+    multiThreader->ParallelizeArray(
+      0,
+      numberOfChunks,
+      [&](SizeValueType chunk) {
+        vnl_vector<RealType> & histogram = chunkHistograms[chunk];
+        histogram.set_size(this->m_NumberOfHistogramBins);
+        histogram.fill(0.0);
+        for (std::size_t indexValue = chunkBegin(chunk); indexValue < chunkBegin(chunk + 1); ++indexValue)
         {
-          H[idx] += 1.0;
+          if (isIncluded(indexValue))
+          {
+            RealType pixel = unsharpenedImageBufferRange[indexValue];
+
+            RealType     cidx = (static_cast<RealType>(pixel) - binMinimum) / histogramSlope;
+            unsigned int idx = itk::Math::floor(cidx);
+            RealType     offset = cidx - static_cast<RealType>(idx);
+
+            if (offset == 0.0)
+            {
+              histogram[idx] += 1.0;
+            }
+            else if (idx < this->m_NumberOfHistogramBins - 1)
+            {
+              histogram[idx] += 1.0 - offset;
+              histogram[idx + 1] += offset;
+            }
+          }
         }
-        else if (idx < this->m_NumberOfHistogramBins - 1)
-        {
-          H[idx] += 1.0 - offset;
-          H[idx + 1] += offset;
-        }
-      }
+      },
+      nullptr);
+
+    vnl_vector<RealType> H(this->m_NumberOfHistogramBins, 0.0);
+    for (const vnl_vector<RealType> & histogram : chunkHistograms)
+    {
+      H += histogram;
     }
 
     // Determine information about the intensity histogram and zero-pad
@@ -444,108 +490,41 @@ CLANG_SUPPRESS_Wfloat_equal
     E = E.extract(this->m_NumberOfHistogramBins, histogramOffset);
 
     // Sharpen the image with the new mapping, E(u|v)
-    sharpenedImage->FillBuffer(0);
-
     const ImageBufferRange<RealImageType> sharpenedImageBufferRange{ *sharpenedImage };
 
-    for (std::size_t indexValue = 0; indexValue < numberOfPixels; ++indexValue)
-    {
-      if ((maskImageBufferRange.empty() || (useMaskLabel && maskImageBufferRange[indexValue] == maskLabel) ||
-           (!useMaskLabel && maskImageBufferRange[indexValue] != NumericTraits<MaskPixelType>::ZeroValue())) &&
-          (confidenceImageBufferRange.empty() || confidenceImageBufferRange[indexValue] > 0.0))
-      {
-        RealType     cidx = (unsharpenedImageBufferRange[indexValue] - binMinimum) / histogramSlope;
-        unsigned int idx = itk::Math::floor(cidx);
-
-        RealType correctedPixel = 0;
-        if (idx < E.size() - 1)
+    multiThreader->ParallelizeArray(
+      0,
+      numberOfChunks,
+      [&](SizeValueType chunk) {
+        for (std::size_t indexValue = chunkBegin(chunk); indexValue < chunkBegin(chunk + 1); ++indexValue)
         {
-          correctedPixel = E[idx] + (E[idx + 1] - E[idx]) * (cidx - static_cast<RealType>(idx));
+          RealType correctedPixel = 0;
+          if (isIncluded(indexValue))
+          {
+            RealType     cidx = (unsharpenedImageBufferRange[indexValue] - binMinimum) / histogramSlope;
+            unsigned int idx = itk::Math::floor(cidx);
+
+            if (idx < E.size() - 1)
+            {
+              correctedPixel = E[idx] + (E[idx + 1] - E[idx]) * (cidx - static_cast<RealType>(idx));
+            }
+            else
+            {
+              correctedPixel = E[E.size() - 1];
+            }
+          }
+          sharpenedImageBufferRange[indexValue] = correctedPixel;
         }
-        else
-        {
-          correctedPixel = E[E.size() - 1];
-        }
-        sharpenedImageBufferRange[indexValue] = correctedPixel;
-      }
-    }
+      },
+      nullptr);
   }
 
   template <typename TInputImage, typename TMaskImage, typename TOutputImage>
   typename N4BiasFieldCorrectionImageFilter<TInputImage, TMaskImage, TOutputImage>::RealImagePointer
   N4BiasFieldCorrectionImageFilter<TInputImage, TMaskImage, TOutputImage>::UpdateBiasFieldEstimate(
-    RealImageType * fieldEstimate, const std::size_t numberOfIncludedPixels)
+    RealImageType * fieldEstimate)
   {
-    // Temporarily set the direction cosine to identity since the B-spline
-    // approximation algorithm works in parametric space and not physical
-    // space.
-    typename ScalarImageType::DirectionType identity;
-    identity.SetIdentity();
-
-    const typename ScalarImageType::RegionType & bufferedRegion = fieldEstimate->GetBufferedRegion();
-    const SizeValueType                          numberOfPixels = bufferedRegion.GetNumberOfPixels();
-    const bool                                   filterHandlesMemory = false;
-
-    using ImporterType = ImportImageFilter<RealType, ImageDimension>;
-    typename ImporterType::Pointer importer = ImporterType::New();
-    importer->SetImportPointer(fieldEstimate->GetBufferPointer(), numberOfPixels, filterHandlesMemory);
-    importer->SetRegion(fieldEstimate->GetBufferedRegion());
-    importer->SetOrigin(fieldEstimate->GetOrigin());
-    importer->SetSpacing(fieldEstimate->GetSpacing());
-    importer->SetDirection(identity);
-    importer->Update();
-
-    const typename ImporterType::OutputImageType * parametricFieldEstimate = importer->GetOutput();
-
-    PointSetPointer fieldPoints = PointSetType::New();
-    fieldPoints->Initialize();
-    auto & pointSTLContainer = fieldPoints->GetPoints()->CastToSTLContainer();
-    pointSTLContainer.reserve(numberOfIncludedPixels);
-    auto & pointDataSTLContainer = fieldPoints->GetPointData()->CastToSTLContainer();
-    pointDataSTLContainer.reserve(numberOfIncludedPixels);
-
-    typename BSplineFilterType::WeightsContainerType::Pointer weights = BSplineFilterType::WeightsContainerType::New();
-    weights->Initialize();
-    auto & weightSTLContainer = weights->CastToSTLContainer();
-    weightSTLContainer.reserve(numberOfIncludedPixels);
-
-    const auto          maskImageBufferRange = MakeImageBufferRange(this->GetMaskImage());
-    const auto          confidenceImageBufferRange = MakeImageBufferRange(this->GetConfidenceImage());
-    const MaskPixelType maskLabel = this->GetMaskLabel();
-    const bool          useMaskLabel = this->GetUseMaskLabel();
-
-    ImageRegionConstIteratorWithIndex<RealImageType> It(parametricFieldEstimate,
-                                                        parametricFieldEstimate->GetRequestedRegion());
-
-    for (std::size_t indexValue = 0; indexValue < numberOfPixels; ++indexValue, ++It)
-    {
-      if ((maskImageBufferRange.empty() || (useMaskLabel && maskImageBufferRange[indexValue] == maskLabel) ||
-           (!useMaskLabel && maskImageBufferRange[indexValue] != NumericTraits<MaskPixelType>::ZeroValue())) &&
-          (confidenceImageBufferRange.empty() || confidenceImageBufferRange[indexValue] > 0.0))
-      {
-        PointType point;
-        parametricFieldEstimate->TransformIndexToPhysicalPoint(It.GetIndex(), point);
-
-        ScalarType scalar;
-        scalar[0] = It.Get();
-
-        pointDataSTLContainer.push_back(scalar);
-        pointSTLContainer.push_back(point);
-
-        RealType confidenceWeight = 1.0;
-        if (!confidenceImageBufferRange.empty())
-        {
-          confidenceWeight = confidenceImageBufferRange[indexValue];
-        }
-        weightSTLContainer.push_back(confidenceWeight);
-      }
-    }
-
-    typename BSplineFilterType::Pointer bspliner = BSplineFilterType::New();
-
-    typename BSplineFilterType::ArrayType numberOfControlPoints;
-    typename BSplineFilterType::ArrayType numberOfFittingLevels;
-    numberOfFittingLevels.Fill(1);
+    ArrayType numberOfControlPoints;
     for (unsigned int d = 0; d < ImageDimension; d++)
     {
       if (!this->m_LogBiasFieldControlPointLattice)
@@ -558,24 +537,8 @@ CLANG_SUPPRESS_Wfloat_equal
       }
     }
 
-    typename ScalarImageType::PointType parametricOrigin = fieldEstimate->GetOrigin();
-    for (unsigned int d = 0; d < ImageDimension; d++)
-    {
-      parametricOrigin[d] += (fieldEstimate->GetSpacing()[d] * fieldEstimate->GetLargestPossibleRegion().GetIndex()[d]);
-    }
-    bspliner->SetOrigin(parametricOrigin);
-    bspliner->SetSpacing(fieldEstimate->GetSpacing());
-    bspliner->SetSize(fieldEstimate->GetLargestPossibleRegion().GetSize());
-    bspliner->SetDirection(fieldEstimate->GetDirection());
-    bspliner->SetGenerateOutputImage(false);
-    bspliner->SetNumberOfLevels(numberOfFittingLevels);
-    bspliner->SetSplineOrder(this->m_SplineOrder);
-    bspliner->SetNumberOfControlPoints(numberOfControlPoints);
-    bspliner->SetInput(fieldPoints);
-    bspliner->SetPointWeights(weights);
-    bspliner->Update();
-
-    typename BiasFieldControlPointLatticeType::Pointer phiLattice = bspliner->GetPhiLattice();
+    typename BiasFieldControlPointLatticeType::Pointer phiLattice =
+      this->FitBiasFieldControlPointLattice(fieldEstimate, numberOfControlPoints);
 
     // Add the bias field control points to the current estimate.
 
@@ -606,6 +569,274 @@ CLANG_SUPPRESS_Wfloat_equal
     return smoothField;
   }
 
+  template <typename TInputImage, typename TMaskImage, typename TOutputImage>
+  typename N4BiasFieldCorrectionImageFilter<TInputImage, TMaskImage, TOutputImage>::BiasFieldControlPointLatticeType::
+    Pointer
+    N4BiasFieldCorrectionImageFilter<TInputImage, TMaskImage, TOutputImage>::FitBiasFieldControlPointLattice(
+      const RealImageType * fieldEstimate, const ArrayType & numberOfControlPoints) const
+  {
+    using LatticeRealType = typename BSplineFilterType::RealType;
+    using LatticePixelType = typename BiasFieldControlPointLatticeType::PixelType;
+
+    for (unsigned int d = 0; d < ImageDimension; d++)
+    {
+      if (numberOfControlPoints[d] < this->m_SplineOrder + 1)
+      {
+        itkExceptionMacro("The number of control points must be greater than the spline order.");
+      }
+    }
+
+    // The B-spline approximation algorithm works in parametric space, as if
+    // the field estimate had an identity direction, with its origin at the
+    // first pixel.
+    const typename RealImageType::RegionType &  bufferedRegion = fieldEstimate->GetBufferedRegion();
+    const typename RealImageType::SizeType &    size = bufferedRegion.GetSize();
+    const typename RealImageType::SpacingType & spacing = fieldEstimate->GetSpacing();
+    typename ScalarImageType::PointType         parametricOrigin = fieldEstimate->GetOrigin();
+    for (unsigned int d = 0; d < ImageDimension; d++)
+    {
+      parametricOrigin[d] += (spacing[d] * fieldEstimate->GetLargestPossibleRegion().GetIndex()[d]);
+    }
+
+    typename BSplineFilterType::KernelType::Pointer kernel = BSplineFilterType::KernelType::New();
+    kernel->SetSplineOrder(this->m_SplineOrder);
+    typename BSplineFilterType::KernelOrder0Type::Pointer kernelOrder0 = BSplineFilterType::KernelOrder0Type::New();
+    typename BSplineFilterType::KernelOrder1Type::Pointer kernelOrder1 = BSplineFilterType::KernelOrder1Type::New();
+    typename BSplineFilterType::KernelOrder2Type::Pointer kernelOrder2 = BSplineFilterType::KernelOrder2Type::New();
+    typename BSplineFilterType::KernelOrder3Type::Pointer kernelOrder3 = BSplineFilterType::KernelOrder3Type::New();
+
+    // The B-spline basis functions are products of functions of the index
+    // of the pixel along each dimension, which are tabulated along with the
+    // first control point of their support and the sum of their squares.
+    const unsigned int           supportSize = this->m_SplineOrder + 1;
+    std::vector<unsigned int>    firstControlPoints[ImageDimension];
+    std::vector<LatticeRealType> basisValues[ImageDimension];
+    std::vector<LatticeRealType> squaredBasisSums[ImageDimension];
+    for (unsigned int d = 0; d < ImageDimension; d++)
+    {
+      const unsigned int    totalNumberOfSpans = numberOfControlPoints[d] - this->m_SplineOrder;
+      const LatticeRealType r = static_cast<LatticeRealType>(totalNumberOfSpans) /
+                                (static_cast<LatticeRealType>(size[d] - 1) * spacing[d]);
+      const LatticeRealType epsilon = r * spacing[d] * static_cast<LatticeRealType>(1e-3);
+
+      firstControlPoints[d].resize(size[d]);
+      basisValues[d].resize(size[d] * supportSize);
+      squaredBasisSums[d].resize(size[d]);
+      for (SizeValueType j = 0; j < size[d]; j++)
+      {
+        const IndexValueType index = bufferedRegion.GetIndex()[d] + static_cast<IndexValueType>(j);
+        const double         point = fieldEstimate->GetOrigin()[d] + spacing[d] * static_cast<double>(index);
+        LatticeRealType p = (point - parametricOrigin[d]) * r;
+        if (std::abs(p - static_cast<LatticeRealType>(totalNumberOfSpans)) <= epsilon)
+        {
+          p = static_cast<LatticeRealType>(totalNumberOfSpans) - epsilon;
+        }
+        if (p < NumericTraits<LatticeRealType>::ZeroValue() && std::abs(p) <= epsilon)
+        {
+          p = NumericTraits<LatticeRealType>::ZeroValue();
+        }
+        if (p < NumericTraits<LatticeRealType>::ZeroValue() || p >= static_cast<LatticeRealType>(totalNumberOfSpans))
+        {
+          itkExceptionMacro("The reparameterized point component "
+                            << p << " is outside the corresponding parametric domain of [0, " << totalNumberOfSpans
+                            << ").");
+        }
+
+        firstControlPoints[d][j] = static_cast<unsigned int>(p);
+        LatticeRealType squaredSum = 0.0;
+        for (unsigned int k = 0; k < supportSize; k++)
+        {
+          const LatticeRealType u = static_cast<LatticeRealType>(p - firstControlPoints[d][j] - k) +
+                                    0.5 * static_cast<LatticeRealType>(this->m_SplineOrder - 1);
+          LatticeRealType B = 0.0;
+          switch (this->m_SplineOrder)
+          {
+            case 0:
+            {
+              B = kernelOrder0->Evaluate(u);
+              break;
+            }
+            case 1:
+            {
+              B = kernelOrder1->Evaluate(u);
+              break;
+            }
+            case 2:
+            {
+              B = kernelOrder2->Evaluate(u);
+              break;
+            }
+            case 3:
+            {
+              B = kernelOrder3->Evaluate(u);
+              break;
+            }
+            default:
+            {
+              B = kernel->Evaluate(u);
+              break;
+            }
+          }
+          basisValues[d][j * supportSize + k] = B;
+          squaredSum += B * B;
+        }
+        squaredBasisSums[d][j] = squaredSum;
+      }
+    }
+
+    // Offsets of the control points in the lattice, and of the ones of the
+    // support of a pixel from its first one.
+    SizeValueType latticeStrides[ImageDimension];
+    SizeValueType numberOfLatticePixels = 1;
+    SizeValueType numberOfSupportPixels = 1;
+    for (unsigned int d = 0; d < ImageDimension; d++)
+    {
+      latticeStrides[d] = numberOfLatticePixels;
+      numberOfLatticePixels *= numberOfControlPoints[d];
+      numberOfSupportPixels *= supportSize;
+    }
+    std::vector<SizeValueType> supportOffsets(numberOfSupportPixels, 0);
+    for (SizeValueType m = 0; m < numberOfSupportPixels; m++)
+    {
+      SizeValueType position = m;
+      for (unsigned int d = 0; d < ImageDimension; d++)
+      {
+        supportOffsets[m] += (position % supportSize) * latticeStrides[d];
+        position /= supportSize;
+      }
+    }
+
+    const auto          fieldEstimateBufferRange = MakeImageBufferRange(fieldEstimate);
+    const auto          maskImageBufferRange = MakeImageBufferRange(this->GetMaskImage());
+    const auto          confidenceImageBufferRange = MakeImageBufferRange(this->GetConfidenceImage());
+    const MaskPixelType maskLabel = this->GetMaskLabel();
+    const bool          useMaskLabel = this->GetUseMaskLabel();
+
+    // The lines of pixels along the first dimension are split in as many
+    // chunks as work units, which accumulate their contributions to their
+    // own delta and omega lattices.
+    const SizeValueType                       numberOfLines = fieldEstimateBufferRange.size() / size[0];
+    const SizeValueType                       numberOfChunks = this->GetNumberOfWorkUnits();
+    std::vector<std::vector<LatticeRealType>> deltaLattices(numberOfChunks);
+    std::vector<std::vector<LatticeRealType>> omegaLattices(numberOfChunks);
+
+    this->GetMultiThreader()->ParallelizeArray(
+      0,
+      numberOfChunks,
+      [&](SizeValueType chunk) {
+        std::vector<LatticeRealType> & delta = deltaLattices[chunk];
+        std::vector<LatticeRealType> & omega = omegaLattices[chunk];
+        delta.assign(numberOfLatticePixels, 0.0);
+        omega.assign(numberOfLatticePixels, 0.0);
+
+        const SizeValueType          numberOfLineSupportPixels = numberOfSupportPixels / supportSize;
+        std::vector<LatticeRealType> lineBasisValues(numberOfLineSupportPixels);
+        const SizeValueType          lastLine = (chunk + 1) * numberOfLines / numberOfChunks;
+        for (SizeValueType line = chunk * numberOfLines / numberOfChunks; line < lastLine; line++)
+        {
+          // The basis functions along the other dimensions are the same for
+          // all the pixels of the line.
+          SizeValueType   lineOffset = 0;
+          LatticeRealType lineSquaredBasisSum = 1.0;
+          std::fill(lineBasisValues.begin(), lineBasisValues.end(), 1.0);
+          SizeValueType position = line;
+          SizeValueType supportStride = 1;
+          for (unsigned int d = 1; d < ImageDimension; d++)
+          {
+            const SizeValueType j = position % size[d];
+            position /= size[d];
+            lineOffset += firstControlPoints[d][j] * latticeStrides[d];
+            lineSquaredBasisSum *= squaredBasisSums[d][j];
+            for (SizeValueType m = 0; m < numberOfLineSupportPixels; m++)
+            {
+              lineBasisValues[m] *= basisValues[d][j * supportSize + (m / supportStride) % supportSize];
+            }
+            supportStride *= supportSize;
+          }
+
+          for (SizeValueType j = 0; j < size[0]; j++)
+          {
+            const std::size_t indexValue = line * size[0] + j;
+            if ((maskImageBufferRange.empty() || (useMaskLabel && maskImageBufferRange[indexValue] == maskLabel) ||
+                 (!useMaskLabel && maskImageBufferRange[indexValue] != NumericTraits<MaskPixelType>::ZeroValue())) &&
+                (confidenceImageBufferRange.empty() || confidenceImageBufferRange[indexValue] > 0.0))
+            {
+              LatticeRealType wc = 1.0;
+              if (!confidenceImageBufferRange.empty())
+              {
+                wc = confidenceImageBufferRange[indexValue];
+              }
+              const LatticeRealType   value = fieldEstimateBufferRange[indexValue];
+              const LatticeRealType   w2Sum = squaredBasisSums[0][j] * lineSquaredBasisSum;
+              const LatticeRealType * firstBasisValues = &basisValues[0][j * supportSize];
+              const SizeValueType     offset = lineOffset + firstControlPoints[0][j];
+              for (SizeValueType m = 0; m < numberOfSupportPixels; m++)
+              {
+                const LatticeRealType t = firstBasisValues[m % supportSize] * lineBasisValues[m / supportSize];
+                omega[offset + supportOffsets[m]] += wc * t * t;
+                delta[offset + supportOffsets[m]] += value * (t * t * t * wc / w2Sum);
+              }
+            }
+          }
+        }
+      },
+      nullptr);
+
+    for (SizeValueType chunk = 1; chunk < numberOfChunks; chunk++)
+    {
+      for (SizeValueType n = 0; n < numberOfLatticePixels; n++)
+      {
+        deltaLattices[0][n] += deltaLattices[chunk][n];
+        omegaLattices[0][n] += omegaLattices[chunk][n];
+      }
+    }
+
+    // Generate the control point lattice, in the physical space given by
+    // BSplineScatteredDataPointSetToImageFilter.
+    typename BiasFieldControlPointLatticeType::SizeType    latticeSize;
+    typename BiasFieldControlPointLatticeType::PointType   latticeOrigin;
+    typename BiasFieldControlPointLatticeType::SpacingType latticeSpacing;
+    for (unsigned int d = 0; d < ImageDimension; d++)
+    {
+      latticeSize[d] = numberOfControlPoints[d];
+
+      const LatticeRealType domain =
+        spacing[d] * static_cast<LatticeRealType>(fieldEstimate->GetLargestPossibleRegion().GetSize()[d] - 1);
+      latticeSpacing[d] = domain / static_cast<LatticeRealType>(numberOfControlPoints[d] - this->m_SplineOrder);
+      latticeOrigin[d] = -0.5 * latticeSpacing[d] * (this->m_SplineOrder - 1);
+    }
+    latticeOrigin = fieldEstimate->GetDirection() * latticeOrigin;
+    for (unsigned int d = 0; d < ImageDimension; d++)
+    {
+      latticeOrigin[d] += parametricOrigin[d];
+    }
+
+    typename BiasFieldControlPointLatticeType::Pointer phiLattice = BiasFieldControlPointLatticeType::New();
+    phiLattice->SetRegions(latticeSize);
+    phiLattice->SetOrigin(latticeOrigin);
+    phiLattice->SetSpacing(latticeSpacing);
+    phiLattice->SetDirection(fieldEstimate->GetDirection());
+    phiLattice->Allocate();
+
+    const ImageBufferRange<BiasFieldControlPointLatticeType> phiLatticeBufferRange{ *phiLattice };
+    for (SizeValueType n = 0; n < numberOfLatticePixels; n++)
+    {
+      LatticePixelType P;
+      P.Fill(0);
+      if (Math::NotAlmostEquals(omegaLattices[0][n], NumericTraits<LatticeRealType>::ZeroValue()))
+      {
+        P[0] = deltaLattices[0][n] / omegaLattices[0][n];
+        if (itk::Math::isnan(P[0]) || itk::Math::isinf(P[0]))
+        {
+          P[0] = 0;
+        }
+      }
+      phiLatticeBufferRange[n] = P;
+    }
+
+    return phiLattice;
+  }
+
   template <typename TInputImage, typename TMaskImage, typename TOutputImage>
   typename N4BiasFieldCorrectionImageFilter<TInputImage, TMaskImage, TOutputImage>::RealImagePointer
   N4BiasFieldCorrectionImageFilter<TInputImage, TMaskImage, TOutputImage>::ReconstructBiasField(
@@ -644,13 +875,8 @@ CLANG_SUPPRESS_Wfloat_equal
   N4BiasFieldCorrectionImageFilter<TInputImage, TMaskImage, TOutputImage>::CalculateConvergenceMeasurement(
     const RealImageType * fieldEstimate1, const RealImageType * fieldEstimate2) const
   {
-    using SubtracterType = SubtractImageFilter<RealImageType, RealImageType, RealImageType>;
-    typename SubtracterType::Pointer subtracter = SubtracterType::New();
-    subtracter->SetInput1(fieldEstimate1);
-    subtracter->SetInput2(fieldEstimate2);
-    subtracter->Update();
-
-    // Calculate statistics over the mask region
+    // Calculate statistics of the difference of the estimates over the mask
+    // region
 
     RealType mu = 0.0;
     RealType sigma = 0.0;
@@ -661,8 +887,9 @@ CLANG_SUPPRESS_Wfloat_equal
     const MaskPixelType maskLabel = this->GetMaskLabel();
     const bool          useMaskLabel = this->GetUseMaskLabel();
 
-    const auto        subtracterImageBufferRange = MakeImageBufferRange(subtracter->GetOutput());
-    const std::size_t numberOfPixels = subtracterImageBufferRange.size();
+    const auto        fieldEstimate1BufferRange = MakeImageBufferRange(fieldEstimate1);
+    const auto        fieldEstimate2BufferRange = MakeImageBufferRange(fieldEstimate2);
+    const std::size_t numberOfPixels = fieldEstimate1BufferRange.size();
 
     for (std::size_t indexValue = 0; indexValue < numberOfPixels; ++indexValue)
     {
@@ -670,7 +897,7 @@ CLANG_SUPPRESS_Wfloat_equal
            (!useMaskLabel && maskImageBufferRange[indexValue] != NumericTraits<MaskPixelType>::ZeroValue())) &&
           (confidenceImageBufferRange.empty() || confidenceImageBufferRange[indexValue] > 0.0))
       {
-        RealType pixel = std::exp(subtracterImageBufferRange[indexValue]);
+        RealType pixel = std::exp(fieldEstimate1BufferRange[indexValue] - fieldEstimate2BufferRange[indexValue]);
         N += 1.0;
 
         if (N > 1.0)
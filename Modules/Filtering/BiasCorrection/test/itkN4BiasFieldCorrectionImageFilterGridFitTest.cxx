@@ -0,0 +1,269 @@
+/*=========================================================================
+ *
+ *  Copyright NumFOCUS
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#include "itkDefaultConvertPixelTraits.h"
+#include "itkImageBufferRange.h"
+#include "itkImageRegionIteratorWithIndex.h"
+#include "itkN4BiasFieldCorrectionImageFilter.h"
+#include "itkTestingMacros.h"
+
+namespace
+{
+constexpr unsigned int Dimension = 3;
+using RealType = float;
+using ImageType = itk::Image<RealType, Dimension>;
+using MaskImageType = itk::Image<unsigned char, Dimension>;
+using CorrecterType = itk::N4BiasFieldCorrectionImageFilter<ImageType, MaskImageType, ImageType>;
+
+// Compares the buffers of two images of the same size, relative to the
+// largest magnitude of the expected values.
+template <typename TImage>
+bool
+CompareImages(const TImage * image, const TImage * expected, double tolerance, const char * name)
+{
+  using PixelType = typename TImage::PixelType;
+
+  const auto expectedRange = itk::MakeImageBufferRange(expected);
+  const auto imageRange = itk::MakeImageBufferRange(image);
+  if (image->GetBufferedRegion().GetSize() != expected->GetBufferedRegion().GetSize())
+  {
+    std::cerr << "Test failed!" << std::endl;
+    std::cerr << "The " << name << " sizes differ: " << image->GetBufferedRegion().GetSize() << " and "
+              << expected->GetBufferedRegion().GetSize() << std::endl;
+    return false;
+  }
+
+  double maximumValue = 0.0;
+  double maximumDifference = 0.0;
+  for (std::size_t i = 0; i < expectedRange.size(); ++i)
+  {
+    const PixelType expectedValue = expectedRange[i];
+    const PixelType value = imageRange[i];
+    for (unsigned int c = 0; c < itk::NumericTraits<PixelType>::GetLength(expectedValue); ++c)
+    {
+      const double e = itk::DefaultConvertPixelTraits<PixelType>::GetNthComponent(c, expectedValue);
+      const double v = itk::DefaultConvertPixelTraits<PixelType>::GetNthComponent(c, value);
+      maximumValue = std::max(maximumValue, std::abs(e));
+      maximumDifference = std::max(maximumDifference, std::abs(v - e));
+    }
+  }
+
+  std::cout << "Largest " << name << " difference: " << maximumDifference << " (largest value " << maximumValue << ")"
+            << std::endl;
+  if (maximumDifference > tolerance * maximumValue)
+  {
+    std::cerr << "Test failed!" << std::endl;
+    std::cerr << "The " << name << " differs from the expected one by more than " << tolerance << std::endl;
+    return false;
+  }
+  return true;
+}
+
+// Copies an image to a grid which starts at the zero index and covers the
+// same physical points.
+template <typename TImage>
+typename TImage::Pointer
+CopyToZeroIndex(const TImage * image)
+{
+  const typename TImage::RegionType & region = image->GetBufferedRegion();
+
+  typename TImage::PointType origin;
+  image->TransformIndexToPhysicalPoint(region.GetIndex(), origin);
+
+  typename TImage::Pointer copy = TImage::New();
+  copy->CopyInformation(image);
+  copy->SetOrigin(origin);
+  copy->SetRegions(region.GetSize());
+  copy->Allocate();
+  std::copy(
+    image->GetBufferPointer(), image->GetBufferPointer() + region.GetNumberOfPixels(), copy->GetBufferPointer());
+  return copy;
+}
+
+// The coefficient of variation of the pixels of an image where the tissue
+// image has the given value.
+double
+ComputeCoefficientOfVariation(const ImageType * image, const ImageType * tissueImage, RealType tissue)
+{
+  const auto imageRange = itk::MakeImageBufferRange(image);
+  const auto tissueRange = itk::MakeImageBufferRange(tissueImage);
+
+  double sum = 0.0;
+  double sumOfSquares = 0.0;
+  double count = 0.0;
+  for (std::size_t i = 0; i < imageRange.size(); ++i)
+  {
+    if (tissueRange[i] == tissue)
+    {
+      const double value = imageRange[i];
+      sum += value;
+      sumOfSquares += value * value;
+      count += 1.0;
+    }
+  }
+  const double mean = sum / count;
+  return std::sqrt(std::max(sumOfSquares / count - mean * mean, 0.0)) / mean;
+}
+} // namespace
+
+int
+itkN4BiasFieldCorrectionImageFilterGridFitTest(int, char *[])
+{
+  // A piecewise constant image of three tissues, multiplied by a smooth bias
+  // field, on a grid which does not start at the origin and is not aligned
+  // with the physical axes.
+  const ImageType::IndexType  index = { { 3, -4, 2 } };
+  const ImageType::SizeType   size = { { 41, 36, 29 } };
+  const ImageType::RegionType region(index, size);
+
+  ImageType::SpacingType spacing;
+  spacing[0] = 1.2;
+  spacing[1] = 0.9;
+  spacing[2] = 1.5;
+  ImageType::PointType origin;
+  origin[0] = -10.0;
+  origin[1] = 4.0;
+  origin[2] = 7.5;
+  ImageType::DirectionType direction;
+  direction.Fill(0.0);
+  direction(0, 1) = 1.0;
+  direction(1, 0) = -1.0;
+  direction(2, 2) = 1.0;
+
+  ImageType::Pointer input = ImageType::New();
+  input->SetRegions(region);
+  input->SetSpacing(spacing);
+  input->SetOrigin(origin);
+  input->SetDirection(direction);
+  input->Allocate();
+
+  // Two labels in an ellipsoid, so that the mask label matters, and a
+  // confidence decreasing from the center, which is zero in a slab.
+  MaskImageType::Pointer mask = MaskImageType::New();
+  mask->CopyInformation(input);
+  mask->SetRegions(region);
+  mask->Allocate();
+
+  CorrecterType::RealImageType::Pointer confidence = CorrecterType::RealImageType::New();
+  confidence->CopyInformation(input);
+  confidence->SetRegions(region);
+  confidence->Allocate();
+
+  // The tissue of each pixel, to measure the remaining bias
+  ImageType::Pointer tissueImage = ImageType::New();
+  tissueImage->CopyInformation(input);
+  tissueImage->SetRegions(region);
+  tissueImage->Allocate();
+
+  itk::ImageRegionIteratorWithIndex<ImageType>           It(input, region);
+  itk::ImageRegionIterator<MaskImageType>                ItM(mask, region);
+  itk::ImageRegionIterator<CorrecterType::RealImageType> ItC(confidence, region);
+  itk::ImageRegionIterator<ImageType>                    ItT(tissueImage, region);
+  for (; !It.IsAtEnd(); ++It, ++ItM, ++ItC, ++ItT)
+  {
+    double radius = 0.0;
+    double x[Dimension];
+    for (unsigned int d = 0; d < Dimension; ++d)
+    {
+      x[d] = (It.GetIndex()[d] - index[d] + 0.5) / size[d] - 0.5;
+      radius += 4.0 * x[d] * x[d];
+    }
+    const double tissue = radius < 0.3 ? 120.0 : (radius < 0.6 ? 80.0 : 40.0);
+    const double bias = std::exp(0.4 * x[0] - 0.3 * x[1] * x[1] + 0.2 * x[0] * x[2]);
+    It.Set(static_cast<RealType>(tissue * bias));
+    ItT.Set(static_cast<RealType>(tissue));
+    ItM.Set(radius < 0.9 ? (x[2] < 0.3 ? 1 : 2) : 0);
+    ItC.Set(x[1] > 0.35 ? 0.0f : static_cast<RealType>(1.0 - 0.5 * radius));
+  }
+
+  CorrecterType::ArrayType numberOfFittingLevels;
+  numberOfFittingLevels.Fill(3);
+  CorrecterType::VariableSizeArrayType maximumNumberOfIterations(3);
+  maximumNumberOfIterations.Fill(4);
+  CorrecterType::ArrayType numberOfControlPoints;
+  numberOfControlPoints[0] = 4;
+  numberOfControlPoints[1] = 5;
+  numberOfControlPoints[2] = 4;
+
+  // The same images on a grid which starts at the zero index
+  ImageType::Pointer                    shiftedInput = CopyToZeroIndex<ImageType>(input);
+  MaskImageType::Pointer                shiftedMask = CopyToZeroIndex<MaskImageType>(mask);
+  CorrecterType::RealImageType::Pointer shiftedConfidence =
+    CopyToZeroIndex<CorrecterType::RealImageType>(confidence);
+
+  CorrecterType::Pointer correcter = CorrecterType::New();
+  CorrecterType::Pointer singleWorkUnitCorrecter = CorrecterType::New();
+  CorrecterType::Pointer shiftedCorrecter = CorrecterType::New();
+
+  for (CorrecterType * filter :
+       { correcter.GetPointer(), singleWorkUnitCorrecter.GetPointer(), shiftedCorrecter.GetPointer() })
+  {
+    filter->SetInput(input);
+    filter->SetMaskImage(mask);
+    filter->SetConfidenceImage(confidence);
+    filter->SetUseMaskLabel(true);
+    filter->SetMaskLabel(1);
+    filter->SetNumberOfFittingLevels(numberOfFittingLevels);
+    filter->SetMaximumNumberOfIterations(maximumNumberOfIterations);
+    filter->SetNumberOfControlPoints(numberOfControlPoints);
+    filter->SetConvergenceThreshold(0.0);
+  }
+  correcter->SetNumberOfWorkUnits(5);
+  singleWorkUnitCorrecter->SetNumberOfWorkUnits(1);
+  shiftedCorrecter->SetInput(shiftedInput);
+  shiftedCorrecter->SetMaskImage(shiftedMask);
+  shiftedCorrecter->SetConfidenceImage(shiftedConfidence);
+
+  ITK_TRY_EXPECT_NO_EXCEPTION(correcter->Update());
+  ITK_TRY_EXPECT_NO_EXCEPTION(singleWorkUnitCorrecter->Update());
+  ITK_TRY_EXPECT_NO_EXCEPTION(shiftedCorrecter->Update());
+
+  // The work units only change the order of the sums.
+  bool success = CompareImages(correcter->GetLogBiasFieldControlPointLattice(),
+                               singleWorkUnitCorrecter->GetLogBiasFieldControlPointLattice(),
+                               1e-5,
+                               "single work unit lattice");
+  success &=
+    CompareImages(correcter->GetOutput(), singleWorkUnitCorrecter->GetOutput(), 1e-5, "single work unit image");
+
+  // The fit only depends on the physical points of the pixels.
+  success &= CompareImages(correcter->GetLogBiasFieldControlPointLattice(),
+                           shiftedCorrecter->GetLogBiasFieldControlPointLattice(),
+                           1e-4,
+                           "zero index lattice");
+  success &= CompareImages(correcter->GetOutput(), shiftedCorrecter->GetOutput(), 1e-4, "zero index image");
+
+  // Most of the bias of the masked tissue is removed.
+  const double inputVariation = ComputeCoefficientOfVariation(input, tissueImage, 120.0f);
+  const double outputVariation = ComputeCoefficientOfVariation(correcter->GetOutput(), tissueImage, 120.0f);
+  std::cout << "Coefficient of variation of the inner tissue: " << inputVariation << " -> " << outputVariation
+            << std::endl;
+  if (!(outputVariation < 0.25 * inputVariation))
+  {
+    std::cerr << "Test failed!" << std::endl;
+    std::cerr << "The bias field of the inner tissue is not corrected" << std::endl;
+    success = false;
+  }
+
+  if (!success)
+  {
+    return EXIT_FAILURE;
+  }
+
+  std::cout << "Test finished." << std::endl;
+  return EXIT_SUCCESS;
+}
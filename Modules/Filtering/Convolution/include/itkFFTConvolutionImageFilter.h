@@ -107,6 +107,28 @@ public:
   itkSetMacro(SizeGreatestPrimeFactor, SizeValueType);
   itkGetMacro(SizeGreatestPrimeFactor, SizeValueType);
 
+  /** Set/get whether the convolution is computed by overlap-save on tiles
+   * of the output requested region, instead of on the whole padded
+   * image. Each tile is padded with the input pixels around it to a size
+   * of fast Fourier transform, so that the memory used is bounded by the
+   * size of the tiles, and only the input pixels needed for the output
+   * requested region are requested, so that the filter can be streamed,
+   * for example by a StreamingImageFilter. When the size of the tiles is
+   * chosen automatically and the direct convolution is estimated to be
+   * cheaper, the output is computed by a ConvolutionImageFilter instead.
+   * The deconvolution filters deriving from this filter do not use tiles.
+   * Defaults to off. */
+  itkSetMacro(Tiling, bool);
+  itkGetConstMacro(Tiling, bool);
+  itkBooleanMacro(Tiling);
+
+  /** Set/get the size of the output tiles when tiling. The tiles padded by
+   * the size of the kernel minus one are transformed with transforms of
+   * the next fast size. The sizes of zero, the default, are chosen to
+   * minimize the estimated cost of the transforms of all the tiles. */
+  itkSetMacro(TileSize, OutputSizeType);
+  itkGetConstReferenceMacro(TileSize, OutputSizeType);
+
 protected:
   FFTConvolutionImageFilter();
   ~FFTConvolutionImageFilter() override = default;
@@ -118,9 +140,10 @@ protected:
 
   /** FFTConvolutionImageFilter needs the entire image kernel, which in
    * general is going to be a different size than the output requested
-   * region. As such, this filter needs to provide an implementation
-   * for GenerateInputRequestedRegion() in order to inform the
-   * pipeline execution model.
+   * region, and the entire input image or, when tiling, the output
+   * requested region padded by the kernel radius. As such, this filter
+   * needs to provide an implementation for GenerateInputRequestedRegion()
+   * in order to inform the pipeline execution model.
    *
    * \sa ProcessObject::GenerateInputRequestedRegion()  */
   void
@@ -130,6 +153,11 @@ protected:
   void
   GenerateData() override;
 
+  /** Compute the output requested region tile by tile, or with a
+   * ConvolutionImageFilter when it is estimated to be faster. */
+  void
+  GenerateTiledData();
+
   /** Prepare the input images for operations in the Fourier
    * domain. This includes resizing the input and kernel images,
    * normalizing the kernel if requested, shifting the kernel, and
@@ -173,6 +201,16 @@ protected:
                 ProgressAccumulator *             progress,
                 float                             progressWeight);
 
+  /** Normalize the kernel if requested, pad it with zeros to the pad
+   * size, shift it so that its center is at the origin, and take its
+   * Fourier transform. */
+  void
+  TransformKernel(const KernelImageType *           kernel,
+                  const InputSizeType &             padSize,
+                  InternalComplexImagePointerType & transformedKernel,
+                  ProgressAccumulator *             progress,
+                  float                             progressWeight);
+
   /** Produce output from the final Fourier domain image. */
   void
   ProduceOutput(InternalComplexImageType * paddedOutput, ProgressAccumulator * progress, float progressWeight);
@@ -194,6 +232,12 @@ protected:
   InputSizeType
   GetPadSize() const;
 
+  /** Get the size of the transforms of the tiles of a region of the given
+   * size, or a size of zero if the direct convolution of the region is
+   * estimated to be faster. */
+  InputSizeType
+  GetTilePadSize(const OutputSizeType & regionSize) const;
+
   /** Get whether the X dimension has an odd size. */
   bool
   GetXDimensionIsOdd() const;
@@ -203,6 +247,9 @@ protected:
 
 private:
   SizeValueType m_SizeGreatestPrimeFactor;
+
+  bool           m_Tiling{ false };
+  OutputSizeType m_TileSize;
 };
 } // namespace itk
 
@@ -24,13 +24,21 @@
 #include "itkCastImageFilter.h"
 #include "itkChangeInformationImageFilter.h"
 #include "itkConstantPadImageFilter.h"
+#include "itkConvolutionImageFilter.h"
 #include "itkCyclicShiftImageFilter.h"
 #include "itkExtractImageFilter.h"
+#include "itkImageAlgorithm.h"
 #include "itkImageBase.h"
+#include "itkImageRegionExclusionIteratorWithIndex.h"
 #include "itkMultiplyImageFilter.h"
 #include "itkNormalizeToConstantImageFilter.h"
 #include "itkMath.h"
 
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+
 namespace itk
 {
 
@@ -38,17 +46,35 @@ template <typename TInputImage, typename TKernelImage, typename TOutputImage, ty
 FFTConvolutionImageFilter<TInputImage, TKernelImage, TOutputImage, TInternalPrecision>::FFTConvolutionImageFilter()
 {
   m_SizeGreatestPrimeFactor = FFTFilterType::New()->GetSizeGreatestPrimeFactor();
+  m_TileSize.Fill(0);
 }
 
 template <typename TInputImage, typename TKernelImage, typename TOutputImage, typename TInternalPrecision>
 void
 FFTConvolutionImageFilter<TInputImage, TKernelImage, TOutputImage, TInternalPrecision>::GenerateInputRequestedRegion()
 {
-  // Request the largest possible region for both input images.
+  // Request the largest possible region for both input images, or, when
+  // tiling, the input pixels needed for the output requested region.
   if (this->GetInput())
   {
     typename InputImageType::Pointer imagePtr = const_cast<InputImageType *>(this->GetInput());
-    imagePtr->SetRequestedRegionToLargestPossibleRegion();
+    if (m_Tiling && this->GetKernelImage())
+    {
+      const KernelSizeType kernelSize = this->GetKernelImage()->GetLargestPossibleRegion().GetSize();
+      InputSizeType        radius;
+      for (unsigned int i = 0; i < ImageDimension; ++i)
+      {
+        radius[i] = kernelSize[i] / 2;
+      }
+      InputRegionType paddedRegion = this->GetOutput()->GetRequestedRegion();
+      paddedRegion.PadByRadius(radius);
+      imagePtr->SetRequestedRegion(
+        this->GetBoundaryCondition()->GetInputRequestedRegion(imagePtr->GetLargestPossibleRegion(), paddedRegion));
+    }
+    else
+    {
+      imagePtr->SetRequestedRegionToLargestPossibleRegion();
+    }
   }
 
   if (this->GetKernelImage())
@@ -64,6 +90,12 @@ template <typename TInputImage, typename TKernelImage, typename TOutputImage, ty
 void
 FFTConvolutionImageFilter<TInputImage, TKernelImage, TOutputImage, TInternalPrecision>::GenerateData()
 {
+  if (m_Tiling)
+  {
+    this->GenerateTiledData();
+    return;
+  }
+
   // Create a process accumulator for tracking the progress of this minipipeline
   ProgressAccumulator::Pointer progress = ProgressAccumulator::New();
   progress->SetMiniPipelineFilter(this);
@@ -92,6 +124,163 @@ FFTConvolutionImageFilter<TInputImage, TKernelImage, TOutputImage, TInternalPrec
   this->ProduceOutput(multiplyFilter->GetOutput(), progress, 0.2);
 }
 
+template <typename TInputImage, typename TKernelImage, typename TOutputImage, typename TInternalPrecision>
+void
+FFTConvolutionImageFilter<TInputImage, TKernelImage, TOutputImage, TInternalPrecision>::GenerateTiledData()
+{
+  // Create a process accumulator for tracking the progress of this minipipeline
+  ProgressAccumulator::Pointer progress = ProgressAccumulator::New();
+  progress->SetMiniPipelineFilter(this);
+
+  const InputImageType *  input = this->GetInput();
+  const KernelImageType * kernelImage = this->GetKernelImage();
+  const OutputRegionType  outputRegion = this->GetOutput()->GetRequestedRegion();
+  const InputSizeType     padSize = this->GetTilePadSize(outputRegion.GetSize());
+
+  if (padSize[0] == 0)
+  {
+    typename InputImageType::Pointer localInput = InputImageType::New();
+    localInput->Graft(input);
+
+    using DirectFilterType = ConvolutionImageFilter<InputImageType, KernelImageType, OutputImageType>;
+    typename DirectFilterType::Pointer directFilter = DirectFilterType::New();
+    directFilter->SetInput(localInput);
+    directFilter->SetKernelImage(kernelImage);
+    directFilter->SetNormalize(this->GetNormalize());
+    directFilter->SetBoundaryCondition(this->GetBoundaryCondition());
+    directFilter->SetOutputRegionMode(this->GetOutputRegionMode());
+    directFilter->SetNumberOfWorkUnits(this->GetNumberOfWorkUnits());
+    progress->RegisterInternalFilter(directFilter, 1.0f);
+
+    directFilter->GraftOutput(this->GetOutput());
+    directFilter->GetOutput()->SetRequestedRegion(outputRegion);
+    directFilter->Update();
+    this->GraftOutput(directFilter->GetOutput());
+    return;
+  }
+
+  this->AllocateOutputs();
+  OutputImageType * output = this->GetOutput();
+
+  InternalComplexImagePointerType transformedKernel;
+  this->TransformKernel(kernelImage, padSize, transformedKernel, progress, 0.1f);
+
+  // Each tile, with the input pixels around it, is transformed in an image
+  // of the pad size and index zero. As the kernel is shifted so that its
+  // center, at kernelSize / 2, is at the origin, the pixels of the tile are
+  // the only ones of the inverse transform which do not wrap around.
+  InternalImagePointerType paddedTile = InternalImageType::New();
+  paddedTile->SetRegions(padSize);
+  paddedTile->Allocate();
+
+  typename FFTFilterType::Pointer fftFilter = FFTFilterType::New();
+  fftFilter->SetNumberOfWorkUnits(this->GetNumberOfWorkUnits());
+  fftFilter->SetInput(paddedTile);
+
+  typename IFFTFilterType::Pointer ifftFilter = IFFTFilterType::New();
+  ifftFilter->SetActualXDimensionIsOdd(padSize[0] % 2 != 0);
+  ifftFilter->SetNumberOfWorkUnits(this->GetNumberOfWorkUnits());
+  ifftFilter->SetInput(fftFilter->GetOutput());
+
+  using InputIndexValueType = typename InputIndexType::IndexValueType;
+  const KernelSizeType    kernelSize = kernelImage->GetLargestPossibleRegion().GetSize();
+  const OutputIndexType & outputIndex = outputRegion.GetIndex();
+  const OutputSizeType &  outputSize = outputRegion.GetSize();
+  InputSizeType           tileSize;
+  InputSizeType           lowerRadius;
+  InputSizeType           numberOfTilesAlong;
+  SizeValueType           numberOfTiles = 1;
+  for (unsigned int i = 0; i < ImageDimension; ++i)
+  {
+    tileSize[i] = padSize[i] - kernelSize[i] + 1;
+    lowerRadius[i] = kernelSize[i] - 1 - kernelSize[i] / 2;
+    numberOfTilesAlong[i] = (outputSize[i] + tileSize[i] - 1) / tileSize[i];
+    numberOfTiles *= numberOfTilesAlong[i];
+  }
+
+  const InputRegionType &            largestRegion = input->GetLargestPossibleRegion();
+  const InputRegionType &            bufferedRegion = input->GetBufferedRegion();
+  const BoundaryConditionPointerType boundaryCondition = this->GetBoundaryCondition();
+  for (SizeValueType tile = 0; tile < numberOfTiles; ++tile)
+  {
+    OutputRegionType tileRegion;
+    InputIndexType   paddedTileIndex;
+    InputSizeType    neededSize;
+    SizeValueType    position = tile;
+    for (unsigned int i = 0; i < ImageDimension; ++i)
+    {
+      const SizeValueType start = (position % numberOfTilesAlong[i]) * tileSize[i];
+      position /= numberOfTilesAlong[i];
+      tileRegion.SetIndex(i, outputIndex[i] + static_cast<InputIndexValueType>(start));
+      tileRegion.SetSize(i, std::min(tileSize[i], outputSize[i] - start));
+      paddedTileIndex[i] = tileRegion.GetIndex(i) - static_cast<InputIndexValueType>(lowerRadius[i]);
+      neededSize[i] = tileRegion.GetSize(i) + kernelSize[i] - 1;
+    }
+
+    // Copy the input pixels of the padded tile, and use the boundary
+    // condition for the ones needed outside the input image. The other
+    // pixels only contribute to pixels which are not part of the tile.
+    const InputRegionType neededRegion(paddedTileIndex, neededSize);
+    InputRegionType       copyRegion(paddedTileIndex, padSize);
+    const bool            overlaps = copyRegion.Crop(bufferedRegion);
+    typename InternalImageType::RegionType paddedCopyRegion;
+    if (overlaps)
+    {
+      typename InternalImageType::IndexType paddedCopyIndex;
+      for (unsigned int i = 0; i < ImageDimension; ++i)
+      {
+        paddedCopyIndex[i] = copyRegion.GetIndex(i) - paddedTileIndex[i];
+      }
+      paddedCopyRegion = typename InternalImageType::RegionType(paddedCopyIndex, copyRegion.GetSize());
+      ImageAlgorithm::Copy(input, paddedTile.GetPointer(), copyRegion, paddedCopyRegion);
+    }
+
+    ImageRegionExclusionIteratorWithIndex<InternalImageType> it(paddedTile, paddedTile->GetLargestPossibleRegion());
+    if (overlaps)
+    {
+      it.SetExclusionRegion(paddedCopyRegion);
+    }
+    for (it.GoToBegin(); !it.IsAtEnd(); ++it)
+    {
+      InputIndexType index;
+      for (unsigned int i = 0; i < ImageDimension; ++i)
+      {
+        index[i] = paddedTileIndex[i] + it.GetIndex()[i];
+      }
+      if (neededRegion.IsInside(index) && !largestRegion.IsInside(index))
+      {
+        it.Set(static_cast<TInternalPrecision>(boundaryCondition->GetPixel(index, input)));
+      }
+      else
+      {
+        it.Set(NumericTraits<TInternalPrecision>::ZeroValue());
+      }
+    }
+    paddedTile->Modified();
+
+    // Multiply the transforms of the padded tile and of the kernel in place.
+    fftFilter->Update();
+    InternalComplexType *       transformedTile = fftFilter->GetOutput()->GetBufferPointer();
+    const InternalComplexType * kernelBuffer = transformedKernel->GetBufferPointer();
+    const SizeValueType         numberOfFrequencies = transformedKernel->GetBufferedRegion().GetNumberOfPixels();
+    for (SizeValueType k = 0; k < numberOfFrequencies; ++k)
+    {
+      transformedTile[k] *= kernelBuffer[k];
+    }
+    ifftFilter->Update();
+
+    typename InternalImageType::IndexType convolvedIndex;
+    for (unsigned int i = 0; i < ImageDimension; ++i)
+    {
+      convolvedIndex[i] = static_cast<InputIndexValueType>(lowerRadius[i]);
+    }
+    const typename InternalImageType::RegionType convolvedRegion(convolvedIndex, tileRegion.GetSize());
+    ImageAlgorithm::Copy(ifftFilter->GetOutput(), output, convolvedRegion, tileRegion);
+
+    this->UpdateProgress(0.1f + 0.9f * static_cast<float>(tile + 1) / static_cast<float>(numberOfTiles));
+  }
+}
+
 template <typename TInputImage, typename TKernelImage, typename TOutputImage, typename TInternalPrecision>
 void
 FFTConvolutionImageFilter<TInputImage, TKernelImage, TOutputImage, TInternalPrecision>::PrepareInputs(
@@ -201,11 +390,44 @@ FFTConvolutionImageFilter<TInputImage, TKernelImage, TOutputImage, TInternalPrec
   InternalComplexImagePointerType & preparedKernel,
   ProgressAccumulator *             progress,
   float                             progressWeight)
+{
+  InternalComplexImagePointerType transformedKernel;
+  this->TransformKernel(kernel, this->GetPadSize(), transformedKernel, progress, progressWeight);
+
+  using InfoFilterType = ChangeInformationImageFilter<InternalComplexImageType>;
+  typename InfoFilterType::Pointer kernelInfoFilter = InfoFilterType::New();
+  kernelInfoFilter->ChangeRegionOn();
+
+  using InfoOffsetValueType = typename InfoFilterType::OutputImageOffsetValueType;
+  const InputSizeType &   inputLowerBound = this->GetPadLowerBound();
+  const InputIndexType &  inputIndex = this->GetInput()->GetLargestPossibleRegion().GetIndex();
+  const KernelIndexType & kernelIndex = kernel->GetLargestPossibleRegion().GetIndex();
+  InfoOffsetValueType     kernelOffset[ImageDimension];
+  for (unsigned int i = 0; i < ImageDimension; ++i)
+  {
+    kernelOffset[i] = static_cast<InfoOffsetValueType>(inputIndex[i] - inputLowerBound[i] - kernelIndex[i]);
+  }
+  kernelInfoFilter->SetOutputOffset(kernelOffset);
+  kernelInfoFilter->SetNumberOfWorkUnits(this->GetNumberOfWorkUnits());
+  kernelInfoFilter->SetInput(transformedKernel);
+  progress->RegisterInternalFilter(kernelInfoFilter, 0.001f * progressWeight);
+  kernelInfoFilter->Update();
+
+  preparedKernel = kernelInfoFilter->GetOutput();
+}
+
+template <typename TInputImage, typename TKernelImage, typename TOutputImage, typename TInternalPrecision>
+void
+FFTConvolutionImageFilter<TInputImage, TKernelImage, TOutputImage, TInternalPrecision>::TransformKernel(
+  const KernelImageType *           kernel,
+  const InputSizeType &             padSize,
+  InternalComplexImagePointerType & transformedKernel,
+  ProgressAccumulator *             progress,
+  float                             progressWeight)
 {
   KernelRegionType kernelRegion = kernel->GetLargestPossibleRegion();
   KernelSizeType   kernelSize = kernelRegion.GetSize();
 
-  InputSizeType                      padSize = this->GetPadSize();
   typename KernelImageType::SizeType kernelUpperBound;
   for (unsigned int i = 0; i < ImageDimension; ++i)
   {
@@ -272,26 +494,8 @@ FFTConvolutionImageFilter<TInputImage, TKernelImage, TOutputImage, TInternalPrec
   progress->RegisterInternalFilter(kernelFFTFilter, 0.699f * progressWeight);
   kernelFFTFilter->Update();
 
-  using InfoFilterType = ChangeInformationImageFilter<InternalComplexImageType>;
-  typename InfoFilterType::Pointer kernelInfoFilter = InfoFilterType::New();
-  kernelInfoFilter->ChangeRegionOn();
-
-  using InfoOffsetValueType = typename InfoFilterType::OutputImageOffsetValueType;
-  const InputSizeType &   inputLowerBound = this->GetPadLowerBound();
-  const InputIndexType &  inputIndex = this->GetInput()->GetLargestPossibleRegion().GetIndex();
-  const KernelIndexType & kernelIndex = kernel->GetLargestPossibleRegion().GetIndex();
-  InfoOffsetValueType     kernelOffset[ImageDimension];
-  for (unsigned int i = 0; i < ImageDimension; ++i)
-  {
-    kernelOffset[i] = static_cast<InfoOffsetValueType>(inputIndex[i] - inputLowerBound[i] - kernelIndex[i]);
-  }
-  kernelInfoFilter->SetOutputOffset(kernelOffset);
-  kernelInfoFilter->SetNumberOfWorkUnits(this->GetNumberOfWorkUnits());
-  kernelInfoFilter->SetInput(kernelFFTFilter->GetOutput());
-  progress->RegisterInternalFilter(kernelInfoFilter, 0.001f * progressWeight);
-  kernelInfoFilter->Update();
-
-  preparedKernel = kernelInfoFilter->GetOutput();
+  transformedKernel = kernelFFTFilter->GetOutput();
+  transformedKernel->DisconnectPipeline();
 }
 
 template <typename TInputImage, typename TKernelImage, typename TOutputImage, typename TInternalPrecision>
@@ -399,6 +603,131 @@ FFTConvolutionImageFilter<TInputImage, TKernelImage, TOutputImage, TInternalPrec
   return padSize;
 }
 
+template <typename TInputImage, typename TKernelImage, typename TOutputImage, typename TInternalPrecision>
+typename FFTConvolutionImageFilter<TInputImage, TKernelImage, TOutputImage, TInternalPrecision>::InputSizeType
+FFTConvolutionImageFilter<TInputImage, TKernelImage, TOutputImage, TInternalPrecision>::GetTilePadSize(
+  const OutputSizeType & regionSize) const
+{
+  // The costs are relative to a butterfly of the transforms, for each pixel
+  // of a padded tile, to pad it, multiply its transform and copy it, and for
+  // each multiplication of the direct convolution. They were measured with
+  // the Vnl transforms and the ConvolutionImageFilter. Past about 2^21
+  // pixels, the tiles do not fit in the cache anymore.
+  constexpr double        tilePixelCost = 10.0;
+  constexpr double        directMultiplicationCost = 2.5;
+  constexpr SizeValueType maximumNumberOfTilePixels = SizeValueType{ 1 } << 21;
+
+  const KernelSizeType kernelSize = this->GetKernelImage()->GetLargestPossibleRegion().GetSize();
+
+  // Only the sizes whose prime factors are at most 5 are considered, which
+  // are fast for all the Fourier transform implementations.
+  SizeValueType greatestPrimeFactor = 5;
+  if (m_SizeGreatestPrimeFactor > 1)
+  {
+    greatestPrimeFactor = std::min(greatestPrimeFactor, m_SizeGreatestPrimeFactor);
+  }
+  const auto fastSize = [greatestPrimeFactor](SizeValueType size) {
+    while (Math::GreatestPrimeFactor(size) > greatestPrimeFactor)
+    {
+      ++size;
+    }
+    return size;
+  };
+
+  // The candidate pad sizes go from the smallest one, for tiles of a single
+  // pixel, to the smallest one for a single tile along the dimension.
+  bool                       automatic = false;
+  std::vector<SizeValueType> candidates[ImageDimension];
+  SizeValueType              smallestNumberOfPixels = 1;
+  for (unsigned int i = 0; i < ImageDimension; ++i)
+  {
+    const SizeValueType largestSize = fastSize(regionSize[i] + kernelSize[i] - 1);
+    if (m_TileSize[i] > 0)
+    {
+      candidates[i].push_back(std::min(fastSize(m_TileSize[i] + kernelSize[i] - 1), largestSize));
+    }
+    else
+    {
+      automatic = true;
+      for (SizeValueType size = fastSize(kernelSize[i]); size < largestSize; size = fastSize(size + 1))
+      {
+        candidates[i].push_back(size);
+      }
+      candidates[i].push_back(largestSize);
+    }
+    smallestNumberOfPixels *= candidates[i].front();
+  }
+  const SizeValueType maximumNumberOfPixels = std::max(maximumNumberOfTilePixels, smallestNumberOfPixels);
+
+  // Go through all the combinations of candidate sizes with at most the
+  // maximum number of pixels, to find the one of smallest estimated cost.
+  InputSizeType padSize;
+  double        smallestCost = std::numeric_limits<double>::max();
+  size_t        choice[ImageDimension] = {};
+  while (true)
+  {
+    double        numberOfTiles = 1.0;
+    SizeValueType numberOfPixels = 1;
+    for (unsigned int i = 0; i < ImageDimension; ++i)
+    {
+      const SizeValueType size = candidates[i][choice[i]];
+      const SizeValueType tileSize = size - kernelSize[i] + 1;
+      numberOfTiles *= static_cast<double>((regionSize[i] + tileSize - 1) / tileSize);
+      numberOfPixels *= size;
+    }
+    const double pixels = static_cast<double>(numberOfPixels);
+    const double cost = numberOfTiles * pixels * (std::log2(pixels) + tilePixelCost);
+    if (cost < smallestCost)
+    {
+      smallestCost = cost;
+      for (unsigned int i = 0; i < ImageDimension; ++i)
+      {
+        padSize[i] = candidates[i][choice[i]];
+      }
+    }
+
+    // The candidates are sorted, so when a size gives too many pixels, so do
+    // the following ones, and the next size along the next dimension is
+    // tried, with the smallest ones along the previous dimensions.
+    unsigned int dimension = 0;
+    for (; dimension < ImageDimension; ++dimension)
+    {
+      if (++choice[dimension] < candidates[dimension].size())
+      {
+        numberOfPixels = 1;
+        for (unsigned int i = 0; i < ImageDimension; ++i)
+        {
+          numberOfPixels *= candidates[i][choice[i]];
+        }
+        if (numberOfPixels <= maximumNumberOfPixels)
+        {
+          break;
+        }
+      }
+      choice[dimension] = 0;
+    }
+    if (dimension == ImageDimension)
+    {
+      break;
+    }
+  }
+
+  if (automatic)
+  {
+    double directCost = directMultiplicationCost;
+    for (unsigned int i = 0; i < ImageDimension; ++i)
+    {
+      directCost *= static_cast<double>(regionSize[i]) * static_cast<double>(kernelSize[i]);
+    }
+    if (directCost < smallestCost)
+    {
+      padSize.Fill(0);
+    }
+  }
+
+  return padSize;
+}
+
 template <typename TInputImage, typename TKernelImage, typename TOutputImage, typename TInternalPrecision>
 bool
 FFTConvolutionImageFilter<TInputImage, TKernelImage, TOutputImage, TInternalPrecision>::GetXDimensionIsOdd() const
@@ -414,6 +743,8 @@ FFTConvolutionImageFilter<TInputImage, TKernelImage, TOutputImage, TInternalPrec
 {
   Superclass::PrintSelf(os, indent);
   os << indent << "SizeGreatestPrimeFactor: " << m_SizeGreatestPrimeFactor << std::endl;
+  os << indent << "Tiling: " << m_Tiling << std::endl;
+  os << indent << "TileSize: " << m_TileSize << std::endl;
 }
 
 } // namespace itk
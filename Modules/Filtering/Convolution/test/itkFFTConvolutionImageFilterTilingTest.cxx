@@ -0,0 +1,190 @@
+/*=========================================================================
+ *
+ *  Copyright NumFOCUS
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include "itkConstantBoundaryCondition.h"
+#include "itkFFTConvolutionImageFilter.h"
+#include "itkImageRegionConstIterator.h"
+#include "itkImageRegionIteratorWithIndex.h"
+#include "itkStreamingImageFilter.h"
+#include "itkTestingMacros.h"
+
+namespace
+{
+constexpr unsigned int Dimension = 3;
+using ImageType = itk::Image<float, Dimension>;
+using ConvolutionFilterType = itk::FFTConvolutionImageFilter<ImageType>;
+
+ImageType::Pointer
+CreateImage(const ImageType::IndexType & index, const ImageType::SizeType & size)
+{
+  ImageType::Pointer image = ImageType::New();
+  image->SetRegions(ImageType::RegionType(index, size));
+  image->Allocate();
+
+  unsigned int                                 state = 4321;
+  itk::ImageRegionIteratorWithIndex<ImageType> it(image, image->GetLargestPossibleRegion());
+  for (it.GoToBegin(); !it.IsAtEnd(); ++it)
+  {
+    state = state * 1103515245u + 12345u;
+    const ImageType::IndexType & pixelIndex = it.GetIndex();
+    it.Set(static_cast<float>((state >> 16) % 100) + 10.0f * static_cast<float>(pixelIndex[0] - pixelIndex[2]));
+  }
+  return image;
+}
+
+// Compares the output of the tiled convolution, computed for the requested
+// region given to the streaming filter, with the output of the convolution
+// of the whole padded image
+bool
+CheckTiling(const ImageType *       image,
+            const ImageType *       kernel,
+            ConvolutionFilterType * tiledFilter,
+            unsigned int            numberOfStreamDivisions,
+            const std::string &     description)
+{
+  ConvolutionFilterType::Pointer referenceFilter = ConvolutionFilterType::New();
+  referenceFilter->SetInput(image);
+  referenceFilter->SetKernelImage(kernel);
+  referenceFilter->SetNormalize(tiledFilter->GetNormalize());
+  referenceFilter->SetBoundaryCondition(tiledFilter->GetBoundaryCondition());
+  referenceFilter->SetOutputRegionMode(tiledFilter->GetOutputRegionMode());
+  referenceFilter->Update();
+
+  tiledFilter->SetInput(image);
+  tiledFilter->SetKernelImage(kernel);
+  tiledFilter->TilingOn();
+
+  using StreamingFilterType = itk::StreamingImageFilter<ImageType, ImageType>;
+  StreamingFilterType::Pointer streamer = StreamingFilterType::New();
+  streamer->SetInput(tiledFilter->GetOutput());
+  streamer->SetNumberOfStreamDivisions(numberOfStreamDivisions);
+  streamer->Update();
+
+  const ImageType * reference = referenceFilter->GetOutput();
+  const ImageType * output = streamer->GetOutput();
+  if (output->GetLargestPossibleRegion() != reference->GetLargestPossibleRegion())
+  {
+    std::cerr << "Test failed for " << description << ": the output region is "
+              << output->GetLargestPossibleRegion() << " instead of " << reference->GetLargestPossibleRegion()
+              << std::endl;
+    return false;
+  }
+
+  double                                   largestMagnitude = 0.0;
+  double                                   largestDifference = 0.0;
+  itk::ImageRegionConstIterator<ImageType> referenceIt(reference, reference->GetLargestPossibleRegion());
+  itk::ImageRegionConstIterator<ImageType> outputIt(output, reference->GetLargestPossibleRegion());
+  for (; !referenceIt.IsAtEnd(); ++referenceIt, ++outputIt)
+  {
+    largestMagnitude = std::max(largestMagnitude, std::abs(static_cast<double>(referenceIt.Get())));
+    const double difference = static_cast<double>(outputIt.Get()) - static_cast<double>(referenceIt.Get());
+    largestDifference = std::max(largestDifference, std::abs(difference));
+  }
+  if (largestDifference > 1e-5 * largestMagnitude)
+  {
+    std::cerr << "Test failed for " << description << ": largest difference " << largestDifference
+              << " for a largest magnitude " << largestMagnitude << std::endl;
+    return false;
+  }
+
+  // When streaming, only the input pixels needed for the last piece are
+  // requested.
+  if (numberOfStreamDivisions > 1 && image->GetRequestedRegion() == image->GetLargestPossibleRegion())
+  {
+    std::cerr << "Test failed for " << description << ": the whole input image was requested" << std::endl;
+    return false;
+  }
+  return true;
+}
+} // namespace
+
+// Checks that the convolution computed by overlap-save on tiles, when
+// streaming or not, is the convolution computed on the whole image.
+int
+itkFFTConvolutionImageFilterTilingTest(int, char *[])
+{
+  ConvolutionFilterType::Pointer filter = ConvolutionFilterType::New();
+
+  ITK_EXERCISE_BASIC_OBJECT_METHODS(filter, FFTConvolutionImageFilter, ConvolutionImageFilterBase);
+
+  ITK_TEST_SET_GET_BOOLEAN(filter, Tiling, true);
+
+  ConvolutionFilterType::OutputSizeType tileSize;
+  tileSize.Fill(0);
+  ITK_TEST_EXPECT_EQUAL(filter->GetTileSize(), tileSize);
+  tileSize[0] = 8;
+  tileSize[1] = 6;
+  tileSize[2] = 5;
+  filter->SetTileSize(tileSize);
+  ITK_TEST_SET_GET_VALUE(tileSize, filter->GetTileSize());
+
+  const ImageType::IndexType imageIndex = { { 3, -2, 5 } };
+  const ImageType::SizeType  imageSize = { { 37, 29, 23 } };
+  ImageType::Pointer         image = CreateImage(imageIndex, imageSize);
+
+  const ImageType::IndexType kernelIndex = { { 0, 0, 0 } };
+  const ImageType::SizeType  kernelSize = { { 5, 4, 3 } };
+  ImageType::Pointer         kernel = CreateImage(kernelIndex, kernelSize);
+
+  bool passed = true;
+
+  filter = ConvolutionFilterType::New();
+  filter->SetTileSize(tileSize);
+  passed &= CheckTiling(image, kernel, filter, 1, "tiles");
+
+  filter = ConvolutionFilterType::New();
+  filter->SetTileSize(tileSize);
+  passed &= CheckTiling(image, kernel, filter, 5, "streamed tiles");
+
+  filter = ConvolutionFilterType::New();
+  filter->SetTileSize(tileSize);
+  filter->NormalizeOn();
+  filter->SetOutputRegionModeToValid();
+  passed &= CheckTiling(image, kernel, filter, 3, "streamed tiles of the valid region");
+
+  itk::ConstantBoundaryCondition<ImageType> boundaryCondition;
+  boundaryCondition.SetConstant(-20.0f);
+  filter = ConvolutionFilterType::New();
+  filter->SetTileSize(tileSize);
+  filter->SetBoundaryCondition(&boundaryCondition);
+  passed &= CheckTiling(image, kernel, filter, 4, "streamed tiles with a constant boundary condition");
+
+  // Tiles larger than the image, along some dimensions
+  tileSize[0] = 100;
+  filter = ConvolutionFilterType::New();
+  filter->SetTileSize(tileSize);
+  passed &= CheckTiling(image, kernel, filter, 2, "tiles larger than the image");
+
+  // The tile size chosen automatically, for a kernel small enough for the
+  // direct convolution to be used, and for larger kernels
+  const ImageType::SizeType smallKernelSize = { { 3, 3, 1 } };
+  ImageType::Pointer        smallKernel = CreateImage(kernelIndex, smallKernelSize);
+  filter = ConvolutionFilterType::New();
+  passed &= CheckTiling(image, smallKernel, filter, 2, "automatic direct convolution");
+
+  filter = ConvolutionFilterType::New();
+  passed &= CheckTiling(image, kernel, filter, 1, "automatic tiles");
+
+  const ImageType::SizeType largeKernelSize = { { 15, 15, 15 } };
+  ImageType::Pointer        largeKernel = CreateImage(kernelIndex, largeKernelSize);
+  filter = ConvolutionFilterType::New();
+  passed &= CheckTiling(image, largeKernel, filter, 3, "automatic tiles with a large kernel");
+
+  std::cout << "Test finished." << std::endl;
+  return passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -178,6 +178,20 @@ protected:
   void
   InitializeIteration() override;
 
+  /** The time step is a parameter of the filter, and the difference
+   * function does not depend on the output, so several iterations of the
+   * update can be fused. */
+  bool
+  TimeStepIsFixed() const override
+  {
+    return true;
+  }
+  bool
+  DifferenceFunctionIsFixed() const override
+  {
+    return true;
+  }
+
   /** To support streaming, this filter produces a output which is
    * larger than the original requested region. The output is padding
    * by m_NumberOfIterations pixels on edge. */
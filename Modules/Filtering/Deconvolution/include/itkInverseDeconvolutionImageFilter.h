@@ -109,6 +109,16 @@ protected:
   InverseDeconvolutionImageFilter();
   ~InverseDeconvolutionImageFilter() override = default;
 
+  /** This filter needs the entire input image and image kernel, even when
+   * tiling is requested, as the deconvolution is not computed on tiles. As
+   * such, this filter needs to provide an implementation for
+   * GenerateInputRequestedRegion() in order to inform the pipeline
+   * execution model.
+   *
+   * \sa ProcessObject::GenerateInputRequestedRegion()  */
+  void
+  GenerateInputRequestedRegion() override;
+
   /** This filter uses a minipipeline to compute the output. */
   void
   GenerateData() override;
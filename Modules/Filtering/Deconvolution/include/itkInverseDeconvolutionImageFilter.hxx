@@ -32,6 +32,27 @@ InverseDeconvolutionImageFilter<TInputImage, TKernelImage, TOutputImage, TIntern
   m_KernelZeroMagnitudeThreshold = 1.0e-4;
 }
 
+template <typename TInputImage, typename TKernelImage, typename TOutputImage, typename TInternalPrecision>
+void
+InverseDeconvolutionImageFilter<TInputImage, TKernelImage, TOutputImage, TInternalPrecision>::
+  GenerateInputRequestedRegion()
+{
+  // Request the largest possible region for both input images.
+  if (this->GetInput())
+  {
+    typename InputImageType::Pointer imagePtr = const_cast<InputImageType *>(this->GetInput());
+    imagePtr->SetRequestedRegionToLargestPossibleRegion();
+  }
+
+  if (this->GetKernelImage())
+  {
+    // Input kernel is an image, cast away the constness so we can set
+    // the requested region.
+    typename KernelImageType::Pointer kernelPtr = const_cast<KernelImageType *>(this->GetKernelImage());
+    kernelPtr->SetRequestedRegionToLargestPossibleRegion();
+  }
+}
+
 template <typename TInputImage, typename TKernelImage, typename TOutputImage, typename TInternalPrecision>
 void
 InverseDeconvolutionImageFilter<TInputImage, TKernelImage, TOutputImage, TInternalPrecision>::GenerateData()
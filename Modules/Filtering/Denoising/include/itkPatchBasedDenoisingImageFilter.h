@@ -208,6 +208,32 @@ public:
   itkSetObjectMacro(Sampler, BaseSamplerType);
   itkGetModifiableObjectMacro(Sampler, BaseSamplerType);
 
+  /** Set/Get flag indicating whether the patch around each pixel should be compared with all the
+   *  patches in a search window around it, instead of with the patches selected by the Sampler.
+   *
+   *  When this flag is true, the intensity updates are computed deterministically, in the manner of
+   *  the non-local means algorithm, by blocks of the image processed in parallel. For each
+   *  displacement in the search window, the patch distances are computed from the image of the
+   *  squared differences between the pixels and their displaced pixels.  When the patch weights are
+   *  all unity (see UseSmoothDiscPatchWeights), they are computed by running sums along each
+   *  dimension, in a time independent of the size of the patch.
+   *  The kernel bandwidth estimation still uses the Sampler.
+   *  Defaults to false.
+   */
+  itkSetMacro(UseSearchWindow, bool);
+  itkBooleanMacro(UseSearchWindow);
+  itkGetConstMacro(UseSearchWindow, bool);
+
+  /** Set/Get the radius of the search window, in the same units as the patch radius.
+   *  This is used only when UseSearchWindow is True/On.
+   *  Defaults to 5.
+   */
+  itkSetMacro(SearchRadius, unsigned int);
+  itkGetConstMacro(SearchRadius, unsigned int);
+
+  PatchRadiusType
+  GetSearchRadiusInVoxels() const;
+
   /** Get the number of independent components of the input. */
   itkGetConstMacro(NumIndependentComponents, unsigned int);
 
@@ -428,6 +454,14 @@ protected:
                               BaseSamplerPointer &                sampler,
                               ThreadDataStruct &                  threadData);
 
+  /** Compute the gradient of the joint entropy for all the pixels, from all the patches in the
+   *  search windows, when UseSearchWindow is True/On. */
+  virtual void
+  ComputeSearchWindowGradientJointEntropy();
+
+  virtual void
+  ThreadedComputeSearchWindowGradientJointEntropy(const InputImageRegionType & regionToProcess);
+
   void
   ApplyUpdate() override;
 
@@ -566,6 +600,13 @@ private:
 
   BaseSamplerPointer                m_Sampler;
   typename ListAdaptorType::Pointer m_SearchSpaceList;
+
+  bool         m_UseSearchWindow{ false };
+  unsigned int m_SearchRadius{ 5 };
+
+  /** The components of the gradient of the joint entropy of each pixel of the output buffer,
+   *  computed from the search windows. */
+  std::vector<RealValueType> m_SearchWindowGradient;
 };
 } // end namespace itk
 
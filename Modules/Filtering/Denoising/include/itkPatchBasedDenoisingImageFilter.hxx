@@ -29,8 +29,11 @@
 #include "itkImageAlgorithm.h"
 #include "itkVectorImageToImageAdaptor.h"
 #include "itkSpatialNeighborSubsampler.h"
+#include "itkIndexRange.h"
 #include "itkMacro.h"
 #include "itkMath.h"
+#include <algorithm>
+#include <cmath>
 
 namespace itk
 {
@@ -117,6 +120,27 @@ PatchBasedDenoisingImageFilter<TInputImage, TOutputImage>::SetKernelBandwidthSig
   m_KernelBandwidthSigmaIsSet = true;
 }
 
+template <typename TInputImage, typename TOutputImage>
+typename PatchBasedDenoisingImageFilter<TInputImage, TOutputImage>::PatchRadiusType
+PatchBasedDenoisingImageFilter<TInputImage, TOutputImage>::GetSearchRadiusInVoxels() const
+{
+  const InputImageType * inputImage = this->GetInput();
+  if (inputImage == nullptr)
+  {
+    itkExceptionMacro(<< "Input image is nullptr.");
+  }
+
+  // The search radius is isotropic in physical space, as the patch radius.
+  const typename InputImageType::SpacingType &    spacing = inputImage->GetSpacing();
+  const typename InputImageType::SpacingValueType maxSpacing = *std::max_element(spacing.Begin(), spacing.End());
+  PatchRadiusType                                 radius;
+  for (unsigned int dim = 0; dim < ImageDimension; ++dim)
+  {
+    radius[dim] = itk::Math::ceil(maxSpacing * m_SearchRadius / spacing[dim]);
+  }
+  return radius;
+}
+
 template <typename TInputImage, typename TOutputImage>
 void
 PatchBasedDenoisingImageFilter<TInputImage, TOutputImage>::CopyInputToOutput()
@@ -1904,6 +1928,13 @@ PatchBasedDenoisingImageFilter<TInputImage, TOutputImage>::ComputeImageUpdate()
 
   str.Filter = this;
 
+  // With a search window, the gradients of the joint entropy are computed
+  // for all the pixels before the updates.
+  if (m_UseSearchWindow && this->GetSmoothingWeight() > 0)
+  {
+    this->ComputeSearchWindowGradientJointEntropy();
+  }
+
   // Compute smoothing updated for intensites at each pixel
   // based on gradient of the joint entropy
   this->GetMultiThreader()->SetNumberOfWorkUnits(this->GetNumberOfWorkUnits());
@@ -2018,8 +2049,20 @@ PatchBasedDenoisingImageFilter<TInputImage, TOutputImage>::ThreadedComputeImageU
       if (smoothingWeight > 0)
       {
         // Get intensity update driven by patch-based denoiser
-        const RealType gradientJointEntropy =
-          this->ComputeGradientJointEntropy(sampleIt.GetInstanceIdentifier(), inList, sampler, threadData);
+        RealType gradientJointEntropy = m_ZeroPixel;
+        if (m_UseSearchWindow)
+        {
+          const OffsetValueType offset = output->ComputeOffset(outputIt.GetIndex());
+          for (unsigned int pc = 0; pc < m_NumPixelComponents; ++pc)
+          {
+            this->SetComponent(gradientJointEntropy, pc, m_SearchWindowGradient[offset * m_NumPixelComponents + pc]);
+          }
+        }
+        else
+        {
+          gradientJointEntropy =
+            this->ComputeGradientJointEntropy(sampleIt.GetInstanceIdentifier(), inList, sampler, threadData);
+        }
 
         constexpr RealValueType stepSizeSmoothing = 0.2;
         result = AddUpdate(result, gradientJointEntropy * (smoothingWeight * stepSizeSmoothing));
@@ -2367,10 +2410,383 @@ PatchBasedDenoisingImageFilter<TInputImage, TOutputImage>::ComputeGradientJointE
   return gradientJointEntropy;
 }
 
+template <typename TInputImage, typename TOutputImage>
+void
+PatchBasedDenoisingImageFilter<TInputImage, TOutputImage>::ComputeSearchWindowGradientJointEntropy()
+{
+  const InputImageRegionType region = this->m_OutputImage->GetBufferedRegion();
+
+  m_SearchWindowGradient.resize(region.GetNumberOfPixels() * m_NumPixelComponents);
+
+  // The image is processed by blocks of about 32768 pixels, small enough for
+  // the buffers of a block to stay in the cache while all the displacements
+  // of the search window are visited. The blocks are the units of work of the
+  // multithreader, and each pixel is computed by a single block, so that the
+  // result does not depend on the number of work units.
+  const auto blockLength =
+    std::max(Math::Round<SizeValueType>(std::pow(32768.0, 1.0 / ImageDimension)), SizeValueType{ 1 });
+  typename InputImageRegionType::SizeType numberOfBlocks;
+  SizeValueType                           totalNumberOfBlocks = 1;
+  for (unsigned int dim = 0; dim < ImageDimension; ++dim)
+  {
+    numberOfBlocks[dim] = (region.GetSize(dim) + blockLength - 1) / blockLength;
+    totalNumberOfBlocks *= numberOfBlocks[dim];
+  }
+
+  this->GetMultiThreader()->SetNumberOfWorkUnits(this->GetNumberOfWorkUnits());
+  this->GetMultiThreader()->ParallelizeArray(
+    0,
+    totalNumberOfBlocks,
+    [&](SizeValueType block) {
+      InputImageRegionType blockRegion;
+      for (unsigned int dim = 0; dim < ImageDimension; ++dim)
+      {
+        const SizeValueType start = (block % numberOfBlocks[dim]) * blockLength;
+        block /= numberOfBlocks[dim];
+        blockRegion.SetIndex(dim, region.GetIndex(dim) + static_cast<IndexValueType>(start));
+        blockRegion.SetSize(dim, std::min(blockLength, region.GetSize(dim) - start));
+      }
+      this->ThreadedComputeSearchWindowGradientJointEntropy(blockRegion);
+    },
+    nullptr);
+}
+
+template <typename TInputImage, typename TOutputImage>
+void
+PatchBasedDenoisingImageFilter<TInputImage, TOutputImage>::ThreadedComputeSearchWindowGradientJointEntropy(
+  const InputImageRegionType & regionToProcess)
+{
+  // For each displacement in the search window
+  //   compute the squared differences between the pixels and the displaced
+  // pixels, over the region padded by the patch radius
+  //   sum the squared differences over the patches, which gives the distances
+  // between the patches and the displaced patches
+  //   accumulate the Gaussian weights and the weighted differences of the
+  // pixels of the region
+  //
+  using IndexType = typename OutputImageType::IndexType;
+  using OffsetType = typename OutputImageType::OffsetType;
+
+  const OutputImageType *    output = this->m_OutputImage;
+  const InputImageRegionType region = output->GetBufferedRegion();
+  const PixelType *          buffer = output->GetBufferPointer();
+  const OffsetValueType *    offsetTable = output->GetOffsetTable();
+  const PatchRadiusType      radius = this->GetPatchRadiusInVoxels();
+  const PatchRadiusType      searchRadius = this->GetSearchRadiusInVoxels();
+  const unsigned int         numberOfComponents = m_NumPixelComponents;
+  const bool                 isEuclidean = (this->GetComponentSpace() == Superclass::ComponentSpaceEnum::EUCLIDEAN);
+
+  // The squared differences are zero outside of the image, so that the
+  // pixels of the patches outside of the image are ignored.
+  InputImageRegionType paddedRegion = regionToProcess;
+  paddedRegion.PadByRadius(radius);
+
+  OffsetValueType paddedStrides[ImageDimension];
+  OffsetValueType blockStrides[ImageDimension];
+  paddedStrides[0] = 1;
+  blockStrides[0] = 1;
+  for (unsigned int dim = 1; dim < ImageDimension; ++dim)
+  {
+    paddedStrides[dim] = paddedStrides[dim - 1] * static_cast<OffsetValueType>(paddedRegion.GetSize(dim - 1));
+    blockStrides[dim] = blockStrides[dim - 1] * static_cast<OffsetValueType>(regionToProcess.GetSize(dim - 1));
+  }
+  const auto computeOffset = [](const IndexType & index, const IndexType & origin, const OffsetValueType * strides) {
+    OffsetValueType offset = 0;
+    for (unsigned int dim = 0; dim < ImageDimension; ++dim)
+    {
+      offset += (index[dim] - origin[dim]) * strides[dim];
+    }
+    return offset;
+  };
+
+  RealArrayType invSquaredSigma(m_NumIndependentComponents);
+  for (unsigned int ic = 0; ic < m_NumIndependentComponents; ++ic)
+  {
+    invSquaredSigma[ic] = 1.0 / itk::Math::sqr(m_KernelBandwidthSigma[ic]);
+  }
+
+  // The patch distances are weighted by the squared patch weights. When they
+  // are all unity, the sums over the patches are computed by running sums.
+  const PatchWeightsType       patchWeights = this->GetPatchWeights();
+  bool                         uniformPatchWeights = true;
+  std::vector<OffsetValueType> patchOffsets;
+  std::vector<RealValueType>   squaredPatchWeights;
+  unsigned int                 pos = 0;
+  for (const IndexType & index : ZeroBasedIndexRange<ImageDimension>(this->GetPatchDiameterInVoxels()))
+  {
+    const RealValueType weight = patchWeights[pos++];
+    uniformPatchWeights = uniformPatchWeights && Math::ExactlyEquals(weight, 1.0);
+    if (weight > 0.0)
+    {
+      OffsetValueType offset = 0;
+      for (unsigned int dim = 0; dim < ImageDimension; ++dim)
+      {
+        offset += (index[dim] - static_cast<IndexValueType>(radius[dim])) * paddedStrides[dim];
+      }
+      patchOffsets.push_back(offset);
+      squaredPatchWeights.push_back(weight * weight);
+    }
+  }
+
+  std::vector<RealValueType> squaredDifferences(paddedRegion.GetNumberOfPixels());
+  std::vector<RealValueType> partialSums(paddedRegion.GetNumberOfPixels());
+  std::vector<RealValueType> rowSums(paddedRegion.GetSize(0));
+  std::vector<RealValueType> line(paddedRegion.GetSize(0));
+
+  // The patch of the pixel itself is at a distance of zero.
+  std::vector<RealValueType> sumOfGaussians(regionToProcess.GetNumberOfPixels(), 1.0);
+  std::vector<RealValueType> gradient(regionToProcess.GetNumberOfPixels() * numberOfComponents, 0.0);
+
+  // In Riemannian space, the eigen analysis of each pixel of the padded
+  // region is cached for all the displacements.
+  EigenValuesCacheType  eigenValsCache;
+  EigenVectorsCacheType eigenVecsCache;
+  std::vector<bool>     isCached;
+  if (!isEuclidean)
+  {
+    eigenValsCache.resize(paddedRegion.GetNumberOfPixels());
+    eigenVecsCache.resize(paddedRegion.GetNumberOfPixels());
+    isCached.assign(paddedRegion.GetNumberOfPixels(), false);
+  }
+  RealArrayType unitWeights(m_NumIndependentComponents);
+  unitWeights.Fill(1.0);
+  RealArrayType   squaredNorm(m_NumIndependentComponents);
+  RealType        difference = m_ZeroPixel;
+  OffsetValueType displacementOffset = 0;
+  const auto      computeRiemannianDifference = [&](OffsetValueType imageOffset, OffsetValueType paddedOffset) {
+    this->ComputeDifferenceAndWeightedSquaredNorm(buffer[imageOffset],
+                                                  buffer[imageOffset + displacementOffset],
+                                                  unitWeights,
+                                                  isCached[paddedOffset],
+                                                  paddedOffset,
+                                                  eigenValsCache,
+                                                  eigenVecsCache,
+                                                  difference,
+                                                  squaredNorm);
+    isCached[paddedOffset] = true;
+    return squaredNorm[0] * invSquaredSigma[0];
+  };
+
+  InputImageRegionType searchRegion;
+  for (unsigned int dim = 0; dim < ImageDimension; ++dim)
+  {
+    searchRegion.SetIndex(dim, -static_cast<IndexValueType>(searchRadius[dim]));
+    searchRegion.SetSize(dim, 2 * searchRadius[dim] + 1);
+  }
+
+  for (const IndexType & searchIndex : ImageRegionIndexRange<ImageDimension>(searchRegion))
+  {
+    OffsetType displacement;
+    bool       isZeroDisplacement = true;
+    displacementOffset = 0;
+    for (unsigned int dim = 0; dim < ImageDimension; ++dim)
+    {
+      displacement[dim] = searchIndex[dim];
+      isZeroDisplacement = isZeroDisplacement && displacement[dim] == 0;
+      displacementOffset += displacement[dim] * offsetTable[dim];
+    }
+    if (isZeroDisplacement)
+    {
+      continue;
+    }
+
+    // The pixels of the region whose displaced pixel is in the image, and the
+    // pixels of the padded region whose squared difference is defined
+    InputImageRegionType displacedRegion = region;
+    displacedRegion.SetIndex(region.GetIndex() - displacement);
+    InputImageRegionType validRegion = regionToProcess;
+    if (!validRegion.Crop(displacedRegion))
+    {
+      continue;
+    }
+    InputImageRegionType differenceRegion = paddedRegion;
+    differenceRegion.Crop(region);
+    differenceRegion.Crop(displacedRegion);
+
+    std::fill(squaredDifferences.begin(), squaredDifferences.end(), 0.0);
+    InputImageRegionType lineRegion = differenceRegion;
+    lineRegion.SetSize(0, 1);
+    SizeValueType lineLength = differenceRegion.GetSize(0);
+    for (const IndexType & lineIndex : ImageRegionIndexRange<ImageDimension>(lineRegion))
+    {
+      const OffsetValueType imageOffset = computeOffset(lineIndex, region.GetIndex(), offsetTable);
+      const OffsetValueType paddedOffset = computeOffset(lineIndex, paddedRegion.GetIndex(), paddedStrides);
+      RealValueType *       differences = squaredDifferences.data() + paddedOffset;
+      if (isEuclidean)
+      {
+        const PixelType * pixels = buffer + imageOffset;
+        const PixelType * displacedPixels = pixels + displacementOffset;
+        for (SizeValueType i = 0; i < lineLength; ++i)
+        {
+          RealValueType squaredDistance = 0.0;
+          for (unsigned int pc = 0; pc < numberOfComponents; ++pc)
+          {
+            const RealValueType diff = static_cast<RealValueType>(this->GetComponent(displacedPixels[i], pc)) -
+                                       static_cast<RealValueType>(this->GetComponent(pixels[i], pc));
+            squaredDistance += diff * diff * invSquaredSigma[pc];
+          }
+          differences[i] = squaredDistance;
+        }
+      }
+      else
+      {
+        for (SizeValueType i = 0; i < lineLength; ++i)
+        {
+          differences[i] = computeRiemannianDifference(imageOffset + i, paddedOffset + i);
+        }
+      }
+    }
+
+    const RealValueType * patchDistances = squaredDifferences.data();
+    if (uniformPatchWeights)
+    {
+      // Sum the squared differences over the patches one dimension after the
+      // other, by running sums from one buffer to the other. Along the
+      // dimensions already summed, only the sums of the valid region are
+      // needed. Along the other dimensions than the first one, the running
+      // sums of the rows of the first dimension are computed together.
+      RealValueType *      source = squaredDifferences.data();
+      RealValueType *      destination = partialSums.data();
+      InputImageRegionType sumRegion = paddedRegion;
+      for (unsigned int dim = 0; dim < ImageDimension; ++dim)
+      {
+        const auto            halfWidth = static_cast<SizeValueType>(radius[dim]);
+        const SizeValueType   length = paddedRegion.GetSize(dim);
+        const OffsetValueType stride = paddedStrides[dim];
+        const SizeValueType   rowLength = (dim == 0) ? 1 : sumRegion.GetSize(0);
+        lineRegion = sumRegion;
+        lineRegion.SetSize(dim, 1);
+        lineRegion.SetSize(0, 1);
+        for (const IndexType & lineIndex : ImageRegionIndexRange<ImageDimension>(lineRegion))
+        {
+          const OffsetValueType offset = computeOffset(lineIndex, paddedRegion.GetIndex(), paddedStrides);
+          const RealValueType * values = source + offset;
+          RealValueType *       sums = destination + offset;
+          if (dim == 0)
+          {
+            RealValueType sum = 0.0;
+            for (SizeValueType i = 0; i < 2 * halfWidth; ++i)
+            {
+              sum += values[i];
+            }
+            for (SizeValueType i = halfWidth; i + halfWidth < length; ++i)
+            {
+              sum += values[i + halfWidth];
+              sums[i] = sum;
+              sum -= values[i - halfWidth];
+            }
+          }
+          else
+          {
+            std::fill(rowSums.begin(), rowSums.begin() + rowLength, 0.0);
+            for (SizeValueType i = 0; i < 2 * halfWidth; ++i)
+            {
+              for (SizeValueType j = 0; j < rowLength; ++j)
+              {
+                rowSums[j] += values[i * stride + j];
+              }
+            }
+            for (SizeValueType i = halfWidth; i + halfWidth < length; ++i)
+            {
+              for (SizeValueType j = 0; j < rowLength; ++j)
+              {
+                rowSums[j] += values[(i + halfWidth) * stride + j];
+                sums[i * stride + j] = rowSums[j];
+                rowSums[j] -= values[(i - halfWidth) * stride + j];
+              }
+            }
+          }
+        }
+        sumRegion.SetIndex(dim, validRegion.GetIndex(dim));
+        sumRegion.SetSize(dim, validRegion.GetSize(dim));
+        patchDistances = destination;
+        std::swap(source, destination);
+      }
+    }
+
+    lineRegion = validRegion;
+    lineRegion.SetSize(0, 1);
+    lineLength = validRegion.GetSize(0);
+    RealValueType * gaussians = line.data();
+    for (const IndexType & lineIndex : ImageRegionIndexRange<ImageDimension>(lineRegion))
+    {
+      const OffsetValueType imageOffset = computeOffset(lineIndex, region.GetIndex(), offsetTable);
+      const OffsetValueType paddedOffset = computeOffset(lineIndex, paddedRegion.GetIndex(), paddedStrides);
+      const OffsetValueType blockOffset = computeOffset(lineIndex, regionToProcess.GetIndex(), blockStrides);
+      if (uniformPatchWeights)
+      {
+        for (SizeValueType i = 0; i < lineLength; ++i)
+        {
+          gaussians[i] = patchDistances[paddedOffset + i];
+        }
+      }
+      else
+      {
+        std::fill(gaussians, gaussians + lineLength, 0.0);
+        for (size_t k = 0; k < patchOffsets.size(); ++k)
+        {
+          const RealValueType * differences = patchDistances + paddedOffset + patchOffsets[k];
+          for (SizeValueType i = 0; i < lineLength; ++i)
+          {
+            gaussians[i] += squaredPatchWeights[k] * differences[i];
+          }
+        }
+      }
+      for (SizeValueType i = 0; i < lineLength; ++i)
+      {
+        gaussians[i] = std::exp(-gaussians[i] / 2.0);
+        sumOfGaussians[blockOffset + i] += gaussians[i];
+      }
+
+      RealValueType * pixelGradient = gradient.data() + blockOffset * numberOfComponents;
+      if (isEuclidean)
+      {
+        const PixelType * pixels = buffer + imageOffset;
+        const PixelType * displacedPixels = pixels + displacementOffset;
+        for (SizeValueType i = 0; i < lineLength; ++i)
+        {
+          for (unsigned int pc = 0; pc < numberOfComponents; ++pc)
+          {
+            pixelGradient[i * numberOfComponents + pc] +=
+              gaussians[i] * (static_cast<RealValueType>(this->GetComponent(displacedPixels[i], pc)) -
+                              static_cast<RealValueType>(this->GetComponent(pixels[i], pc)));
+          }
+        }
+      }
+      else
+      {
+        for (SizeValueType i = 0; i < lineLength; ++i)
+        {
+          computeRiemannianDifference(imageOffset + i, paddedOffset + i);
+          for (unsigned int pc = 0; pc < numberOfComponents; ++pc)
+          {
+            pixelGradient[i * numberOfComponents + pc] += gaussians[i] * this->GetComponent(difference, pc);
+          }
+        }
+      }
+    }
+  } // end for each displacement
+
+  SizeValueType blockOffset = 0;
+  for (const IndexType & index : ImageRegionIndexRange<ImageDimension>(regionToProcess))
+  {
+    const OffsetValueType imageOffset = computeOffset(index, region.GetIndex(), offsetTable);
+    for (unsigned int pc = 0; pc < numberOfComponents; ++pc)
+    {
+      m_SearchWindowGradient[imageOffset * numberOfComponents + pc] =
+        gradient[blockOffset * numberOfComponents + pc] / (sumOfGaussians[blockOffset] + m_MinProbability);
+    }
+    ++blockOffset;
+  }
+}
+
 template <typename TInputImage, typename TOutputImage>
 void
 PatchBasedDenoisingImageFilter<TInputImage, TOutputImage>::PostProcessOutput()
-{}
+{
+  // Release the gradients computed from the search windows.
+  std::vector<RealValueType>().swap(m_SearchWindowGradient);
+}
 
 template <typename TInputImage, typename TOutputImage>
 void
@@ -2459,6 +2875,16 @@ PatchBasedDenoisingImageFilter<TInputImage, TOutputImage>::PrintSelf(std::ostrea
 
   itkPrintSelfObjectMacro(Sampler);
   itkPrintSelfObjectMacro(UpdateBuffer);
+
+  if (m_UseSearchWindow)
+  {
+    os << indent << "UseSearchWindow: On" << std::endl;
+  }
+  else
+  {
+    os << indent << "UseSearchWindow: Off" << std::endl;
+  }
+  os << indent << "SearchRadius: " << m_SearchRadius << std::endl;
 }
 
 } // end namespace itk
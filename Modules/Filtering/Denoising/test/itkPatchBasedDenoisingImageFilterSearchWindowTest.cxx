@@ -0,0 +1,203 @@
+/*=========================================================================
+ *
+ *  Copyright NumFOCUS
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include "itkImage.h"
+#include "itkImageRegionConstIterator.h"
+#include "itkImageRegionIteratorWithIndex.h"
+#include "itkIndexRange.h"
+#include "itkPatchBasedDenoisingImageFilter.h"
+#include "itkTestingMacros.h"
+
+namespace
+{
+// A noisy image made of two constant regions
+template <unsigned int VDimension>
+typename itk::Image<float, VDimension>::Pointer
+CreateImage(const itk::Index<VDimension> & index, const itk::Size<VDimension> & size, double lastSpacing)
+{
+  using ImageType = itk::Image<float, VDimension>;
+
+  typename ImageType::Pointer image = ImageType::New();
+  image->SetRegions(typename ImageType::RegionType(index, size));
+  typename ImageType::SpacingType spacing;
+  spacing.Fill(1.0);
+  spacing[VDimension - 1] = lastSpacing;
+  image->SetSpacing(spacing);
+  image->Allocate();
+
+  unsigned int                                 state = 4321;
+  itk::ImageRegionIteratorWithIndex<ImageType> it(image, image->GetLargestPossibleRegion());
+  for (it.GoToBegin(); !it.IsAtEnd(); ++it)
+  {
+    state = state * 1103515245u + 12345u;
+    const float noise = static_cast<float>((state >> 16) % 200) / 10.0f;
+    it.Set((it.GetIndex()[0] - index[0] < static_cast<itk::IndexValueType>(size[0] / 2) ? 20.0f : 80.0f) + noise);
+  }
+  return image;
+}
+
+// Compares the denoised image with the one computed directly from the
+// patches of the search windows, and with the one computed by another number
+// of work units
+template <unsigned int VDimension>
+bool
+CheckSearchWindow(const itk::Index<VDimension> & index,
+                  const itk::Size<VDimension> &  size,
+                  double                         lastSpacing,
+                  bool                           useSmoothDiscPatchWeights,
+                  const std::string &            description)
+{
+  using ImageType = itk::Image<float, VDimension>;
+  using FilterType = itk::PatchBasedDenoisingImageFilter<ImageType, ImageType>;
+  using IndexType = typename ImageType::IndexType;
+
+  const typename ImageType::Pointer image = CreateImage<VDimension>(index, size, lastSpacing);
+  const double                      kernelSigma = 25.0;
+
+  typename FilterType::RealArrayType kernelBandwidthSigma(1);
+  kernelBandwidthSigma[0] = kernelSigma;
+
+  std::vector<typename FilterType::Pointer> filters;
+  for (unsigned int numberOfWorkUnits : { 1, 3 })
+  {
+    typename FilterType::Pointer filter = FilterType::New();
+    filter->SetInput(image);
+    filter->UseSearchWindowOn();
+    filter->SetSearchRadius(1);
+    filter->SetPatchRadius(1);
+    filter->SetUseSmoothDiscPatchWeights(useSmoothDiscPatchWeights);
+    filter->SetKernelBandwidthSigma(kernelBandwidthSigma);
+    filter->SetNumberOfWorkUnits(numberOfWorkUnits);
+    filter->Update();
+    filters.push_back(filter);
+  }
+
+  const typename FilterType::PatchWeightsType patchWeights = filters[0]->GetPatchWeights();
+  const typename FilterType::PatchRadiusType  patchRadius = filters[0]->GetPatchRadiusInVoxels();
+  const typename FilterType::PatchRadiusType  searchRadius = filters[0]->GetSearchRadiusInVoxels();
+  const typename ImageType::RegionType        region = image->GetLargestPossibleRegion();
+  typename FilterType::PatchRadiusType        searchDiameter;
+  typename FilterType::PatchRadiusType        patchDiameter;
+  for (unsigned int dim = 0; dim < VDimension; ++dim)
+  {
+    searchDiameter[dim] = 2 * searchRadius[dim] + 1;
+    patchDiameter[dim] = 2 * patchRadius[dim] + 1;
+  }
+
+  bool                                         passed = true;
+  double                                       largestError = 0.0;
+  double                                       largestChange = 0.0;
+  itk::ImageRegionConstIterator<ImageType>     outputIt(filters[0]->GetOutput(), region);
+  itk::ImageRegionConstIterator<ImageType>     otherOutputIt(filters[1]->GetOutput(), region);
+  itk::ImageRegionIteratorWithIndex<ImageType> it(image, region);
+  for (; !it.IsAtEnd(); ++it, ++outputIt, ++otherOutputIt)
+  {
+    const IndexType pixelIndex = it.GetIndex();
+    double          sumOfGaussians = 1.0;
+    double          gradient = 0.0;
+    for (const IndexType & searchIndex : itk::ZeroBasedIndexRange<VDimension>(searchDiameter))
+    {
+      IndexType displacedIndex;
+      bool      isZeroDisplacement = true;
+      for (unsigned int dim = 0; dim < VDimension; ++dim)
+      {
+        displacedIndex[dim] =
+          pixelIndex[dim] + searchIndex[dim] - static_cast<itk::IndexValueType>(searchRadius[dim]);
+        isZeroDisplacement = isZeroDisplacement && displacedIndex[dim] == pixelIndex[dim];
+      }
+      if (isZeroDisplacement || !region.IsInside(displacedIndex))
+      {
+        continue;
+      }
+
+      double       squaredDistance = 0.0;
+      unsigned int pos = 0;
+      for (const IndexType & patchIndex : itk::ZeroBasedIndexRange<VDimension>(patchDiameter))
+      {
+        typename ImageType::OffsetType offset;
+        for (unsigned int dim = 0; dim < VDimension; ++dim)
+        {
+          offset[dim] = patchIndex[dim] - static_cast<itk::IndexValueType>(patchRadius[dim]);
+        }
+        const double weight = patchWeights[pos++];
+        if (region.IsInside(pixelIndex + offset) && region.IsInside(displacedIndex + offset))
+        {
+          const double difference = image->GetPixel(displacedIndex + offset) - image->GetPixel(pixelIndex + offset);
+          squaredDistance += weight * weight * difference * difference / (kernelSigma * kernelSigma);
+        }
+      }
+      const double gaussian = std::exp(-squaredDistance / 2.0);
+      sumOfGaussians += gaussian;
+      gradient += gaussian * (image->GetPixel(displacedIndex) - it.Get());
+    }
+    const double expected = it.Get() + 0.2 * gradient / sumOfGaussians;
+
+    largestError = std::max(largestError, std::abs(outputIt.Get() - expected));
+    largestChange = std::max(largestChange, static_cast<double>(std::abs(outputIt.Get() - it.Get())));
+    if (otherOutputIt.Get() != outputIt.Get())
+    {
+      std::cerr << "Test failed for " << description << ": the output at " << pixelIndex
+                << " depends on the number of work units" << std::endl;
+      passed = false;
+      break;
+    }
+  }
+
+  if (largestError > 1e-4 || largestChange < 1.0)
+  {
+    std::cerr << "Test failed for " << description << ": largest error " << largestError << ", largest change "
+              << largestChange << std::endl;
+    passed = false;
+  }
+  return passed;
+}
+} // namespace
+
+// Checks the denoising with all the patches of the search windows, with
+// unity and smooth-disc patch weights, and anisotropic spacings.
+int
+itkPatchBasedDenoisingImageFilterSearchWindowTest(int, char *[])
+{
+  using ImageType = itk::Image<float, 3>;
+  using FilterType = itk::PatchBasedDenoisingImageFilter<ImageType, ImageType>;
+
+  FilterType::Pointer filter = FilterType::New();
+
+  ITK_EXERCISE_BASIC_OBJECT_METHODS(filter, PatchBasedDenoisingImageFilter, PatchBasedDenoisingBaseImageFilter);
+
+  ITK_TEST_SET_GET_BOOLEAN(filter, UseSearchWindow, true);
+
+  const unsigned int searchRadius = 3;
+  filter->SetSearchRadius(searchRadius);
+  ITK_TEST_SET_GET_VALUE(searchRadius, filter->GetSearchRadius());
+
+  bool passed = true;
+
+  const itk::Index<2> index2D = { { 0, 0 } };
+  const itk::Size<2>  size2D = { { 210, 170 } };
+  passed &= CheckSearchWindow<2>(index2D, size2D, 1.0, false, "2D");
+  passed &= CheckSearchWindow<2>(index2D, size2D, 1.0, true, "2D, smooth-disc patch weights");
+
+  const itk::Index<3> index3D = { { 0, 0, 0 } };
+  const itk::Size<3>  size3D = { { 41, 37, 13 } };
+  passed &= CheckSearchWindow<3>(index3D, size3D, 2.0, false, "3D, anisotropic");
+  passed &= CheckSearchWindow<3>(index3D, size3D, 2.0, true, "3D, anisotropic, smooth-disc patch weights");
+
+  std::cout << "Test finished." << std::endl;
+  return passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
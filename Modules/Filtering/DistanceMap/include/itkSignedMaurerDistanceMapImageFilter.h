@@ -19,6 +19,7 @@
 #define itkSignedMaurerDistanceMapImageFilter_h
 
 #include "itkImageToImageFilter.h"
+#include <vector>
 
 namespace itk
 {
@@ -50,6 +51,19 @@ namespace itk
  *  the itk::DanielssonDistanceImageFilter class except it does not return
  *  the Voronoi map.
  *
+ *  \par Band limited distances and streaming
+ *  Set/GetMaximumDistance limits the computation to a band around the
+ *  object boundary: distances larger than the maximum distance are clamped
+ *  to it, which also makes each pass cheaper. As the distances in the band
+ *  only depend on the input within the maximum distance, the filter then
+ *  only requests the output requested region of the input padded by that
+ *  distance, so that the distance map of a large volume can be streamed
+ *  slab by slab, e.g. with an ImageFileWriter or a StreamingImageFilter.
+ *  Without a maximum distance, the whole input is requested.
+ *
+ *  Each pass of the algorithm, one per dimension, processes all the lines
+ *  along its dimension in parallel.
+ *
  *  Reference:
  *  C. R. Maurer, Jr., R. Qi, and V. Raghavan, "A Linear Time Algorithm
  *  for Computing Exact Euclidean Distance Transforms of Binary Images in
@@ -153,6 +167,15 @@ public:
   itkSetMacro(BackgroundValue, InputPixelType);
   itkGetConstReferenceMacro(BackgroundValue, InputPixelType);
 
+  /**
+   * Set/Get the maximum distance computed, in physical units if the image
+   * spacing is used, or in pixels otherwise. Larger distances are clamped
+   * to the maximum distance. The default, NumericTraits<double>::max(),
+   * computes all the distances.
+   */
+  itkSetMacro(MaximumDistance, double);
+  itkGetConstMacro(MaximumDistance, double);
+
 protected:
   SignedMaurerDistanceMapImageFilter();
   ~SignedMaurerDistanceMapImageFilter() override = default;
@@ -163,22 +186,34 @@ protected:
   void
   GenerateData() override;
 
-  unsigned int
-  SplitRequestedRegion(unsigned int i, unsigned int num, OutputImageRegionType & splitRegion) override;
-
+  /** Without a maximum distance, the whole input is needed. Otherwise
+   * the output requested region padded by the maximum distance is
+   * requested. */
   void
-  ThreadedGenerateData(const OutputImageRegionType &, ThreadIdType) override;
+  GenerateInputRequestedRegion() override;
 
+  /** Compute the current dimension pass of the lines of a region of the
+   * distance image. The region covers whole lines in that dimension. */
   void
-  DynamicThreadedGenerateData(const OutputImageRegionType &) override
-  {
-    itkExceptionMacro("This class requires threadId so it must use classic multi-threading model");
-  }
+  ThreadedVoronoi(OutputImageType * distance, const OutputImageRegionType & regionForThread);
 
 private:
   void
-       Voronoi(unsigned int, OutputIndexType idx, OutputImageType * output);
-  bool Remove(OutputPixelType, OutputPixelType, OutputPixelType, OutputPixelType, OutputPixelType, OutputPixelType);
+  Voronoi(unsigned int                   d,
+          OutputIndexType                idx,
+          OutputImageType *              distance,
+          std::vector<OutputPixelType> & g,
+          std::vector<OutputPixelType> & h);
+  bool
+  Remove(OutputPixelType, OutputPixelType, OutputPixelType, OutputPixelType, OutputPixelType, OutputPixelType);
+
+  /** Whether distances larger than m_MaximumDistance are clamped. */
+  bool
+  IsBandLimited() const;
+
+  /** Signed distance of the final pass, from the squared distance. */
+  OutputPixelType
+  FinalDistance(OutputPixelType squaredDistance, bool inside) const;
 
   InputPixelType   m_BackgroundValue;
   InputSpacingType m_Spacing;
@@ -189,6 +224,9 @@ private:
   bool m_UseImageSpacing{ true };
   bool m_SquaredDistance{ false };
 
+  double          m_MaximumDistance{ NumericTraits<double>::max() };
+  OutputPixelType m_MaximumSquaredDistance{ NumericTraits<OutputPixelType>::max() };
+
   const InputImageType * m_InputCache;
 };
 } // end namespace itk
@@ -25,8 +25,9 @@
 #include "itkBinaryContourImageFilter.h"
 #include "itkProgressReporter.h"
 #include "itkProgressAccumulator.h"
-#include "itkMath.h"
-#include "vnl/vnl_vector.h"
+#include "itkProgressTransformer.h"
+#include "itkImageAlgorithm.h"
+#include "itkImageLinearConstIteratorWithIndex.h"
 #include "itkMath.h"
 
 namespace itk
@@ -36,66 +37,48 @@ SignedMaurerDistanceMapImageFilter<TInputImage, TOutputImage>::SignedMaurerDista
   : m_BackgroundValue(NumericTraits<InputPixelType>::ZeroValue())
   , m_Spacing(0.0)
   , m_InputCache(nullptr)
+{}
+
+template <typename TInputImage, typename TOutputImage>
+bool
+SignedMaurerDistanceMapImageFilter<TInputImage, TOutputImage>::IsBandLimited() const
 {
-  this->DynamicMultiThreadingOff();
+  return m_MaximumDistance < NumericTraits<double>::max();
 }
 
 template <typename TInputImage, typename TOutputImage>
-unsigned int
-SignedMaurerDistanceMapImageFilter<TInputImage, TOutputImage>::SplitRequestedRegion(unsigned int            i,
-                                                                                    unsigned int            num,
-                                                                                    OutputImageRegionType & splitRegion)
+void
+SignedMaurerDistanceMapImageFilter<TInputImage, TOutputImage>::GenerateInputRequestedRegion()
 {
-  // Get the output pointer
-  OutputImageType * outputPtr = this->GetOutput();
-
-  // Initialize the splitRegion to the output requested region
-  splitRegion = outputPtr->GetRequestedRegion();
+  Superclass::GenerateInputRequestedRegion();
 
-  const OutputSizeType & requestedRegionSize = splitRegion.GetSize();
-
-  OutputIndexType splitIndex = splitRegion.GetIndex();
-  OutputSizeType  splitSize = splitRegion.GetSize();
-
-  // split on the outermost dimension available
-  // and avoid the current dimension
-  int splitAxis = static_cast<int>(outputPtr->GetImageDimension()) - 1;
-  while ((requestedRegionSize[splitAxis] == 1) || (splitAxis == static_cast<int>(m_CurrentDimension)))
+  auto * input = const_cast<InputImageType *>(this->GetInput());
+  if (!input)
   {
-    --splitAxis;
-    if (splitAxis < 0)
-    { // cannot split
-      itkDebugMacro("Cannot Split");
-      return 1;
-    }
+    return;
   }
 
-  // determine the actual number of pieces that will be generated
-  auto range = static_cast<double>(requestedRegionSize[splitAxis]);
-
-  auto         valuesPerThread = static_cast<unsigned int>(std::ceil(range / static_cast<double>(num)));
-  unsigned int maxThreadIdUsed = static_cast<unsigned int>(std::ceil(range / static_cast<double>(valuesPerThread))) - 1;
-
-  // Split the region
-  if (i < maxThreadIdUsed)
+  const InputRegionType & largestRegion = input->GetLargestPossibleRegion();
+  if (!this->IsBandLimited())
   {
-    splitIndex[splitAxis] += i * valuesPerThread;
-    splitSize[splitAxis] = valuesPerThread;
+    input->SetRequestedRegion(largestRegion);
+    return;
   }
-  if (i == maxThreadIdUsed)
+
+  // The distances in the band only depend on the boundary pixels within
+  // the maximum distance, and one more pixel is needed to find the
+  // boundary.
+  InputRegionType region = this->GetOutput()->GetRequestedRegion();
+  InputSizeType   radius;
+  for (unsigned int d = 0; d < InputImageDimension; d++)
   {
-    splitIndex[splitAxis] += i * valuesPerThread;
-    // last thread needs to process the "rest" dimension being split
-    splitSize[splitAxis] = splitSize[splitAxis] - i * valuesPerThread;
+    const double spacing = this->m_UseImageSpacing ? input->GetSpacing()[d] : 1.0;
+    const double pixels = std::ceil(m_MaximumDistance / spacing) + 1.0;
+    radius[d] = static_cast<InputSizeValueType>(std::min(pixels, static_cast<double>(largestRegion.GetSize(d))));
   }
-
-  // set the split region ivars
-  splitRegion.SetIndex(splitIndex);
-  splitRegion.SetSize(splitSize);
-
-  itkDebugMacro("Split Piece: " << splitRegion);
-
-  return maxThreadIdUsed + 1;
+  region.PadByRadius(radius);
+  region.Crop(largestRegion);
+  input->SetRequestedRegion(region);
 }
 
 template <typename TInputImage, typename TOutputImage>
@@ -108,10 +91,43 @@ SignedMaurerDistanceMapImageFilter<TInputImage, TOutputImage>::GenerateData()
   const InputImageType * inputPtr = this->GetInput();
   m_InputCache = this->GetInput();
 
-  // prepare the data
-  this->AllocateOutputs();
   this->m_Spacing = outputPtr->GetSpacing();
 
+  m_MaximumSquaredDistance = NumericTraits<OutputPixelType>::max();
+  if (this->IsBandLimited() &&
+      m_MaximumDistance * m_MaximumDistance < static_cast<double>(NumericTraits<OutputPixelType>::max()))
+  {
+    m_MaximumSquaredDistance = static_cast<OutputPixelType>(m_MaximumDistance * m_MaximumDistance);
+  }
+
+  // The distance is computed over the requested region of the input, which
+  // is larger than the output requested region when streaming.
+  const InputRegionType workRegion = inputPtr->GetRequestedRegion();
+  const bool            computeInOutput = (workRegion == outputPtr->GetRequestedRegion());
+
+  // Disconnect the input from the pipeline, so that the internal filters
+  // don't request more than the work region of it. An image without a
+  // source takes its buffered region as its largest possible region, so
+  // the work region is copied unless it is exactly the buffered region.
+  InputImageConstPointer binaryInput = inputPtr;
+  if (workRegion != inputPtr->GetLargestPossibleRegion())
+  {
+    typename InputImageType::Pointer inputView = InputImageType::New();
+    if (inputPtr->GetBufferedRegion() == workRegion)
+    {
+      inputView->Graft(inputPtr);
+    }
+    else
+    {
+      inputView->CopyInformation(inputPtr);
+      inputView->SetRegions(workRegion);
+      inputView->Allocate();
+      ImageAlgorithm::Copy(inputPtr, inputView.GetPointer(), workRegion, workRegion);
+    }
+    inputView->SetLargestPossibleRegion(workRegion);
+    binaryInput = inputView;
+  }
+
   // store the binary image in an image with a pixel type as small as possible
   // instead of keeping the native input pixel type to avoid using too much
   // memory.
@@ -129,10 +145,15 @@ SignedMaurerDistanceMapImageFilter<TInputImage, TOutputImage>::GenerateData()
   binaryFilter->SetUpperThreshold(this->m_BackgroundValue);
   binaryFilter->SetInsideValue(NumericTraits<OutputPixelType>::max());
   binaryFilter->SetOutsideValue(NumericTraits<OutputPixelType>::ZeroValue());
-  binaryFilter->SetInput(inputPtr);
+  binaryFilter->SetInput(binaryInput);
   binaryFilter->SetNumberOfWorkUnits(nbthreads);
   progressAcc->RegisterInternalFilter(binaryFilter, 0.1f);
-  binaryFilter->GraftOutput(outputPtr);
+  if (computeInOutput)
+  {
+    // prepare the data
+    this->AllocateOutputs();
+    binaryFilter->GraftOutput(outputPtr);
+  }
   binaryFilter->Update();
 
   // Dilate the inverted image by 1 pixel to give it the same boundary
@@ -147,182 +168,108 @@ SignedMaurerDistanceMapImageFilter<TInputImage, TOutputImage>::GenerateData()
   progressAcc->RegisterInternalFilter(borderFilter, 0.23f);
   borderFilter->Update();
 
-  this->GraftOutput(borderFilter->GetOutput());
-
-  // Set up the multithreaded processing
-  typename ImageSource<OutputImageType>::ThreadStruct str;
-  str.Filter = this;
+  OutputImagePointer distance = borderFilter->GetOutput();
+  if (computeInOutput)
+  {
+    this->GraftOutput(distance);
+    distance = outputPtr;
+  }
 
-  this->GetMultiThreader()->SetNumberOfWorkUnits(nbthreads);
-  this->GetMultiThreader()->SetSingleMethod(this->ThreaderCallback, &str);
+  // One pass per dimension, each of them processing all the lines along
+  // the dimension in parallel
+  MultiThreaderBase * multiThreader = this->GetMultiThreader();
+  multiThreader->SetNumberOfWorkUnits(nbthreads);
 
-  // multithread the execution
+  const float progressPerDimension = 0.67f / static_cast<float>(ImageDimension);
   for (unsigned int d = 0; d < ImageDimension; d++)
   {
     m_CurrentDimension = d;
-    this->GetMultiThreader()->SingleMethodExecute();
+
+    ProgressTransformer progress(0.33f + static_cast<float>(d) * progressPerDimension,
+                                 0.33f + static_cast<float>(d + 1) * progressPerDimension,
+                                 this);
+    multiThreader->template ParallelizeImageRegionRestrictDirection<ImageDimension>(
+      d,
+      workRegion,
+      [this, &distance](const OutputImageRegionType & regionForThread) {
+        this->ThreadedVoronoi(distance, regionForThread);
+      },
+      progress.GetProcessObject());
   }
+
+  if (!computeInOutput)
+  {
+    this->AllocateOutputs();
+    ImageAlgorithm::Copy(
+      distance.GetPointer(), outputPtr, outputPtr->GetRequestedRegion(), outputPtr->GetRequestedRegion());
+  }
+  m_InputCache = nullptr;
 }
 
 template <typename TInputImage, typename TOutputImage>
 void
-SignedMaurerDistanceMapImageFilter<TInputImage, TOutputImage>::ThreadedGenerateData(
-  const OutputImageRegionType & outputRegionForThread,
-  ThreadIdType                  threadId)
+SignedMaurerDistanceMapImageFilter<TInputImage, TOutputImage>::ThreadedVoronoi(
+  OutputImageType *             distance,
+  const OutputImageRegionType & regionForThread)
 {
-  OutputImageType * outputImage = this->GetOutput();
+  const OutputSizeValueType    nd = regionForThread.GetSize()[m_CurrentDimension];
+  std::vector<OutputPixelType> g(nd);
+  std::vector<OutputPixelType> h(nd);
 
-  InputRegionType region = outputRegionForThread;
-  InputSizeType   size = region.GetSize();
-  InputIndexType  startIndex = outputRegionForThread.GetIndex();
+  ImageLinearConstIteratorWithIndex<OutputImageType> lineIt(distance, regionForThread);
+  lineIt.SetDirection(m_CurrentDimension);
+  for (lineIt.GoToBegin(); !lineIt.IsAtEnd(); lineIt.NextLine())
+  {
+    this->Voronoi(m_CurrentDimension, lineIt.GetIndex(), distance, g, h);
+  }
+}
 
-  OutputImageType * outputPtr = this->GetOutput();
+template <typename TInputImage, typename TOutputImage>
+auto
+SignedMaurerDistanceMapImageFilter<TInputImage, TOutputImage>::FinalDistance(OutputPixelType squaredDistance,
+                                                                             bool            inside) const
+  -> OutputPixelType
+{
+  using OutputRealType = typename NumericTraits<OutputPixelType>::RealType;
 
-  // compute the number of rows first, so we can setup a progress reporter
-  std::vector<InputSizeValueType> NumberOfRows;
-  for (unsigned int i = 0; i < InputImageDimension; i++)
+  if (squaredDistance > m_MaximumSquaredDistance)
   {
-    NumberOfRows.push_back(1);
-    for (unsigned int d = 0; d < InputImageDimension; d++)
-    {
-      if (d != i)
-      {
-        NumberOfRows[i] *= size[d];
-      }
-    }
+    squaredDistance = m_MaximumSquaredDistance;
   }
 
-  // set the progress reporter. Use a pointer to be able to destroy it before
-  // the creation of progress2
-  // so it won't set wrong progress at the end of ThreadedGenerateData()
-  float progressPerDimension = 0.67f / static_cast<float>(ImageDimension);
+  OutputPixelType outputValue = squaredDistance;
   if (!this->m_SquaredDistance)
   {
-    progressPerDimension = 0.67f / (static_cast<float>(ImageDimension) + 1);
+    // cast to a real type is required on some platforms
+    outputValue = static_cast<OutputPixelType>(std::sqrt(static_cast<OutputRealType>(squaredDistance)));
   }
-  std::unique_ptr<ProgressReporter> progress(
-    new ProgressReporter(this,
-                         threadId,
-                         NumberOfRows[m_CurrentDimension],
-                         30,
-                         0.33f + static_cast<float>(m_CurrentDimension * progressPerDimension),
-                         progressPerDimension));
-
-  // This variable provides the amount by which to divide the dimensionless index in order to get the index for each
-  // dimension.
-  vnl_vector<unsigned int> k(InputImageDimension - 1);
-  unsigned int             count = 0;
-  k[count] = 1;
-  for (unsigned int d = m_CurrentDimension + InputImageDimension - 1; d > m_CurrentDimension + 1; d--)
-  {
-    k[count + 1] = k[count] * size[d % InputImageDimension];
-    count++;
-  }
-  k.flip();
-
-  // The index is defined as the dimensionless index into the pixel.
-  // It must be divided by each dimension size in order to get the index for that dimension.
-  // The result of this division is the offsetIndex, which is the index offset relative to the region of this thread.
-  // The true pixel location (idx) is provided by the sum of the offsetIndex and the startIndex.
-  InputSizeValueType index;
-  OutputIndexType    offsetIndex;
-  offsetIndex.Fill(0);
-  InputSizeValueType tempRow = NumberOfRows[m_CurrentDimension];
-  OutputIndexType    idx;
-  idx.Fill(0);
-
-  for (InputSizeValueType n = 0; n < tempRow; n++)
-  {
-    index = n;
-    count = 0;
-    for (unsigned int d = m_CurrentDimension + 1; d < m_CurrentDimension + InputImageDimension; d++)
-    {
-      offsetIndex[d % InputImageDimension] =
-        static_cast<OutputIndexValueType>(static_cast<double>(index) / static_cast<double>(k[count]));
-      idx[d % InputImageDimension] =
-        offsetIndex[d % InputImageDimension] + static_cast<OutputIndexValueType>(startIndex[d % InputImageDimension]);
-
-      index %= k[count];
-      count++;
-    }
-    this->Voronoi(m_CurrentDimension, idx, outputImage);
-    progress->CompletedPixel();
-  }
-  progress.reset();
 
-  if (m_CurrentDimension == ImageDimension - 1 && !this->m_SquaredDistance)
+  if (inside == this->m_InsideIsPositive)
   {
-    using OutputIterator = ImageRegionIterator<OutputImageType>;
-    using InputIterator = ImageRegionConstIterator<InputImageType>;
-
-    typename OutputImageType::RegionType outputRegion = outputRegionForThread;
-
-    OutputIterator Ot(outputPtr, outputRegion);
-    InputIterator  It(m_InputCache, outputRegion);
-
-    Ot.GoToBegin();
-    It.GoToBegin();
-
-    ProgressReporter progress2(this,
-                               threadId,
-                               outputRegionForThread.GetNumberOfPixels(),
-                               30,
-                               0.33f + static_cast<float>(ImageDimension * progressPerDimension),
-                               progressPerDimension);
-
-    using OutputRealType = typename NumericTraits<OutputPixelType>::RealType;
-
-    while (!Ot.IsAtEnd())
-    {
-      // cast to a real type is required on some platforms
-      const auto outputValue =
-        static_cast<OutputPixelType>(std::sqrt(static_cast<OutputRealType>(itk::Math::abs(Ot.Get()))));
-
-      if (Math::NotExactlyEquals(It.Get(), this->m_BackgroundValue))
-      {
-        if (this->GetInsideIsPositive())
-        {
-          Ot.Set(outputValue);
-        }
-        else
-        {
-          Ot.Set(-outputValue);
-        }
-      }
-      else
-      {
-        if (this->GetInsideIsPositive())
-        {
-          Ot.Set(-outputValue);
-        }
-        else
-        {
-          Ot.Set(outputValue);
-        }
-      }
-
-      ++Ot;
-      ++It;
-      progress2.CompletedPixel();
-    }
+    return outputValue;
   }
+  return -outputValue;
 }
 
 template <typename TInputImage, typename TOutputImage>
 void
-SignedMaurerDistanceMapImageFilter<TInputImage, TOutputImage>::Voronoi(unsigned int      d,
-                                                                       OutputIndexType   idx,
-                                                                       OutputImageType * output)
+SignedMaurerDistanceMapImageFilter<TInputImage, TOutputImage>::Voronoi(unsigned int                   d,
+                                                                       OutputIndexType                idx,
+                                                                       OutputImageType *              distance,
+                                                                       std::vector<OutputPixelType> & g,
+                                                                       std::vector<OutputPixelType> & h)
 {
-  OutputRegionType    oRegion = output->GetRequestedRegion();
+  OutputRegionType    oRegion = distance->GetBufferedRegion();
   OutputSizeValueType nd = oRegion.GetSize()[d];
 
-  vnl_vector<OutputPixelType> g(nd, 0);
-  vnl_vector<OutputPixelType> h(nd, 0);
-
-
-  InputRegionType iRegion = m_InputCache->GetRequestedRegion();
-  InputIndexType  startIndex = iRegion.GetIndex();
+  // The pixels of the line are accessed directly in the buffers
+  idx[d] = oRegion.GetIndex()[d];
+  OutputPixelType *      line = distance->GetBufferPointer() + distance->ComputeOffset(idx);
+  const OffsetValueType  stride = distance->GetOffsetTable()[d];
+  const InputPixelType * inputLine = m_InputCache->GetBufferPointer() + m_InputCache->ComputeOffset(idx);
+  const OffsetValueType  inputStride = m_InputCache->GetOffsetTable()[d];
+  const bool             lastPass = (d == ImageDimension - 1);
+  const OutputPixelType  maximumSquaredDistance = m_MaximumSquaredDistance;
 
   OutputPixelType di;
 
@@ -330,9 +277,7 @@ SignedMaurerDistanceMapImageFilter<TInputImage, TOutputImage>::Voronoi(unsigned
 
   for (unsigned int i = 0; i < nd; i++)
   {
-    idx[d] = i + startIndex[d];
-
-    di = output->GetPixel(idx);
+    di = line[i * stride];
 
     OutputPixelType iw;
 
@@ -345,29 +290,43 @@ SignedMaurerDistanceMapImageFilter<TInputImage, TOutputImage>::Voronoi(unsigned
       iw = static_cast<OutputPixelType>(i);
     }
 
-    if (Math::NotExactlyEquals(di, NumericTraits<OutputPixelType>::max()))
+    // the pixels farther than the maximum distance can't be the closest
+    // to the pixels in the band
+    if (Math::NotExactlyEquals(di, NumericTraits<OutputPixelType>::max()) &&
+        !(static_cast<OutputPixelType>(itk::Math::abs(di)) > maximumSquaredDistance))
     {
       if (l < 1)
       {
         l++;
-        g(l) = di;
-        h(l) = iw;
+        g[l] = di;
+        h[l] = iw;
       }
       else
       {
-        while ((l >= 1) && this->Remove(g(l - 1), g(l), di, h(l - 1), h(l), iw))
+        while ((l >= 1) && this->Remove(g[l - 1], g[l], di, h[l - 1], h[l], iw))
         {
           l--;
         }
         l++;
-        g(l) = di;
-        h(l) = iw;
+        g[l] = di;
+        h[l] = iw;
       }
     }
   }
 
   if (l == -1)
   {
+    // No boundary pixel in the line. In the last pass, the line is still
+    // signed, unless the squared distances are not limited.
+    if (lastPass && (!this->m_SquaredDistance || this->IsBandLimited()))
+    {
+      for (unsigned int i = 0; i < nd; i++)
+      {
+        line[i * stride] =
+          this->FinalDistance(NumericTraits<OutputPixelType>::max(),
+                              Math::NotExactlyEquals(inputLine[i * inputStride], this->m_BackgroundValue));
+      }
+    }
     return;
   }
 
@@ -388,12 +347,12 @@ SignedMaurerDistanceMapImageFilter<TInputImage, TOutputImage>::Voronoi(unsigned
       iw = static_cast<OutputPixelType>(i);
     }
 
-    OutputPixelType d1 = itk::Math::abs(g(l)) + (h(l) - iw) * (h(l) - iw);
+    OutputPixelType d1 = itk::Math::abs(g[l]) + (h[l] - iw) * (h[l] - iw);
 
     while (l < ns)
     {
       // be sure to compute d2 *only* if l < ns
-      OutputPixelType d2 = itk::Math::abs(g(l + 1)) + (h(l + 1) - iw) * (h(l + 1) - iw);
+      OutputPixelType d2 = itk::Math::abs(g[l + 1]) + (h[l + 1] - iw) * (h[l + 1] - iw);
       // then compare d1 and d2
       if (d1 <= d2)
       {
@@ -402,29 +361,17 @@ SignedMaurerDistanceMapImageFilter<TInputImage, TOutputImage>::Voronoi(unsigned
       l++;
       d1 = d2;
     }
-    idx[d] = i + startIndex[d];
 
-    if (Math::NotExactlyEquals(m_InputCache->GetPixel(idx), this->m_BackgroundValue))
+    // The intermediate passes only need the squared distance, the sign and
+    // the final distance are computed in the last pass.
+    if (lastPass)
     {
-      if (this->m_InsideIsPositive)
-      {
-        output->SetPixel(idx, d1);
-      }
-      else
-      {
-        output->SetPixel(idx, -d1);
-      }
+      line[i * stride] =
+        this->FinalDistance(d1, Math::NotExactlyEquals(inputLine[i * inputStride], this->m_BackgroundValue));
     }
     else
     {
-      if (this->m_InsideIsPositive)
-      {
-        output->SetPixel(idx, -d1);
-      }
-      else
-      {
-        output->SetPixel(idx, d1);
-      }
+      line[i * stride] = d1;
     }
   }
 }
@@ -460,6 +407,7 @@ SignedMaurerDistanceMapImageFilter<TInputImage, TOutputImage>::PrintSelf(std::os
   os << indent << "Inside is positive: " << this->m_InsideIsPositive << std::endl;
   os << indent << "Use image spacing: " << this->m_UseImageSpacing << std::endl;
   os << indent << "Squared distance: " << this->m_SquaredDistance << std::endl;
+  os << indent << "Maximum distance: " << this->m_MaximumDistance << std::endl;
 }
 } // end namespace itk
 
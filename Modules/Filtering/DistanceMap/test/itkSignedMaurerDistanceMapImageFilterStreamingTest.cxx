@@ -0,0 +1,126 @@
+/*=========================================================================
+ *
+ *  Copyright NumFOCUS
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include "itkImageRegionConstIterator.h"
+#include "itkImageRegionIteratorWithIndex.h"
+#include "itkPipelineMonitorImageFilter.h"
+#include "itkSignedMaurerDistanceMapImageFilter.h"
+#include "itkStreamingImageFilter.h"
+#include "itkTestingMacros.h"
+
+// Computes a band limited distance map by streaming it in slabs, and
+// compares it with the clamped full distance map.
+int
+itkSignedMaurerDistanceMapImageFilterStreamingTest(int, char *[])
+{
+  constexpr unsigned int Dimension = 3;
+  using InputImageType = itk::Image<unsigned char, Dimension>;
+  using OutputImageType = itk::Image<float, Dimension>;
+  using FilterType = itk::SignedMaurerDistanceMapImageFilter<InputImageType, OutputImageType>;
+
+  // Two balls and a few isolated pixels in an anisotropic image
+  InputImageType::Pointer  image = InputImageType::New();
+  InputImageType::SizeType size = { { 41, 33, 29 } };
+  image->SetRegions(size);
+  const double spacing[Dimension] = { 0.8, 1.0, 1.3 };
+  image->SetSpacing(spacing);
+  image->Allocate();
+
+  const double center1[Dimension] = { 12.0, 10.0, 8.0 };
+  const double center2[Dimension] = { 30.0, 24.0, 20.0 };
+
+  itk::ImageRegionIteratorWithIndex<InputImageType> it(image, image->GetLargestPossibleRegion());
+  for (it.GoToBegin(); !it.IsAtEnd(); ++it)
+  {
+    const InputImageType::IndexType & index = it.GetIndex();
+    double                            distance1 = 0.0;
+    double                            distance2 = 0.0;
+    for (unsigned int d = 0; d < Dimension; ++d)
+    {
+      distance1 += itk::Math::sqr((index[d] - center1[d]) * spacing[d]);
+      distance2 += itk::Math::sqr((index[d] - center2[d]) * spacing[d]);
+    }
+    const bool isolated = (index[0] * 7 + index[1] * 3 + index[2] * 5) % 97 == 0;
+    it.Set((distance1 < 36.0 || distance2 < 20.0 || isolated) ? 1 : 0);
+  }
+
+  FilterType::Pointer reference = FilterType::New();
+
+  ITK_EXERCISE_BASIC_OBJECT_METHODS(reference, SignedMaurerDistanceMapImageFilter, ImageToImageFilter);
+
+  ITK_TEST_EXPECT_EQUAL(reference->GetMaximumDistance(), itk::NumericTraits<double>::max());
+
+  reference->SetInput(image);
+  reference->SetUseImageSpacing(true);
+  reference->SetNumberOfWorkUnits(1);
+  ITK_TRY_EXPECT_NO_EXCEPTION(reference->Update());
+
+  const double maximumDistance = 3.5;
+
+  FilterType::Pointer filter = FilterType::New();
+  filter->SetInput(image);
+  filter->SetUseImageSpacing(true);
+  filter->SetMaximumDistance(maximumDistance);
+  ITK_TEST_SET_GET_VALUE(maximumDistance, filter->GetMaximumDistance());
+
+  using MonitorFilterType = itk::PipelineMonitorImageFilter<OutputImageType>;
+  MonitorFilterType::Pointer monitor = MonitorFilterType::New();
+  monitor->SetInput(filter->GetOutput());
+
+  const unsigned int numberOfStreamDivisions = 5;
+
+  using StreamingFilterType = itk::StreamingImageFilter<OutputImageType, OutputImageType>;
+  StreamingFilterType::Pointer streamer = StreamingFilterType::New();
+  streamer->SetInput(monitor->GetOutput());
+  streamer->SetNumberOfStreamDivisions(numberOfStreamDivisions);
+  ITK_TRY_EXPECT_NO_EXCEPTION(streamer->Update());
+
+  if (!monitor->VerifyAllInputCanStream(numberOfStreamDivisions))
+  {
+    std::cout << monitor << std::endl;
+    std::cerr << "Test failed!" << std::endl;
+    std::cerr << "The distance map was not streamed as expected!" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  // The distances in the band are exact, the others are clamped
+  itk::ImageRegionConstIterator<OutputImageType> referenceIt(reference->GetOutput(),
+                                                             reference->GetOutput()->GetLargestPossibleRegion());
+  itk::ImageRegionConstIterator<OutputImageType> outputIt(streamer->GetOutput(),
+                                                          streamer->GetOutput()->GetLargestPossibleRegion());
+  for (; !referenceIt.IsAtEnd(); ++referenceIt, ++outputIt)
+  {
+    const float referenceValue = referenceIt.Get();
+    float       expected = referenceValue;
+    if (std::abs(referenceValue) > maximumDistance)
+    {
+      expected = referenceValue > 0 ? maximumDistance : -maximumDistance;
+    }
+
+    if (std::abs(expected - outputIt.Get()) > 1e-4)
+    {
+      std::cerr << "Test failed!" << std::endl;
+      std::cerr << "Error in distance at index " << referenceIt.GetIndex() << std::endl;
+      std::cerr << "Expected: " << expected << ", but got: " << outputIt.Get() << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+
+  std::cout << "Test finished." << std::endl;
+  return EXIT_SUCCESS;
+}
@@ -27,7 +27,11 @@ namespace itk
  *
  * \brief VNL based complex to complex Fast Fourier Transform.
  *
- * This filter requires input images with sizes which are a power of two.
+ * The image size may be arbitrary, but the transform is fastest when
+ * 2, 3, and 5 are the only prime factors of the image size along each
+ * dimension. The other sizes are transformed with Bluestein's algorithm,
+ * which is several times slower. The lines of the image are transformed by
+ * the work units of the filter.
  *
  * \ingroup FourierTransform
  * \ingroup ITKFFT
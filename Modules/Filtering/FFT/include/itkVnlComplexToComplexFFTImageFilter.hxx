@@ -45,17 +45,6 @@ VnlComplexToComplexFFTImageFilter<TImage>::BeforeThreadedGenerateData()
   const typename ImageType::RegionType bufferedRegion = input->GetBufferedRegion();
   const typename ImageType::SizeType & imageSize = bufferedRegion.GetSize();
 
-  for (unsigned int ii = 0; ii < ImageDimension; ++ii)
-  {
-    if (!VnlFFTCommon::IsDimensionSizeLegal(imageSize[ii]))
-    {
-      itkExceptionMacro(<< "Cannot compute FFT of image with size " << imageSize
-                        << ". VnlComplexToComplexFFTImageFilter operates "
-                        << "only on images whose size in each dimension has"
-                        << "only a combination of 2,3, and 5 as prime factors.");
-    }
-  }
-
   // Copy the input to the output, and we will work in place on the output.
   ImageAlgorithm::Copy<ImageType, ImageType>(input, output, bufferedRegion, bufferedRegion);
 
@@ -63,7 +52,9 @@ VnlComplexToComplexFFTImageFilter<TImage>::BeforeThreadedGenerateData()
   auto * outputBuffer = static_cast<VclPixelType *>(output->GetBufferPointer());
 
   // call the proper transform, based on compile type template parameter
-  VnlFFTCommon::VnlFFTTransform<Image<typename PixelType::value_type, ImageDimension>> vnlfft(imageSize);
+  this->GetMultiThreader()->SetNumberOfWorkUnits(this->GetNumberOfWorkUnits());
+  using TransformType = VnlFFTCommon::VnlFFTTransform<Image<typename PixelType::value_type, ImageDimension>>;
+  TransformType vnlfft(imageSize, this->GetMultiThreader());
   if (this->GetTransformDirection() == Superclass::TransformDirectionEnum::INVERSE)
   {
     vnlfft.transform(outputBuffer, 1);
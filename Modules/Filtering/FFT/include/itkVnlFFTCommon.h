@@ -18,9 +18,15 @@
 #ifndef itkVnlFFTCommon_h
 #define itkVnlFFTCommon_h
 
+#include "itkFixedArray.h"
 #include "itkIntTypes.h"
+#include "itkMultiThreaderBase.h"
+#include "ITKFFTExport.h"
 
-#include "vnl/algo/vnl_fft_base.h"
+#include "vnl/algo/vnl_fft_prime_factors.h"
+#include <complex>
+#include <memory>
+#include <vector>
 
 namespace itk
 {
@@ -42,17 +48,100 @@ struct VnlFFTCommon
 
   static constexpr SizeValueType GREATEST_PRIME_FACTOR = 5;
 
+  /** Returns the prime factorization of a size and the table of twiddle
+  factors of the transforms of this size, which are computed once and
+  shared by all the transforms of the process.  The table does not depend
+  on the direction of the transforms. */
+  template <typename TValue>
+  static std::shared_ptr<const vnl_fft_prime_factors<TValue>>
+  GetPrimeFactors(SizeValueType n);
+
+  /** Tables of the transforms of the sizes which are not legal, which are
+  computed with Bluestein's algorithm: the transform of size n is written as
+  the circular convolution of the signal multiplied by the chirp with the
+  conjugate of the chirp, which is computed with transforms of the legal
+  padded size. The transformed conjugate chirp is divided by the padded size,
+  so that the inverse transform of the product does not need to be. */
+  template <typename TValue>
+  struct BluesteinTables
+  {
+    SizeValueType                                        PaddedSize;
+    std::shared_ptr<const vnl_fft_prime_factors<TValue>> PrimeFactors;
+    std::vector<std::complex<TValue>>                    Chirp;
+    std::vector<std::complex<TValue>>                    TransformedChirp;
+  };
+
+  /** Returns the Bluestein tables of the transforms of size n in the
+  direction dir, which, like the prime factors, are computed once and shared
+  by all the transforms of the process. */
+  template <typename TValue>
+  static std::shared_ptr<const BluesteinTables<TValue>>
+  GetBluesteinTables(SizeValueType n, int dir);
+
   /** Convenience struct for computing the discrete Fourier
-  Transform. */
+  Transform. The one dimensional transforms along each dimension but the
+  first one are computed together, for all the lines of the image that are
+  next to each other in memory.  The lines are split in blocks which are
+  transformed by the work units of the multithreader, when one is given,
+  and the result does not depend on the number of work units.  Sizes which
+  are not legal are supported, but their transforms are slower. */
   template <typename TImage>
-  struct VnlFFTTransform : public vnl_fft_base<TImage::ImageDimension, typename TImage::PixelType>
+  struct VnlFFTTransform
   {
-    using Base = vnl_fft_base<TImage::ImageDimension, typename TImage::PixelType>;
+    using ValueType = typename TImage::PixelType;
+    using SizeType = typename TImage::SizeType;
+
+    /** Whether the image is transformed along each dimension. */
+    using DimensionsType = FixedArray<bool, TImage::ImageDimension>;
+
+    //: constructor takes size of signal, and the multithreader used to
+    //: transform the lines, if any.
+    VnlFFTTransform(const SizeType & s, MultiThreaderBase * multiThreader = nullptr);
 
-    //: constructor takes size of signal.
-    VnlFFTTransform(const typename TImage::SizeType & s);
+    //: dir = +1/-1 according to direction of transform.
+    void
+    transform(std::complex<ValueType> * signal, int dir);
+
+    /** Transforms the signal along the given dimensions only, that is,
+    transforms each of the images along these dimensions, for example each
+    image of a stack of images of the same size, or each slice of a volume,
+    in a single call. */
+    void
+    transform(std::complex<ValueType> * signal, int dir, const DimensionsType & dimensions);
+
+  private:
+    /** Transforms the lot lines of size n starting at data, the elements of
+    each line being inc elements apart, and the lines jump elements apart. */
+    static void
+    TransformLines(std::complex<ValueType> *                data,
+                   long                                     inc,
+                   long                                     jump,
+                   long                                     n,
+                   long                                     lot,
+                   int                                      dir,
+                   const vnl_fft_prime_factors<ValueType> * factors,
+                   const BluesteinTables<ValueType> *       bluestein);
+
+    SizeType            m_Size;
+    MultiThreaderBase * m_MultiThreader;
   };
 };
+
+template <>
+ITKFFT_EXPORT std::shared_ptr<const vnl_fft_prime_factors<float>>
+              VnlFFTCommon::GetPrimeFactors<float>(SizeValueType n);
+
+template <>
+ITKFFT_EXPORT std::shared_ptr<const vnl_fft_prime_factors<double>>
+              VnlFFTCommon::GetPrimeFactors<double>(SizeValueType n);
+
+template <>
+ITKFFT_EXPORT std::shared_ptr<const VnlFFTCommon::BluesteinTables<float>>
+              VnlFFTCommon::GetBluesteinTables<float>(SizeValueType n, int dir);
+
+template <>
+ITKFFT_EXPORT std::shared_ptr<const VnlFFTCommon::BluesteinTables<double>>
+              VnlFFTCommon::GetBluesteinTables<double>(SizeValueType n, int dir);
 } // namespace itk
 
 #ifndef ITK_MANUAL_INSTANTIATION
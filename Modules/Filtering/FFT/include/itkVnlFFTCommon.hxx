@@ -20,6 +20,9 @@
 
 #include "itkVnlFFTCommon.h"
 
+#include "vnl/algo/vnl_fft.h"
+#include <algorithm>
+
 namespace itk
 {
 
@@ -41,11 +44,169 @@ VnlFFTCommon ::IsDimensionSizeLegal(TSizeValue n)
 }
 
 template <typename TImage>
-VnlFFTCommon::VnlFFTTransform<TImage>::VnlFFTTransform(const typename TImage::SizeType & s)
+VnlFFTCommon::VnlFFTTransform<TImage>::VnlFFTTransform(const SizeType & s, MultiThreaderBase * multiThreader)
+  : m_Size(s)
+  , m_MultiThreader(multiThreader)
+{}
+
+template <typename TImage>
+void
+VnlFFTCommon::VnlFFTTransform<TImage>::transform(std::complex<ValueType> * signal, int dir)
+{
+  DimensionsType dimensions;
+  dimensions.Fill(true);
+  this->transform(signal, dir, dimensions);
+}
+
+template <typename TImage>
+void
+VnlFFTCommon::VnlFFTTransform<TImage>::transform(std::complex<ValueType> * signal,
+                                                 int                       dir,
+                                                 const DimensionsType &    dimensions)
+{
+  // The lines are transformed by blocks of as many lines as gpfa transforms
+  // together, which are the units of work of the multithreader.
+  constexpr long blockSize = 128;
+
+  // Transform along the last dimension first, as vnl_fft_base did.
+  for (int i = TImage::ImageDimension - 1; i >= 0; --i)
+  {
+    if (!dimensions[i])
+    {
+      continue;
+    }
+
+    // The signal is seen as an image of size stride x size x count, to be
+    // transformed along the second dimension.
+    const auto size = static_cast<long>(m_Size[i]);
+    long       stride = 1;
+    long       count = 1;
+    for (int j = 0; j < static_cast<int>(TImage::ImageDimension); ++j)
+    {
+      if (j < i)
+      {
+        stride *= static_cast<long>(m_Size[j]);
+      }
+      else if (j > i)
+      {
+        count *= static_cast<long>(m_Size[j]);
+      }
+    }
+
+    std::shared_ptr<const vnl_fft_prime_factors<ValueType>> factors;
+    std::shared_ptr<const BluesteinTables<ValueType>>       bluestein;
+    if (IsDimensionSizeLegal(m_Size[i]))
+    {
+      factors = GetPrimeFactors<ValueType>(m_Size[i]);
+    }
+    else
+    {
+      bluestein = GetBluesteinTables<ValueType>(m_Size[i], dir);
+    }
+
+    // When the lines are along the first dimension, the blocks are made of
+    // consecutive lines of the whole signal.  Otherwise they are made of
+    // lines next to each other in memory, in a single slab of stride x size.
+    const long          inc = stride;
+    const long          jump = (stride == 1) ? size : 1;
+    const long          linesPerSlab = (stride == 1) ? count : stride;
+    const long          blocksPerSlab = (linesPerSlab + blockSize - 1) / blockSize;
+    const SizeValueType numberOfBlocks = (stride == 1) ? blocksPerSlab : count * blocksPerSlab;
+
+    const auto transformBlock = [&](SizeValueType block) {
+      const long slab = static_cast<long>(block) / blocksPerSlab;
+      const long firstLine = (static_cast<long>(block) % blocksPerSlab) * blockSize;
+      const long lot = std::min(blockSize, linesPerSlab - firstLine);
+      TransformLines(signal + slab * size * stride + firstLine * jump,
+                     inc,
+                     jump,
+                     size,
+                     lot,
+                     dir,
+                     factors.get(),
+                     bluestein.get());
+    };
+
+    if (m_MultiThreader != nullptr && numberOfBlocks > 1)
+    {
+      m_MultiThreader->ParallelizeArray(0, numberOfBlocks, transformBlock, nullptr);
+    }
+    else
+    {
+      for (SizeValueType block = 0; block < numberOfBlocks; ++block)
+      {
+        transformBlock(block);
+      }
+    }
+  }
+}
+
+template <typename TImage>
+void
+VnlFFTCommon::VnlFFTTransform<TImage>::TransformLines(std::complex<ValueType> *                data,
+                                                      long                                     inc,
+                                                      long                                     jump,
+                                                      long                                     n,
+                                                      long                                     lot,
+                                                      int                                      dir,
+                                                      const vnl_fft_prime_factors<ValueType> * factors,
+                                                      const BluesteinTables<ValueType> *       bluestein)
 {
-  for (unsigned int i = 0; i < TImage::ImageDimension; i++)
+  // This relies on std::complex<T> being layout compatible with
+  // "struct { T real; T imag; }", as vnl_fft_base does.
+  long info = 0;
+  if (bluestein == nullptr)
+  {
+    if (inc == 1)
+    {
+      // The lines whose elements are next to each other are transformed one
+      // at a time.
+      for (long l = 0; l < lot; ++l)
+      {
+        auto * line = reinterpret_cast<ValueType *>(data + l * jump);
+        vnl_fft_gpfa(line, line + 1, factors->trigs(), 2, 0, n, 1, dir, factors->pqr(), &info);
+      }
+    }
+    else
+    {
+      auto * lines = reinterpret_cast<ValueType *>(data);
+      vnl_fft_gpfa(lines, lines + 1, factors->trigs(), 2 * inc, 2 * jump, n, lot, dir, factors->pqr(), &info);
+    }
+    return;
+  }
+
+  // The lines multiplied by the chirp are padded with zeros, and interleaved
+  // so that they are transformed together.
+  const auto                               paddedSize = static_cast<long>(bluestein->PaddedSize);
+  const vnl_fft_prime_factors<ValueType> * paddedFactors = bluestein->PrimeFactors.get();
+  const std::complex<ValueType> *          chirp = bluestein->Chirp.data();
+  const std::complex<ValueType> *          transformedChirp = bluestein->TransformedChirp.data();
+  std::vector<std::complex<ValueType>>     work(paddedSize * lot);
+  for (long j = 0; j < n; ++j)
   {
-    Base::factors_[TImage::ImageDimension - i - 1].resize(s[i]);
+    for (long l = 0; l < lot; ++l)
+    {
+      work[j * lot + l] = data[j * inc + l * jump] * chirp[j];
+    }
+  }
+
+  auto * lines = reinterpret_cast<ValueType *>(work.data());
+  vnl_fft_gpfa(lines, lines + 1, paddedFactors->trigs(), 2 * lot, 2, paddedSize, lot, -1, paddedFactors->pqr(), &info);
+  for (long j = 0; j < paddedSize; ++j)
+  {
+    for (long l = 0; l < lot; ++l)
+    {
+      work[j * lot + l] *= transformedChirp[j];
+    }
+  }
+  vnl_fft_gpfa(lines, lines + 1, paddedFactors->trigs(), 2 * lot, 2, paddedSize, lot, 1, paddedFactors->pqr(), &info);
+
+  for (long j = 0; j < n; ++j)
+  {
+    for (long l = 0; l < lot; ++l)
+    {
+      data[j * inc + l * jump] = work[j * lot + l] * chirp[j];
+    }
   }
 }
 
@@ -30,9 +30,11 @@ namespace itk
  *
  * \brief VNL-based reverse Fast Fourier Transform.
  *
- * The input image size must be a multiple of combinations of 2s, 3s,
- * and/or 5s in all dimensions (2, 3, and 5 should be the only prime
- * factors of the image size along each dimension).
+ * The image size may be arbitrary, but the transform is fastest when
+ * 2, 3, and 5 are the only prime factors of the image size along each
+ * dimension. The other sizes are transformed with Bluestein's algorithm,
+ * which is several times slower. The lines of the image are transformed by
+ * the work units of the filter.
  *
  * \ingroup FourierTransform
  *
@@ -53,13 +53,6 @@ VnlInverseFFTImageFilter<TInputImage, TOutputImage>::GenerateData()
   unsigned int vectorSize = 1;
   for (unsigned int i = 0; i < ImageDimension; i++)
   {
-    if (!VnlFFTCommon::IsDimensionSizeLegal(outputSize[i]))
-    {
-      itkExceptionMacro(<< "Cannot compute FFT of image with size " << outputSize
-                        << ". VnlInverseFFTImageFilter operates "
-                        << "only on images whose size in each dimension has"
-                        << "only a combination of 2,3, and 5 as prime factors.");
-    }
     vectorSize *= outputSize[i];
   }
 
@@ -72,7 +65,8 @@ VnlInverseFFTImageFilter<TInputImage, TOutputImage>::GenerateData()
   OutputPixelType * out = outputPtr->GetBufferPointer();
 
   // call the proper transform, based on compile type template parameter
-  VnlFFTCommon::VnlFFTTransform<OutputImageType> vnlfft(outputSize);
+  this->GetMultiThreader()->SetNumberOfWorkUnits(this->GetNumberOfWorkUnits());
+  VnlFFTCommon::VnlFFTTransform<OutputImageType> vnlfft(outputSize, this->GetMultiThreader());
   vnlfft.transform(signal.data_block(), 1);
 
   // Copy the VNL output back to the ITK image.
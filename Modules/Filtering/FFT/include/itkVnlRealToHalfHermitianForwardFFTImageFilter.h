@@ -30,8 +30,11 @@ namespace itk
  *
  * \brief VNL-based forward Fast Fourier Transform.
  *
- * The input image size in all dimensions must have a prime
- * factorization consisting of 2s, 3s, and 5s.
+ * The image size may be arbitrary, but the transform is fastest when
+ * 2, 3, and 5 are the only prime factors of the image size along each
+ * dimension. The other sizes are transformed with Bluestein's algorithm,
+ * which is several times slower. The lines of the image are transformed by
+ * the work units of the filter.
  *
  * \ingroup FourierTransform
  *
@@ -50,13 +50,6 @@ VnlRealToHalfHermitianForwardFFTImageFilter<TInputImage, TOutputImage>::Generate
   unsigned int vectorSize = 1;
   for (unsigned int i = 0; i < ImageDimension; i++)
   {
-    if (!VnlFFTCommon::IsDimensionSizeLegal(inputSize[i]))
-    {
-      itkExceptionMacro(<< "Cannot compute FFT of image with size " << inputSize
-                        << ". VnlRealToHalfHermitianForwardFFTImageFilter operates "
-                        << "only on images whose size in each dimension has a prime "
-                        << "factorization consisting of only 2s, 3s, or 5s.");
-    }
     vectorSize *= inputSize[i];
   }
 
@@ -68,7 +61,8 @@ VnlRealToHalfHermitianForwardFFTImageFilter<TInputImage, TOutputImage>::Generate
   }
 
   // call the proper transform, based on compile type template parameter
-  VnlFFTCommon::VnlFFTTransform<InputImageType> vnlfft(inputSize);
+  this->GetMultiThreader()->SetNumberOfWorkUnits(this->GetNumberOfWorkUnits());
+  VnlFFTCommon::VnlFFTTransform<InputImageType> vnlfft(inputSize, this->GetMultiThreader());
   vnlfft.transform(signal.data_block(), -1);
 
   // Copy the VNL output back to the ITK image.
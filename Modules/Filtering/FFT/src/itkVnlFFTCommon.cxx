@@ -0,0 +1,145 @@
+/*=========================================================================
+ *
+ *  Copyright NumFOCUS
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#include "itkVnlFFTCommon.h"
+
+#include "itkMath.h"
+#include "vnl/algo/vnl_fft.h"
+#include <map>
+#include <mutex>
+#include <utility>
+
+namespace itk
+{
+namespace
+{
+template <typename TValue>
+std::shared_ptr<const vnl_fft_prime_factors<TValue>>
+GetCachedPrimeFactors(SizeValueType n)
+{
+  // The tables are only added to the cache, so the ones returned stay valid
+  // after the lock is released, and are read concurrently by the transforms.
+  static std::mutex                                                                   mutex;
+  static std::map<SizeValueType, std::shared_ptr<const vnl_fft_prime_factors<TValue>>> cache;
+
+  const std::lock_guard<std::mutex> lock(mutex);
+  auto &                            factors = cache[n];
+  if (!factors)
+  {
+    factors = std::make_shared<const vnl_fft_prime_factors<TValue>>(static_cast<int>(n));
+  }
+  return factors;
+}
+
+template <typename TValue>
+std::shared_ptr<const VnlFFTCommon::BluesteinTables<TValue>>
+ComputeBluesteinTables(SizeValueType n, int dir)
+{
+  // The circular convolution of size padded size is the linear convolution
+  // of the n samples with the 2 n - 1 samples of the conjugate chirp.
+  SizeValueType paddedSize = 2 * n - 1;
+  while (!VnlFFTCommon::IsDimensionSizeLegal(paddedSize))
+  {
+    ++paddedSize;
+  }
+
+  auto tables = std::make_shared<VnlFFTCommon::BluesteinTables<TValue>>();
+  tables->PaddedSize = paddedSize;
+  tables->PrimeFactors = VnlFFTCommon::GetPrimeFactors<TValue>(paddedSize);
+
+  // The tables are computed in double precision, with the chirp
+  // exp( dir i pi k^2 / n ) whose exponent is reduced modulo 2 n, so that its
+  // accuracy does not depend on the size.
+  std::vector<std::complex<double>> chirp(n);
+  for (SizeValueType k = 0; k < n; ++k)
+  {
+    const auto square = static_cast<double>((static_cast<unsigned long long>(k) * k) % (2 * n));
+    chirp[k] = std::polar(1.0, dir * Math::pi * square / static_cast<double>(n));
+  }
+
+  std::vector<std::complex<double>> conjugateChirp(paddedSize, std::complex<double>(0.0, 0.0));
+  conjugateChirp[0] = std::conj(chirp[0]);
+  for (SizeValueType k = 1; k < n; ++k)
+  {
+    conjugateChirp[k] = std::conj(chirp[k]);
+    conjugateChirp[paddedSize - k] = std::conj(chirp[k]);
+  }
+
+  const vnl_fft_prime_factors<double> factors(static_cast<int>(paddedSize));
+  auto *                              data = reinterpret_cast<double *>(conjugateChirp.data());
+  long                                info = 0;
+  vnl_fft_gpfa(data, data + 1, factors.trigs(), 2, 0, paddedSize, 1, -1, factors.pqr(), &info);
+
+  tables->Chirp.resize(n);
+  for (SizeValueType k = 0; k < n; ++k)
+  {
+    tables->Chirp[k] = std::complex<TValue>(chirp[k]);
+  }
+  tables->TransformedChirp.resize(paddedSize);
+  for (SizeValueType k = 0; k < paddedSize; ++k)
+  {
+    tables->TransformedChirp[k] = std::complex<TValue>(conjugateChirp[k] / static_cast<double>(paddedSize));
+  }
+  return tables;
+}
+
+template <typename TValue>
+std::shared_ptr<const VnlFFTCommon::BluesteinTables<TValue>>
+GetCachedBluesteinTables(SizeValueType n, int dir)
+{
+  using TablesPointer = std::shared_ptr<const VnlFFTCommon::BluesteinTables<TValue>>;
+  static std::mutex                                             mutex;
+  static std::map<std::pair<SizeValueType, int>, TablesPointer> cache;
+
+  const std::lock_guard<std::mutex> lock(mutex);
+  auto &                            tables = cache[std::make_pair(n, dir)];
+  if (!tables)
+  {
+    tables = ComputeBluesteinTables<TValue>(n, dir);
+  }
+  return tables;
+}
+} // end anonymous namespace
+
+template <>
+std::shared_ptr<const vnl_fft_prime_factors<float>>
+VnlFFTCommon::GetPrimeFactors<float>(SizeValueType n)
+{
+  return GetCachedPrimeFactors<float>(n);
+}
+
+template <>
+std::shared_ptr<const vnl_fft_prime_factors<double>>
+VnlFFTCommon::GetPrimeFactors<double>(SizeValueType n)
+{
+  return GetCachedPrimeFactors<double>(n);
+}
+
+template <>
+std::shared_ptr<const VnlFFTCommon::BluesteinTables<float>>
+VnlFFTCommon::GetBluesteinTables<float>(SizeValueType n, int dir)
+{
+  return GetCachedBluesteinTables<float>(n, dir);
+}
+
+template <>
+std::shared_ptr<const VnlFFTCommon::BluesteinTables<double>>
+VnlFFTCommon::GetBluesteinTables<double>(SizeValueType n, int dir)
+{
+  return GetCachedBluesteinTables<double>(n, dir);
+}
+} // end namespace itk
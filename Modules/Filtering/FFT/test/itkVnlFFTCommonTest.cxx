@@ -0,0 +1,223 @@
+/*=========================================================================
+ *
+ *  Copyright NumFOCUS
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include "itkImage.h"
+#include "itkMath.h"
+#include "itkMultiThreaderBase.h"
+#include "itkVnlFFTCommon.h"
+#include <iostream>
+#include <vector>
+
+namespace
+{
+// Direct computation of the discrete Fourier transform along the given
+// dimensions, in double precision
+template <typename TValue, unsigned int VDimension>
+std::vector<std::complex<double>>
+DirectTransform(const std::vector<std::complex<TValue>> & signal,
+                const itk::Size<VDimension> &             size,
+                int                                       dir,
+                const itk::FixedArray<bool, VDimension> & dimensions)
+{
+  std::vector<std::complex<double>> result(signal.begin(), signal.end());
+  for (unsigned int d = 0; d < VDimension; ++d)
+  {
+    if (!dimensions[d])
+    {
+      continue;
+    }
+    itk::SizeValueType stride = 1;
+    for (unsigned int j = 0; j < d; ++j)
+    {
+      stride *= size[j];
+    }
+    const itk::SizeValueType          n = size[d];
+    std::vector<std::complex<double>> line(n);
+    for (itk::SizeValueType start = 0; start < result.size(); ++start)
+    {
+      if ((start / stride) % n != 0)
+      {
+        continue;
+      }
+      for (itk::SizeValueType k = 0; k < n; ++k)
+      {
+        line[k] = 0.0;
+        for (itk::SizeValueType m = 0; m < n; ++m)
+        {
+          line[k] += result[start + m * stride] *
+                     std::polar(1.0, dir * 2.0 * itk::Math::pi * static_cast<double>((k * m) % n) / n);
+        }
+      }
+      for (itk::SizeValueType k = 0; k < n; ++k)
+      {
+        result[start + k * stride] = line[k];
+      }
+    }
+  }
+  return result;
+}
+
+template <typename TValue>
+std::vector<std::complex<TValue>>
+CreateSignal(itk::SizeValueType numberOfElements)
+{
+  std::vector<std::complex<TValue>> signal(numberOfElements);
+  unsigned int                      state = 1234;
+  for (auto & value : signal)
+  {
+    state = state * 1103515245u + 12345u;
+    const auto real = static_cast<TValue>((state >> 16) % 1000) / 100;
+    state = state * 1103515245u + 12345u;
+    value = std::complex<TValue>(real, static_cast<TValue>((state >> 16) % 1000) / 100 - 5);
+  }
+  return signal;
+}
+
+template <typename TValue, typename TReference>
+bool
+CompareSignals(const std::vector<std::complex<TValue>> &     signal,
+               const std::vector<std::complex<TReference>> & reference,
+               double                                        tolerance,
+               const std::string &                           description)
+{
+  double largestMagnitude = 0.0;
+  double largestDifference = 0.0;
+  for (size_t i = 0; i < signal.size(); ++i)
+  {
+    const std::complex<double> value(signal[i].real(), signal[i].imag());
+    const std::complex<double> referenceValue(reference[i].real(), reference[i].imag());
+    largestMagnitude = std::max(largestMagnitude, std::abs(referenceValue));
+    largestDifference = std::max(largestDifference, std::abs(value - referenceValue));
+  }
+  if (largestDifference > tolerance * largestMagnitude)
+  {
+    std::cerr << "Test failed for " << description << std::endl;
+    std::cerr << "Largest difference " << largestDifference << " for a largest magnitude " << largestMagnitude
+              << std::endl;
+    return false;
+  }
+  return true;
+}
+
+// Compares the transforms along all the dimensions, and along some of them
+// only, in both directions, with the direct computation, the transforms
+// computed by several work units with the ones computed by a single one, and
+// the transform of a stack of images with the transforms of each image
+template <typename TValue>
+bool
+CheckTransforms(const itk::Size<3> & size, double tolerance, const std::string & description)
+{
+  using VolumeType = itk::Image<TValue, 3>;
+  using SliceType = itk::Image<TValue, 2>;
+  using VolumeTransformType = itk::VnlFFTCommon::VnlFFTTransform<VolumeType>;
+  using SliceTransformType = itk::VnlFFTCommon::VnlFFTTransform<SliceType>;
+  using DimensionsType = typename VolumeTransformType::DimensionsType;
+
+  bool passed = true;
+
+  const itk::SizeValueType numberOfElements = size[0] * size[1] * size[2];
+  VolumeTransformType      transform(size);
+  for (int dir : { -1, 1 })
+  {
+    const std::string name = description + (dir == -1 ? ", forward" : ", inverse");
+
+    std::vector<std::complex<TValue>> signal = CreateSignal<TValue>(numberOfElements);
+    const auto reference = DirectTransform<TValue, 3>(signal, size, dir, DimensionsType(true));
+    transform.transform(signal.data(), dir);
+    passed &= CompareSignals(signal, reference, tolerance, name);
+
+    for (const DimensionsType & dimensions :
+         { DimensionsType(false), DimensionsType{ { true, false, false } }, DimensionsType{ { false, true, true } } })
+    {
+      signal = CreateSignal<TValue>(numberOfElements);
+      const auto partialReference = DirectTransform<TValue, 3>(signal, size, dir, dimensions);
+      transform.transform(signal.data(), dir, dimensions);
+      passed &= CompareSignals(signal, partialReference, tolerance, name + ", some dimensions");
+    }
+  }
+
+  itk::MultiThreaderBase::Pointer multiThreader = itk::MultiThreaderBase::New();
+  multiThreader->SetNumberOfWorkUnits(5);
+  VolumeTransformType               threadedTransform(size, multiThreader);
+  std::vector<std::complex<TValue>> serial = CreateSignal<TValue>(numberOfElements);
+  std::vector<std::complex<TValue>> threaded = serial;
+  transform.transform(serial.data(), 1);
+  threadedTransform.transform(threaded.data(), 1);
+  passed &= CompareSignals(threaded, serial, 0.0, description + ", several work units");
+
+  // A stack of 7 images, which is not transformed along the stack
+  const typename VolumeType::SizeType stackSize = { { 16, 15, 7 } };
+  const typename SliceType::SizeType  sliceSize = { { 16, 15 } };
+  const itk::SizeValueType            numberOfSliceElements = sliceSize[0] * sliceSize[1];
+  std::vector<std::complex<TValue>>   stack = CreateSignal<TValue>(numberOfSliceElements * stackSize[2]);
+  std::vector<std::complex<TValue>>   slices = stack;
+
+  VolumeTransformType stackTransform(stackSize);
+  stackTransform.transform(stack.data(), -1, DimensionsType{ { true, true, false } });
+  SliceTransformType sliceTransform(sliceSize);
+  for (itk::SizeValueType i = 0; i < stackSize[2]; ++i)
+  {
+    sliceTransform.transform(slices.data() + i * numberOfSliceElements, -1);
+  }
+  passed &= CompareSignals(stack, slices, 0.0, description + ", stack of images");
+
+  return passed;
+}
+} // namespace
+
+// Checks the transforms of the Vnl FFT filters along all the dimensions of
+// an image or some of them only, for sizes whose only prime factors are 2, 3
+// and 5 and other sizes, and that the tables of their sizes are shared.
+int
+itkVnlFFTCommonTest(int, char *[])
+{
+  bool passed = true;
+
+  const auto factors = itk::VnlFFTCommon::GetPrimeFactors<double>(60);
+  if (factors != itk::VnlFFTCommon::GetPrimeFactors<double>(60) || factors->number() != 60 ||
+      factors == itk::VnlFFTCommon::GetPrimeFactors<double>(48) ||
+      itk::VnlFFTCommon::GetPrimeFactors<float>(60)->number() != 60)
+  {
+    std::cerr << "Test failed: the tables of the sizes are not shared" << std::endl;
+    passed = false;
+  }
+
+  const auto tables = itk::VnlFFTCommon::GetBluesteinTables<double>(7, -1);
+  if (tables != itk::VnlFFTCommon::GetBluesteinTables<double>(7, -1) ||
+      tables == itk::VnlFFTCommon::GetBluesteinTables<double>(7, 1) || tables->PaddedSize != 15 ||
+      !itk::VnlFFTCommon::IsDimensionSizeLegal(tables->PrimeFactors->number()))
+  {
+    std::cerr << "Test failed: the Bluestein tables of the sizes are not shared" << std::endl;
+    passed = false;
+  }
+
+  const itk::Size<3> legalSize = { { 12, 10, 9 } };
+  passed &= CheckTransforms<double>(legalSize, 1e-12, "double");
+  passed &= CheckTransforms<float>(legalSize, 1e-5, "float");
+
+  // Sizes which are transformed with Bluestein's algorithm, and a line long
+  // enough for its chirp to be computed accurately
+  const itk::Size<3> otherSize = { { 11, 14, 13 } };
+  passed &= CheckTransforms<double>(otherSize, 1e-12, "double, other sizes");
+  passed &= CheckTransforms<float>(otherSize, 1e-5, "float, other sizes");
+  const itk::Size<3> lineSize = { { 1021, 1, 1 } };
+  passed &= CheckTransforms<double>(lineSize, 1e-12, "double, long line");
+
+  std::cout << "Test finished." << std::endl;
+  return passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -22,6 +22,8 @@
 #include "itkIntTypes.h"
 #include "itkFastMarchingStoppingCriterionBase.h"
 #include "itkFastMarchingTraits.h"
+#include "itkFastMarchingUntidyPriorityQueue.h"
+#include "itkProgressReporter.h"
 #include "ITKFastMarchingExport.h"
 
 #include <queue>
@@ -46,10 +48,27 @@ public:
     NoHandles,
     Strict
   };
+
+  /**
+   *\class PropagationEngine
+   * \ingroup ITKFastMarching
+   * Algorithm used to propagate the front.
+   * */
+  enum class PropagationEngine : uint8_t
+  {
+    /** Nodes are processed in increasing order using a binary heap. */
+    BinaryHeap = 0,
+    /** Nodes are processed in bucketed order using an untidy priority queue. */
+    UntidyPriorityQueue,
+    /** Nodes are updated iteratively and in parallel, by blocks. */
+    FastIterativeMethod
+  };
 };
 // Define how to print enumeration
 extern ITKFastMarching_EXPORT std::ostream &
                               operator<<(std::ostream & out, const FastMarchingTraitsEnums::TopologyCheck value);
+extern ITKFastMarching_EXPORT std::ostream &
+                              operator<<(std::ostream & out, const FastMarchingTraitsEnums::PropagationEngine value);
 
 /**
  * \class FastMarchingBase
@@ -62,13 +81,26 @@ extern ITKFastMarching_EXPORT std::ostream &
  * front forward one node at a time.
  *
  * Updates are performed using an entropy satisfy scheme where only
- * "upwind" neighborhoods are used. This implementation of Fast Marching
- * uses a std::priority_queue to locate the next proper node to
+ * "upwind" neighborhoods are used. By default, this implementation of Fast
+ * Marching uses a std::priority_queue to locate the next proper node to
  * update.
  *
  * Fast Marching sweeps through N points in (N log N) steps to obtain
  * the arrival time value as the front propagates through the domain.
  *
+ * \par Propagation engines:
+ * The PropagationEngine selects how the nodes are ordered:
+ * \li BinaryHeap (default): exact ordering, O(N log N).
+ * \li UntidyPriorityQueue: nodes are bucketed according to their value, see
+ * FastMarchingUntidyPriorityQueue. The ordering is exact up to the
+ * BucketWidth, and the propagation is O(N).
+ * \li FastIterativeMethod: the arrival times are computed in parallel by
+ * iterative updates, and the nodes are then visited in increasing order.
+ * It is only available for images, see FastMarchingImageFilterBase.
+ *
+ * The stopping criterion, the alive, trial, forbidden and processed points
+ * are used the same way by all the engines.
+ *
  * The initial front is specified by two containers:
  * \li one containing the known nodes (Alive Nodes: nodes that are already
  * part of the object),
@@ -176,6 +208,7 @@ public:
   */
 
   using TopologyCheckEnum = FastMarchingTraitsEnums::TopologyCheck;
+  using PropagationEngineEnum = FastMarchingTraitsEnums::PropagationEngine;
 #if !defined(ITK_LEGACY_REMOVE)
   using TopologyCheckType = FastMarchingTraitsEnums::TopologyCheck;
   /**Exposes enums values for backwards compatibility*/
@@ -189,6 +222,17 @@ public:
   itkSetEnumMacro(TopologyCheck, TopologyCheckEnum);
   itkGetConstReferenceMacro(TopologyCheck, TopologyCheckEnum);
 
+  /** Set/Get the algorithm used to propagate the front. Default is
+   * BinaryHeap. */
+  itkSetEnumMacro(PropagationEngine, PropagationEngineEnum);
+  itkGetConstReferenceMacro(PropagationEngine, PropagationEngineEnum);
+
+  /** Set/Get the width of the buckets used by the UntidyPriorityQueue
+   * engine. When it is not strictly positive (default), the width is
+   * computed by ComputeDefaultBucketWidth(). */
+  itkSetMacro(BucketWidth, double);
+  itkGetConstMacro(BucketWidth, double);
+
   /** Set/Get TrialPoints */
   itkSetObjectMacro(TrialPoints, NodePairContainerType);
   itkGetModifiableObjectMacro(TrialPoints, NodePairContainerType);
@@ -262,8 +306,43 @@ protected:
 
   PriorityQueueType m_Heap;
 
+  using UntidyPriorityQueueType = FastMarchingUntidyPriorityQueue<NodePairType>;
+
+  UntidyPriorityQueueType m_UntidyQueue;
+
   TopologyCheckEnum m_TopologyCheck;
 
+  PropagationEngineEnum m_PropagationEngine{ PropagationEngineEnum::BinaryHeap };
+
+  double m_BucketWidth{ 0.0 };
+
+  /** \brief Insert a node pair in the queue of the propagation engine */
+  void
+  PushNodePair(const NodePairType & iNodePair)
+  {
+    switch (m_PropagationEngine)
+    {
+      case PropagationEngineEnum::UntidyPriorityQueue:
+        m_UntidyQueue.push(iNodePair);
+        break;
+      case PropagationEngineEnum::FastIterativeMethod:
+        // Nodes are not ordered while the front propagates
+        break;
+      default:
+        m_Heap.push(iNodePair);
+    }
+  }
+
+  /** \brief Remove all the node pairs from the queues and release memory */
+  void
+  ReleaseNodePairs();
+
+  /** \brief Get the bucket width used by the UntidyPriorityQueue engine when
+   * BucketWidth is not set. It should not exceed the lowest difference between
+   * the values of two neighbor nodes. Default is 1. */
+  virtual double
+  ComputeDefaultBucketWidth() const;
+
   /** \brief Get the total number of nodes in the domain */
   virtual IdentifierType
   GetTotalNumberOfNodes() const = 0;
@@ -321,6 +400,12 @@ protected:
   void
   GenerateData() override;
 
+  /** \brief Propagate the front using the given queue, and return the value
+   * reached by the front. */
+  template <typename TQueue>
+  OutputPixelType
+  PropagateFront(OutputDomainType * oDomain, TQueue & ioQueue, ProgressReporter & ioProgress);
+
   /** \brief PrintSelf method  */
   void
   PrintSelf(std::ostream & os, Indent indent) const override;
@@ -23,7 +23,6 @@
 
 #include "itkProgressReporter.h"
 #include "itkMath.h"
-#include "itkMath.h"
 
 namespace itk
 {
@@ -58,6 +57,8 @@ FastMarchingBase<TInput, TOutput>::PrintSelf(std::ostream & os, Indent indent) c
   Superclass::PrintSelf(os, indent);
   os << indent << "Speed constant: " << m_SpeedConstant << std::endl;
   os << indent << "Topology check: " << m_TopologyCheck << std::endl;
+  os << indent << "Propagation engine: " << m_PropagationEngine << std::endl;
+  os << indent << "Bucket width: " << m_BucketWidth << std::endl;
   os << indent << "Normalization Factor: " << m_NormalizationFactor << std::endl;
 }
 
@@ -92,17 +93,18 @@ FastMarchingBase<TInput, TOutput>::Initialize(OutputDomainType * oDomain)
     }
   }
 
-  // make sure the heap is empty
-  while (!m_Heap.empty())
+  // make sure the queues are empty
+  this->ReleaseNodePairs();
+
+  if (m_PropagationEngine == PropagationEngineEnum::UntidyPriorityQueue)
   {
-    m_Heap.pop();
-  }
-  /*
-  while ( !m_Heap->Empty() )
+    const double bucketWidth = (m_BucketWidth > 0.0) ? m_BucketWidth : this->ComputeDefaultBucketWidth();
+    if (!(bucketWidth > 0.0))
     {
-    m_Heap->Pop();
+      itkExceptionMacro(<< "Bucket width is null or negative");
     }
-  */
+    m_UntidyQueue.SetBucketWidth(bucketWidth);
+  }
 
   this->InitializeOutput(oDomain);
 
@@ -112,6 +114,25 @@ FastMarchingBase<TInput, TOutput>::Initialize(OutputDomainType * oDomain)
 }
 // -----------------------------------------------------------------------------
 
+// -----------------------------------------------------------------------------
+template <typename TInput, typename TOutput>
+void
+FastMarchingBase<TInput, TOutput>::ReleaseNodePairs()
+{
+  PriorityQueueType().swap(m_Heap);
+  m_UntidyQueue.release();
+}
+// -----------------------------------------------------------------------------
+
+// -----------------------------------------------------------------------------
+template <typename TInput, typename TOutput>
+double
+FastMarchingBase<TInput, TOutput>::ComputeDefaultBucketWidth() const
+{
+  return 1.0;
+}
+// -----------------------------------------------------------------------------
+
 // -----------------------------------------------------------------------------
 template <typename TInput, typename TOutput>
 void
@@ -121,58 +142,21 @@ FastMarchingBase<TInput, TOutput>::GenerateData()
 
   Initialize(output);
 
-  OutputPixelType current_value = 0.;
-
   ProgressReporter progress(this, 0, this->GetTotalNumberOfNodes());
 
   m_StoppingCriterion->Reinitialize();
 
+  OutputPixelType current_value = 0.;
+
   try
   {
-    // while( !m_Heap->Empty() )
-    while (!m_Heap.empty())
+    if (m_PropagationEngine == PropagationEngineEnum::UntidyPriorityQueue)
     {
-      // PriorityQueueElementType element = m_Heap->Peek();
-      // m_Heap->Pop();
-      //
-      // NodeType current_node = element.m_Element;
-      // OutputPixelType current_value = element.m_Priority;
-
-
-      NodePairType current_node_pair = m_Heap.top();
-      m_Heap.pop();
-
-      NodeType current_node = current_node_pair.GetNode();
-      current_value = this->GetOutputValue(output, current_node);
-
-      if (Math::ExactlyEquals(current_value, current_node_pair.GetValue()))
-      {
-        // is this node already alive ?
-        if (this->GetLabelValueForGivenNode(current_node) != Traits::Alive)
-        {
-          m_StoppingCriterion->SetCurrentNodePair(current_node_pair);
-
-          if (m_StoppingCriterion->IsSatisfied())
-          {
-            break;
-          }
-
-          if (this->CheckTopology(output, current_node))
-          {
-            if (m_CollectPoints)
-            {
-              m_ProcessedPoints->push_back(current_node_pair);
-            }
-
-            // set this node as alive
-            this->SetLabelValueForGivenNode(current_node, Traits::Alive);
-
-            // update its neighbors
-            this->UpdateNeighbors(output, current_node);
-          }
-        }
-        progress.CompletedPixel();
-      }
+      current_value = this->PropagateFront(output, m_UntidyQueue, progress);
+    }
+    else
+    {
+      current_value = this->PropagateFront(output, m_Heap, progress);
     }
   }
   catch (ProcessAborted &)
@@ -183,14 +167,7 @@ FastMarchingBase<TInput, TOutput>::GenerateData()
     // it.
     //
     // RELEASE MEMORY!!!
-    while (!m_Heap.empty())
-    {
-      m_Heap.pop();
-    }
-    /*while( !m_Heap->Empty() )
-      {
-      m_Heap->Pop();
-      }*/
+    this->ReleaseNodePairs();
 
     throw ProcessAborted(__FILE__, __LINE__);
   }
@@ -198,14 +175,59 @@ FastMarchingBase<TInput, TOutput>::GenerateData()
   m_TargetReachedValue = current_value;
 
   // let's release some useless memory...
-  while (!m_Heap.empty())
+  this->ReleaseNodePairs();
+}
+// -----------------------------------------------------------------------------
+
+// -----------------------------------------------------------------------------
+template <typename TInput, typename TOutput>
+template <typename TQueue>
+typename FastMarchingBase<TInput, TOutput>::OutputPixelType
+FastMarchingBase<TInput, TOutput>::PropagateFront(OutputDomainType * oDomain,
+                                                  TQueue &           ioQueue,
+                                                  ProgressReporter & ioProgress)
+{
+  OutputPixelType current_value = 0.;
+
+  while (!ioQueue.empty())
   {
-    m_Heap.pop();
-  }
-  /*while( !m_Heap->Empty() )
+    NodePairType current_node_pair = ioQueue.top();
+    ioQueue.pop();
+
+    NodeType current_node = current_node_pair.GetNode();
+    current_value = this->GetOutputValue(oDomain, current_node);
+
+    if (Math::ExactlyEquals(current_value, current_node_pair.GetValue()))
     {
-    m_Heap->Pop();
-    }*/
+      // is this node already alive ?
+      if (this->GetLabelValueForGivenNode(current_node) != Traits::Alive)
+      {
+        m_StoppingCriterion->SetCurrentNodePair(current_node_pair);
+
+        if (m_StoppingCriterion->IsSatisfied())
+        {
+          break;
+        }
+
+        if (this->CheckTopology(oDomain, current_node))
+        {
+          if (m_CollectPoints)
+          {
+            m_ProcessedPoints->push_back(current_node_pair);
+          }
+
+          // set this node as alive
+          this->SetLabelValueForGivenNode(current_node, Traits::Alive);
+
+          // update its neighbors
+          this->UpdateNeighbors(oDomain, current_node);
+        }
+      }
+      ioProgress.CompletedPixel();
+    }
+  }
+
+  return current_value;
 }
 // -----------------------------------------------------------------------------
 
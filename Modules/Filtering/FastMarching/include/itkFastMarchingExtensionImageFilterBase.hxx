@@ -113,6 +113,11 @@ FastMarchingExtensionImageFilterBase<TInput, TOutput, TAuxValue, VAuxDimension>:
 {
   this->Superclass::InitializeOutput(oImage);
 
+  if (this->m_PropagationEngine == Superclass::PropagationEngineEnum::FastIterativeMethod)
+  {
+    itkExceptionMacro(<< "in Initialize(): Extension requires an ordered propagation engine");
+  }
+
   if (!m_AuxiliaryAliveValues)
   {
     itkExceptionMacro(<< "in Initialize(): Null pointer for AuxAliveValues");
@@ -230,7 +235,7 @@ FastMarchingExtensionImageFilterBase<TInput, TOutput, TAuxValue, VAuxDimension>:
     // node.SetValue( outputPixel );
     // node.SetIndex( index );
     // m_TrialHeap.push(node);
-    this->m_Heap.push(NodePairType(iNode, outputPixel));
+    this->PushNodePair(NodePairType(iNode, outputPixel));
 
     // update auxiliary values
     for (unsigned int k = 0; k < AuxDimension; k++)
@@ -63,6 +63,23 @@ namespace itk
  *
  * For an alternative implementation, see itk::FastMarchingImageFilter.
  *
+ * \par Fast iterative method:
+ * When the PropagationEngine is FastIterativeMethod, the image is split in
+ * blocks, and the active blocks are updated in parallel until the arrival
+ * times converge. The blocks are processed in two passes, such that
+ * neighbor blocks are never updated at the same time. Nodes are updated
+ * using the same upwind scheme as the fast marching method, but from all
+ * their neighbors instead of only the alive ones. Once converged, the nodes
+ * are visited in increasing arrival time order to evaluate the stopping
+ * criterion, to collect the processed points and to label the alive nodes.
+ * The nodes beyond the one satisfying the stopping criterion are reset to
+ * the large value. Since the whole reachable domain is computed, this engine
+ * is best suited for stopping criteria which are satisfied late, and it does
+ * not support topology checks.
+ *
+ * See W.-K. Jeong and R. T. Whitaker, "A Fast Iterative Method for Eikonal
+ * Equations", SIAM Journal on Scientific Computing, 30(5):2512-2534, 2008.
+ *
  * \tparam TTraits traits
  *
  * \sa FastMarchingImageFilter
@@ -181,6 +198,22 @@ protected:
   void
   GenerateOutputInformation() override;
 
+  void
+  GenerateData() override;
+
+  /** Compute the arrival times with the fast iterative method. */
+  void
+  GenerateDataUsingFastIterativeMethod();
+
+  /** Update the arrival times of a block of the output until they do not
+   * change anymore, and return true if they changed significantly. */
+  bool
+  UpdateBlockUsingFastIterativeMethod(OutputImageType * oImage, const OutputRegionType & iBlock) const;
+
+  /** The bucket width is the lowest spacing divided by the highest speed. */
+  double
+  ComputeDefaultBucketWidth() const override;
+
   void
   EnlargeOutputRequestedRegion(DataObject * output) override;
 
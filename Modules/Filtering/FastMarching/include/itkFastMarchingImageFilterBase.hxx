@@ -22,9 +22,13 @@
 #include "itkFastMarchingImageFilterBase.h"
 
 #include "itkImageRegionIterator.h"
+#include "itkImageRegionConstIteratorWithIndex.h"
 #include "itkConnectedComponentImageFilter.h"
 #include "itkRelabelComponentImageFilter.h"
 
+#include <algorithm>
+#include <cmath>
+
 namespace itk
 {
 
@@ -107,6 +111,351 @@ FastMarchingImageFilterBase<TInput, TOutput>::EnlargeOutputRequestedRegion(DataO
   }
 }
 
+template <typename TInput, typename TOutput>
+void
+FastMarchingImageFilterBase<TInput, TOutput>::GenerateData()
+{
+  if (this->m_PropagationEngine == Superclass::PropagationEngineEnum::FastIterativeMethod)
+  {
+    this->GenerateDataUsingFastIterativeMethod();
+  }
+  else
+  {
+    Superclass::GenerateData();
+  }
+}
+
+template <typename TInput, typename TOutput>
+double
+FastMarchingImageFilterBase<TInput, TOutput>::ComputeDefaultBucketWidth() const
+{
+  const OutputSpacingType & spacing = this->GetOutput()->GetSpacing();
+
+  double width = spacing[0];
+  for (unsigned int d = 1; d < ImageDimension; ++d)
+  {
+    width = std::min(width, static_cast<double>(spacing[d]));
+  }
+
+  const InputImageType * input = this->GetInput();
+  if (input)
+  {
+    // The speed is the input value divided by the normalization factor
+    InputPixelType maximum = NumericTraits<InputPixelType>::NonpositiveMin();
+
+    ImageRegionConstIterator<InputImageType> it(input, input->GetBufferedRegion());
+    for (it.GoToBegin(); !it.IsAtEnd(); ++it)
+    {
+      maximum = std::max(maximum, it.Get());
+    }
+
+    const double maximumSpeed = static_cast<double>(maximum) / this->m_NormalizationFactor;
+    if (maximumSpeed > 0.0)
+    {
+      width /= maximumSpeed;
+    }
+  }
+  return width;
+}
+
+template <typename TInput, typename TOutput>
+void
+FastMarchingImageFilterBase<TInput, TOutput>::GenerateDataUsingFastIterativeMethod()
+{
+  if (this->m_TopologyCheck != Superclass::TopologyCheckEnum::Nothing)
+  {
+    itkExceptionMacro(<< "Topology checks are not supported by the fast iterative method");
+  }
+
+  OutputImageType * output = this->GetOutput();
+
+  this->Initialize(output);
+
+  this->m_StoppingCriterion->Reinitialize();
+
+  // Split the buffered region in blocks of about 4096 nodes
+  using NodeIndexValueType = typename NodeType::IndexValueType;
+  const auto blockLength =
+    std::max(static_cast<SizeValueType>(std::lround(std::pow(4096.0, 1.0 / ImageDimension))), SizeValueType{ 2 });
+
+  const OutputSizeType & bufferedSize = m_BufferedRegion.GetSize();
+  OutputSizeType         numberOfBlocksPerAxis;
+  SizeValueType          numberOfBlocks = 1;
+  for (unsigned int d = 0; d < ImageDimension; ++d)
+  {
+    numberOfBlocksPerAxis[d] = (bufferedSize[d] + blockLength - 1) / blockLength;
+    numberOfBlocks *= numberOfBlocksPerAxis[d];
+  }
+
+  const auto getBlockIndex = [&numberOfBlocksPerAxis](SizeValueType blockId) {
+    NodeType blockIndex;
+    for (unsigned int d = 0; d < ImageDimension; ++d)
+    {
+      blockIndex[d] = static_cast<NodeIndexValueType>(blockId % numberOfBlocksPerAxis[d]);
+      blockId /= numberOfBlocksPerAxis[d];
+    }
+    return blockIndex;
+  };
+  const auto getBlockId = [&numberOfBlocksPerAxis](const NodeType & blockIndex) {
+    SizeValueType blockId = 0;
+    for (unsigned int d = ImageDimension; d > 0; --d)
+    {
+      blockId = blockId * numberOfBlocksPerAxis[d - 1] + static_cast<SizeValueType>(blockIndex[d - 1]);
+    }
+    return blockId;
+  };
+  const auto getBlockRegion = [this, blockLength](const NodeType & blockIndex) {
+    OutputRegionType block;
+    for (unsigned int d = 0; d < ImageDimension; ++d)
+    {
+      const NodeIndexValueType start = m_StartIndex[d] + blockIndex[d] * static_cast<NodeIndexValueType>(blockLength);
+      block.SetIndex(d, start);
+      block.SetSize(d, std::min(blockLength, static_cast<SizeValueType>(m_LastIndex[d] - start + 1)));
+    }
+    return block;
+  };
+
+  std::vector<unsigned char> isActive(numberOfBlocks, 0);
+  std::vector<unsigned char> hasChanged(numberOfBlocks, 0);
+
+  const auto activateBlockAndNeighbors = [&](const NodeType & blockIndex) {
+    isActive[getBlockId(blockIndex)] = 1;
+
+    NodeType neighborIndex = blockIndex;
+    for (unsigned int d = 0; d < ImageDimension; ++d)
+    {
+      if (blockIndex[d] > 0)
+      {
+        neighborIndex[d] = blockIndex[d] - 1;
+        isActive[getBlockId(neighborIndex)] = 1;
+      }
+      if (blockIndex[d] + 1 < static_cast<NodeIndexValueType>(numberOfBlocksPerAxis[d]))
+      {
+        neighborIndex[d] = blockIndex[d] + 1;
+        isActive[getBlockId(neighborIndex)] = 1;
+      }
+      neighborIndex[d] = blockIndex[d];
+    }
+  };
+
+  // The front starts from the blocks of the alive and trial points
+  for (const auto & points : { this->m_AlivePoints, this->m_TrialPoints })
+  {
+    if (points)
+    {
+      for (NodePairContainerConstIterator pointsIter = points->Begin(); pointsIter != points->End(); ++pointsIter)
+      {
+        const NodeType & node = pointsIter->Value().GetNode();
+        if (m_BufferedRegion.IsInside(node))
+        {
+          NodeType blockIndex;
+          for (unsigned int d = 0; d < ImageDimension; ++d)
+          {
+            blockIndex[d] = (node[d] - m_StartIndex[d]) / static_cast<NodeIndexValueType>(blockLength);
+          }
+          activateBlockAndNeighbors(blockIndex);
+        }
+      }
+    }
+  }
+
+  // Update the active blocks until convergence. Blocks are split in two sets
+  // such that neighbor blocks are never updated concurrently.
+  std::vector<SizeValueType> activeBlocks;
+  std::vector<SizeValueType> updatedBlocks;
+  for (SizeValueType blockId = 0; blockId < numberOfBlocks; ++blockId)
+  {
+    if (isActive[blockId])
+    {
+      activeBlocks.push_back(blockId);
+    }
+  }
+
+  while (!activeBlocks.empty())
+  {
+    for (unsigned int parity = 0; parity < 2; ++parity)
+    {
+      updatedBlocks.clear();
+      for (const SizeValueType blockId : activeBlocks)
+      {
+        const NodeType blockIndex = getBlockIndex(blockId);
+        NodeIndexValueType sum = 0;
+        for (unsigned int d = 0; d < ImageDimension; ++d)
+        {
+          sum += blockIndex[d];
+        }
+        if (static_cast<unsigned int>(sum % 2) == parity)
+        {
+          updatedBlocks.push_back(blockId);
+        }
+      }
+
+      this->GetMultiThreader()->ParallelizeArray(
+        0,
+        updatedBlocks.size(),
+        [&](SizeValueType i) {
+          const SizeValueType blockId = updatedBlocks[i];
+          hasChanged[blockId] =
+            this->UpdateBlockUsingFastIterativeMethod(output, getBlockRegion(getBlockIndex(blockId)));
+        },
+        nullptr);
+    }
+
+    if (this->GetAbortGenerateData())
+    {
+      throw ProcessAborted(__FILE__, __LINE__);
+    }
+
+    // Blocks which changed, and their neighbors, are updated again
+    std::fill(isActive.begin(), isActive.end(), 0);
+    for (const SizeValueType blockId : activeBlocks)
+    {
+      if (hasChanged[blockId])
+      {
+        activateBlockAndNeighbors(getBlockIndex(blockId));
+        hasChanged[blockId] = 0;
+      }
+    }
+
+    activeBlocks.clear();
+    for (SizeValueType blockId = 0; blockId < numberOfBlocks; ++blockId)
+    {
+      if (isActive[blockId])
+      {
+        activeBlocks.push_back(blockId);
+      }
+    }
+  }
+
+  // Visit the nodes in increasing order to apply the stopping criterion
+  std::vector<NodePairType> nodePairs;
+
+  ImageRegionConstIteratorWithIndex<OutputImageType> outputIt(output, m_BufferedRegion);
+  ImageRegionConstIterator<LabelImageType>           labelIt(m_LabelImage, m_BufferedRegion);
+  for (; !outputIt.IsAtEnd(); ++outputIt, ++labelIt)
+  {
+    const unsigned char label = labelIt.Get();
+    if ((label == Traits::Far || label == Traits::InitialTrial) && outputIt.Get() < this->m_LargeValue)
+    {
+      nodePairs.push_back(NodePairType(outputIt.GetIndex(), outputIt.Get()));
+    }
+  }
+  std::sort(nodePairs.begin(), nodePairs.end());
+
+  ProgressReporter progress(this, 0, nodePairs.size());
+
+  OutputPixelType current_value = 0.;
+
+  auto nodePairIt = nodePairs.cbegin();
+  for (; nodePairIt != nodePairs.cend(); ++nodePairIt)
+  {
+    current_value = nodePairIt->GetValue();
+
+    this->m_StoppingCriterion->SetCurrentNodePair(*nodePairIt);
+
+    if (this->m_StoppingCriterion->IsSatisfied())
+    {
+      break;
+    }
+
+    if (this->m_CollectPoints)
+    {
+      this->m_ProcessedPoints->push_back(*nodePairIt);
+    }
+
+    this->SetLabelValueForGivenNode(nodePairIt->GetNode(), Traits::Alive);
+
+    progress.CompletedPixel();
+  }
+
+  // The nodes beyond the stopping point have not been reached
+  for (; nodePairIt != nodePairs.cend(); ++nodePairIt)
+  {
+    if (this->GetLabelValueForGivenNode(nodePairIt->GetNode()) == Traits::Far)
+    {
+      this->SetOutputValue(output, nodePairIt->GetNode(), this->m_LargeValue);
+    }
+  }
+
+  this->m_TargetReachedValue = current_value;
+}
+
+template <typename TInput, typename TOutput>
+bool
+FastMarchingImageFilterBase<TInput, TOutput>::UpdateBlockUsingFastIterativeMethod(OutputImageType *        oImage,
+                                                                                  const OutputRegionType & iBlock) const
+{
+  const OffsetValueType * offsetTable = oImage->GetOffsetTable();
+  OutputPixelType *       values = oImage->GetBufferPointer();
+  const unsigned char *   labels = m_LabelImage->GetBufferPointer();
+
+  // Relative change of the arrival time below which a node has converged
+  constexpr double tolerance = 1e-6;
+
+  bool hasChanged = false;
+  bool hasConverged = false;
+
+  while (!hasConverged)
+  {
+    hasConverged = true;
+
+    ImageRegionConstIteratorWithIndex<LabelImageType> it(m_LabelImage, iBlock);
+    for (; !it.IsAtEnd(); ++it)
+    {
+      // Alive, initial trial and forbidden nodes are fixed
+      if (it.Get() != Traits::Far)
+      {
+        continue;
+      }
+
+      const NodeType &      node = it.GetIndex();
+      const OffsetValueType offset = oImage->ComputeOffset(node);
+
+      // Smallest valued neighbor along each axis
+      InternalNodeStructureArray neighbors;
+      bool                       hasNeighbor = false;
+      for (unsigned int j = 0; j < ImageDimension; ++j)
+      {
+        InternalNodeStructure & neighbor = neighbors[j];
+        neighbor.m_Node = node;
+        neighbor.m_Value = this->m_LargeValue;
+        neighbor.m_Axis = j;
+
+        const OffsetValueType neighborOffsets[2] = { offset - offsetTable[j], offset + offsetTable[j] };
+        const bool            isInside[2] = { node[j] > m_StartIndex[j], node[j] < m_LastIndex[j] };
+        for (unsigned int k = 0; k < 2; ++k)
+        {
+          if (isInside[k] && labels[neighborOffsets[k]] != Traits::Forbidden &&
+              values[neighborOffsets[k]] < neighbor.m_Value)
+          {
+            neighbor.m_Value = values[neighborOffsets[k]];
+            hasNeighbor = true;
+          }
+        }
+      }
+
+      if (!hasNeighbor)
+      {
+        continue;
+      }
+
+      const auto            value = static_cast<OutputPixelType>(this->Solve(oImage, node, neighbors));
+      const OutputPixelType previous = values[offset];
+      if (value < previous)
+      {
+        values[offset] = value;
+        if (static_cast<double>(previous) - static_cast<double>(value) > tolerance * (1.0 + value))
+        {
+          hasChanged = true;
+          hasConverged = false;
+        }
+      }
+    }
+  }
+
+  return hasChanged;
+}
+
 template <typename TInput, typename TOutput>
 IdentifierType
 FastMarchingImageFilterBase<TInput, TOutput>::GetTotalNumberOfNodes() const
@@ -199,7 +548,7 @@ FastMarchingImageFilterBase<TInput, TOutput>::UpdateValue(OutputImageType * oIma
     this->SetLabelValueForGivenNode(iNode, Traits::Trial);
 
     // Insert point into trial heap
-    this->m_Heap.push(NodePairType(iNode, outputPixel));
+    this->PushNodePair(NodePairType(iNode, outputPixel));
   }
 }
 
@@ -565,7 +914,7 @@ FastMarchingImageFilterBase<TInput, TOutput>::InitializeOutput(OutputImageType *
         this->SetOutputValue(oImage, idx, outputPixel);
 
         // this->m_Heap->Push( PriorityQueueElementType( idx, pointsIter->second ) );
-        this->m_Heap.push(pointsIter->Value());
+        this->PushNodePair(pointsIter->Value());
       }
       ++pointsIter;
     }
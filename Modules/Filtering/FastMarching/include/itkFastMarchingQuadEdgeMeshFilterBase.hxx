@@ -206,7 +206,7 @@ FastMarchingQuadEdgeMeshFilterBase<TInput, TOutput>::UpdateValue(OutputMeshType
 
       this->SetLabelValueForGivenNode(iNode, Traits::Trial);
 
-      this->m_Heap.push(NodePairType(iNode, outputPixel));
+      this->PushNodePair(NodePairType(iNode, outputPixel));
     }
   }
   else
@@ -582,6 +582,11 @@ template <typename TInput, typename TOutput>
 void
 FastMarchingQuadEdgeMeshFilterBase<TInput, TOutput>::InitializeOutput(OutputMeshType * oMesh)
 {
+  if (this->m_PropagationEngine == Superclass::PropagationEngineEnum::FastIterativeMethod)
+  {
+    itkExceptionMacro(<< "The fast iterative method is only available for images");
+  }
+
   this->CopyInputMeshToOutputMeshGeometry();
 
   // Check that the input mesh is made of triangles
@@ -677,7 +682,7 @@ FastMarchingQuadEdgeMeshFilterBase<TInput, TOutput>::InitializeOutput(OutputMesh
         this->SetLabelValueForGivenNode(idx, Traits::InitialTrial);
         this->SetOutputValue(oMesh, idx, outputPixel);
 
-        this->m_Heap.push(pointsIter->Value());
+        this->PushNodePair(pointsIter->Value());
       }
 
       ++pointsIter;
@@ -0,0 +1,305 @@
+/*=========================================================================
+ *
+ *  Copyright NumFOCUS
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkFastMarchingUntidyPriorityQueue_h
+#define itkFastMarchingUntidyPriorityQueue_h
+
+#include "itkIntTypes.h"
+#include "itkNumericTraits.h"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace itk
+{
+/**
+ * \class FastMarchingUntidyPriorityQueue
+ * \brief Bucketed priority queue of node pairs used by fast marching.
+ *
+ * Node pairs are stored in buckets of width BucketWidth according to their
+ * value. Buckets are visited in increasing order, and node pairs within a
+ * bucket are returned in insertion order. Push and pop are O(1), which makes
+ * the front propagation O(N) instead of O(N log N) with a binary heap.
+ *
+ * The ordering is exact up to the bucket width: a popped node pair may have a
+ * value larger than another pending one by at most BucketWidth. When the
+ * bucket width is lower than the smallest possible difference between the
+ * values of two neighbor nodes, the error introduced is of the same order as
+ * the discretization error of the fast marching scheme.
+ *
+ * The buckets are kept in a circular array, which grows when the range of the
+ * pending values exceeds its extent. Node pairs too far ahead of the front
+ * are kept aside until the front gets close to them.
+ *
+ * The interface mimics the subset of std::priority_queue used by
+ * FastMarchingBase.
+ *
+ * See J. Yatziv, A. Bartesaghi and G. Sapiro, "O(N) implementation of the
+ * fast marching algorithm", Journal of Computational Physics, 212(2):393-399,
+ * 2006.
+ *
+ * \tparam TNodePair node pair type, providing GetValue()
+ *
+ * \sa FastMarchingBase
+ *
+ * \ingroup ITKFastMarching
+ */
+template <typename TNodePair>
+class FastMarchingUntidyPriorityQueue
+{
+public:
+  using Self = FastMarchingUntidyPriorityQueue;
+  using NodePairType = TNodePair;
+  using BucketIndexType = OffsetValueType;
+
+  FastMarchingUntidyPriorityQueue() = default;
+
+  /** Set/Get the width of a bucket. Changing the width clears the queue. */
+  void
+  SetBucketWidth(double width)
+  {
+    this->clear();
+    m_BucketWidth = width;
+    m_InverseBucketWidth = 1.0 / width;
+  }
+  double
+  GetBucketWidth() const
+  {
+    return m_BucketWidth;
+  }
+
+  bool
+  empty() const
+  {
+    return m_Size == 0;
+  }
+
+  SizeValueType
+  size() const
+  {
+    return m_Size;
+  }
+
+  /** Returns the first node pair of the lowest non empty bucket. */
+  const NodePairType &
+  top() const
+  {
+    const BucketType & bucket = m_Buckets[this->GetSlot(m_CurrentBucket)];
+    return bucket.m_NodePairs[bucket.m_Head];
+  }
+
+  void
+  push(const NodePairType & nodePair)
+  {
+    BucketIndexType b = this->ComputeBucketIndex(nodePair.GetValue());
+
+    if (m_NumberOfBucketedNodePairs == 0)
+    {
+      if (m_Buckets.empty())
+      {
+        this->Grow(1);
+      }
+      m_CurrentBucket = b;
+      m_LastBucket = b;
+    }
+    else
+    {
+      if (b - m_CurrentBucket >= MaximumNumberOfBuckets)
+      {
+        // Too far ahead, it is bucketed when the front gets closer
+        m_Overflow.push_back(nodePair);
+        ++m_Size;
+        return;
+      }
+      // Untidy for values lower than the covered range, which only happens
+      // with pathological inputs
+      b = std::max(b, m_LastBucket - MaximumNumberOfBuckets + 1);
+
+      const BucketIndexType first = std::min(b, m_CurrentBucket);
+      const BucketIndexType last = std::max(b, m_LastBucket);
+      if (last - first >= static_cast<BucketIndexType>(m_Buckets.size()))
+      {
+        this->Grow(last - first + 1);
+      }
+      m_CurrentBucket = first;
+      m_LastBucket = last;
+    }
+
+    m_Buckets[this->GetSlot(b)].m_NodePairs.push_back(nodePair);
+    ++m_NumberOfBucketedNodePairs;
+    ++m_Size;
+  }
+
+  void
+  pop()
+  {
+    BucketType & bucket = m_Buckets[this->GetSlot(m_CurrentBucket)];
+    ++bucket.m_Head;
+    --m_NumberOfBucketedNodePairs;
+    --m_Size;
+
+    if (bucket.Empty())
+    {
+      bucket.Clear();
+
+      if (m_NumberOfBucketedNodePairs > 0)
+      {
+        do
+        {
+          ++m_CurrentBucket;
+        } while (m_Buckets[this->GetSlot(m_CurrentBucket)].Empty());
+      }
+      else if (!m_Overflow.empty())
+      {
+        this->BucketOverflow();
+      }
+    }
+  }
+
+  /** Remove all node pairs, keeping the allocated buckets. */
+  void
+  clear()
+  {
+    for (auto & bucket : m_Buckets)
+    {
+      bucket.Clear();
+    }
+    m_Overflow.clear();
+    m_NumberOfBucketedNodePairs = 0;
+    m_Size = 0;
+  }
+
+  /** Remove all node pairs and release the memory. */
+  void
+  release()
+  {
+    std::vector<BucketType>().swap(m_Buckets);
+    std::vector<NodePairType>().swap(m_Overflow);
+    m_NumberOfBucketedNodePairs = 0;
+    m_Size = 0;
+  }
+
+private:
+  struct BucketType
+  {
+    std::vector<NodePairType> m_NodePairs;
+    size_t                    m_Head{ 0 };
+
+    bool
+    Empty() const
+    {
+      return m_Head == m_NodePairs.size();
+    }
+
+    void
+    Clear()
+    {
+      m_NodePairs.clear();
+      m_Head = 0;
+    }
+  };
+
+  template <typename TValue>
+  BucketIndexType
+  ComputeBucketIndex(const TValue & value) const
+  {
+    return static_cast<BucketIndexType>(std::floor(static_cast<double>(value) * m_InverseBucketWidth));
+  }
+
+  size_t
+  GetSlot(BucketIndexType b) const
+  {
+    // The number of buckets is a power of two
+    return static_cast<size_t>(b) & (m_Buckets.size() - 1);
+  }
+
+  /** Make room for at least numberOfBuckets consecutive buckets, moving the
+   * pending node pairs to their new slots. */
+  void
+  Grow(BucketIndexType numberOfBuckets)
+  {
+    size_t newSize = std::max(m_Buckets.size(), static_cast<size_t>(16));
+    while (newSize < static_cast<size_t>(numberOfBuckets))
+    {
+      newSize *= 2;
+    }
+    if (newSize == m_Buckets.size())
+    {
+      return;
+    }
+
+    std::vector<BucketType> buckets(newSize);
+    if (m_NumberOfBucketedNodePairs > 0)
+    {
+      for (BucketIndexType b = m_CurrentBucket; b <= m_LastBucket; ++b)
+      {
+        BucketType & bucket = m_Buckets[this->GetSlot(b)];
+        if (!bucket.Empty())
+        {
+          BucketType & newBucket = buckets[static_cast<size_t>(b) & (newSize - 1)];
+          newBucket.m_NodePairs.assign(bucket.m_NodePairs.begin() + bucket.m_Head, bucket.m_NodePairs.end());
+        }
+      }
+    }
+    m_Buckets.swap(buckets);
+  }
+
+  /** Move the overflowing node pairs which are close enough to the lowest
+   * one to the buckets. */
+  void
+  BucketOverflow()
+  {
+    BucketIndexType first = NumericTraits<BucketIndexType>::max();
+    for (const auto & nodePair : m_Overflow)
+    {
+      first = std::min(first, this->ComputeBucketIndex(nodePair.GetValue()));
+    }
+
+    std::vector<NodePairType> overflow;
+    overflow.swap(m_Overflow);
+    m_Size -= overflow.size();
+    for (const auto & nodePair : overflow)
+    {
+      if (this->ComputeBucketIndex(nodePair.GetValue()) - first < MaximumNumberOfBuckets)
+      {
+        this->push(nodePair);
+      }
+      else
+      {
+        m_Overflow.push_back(nodePair);
+        ++m_Size;
+      }
+    }
+  }
+
+  /** Maximum extent of the circular array of buckets */
+  static constexpr BucketIndexType MaximumNumberOfBuckets = 1 << 16;
+
+  std::vector<BucketType>   m_Buckets;
+  std::vector<NodePairType> m_Overflow;
+
+  double          m_BucketWidth{ 1.0 };
+  double          m_InverseBucketWidth{ 1.0 };
+  SizeValueType   m_NumberOfBucketedNodePairs{ 0 };
+  SizeValueType   m_Size{ 0 };
+  BucketIndexType m_CurrentBucket{ 0 };
+  BucketIndexType m_LastBucket{ 0 };
+};
+} // end namespace itk
+
+#endif // itkFastMarchingUntidyPriorityQueue_h
@@ -62,6 +62,11 @@ FastMarchingUpwindGradientImageFilterBase<TInput, TOutput>::InitializeOutput(Out
 {
   Superclass::InitializeOutput(output);
 
+  if (this->m_PropagationEngine == Superclass::PropagationEngineEnum::FastIterativeMethod)
+  {
+    itkExceptionMacro(<< "Upwind gradient computation requires an ordered propagation engine");
+  }
+
   // allocate memory for the GradientImage if requested
   GradientImagePointer GradientImage = this->GetGradientImage();
 
@@ -37,4 +37,22 @@ operator<<(std::ostream & out, const FastMarchingTraitsEnums::TopologyCheck valu
     }
   }();
 }
+
+std::ostream &
+operator<<(std::ostream & out, const FastMarchingTraitsEnums::PropagationEngine value)
+{
+  return out << [value] {
+    switch (value)
+    {
+      case FastMarchingTraitsEnums::PropagationEngine::BinaryHeap:
+        return "itk::FastMarchingTraitsEnums::PropagationEngine::BinaryHeap";
+      case FastMarchingTraitsEnums::PropagationEngine::UntidyPriorityQueue:
+        return "itk::FastMarchingTraitsEnums::PropagationEngine::UntidyPriorityQueue";
+      case FastMarchingTraitsEnums::PropagationEngine::FastIterativeMethod:
+        return "itk::FastMarchingTraitsEnums::PropagationEngine::FastIterativeMethod";
+      default:
+        return "INVALID VALUE FOR itk::FastMarchingTraitsEnums::PropagationEngine";
+    }
+  }();
+}
 } // end namespace itk
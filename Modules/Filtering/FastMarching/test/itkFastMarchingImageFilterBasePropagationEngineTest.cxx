@@ -0,0 +1,208 @@
+/*=========================================================================
+ *
+ *  Copyright NumFOCUS
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include "itkFastMarchingImageFilterBase.h"
+#include "itkFastMarchingThresholdStoppingCriterion.h"
+#include "itkImageRegionConstIterator.h"
+#include "itkImageRegionIteratorWithIndex.h"
+#include "itkTestingMacros.h"
+
+#include <set>
+
+namespace
+{
+constexpr unsigned int Dimension = 3;
+using PixelType = float;
+using ImageType = itk::Image<PixelType, Dimension>;
+using FastMarchingType = itk::FastMarchingImageFilterBase<ImageType, ImageType>;
+using CriterionType = itk::FastMarchingThresholdStoppingCriterion<ImageType, ImageType>;
+using PropagationEngineEnum = itk::FastMarchingTraitsEnums::PropagationEngine;
+
+FastMarchingType::Pointer
+CreateFastMarching(const ImageType * speed, PropagationEngineEnum engine)
+{
+  using NodePairType = FastMarchingType::NodePairType;
+  using NodePairContainerType = FastMarchingType::NodePairContainerType;
+
+  // Two seeds on both sides of a wall
+  NodePairContainerType::Pointer trial = NodePairContainerType::New();
+  ImageType::IndexType           seed1 = { { 20, 24, 20 } };
+  ImageType::IndexType           seed2 = { { 44, 22, 21 } };
+  trial->push_back(NodePairType(seed1, 0.0));
+  trial->push_back(NodePairType(seed2, 0.0));
+
+  // The wall has a hole
+  NodePairContainerType::Pointer forbidden = NodePairContainerType::New();
+  for (itk::IndexValueType y = 0; y < 48; ++y)
+  {
+    for (itk::IndexValueType z = 0; z < 40; ++z)
+    {
+      if (y < 20 || y > 28 || z < 18 || z > 22)
+      {
+        ImageType::IndexType index = { { 32, y, z } };
+        forbidden->push_back(NodePairType(index, 0.0));
+      }
+    }
+  }
+
+  // The front stops before reaching the border of the image
+  CriterionType::Pointer criterion = CriterionType::New();
+  criterion->SetThreshold(12.0);
+
+  FastMarchingType::Pointer marcher = FastMarchingType::New();
+  marcher->SetInput(speed);
+  marcher->SetTrialPoints(trial);
+  marcher->SetForbiddenPoints(forbidden);
+  marcher->SetStoppingCriterion(criterion);
+  marcher->SetPropagationEngine(engine);
+  marcher->CollectPointsOn();
+  return marcher;
+}
+
+// Compares the arrival times of the nodes which are alive in both filters
+bool
+CompareAliveNodes(FastMarchingType * reference, FastMarchingType * marcher, double tolerance)
+{
+  const ImageType * referenceOutput = reference->GetOutput();
+  const ImageType * output = marcher->GetOutput();
+
+  itk::ImageRegionConstIteratorWithIndex<ImageType> referenceIt(referenceOutput, referenceOutput->GetBufferedRegion());
+  itk::ImageRegionConstIterator<ImageType>          outputIt(output, output->GetBufferedRegion());
+
+  double maximumError = 0.0;
+  for (; !referenceIt.IsAtEnd(); ++referenceIt, ++outputIt)
+  {
+    const ImageType::IndexType & index = referenceIt.GetIndex();
+    if (reference->GetLabelImage()->GetPixel(index) == FastMarchingType::Traits::Alive &&
+        marcher->GetLabelImage()->GetPixel(index) == FastMarchingType::Traits::Alive)
+    {
+      maximumError = std::max(maximumError, std::abs(static_cast<double>(referenceIt.Get()) - outputIt.Get()));
+    }
+  }
+  std::cout << "Maximum error: " << maximumError << std::endl;
+  return maximumError <= tolerance;
+}
+} // namespace
+
+// Compares the arrival times computed by the untidy priority queue and by
+// the fast iterative method with the ones computed with the binary heap.
+int
+itkFastMarchingImageFilterBasePropagationEngineTest(int, char *[])
+{
+  // Anisotropic image with a smoothly varying speed
+  ImageType::Pointer  speed = ImageType::New();
+  ImageType::SizeType size = { { 64, 48, 40 } };
+  speed->SetRegions(size);
+  const double spacing[Dimension] = { 1.0, 0.8, 1.2 };
+  speed->SetSpacing(spacing);
+  speed->Allocate();
+
+  itk::ImageRegionIteratorWithIndex<ImageType> it(speed, speed->GetLargestPossibleRegion());
+  for (it.GoToBegin(); !it.IsAtEnd(); ++it)
+  {
+    const ImageType::IndexType & index = it.GetIndex();
+    it.Set(1.0 + 0.5 * std::sin(0.3 * index[0]) * std::cos(0.2 * index[1] + 0.1 * index[2]));
+  }
+
+  FastMarchingType::Pointer marcher = FastMarchingType::New();
+
+  ITK_TEST_EXPECT_EQUAL(marcher->GetPropagationEngine(), PropagationEngineEnum::BinaryHeap);
+  ITK_TEST_SET_GET_VALUE(0.0, marcher->GetBucketWidth());
+
+  marcher->SetBucketWidth(0.25);
+  ITK_TEST_SET_GET_VALUE(0.25, marcher->GetBucketWidth());
+
+  std::set<PropagationEngineEnum> allEngines{ PropagationEngineEnum::BinaryHeap,
+                                              PropagationEngineEnum::UntidyPriorityQueue,
+                                              PropagationEngineEnum::FastIterativeMethod };
+  for (const auto & engine : allEngines)
+  {
+    std::cout << "STREAMED ENUM VALUE PropagationEngine: " << engine << std::endl;
+  }
+
+  FastMarchingType::Pointer reference = CreateFastMarching(speed, PropagationEngineEnum::BinaryHeap);
+  ITK_TRY_EXPECT_NO_EXCEPTION(reference->Update());
+
+  // The error of the untidy priority queue is of the order of the bucket
+  // width, which is 0.8 / 1.5 by default
+  FastMarchingType::Pointer untidy = CreateFastMarching(speed, PropagationEngineEnum::UntidyPriorityQueue);
+  ITK_TRY_EXPECT_NO_EXCEPTION(untidy->Update());
+  if (!CompareAliveNodes(reference, untidy, 0.6))
+  {
+    std::cerr << "Test failed!" << std::endl;
+    std::cerr << "Error in the arrival times computed with the untidy priority queue" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  untidy->SetBucketWidth(0.01);
+  ITK_TRY_EXPECT_NO_EXCEPTION(untidy->Update());
+  if (!CompareAliveNodes(reference, untidy, 0.01))
+  {
+    std::cerr << "Test failed!" << std::endl;
+    std::cerr << "Error in the arrival times computed with the untidy priority queue" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  // The fast iterative method converges to the same arrival times, and the
+  // stopping criterion is applied in increasing arrival time order
+  for (unsigned int numberOfWorkUnits = 1; numberOfWorkUnits <= 4; numberOfWorkUnits *= 2)
+  {
+    FastMarchingType::Pointer iterative = CreateFastMarching(speed, PropagationEngineEnum::FastIterativeMethod);
+    iterative->SetNumberOfWorkUnits(numberOfWorkUnits);
+    ITK_TRY_EXPECT_NO_EXCEPTION(iterative->Update());
+
+    ITK_TEST_EXPECT_EQUAL(iterative->GetProcessedPoints()->Size(), reference->GetProcessedPoints()->Size());
+    ITK_TEST_EXPECT_TRUE(
+      itk::Math::FloatAlmostEqual(iterative->GetTargetReachedValue(), reference->GetTargetReachedValue(), 4, 1e-4f));
+    if (!CompareAliveNodes(reference, iterative, 1e-4))
+    {
+      std::cerr << "Test failed!" << std::endl;
+      std::cerr << "Error in the arrival times computed with the fast iterative method" << std::endl;
+      return EXIT_FAILURE;
+    }
+
+    // The nodes beyond the stopping point were not reached
+    const ImageType *                                 output = iterative->GetOutput();
+    itk::ImageRegionConstIteratorWithIndex<ImageType> outputIt(output, output->GetBufferedRegion());
+    for (; !outputIt.IsAtEnd(); ++outputIt)
+    {
+      const unsigned char label = iterative->GetLabelImage()->GetPixel(outputIt.GetIndex());
+      if ((label == FastMarchingType::Traits::Alive) !=
+          (reference->GetLabelImage()->GetPixel(outputIt.GetIndex()) == FastMarchingType::Traits::Alive))
+      {
+        std::cerr << "Test failed!" << std::endl;
+        std::cerr << "Error in the alive nodes at index " << outputIt.GetIndex() << std::endl;
+        return EXIT_FAILURE;
+      }
+      if (label == FastMarchingType::Traits::Far && outputIt.Get() < itk::NumericTraits<PixelType>::max())
+      {
+        std::cerr << "Test failed!" << std::endl;
+        std::cerr << "Unexpected value " << outputIt.Get() << " at index " << outputIt.GetIndex() << std::endl;
+        return EXIT_FAILURE;
+      }
+    }
+  }
+
+  // Topology checks need the nodes to be processed in order
+  FastMarchingType::Pointer topology = CreateFastMarching(speed, PropagationEngineEnum::FastIterativeMethod);
+  topology->SetTopologyCheck(itk::FastMarchingTraitsEnums::TopologyCheck::Strict);
+  ITK_TRY_EXPECT_EXCEPTION(topology->Update());
+
+  std::cout << "Test finished." << std::endl;
+  return EXIT_SUCCESS;
+}
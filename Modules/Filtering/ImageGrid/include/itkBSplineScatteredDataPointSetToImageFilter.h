@@ -278,6 +278,17 @@ public:
   itkGetConstReferenceMacro(GenerateOutputImage, bool);
   itkBooleanMacro(GenerateOutputImage);
 
+  /** Set/Get whether the points are sorted by the cell of the control point
+   * lattice of the finest level which contains them, so that the points
+   * handled by each thread are close to each other in the lattices of all the
+   * levels. This improves the cache locality of the fitting of a large number
+   * of points to large lattices, at the cost of a copy of the points and of
+   * their weights, and of a slightly different rounding of the sums of their
+   * contributions. Default = false. */
+  itkSetMacro(SortPointsByLatticeCell, bool);
+  itkGetConstMacro(SortPointsByLatticeCell, bool);
+  itkBooleanMacro(SortPointsByLatticeCell);
+
   /** Get the control point lattice produced by the fitting process. */
   PointDataImagePointer
   GetPhiLattice()
@@ -341,6 +352,16 @@ private:
   void
   CollapsePhiLattice(PointDataImageType *, PointDataImageType *, const RealType, const unsigned int);
 
+  /** Map a point to the parametric domain of the control point lattice of the
+   * current level, given the number of spans per unit of length and the
+   * B-spline epsilon of each dimension. */
+  RealArrayType
+  TransformPointToParametricDomain(const PointType &, const RealArrayType &, const RealArrayType &) const;
+
+  /** Evaluate the B-spline kernel of the given parametric dimension. */
+  typename KernelType::RealType
+  EvaluateKernel(const RealType, const unsigned int) const;
+
   /** Set the grid parametric domain parameters such as the origin, size,
    * spacing, and direction. */
   void
@@ -354,6 +375,7 @@ private:
   bool         m_DoMultilevel{ false };
   bool         m_GenerateOutputImage{ true };
   bool         m_UsePointWeights{ false };
+  bool         m_SortPointsByLatticeCell{ false };
   unsigned int m_MaximumNumberOfLevels{ 1 };
   unsigned int m_CurrentLevel{ 0 };
   ArrayType    m_NumberOfControlPoints;
@@ -382,6 +404,10 @@ private:
   std::vector<RealImagePointer>      m_OmegaLatticePerThread;
   std::vector<PointDataImagePointer> m_DeltaLatticePerThread;
 
+  /** The points and their weights sorted by lattice cell, if requested. */
+  std::vector<PointType> m_SortedPoints;
+  std::vector<RealType>  m_SortedPointWeights;
+
   RealType m_BSplineEpsilon{ static_cast<RealType>(1e-3) };
   bool     m_IsFittingComplete{ false };
 };
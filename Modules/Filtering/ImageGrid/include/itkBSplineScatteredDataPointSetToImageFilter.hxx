@@ -30,6 +30,8 @@
 #include "itkMath.h"
 #include "vnl/algo/vnl_matrix_inverse.h"
 #include "itkMath.h"
+#include <algorithm>
+#include <numeric>
 
 namespace itk
 {
@@ -253,6 +255,7 @@ BSplineScatteredDataPointSetToImageFilter<TInputPointSet, TOutputImage>::Generat
 
   this->m_CurrentLevel = 0;
   this->m_CurrentNumberOfControlPoints = this->m_NumberOfControlPoints;
+  this->m_IsFittingComplete = false;
 
 
   // Set up multithread processing to handle generating the
@@ -263,12 +266,18 @@ BSplineScatteredDataPointSetToImageFilter<TInputPointSet, TOutputImage>::Generat
 
   MultiThreaderBase * multiThreader = this->GetMultiThreader();
   multiThreader->SetNumberOfWorkUnits(this->GetNumberOfWorkUnits());
-  multiThreader->SetSingleMethod(this->ThreaderCallback, &str1);
+
+  // The single method is set before each execution, as the multithreader
+  // also parallelizes the other steps of the fitting.
+  const auto generateControlPointLattice = [this, multiThreader, &str1]() {
+    this->BeforeThreadedGenerateData();
+    multiThreader->SetSingleMethod(this->ThreaderCallback, &str1);
+    multiThreader->SingleMethodExecute();
+    this->AfterThreadedGenerateData();
+  };
 
   // Multithread the generation of the control point lattice.
-  this->BeforeThreadedGenerateData();
-  multiThreader->SingleMethodExecute();
-  this->AfterThreadedGenerateData();
+  generateControlPointLattice();
 
   this->UpdatePointSet();
 
@@ -312,7 +321,8 @@ BSplineScatteredDataPointSetToImageFilter<TInputPointSet, TOutputImage>::Generat
 
       if (this->GetDebug())
       {
-        RealType weight = this->m_PointWeights->GetElement(ItIn.Index());
+        RealType weight = this->m_SortedPointWeights.empty() ? this->m_PointWeights->GetElement(ItIn.Index())
+                                                             : this->m_SortedPointWeights[ItIn.Index()];
         averageDifference += (ItIn.Value() - ItOut.Value()).GetNorm() * weight;
         totalWeight += weight;
       }
@@ -326,9 +336,7 @@ BSplineScatteredDataPointSetToImageFilter<TInputPointSet, TOutputImage>::Generat
     }
 
     // Multithread the generation of the control point lattice.
-    this->BeforeThreadedGenerateData();
-    multiThreader->SingleMethodExecute();
-    this->AfterThreadedGenerateData();
+    generateControlPointLattice();
 
     this->UpdatePointSet();
   }
@@ -351,11 +359,16 @@ BSplineScatteredDataPointSetToImageFilter<TInputPointSet, TOutputImage>::Generat
     this->UpdatePointSet();
   }
 
+  this->m_SortedPoints.clear();
+  this->m_SortedPoints.shrink_to_fit();
+  this->m_SortedPointWeights.clear();
+  this->m_SortedPointWeights.shrink_to_fit();
   this->m_IsFittingComplete = true;
 
   if (this->m_GenerateOutputImage)
   {
     //    this->BeforeThreadedGenerateData();
+    multiThreader->SetSingleMethod(this->ThreaderCallback, &str1);
     multiThreader->SingleMethodExecute();
     //    this->AfterThreadedGenerateData();
   }
@@ -397,6 +410,90 @@ BSplineScatteredDataPointSetToImageFilter<TInputPointSet, TOutputImage>::BeforeT
       this->m_DeltaLatticePerThread[n]->Allocate();
       this->m_DeltaLatticePerThread[n]->FillBuffer(NumericTraits<PointDataType>::ZeroValue());
     }
+
+    if (this->m_CurrentLevel == 0)
+    {
+      this->m_SortedPoints.clear();
+      this->m_SortedPointWeights.clear();
+    }
+    if (this->m_SortPointsByLatticeCell && this->m_CurrentLevel == 0)
+    {
+      // Counting sort of the points by the linear index of the cell of the
+      // finest lattice which contains them, which also keeps the points of
+      // the cells of the coarser lattices together. The cells are computed
+      // in as many chunks as work units. The points, their weights and their
+      // data are then copied in this order, so that they are read in the
+      // order in which they are stored at every level.
+      const TInputPointSet * input = this->GetInput();
+      const SizeValueType    numberOfPoints = input->GetNumberOfPoints();
+      const SizeValueType    numberOfChunks = this->GetNumberOfWorkUnits();
+
+      RealArrayType                           r;
+      RealArrayType                           epsilon;
+      ArrayType                               numberOfCellsPerSpan;
+      ArrayType                               numberOfCells;
+      FixedArray<SizeValueType, ImageDimension> cellStrides;
+      SizeValueType                           totalNumberOfCells = 1;
+      for (unsigned int i = 0; i < ImageDimension; i++)
+      {
+        const unsigned int totalNumberOfSpans = this->m_CurrentNumberOfControlPoints[i] - this->m_SplineOrder[i];
+        r[i] = static_cast<RealType>(totalNumberOfSpans) /
+               (static_cast<RealType>(this->m_Size[i] - 1) * this->m_Spacing[i]);
+        epsilon[i] = r[i] * this->m_Spacing[i] * this->m_BSplineEpsilon;
+        numberOfCellsPerSpan[i] = 1u << (this->m_NumberOfLevels[i] - 1);
+        numberOfCells[i] = totalNumberOfSpans * numberOfCellsPerSpan[i];
+        cellStrides[i] = totalNumberOfCells;
+        totalNumberOfCells *= numberOfCells[i];
+      }
+
+      std::vector<SizeValueType> cells(numberOfPoints);
+      this->GetMultiThreader()->ParallelizeArray(
+        0,
+        numberOfChunks,
+        [&](SizeValueType chunk) {
+          const SizeValueType end = (chunk + 1) * numberOfPoints / numberOfChunks;
+          for (SizeValueType n = chunk * numberOfPoints / numberOfChunks; n < end; n++)
+          {
+            PointType point;
+            point.Fill(0.0);
+            input->GetPoint(n, &point);
+
+            const RealArrayType p = this->TransformPointToParametricDomain(point, r, epsilon);
+            SizeValueType       cell = 0;
+            for (unsigned int i = 0; i < ImageDimension; i++)
+            {
+              const auto index = static_cast<unsigned>(p[i] * static_cast<RealType>(numberOfCellsPerSpan[i]));
+              cell += std::min(index, numberOfCells[i] - 1) * cellStrides[i];
+            }
+            cells[n] = cell;
+          }
+        },
+        nullptr);
+
+      std::vector<SizeValueType> cellStarts(totalNumberOfCells + 1, 0);
+      for (const SizeValueType cell : cells)
+      {
+        cellStarts[cell + 1]++;
+      }
+      std::partial_sum(cellStarts.begin(), cellStarts.end(), cellStarts.begin());
+      std::vector<SizeValueType> pointOrder(numberOfPoints);
+      for (SizeValueType n = 0; n < numberOfPoints; n++)
+      {
+        pointOrder[cellStarts[cells[n]]++] = n;
+      }
+
+      this->m_SortedPoints.resize(numberOfPoints);
+      this->m_SortedPointWeights.resize(numberOfPoints);
+      typename PointDataContainerType::STLContainerType sortedPointData(numberOfPoints);
+      for (SizeValueType n = 0; n < numberOfPoints; n++)
+      {
+        this->m_SortedPoints[n].Fill(0.0);
+        input->GetPoint(pointOrder[n], &this->m_SortedPoints[n]);
+        this->m_SortedPointWeights[n] = this->m_PointWeights->GetElement(pointOrder[n]);
+        sortedPointData[n] = this->m_InputPointData->GetElement(pointOrder[n]);
+      }
+      this->m_InputPointData->CastToSTLContainer().swap(sortedPointData);
+    }
   }
 }
 
@@ -444,21 +541,26 @@ BSplineScatteredDataPointSetToImageFilter<TInputPointSet, TOutputImage>::Threade
   // Ignore the output region as we're only interested in dividing the
   // points among the threads.
 
+  // The B-spline weights of the neighborhood of control points of a point
+  // are the products of its weights along each dimension, which are
+  // evaluated once per point and dimension.
   typename RealImageType::SizeType size;
-
+  SizeValueType                    numberOfNeighbors = 1;
   for (unsigned int i = 0; i < ImageDimension; i++)
   {
     size[i] = this->m_SplineOrder[i] + 1;
+    numberOfNeighbors *= size[i];
   }
-  RealImagePointer neighborhoodWeightImage = RealImageType::New();
-  neighborhoodWeightImage->SetRegions(size);
-  neighborhoodWeightImage->Allocate();
-  neighborhoodWeightImage->FillBuffer(0.0);
-
-  ImageRegionIteratorWithIndex<RealImageType> ItW(neighborhoodWeightImage,
-                                                  neighborhoodWeightImage->GetRequestedRegion());
+  std::vector<typename KernelType::RealType> weights[ImageDimension];
+  std::vector<OffsetValueType>               offsets[ImageDimension];
+  for (unsigned int i = 0; i < ImageDimension; i++)
+  {
+    weights[i].resize(size[i]);
+    offsets[i].resize(size[i]);
+  }
+  std::vector<RealType>        neighborhoodWeights(numberOfNeighbors);
+  std::vector<OffsetValueType> neighborhoodOffsets(numberOfNeighbors);
 
-  RealArrayType p;
   RealArrayType r;
   RealArrayType epsilon;
   for (unsigned int i = 0; i < ImageDimension; i++)
@@ -468,110 +570,92 @@ BSplineScatteredDataPointSetToImageFilter<TInputPointSet, TOutputImage>::Threade
     epsilon[i] = r[i] * this->m_Spacing[i] * this->m_BSplineEpsilon;
   }
 
+  RealType *              currentThreadOmegaLattice = this->m_OmegaLatticePerThread[threadId]->GetBufferPointer();
+  PointDataType *         currentThreadDeltaLattice = this->m_DeltaLatticePerThread[threadId]->GetBufferPointer();
+  const OffsetValueType * offsetTable = this->m_OmegaLatticePerThread[threadId]->GetOffsetTable();
+
   // Determine which points should be handled by this particular thread.
 
   ThreadIdType numberOfThreads = this->GetNumberOfWorkUnits();
   auto         numberOfPointsPerThread = static_cast<SizeValueType>(input->GetNumberOfPoints() / numberOfThreads);
 
-  unsigned int start = threadId * numberOfPointsPerThread;
-  unsigned int end = start + numberOfPointsPerThread;
+  SizeValueType start = threadId * numberOfPointsPerThread;
+  SizeValueType end = start + numberOfPointsPerThread;
   if (threadId == this->GetNumberOfWorkUnits() - 1)
   {
     end = input->GetNumberOfPoints();
   }
 
-  for (unsigned int n = start; n < end; n++)
+  for (SizeValueType n = start; n < end; n++)
   {
     PointType point;
     point.Fill(0.0);
 
-    input->GetPoint(n, &point);
-
-    for (unsigned int i = 0; i < ImageDimension; i++)
+    if (this->m_SortedPoints.empty())
     {
-      unsigned int totalNumberOfSpans = this->m_CurrentNumberOfControlPoints[i] - this->m_SplineOrder[i];
-
-      p[i] = (point[i] - this->m_Origin[i]) * r[i];
-      if (std::abs(p[i] - static_cast<RealType>(totalNumberOfSpans)) <= epsilon[i])
-      {
-        p[i] = static_cast<RealType>(totalNumberOfSpans) - epsilon[i];
-      }
-      if (p[i] < NumericTraits<RealType>::ZeroValue() && std::abs(p[i]) <= epsilon[i])
-      {
-        p[i] = NumericTraits<RealType>::ZeroValue();
-      }
-
-      if (p[i] < NumericTraits<RealType>::ZeroValue() || p[i] >= static_cast<RealType>(totalNumberOfSpans))
-      {
-        itkExceptionMacro("The reparameterized point component "
-                          << p[i] << " is outside the corresponding parametric domain of [0, " << totalNumberOfSpans
-                          << ").");
-      }
+      input->GetPoint(n, &point);
+    }
+    else
+    {
+      point = this->m_SortedPoints[n];
     }
 
-    RealType w2Sum = 0.0;
-    for (ItW.GoToBegin(); !ItW.IsAtEnd(); ++ItW)
+    const RealArrayType p = this->TransformPointToParametricDomain(point, r, epsilon);
+
+    for (unsigned int i = 0; i < ImageDimension; i++)
     {
-      RealType                          B = 1.0;
-      typename RealImageType::IndexType idx = ItW.GetIndex();
-      for (unsigned int i = 0; i < ImageDimension; i++)
+      for (unsigned int k = 0; k < size[i]; k++)
       {
-        RealType u = static_cast<RealType>(p[i] - static_cast<unsigned>(p[i]) - idx[i]) +
+        RealType u = static_cast<RealType>(p[i] - static_cast<unsigned>(p[i]) - k) +
                      0.5 * static_cast<RealType>(this->m_SplineOrder[i] - 1);
+        weights[i][k] = this->EvaluateKernel(u, i);
 
-        switch (this->m_SplineOrder[i])
+        SizeValueType idx = k + static_cast<unsigned>(p[i]);
+        if (this->m_CloseDimension[i])
         {
-          case 0:
-          {
-            B *= this->m_KernelOrder0->Evaluate(u);
-            break;
-          }
-          case 1:
-          {
-            B *= this->m_KernelOrder1->Evaluate(u);
-            break;
-          }
-          case 2:
-          {
-            B *= this->m_KernelOrder2->Evaluate(u);
-            break;
-          }
-          case 3:
-          {
-            B *= this->m_KernelOrder3->Evaluate(u);
-            break;
-          }
-          default:
-          {
-            B *= this->m_Kernel[i]->Evaluate(u);
-            break;
-          }
+          idx %= size[i];
         }
+        offsets[i][k] = static_cast<OffsetValueType>(idx) * offsetTable[i];
       }
-      ItW.Set(B);
-      w2Sum += B * B;
     }
 
-    RealImageType *      currentThreadOmegaLattice = this->m_OmegaLatticePerThread[threadId];
-    PointDataImageType * currentThreadDeltaLattice = this->m_DeltaLatticePerThread[threadId];
-
-    for (ItW.GoToBegin(); !ItW.IsAtEnd(); ++ItW)
+    // The weights and the offsets of the neighborhood, with the first
+    // dimension varying the fastest, are computed one dimension at a time,
+    // so that the neighbors share the products along the first dimensions.
+    neighborhoodWeights[0] = 1.0;
+    neighborhoodOffsets[0] = 0;
+    SizeValueType numberOfProducts = 1;
+    for (unsigned int i = 0; i < ImageDimension; i++)
     {
-      typename RealImageType::IndexType idx = ItW.GetIndex();
-      for (unsigned int i = 0; i < ImageDimension; i++)
+      for (unsigned int k = size[i]; k-- > 0;)
       {
-        idx[i] += static_cast<unsigned>(p[i]);
-        if (this->m_CloseDimension[i])
+        for (SizeValueType m = 0; m < numberOfProducts; m++)
         {
-          idx[i] %= size[i];
+          RealType B = neighborhoodWeights[m];
+          B *= weights[i][k];
+          neighborhoodWeights[k * numberOfProducts + m] = B;
+          neighborhoodOffsets[k * numberOfProducts + m] = neighborhoodOffsets[m] + offsets[i][k];
         }
       }
-      RealType wc = this->m_PointWeights->GetElement(n);
-      RealType t = ItW.Get();
-      currentThreadOmegaLattice->SetPixel(idx, currentThreadOmegaLattice->GetPixel(idx) + wc * t * t);
-      PointDataType data = this->m_InputPointData->GetElement(n);
+      numberOfProducts *= size[i];
+    }
+
+    RealType w2Sum = 0.0;
+    for (SizeValueType m = 0; m < numberOfNeighbors; m++)
+    {
+      w2Sum += neighborhoodWeights[m] * neighborhoodWeights[m];
+    }
+
+    const RealType      wc =
+      this->m_SortedPointWeights.empty() ? this->m_PointWeights->GetElement(n) : this->m_SortedPointWeights[n];
+    const PointDataType pointData = this->m_InputPointData->GetElement(n);
+    for (SizeValueType m = 0; m < numberOfNeighbors; m++)
+    {
+      RealType t = neighborhoodWeights[m];
+      currentThreadOmegaLattice[neighborhoodOffsets[m]] += wc * t * t;
+      PointDataType data = pointData;
       data *= (t * t * t * wc / w2Sum);
-      currentThreadDeltaLattice->SetPixel(idx, currentThreadDeltaLattice->GetPixel(idx) + data);
+      currentThreadDeltaLattice[neighborhoodOffsets[m]] += data;
     }
   }
 }
@@ -684,37 +768,6 @@ BSplineScatteredDataPointSetToImageFilter<TInputPointSet, TOutputImage>::AfterTh
 {
   if (!this->m_IsFittingComplete)
   {
-    // Accumulate all the delta lattice and omega lattice values to
-    // calculate the final phi lattice.
-
-    ImageRegionIterator<PointDataImageType> ItD(this->m_DeltaLatticePerThread[0],
-                                                this->m_DeltaLatticePerThread[0]->GetLargestPossibleRegion());
-    ImageRegionIterator<RealImageType>      ItO(this->m_OmegaLatticePerThread[0],
-                                           this->m_OmegaLatticePerThread[0]->GetLargestPossibleRegion());
-
-    for (ThreadIdType n = 1; n < this->GetNumberOfWorkUnits(); n++)
-    {
-      ImageRegionIterator<PointDataImageType> Itd(this->m_DeltaLatticePerThread[n],
-                                                  this->m_DeltaLatticePerThread[n]->GetLargestPossibleRegion());
-      ImageRegionIterator<RealImageType>      Ito(this->m_OmegaLatticePerThread[n],
-                                             this->m_OmegaLatticePerThread[n]->GetLargestPossibleRegion());
-
-      ItD.GoToBegin();
-      ItO.GoToBegin();
-      Itd.GoToBegin();
-      Ito.GoToBegin();
-      while (!ItD.IsAtEnd())
-      {
-        ItD.Set(ItD.Get() + Itd.Get());
-        ItO.Set(ItO.Get() + Ito.Get());
-
-        ++ItD;
-        ++ItO;
-        ++Itd;
-        ++Ito;
-      }
-    }
-
     // Generate the control point lattice
 
     typename RealImageType::SizeType size;
@@ -732,27 +785,60 @@ BSplineScatteredDataPointSetToImageFilter<TInputPointSet, TOutputImage>::AfterTh
     this->m_PhiLattice = PointDataImageType::New();
     this->m_PhiLattice->SetRegions(size);
     this->m_PhiLattice->Allocate();
-    this->m_PhiLattice->FillBuffer(NumericTraits<PointDataType>::ZeroValue());
-
-    ImageRegionIterator<PointDataImageType> ItP(this->m_PhiLattice, this->m_PhiLattice->GetLargestPossibleRegion());
 
-    for (ItP.GoToBegin(), ItO.GoToBegin(), ItD.GoToBegin(); !ItP.IsAtEnd(); ++ItP, ++ItO, ++ItD)
+    // Accumulate all the delta lattice and omega lattice values to
+    // calculate the final phi lattice. The lattices are split in as many
+    // segments as work units, and the values of the threads are summed in
+    // the same order in each segment.
+
+    const ThreadIdType                 numberOfThreads = this->GetNumberOfWorkUnits();
+    std::vector<const RealType *>      omegaLattices(numberOfThreads);
+    std::vector<const PointDataType *> deltaLattices(numberOfThreads);
+    for (ThreadIdType n = 0; n < numberOfThreads; n++)
     {
-      PointDataType P;
-      P.Fill(0);
-      if (Math::NotAlmostEquals(ItO.Get(), NumericTraits<typename PointDataType::ValueType>::ZeroValue()))
-      {
-        P = ItD.Get() / ItO.Get();
-        for (unsigned int i = 0; i < P.Size(); i++)
+      omegaLattices[n] = this->m_OmegaLatticePerThread[n]->GetBufferPointer();
+      deltaLattices[n] = this->m_DeltaLatticePerThread[n]->GetBufferPointer();
+    }
+    PointDataType * phiLattice = this->m_PhiLattice->GetBufferPointer();
+
+    const SizeValueType numberOfControlPoints = this->m_PhiLattice->GetLargestPossibleRegion().GetNumberOfPixels();
+    const SizeValueType numberOfSegments = numberOfThreads;
+    this->GetMultiThreader()->ParallelizeArray(
+      0,
+      numberOfSegments,
+      [&](SizeValueType segment) {
+        const SizeValueType end = (segment + 1) * numberOfControlPoints / numberOfSegments;
+        for (SizeValueType j = segment * numberOfControlPoints / numberOfSegments; j < end; j++)
         {
-          if (itk::Math::isnan(P[i]) || itk::Math::isinf(P[i]))
+          RealType      omega = omegaLattices[0][j];
+          PointDataType delta = deltaLattices[0][j];
+          for (ThreadIdType n = 1; n < numberOfThreads; n++)
+          {
+            omega += omegaLattices[n][j];
+            delta += deltaLattices[n][j];
+          }
+
+          PointDataType P;
+          P.Fill(0);
+          if (Math::NotAlmostEquals(omega, NumericTraits<typename PointDataType::ValueType>::ZeroValue()))
           {
-            P[i] = 0;
+            P = delta / omega;
+            for (unsigned int i = 0; i < P.Size(); i++)
+            {
+              if (itk::Math::isnan(P[i]) || itk::Math::isinf(P[i]))
+              {
+                P[i] = 0;
+              }
+            }
           }
+          phiLattice[j] = P;
         }
-        ItP.Set(P);
-      }
-    }
+      },
+      nullptr);
+
+    // The lattices of the threads are only needed during the fitting.
+    this->m_OmegaLatticePerThread.clear();
+    this->m_DeltaLatticePerThread.clear();
   }
 }
 
@@ -911,34 +997,21 @@ void
 BSplineScatteredDataPointSetToImageFilter<TInputPointSet, TOutputImage>::UpdatePointSet()
 {
   const TInputPointSet * input = this->GetInput();
-  PointDataImagePointer  collapsedPhiLattices[ImageDimension + 1];
-  for (unsigned int i = 0; i < ImageDimension; i++)
-  {
-    collapsedPhiLattices[i] = PointDataImageType::New();
-    collapsedPhiLattices[i]->SetOrigin(this->m_PhiLattice->GetOrigin());
-    collapsedPhiLattices[i]->SetSpacing(this->m_PhiLattice->GetSpacing());
-    collapsedPhiLattices[i]->SetDirection(this->m_PhiLattice->GetDirection());
 
-    typename PointDataImageType::SizeType size;
-    size.Fill(1);
-    for (unsigned int j = 0; j < i; j++)
-    {
-      size[j] = this->m_PhiLattice->GetLargestPossibleRegion().GetSize()[j];
-    }
-    collapsedPhiLattices[i]->SetRegions(size);
-    collapsedPhiLattices[i]->Allocate();
-  }
-  collapsedPhiLattices[ImageDimension] = this->m_PhiLattice;
+  const typename PointDataImageType::SizeType & latticeSize = this->m_PhiLattice->GetLargestPossibleRegion().GetSize();
+  const PointDataType *                        phiLattice = this->m_PhiLattice->GetBufferPointer();
+  const OffsetValueType *                      offsetTable = this->m_PhiLattice->GetOffsetTable();
+
   ArrayType totalNumberOfSpans;
   for (unsigned int i = 0; i < ImageDimension; i++)
   {
     if (this->m_CloseDimension[i])
     {
-      totalNumberOfSpans[i] = this->m_PhiLattice->GetLargestPossibleRegion().GetSize()[i];
+      totalNumberOfSpans[i] = latticeSize[i];
     }
     else
     {
-      totalNumberOfSpans[i] = this->m_PhiLattice->GetLargestPossibleRegion().GetSize()[i] - this->m_SplineOrder[i];
+      totalNumberOfSpans[i] = latticeSize[i] - this->m_SplineOrder[i];
     }
   }
 
@@ -955,57 +1028,125 @@ BSplineScatteredDataPointSetToImageFilter<TInputPointSet, TOutputImage>::UpdateP
     epsilon[i] = r[i] * this->m_Spacing[i] * this->m_BSplineEpsilon;
   }
 
-  FixedArray<RealType, ImageDimension> U;
-  FixedArray<RealType, ImageDimension> currentU;
-  currentU.Fill(-1);
-
-  typename PointDataImageType::IndexType startPhiIndex = this->m_PhiLattice->GetLargestPossibleRegion().GetIndex();
-
-  this->m_OutputPointData->CastToSTLContainer().resize(this->m_InputPointData->Size());
-  typename PointDataContainerType::ConstIterator ItIn = this->m_InputPointData->Begin();
-  while (ItIn != this->m_InputPointData->End())
+  SizeValueType numberOfNeighbors = 1;
+  for (unsigned int i = 0; i < ImageDimension; i++)
   {
-    PointType point;
-    point.Fill(0.0);
-
-    input->GetPoint(ItIn.Index(), &point);
-
-    for (unsigned int i = 0; i < ImageDimension; i++)
-    {
-      U[i] = static_cast<RealType>(totalNumberOfSpans[i]) * static_cast<RealType>(point[i] - this->m_Origin[i]) /
-             (static_cast<RealType>(this->m_Size[i] - 1) * this->m_Spacing[i]);
+    numberOfNeighbors *= this->m_SplineOrder[i] + 1;
+  }
 
-      if (std::abs(U[i] - static_cast<RealType>(totalNumberOfSpans[i])) <= epsilon[i])
-      {
-        U[i] = static_cast<RealType>(totalNumberOfSpans[i]) - epsilon[i];
-      }
-      if (U[i] < NumericTraits<RealType>::ZeroValue() && std::abs(U[i]) <= epsilon[i])
+  // Each point is evaluated from the neighborhood of control points of its
+  // span, which is collapsed one dimension at a time, starting with the last
+  // one, as CollapsePhiLattice() does for the whole lattice. The points are
+  // split in as many chunks as work units.
+
+  const SizeValueType numberOfPoints = this->m_InputPointData->Size();
+  const SizeValueType numberOfChunks = this->GetNumberOfWorkUnits();
+
+  this->m_OutputPointData->CastToSTLContainer().resize(numberOfPoints);
+  this->GetMultiThreader()->ParallelizeArray(
+    0,
+    numberOfChunks,
+    [&](SizeValueType chunk) {
+      std::vector<RealType>        weights[ImageDimension];
+      std::vector<OffsetValueType> offsets[ImageDimension];
+      for (unsigned int i = 0; i < ImageDimension; i++)
       {
-        U[i] = NumericTraits<RealType>::ZeroValue();
+        weights[i].resize(this->m_SplineOrder[i] + 1);
+        offsets[i].resize(this->m_SplineOrder[i] + 1);
       }
+      std::vector<OffsetValueType> neighborhoodOffsets(numberOfNeighbors);
+      std::vector<PointDataType>   neighborhood(numberOfNeighbors);
 
-      if (U[i] < NumericTraits<RealType>::ZeroValue() || U[i] >= static_cast<RealType>(totalNumberOfSpans[i]))
-      {
-        itkExceptionMacro("The collapse point component "
-                          << U[i] << " is outside the corresponding parametric domain of [0, " << totalNumberOfSpans[i]
-                          << ").");
-      }
-    }
-    for (int i = ImageDimension - 1; i >= 0; i--)
-    {
-      if (Math::NotExactlyEquals(U[i], currentU[i]))
+      FixedArray<RealType, ImageDimension> U;
+
+      const SizeValueType end = (chunk + 1) * numberOfPoints / numberOfChunks;
+      for (SizeValueType n = chunk * numberOfPoints / numberOfChunks; n < end; n++)
       {
-        for (int j = i; j >= 0; j--)
+        PointType point;
+        point.Fill(0.0);
+
+        if (this->m_SortedPoints.empty())
         {
-          this->CollapsePhiLattice(collapsedPhiLattices[j + 1], collapsedPhiLattices[j], U[j], j);
-          currentU[j] = U[j];
+          input->GetPoint(n, &point);
         }
-        break;
+        else
+        {
+          point = this->m_SortedPoints[n];
+        }
+
+        for (unsigned int i = 0; i < ImageDimension; i++)
+        {
+          U[i] = static_cast<RealType>(totalNumberOfSpans[i]) * static_cast<RealType>(point[i] - this->m_Origin[i]) /
+                 (static_cast<RealType>(this->m_Size[i] - 1) * this->m_Spacing[i]);
+
+          if (std::abs(U[i] - static_cast<RealType>(totalNumberOfSpans[i])) <= epsilon[i])
+          {
+            U[i] = static_cast<RealType>(totalNumberOfSpans[i]) - epsilon[i];
+          }
+          if (U[i] < NumericTraits<RealType>::ZeroValue() && std::abs(U[i]) <= epsilon[i])
+          {
+            U[i] = NumericTraits<RealType>::ZeroValue();
+          }
+
+          if (U[i] < NumericTraits<RealType>::ZeroValue() || U[i] >= static_cast<RealType>(totalNumberOfSpans[i]))
+          {
+            itkExceptionMacro("The collapse point component "
+                              << U[i] << " is outside the corresponding parametric domain of [0, "
+                              << totalNumberOfSpans[i] << ").");
+          }
+
+          for (unsigned int k = 0; k < this->m_SplineOrder[i] + 1; k++)
+          {
+            IndexValueType idx = static_cast<unsigned int>(U[i]) + k;
+            RealType       v = U[i] - idx + 0.5 * static_cast<RealType>(this->m_SplineOrder[i] - 1);
+            weights[i][k] = this->EvaluateKernel(v, i);
+            if (this->m_CloseDimension[i])
+            {
+              idx %= latticeSize[i];
+            }
+            offsets[i][k] = idx * offsetTable[i];
+          }
+        }
+
+        // Gather the neighborhood with the first dimension varying the
+        // fastest, whose offsets are computed one dimension at a time.
+        neighborhoodOffsets[0] = 0;
+        SizeValueType numberOfSums = 1;
+        for (unsigned int i = 0; i < ImageDimension; i++)
+        {
+          for (unsigned int k = this->m_SplineOrder[i] + 1; k-- > 0;)
+          {
+            for (SizeValueType m = 0; m < numberOfSums; m++)
+            {
+              neighborhoodOffsets[k * numberOfSums + m] = neighborhoodOffsets[m] + offsets[i][k];
+            }
+          }
+          numberOfSums *= this->m_SplineOrder[i] + 1;
+        }
+        for (SizeValueType m = 0; m < numberOfNeighbors; m++)
+        {
+          neighborhood[m] = phiLattice[neighborhoodOffsets[m]];
+        }
+
+        SizeValueType numberOfCollapsedNeighbors = numberOfNeighbors;
+        for (int i = ImageDimension - 1; i >= 0; i--)
+        {
+          numberOfCollapsedNeighbors /= this->m_SplineOrder[i] + 1;
+          for (SizeValueType m = 0; m < numberOfCollapsedNeighbors; m++)
+          {
+            PointDataType data;
+            data.Fill(0.0);
+            for (unsigned int k = 0; k < this->m_SplineOrder[i] + 1; k++)
+            {
+              data += (neighborhood[m + k * numberOfCollapsedNeighbors] * weights[i][k]);
+            }
+            neighborhood[m] = data;
+          }
+        }
+        this->m_OutputPointData->CastToSTLContainer()[n] = neighborhood[0];
       }
-    }
-    this->m_OutputPointData->CastToSTLContainer()[ItIn.Index()] = collapsedPhiLattices[0]->GetPixel(startPhiIndex);
-    ++ItIn;
-  }
+    },
+    nullptr);
 }
 
 template <typename TInputPointSet, typename TOutputImage>
@@ -1028,35 +1169,7 @@ BSplineScatteredDataPointSetToImageFilter<TInputPointSet, TOutputImage>::Collaps
       idx[dimension] = static_cast<unsigned int>(u) + i;
       RealType v = u - idx[dimension] + 0.5 * static_cast<RealType>(this->m_SplineOrder[dimension] - 1);
 
-      RealType B = 0.0;
-      switch (this->m_SplineOrder[dimension])
-      {
-        case 0:
-        {
-          B = this->m_KernelOrder0->Evaluate(v);
-          break;
-        }
-        case 1:
-        {
-          B = this->m_KernelOrder1->Evaluate(v);
-          break;
-        }
-        case 2:
-        {
-          B = this->m_KernelOrder2->Evaluate(v);
-          break;
-        }
-        case 3:
-        {
-          B = this->m_KernelOrder3->Evaluate(v);
-          break;
-        }
-        default:
-        {
-          B = this->m_Kernel[dimension]->Evaluate(v);
-          break;
-        }
-      }
+      RealType B = this->EvaluateKernel(v, dimension);
       if (this->m_CloseDimension[dimension])
       {
         idx[dimension] %= lattice->GetLargestPossibleRegion().GetSize()[dimension];
@@ -1067,6 +1180,69 @@ BSplineScatteredDataPointSetToImageFilter<TInputPointSet, TOutputImage>::Collaps
   }
 }
 
+template <typename TInputPointSet, typename TOutputImage>
+typename BSplineScatteredDataPointSetToImageFilter<TInputPointSet, TOutputImage>::RealArrayType
+BSplineScatteredDataPointSetToImageFilter<TInputPointSet, TOutputImage>::TransformPointToParametricDomain(
+  const PointType &     point,
+  const RealArrayType & r,
+  const RealArrayType & epsilon) const
+{
+  RealArrayType p;
+  for (unsigned int i = 0; i < ImageDimension; i++)
+  {
+    unsigned int totalNumberOfSpans = this->m_CurrentNumberOfControlPoints[i] - this->m_SplineOrder[i];
+
+    p[i] = (point[i] - this->m_Origin[i]) * r[i];
+    if (std::abs(p[i] - static_cast<RealType>(totalNumberOfSpans)) <= epsilon[i])
+    {
+      p[i] = static_cast<RealType>(totalNumberOfSpans) - epsilon[i];
+    }
+    if (p[i] < NumericTraits<RealType>::ZeroValue() && std::abs(p[i]) <= epsilon[i])
+    {
+      p[i] = NumericTraits<RealType>::ZeroValue();
+    }
+
+    if (p[i] < NumericTraits<RealType>::ZeroValue() || p[i] >= static_cast<RealType>(totalNumberOfSpans))
+    {
+      itkExceptionMacro("The reparameterized point component "
+                        << p[i] << " is outside the corresponding parametric domain of [0, " << totalNumberOfSpans
+                        << ").");
+    }
+  }
+  return p;
+}
+
+template <typename TInputPointSet, typename TOutputImage>
+typename BSplineScatteredDataPointSetToImageFilter<TInputPointSet, TOutputImage>::KernelType::RealType
+BSplineScatteredDataPointSetToImageFilter<TInputPointSet, TOutputImage>::EvaluateKernel(
+  const RealType     u,
+  const unsigned int dimension) const
+{
+  switch (this->m_SplineOrder[dimension])
+  {
+    case 0:
+    {
+      return this->m_KernelOrder0->Evaluate(u);
+    }
+    case 1:
+    {
+      return this->m_KernelOrder1->Evaluate(u);
+    }
+    case 2:
+    {
+      return this->m_KernelOrder2->Evaluate(u);
+    }
+    case 3:
+    {
+      return this->m_KernelOrder3->Evaluate(u);
+    }
+    default:
+    {
+      return this->m_Kernel[dimension]->Evaluate(u);
+    }
+  }
+}
+
 template <typename TInputPointSet, typename TOutputImage>
 void
 BSplineScatteredDataPointSetToImageFilter<TInputPointSet, TOutputImage>::SetPhiLatticeParametricDomainParameters()
@@ -1138,6 +1314,7 @@ BSplineScatteredDataPointSetToImageFilter<TInputPointSet, TOutputImage>::PrintSe
   os << indent << "Do multi level: " << this->m_DoMultilevel << std::endl;
   os << indent << "Generate output image: " << this->m_GenerateOutputImage << std::endl;
   os << indent << "Use point weights: " << this->m_UsePointWeights << std::endl;
+  os << indent << "Sort points by lattice cell: " << this->m_SortPointsByLatticeCell << std::endl;
   os << indent << "Maximum number of levels: " << this->m_MaximumNumberOfLevels << std::endl;
   os << indent << "Current level: " << this->m_CurrentLevel << std::endl;
   os << indent << "Number of control points: " << this->m_NumberOfControlPoints << std::endl;
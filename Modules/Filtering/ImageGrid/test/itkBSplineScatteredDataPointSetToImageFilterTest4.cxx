@@ -19,6 +19,7 @@
 #include "itkPointSet.h"
 #include "itkBSplineScatteredDataPointSetToImageFilter.h"
 #include "itkBSplineTransform.h"
+#include "itkImageRegionConstIterator.h"
 #include "itkVectorIndexSelectionCastImageFilter.h"
 #include "itkVectorLinearInterpolateImageFunction.h"
 #include "itkTestingMacros.h"
@@ -172,6 +173,39 @@ itkBSplineScatteredDataPointSetToImageFilterTest4(int, char *[])
   ITK_TRY_EXPECT_NO_EXCEPTION(filter->Update());
 
 
+  // Fitting the points sorted by lattice cell only changes the rounding of
+  // the control point lattice
+  FilterType::Pointer sortingFilter = FilterType::New();
+  ITK_TEST_SET_GET_BOOLEAN(sortingFilter, SortPointsByLatticeCell, true);
+
+  sortingFilter->SetOrigin(origin);
+  sortingFilter->SetSpacing(spacing);
+  sortingFilter->SetSize(size);
+  sortingFilter->SetDirection(direction);
+  sortingFilter->SetInput(pointSet);
+  sortingFilter->SetPointWeights(weights);
+  sortingFilter->SetGenerateOutputImage(false);
+  sortingFilter->SetSplineOrder(SplineOrder);
+  sortingFilter->SetNumberOfControlPoints(ncps);
+  sortingFilter->SetNumberOfLevels(3);
+  sortingFilter->SetCloseDimension(close);
+
+  ITK_TRY_EXPECT_NO_EXCEPTION(sortingFilter->Update());
+
+  const VectorImageType::RegionType              latticeRegion = filter->GetPhiLattice()->GetLargestPossibleRegion();
+  itk::ImageRegionConstIterator<VectorImageType> ItPhi(filter->GetPhiLattice(), latticeRegion);
+  itk::ImageRegionConstIterator<VectorImageType> ItSortedPhi(sortingFilter->GetPhiLattice(), latticeRegion);
+  for (; !ItPhi.IsAtEnd(); ++ItPhi, ++ItSortedPhi)
+  {
+    if ((ItPhi.Get() - ItSortedPhi.Get()).GetNorm() > 1e-4 * (1.0 + ItPhi.Get().GetNorm()))
+    {
+      std::cerr << "The control point lattice fitted to the sorted points is " << ItSortedPhi.Get() << " instead of "
+                << ItPhi.Get() << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+
+
   // Instantiate the BSpline transform
 
   using TransformType = itk::BSplineTransform<float, DataDimension, SplineOrder>;
@@ -24,6 +24,7 @@
 #include <deque>
 #include <functional>
 #include <mutex>
+#include <numeric>
 #include <vector>
 
 namespace itk
@@ -134,7 +135,10 @@ protected:
 
   using LineMapType = std::vector<LineEncodingType>;
 
-  using UnionFindType = std::vector<InternalLabelType>;
+  /** The union-find forest is shared by all work units. Parents always
+   * have a smaller label than their children, so the root of each set is
+   * its smallest label, and links are made with compare-and-swap. */
+  using UnionFindType = std::vector<std::atomic<InternalLabelType>>;
   using ConsecutiveVectorType = std::vector<OutputPixelType>;
 
   SizeValueType
@@ -153,82 +157,194 @@ protected:
     return linearIndex;
   }
 
+  /** Split the range [begin, end) into numberOfBlocks contiguous blocks
+   * and process them in parallel. The function is called with the block
+   * number and the range of the block. */
+  using BlockFunctionType = std::function<void(SizeValueType, SizeValueType, SizeValueType)>;
+
+  void
+  ParallelizeBlocks(SizeValueType             begin,
+                    SizeValueType             end,
+                    SizeValueType             numberOfBlocks,
+                    const BlockFunctionType & blockFunction)
+  {
+    const SizeValueType count = end - begin;
+    m_EnclosingFilter->GetMultiThreader()->ParallelizeArray(
+      0,
+      numberOfBlocks,
+      [begin, count, numberOfBlocks, &blockFunction](SizeValueType block) {
+        blockFunction(
+          block, begin + block * count / numberOfBlocks, begin + (block + 1) * count / numberOfBlocks);
+      },
+      nullptr);
+  }
+
+  /** Number of blocks used to scan count elements, one per work unit. */
+  SizeValueType
+  GetNumberOfBlocks(SizeValueType count) const
+  {
+    const SizeValueType numberOfWorkUnits = m_EnclosingFilter->GetNumberOfWorkUnits();
+    return std::max<SizeValueType>(1, std::min<SizeValueType>(count, numberOfWorkUnits));
+  }
+
   void
   InitUnion(InternalLabelType numberOfLabels)
   {
     m_UnionFind = UnionFindType(numberOfLabels + 1);
 
-    typename LineMapType::iterator MapBegin, MapEnd, LineIt;
-    MapBegin = m_LineMap.begin();
-    MapEnd = m_LineMap.end();
-    LineIt = MapBegin;
-    InternalLabelType label = 1;
-    for (LineIt = MapBegin; LineIt != MapEnd; ++LineIt)
-    {
-      LineEncodingIterator cIt;
-      for (cIt = LineIt->begin(); cIt != LineIt->end(); ++cIt)
-      {
-        cIt->label = label;
-        m_UnionFind[label] = label;
-        label++;
-      }
-    }
+    // Label the runs in raster order: count the runs of blocks of lines,
+    // then each block numbers its runs from the prefix sum of the counts.
+    const SizeValueType            numberOfLines = m_LineMap.size();
+    const SizeValueType            numberOfBlocks = this->GetNumberOfBlocks(numberOfLines);
+    std::vector<InternalLabelType> firstLabel(numberOfBlocks + 1, 0);
+
+    this->ParallelizeBlocks(
+      0, numberOfLines, numberOfBlocks, [this, &firstLabel](SizeValueType block, SizeValueType b, SizeValueType e) {
+        InternalLabelType count = 0;
+        for (SizeValueType line = b; line < e; ++line)
+        {
+          count += m_LineMap[line].size();
+        }
+        firstLabel[block + 1] = count;
+      });
+
+    firstLabel[0] = 1;
+    std::partial_sum(firstLabel.begin(), firstLabel.end(), firstLabel.begin());
+
+    this->ParallelizeBlocks(
+      0, numberOfLines, numberOfBlocks, [this, &firstLabel](SizeValueType block, SizeValueType b, SizeValueType e) {
+        InternalLabelType label = firstLabel[block];
+        for (SizeValueType line = b; line < e; ++line)
+        {
+          for (auto & run : m_LineMap[line])
+          {
+            run.label = label;
+            m_UnionFind[label].store(label, std::memory_order_relaxed);
+            ++label;
+          }
+        }
+      });
   }
 
   InternalLabelType
   LookupSet(const InternalLabelType label)
   {
     InternalLabelType l = label;
-    while (l != m_UnionFind[l])
+    while (true)
     {
-      l = m_UnionFind[l]; // transitively sets equivalence
+      InternalLabelType parent = m_UnionFind[l].load(std::memory_order_relaxed);
+      if (parent == l)
+      {
+        return l;
+      }
+      const InternalLabelType grandParent = m_UnionFind[parent].load(std::memory_order_relaxed);
+      if (grandParent != parent)
+      {
+        // Path halving: the grand parent belongs to the same set, so any
+        // thread may shorten the path. A failure only means that another
+        // thread changed the link first.
+        m_UnionFind[l].compare_exchange_weak(parent, grandParent, std::memory_order_relaxed);
+      }
+      l = grandParent;
     }
-    return l;
   }
 
   void
   LinkLabels(const InternalLabelType label1, const InternalLabelType label2)
   {
-    std::lock_guard<std::mutex> mutexHolder(m_Mutex);
-    InternalLabelType           E1 = this->LookupSet(label1);
-    InternalLabelType           E2 = this->LookupSet(label2);
+    while (true)
+    {
+      InternalLabelType E1 = this->LookupSet(label1);
+      InternalLabelType E2 = this->LookupSet(label2);
+      if (E1 == E2)
+      {
+        return;
+      }
+      if (E1 < E2)
+      {
+        std::swap(E1, E2);
+      }
+      // Link the larger root to the smaller one, unless it stopped being a
+      // root in the meantime, in which case the lookup is repeated.
+      InternalLabelType expected = E1;
+      if (m_UnionFind[E1].compare_exchange_strong(expected, E2))
+      {
+        return;
+      }
+    }
+  }
 
-    if (E1 < E2)
+  /** Convert the index of an object, in raster order, to its output label.
+   * The labels start at 0 and skip the background value. */
+  static OutputPixelType
+  ObjectIndexToLabel(SizeValueType objectIndex, OutputPixelType backgroundValue)
+  {
+    auto label = static_cast<OutputPixelType>(objectIndex);
+    if (NumericTraits<OutputPixelType>::IsNonnegative(backgroundValue) &&
+        objectIndex >= static_cast<SizeValueType>(backgroundValue))
     {
-      m_UnionFind[E2] = E1;
+      ++label;
     }
-    else
+    return label;
+  }
+
+  /** Inverse of ObjectIndexToLabel(). */
+  static SizeValueType
+  LabelToObjectIndex(OutputPixelType label, OutputPixelType backgroundValue)
+  {
+    auto objectIndex = static_cast<SizeValueType>(label);
+    if (NumericTraits<OutputPixelType>::IsNonnegative(backgroundValue) && label > backgroundValue)
     {
-      m_UnionFind[E1] = E2;
+      --objectIndex;
     }
+    return objectIndex;
   }
 
   SizeValueType
   CreateConsecutive(OutputPixelType backgroundValue)
   {
-    const size_t N = m_UnionFind.size();
+    const SizeValueType N = m_UnionFind.size();
 
     m_Consecutive = ConsecutiveVectorType(N);
     m_Consecutive[0] = backgroundValue;
 
-    OutputPixelType consecutiveLabel = 0;
-    SizeValueType   count = 0;
+    // The roots are numbered in order: count the roots of each block, then
+    // each block numbers its roots from the prefix sum of the counts.
+    const SizeValueType        numberOfBlocks = this->GetNumberOfBlocks(N - 1);
+    std::vector<SizeValueType> firstObject(numberOfBlocks + 1, 0);
 
-    for (size_t i = 1; i < N; i++)
-    {
-      const auto label = static_cast<size_t>(m_UnionFind[i]);
-      if (label == i)
-      {
-        if (consecutiveLabel == backgroundValue)
+    this->ParallelizeBlocks(
+      1, N, numberOfBlocks, [this, &firstObject](SizeValueType block, SizeValueType b, SizeValueType e) {
+        SizeValueType count = 0;
+        for (SizeValueType i = b; i < e; ++i)
         {
-          ++consecutiveLabel;
+          if (m_UnionFind[i].load(std::memory_order_relaxed) == i)
+          {
+            ++count;
+          }
         }
-        m_Consecutive[label] = consecutiveLabel;
-        ++consecutiveLabel;
-        ++count;
-      }
-    }
-    return count;
+        firstObject[block + 1] = count;
+      });
+
+    std::partial_sum(firstObject.begin(), firstObject.end(), firstObject.begin());
+
+    this->ParallelizeBlocks(
+      1,
+      N,
+      numberOfBlocks,
+      [this, &firstObject, backgroundValue](SizeValueType block, SizeValueType b, SizeValueType e) {
+        SizeValueType objectIndex = firstObject[block];
+        for (SizeValueType i = b; i < e; ++i)
+        {
+          if (m_UnionFind[i].load(std::memory_order_relaxed) == i)
+          {
+            m_Consecutive[i] = ObjectIndexToLabel(objectIndex, backgroundValue);
+            ++objectIndex;
+          }
+        }
+      });
+
+    return firstObject.back();
   }
 
   bool
@@ -472,9 +588,8 @@ protected:
   void
   ComputeEquivalence(const SizeValueType workUnitResultsIndex, bool strictlyLess)
   {
-    const OffsetValueType linecount = m_LineMap.size();
-    WorkUnitData          wud = m_WorkUnitResults[workUnitResultsIndex];
-    SizeValueType         lastLine = wud.lastLine;
+    WorkUnitData  wud = m_WorkUnitResults[workUnitResultsIndex];
+    SizeValueType lastLine = wud.lastLine;
     if (!strictlyLess)
     {
       lastLine++;
@@ -483,32 +598,42 @@ protected:
     }
     for (SizeValueType thisIdx = wud.firstLine; thisIdx < lastLine; ++thisIdx)
     {
-      if (!m_LineMap[thisIdx].empty())
+      this->ComputeLineEquivalence(thisIdx);
+    }
+  }
+
+  /* Link the runs of a line with the runs of its previous neighbor lines.
+   * As the linking is lock free, lines may be processed in any order and
+   * by any number of threads. */
+  void
+  ComputeLineEquivalence(const SizeValueType thisIdx)
+  {
+    const OffsetValueType linecount = m_LineMap.size();
+    if (!m_LineMap[thisIdx].empty())
+    {
+      auto it = this->m_LineOffsets.begin();
+      while (it != this->m_LineOffsets.end())
       {
-        auto it = this->m_LineOffsets.begin();
-        while (it != this->m_LineOffsets.end())
+        OffsetValueType neighIdx = thisIdx + (*it);
+        // check if the neighbor is in the map
+        if (neighIdx >= 0 && neighIdx < linecount && !m_LineMap[neighIdx].empty())
         {
-          OffsetValueType neighIdx = thisIdx + (*it);
-          // check if the neighbor is in the map
-          if (neighIdx >= 0 && neighIdx < linecount && !m_LineMap[neighIdx].empty())
+          // Now check whether they are really neighbors
+          bool areNeighbors = this->CheckNeighbors(m_LineMap[thisIdx][0].where, m_LineMap[neighIdx][0].where);
+          if (areNeighbors)
           {
-            // Now check whether they are really neighbors
-            bool areNeighbors = this->CheckNeighbors(m_LineMap[thisIdx][0].where, m_LineMap[neighIdx][0].where);
-            if (areNeighbors)
-            {
-              this->CompareLines(m_LineMap[thisIdx],
-                                 m_LineMap[neighIdx],
-                                 false,
-                                 false,
-                                 0,
-                                 [this](const LineEncodingConstIterator & currentRun,
-                                        const LineEncodingConstIterator & neighborRun,
-                                        OffsetValueType,
-                                        OffsetValueType) { this->LinkLabels(neighborRun->label, currentRun->label); });
-            }
+            this->CompareLines(m_LineMap[thisIdx],
+                               m_LineMap[neighIdx],
+                               false,
+                               false,
+                               0,
+                               [this](const LineEncodingConstIterator & currentRun,
+                                      const LineEncodingConstIterator & neighborRun,
+                                      OffsetValueType,
+                                      OffsetValueType) { this->LinkLabels(neighborRun->label, currentRun->label); });
           }
-          ++it;
         }
+        ++it;
       }
     }
   }
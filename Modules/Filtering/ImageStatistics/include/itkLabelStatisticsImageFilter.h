@@ -19,6 +19,7 @@
 #define itkLabelStatisticsImageFilter_h
 
 #include "itkImageSink.h"
+#include "itkCompensatedSummation.h"
 #include "itkNumericTraits.h"
 #include "itkSimpleDataObjectDecorator.h"
 #include "itkHistogram.h"
@@ -35,10 +36,10 @@ namespace itk
  * LabelStatisticsImageFilter computes the minimum, maximum, sum,
  * mean, median, variance and sigma of regions of an intensity image, where
  * the regions are defined via a label map (a second input).  The
- * label image should be integral type. The filter needs all of its
- * input image.  It behaves as a filter with an input and output. Thus
- * it can be inserted in a pipline with other filters and the
- * statistics will only be recomputed if a downstream filter changes.
+ * label image should be integral type. It behaves as a filter with an
+ * input and output. Thus it can be inserted in a pipline with other
+ * filters and the statistics will only be recomputed if a downstream
+ * filter changes.
  *
  * Optionally, the filter also computes intensity histograms on each
  * object. If histograms are enabled, a median intensity value can
@@ -49,7 +50,11 @@ namespace itk
  * This filter is automatically multi-threaded and can stream its
  * input when NumberOfStreamDivisions is set to more than
  * 1. Statistics are independently computed for each streamed and
- * threaded region then merged.
+ * threaded region then merged, so only one piece of the inputs needs to
+ * be in memory at a time, and the memory used by the statistics only
+ * depends on the number of labels (and on the number of bins of the
+ * histograms, when enabled). The sums are computed with a compensated
+ * summation, to keep their accuracy on very large images.
  *
  * \ingroup MathematicalStatisticsImageFilters
  * \ingroup ITKImageStatistics
@@ -193,6 +198,8 @@ public:
       m_Mean = l.m_Mean;
       m_Sum = l.m_Sum;
       m_SumOfSquares = l.m_SumOfSquares;
+      m_CompensatedSum = l.m_CompensatedSum;
+      m_CompensatedSumOfSquares = l.m_CompensatedSumOfSquares;
       m_Sigma = l.m_Sigma;
       m_Variance = l.m_Variance;
       m_BoundingBox = l.m_BoundingBox;
@@ -213,6 +220,8 @@ public:
         m_Mean = l.m_Mean;
         m_Sum = l.m_Sum;
         m_SumOfSquares = l.m_SumOfSquares;
+        m_CompensatedSum = l.m_CompensatedSum;
+        m_CompensatedSumOfSquares = l.m_CompensatedSumOfSquares;
         m_Sigma = l.m_Sigma;
         m_Variance = l.m_Variance;
         m_BoundingBox = l.m_BoundingBox;
@@ -231,6 +240,14 @@ public:
     RealType                        m_Variance;
     BoundingBoxType                 m_BoundingBox;
     typename HistogramType::Pointer m_Histogram;
+
+  private:
+    friend class LabelStatisticsImageFilter;
+
+    // The sums are accumulated with compensation of the rounding errors, and
+    // copied to m_Sum and m_SumOfSquares when the statistics are computed.
+    CompensatedSummation<RealType> m_CompensatedSum;
+    CompensatedSummation<RealType> m_CompensatedSumOfSquares;
   };
 
   /** Type of the map used to store data per label */
@@ -22,6 +22,7 @@
 #include "itkImageLinearConstIteratorWithIndex.h"
 #include "itkImageScanlineConstIterator.h"
 #include "itkTotalProgressReporter.h"
+#include <algorithm>
 
 namespace itk
 {
@@ -73,8 +74,8 @@ LabelStatisticsImageFilter<TInputImage, TLabelImage>::MergeMap(MapType & m1, Map
 
       // accumulate the information from this thread
       labelStats.m_Count += m2_value.second.m_Count;
-      labelStats.m_Sum += m2_value.second.m_Sum;
-      labelStats.m_SumOfSquares += m2_value.second.m_SumOfSquares;
+      labelStats.m_CompensatedSum += m2_value.second.m_CompensatedSum;
+      labelStats.m_CompensatedSumOfSquares += m2_value.second.m_CompensatedSumOfSquares;
 
       if (labelStats.m_Minimum > m2_value.second.m_Minimum)
       {
@@ -124,6 +125,8 @@ LabelStatisticsImageFilter<TInputImage, TLabelImage>::AfterStreamedGenerateData(
   {
     typename MapType::mapped_type & labelStats = mapValue.second;
 
+    labelStats.m_Sum = labelStats.m_CompensatedSum.GetSum();
+    labelStats.m_SumOfSquares = labelStats.m_CompensatedSumOfSquares.GetSum();
     labelStats.m_Mean = labelStats.m_Sum / static_cast<RealType>(labelStats.m_Count);
 
     // variance
@@ -131,7 +134,8 @@ LabelStatisticsImageFilter<TInputImage, TLabelImage>::AfterStreamedGenerateData(
     {
       // unbiased estimate of variance
       LabelStatistics & ls = mapValue.second;
-      const RealType    sumSquared = ls.m_Sum * ls.m_Sum;
+      const RealType    sum = ls.m_Sum;
+      const RealType    sumSquared = sum * sum;
       const auto        count = static_cast<RealType>(ls.m_Count);
 
       ls.m_Variance = (ls.m_SumOfSquares - sumSquared / count) / (count - 1.0);
@@ -186,14 +190,19 @@ LabelStatisticsImageFilter<TInputImage, TLabelImage>::ThreadedStreamedGenerateDa
   // do the work
   while (!it.IsAtEnd())
   {
+    const IndexType lineIndex = it.GetIndex();
+    IndexValueType  runStart = lineIndex[0];
     while (!it.IsAtEndOfLine())
     {
-      const RealType & value = static_cast<RealType>(it.Get());
-
-      const LabelPixelType & label = labelIt.Get();
+      // The labels come in runs along the lines, so the statistics of a label
+      // are only looked up once per run
+      const LabelPixelType label = labelIt.Get();
 
       // is the label already in this thread?
-      mapIt = localStatistics.find(label);
+      if (mapIt == localStatistics.end() || mapIt->first != label)
+      {
+        mapIt = localStatistics.find(label);
+      }
       if (mapIt == localStatistics.end())
       {
         // create a new statistics object
@@ -209,45 +218,54 @@ LabelStatisticsImageFilter<TInputImage, TLabelImage>::ThreadedStreamedGenerateDa
 
       typename MapType::mapped_type & labelStats = mapIt->second;
 
-      // update the values for this label and this thread
-      if (value < labelStats.m_Minimum)
+      // update the values for this label and this thread, over the run
+      IndexValueType runEnd = runStart;
+      do
       {
-        labelStats.m_Minimum = value;
-      }
-      if (value > labelStats.m_Maximum)
-      {
-        labelStats.m_Maximum = value;
-      }
+        const RealType & value = static_cast<RealType>(it.Get());
 
-      // bounding box is min,max pairs
-      for (unsigned int i = 0; i < (2 * TInputImage::ImageDimension); i += 2)
-      {
-        const IndexType & index = it.GetIndex();
-        if (labelStats.m_BoundingBox[i] > index[i / 2])
+        if (value < labelStats.m_Minimum)
         {
-          labelStats.m_BoundingBox[i] = index[i / 2];
+          labelStats.m_Minimum = value;
         }
-        if (labelStats.m_BoundingBox[i + 1] < index[i / 2])
+        if (value > labelStats.m_Maximum)
         {
-          labelStats.m_BoundingBox[i + 1] = index[i / 2];
+          labelStats.m_Maximum = value;
         }
-      }
 
-      labelStats.m_Sum += value;
-      labelStats.m_SumOfSquares += (value * value);
-      labelStats.m_Count++;
+        labelStats.m_CompensatedSum += value;
+        labelStats.m_CompensatedSumOfSquares += (value * value);
 
-      // if enabled, update the histogram for this label
-      if (m_UseHistograms)
-      {
-        histogramMeasurement[0] = value;
-        labelStats.m_Histogram->GetIndex(histogramMeasurement, histogramIndex);
-        labelStats.m_Histogram->IncreaseFrequencyOfIndex(histogramIndex, 1);
-      }
+        // if enabled, update the histogram for this label
+        if (m_UseHistograms)
+        {
+          histogramMeasurement[0] = value;
+          labelStats.m_Histogram->GetIndex(histogramMeasurement, histogramIndex);
+          labelStats.m_Histogram->IncreaseFrequencyOfIndex(histogramIndex, 1);
+        }
+
+        ++labelIt;
+        ++it;
+        ++runEnd;
+      } while (!it.IsAtEndOfLine() && labelIt.Get() == label);
 
+      labelStats.m_Count += static_cast<IdentifierType>(runEnd - runStart);
 
-      ++labelIt;
-      ++it;
+      // bounding box is min,max pairs
+      labelStats.m_BoundingBox[0] = std::min(labelStats.m_BoundingBox[0], runStart);
+      labelStats.m_BoundingBox[1] = std::max(labelStats.m_BoundingBox[1], runEnd - 1);
+      for (unsigned int i = 2; i < (2 * TInputImage::ImageDimension); i += 2)
+      {
+        if (labelStats.m_BoundingBox[i] > lineIndex[i / 2])
+        {
+          labelStats.m_BoundingBox[i] = lineIndex[i / 2];
+        }
+        if (labelStats.m_BoundingBox[i + 1] < lineIndex[i / 2])
+        {
+          labelStats.m_BoundingBox[i + 1] = lineIndex[i / 2];
+        }
+      }
+      runStart = runEnd;
     }
     labelIt.NextLine();
     it.NextLine();
@@ -0,0 +1,177 @@
+/*=========================================================================
+ *
+ *  Copyright NumFOCUS
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include "itkBinaryThresholdImageFilter.h"
+#include "itkCastImageFilter.h"
+#include "itkImageFileReader.h"
+#include "itkImageFileWriter.h"
+#include "itkLabelStatisticsImageFilter.h"
+#include "itkRLEImage.h"
+#include "itkTestingMacros.h"
+
+namespace
+{
+constexpr unsigned int Dimension = 3;
+using LabelImageType = itk::Image<unsigned char, Dimension>;
+using RLELabelImageType = itk::RLEImage<unsigned char, Dimension>;
+using ImageType = itk::Image<float, Dimension>;
+
+template <typename TImage>
+bool
+CompareLabelImages(const TImage * image, const LabelImageType * reference)
+{
+  itk::ImageRegionConstIteratorWithIndex<TImage> it(image, reference->GetLargestPossibleRegion());
+  itk::ImageRegionConstIterator<LabelImageType>  referenceIt(reference, reference->GetLargestPossibleRegion());
+  for (; !referenceIt.IsAtEnd(); ++it, ++referenceIt)
+  {
+    if (it.Get() != referenceIt.Get())
+    {
+      std::cerr << "Test failed!" << std::endl;
+      std::cerr << "Error at index " << it.GetIndex() << std::endl;
+      std::cerr << "Expected: " << static_cast<int>(referenceIt.Get()) << ", but got: " << static_cast<int>(it.Get())
+                << std::endl;
+      return false;
+    }
+  }
+  return true;
+}
+} // namespace
+
+// Thresholds a run-length encoded label image, computes label statistics
+// with it and writes it, and compares the results with the ones obtained
+// with a dense label image.
+int
+itkLabelStatisticsImageFilterRLEImageTest(int argc, char * argv[])
+{
+  if (argc < 2)
+  {
+    std::cerr << "Missing parameters." << std::endl;
+    std::cerr << "Usage: " << itkNameOfTestExecutableMacro(argv) << " outputImage" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  // Nested boxes and slabs
+  LabelImageType::SizeType size = { { 70, 45, 30 } };
+  LabelImageType::Pointer  labels = LabelImageType::New();
+  labels->SetRegions(size);
+  labels->Allocate();
+
+  ImageType::Pointer image = ImageType::New();
+  image->SetRegions(size);
+  image->Allocate();
+
+  itk::ImageRegionIteratorWithIndex<LabelImageType> labelIt(labels, labels->GetLargestPossibleRegion());
+  itk::ImageRegionIterator<ImageType>               imageIt(image, image->GetLargestPossibleRegion());
+  for (; !labelIt.IsAtEnd(); ++labelIt, ++imageIt)
+  {
+    const LabelImageType::IndexType & idx = labelIt.GetIndex();
+    unsigned char                     label = 0;
+    if (idx[0] > 10 && idx[0] < 60 && idx[1] > 5 && idx[1] < 40)
+    {
+      label = (idx[2] < 10) ? 1 : 2;
+      if (idx[0] > 30 && idx[0] < 40 && idx[1] > 15 && idx[1] < 20)
+      {
+        label = 3;
+      }
+    }
+    else if (idx[0] % 20 == 0)
+    {
+      label = 4;
+    }
+    labelIt.Set(label);
+    imageIt.Set(static_cast<float>(idx[0] + 2 * idx[1] - idx[2]));
+  }
+
+  // Conversion to a run-length encoded label image
+  using ToRLEFilterType = itk::CastImageFilter<LabelImageType, RLELabelImageType>;
+  ToRLEFilterType::Pointer toRLE = ToRLEFilterType::New();
+  toRLE->SetInput(labels);
+  ITK_TRY_EXPECT_NO_EXCEPTION(toRLE->Update());
+
+  RLELabelImageType::Pointer rleLabels = toRLE->GetOutput();
+  std::cout << "Number of segments: " << rleLabels->GetNumberOfSegments() << std::endl;
+  ITK_TEST_EXPECT_TRUE(CompareLabelImages<RLELabelImageType>(rleLabels, labels));
+  ITK_TEST_EXPECT_TRUE(rleLabels->GetNumberOfSegments() < labels->GetLargestPossibleRegion().GetNumberOfPixels() / 5);
+
+  // Thresholding, in place
+  using ThresholdFilterType = itk::BinaryThresholdImageFilter<RLELabelImageType, RLELabelImageType>;
+  ToRLEFilterType::Pointer toRLE2 = ToRLEFilterType::New();
+  toRLE2->SetInput(labels);
+  ThresholdFilterType::Pointer threshold = ThresholdFilterType::New();
+  threshold->SetInput(toRLE2->GetOutput());
+  threshold->SetLowerThreshold(2);
+  threshold->SetUpperThreshold(3);
+  threshold->SetInsideValue(1);
+  threshold->SetOutsideValue(0);
+  threshold->InPlaceOn();
+  ITK_TRY_EXPECT_NO_EXCEPTION(threshold->Update());
+
+  using DenseThresholdFilterType = itk::BinaryThresholdImageFilter<LabelImageType, LabelImageType>;
+  DenseThresholdFilterType::Pointer denseThreshold = DenseThresholdFilterType::New();
+  denseThreshold->SetInput(labels);
+  denseThreshold->SetLowerThreshold(2);
+  denseThreshold->SetUpperThreshold(3);
+  denseThreshold->SetInsideValue(1);
+  denseThreshold->SetOutsideValue(0);
+  ITK_TRY_EXPECT_NO_EXCEPTION(denseThreshold->Update());
+  ITK_TEST_EXPECT_TRUE(CompareLabelImages<RLELabelImageType>(threshold->GetOutput(), denseThreshold->GetOutput()));
+
+  // Label statistics, streamed
+  using StatisticsFilterType = itk::LabelStatisticsImageFilter<ImageType, RLELabelImageType>;
+  StatisticsFilterType::Pointer statistics = StatisticsFilterType::New();
+  statistics->SetInput(image);
+  statistics->SetLabelInput(toRLE->GetOutput());
+  statistics->SetNumberOfStreamDivisions(3);
+  ITK_TRY_EXPECT_NO_EXCEPTION(statistics->Update());
+
+  using DenseStatisticsFilterType = itk::LabelStatisticsImageFilter<ImageType, LabelImageType>;
+  DenseStatisticsFilterType::Pointer denseStatistics = DenseStatisticsFilterType::New();
+  denseStatistics->SetInput(image);
+  denseStatistics->SetLabelInput(labels);
+  ITK_TRY_EXPECT_NO_EXCEPTION(denseStatistics->Update());
+
+  ITK_TEST_EXPECT_EQUAL(statistics->GetNumberOfLabels(), denseStatistics->GetNumberOfLabels());
+  for (unsigned char label = 0; label < 5; ++label)
+  {
+    ITK_TEST_EXPECT_EQUAL(statistics->GetCount(label), denseStatistics->GetCount(label));
+    ITK_TEST_EXPECT_EQUAL(statistics->GetMinimum(label), denseStatistics->GetMinimum(label));
+    ITK_TEST_EXPECT_EQUAL(statistics->GetMaximum(label), denseStatistics->GetMaximum(label));
+    ITK_TEST_EXPECT_EQUAL(statistics->GetSum(label), denseStatistics->GetSum(label));
+    ITK_TEST_EXPECT_EQUAL(statistics->GetRegion(label), denseStatistics->GetRegion(label));
+  }
+
+  // Writing, in a single piece and streamed
+  using WriterType = itk::ImageFileWriter<RLELabelImageType>;
+  using ReaderType = itk::ImageFileReader<LabelImageType>;
+  for (unsigned int numberOfStreamDivisions = 1; numberOfStreamDivisions <= 4; numberOfStreamDivisions += 3)
+  {
+    WriterType::Pointer writer = WriterType::New();
+    writer->SetInput(toRLE->GetOutput());
+    writer->SetFileName(argv[1]);
+    writer->SetNumberOfStreamDivisions(numberOfStreamDivisions);
+    ITK_TRY_EXPECT_NO_EXCEPTION(writer->Update());
+
+    ReaderType::Pointer reader = ReaderType::New();
+    reader->SetFileName(argv[1]);
+    ITK_TRY_EXPECT_NO_EXCEPTION(reader->Update());
+    ITK_TEST_EXPECT_TRUE(CompareLabelImages<LabelImageType>(reader->GetOutput(), labels));
+  }
+
+  std::cout << "Test finished." << std::endl;
+  return EXIT_SUCCESS;
+}
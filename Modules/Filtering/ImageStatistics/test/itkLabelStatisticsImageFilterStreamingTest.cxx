@@ -0,0 +1,137 @@
+/*=========================================================================
+ *
+ *  Copyright NumFOCUS
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include "itkImageRegionIterator.h"
+#include "itkImageRegionIteratorWithIndex.h"
+#include "itkLabelStatisticsImageFilter.h"
+#include "itkTestingMacros.h"
+#include <map>
+
+namespace
+{
+constexpr unsigned int Dimension = 3;
+using ImageType = itk::Image<double, Dimension>;
+using LabelImageType = itk::Image<unsigned short, Dimension>;
+using FilterType = itk::LabelStatisticsImageFilter<ImageType, LabelImageType>;
+
+// Statistics computed pixel by pixel
+struct ReferenceStatistics
+{
+  itk::SizeValueType        Count{ 0 };
+  double                    Minimum{ itk::NumericTraits<double>::max() };
+  double                    Maximum{ itk::NumericTraits<double>::NonpositiveMin() };
+  LabelImageType::IndexType Min{ { 1000, 1000, 1000 } };
+  LabelImageType::IndexType Max{ { -1, -1, -1 } };
+};
+} // namespace
+
+// Computes the label statistics in several stream pieces and work units,
+// and compares them with the ones computed pixel by pixel.
+int
+itkLabelStatisticsImageFilterStreamingTest(int, char *[])
+{
+  // Slabs of labels cut by a sphere, so that the labels come in runs of
+  // various lengths along the lines
+  ImageType::SizeType size = { { 100, 80, 125 } };
+  ImageType::Pointer  image = ImageType::New();
+  image->SetRegions(size);
+  image->Allocate();
+
+  LabelImageType::Pointer labels = LabelImageType::New();
+  labels->SetRegions(size);
+  labels->Allocate();
+
+  std::map<unsigned short, ReferenceStatistics> reference;
+
+  itk::ImageRegionIteratorWithIndex<LabelImageType> labelIt(labels, labels->GetLargestPossibleRegion());
+  itk::ImageRegionIterator<ImageType>               imageIt(image, image->GetLargestPossibleRegion());
+  for (; !labelIt.IsAtEnd(); ++labelIt, ++imageIt)
+  {
+    const LabelImageType::IndexType & idx = labelIt.GetIndex();
+    const double                      dx = idx[0] - 40.0;
+    const double                      dy = idx[1] - 45.0;
+    const double                      dz = idx[2] - 60.0;
+    unsigned short                    label = static_cast<unsigned short>(idx[2] / 10 + 20 * (idx[1] / 40));
+    if (dx * dx + dy * dy + dz * dz < 900)
+    {
+      label = static_cast<unsigned short>(100 + idx[0] % 3);
+    }
+    // Values which are not exactly represented, to check the accuracy of the sums
+    const double value = 0.1 * (1 + label % 4);
+    labelIt.Set(label);
+    imageIt.Set(value);
+
+    ReferenceStatistics & stats = reference[label];
+    stats.Count++;
+    stats.Minimum = std::min(stats.Minimum, value);
+    stats.Maximum = std::max(stats.Maximum, value);
+    for (unsigned int i = 0; i < Dimension; ++i)
+    {
+      stats.Min[i] = std::min(stats.Min[i], idx[i]);
+      stats.Max[i] = std::max(stats.Max[i], idx[i]);
+    }
+  }
+
+  FilterType::Pointer filter = FilterType::New();
+  filter->SetInput(image);
+  filter->SetLabelInput(labels);
+  filter->SetHistogramParameters(40, 0.0, 0.5);
+
+  ITK_EXERCISE_BASIC_OBJECT_METHODS(filter, LabelStatisticsImageFilter, ImageSink);
+
+  for (unsigned int numberOfStreamDivisions : { 1, 7 })
+  {
+    for (itk::ThreadIdType numberOfWorkUnits : { 1, 3 })
+    {
+      std::cout << "Stream divisions: " << numberOfStreamDivisions << ", work units: " << numberOfWorkUnits
+                << std::endl;
+      filter->SetNumberOfStreamDivisions(numberOfStreamDivisions);
+      filter->SetNumberOfWorkUnits(numberOfWorkUnits);
+      filter->Modified();
+      ITK_TRY_EXPECT_NO_EXCEPTION(filter->Update());
+
+      ITK_TEST_EXPECT_EQUAL(filter->GetNumberOfLabels(), reference.size());
+      for (const auto & labelStats : reference)
+      {
+        const unsigned short        label = labelStats.first;
+        const ReferenceStatistics & stats = labelStats.second;
+        const double                value = 0.1 * (1 + label % 4);
+
+        ITK_TEST_EXPECT_TRUE(filter->HasLabel(label));
+        ITK_TEST_EXPECT_EQUAL(filter->GetCount(label), stats.Count);
+        ITK_TEST_EXPECT_EQUAL(filter->GetMinimum(label), stats.Minimum);
+        ITK_TEST_EXPECT_EQUAL(filter->GetMaximum(label), stats.Maximum);
+        LabelImageType::SizeType regionSize;
+        for (unsigned int i = 0; i < Dimension; ++i)
+        {
+          regionSize[i] = stats.Max[i] - stats.Min[i] + 1;
+        }
+        ITK_TEST_EXPECT_EQUAL(filter->GetRegion(label), LabelImageType::RegionType(stats.Min, regionSize));
+        // The sums are accurate up to a few units in the last place
+        ITK_TEST_EXPECT_TRUE(std::abs(filter->GetSum(label) - stats.Count * value) <=
+                             1e-14 * stats.Count * value);
+        ITK_TEST_EXPECT_TRUE(std::abs(filter->GetMean(label) - value) <= 1e-14);
+        ITK_TEST_EXPECT_TRUE(filter->GetSigma(label) < 1e-6);
+        ITK_TEST_EXPECT_EQUAL(filter->GetHistogram(label)->GetTotalFrequency(), stats.Count);
+      }
+    }
+  }
+
+  std::cout << "Test finished." << std::endl;
+  return EXIT_SUCCESS;
+}
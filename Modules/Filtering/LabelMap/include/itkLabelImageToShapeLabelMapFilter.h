@@ -129,6 +129,13 @@ public:
   itkGetConstReferenceMacro(ComputeOrientedBoundingBox, bool);
   itkBooleanMacro(ComputeOrientedBoundingBox);
 
+  /**
+   * Set/Get the number of lines from which a label object is processed
+   * with all the work units, instead of a single one. Default value is 8192.
+   */
+  itkSetMacro(LargeObjectNumberOfLines, SizeValueType);
+  itkGetConstMacro(LargeObjectNumberOfLines, SizeValueType);
+
 
 protected:
   LabelImageToShapeLabelMapFilter();
@@ -155,6 +162,7 @@ private:
   bool                 m_ComputeFeretDiameter;
   bool                 m_ComputePerimeter;
   bool                 m_ComputeOrientedBoundingBox;
+  SizeValueType        m_LargeObjectNumberOfLines;
 }; // end of class
 } // end namespace itk
 
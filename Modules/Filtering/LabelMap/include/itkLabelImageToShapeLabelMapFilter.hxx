@@ -30,6 +30,7 @@ LabelImageToShapeLabelMapFilter<TInputImage, TOutputImage>::LabelImageToShapeLab
   m_ComputeFeretDiameter = false;
   m_ComputePerimeter = true;
   m_ComputeOrientedBoundingBox = false;
+  m_LargeObjectNumberOfLines = 8192;
 }
 
 template <typename TInputImage, typename TOutputImage>
@@ -78,6 +79,7 @@ LabelImageToShapeLabelMapFilter<TInputImage, TOutputImage>::GenerateData()
   valuator->SetComputePerimeter(m_ComputePerimeter);
   valuator->SetComputeFeretDiameter(m_ComputeFeretDiameter);
   valuator->SetComputeOrientedBoundingBox(m_ComputeOrientedBoundingBox);
+  valuator->SetLargeObjectNumberOfLines(m_LargeObjectNumberOfLines);
   progress->RegisterInternalFilter(valuator, .5f);
 
   valuator->GraftOutput(this->GetOutput());
@@ -97,6 +99,7 @@ LabelImageToShapeLabelMapFilter<TInputImage, TOutputImage>::PrintSelf(std::ostre
   os << indent << "ComputeFeretDiameter: " << m_ComputeFeretDiameter << std::endl;
   os << indent << "ComputePerimeter: " << m_ComputePerimeter << std::endl;
   os << indent << "ComputeOrientedBoundingBox: " << m_ComputeOrientedBoundingBox << std::endl;
+  os << indent << "LargeObjectNumberOfLines: " << m_LargeObjectNumberOfLines << std::endl;
 }
 } // end namespace itk
 #endif
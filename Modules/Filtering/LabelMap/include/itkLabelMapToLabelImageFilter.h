@@ -28,6 +28,11 @@ namespace itk
  *
  * LabelMapToBinaryImageFilter to a label image.
  *
+ * The lines of the label objects are written through scanline iterators,
+ * so that the output image may be an RLEImage, in which case they are
+ * directly encoded in the output, and a dense label image is never
+ * allocated.
+ *
  * \author Gaetan Lehmann. Biologie du Developpement et de la Reproduction, INRA de Jouy-en-Josas, France.
  *
  * This implementation was taken from the Insight Journal paper:
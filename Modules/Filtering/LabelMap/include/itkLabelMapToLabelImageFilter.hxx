@@ -22,6 +22,7 @@
 #include "itkNumericTraits.h"
 #include "itkProgressReporter.h"
 #include "itkImageRegionConstIteratorWithIndex.h"
+#include "itkImageScanlineIterator.h"
 
 namespace itk
 {
@@ -50,13 +51,24 @@ template <typename TInputImage, typename TOutputImage>
 void
 LabelMapToLabelImageFilter<TInputImage, TOutputImage>::ThreadedProcessLabelObject(LabelObjectType * labelObject)
 {
-  const typename LabelObjectType::LabelType &  label = labelObject->GetLabel();
-  typename LabelObjectType::ConstIndexIterator it(labelObject);
+  const typename LabelObjectType::LabelType & label = labelObject->GetLabel();
+  typename LabelObjectType::ConstLineIterator lit(labelObject);
 
-  while (!it.IsAtEnd())
+  while (!lit.IsAtEnd())
   {
-    this->m_OutputImage->SetPixel(it.GetIndex(), label);
-    ++it;
+    // The lines of different label objects never overlap, and the iterators
+    // of an RLEImage lock the line while they encode their span in it
+    const typename LabelObjectType::LineType & line = lit.GetLine();
+    typename OutputImageType::SizeType         lineSize;
+    lineSize.Fill(1);
+    lineSize[0] = line.GetLength();
+    ImageScanlineIterator<OutputImageType> it(this->m_OutputImage, OutputImageRegionType(line.GetIndex(), lineSize));
+    while (!it.IsAtEndOfLine())
+    {
+      it.Set(label);
+      ++it;
+    }
+    ++lit;
   }
 }
 
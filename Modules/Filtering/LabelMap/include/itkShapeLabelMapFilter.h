@@ -19,6 +19,7 @@
 #define itkShapeLabelMapFilter_h
 
 #include "itkInPlaceLabelMapFilter.h"
+#include "itkContinuousIndex.h"
 #include "itkLexicographicCompare.h"
 
 namespace itk
@@ -30,15 +31,20 @@ namespace itk
  * ShapeLabelMapFilter can be used to set the attributes values of the
  * ShapeLabelObject in a LabelMap.
  *
- * ShapeLabelMapFilter takes an optional parameter, used only to
- * optimize the computation time and the memory usage when the
- * perimeter or the feret diameter is used: the exact copy of the
- * input LabelMap is stored in an Image.
- * It can be set with SetLabelImage(). It is cleared at the end of the
- * computation, so must be reset before running Update() again. It is
- * not part of the pipeline management design, to let the subclasses
- * of ShapeLabelMapFilter use the pipeline design to specify truly
- * required inputs.
+ * The label objects are processed concurrently. The large label objects,
+ * which would otherwise be processed by a single work unit while the other
+ * ones are done, are processed one at a time before the others, with their
+ * lines split among the work units. The number of lines above which a label
+ * object is considered as large can be set with SetLargeObjectNumberOfLines().
+ *
+ * The maximum Feret diameter is computed from the convex hull of the
+ * extremities of the lines of each label object, in O(n log(n)) in 2D.
+ *
+ * ShapeLabelMapFilter takes an optional parameter, the exact copy of the
+ * input LabelMap stored in an Image, which can be set with SetLabelImage().
+ * It is not needed anymore by any of the computed attributes, and is only
+ * kept for backward compatibility. It is cleared at the end of the
+ * computation.
  *
  * \author Gaetan Lehmann. Biologie du Developpement et de la Reproduction, INRA de Jouy-en-Josas, France.
  *
@@ -102,7 +108,7 @@ public:
 
   /**
    * Set/Get whether the maximum Feret diameter should be computed or not.
-   * Default value is false because of the high computation time required.
+   * Default value is false.
    */
   itkSetMacro(ComputeFeretDiameter, bool);
   itkGetConstReferenceMacro(ComputeFeretDiameter, bool);
@@ -125,6 +131,13 @@ public:
   itkGetConstReferenceMacro(ComputeOrientedBoundingBox, bool);
   itkBooleanMacro(ComputeOrientedBoundingBox);
 
+  /**
+   * Set/Get the number of lines from which a label object is processed
+   * with all the work units, instead of a single one. Default value is 8192.
+   */
+  itkSetMacro(LargeObjectNumberOfLines, SizeValueType);
+  itkGetConstMacro(LargeObjectNumberOfLines, SizeValueType);
+
   /** Set the label image */
   void
   SetLabelImage(const TLabelImage * input)
@@ -149,13 +162,45 @@ protected:
   PrintSelf(std::ostream & os, Indent indent) const override;
 
 private:
+  /** Sums over the lines of a label object, from which most of its
+   * attributes are computed. */
+  struct LineSums
+  {
+    LineSums();
+
+    void
+    Merge(const LineSums & other);
+
+    SizeValueType                           NumberOfPixels;
+    ContinuousIndex<double, ImageDimension> Centroid;
+    IndexType                               Mins;
+    IndexType                               Maxs;
+    SizeValueType                           NumberOfPixelsOnBorder;
+    double                                  PerimeterOnBorder;
+    MatrixType                              CentralMoments;
+  };
+
   bool                   m_ComputeFeretDiameter;
   bool                   m_ComputePerimeter;
   bool                   m_ComputeOrientedBoundingBox;
+  SizeValueType          m_LargeObjectNumberOfLines;
   LabelImageConstPointer m_LabelImage;
 
+  /** Add the lines [firstLine, lastLine) of the label object to the sums. */
+  void
+  AccumulateLines(const LabelObjectType * labelObject,
+                  SizeValueType           firstLine,
+                  SizeValueType           lastLine,
+                  LineSums &              sums) const;
+
+  /** Set the attributes of the label object. The computations which can be
+   * parallelized are done with the multithreader of the filter when
+   * useMultiThreader is true. */
+  void
+  ComputeAttributes(LabelObjectType * labelObject, const LineSums & sums, bool useMultiThreader);
+
   void
-  ComputeFeretDiameter(LabelObjectType * labelObject);
+  ComputeFeretDiameter(LabelObjectType * labelObject, bool useMultiThreader);
   void
   ComputePerimeter(LabelObjectType * labelObject);
   void
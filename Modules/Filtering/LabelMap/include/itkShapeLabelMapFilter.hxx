@@ -30,17 +30,48 @@
 #include "vnl/algo/vnl_symmetric_eigensystem.h"
 #include "itkMath.h"
 #include "itkLexicographicCompare.h"
+#include <algorithm>
 #include <deque>
 #include <map>
+#include <vector>
 
 namespace itk
 {
+template <typename TImage, typename TLabelImage>
+ShapeLabelMapFilter<TImage, TLabelImage>::LineSums::LineSums()
+  : NumberOfPixels(0)
+  , NumberOfPixelsOnBorder(0)
+  , PerimeterOnBorder(0)
+{
+  Centroid.Fill(0);
+  Mins.Fill(NumericTraits<IndexValueType>::max());
+  Maxs.Fill(NumericTraits<IndexValueType>::NonpositiveMin());
+  CentralMoments.Fill(0);
+}
+
+template <typename TImage, typename TLabelImage>
+void
+ShapeLabelMapFilter<TImage, TLabelImage>::LineSums::Merge(const LineSums & other)
+{
+  NumberOfPixels += other.NumberOfPixels;
+  NumberOfPixelsOnBorder += other.NumberOfPixelsOnBorder;
+  PerimeterOnBorder += other.PerimeterOnBorder;
+  CentralMoments += other.CentralMoments;
+  for (unsigned int i = 0; i < ImageDimension; i++)
+  {
+    Centroid[i] += other.Centroid[i];
+    Mins[i] = std::min(Mins[i], other.Mins[i]);
+    Maxs[i] = std::max(Maxs[i], other.Maxs[i]);
+  }
+}
+
 template <typename TImage, typename TLabelImage>
 ShapeLabelMapFilter<TImage, TLabelImage>::ShapeLabelMapFilter()
 {
   m_ComputeFeretDiameter = false;
   m_ComputePerimeter = true;
   m_ComputeOrientedBoundingBox = false;
+  m_LargeObjectNumberOfLines = 8192;
 }
 
 template <typename TImage, typename TLabelImage>
@@ -49,20 +80,40 @@ ShapeLabelMapFilter<TImage, TLabelImage>::BeforeThreadedGenerateData()
 {
   Superclass::BeforeThreadedGenerateData();
 
-  // Generate the label image, if needed
-  if (m_ComputeFeretDiameter)
+  // The large label objects are processed here, one at a time, with their
+  // lines split in blocks of fixed size among the work units. This way, they
+  // don't keep a single work unit busy after the other objects are done, and
+  // the result doesn't depend on the number of work units.
+  constexpr SizeValueType linesPerBlock = 1024;
+  MultiThreaderBase *     multiThreader = this->GetMultiThreader();
+  for (typename ImageType::Iterator it(this->GetOutput()); !it.IsAtEnd(); ++it)
   {
-    if (!m_LabelImage)
+    LabelObjectType *   labelObject = it.GetLabelObject();
+    const SizeValueType numberOfLines = labelObject->GetNumberOfLines();
+    if (numberOfLines < m_LargeObjectNumberOfLines)
+    {
+      continue;
+    }
+
+    const SizeValueType   numberOfBlocks = (numberOfLines + linesPerBlock - 1) / linesPerBlock;
+    std::vector<LineSums> blockSums(numberOfBlocks);
+    multiThreader->ParallelizeArray(
+      0,
+      numberOfBlocks,
+      [this, labelObject, numberOfLines, &blockSums](SizeValueType block) {
+        this->AccumulateLines(labelObject,
+                              block * linesPerBlock,
+                              std::min(numberOfLines, (block + 1) * linesPerBlock),
+                              blockSums[block]);
+      },
+      nullptr);
+
+    LineSums sums;
+    for (const auto & s : blockSums)
     {
-      // generate an image of the labelized image
-      using LCI2IType = LabelMapToLabelImageFilter<TImage, LabelImageType>;
-      typename LCI2IType::Pointer lci2i = LCI2IType::New();
-      lci2i->SetInput(this->GetOutput());
-      // Respect the number of threads of the filter
-      lci2i->SetNumberOfWorkUnits(this->GetNumberOfWorkUnits());
-      lci2i->Update();
-      m_LabelImage = lci2i->GetOutput();
+      sums.Merge(s);
     }
+    this->ComputeAttributes(labelObject, sums, true);
   }
 }
 
@@ -70,7 +121,26 @@ template <typename TImage, typename TLabelImage>
 void
 ShapeLabelMapFilter<TImage, TLabelImage>::ThreadedProcessLabelObject(LabelObjectType * labelObject)
 {
-  ImageType * output = this->GetOutput();
+  const SizeValueType numberOfLines = labelObject->GetNumberOfLines();
+  if (numberOfLines >= m_LargeObjectNumberOfLines)
+  {
+    // Already done in BeforeThreadedGenerateData()
+    return;
+  }
+
+  LineSums sums;
+  this->AccumulateLines(labelObject, 0, numberOfLines, sums);
+  this->ComputeAttributes(labelObject, sums, false);
+}
+
+template <typename TImage, typename TLabelImage>
+void
+ShapeLabelMapFilter<TImage, TLabelImage>::AccumulateLines(const LabelObjectType * labelObject,
+                                                          SizeValueType           firstLine,
+                                                          SizeValueType           lastLine,
+                                                          LineSums &              sums) const
+{
+  const ImageType * output = this->GetOutput();
 
   // Compute the size per pixel, to be used later
   double sizePerPixel = 1;
@@ -94,56 +164,44 @@ ShapeLabelMapFilter<TImage, TLabelImage>::ThreadedProcessLabelObject(LabelObject
     borderMax[i] += output->GetLargestPossibleRegion().GetSize()[i] - 1;
   }
 
-  // Init the vars
-  SizeValueType                           nbOfPixels = 0;
-  ContinuousIndex<double, ImageDimension> centroid;
-  centroid.Fill(0);
-  IndexType mins;
-  mins.Fill(NumericTraits<IndexValueType>::max());
-  IndexType maxs;
-  maxs.Fill(NumericTraits<IndexValueType>::NonpositiveMin());
-  SizeValueType nbOfPixelsOnBorder = 0;
-  double        perimeterOnBorder = 0;
-  MatrixType    centralMoments;
-  centralMoments.Fill(0);
-
   using LengthType = typename LabelObjectType::LengthType;
 
-  // Iterate over all the lines
-  typename LabelObjectType::ConstLineIterator lit(labelObject);
-  while (!lit.IsAtEnd())
+  // Iterate over the lines
+  for (SizeValueType l = firstLine; l < lastLine; ++l)
   {
-    const IndexType & idx = lit.GetLine().GetIndex();
-    LengthType        length = lit.GetLine().GetLength();
+    const typename LabelObjectType::LineType & line = labelObject->GetLine(l);
+
+    const IndexType & idx = line.GetIndex();
+    LengthType        length = line.GetLength();
 
     // Update the nbOfPixels
-    nbOfPixels += length;
+    sums.NumberOfPixels += length;
 
     // Update the centroid - and report the progress
     // First, update the axes that are not 0
     for (unsigned int i = 1; i < ImageDimension; i++)
     {
-      centroid[i] += (OffsetValueType)length * idx[i];
+      sums.Centroid[i] += (OffsetValueType)length * idx[i];
     }
     // Then, update the axis 0
-    centroid[0] += idx[0] * (OffsetValueType)length + (length * (length - 1)) / 2.0;
+    sums.Centroid[0] += idx[0] * (OffsetValueType)length + (length * (length - 1)) / 2.0;
 
     // Update the mins and maxs
     for (unsigned int i = 0; i < ImageDimension; i++)
     {
-      if (idx[i] < mins[i])
+      if (idx[i] < sums.Mins[i])
       {
-        mins[i] = idx[i];
+        sums.Mins[i] = idx[i];
       }
-      if (idx[i] > maxs[i])
+      if (idx[i] > sums.Maxs[i])
       {
-        maxs[i] = idx[i];
+        sums.Maxs[i] = idx[i];
       }
     }
     // Must fix the max for the axis 0
-    if (idx[0] + (OffsetValueType)length > maxs[0])
+    if (idx[0] + (OffsetValueType)length > sums.Maxs[0])
     {
-      maxs[0] = idx[0] + length - 1;
+      sums.Maxs[0] = idx[0] + length - 1;
     }
 
     // Object is on a border ?
@@ -160,7 +218,7 @@ ShapeLabelMapFilter<TImage, TLabelImage>::ThreadedProcessLabelObject(LabelObject
     {
       // The line touch a border on a dimension other than 0, so
       // all the line touch a border
-      nbOfPixelsOnBorder += length;
+      sums.NumberOfPixelsOnBorder += length;
     }
     else
     {
@@ -169,7 +227,7 @@ ShapeLabelMapFilter<TImage, TLabelImage>::ThreadedProcessLabelObject(LabelObject
       if (idx[0] == borderMin[0])
       {
         // One more pixel on the border
-        nbOfPixelsOnBorder++;
+        sums.NumberOfPixelsOnBorder++;
         isOnBorder0 = true;
       }
       if (!isOnBorder0 || length > 1)
@@ -178,7 +236,7 @@ ShapeLabelMapFilter<TImage, TLabelImage>::ThreadedProcessLabelObject(LabelObject
         if (idx[0] + (OffsetValueType)length - 1 == borderMax[0])
         {
           // One more pixel on the border
-          nbOfPixelsOnBorder++;
+          sums.NumberOfPixelsOnBorder++;
         }
       }
     }
@@ -188,12 +246,12 @@ ShapeLabelMapFilter<TImage, TLabelImage>::ThreadedProcessLabelObject(LabelObject
     if (idx[0] == borderMin[0])
     {
       // Fhe beginning of the line
-      perimeterOnBorder += sizePerPixelPerDimension[0];
+      sums.PerimeterOnBorder += sizePerPixelPerDimension[0];
     }
     if (idx[0] + (OffsetValueType)length - 1 == borderMax[0])
     {
       // And the end of the line
-      perimeterOnBorder += sizePerPixelPerDimension[0];
+      sums.PerimeterOnBorder += sizePerPixelPerDimension[0];
     }
     // Then the other dimensions
     for (unsigned int i = 1; i < ImageDimension; i++)
@@ -201,12 +259,12 @@ ShapeLabelMapFilter<TImage, TLabelImage>::ThreadedProcessLabelObject(LabelObject
       if (idx[i] == borderMin[i])
       {
         // one border
-        perimeterOnBorder += sizePerPixelPerDimension[i] * length;
+        sums.PerimeterOnBorder += sizePerPixelPerDimension[i] * length;
       }
       if (idx[i] == borderMax[i])
       {
         // and the other
-        perimeterOnBorder += sizePerPixelPerDimension[i] * length;
+        sums.PerimeterOnBorder += sizePerPixelPerDimension[i] * length;
       }
     }
 
@@ -246,12 +304,12 @@ ShapeLabelMapFilter<TImage, TLabelImage>::ThreadedProcessLabelObject(LabelObject
 
         for (unsigned int i = 0; i < ImageDimension; i++)
         {
-          centralMoments[i][i] += pP[i] * pP[i];
+          sums.CentralMoments[i][i] += pP[i] * pP[i];
           for (unsigned int j = i + 1; j < ImageDimension; j++)
           {
             const double cm = pP[i] * pP[j];
-            centralMoments[i][j] += cm;
-            centralMoments[j][i] += cm;
+            sums.CentralMoments[i][j] += cm;
+            sums.CentralMoments[j][i] += cm;
           }
         }
       }
@@ -275,7 +333,7 @@ ShapeLabelMapFilter<TImage, TLabelImage>::ThreadedProcessLabelObject(LabelObject
 
       for (unsigned int i = 0; i < ImageDimension; i++)
       {
-        centralMoments[i][i] +=
+        sums.CentralMoments[i][i] +=
           length * (physicalPosition[i] * physicalPosition[i] +
                     lcoff_1 * (2.0 * physicalPosition[i] * scale[i] + lcoff_2 * scale[i] * scale[i]));
 
@@ -284,15 +342,33 @@ ShapeLabelMapFilter<TImage, TLabelImage>::ThreadedProcessLabelObject(LabelObject
           const double cm = length * (physicalPosition[i] * physicalPosition[j] +
                                       lcoff_1 * (physicalPosition[i] * scale[j] + scale[i] * physicalPosition[j] +
                                                  lcoff_2 * scale[i] * scale[j]));
-          centralMoments[j][i] += cm;
-          centralMoments[i][j] += cm;
+          sums.CentralMoments[j][i] += cm;
+          sums.CentralMoments[i][j] += cm;
         }
       }
     }
+  }
+}
 
-    ++lit;
+template <typename TImage, typename TLabelImage>
+void
+ShapeLabelMapFilter<TImage, TLabelImage>::ComputeAttributes(LabelObjectType * labelObject,
+                                                            const LineSums &  sums,
+                                                            bool              useMultiThreader)
+{
+  const ImageType * output = this->GetOutput();
+
+  double sizePerPixel = 1;
+  for (unsigned int i = 0; i < ImageDimension; i++)
+  {
+    sizePerPixel *= output->GetSpacing()[i];
   }
 
+  const SizeValueType                     nbOfPixels = sums.NumberOfPixels;
+  ContinuousIndex<double, ImageDimension> centroid = sums.Centroid;
+  const IndexType &                       mins = sums.Mins;
+  const IndexType &                       maxs = sums.Maxs;
+  MatrixType                              centralMoments = sums.CentralMoments;
 
   // final computation
   typename LabelObjectType::RegionType::SizeType boundingBoxSize;
@@ -400,8 +476,8 @@ ShapeLabelMapFilter<TImage, TLabelImage>::ThreadedProcessLabelObject(LabelObject
   labelObject->SetPhysicalSize(physicalSize);
   labelObject->SetBoundingBox(boundingBox);
   labelObject->SetCentroid(physicalCentroid);
-  labelObject->SetNumberOfPixelsOnBorder(nbOfPixelsOnBorder);
-  labelObject->SetPerimeterOnBorder(perimeterOnBorder);
+  labelObject->SetNumberOfPixelsOnBorder(sums.NumberOfPixelsOnBorder);
+  labelObject->SetPerimeterOnBorder(sums.PerimeterOnBorder);
   labelObject->SetPrincipalMoments(principalMoments);
   labelObject->SetPrincipalAxes(principalAxes);
   labelObject->SetElongation(elongation);
@@ -412,7 +488,7 @@ ShapeLabelMapFilter<TImage, TLabelImage>::ThreadedProcessLabelObject(LabelObject
 
   if (m_ComputeFeretDiameter)
   {
-    this->ComputeFeretDiameter(labelObject);
+    this->ComputeFeretDiameter(labelObject, useMultiThreader);
   }
 
   if (m_ComputePerimeter)
@@ -428,66 +504,147 @@ ShapeLabelMapFilter<TImage, TLabelImage>::ThreadedProcessLabelObject(LabelObject
 
 template <typename TImage, typename TLabelImage>
 void
-ShapeLabelMapFilter<TImage, TLabelImage>::ComputeFeretDiameter(LabelObjectType * labelObject)
+ShapeLabelMapFilter<TImage, TLabelImage>::ComputeFeretDiameter(LabelObjectType * labelObject, bool useMultiThreader)
 {
-  const LabelPixelType & label = labelObject->GetLabel();
-
-  using IndexListType = typename std::deque<IndexType>;
-  IndexListType idxList;
-
-  using NeighborIteratorType = typename itk::ConstNeighborhoodIterator<LabelImageType>;
-  SizeType neighborHoodRadius;
-  neighborHoodRadius.Fill(1);
-  NeighborIteratorType                      it(neighborHoodRadius, m_LabelImage, m_LabelImage->GetBufferedRegion());
-  ConstantBoundaryCondition<LabelImageType> lcbc;
-  // Use label + 1 to have a label different of the current label on the border
-  lcbc.SetConstant(label + 1);
-  it.OverrideBoundaryCondition(&lcbc);
-  it.GoToBegin();
+  // The maximum Feret diameter is the largest distance between two vertices
+  // of the convex hull of the object. Those vertices are extremities of the
+  // rows of the object, and more precisely vertices of the convex hull of the
+  // extremities of the rows in one of the planes along the axes 0 and 1.
+
+  // The rows, with the index of their first pixel and the index of their last
+  // pixel along the axis 0
+  using RowType = std::pair<IndexType, IndexValueType>;
+  std::vector<RowType> rows;
+  rows.reserve(labelObject->GetNumberOfLines());
+  for (SizeValueType l = 0; l < labelObject->GetNumberOfLines(); ++l)
+  {
+    const typename LabelObjectType::LineType & line = labelObject->GetLine(l);
+    rows.emplace_back(line.GetIndex(), line.GetIndex()[0] + static_cast<OffsetValueType>(line.GetLength()) - 1);
+  }
 
-  using NeighborIndexType = typename NeighborIteratorType::NeighborIndexType;
+  // Sort them by plane, then by row in the plane, then along the axis 0
+  std::sort(rows.begin(), rows.end(), [](const RowType & a, const RowType & b) {
+    for (unsigned int i = ImageDimension - 1; i > 0; i--)
+    {
+      if (a.first[i] != b.first[i])
+      {
+        return a.first[i] < b.first[i];
+      }
+    }
+    return a.first[0] < b.first[0];
+  });
 
-  // Iterate over all the indexes
-  typename LabelObjectType::ConstIndexIterator iit(labelObject);
-  while (!iit.IsAtEnd())
+  const auto haveSameCoordinates = [](const IndexType & a, const IndexType & b, unsigned int firstAxis) {
+    for (unsigned int i = firstAxis; i < ImageDimension; i++)
+    {
+      if (a[i] != b[i])
+      {
+        return false;
+      }
+    }
+    return true;
+  };
+
+  // Cross product of (a - o) and (b - o) in the plane, with the axis 1 first
+  // to match the order of the points
+  const auto cross = [](const IndexType & o, const IndexType & a, const IndexType & b) {
+    return (a[1] - o[1]) * (b[0] - o[0]) - (a[0] - o[0]) * (b[1] - o[1]);
+  };
+
+  std::vector<IndexType> vertices;
+  std::vector<IndexType> points;
+  std::vector<IndexType> hull;
+  auto                   rowIt = rows.begin();
+  while (rowIt != rows.end())
   {
-    // Move the iterator to the new location
-    it += iit.GetIndex() - it.GetIndex();
+    // The extremities of the rows of the plane, in lexicographic order
+    const IndexType planeIndex = rowIt->first;
+    points.clear();
+    while (rowIt != rows.end() && haveSameCoordinates(rowIt->first, planeIndex, 2))
+    {
+      const IndexType rowIndex = rowIt->first;
+      IndexValueType  rowEnd = rowIt->second;
+      for (++rowIt; rowIt != rows.end() && haveSameCoordinates(rowIt->first, rowIndex, 1); ++rowIt)
+      {
+        rowEnd = std::max(rowEnd, rowIt->second);
+      }
+      points.push_back(rowIndex);
+      if (rowEnd != rowIndex[0])
+      {
+        points.push_back(rowIndex);
+        points.back()[0] = rowEnd;
+      }
+    }
 
-    // Push the pixel in the list if it is on the border of the object
-    for (NeighborIndexType i = 0; i < it.Size(); i++)
+    // Convex hull of the plane, with Andrew's monotone chain algorithm
+    hull.resize(2 * points.size());
+    size_t k = 0;
+    for (const auto & p : points)
     {
-      if (it.GetPixel(i) != label)
+      while (k >= 2 && cross(hull[k - 2], hull[k - 1], p) <= 0)
       {
-        idxList.push_back(iit.GetIndex());
-        break;
+        k--;
       }
+      hull[k++] = p;
     }
-    ++iit;
+    for (size_t i = points.size() - 1, t = k + 1; i > 0; i--)
+    {
+      while (k >= t && cross(hull[k - 2], hull[k - 1], points[i - 1]) <= 0)
+      {
+        k--;
+      }
+      hull[k++] = points[i - 1];
+    }
+    if (points.size() > 1)
+    {
+      // The first point has been added again at the end
+      k--;
+    }
+    vertices.insert(vertices.end(), hull.begin(), hull.begin() + k);
   }
 
-  ImageType * output = this->GetOutput();
-
-  const typename ImageType::SpacingType & spacing = output->GetSpacing();
+  const typename ImageType::SpacingType & spacing = this->GetOutput()->GetSpacing();
+  const SizeValueType                     numberOfVertices = vertices.size();
 
-  // We can now search the feret diameter
-  double feretDiameter = 0;
-  for (typename IndexListType::const_iterator iIt1 = idxList.begin(); iIt1 != idxList.end(); iIt1++)
-  {
-    auto iIt2 = iIt1;
-    for (iIt2++; iIt2 != idxList.end(); iIt2++)
+  // The largest squared length between the vertex v and the next ones
+  const auto farthestSquaredLength = [&vertices, &spacing, numberOfVertices](SizeValueType v) {
+    double maximum = 0;
+    for (SizeValueType w = v + 1; w < numberOfVertices; w++)
     {
-      // Compute the length between the 2 indexes
       double length = 0;
       for (unsigned int i = 0; i < ImageDimension; i++)
       {
-        const OffsetValueType indexDifference = (iIt1->operator[](i) - iIt2->operator[](i));
-        length += std::pow(indexDifference * spacing[i], 2);
-      }
-      if (feretDiameter < length)
-      {
-        feretDiameter = length;
+        const double difference = (vertices[v][i] - vertices[w][i]) * spacing[i];
+        length += difference * difference;
       }
+      maximum = std::max(maximum, length);
+    }
+    return maximum;
+  };
+
+  double feretDiameter = 0;
+  if (useMultiThreader)
+  {
+    // The vertices are processed by pairs, the first with the last and so on,
+    // to balance the work
+    std::vector<double> maxima((numberOfVertices + 1) / 2);
+    this->GetMultiThreader()->ParallelizeArray(
+      0,
+      maxima.size(),
+      [&maxima, &farthestSquaredLength, numberOfVertices](SizeValueType v) {
+        maxima[v] = std::max(farthestSquaredLength(v), farthestSquaredLength(numberOfVertices - 1 - v));
+      },
+      nullptr);
+    for (const double m : maxima)
+    {
+      feretDiameter = std::max(feretDiameter, m);
+    }
+  }
+  else
+  {
+    for (SizeValueType v = 0; v < numberOfVertices; v++)
+    {
+      feretDiameter = std::max(feretDiameter, farthestSquaredLength(v));
     }
   }
   // Final computation
@@ -924,6 +1081,7 @@ ShapeLabelMapFilter<TImage, TLabelImage>::PrintSelf(std::ostream & os, Indent in
   os << indent << "ComputeFeretDiameter: " << m_ComputeFeretDiameter << std::endl;
   os << indent << "ComputePerimeter: " << m_ComputePerimeter << std::endl;
   os << indent << "ComputeOrientedBoundingBox: " << m_ComputeOrientedBoundingBox << std::endl;
+  os << indent << "LargeObjectNumberOfLines: " << m_LargeObjectNumberOfLines << std::endl;
 }
 
 } // end namespace itk
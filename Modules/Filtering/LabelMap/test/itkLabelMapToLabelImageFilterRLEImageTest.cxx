@@ -0,0 +1,161 @@
+/*=========================================================================
+ *
+ *  Copyright NumFOCUS
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include "itkBinaryBallStructuringElement.h"
+#include "itkBinaryDilateImageFilter.h"
+#include "itkCastImageFilter.h"
+#include "itkLabelImageToLabelMapFilter.h"
+#include "itkLabelMapToLabelImageFilter.h"
+#include "itkRLEImage.h"
+#include "itkStreamingImageFilter.h"
+#include "itkTestingMacros.h"
+
+namespace
+{
+constexpr unsigned int Dimension = 3;
+using PixelType = unsigned short;
+using ImageType = itk::Image<PixelType, Dimension>;
+using RLEImageType = itk::RLEImage<PixelType, Dimension>;
+using LabelObjectType = itk::LabelObject<PixelType, Dimension>;
+using LabelMapType = itk::LabelMap<LabelObjectType>;
+
+bool
+CompareImages(const RLEImageType * rleImage, const ImageType * image)
+{
+  itk::ImageRegionConstIteratorWithIndex<RLEImageType> rleIt(rleImage, image->GetLargestPossibleRegion());
+  itk::ImageRegionConstIterator<ImageType>             it(image, image->GetLargestPossibleRegion());
+  for (; !it.IsAtEnd(); ++it, ++rleIt)
+  {
+    if (rleIt.Get() != it.Get())
+    {
+      std::cerr << "Test failed!" << std::endl;
+      std::cerr << "Error at index " << rleIt.GetIndex() << std::endl;
+      std::cerr << "Expected: " << it.Get() << ", but got: " << rleIt.Get() << std::endl;
+      return false;
+    }
+  }
+  return true;
+}
+} // namespace
+
+// Converts a run-length encoded label image to a label map and back, and
+// applies a morphological filter to it through a streamed conversion to a
+// dense image.
+int
+itkLabelMapToLabelImageFilterRLEImageTest(int, char *[])
+{
+  // Many small objects, several of them on each line
+  ImageType::SizeType size = { { 120, 40, 30 } };
+  ImageType::Pointer  image = ImageType::New();
+  image->SetRegions(size);
+  image->Allocate();
+
+  itk::ImageRegionIteratorWithIndex<ImageType> it(image, image->GetLargestPossibleRegion());
+  for (; !it.IsAtEnd(); ++it)
+  {
+    const ImageType::IndexType & idx = it.GetIndex();
+    PixelType                    label = 0;
+    if (idx[0] % 12 > 2 && idx[1] % 8 > 1 && idx[2] % 10 > 3)
+    {
+      label = static_cast<PixelType>(1 + idx[0] / 12 + 10 * (idx[1] / 8) + 50 * (idx[2] / 10));
+    }
+    it.Set(label);
+  }
+
+  using ToRLEFilterType = itk::CastImageFilter<ImageType, RLEImageType>;
+  ToRLEFilterType::Pointer toRLE = ToRLEFilterType::New();
+  toRLE->SetInput(image);
+  ITK_TRY_EXPECT_NO_EXCEPTION(toRLE->Update());
+
+  // Label image to label map
+  using ToLabelMapFilterType = itk::LabelImageToLabelMapFilter<RLEImageType, LabelMapType>;
+  ToLabelMapFilterType::Pointer toLabelMap = ToLabelMapFilterType::New();
+  toLabelMap->SetInput(toRLE->GetOutput());
+  ITK_TRY_EXPECT_NO_EXCEPTION(toLabelMap->Update());
+
+  using DenseToLabelMapFilterType = itk::LabelImageToLabelMapFilter<ImageType, LabelMapType>;
+  DenseToLabelMapFilterType::Pointer denseToLabelMap = DenseToLabelMapFilterType::New();
+  denseToLabelMap->SetInput(image);
+  ITK_TRY_EXPECT_NO_EXCEPTION(denseToLabelMap->Update());
+
+  LabelMapType * labelMap = toLabelMap->GetOutput();
+  LabelMapType * denseLabelMap = denseToLabelMap->GetOutput();
+  ITK_TEST_EXPECT_EQUAL(labelMap->GetNumberOfLabelObjects(), 150u);
+  ITK_TEST_EXPECT_EQUAL(labelMap->GetNumberOfLabelObjects(), denseLabelMap->GetNumberOfLabelObjects());
+  for (LabelMapType::ConstIterator objectIt(denseLabelMap); !objectIt.IsAtEnd(); ++objectIt)
+  {
+    const LabelObjectType * denseObject = objectIt.GetLabelObject();
+    const LabelObjectType * object = labelMap->GetLabelObject(objectIt.GetLabel());
+    ITK_TEST_EXPECT_EQUAL(object->Size(), denseObject->Size());
+    ITK_TEST_EXPECT_EQUAL(object->GetNumberOfLines(), denseObject->GetNumberOfLines());
+  }
+
+  // Label map to label image, with concurrent writes to the same lines
+  using ToLabelImageFilterType = itk::LabelMapToLabelImageFilter<LabelMapType, RLEImageType>;
+  for (unsigned int numberOfWorkUnits = 1; numberOfWorkUnits <= 8; numberOfWorkUnits *= 8)
+  {
+    ToLabelImageFilterType::Pointer toLabelImage = ToLabelImageFilterType::New();
+    toLabelImage->SetInput(labelMap);
+    toLabelImage->SetNumberOfWorkUnits(numberOfWorkUnits);
+    ITK_TRY_EXPECT_NO_EXCEPTION(toLabelImage->Update());
+    ITK_TEST_EXPECT_TRUE(CompareImages(toLabelImage->GetOutput(), image));
+    ITK_TEST_EXPECT_EQUAL(toLabelImage->GetOutput()->GetNumberOfSegments(),
+                          toRLE->GetOutput()->GetNumberOfSegments());
+  }
+
+  // Dilation of the run-length encoded image, which is only expanded one
+  // piece at a time
+  using KernelType = itk::BinaryBallStructuringElement<PixelType, Dimension>;
+  KernelType           kernel;
+  KernelType::SizeType radius;
+  radius.Fill(1);
+  kernel.SetRadius(radius);
+  kernel.CreateStructuringElement();
+
+  using DilateFilterType = itk::BinaryDilateImageFilter<ImageType, ImageType, KernelType>;
+  DilateFilterType::Pointer denseDilate = DilateFilterType::New();
+  denseDilate->SetInput(image);
+  denseDilate->SetKernel(kernel);
+  denseDilate->SetForegroundValue(5);
+  ITK_TRY_EXPECT_NO_EXCEPTION(denseDilate->Update());
+
+  using ToDenseFilterType = itk::CastImageFilter<RLEImageType, ImageType>;
+  ToDenseFilterType::Pointer toDense = ToDenseFilterType::New();
+  toDense->SetInput(toRLE->GetOutput());
+
+  DilateFilterType::Pointer dilate = DilateFilterType::New();
+  dilate->SetInput(toDense->GetOutput());
+  dilate->SetKernel(kernel);
+  dilate->SetForegroundValue(5);
+
+  ToRLEFilterType::Pointer dilatedToRLE = ToRLEFilterType::New();
+  dilatedToRLE->SetInput(dilate->GetOutput());
+
+  using StreamingFilterType = itk::StreamingImageFilter<RLEImageType, RLEImageType>;
+  StreamingFilterType::Pointer streamer = StreamingFilterType::New();
+  streamer->SetInput(dilatedToRLE->GetOutput());
+  streamer->SetNumberOfStreamDivisions(4);
+  ITK_TRY_EXPECT_NO_EXCEPTION(streamer->Update());
+
+  ITK_TEST_EXPECT_TRUE(toDense->GetOutput()->GetBufferedRegion().GetNumberOfPixels() <
+                       image->GetLargestPossibleRegion().GetNumberOfPixels() / 2);
+  ITK_TEST_EXPECT_TRUE(CompareImages(streamer->GetOutput(), denseDilate->GetOutput()));
+
+  std::cout << "Test finished." << std::endl;
+  return EXIT_SUCCESS;
+}
@@ -19,7 +19,9 @@
 #include "itkGTest.h"
 
 #include "itkImage.h"
+#include "itkImageRegionConstIteratorWithIndex.h"
 #include "itkLabelImageToShapeLabelMapFilter.h"
+#include <random>
 
 
 namespace Math = itk::Math;
@@ -96,6 +98,79 @@ protected:
       }
       return false;
     }
+
+    // Largest distance between two pixels of the label, by comparing all the pairs
+    static double
+    ComputeFeretDiameterByBruteForce(const ImageType * image, PixelType label)
+    {
+      std::vector<typename ImageType::PointType> points;
+      for (itk::ImageRegionConstIteratorWithIndex<ImageType> it(image, image->GetBufferedRegion()); !it.IsAtEnd(); ++it)
+      {
+        if (it.Get() == label)
+        {
+          typename ImageType::PointType point;
+          image->TransformIndexToPhysicalPoint(it.GetIndex(), point);
+          points.push_back(point);
+        }
+      }
+
+      double feretDiameter = 0;
+      for (size_t i = 0; i < points.size(); ++i)
+      {
+        for (size_t j = i + 1; j < points.size(); ++j)
+        {
+          feretDiameter = std::max(feretDiameter, points[i].EuclideanDistanceTo(points[j]));
+        }
+      }
+      return feretDiameter;
+    }
+
+    // Labels 1 to 3 are shapes with concavities and holes, and label 4 is
+    // made of scattered pixels
+    static typename ImageType::Pointer
+    CreateShapesImage(const typename ImageType::SizeType & size)
+    {
+      typename ImageType::Pointer image = ImageType::New();
+      image->SetRegions(typename ImageType::RegionType(size));
+      image->Allocate();
+      image->FillBuffer(0);
+
+      typename ImageType::SpacingType spacing;
+      for (unsigned int i = 0; i < Dimension; ++i)
+      {
+        spacing[i] = 0.6 + 0.35 * i;
+      }
+      image->SetSpacing(spacing);
+
+      std::mt19937 generator(42);
+      for (itk::ImageRegionIteratorWithIndex<ImageType> it(image, image->GetBufferedRegion()); !it.IsAtEnd(); ++it)
+      {
+        const typename ImageType::IndexType & idx = it.GetIndex();
+        double                                radius = 0;
+        for (unsigned int i = 0; i < Dimension; ++i)
+        {
+          const double d = (idx[i] - 0.5 * size[i]) / (0.45 * size[i]);
+          radius += d * d;
+        }
+        if (radius > 0.5 && radius < 1.0 && idx[0] > idx[1])
+        {
+          it.Set(1);
+        }
+        else if (radius < 0.2 && idx[1] % 4 != 0)
+        {
+          it.Set(2);
+        }
+        else if (idx[1] == idx[0] / 2 + 1)
+        {
+          it.Set(3);
+        }
+        else if (generator() % 100 == 0)
+        {
+          it.Set(4);
+        }
+      }
+      return image;
+    }
   };
 };
 } // namespace
@@ -510,3 +585,106 @@ TEST_F(ShapeLabelMapFixture, 2D_T2x4)
     labelObject->Print(std::cout);
   }
 }
+
+
+TEST_F(ShapeLabelMapFixture, 2D_FeretDiameter)
+{
+  using Utils = FixtureUtilities<2>;
+
+  Utils::ImageType::SizeType size = { { 61, 47 } };
+  Utils::ImageType::Pointer  image(Utils::CreateShapesImage(size));
+
+  using L2SType = itk::LabelImageToShapeLabelMapFilter<Utils::ImageType>;
+  L2SType::Pointer l2s = L2SType::New();
+  l2s->SetInput(image);
+  l2s->ComputeFeretDiameterOn();
+  l2s->Update();
+
+  ASSERT_EQ(4u, l2s->GetOutput()->GetNumberOfLabelObjects());
+  for (Utils::PixelType label = 1; label <= 4; ++label)
+  {
+    EXPECT_NEAR(Utils::ComputeFeretDiameterByBruteForce(image, label),
+                l2s->GetOutput()->GetLabelObject(label)->GetFeretDiameter(),
+                1e-10);
+  }
+}
+
+
+TEST_F(ShapeLabelMapFixture, 3D_FeretDiameter)
+{
+  using Utils = FixtureUtilities<3>;
+
+  Utils::ImageType::SizeType size = { { 23, 19, 17 } };
+  Utils::ImageType::Pointer  image(Utils::CreateShapesImage(size));
+
+  using L2SType = itk::LabelImageToShapeLabelMapFilter<Utils::ImageType>;
+  L2SType::Pointer l2s = L2SType::New();
+  l2s->SetInput(image);
+  l2s->ComputeFeretDiameterOn();
+  l2s->Update();
+
+  ASSERT_EQ(4u, l2s->GetOutput()->GetNumberOfLabelObjects());
+  for (Utils::PixelType label = 1; label <= 4; ++label)
+  {
+    EXPECT_NEAR(Utils::ComputeFeretDiameterByBruteForce(image, label),
+                l2s->GetOutput()->GetLabelObject(label)->GetFeretDiameter(),
+                1e-10);
+  }
+}
+
+
+TEST_F(ShapeLabelMapFixture, 3D_LargeObjects)
+{
+  using Utils = FixtureUtilities<3>;
+
+  Utils::ImageType::SizeType size = { { 40, 90, 70 } };
+  Utils::ImageType::Pointer  image(Utils::CreateShapesImage(size));
+
+  // The objects are processed one at a time with all the work units when
+  // they have more lines than the threshold
+  using L2SType = itk::LabelImageToShapeLabelMapFilter<Utils::ImageType>;
+  std::vector<L2SType::Pointer> filters;
+  for (const itk::SizeValueType largeObjectNumberOfLines : { itk::SizeValueType{ 1 }, itk::SizeValueType{ 2000 } })
+  {
+    for (const itk::ThreadIdType numberOfWorkUnits : { 1, 5 })
+    {
+      L2SType::Pointer l2s = L2SType::New();
+      l2s->SetInput(image);
+      l2s->ComputeFeretDiameterOn();
+      l2s->ComputeOrientedBoundingBoxOn();
+      l2s->SetLargeObjectNumberOfLines(largeObjectNumberOfLines);
+      l2s->SetNumberOfWorkUnits(numberOfWorkUnits);
+      l2s->Update();
+      filters.push_back(l2s);
+    }
+  }
+
+  // Default processing, one work unit per object
+  L2SType::Pointer reference = L2SType::New();
+  reference->SetInput(image);
+  reference->ComputeFeretDiameterOn();
+  reference->ComputeOrientedBoundingBoxOn();
+  reference->SetLargeObjectNumberOfLines(itk::NumericTraits<itk::SizeValueType>::max());
+  reference->Update();
+
+  for (Utils::PixelType label = 1; label <= 4; ++label)
+  {
+    const Utils::LabelObjectType * expected = reference->GetOutput()->GetLabelObject(label);
+    for (const auto & l2s : filters)
+    {
+      const Utils::LabelObjectType * labelObject = l2s->GetOutput()->GetLabelObject(label);
+      EXPECT_EQ(expected->GetNumberOfPixels(), labelObject->GetNumberOfPixels());
+      EXPECT_EQ(expected->GetNumberOfPixelsOnBorder(), labelObject->GetNumberOfPixelsOnBorder());
+      EXPECT_EQ(expected->GetBoundingBox(), labelObject->GetBoundingBox());
+      EXPECT_NEAR(expected->GetPerimeterOnBorder(), labelObject->GetPerimeterOnBorder(), 1e-8);
+      EXPECT_NEAR(expected->GetPerimeter(), labelObject->GetPerimeter(), 1e-8);
+      EXPECT_NEAR(expected->GetFeretDiameter(), labelObject->GetFeretDiameter(), 1e-10);
+      EXPECT_NEAR(expected->GetElongation(), labelObject->GetElongation(), 1e-8);
+      EXPECT_NEAR(expected->GetFlatness(), labelObject->GetFlatness(), 1e-8);
+      ITK_EXPECT_VECTOR_NEAR(expected->GetCentroid(), labelObject->GetCentroid(), 1e-8);
+      ITK_EXPECT_VECTOR_NEAR(expected->GetPrincipalMoments(), labelObject->GetPrincipalMoments(), 1e-6);
+      ITK_EXPECT_VECTOR_NEAR(
+        expected->GetOrientedBoundingBoxSize(), labelObject->GetOrientedBoundingBoxSize(), 1e-6);
+    }
+  }
+}
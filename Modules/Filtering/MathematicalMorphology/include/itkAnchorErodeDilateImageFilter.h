@@ -33,6 +33,12 @@ namespace itk
  * The SetBoundary facility isn't necessary for operation of the
  * anchor method but is included for compatibility with other
  * morphology classes in itk.
+ *
+ * The kernel is applied one line of its decomposition at a time. All
+ * the lines of the image parallel to a line of the decomposition are
+ * independent, so they are split between all the threads before
+ * moving to the next direction, and the region is processed as a
+ * whole instead of one padded piece per thread.
  * \ingroup ITKMathematicalMorphology
  */
 template <typename TImage, typename TKernel, typename TFunction1>
@@ -79,9 +85,10 @@ protected:
   void
   PrintSelf(std::ostream & os, Indent indent) const override;
 
-  /** Multi-thread version GenerateData. */
+  /** Processes the lines of each direction of the kernel decomposition,
+   * split between the threads. */
   void
-  DynamicThreadedGenerateData(const InputImageRegionType & outputRegionForThread) override;
+  GenerateData() override;
 
 
   // should be set by the meta filter
@@ -19,7 +19,8 @@
 #define itkAnchorErodeDilateImageFilter_hxx
 
 #include "itkAnchorErodeDilateImageFilter.h"
-
+#include "itkImageAlgorithm.h"
+#include "itkProgressTransformer.h"
 
 #include "itkAnchorUtilities.h"
 namespace itk
@@ -27,14 +28,11 @@ namespace itk
 template <typename TImage, typename TKernel, typename TFunction1>
 AnchorErodeDilateImageFilter<TImage, TKernel, TFunction1>::AnchorErodeDilateImageFilter()
   : m_Boundary(NumericTraits<InputImagePixelType>::ZeroValue())
-{
-  this->DynamicMultiThreadingOn();
-}
+{}
 
 template <typename TImage, typename TKernel, typename TFunction1>
 void
-AnchorErodeDilateImageFilter<TImage, TKernel, TFunction1>::DynamicThreadedGenerateData(
-  const InputImageRegionType & outputRegionForThread)
+AnchorErodeDilateImageFilter<TImage, TKernel, TFunction1>::GenerateData()
 {
   // check that we are using a decomposable kernel
   if (!this->GetKernel().GetDecomposable())
@@ -45,17 +43,18 @@ AnchorErodeDilateImageFilter<TImage, TKernel, TFunction1>::DynamicThreadedGenera
   // TFunction1 will be < for erosions
   // TFunction2 will be <=
 
-  AnchorLineType AnchorLine;
+  // the lines are loaded one at a time into a buffer vector, where the
+  // erosion or dilation is carried out, and the result is copied back
+  // to an internal buffer. The lines of a direction never intersect, so
+  // each direction is processed in a single pass over the whole region,
+  // with the face of the lines split between the threads.
 
-  // the initial version will adopt the methodology of loading a line
-  // at a time into a buffer vector, carrying out the opening or
-  // closing, and then copy the result to the output. Hopefully this
-  // will improve cache performance when working along non raster
-  // directions.
+  this->AllocateOutputs();
 
   InputImageConstPointer input = this->GetInput();
 
-  InputImageRegionType IReg = outputRegionForThread;
+  InputImageRegionType OReg = this->GetOutput()->GetRequestedRegion();
+  InputImageRegionType IReg = OReg;
   IReg.PadByRadius(this->GetKernel().GetRadius());
   IReg.Crop(this->GetInput()->GetRequestedRegion());
 
@@ -65,8 +64,6 @@ AnchorErodeDilateImageFilter<TImage, TKernel, TFunction1>::DynamicThreadedGenera
   internalbuffer->Allocate();
   InputImagePointer output = internalbuffer;
 
-  // get the region size
-  InputImageRegionType OReg = outputRegionForThread;
   // maximum buffer length is sum of dimensions
   unsigned int bufflength = 0;
   for (unsigned i = 0; i < TImage::ImageDimension; i++)
@@ -77,13 +74,13 @@ AnchorErodeDilateImageFilter<TImage, TKernel, TFunction1>::DynamicThreadedGenera
   // compat
   bufflength += 2;
 
-  std::vector<InputImagePixelType> buffer(bufflength);
-  std::vector<InputImagePixelType> inbuffer(bufflength);
-
   // iterate over all the structuring elements
   typename KernelType::DecompType decomposition = this->GetKernel().GetLines();
   BresType                        BresLine;
 
+  MultiThreaderBase * multiThreader = this->GetMultiThreader();
+  multiThreader->SetNumberOfWorkUnits(this->GetNumberOfWorkUnits());
+
   for (unsigned i = 0; i < decomposition.size(); i++)
   {
     typename KernelType::LType     ThisLine = decomposition[i];
@@ -101,22 +98,26 @@ AnchorErodeDilateImageFilter<TImage, TKernel, TFunction1>::DynamicThreadedGenera
 
     InputImageRegionType BigFace = MakeEnlargedFace<InputImageType, KernelLType>(input, IReg, ThisLine);
 
-    AnchorLine.SetSize(SELength);
+    ProgressTransformer progress(
+      static_cast<float>(i) / decomposition.size(), static_cast<float>(i + 1) / decomposition.size(), this);
+    multiThreader->template ParallelizeImageRegion<InputImageDimension>(
+      BigFace,
+      [&](const InputImageRegionType & faceForThread) {
+        AnchorLineType AnchorLine;
+        AnchorLine.SetSize(SELength);
+        std::vector<InputImagePixelType> buffer(bufflength);
+        std::vector<InputImagePixelType> inbuffer(bufflength);
+        DoAnchorFace<TImage, BresType, AnchorLineType, KernelLType>(
+          input, output, m_Boundary, ThisLine, AnchorLine, TheseOffsets, inbuffer, buffer, IReg, faceForThread);
+      },
+      progress.GetProcessObject());
 
-    DoAnchorFace<TImage, BresType, AnchorLineType, KernelLType>(
-      input, output, m_Boundary, ThisLine, AnchorLine, TheseOffsets, inbuffer, buffer, IReg, BigFace);
     // after the first pass the input will be taken from the output
     input = internalbuffer;
   }
 
   // copy internal buffer to output
-  using IterType = ImageRegionIterator<InputImageType>;
-  IterType oit(this->GetOutput(), OReg);
-  IterType iit(internalbuffer, OReg);
-  for (oit.GoToBegin(), iit.GoToBegin(); !oit.IsAtEnd(); ++oit, ++iit)
-  {
-    oit.Set(iit.Get());
-  }
+  ImageAlgorithm::Copy(input.GetPointer(), this->GetOutput(), OReg, OReg);
 }
 
 template <typename TImage, typename TKernel, typename TFunction1>
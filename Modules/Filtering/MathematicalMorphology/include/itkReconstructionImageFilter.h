@@ -22,7 +22,10 @@
 #include "itkShapedNeighborhoodIterator.h"
 #include "itkImageRegionIterator.h"
 #include "itkProgressReporter.h"
+#include <algorithm>
+#include <deque>
 #include <queue>
+#include <vector>
 
 //#define BASIC
 #define COPY
@@ -43,6 +46,15 @@ namespace itk
  * applications and efficient algorithms" -- IEEE Transactions on
  * Image processing, Vol 2, No 2, pp 176-201, April 1993
  *
+ * When UseInternalCopy is on (the default), the image is split in slabs
+ * along its last dimension, one per work unit. The raster and
+ * antiraster scans are run on all the slabs in parallel, and the FIFO
+ * propagation uses one FIFO per slab: the pixels of the other slabs are
+ * updated between the rounds of propagation. For 8 bit pixel types,
+ * the FIFO of each slab is split in one FIFO per gray level, and the
+ * pixels with the strongest values are propagated first, so that most
+ * pixels are only set once.
+ *
  * \author Richard Beare. Department of Medicine, Monash University,
  * Melbourne, Australia.
  *
@@ -124,8 +136,9 @@ public:
 
   /**
    * Perform a padding of the image internally to increase the performance
-   * of the filter. UseInternalCopy can be set to false to reduce the memory
-   * usage.
+   * of the filter, and to process it with several threads. UseInternalCopy
+   * can be set to false to reduce the memory usage, in which case the
+   * filter is single threaded.
    */
   itkSetMacro(UseInternalCopy, bool);
   itkGetConstReferenceMacro(UseInternalCopy, bool);
@@ -150,6 +163,11 @@ protected:
   void
   GenerateData() override;
 
+  /** Reconstruction of the padded marker image in place, in parallel over
+   * slabs of the image. */
+  void
+  ParallelReconstruction(InputImageType * markerImage, const InputImageType * maskImage);
+
   /**
    * the value of the border - used in boundary condition.
    */
@@ -171,6 +189,70 @@ private:
   using InIndexType = typename InputImageType::IndexType;
   using CNInputIterator = ConstShapedNeighborhoodIterator<InputImageType>;
   using NOutputIterator = ShapedNeighborhoodIterator<OutputImageType>;
+
+  using BufferOffsetType = typename InputImageType::OffsetValueType;
+
+  /** FIFO of the pixels of a slab to propagate from, given by their
+   * offset in the buffer. For pixel types with at most 256 values, there
+   * is one FIFO per level, and the strongest levels are popped first. */
+  class PropagationQueue
+  {
+  public:
+    PropagationQueue()
+      : m_UseLevels(NumericTraits<InputImagePixelType>::is_integer && sizeof(InputImagePixelType) == 1)
+      , m_Levels(m_UseLevels ? 256 : 1)
+    {}
+
+    bool
+    Empty() const
+    {
+      return m_Size == 0;
+    }
+
+    void
+    Push(BufferOffsetType offset, InputImagePixelType value)
+    {
+      const unsigned int level = this->GetLevel(value);
+      m_Levels[level].push_back(offset);
+      m_Current = std::min(m_Current, level);
+      ++m_Size;
+    }
+
+    BufferOffsetType
+    Pop()
+    {
+      while (m_Levels[m_Current].empty())
+      {
+        ++m_Current;
+      }
+      const BufferOffsetType offset = m_Levels[m_Current].front();
+      m_Levels[m_Current].pop_front();
+      --m_Size;
+      return offset;
+    }
+
+  private:
+    // rank of the value, from the strongest to the weakest
+    unsigned int
+    GetLevel(InputImagePixelType value) const
+    {
+      if (!m_UseLevels)
+      {
+        return 0;
+      }
+      TCompare compare;
+      if (compare(1, 0))
+      {
+        return static_cast<unsigned int>(NumericTraits<InputImagePixelType>::max() - value);
+      }
+      return static_cast<unsigned int>(value - NumericTraits<InputImagePixelType>::NonpositiveMin());
+    }
+
+    bool                                      m_UseLevels;
+    std::vector<std::deque<BufferOffsetType>> m_Levels;
+    unsigned int                              m_Current{ 0 };
+    SizeValueType                             m_Size{ 0 };
+  };
 }; // end of class
 } // end namespace itk
 
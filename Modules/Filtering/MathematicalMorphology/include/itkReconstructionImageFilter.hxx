@@ -25,6 +25,9 @@
 
 #include "itkConstantPadImageFilter.h"
 #include "itkCropImageFilter.h"
+#include "itkProgressTransformer.h"
+#include <algorithm>
+#include <atomic>
 
 namespace itk
 {
@@ -72,11 +75,6 @@ ReconstructionImageFilter<TInputImage, TOutputImage, TCompare>::GenerateData()
 {
   // Allocate the output
   this->AllocateOutputs();
-  // there are 2 passes that use all pixels and a 3rd that uses some
-  // subset of the pixels. We'll just pretend that the third pass
-  // takes the same as each of the others. Is it OK to update more
-  // often than pixels?
-  ProgressReporter progress(this, 0, this->GetOutput()->GetRequestedRegion().GetNumberOfPixels() * 3);
 
   TCompare compare;
 
@@ -90,18 +88,14 @@ ReconstructionImageFilter<TInputImage, TOutputImage, TCompare>::GenerateData()
     itkExceptionMacro(<< "Marker and mask must have the same size.");
   }
 
-  // create padded versions of the marker image and the mask image
-  using PadType = typename itk::ConstantPadImageFilter<InputImageType, InputImageType>;
-
-  MarkerImageConstPointer markerImageP;
-  MaskImageConstPointer   maskImageP;
-
-  ISizeType padSize;
-
   if (m_UseInternalCopy)
   {
+    // create padded versions of the marker image and the mask image, and
+    // process them with several threads
+    using PadType = typename itk::ConstantPadImageFilter<InputImageType, InputImageType>;
     typename PadType::Pointer MaskPad = PadType::New();
     typename PadType::Pointer MarkerPad = PadType::New();
+    ISizeType                 padSize;
     padSize.Fill(1);
 
     MaskPad->SetConstant(m_MarkerValue);
@@ -116,24 +110,41 @@ ReconstructionImageFilter<TInputImage, TOutputImage, TCompare>::GenerateData()
     MaskPad->Update();
     MarkerPad->Update();
 
-    markerImageP = MarkerPad->GetOutput();
-    maskImageP = MaskPad->GetOutput();
+    this->ParallelReconstruction(MarkerPad->GetOutput(), MaskPad->GetOutput());
+
+    using CropType = typename itk::CropImageFilter<InputImageType, OutputImageType>;
+    typename CropType::Pointer crop = CropType::New();
+
+    crop->SetInput(MarkerPad->GetOutput());
+    crop->SetUpperBoundaryCropSize(padSize);
+    crop->SetLowerBoundaryCropSize(padSize);
+    crop->GraftOutput(this->GetOutput());
+    /** execute the minipipeline */
+    crop->Update();
+
+    /** graft the minipipeline output back into this filter's output */
+    this->GraftOutput(crop->GetOutput());
+    return;
   }
-  else
+
+  // there are 2 passes that use all pixels and a 3rd that uses some
+  // subset of the pixels. We'll just pretend that the third pass
+  // takes the same as each of the others. Is it OK to update more
+  // often than pixels?
+  ProgressReporter progress(this, 0, this->GetOutput()->GetRequestedRegion().GetNumberOfPixels() * 3);
+
+  MaskImageConstPointer maskImageP = this->GetMaskImage();
+  InputIteratorType     inIt(markerImage, output->GetRequestedRegion());
+  OutputIteratorType    outIt(output, output->GetRequestedRegion());
+  // copy marker to output - isn't there a better way?
+  while (!outIt.IsAtEnd())
   {
-    maskImageP = this->GetMaskImage();
-    InputIteratorType  inIt(markerImage, output->GetRequestedRegion());
-    OutputIteratorType outIt(output, output->GetRequestedRegion());
-    // copy marker to output - isn't there a better way?
-    while (!outIt.IsAtEnd())
-    {
-      MarkerImagePixelType currentValue = inIt.Get();
-      outIt.Set(static_cast<OutputImagePixelType>(currentValue));
-      ++inIt;
-      ++outIt;
-    }
-    markerImageP = output;
+    MarkerImagePixelType currentValue = inIt.Get();
+    outIt.Set(static_cast<OutputImagePixelType>(currentValue));
+    ++inIt;
+    ++outIt;
   }
+  MarkerImageConstPointer markerImageP = output.GetPointer();
 
   // declare our queue type
   using FifoType = typename std::queue<OutputImageIndexType>;
@@ -144,26 +155,6 @@ ReconstructionImageFilter<TInputImage, TOutputImage, TCompare>::GenerateData()
   CNInputIterator   mskNIt;
   ISizeType         kernelRadius;
   kernelRadius.Fill(1);
-  if (m_UseInternalCopy)
-  {
-    FaceCalculatorType faceCalculator;
-
-    FaceListType   faceList;
-    FaceListTypeIt fit;
-
-    faceList = faceCalculator(maskImageP, maskImageP->GetLargestPossibleRegion(), kernelRadius);
-    // we will only be processing the body region
-    fit = faceList.begin();
-    // must be a better way of doing this
-    NOutputIterator tt(kernelRadius, markerImageP, *fit);
-    outNIt = tt;
-
-    InputIteratorType ttt(maskImageP, *fit);
-    mskIt = ttt;
-    CNInputIterator tttt(kernelRadius, maskImageP, *fit);
-    mskNIt = tttt;
-  }
-  else
   {
     NOutputIterator tt(kernelRadius, markerImageP, output->GetRequestedRegion());
     outNIt = tt;
@@ -321,21 +312,304 @@ ReconstructionImageFilter<TInputImage, TOutputImage, TCompare>::GenerateData()
     progress.CompletedPixel();
   }
 
-  if (m_UseInternalCopy)
+}
+
+template <typename TInputImage, typename TOutputImage, typename TCompare>
+void
+ReconstructionImageFilter<TInputImage, TOutputImage, TCompare>::ParallelReconstruction(
+  InputImageType *       markerImage,
+  const InputImageType * maskImage)
+{
+  constexpr unsigned int Dimension = InputImageType::ImageDimension;
+  constexpr unsigned int SlabDimension = Dimension - 1;
+
+  TCompare compare;
+
+  // the images are padded by one pixel with the marker value, so all the
+  // neighbors of the pixels of the body are in the buffer, and the
+  // padding is never propagated to
+  const MarkerImageRegionType & bufferedRegion = markerImage->GetBufferedRegion();
+  MarkerImageRegionType         body = bufferedRegion;
+  ISizeType                     radius;
+  radius.Fill(1);
+  body.ShrinkByRadius(radius);
+
+  InputImagePixelType *       out = markerImage->GetBufferPointer();
+  const InputImagePixelType * msk = maskImage->GetBufferPointer();
+  const BufferOffsetType *    offsetTable = markerImage->GetOffsetTable();
+  const BufferOffsetType      planeStride = offsetTable[SlabDimension];
+
+  // offsets of the neighbors in the buffer, with the plane they are in
+  // relative to the center. The previous neighbors come before the center
+  // in raster order, and the later ones after it.
+  std::vector<BufferOffsetType> neighbors;
+  std::vector<int>              neighborPlanes;
+  unsigned int                  numberOfNeighborhoodPixels = 1;
+  for (unsigned int d = 0; d < Dimension; ++d)
   {
-    using CropType = typename itk::CropImageFilter<InputImageType, OutputImageType>;
-    typename CropType::Pointer crop = CropType::New();
+    numberOfNeighborhoodPixels *= 3;
+  }
+  for (unsigned int i = 0; i < numberOfNeighborhoodPixels; ++i)
+  {
+    BufferOffsetType offset = 0;
+    unsigned int     numberOfNonZero = 0;
+    int              plane = 0;
+    for (unsigned int d = 0, rest = i; d < Dimension; ++d, rest /= 3)
+    {
+      const int o = static_cast<int>(rest % 3) - 1;
+      offset += o * offsetTable[d];
+      numberOfNonZero += (o != 0);
+      plane = o;
+    }
+    if (numberOfNonZero == 0 || (!m_FullyConnected && numberOfNonZero > 1))
+    {
+      continue;
+    }
+    neighbors.push_back(offset);
+    neighborPlanes.push_back(plane);
+  }
 
-    crop->SetInput(markerImageP);
-    crop->SetUpperBoundaryCropSize(padSize);
-    crop->SetLowerBoundaryCropSize(padSize);
-    crop->GraftOutput(this->GetOutput());
-    /** execute the minipipeline */
-    crop->Update();
+  // the neighbors to visit in a scan. Across the boundaries between the
+  // slabs, the neighbors are left to the propagation step.
+  auto selectNeighbors = [&](bool later, bool otherPlanes) {
+    std::vector<BufferOffsetType> selected;
+    for (unsigned int i = 0; i < neighbors.size(); ++i)
+    {
+      if ((neighbors[i] > 0) == later && (otherPlanes || neighborPlanes[i] == 0))
+      {
+        selected.push_back(neighbors[i]);
+      }
+    }
+    return selected;
+  };
+  const std::vector<BufferOffsetType> previous = selectNeighbors(false, true);
+  const std::vector<BufferOffsetType> previousInPlane = selectNeighbors(false, false);
+  const std::vector<BufferOffsetType> later = selectNeighbors(true, true);
+  const std::vector<BufferOffsetType> laterInPlane = selectNeighbors(true, false);
+
+  // slabs of planes along the last dimension. The scan lines are along the
+  // first dimension, so the 1D images are processed in a single slab.
+  const IndexValueType firstPlane = body.GetIndex(SlabDimension);
+  const SizeValueType  numberOfPlanes = body.GetSize(SlabDimension);
+  SizeValueType        numberOfSlabs = 1;
+  if (Dimension > 1)
+  {
+    numberOfSlabs = std::max<SizeValueType>(1, std::min<SizeValueType>(this->GetNumberOfWorkUnits(), numberOfPlanes));
+  }
+  std::vector<SizeValueType> slabStart(numberOfSlabs + 1);
+  for (SizeValueType s = 0; s <= numberOfSlabs; ++s)
+  {
+    slabStart[s] = numberOfPlanes * s / numberOfSlabs;
+  }
+  // slab of each plane, with the padding planes which do not belong to any
+  std::vector<SizeValueType> planeSlab(numberOfPlanes + 2, numberOfSlabs);
+  for (SizeValueType s = 0; s < numberOfSlabs; ++s)
+  {
+    for (SizeValueType z = slabStart[s]; z < slabStart[s + 1]; ++z)
+    {
+      planeSlab[z + 1] = s;
+    }
+  }
+  auto slabOf = [&](BufferOffsetType offset) { return planeSlab[offset / planeStride]; };
 
-    /** graft the minipipeline output back into this filter's output */
-    this->GraftOutput(crop->GetOutput());
+  // the scan lines of a slab, and the plane they are in
+  const SizeValueType lineLength = body.GetSize(0);
+
+  auto slabRegion = [&](SizeValueType s) {
+    MarkerImageRegionType region = body;
+    if (Dimension > 1)
+    {
+      region.SetIndex(SlabDimension, firstPlane + static_cast<IndexValueType>(slabStart[s]));
+      region.SetSize(SlabDimension, slabStart[s + 1] - slabStart[s]);
+    }
+    return region;
+  };
+  auto lineStart = [&](const MarkerImageRegionType & region, SizeValueType line, IndexValueType & plane) {
+    InputImageIndexType index = region.GetIndex();
+    for (unsigned int d = 1; d < Dimension; ++d)
+    {
+      index[d] += static_cast<IndexValueType>(line % region.GetSize(d));
+      line /= region.GetSize(d);
+    }
+    plane = index[SlabDimension] - firstPlane;
+    return markerImage->ComputeOffset(index);
+  };
+
+  MultiThreaderBase * multiThreader = this->GetMultiThreader();
+  multiThreader->SetNumberOfWorkUnits(this->GetNumberOfWorkUnits());
+
+  // raster and antiraster scans of each slab
+  std::atomic<bool> validMarker(true);
+  {
+    ProgressTransformer progress(0.0f, 0.5f, this);
+    multiThreader->ParallelizeArray(
+      0,
+      numberOfSlabs,
+      [&](SizeValueType s) {
+        const MarkerImageRegionType region = slabRegion(s);
+        const SizeValueType         numberOfLines = region.GetNumberOfPixels() / lineLength;
+        const IndexValueType        firstSlabPlane = static_cast<IndexValueType>(slabStart[s]);
+        const IndexValueType        lastSlabPlane = static_cast<IndexValueType>(slabStart[s + 1]) - 1;
+        IndexValueType              plane;
+        for (SizeValueType line = 0; line < numberOfLines; ++line)
+        {
+          const BufferOffsetType                start = lineStart(region, line, plane);
+          const std::vector<BufferOffsetType> & visited =
+            (plane == firstSlabPlane && s > 0) ? previousInPlane : previous;
+          for (BufferOffsetType p = start; p < start + static_cast<BufferOffsetType>(lineLength); ++p)
+          {
+            InputImagePixelType       V = out[p];
+            const InputImagePixelType iV = msk[p];
+            // be sure that the pixels in the images follow the preconditions
+            if (compare(V, iV))
+            {
+              validMarker = false;
+            }
+            for (const BufferOffsetType o : visited)
+            {
+              if (compare(out[p + o], V))
+              {
+                V = out[p + o];
+              }
+            }
+            // this step clamps to the mask
+            out[p] = compare(V, iV) ? iV : V;
+          }
+        }
+        for (SizeValueType line = numberOfLines; line-- > 0;)
+        {
+          const BufferOffsetType                start = lineStart(region, line, plane);
+          const std::vector<BufferOffsetType> & visited =
+            (plane == lastSlabPlane && s + 1 < numberOfSlabs) ? laterInPlane : later;
+          for (BufferOffsetType p = start + static_cast<BufferOffsetType>(lineLength); p-- > start;)
+          {
+            InputImagePixelType V = out[p];
+            for (const BufferOffsetType o : visited)
+            {
+              if (compare(out[p + o], V))
+              {
+                V = out[p + o];
+              }
+            }
+            out[p] = compare(V, msk[p]) ? msk[p] : V;
+          }
+        }
+      },
+      progress.GetProcessObject());
+  }
+  if (!validMarker)
+  {
+    if (compare(0, 1))
+    {
+      itkExceptionMacro(<< "Marker pixels must be <= mask pixels.");
+    }
+    else
+    {
+      itkExceptionMacro(<< "Marker pixels must be >= mask pixels.");
+    }
+  }
+
+  // the pixels which can still be propagated from, in the FIFO of their
+  // slab: the ones with a later neighbor to modify, and on the boundaries
+  // of the slabs the ones with any neighbor to modify
+  std::vector<PropagationQueue> queues(numberOfSlabs);
+  multiThreader->ParallelizeArray(
+    0,
+    numberOfSlabs,
+    [&](SizeValueType s) {
+      const MarkerImageRegionType region = slabRegion(s);
+      const SizeValueType         numberOfLines = region.GetNumberOfPixels() / lineLength;
+      IndexValueType              plane;
+      for (SizeValueType line = 0; line < numberOfLines; ++line)
+      {
+        const BufferOffsetType start = lineStart(region, line, plane);
+        const bool onBoundary = (plane == static_cast<IndexValueType>(slabStart[s]) && s > 0) ||
+                                (plane + 1 == static_cast<IndexValueType>(slabStart[s + 1]) && s + 1 < numberOfSlabs);
+        const std::vector<BufferOffsetType> & visited = onBoundary ? neighbors : later;
+        for (BufferOffsetType p = start; p < start + static_cast<BufferOffsetType>(lineLength); ++p)
+        {
+          const InputImagePixelType V = out[p];
+          for (const BufferOffsetType o : visited)
+          {
+            if (compare(V, out[p + o]) && compare(msk[p + o], out[p + o]))
+            {
+              queues[s].Push(p, V);
+              break;
+            }
+          }
+        }
+      }
+    },
+    nullptr);
+
+  // propagation in rounds: each slab is processed by its own thread, and
+  // the pixels of the neighbor slabs are updated between the rounds
+  std::vector<std::vector<BufferOffsetType>> exchanges(numberOfSlabs);
+
+  auto propagate = [&](BufferOffsetType p, BufferOffsetType n) {
+    const InputImagePixelType V = out[p];
+    const InputImagePixelType VN = out[n];
+    const InputImagePixelType iN = msk[n];
+    // candidate for dilation via flooding
+    if (compare(V, VN) && Math::NotAlmostEquals(iN, VN))
+    {
+      // propagate the center value, clamped by the mask
+      out[n] = compare(iN, V) ? V : iN;
+      return true;
+    }
+    return false;
+  };
+  bool done = false;
+  while (!done)
+  {
+    multiThreader->ParallelizeArray(
+      0,
+      numberOfSlabs,
+      [&](SizeValueType s) {
+        PropagationQueue & queue = queues[s];
+        while (!queue.Empty())
+        {
+          const BufferOffsetType p = queue.Pop();
+          bool                   crossesSlabs = false;
+          for (const BufferOffsetType o : neighbors)
+          {
+            const SizeValueType t = slabOf(p + o);
+            if (t != s && t != numberOfSlabs)
+            {
+              crossesSlabs = true;
+            }
+            else if (propagate(p, p + o))
+            {
+              queue.Push(p + o, out[p + o]);
+            }
+          }
+          if (crossesSlabs)
+          {
+            exchanges[s].push_back(p);
+          }
+        }
+      },
+      nullptr);
+
+    done = true;
+    for (SizeValueType s = 0; s < numberOfSlabs; ++s)
+    {
+      for (const BufferOffsetType p : exchanges[s])
+      {
+        for (const BufferOffsetType o : neighbors)
+        {
+          const SizeValueType t = slabOf(p + o);
+          if (t != s && t != numberOfSlabs && propagate(p, p + o))
+          {
+            queues[t].Push(p + o, out[p + o]);
+            done = false;
+          }
+        }
+      }
+      exchanges[s].clear();
+    }
   }
+  this->UpdateProgress(1.0f);
 }
 
 template <typename TInputImage, typename TOutputImage, typename TCompare>
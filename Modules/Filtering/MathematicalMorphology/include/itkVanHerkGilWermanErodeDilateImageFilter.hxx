@@ -20,6 +20,7 @@
 
 #include "itkVanHerkGilWermanErodeDilateImageFilter.h"
 #include "itkImageRegionIterator.h"
+#include "itkProgressTransformer.h"
 
 #include "itkVanHerkGilWermanUtilities.h"
 
@@ -28,15 +29,11 @@ namespace itk
 template <typename TImage, typename TKernel, typename TFunction1>
 VanHerkGilWermanErodeDilateImageFilter<TImage, TKernel, TFunction1>::VanHerkGilWermanErodeDilateImageFilter()
   : m_Boundary(NumericTraits<InputImagePixelType>::ZeroValue())
-{
-  this->DynamicMultiThreadingOn();
-  this->ThreaderUpdateProgressOff();
-}
+{}
 
 template <typename TImage, typename TKernel, typename TFunction1>
 void
-VanHerkGilWermanErodeDilateImageFilter<TImage, TKernel, TFunction1>::DynamicThreadedGenerateData(
-  const InputImageRegionType & outputRegionForThread)
+VanHerkGilWermanErodeDilateImageFilter<TImage, TKernel, TFunction1>::GenerateData()
 {
   // check that we are using a decomposable kernel
   if (!this->GetKernel().GetDecomposable())
@@ -47,21 +44,19 @@ VanHerkGilWermanErodeDilateImageFilter<TImage, TKernel, TFunction1>::DynamicThre
 
   // TFunction1 will be < for erosions
 
-  // the initial version will adopt the methodology of loading a line
-  // at a time into a buffer vector, carrying out the opening or
-  // closing, and then copy the result to the output. Hopefully this
-  // will improve cache performance when working along non raster
-  // directions.
+  // the lines are loaded one at a time into a buffer vector, where the
+  // erosion or dilation is carried out, and the result is copied back
+  // to an internal buffer. The lines of a direction never intersect, so
+  // each direction is processed in a single pass over the whole region,
+  // with the face of the lines split between the threads.
 
-  InputImageConstPointer input = this->GetInput();
+  this->AllocateOutputs();
 
-  SizeValueType totalPixels =
-    this->GetKernel().GetLines().size() * this->GetOutput()->GetRequestedRegion().GetNumberOfPixels();
-  TotalProgressReporter progress(this, totalPixels);
+  InputImageConstPointer input = this->GetInput();
 
-  InputImageRegionType IReg = outputRegionForThread;
+  InputImageRegionType OReg = this->GetOutput()->GetRequestedRegion();
+  InputImageRegionType IReg = OReg;
   IReg.PadByRadius(this->GetKernel().GetRadius());
-  // IReg.PadByRadius( this->GetKernel().GetRadius() );
   IReg.Crop(this->GetInput()->GetRequestedRegion());
 
   // allocate an internal buffer
@@ -70,8 +65,6 @@ VanHerkGilWermanErodeDilateImageFilter<TImage, TKernel, TFunction1>::DynamicThre
   internalbuffer->Allocate();
   InputImagePointer output = internalbuffer;
 
-  // get the region size
-  InputImageRegionType OReg = outputRegionForThread;
   // maximum buffer length is sum of dimensions
   unsigned int bufflength = 0;
   for (unsigned i = 0; i < TImage::ImageDimension; i++)
@@ -82,15 +75,15 @@ VanHerkGilWermanErodeDilateImageFilter<TImage, TKernel, TFunction1>::DynamicThre
   // compat
   bufflength += 2;
 
-  std::vector<InputImagePixelType> buffer(bufflength);
-  std::vector<InputImagePixelType> forward(bufflength);
-  std::vector<InputImagePixelType> reverse(bufflength);
   // iterate over all the structuring elements
   typename KernelType::DecompType decomposition = this->GetKernel().GetLines();
   BresType                        BresLine;
 
   using KernelLType = typename KernelType::LType;
 
+  MultiThreaderBase * multiThreader = this->GetMultiThreader();
+  multiThreader->SetNumberOfWorkUnits(this->GetNumberOfWorkUnits());
+
   for (unsigned i = 0; i < decomposition.size(); i++)
   {
     typename KernelType::LType     ThisLine = decomposition[i];
@@ -104,12 +97,21 @@ VanHerkGilWermanErodeDilateImageFilter<TImage, TKernel, TFunction1>::DynamicThre
 
     InputImageRegionType BigFace = MakeEnlargedFace<InputImageType, KernelLType>(input, IReg, ThisLine);
 
-    DoFace<TImage, BresType, TFunction1, KernelLType>(
-      input, output, m_Boundary, ThisLine, TheseOffsets, SELength, buffer, forward, reverse, IReg, BigFace);
+    ProgressTransformer progress(
+      static_cast<float>(i) / decomposition.size(), static_cast<float>(i + 1) / decomposition.size(), this);
+    multiThreader->template ParallelizeImageRegion<InputImageDimension>(
+      BigFace,
+      [&](const InputImageRegionType & faceForThread) {
+        std::vector<InputImagePixelType> buffer(bufflength);
+        std::vector<InputImagePixelType> forward(bufflength);
+        std::vector<InputImagePixelType> reverse(bufflength);
+        DoFace<TImage, BresType, TFunction1, KernelLType>(
+          input, output, m_Boundary, ThisLine, TheseOffsets, SELength, buffer, forward, reverse, IReg, faceForThread);
+      },
+      progress.GetProcessObject());
 
     // after the first pass the input will be taken from the output
     input = internalbuffer;
-    progress.Completed(IReg.GetNumberOfPixels());
   }
 
   // copy internal buffer to output
@@ -191,14 +191,12 @@ DoFace(typename TImage::ConstPointer             input,
         {
           pixbuffer[j] = fExtBuffer[j + KernLen / 2];
         }
-        for (unsigned j = KernLen / 2, k = KernLen / 2 + KernLen / 2, l = KernLen / 2 - KernLen / 2;
-             j < size - KernLen / 2;
-             j++, k++, l++)
+        // the bulk of the line is a plain element wise combination of
+        // the two extreme buffers, which the compiler can vectorize
+        const unsigned half = KernLen / 2;
+        for (unsigned j = 0; j < size - 2 * half; j++)
         {
-
-          typename TImage::PixelType V1 = fExtBuffer[k];
-          typename TImage::PixelType V2 = rExtBuffer[l];
-          pixbuffer[j] = m_TF(V1, V2);
+          pixbuffer[j + half] = m_TF(fExtBuffer[j + 2 * half], rExtBuffer[j]);
         }
         // line end -- involves reseting the end of the reverse
         // extreme array
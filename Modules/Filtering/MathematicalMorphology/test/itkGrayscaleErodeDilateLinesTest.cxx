@@ -0,0 +1,238 @@
+/*=========================================================================
+ *
+ *  Copyright NumFOCUS
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include "itkFlatStructuringElement.h"
+#include "itkGrayscaleDilateImageFilter.h"
+#include "itkGrayscaleErodeImageFilter.h"
+#include "itkImageRegionIteratorWithIndex.h"
+#include "itkTestingMacros.h"
+#include "itkTimeProbe.h"
+
+namespace
+{
+// Pseudo random values with some structure, so that the extrema of the
+// lines are not always at the same place
+template <typename TImage>
+typename TImage::Pointer
+CreateImage(const typename TImage::SizeType & size)
+{
+  auto image = TImage::New();
+  image->SetRegions(size);
+  image->Allocate();
+
+  itk::ImageRegionIteratorWithIndex<TImage> it(image, image->GetLargestPossibleRegion());
+  unsigned int                              state = 12345;
+  for (; !it.IsAtEnd(); ++it)
+  {
+    state = state * 1103515245u + 12345u;
+    const typename TImage::IndexType & idx = it.GetIndex();
+    unsigned int                       value = (state >> 16) % 64;
+    for (unsigned int d = 0; d < TImage::ImageDimension; ++d)
+    {
+      value += static_cast<unsigned int>(idx[d] * (d + 3));
+    }
+    it.Set(static_cast<typename TImage::PixelType>(value % 4000));
+  }
+  return image;
+}
+
+template <typename TImage>
+bool
+CompareImages(const TImage *                      image,
+              const TImage *                      reference,
+              const typename TImage::RegionType & region,
+              const char *                        description)
+{
+  itk::ImageRegionConstIteratorWithIndex<TImage> it(image, region);
+  itk::ImageRegionConstIterator<TImage>          referenceIt(reference, region);
+  for (; !referenceIt.IsAtEnd(); ++it, ++referenceIt)
+  {
+    if (it.Get() != referenceIt.Get())
+    {
+      std::cerr << "Test failed for " << description << std::endl;
+      std::cerr << "Error at index " << it.GetIndex() << std::endl;
+      std::cerr << "Expected: " << static_cast<double>(referenceIt.Get())
+                << ", but got: " << static_cast<double>(it.Get()) << std::endl;
+      return false;
+    }
+  }
+  return true;
+}
+
+// Runs the given morphology filter with an algorithm, and returns its output
+template <typename TFilter>
+typename TFilter::OutputImageType::Pointer
+Run(const typename TFilter::InputImageType * image,
+    const typename TFilter::KernelType &     kernel,
+    int                                      algorithm,
+    itk::ThreadIdType                        numberOfWorkUnits,
+    itk::TimeProbe *                         probe = nullptr)
+{
+  auto filter = TFilter::New();
+  filter->SetInput(image);
+  filter->SetKernel(kernel);
+  filter->SetAlgorithm(algorithm);
+  filter->SetNumberOfWorkUnits(numberOfWorkUnits);
+  if (probe)
+  {
+    probe->Start();
+  }
+  filter->Update();
+  if (probe)
+  {
+    probe->Stop();
+  }
+  typename TFilter::OutputImageType::Pointer output = filter->GetOutput();
+  output->DisconnectPipeline();
+  return output;
+}
+
+// Compares the anchor and van Herk/Gil-Werman algorithms with the basic
+// one, and their multithreaded results with the single threaded ones.
+// The line decompositions of the kernels which are not boxes are only
+// exact at more than a radius from the image boundary.
+template <typename TFilter>
+bool
+CheckAlgorithms(const typename TFilter::InputImageType * image,
+                const typename TFilter::KernelType &     kernel,
+                bool                                     isBox,
+                const char *                             description)
+{
+  using ImageType = typename TFilter::OutputImageType;
+  typename ImageType::RegionType region = image->GetLargestPossibleRegion();
+  typename ImageType::RegionType interior = region;
+  if (!isBox)
+  {
+    interior.ShrinkByRadius(kernel.GetRadius());
+  }
+
+  const typename ImageType::Pointer basic = Run<TFilter>(image, kernel, TFilter::BASIC, 1);
+  const typename ImageType::Pointer anchor = Run<TFilter>(image, kernel, TFilter::ANCHOR, 1);
+  const typename ImageType::Pointer vhgw = Run<TFilter>(image, kernel, TFilter::VHGW, 1);
+  std::cout << description << std::endl;
+  bool passed = CompareImages<ImageType>(anchor, basic, interior, description);
+  passed &= CompareImages<ImageType>(vhgw, basic, interior, description);
+
+  for (itk::ThreadIdType numberOfWorkUnits : { 2, 5 })
+  {
+    std::cout << description << ", " << numberOfWorkUnits << " work units" << std::endl;
+    passed &= CompareImages<ImageType>(
+      Run<TFilter>(image, kernel, TFilter::ANCHOR, numberOfWorkUnits), anchor, region, description);
+    passed &= CompareImages<ImageType>(
+      Run<TFilter>(image, kernel, TFilter::VHGW, numberOfWorkUnits), vhgw, region, description);
+  }
+  return passed;
+}
+} // namespace
+
+// Checks the line based algorithms of the grayscale erosion and dilation
+// against the basic one for several kernels, pixel types and numbers of
+// work units, and times them over a range of radii.
+int
+itkGrayscaleErodeDilateLinesTest(int, char *[])
+{
+  bool passed = true;
+
+  // 2D, 8 bit and 16 bit
+  {
+    constexpr unsigned int Dimension = 2;
+    using KernelType = itk::FlatStructuringElement<Dimension>;
+    using ImageType = itk::Image<unsigned char, Dimension>;
+    using ShortImageType = itk::Image<unsigned short, Dimension>;
+    using DilateType = itk::GrayscaleDilateImageFilter<ImageType, ImageType, KernelType>;
+    using ErodeType = itk::GrayscaleErodeImageFilter<ImageType, ImageType, KernelType>;
+    using ShortDilateType = itk::GrayscaleDilateImageFilter<ShortImageType, ShortImageType, KernelType>;
+    using ShortErodeType = itk::GrayscaleErodeImageFilter<ShortImageType, ShortImageType, KernelType>;
+
+    // An odd size, so that the lines are not multiples of the kernel length
+    ImageType::SizeType           size = { { 67, 45 } };
+    const ImageType::Pointer      image = CreateImage<ImageType>(size);
+    const ShortImageType::Pointer shortImage = CreateImage<ShortImageType>(size);
+    KernelType::RadiusType        radius = { { 4, 3 } };
+    const KernelType              box = KernelType::Box(radius);
+    KernelType::RadiusType        polygonRadius = { { 5, 5 } };
+    const KernelType              polygon = KernelType::Polygon(polygonRadius, 4);
+    ITK_TEST_EXPECT_TRUE(box.GetDecomposable());
+    ITK_TEST_EXPECT_TRUE(polygon.GetDecomposable());
+
+    passed &= CheckAlgorithms<DilateType>(image, box, true, "2D 8 bit box dilation");
+    passed &= CheckAlgorithms<ErodeType>(image, box, true, "2D 8 bit box erosion");
+    passed &= CheckAlgorithms<DilateType>(image, polygon, false, "2D 8 bit polygon dilation");
+    passed &= CheckAlgorithms<ErodeType>(image, polygon, false, "2D 8 bit polygon erosion");
+    passed &= CheckAlgorithms<ShortDilateType>(shortImage, box, true, "2D 16 bit box dilation");
+    passed &= CheckAlgorithms<ShortErodeType>(shortImage, polygon, false, "2D 16 bit polygon erosion");
+  }
+
+  // 3D, 16 bit
+  {
+    constexpr unsigned int Dimension = 3;
+    using KernelType = itk::FlatStructuringElement<Dimension>;
+    using ImageType = itk::Image<unsigned short, Dimension>;
+    using DilateType = itk::GrayscaleDilateImageFilter<ImageType, ImageType, KernelType>;
+    using ErodeType = itk::GrayscaleErodeImageFilter<ImageType, ImageType, KernelType>;
+
+    ImageType::SizeType      size = { { 23, 19, 17 } };
+    const ImageType::Pointer image = CreateImage<ImageType>(size);
+    KernelType::RadiusType   radius = { { 2, 1, 3 } };
+    const KernelType         box = KernelType::Box(radius);
+    radius.Fill(3);
+    const KernelType cube = KernelType::Box(radius);
+
+    passed &= CheckAlgorithms<DilateType>(image, box, true, "3D 16 bit box dilation");
+    passed &= CheckAlgorithms<ErodeType>(image, cube, true, "3D 16 bit box erosion");
+  }
+
+  // Radius sweep: the basic algorithm grows with the number of pixels of
+  // the kernel while the line based ones do not depend on the radius
+  {
+    constexpr unsigned int Dimension = 2;
+    using KernelType = itk::FlatStructuringElement<Dimension>;
+    using ImageType = itk::Image<unsigned char, Dimension>;
+    using DilateType = itk::GrayscaleDilateImageFilter<ImageType, ImageType, KernelType>;
+
+    ImageType::SizeType      size = { { 512, 512 } };
+    const ImageType::Pointer image = CreateImage<ImageType>(size);
+    const itk::ThreadIdType  numberOfWorkUnits = itk::MultiThreaderBase::GetGlobalDefaultNumberOfThreads();
+
+    std::cout << "Radius\tBasic\tAnchor\tVHGW (s, " << numberOfWorkUnits << " work units)" << std::endl;
+    for (unsigned int r : { 1, 2, 4, 8, 16, 32 })
+    {
+      KernelType::RadiusType radius;
+      radius.Fill(r);
+      const KernelType kernel = KernelType::Box(radius);
+
+      itk::TimeProbe basicProbe;
+      itk::TimeProbe anchorProbe;
+      itk::TimeProbe vhgwProbe;
+
+      ImageType::Pointer anchor = Run<DilateType>(image, kernel, DilateType::ANCHOR, numberOfWorkUnits, &anchorProbe);
+      ImageType::Pointer vhgw = Run<DilateType>(image, kernel, DilateType::VHGW, numberOfWorkUnits, &vhgwProbe);
+      passed &= CompareImages<ImageType>(vhgw, anchor, image->GetLargestPossibleRegion(), "radius sweep");
+      if (r <= 8)
+      {
+        ImageType::Pointer basic = Run<DilateType>(image, kernel, DilateType::BASIC, numberOfWorkUnits, &basicProbe);
+        passed &= CompareImages<ImageType>(anchor, basic, image->GetLargestPossibleRegion(), "radius sweep");
+      }
+      std::cout << r << '\t' << basicProbe.GetTotal() << '\t' << anchorProbe.GetTotal() << '\t'
+                << vhgwProbe.GetTotal() << std::endl;
+    }
+  }
+
+  std::cout << "Test finished." << std::endl;
+  return passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
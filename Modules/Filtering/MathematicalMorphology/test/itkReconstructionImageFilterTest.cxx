@@ -0,0 +1,225 @@
+/*=========================================================================
+ *
+ *  Copyright NumFOCUS
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include "itkGrayscaleFillholeImageFilter.h"
+#include "itkImageRegionIteratorWithIndex.h"
+#include "itkReconstructionByDilationImageFilter.h"
+#include "itkReconstructionByErosionImageFilter.h"
+#include "itkTestingMacros.h"
+
+namespace
+{
+// Basins and peaks of various heights, with narrow paths between them
+// which cross the whole image back and forth
+template <typename TImage>
+typename TImage::Pointer
+CreateMask(const typename TImage::SizeType & size)
+{
+  auto image = TImage::New();
+  image->SetRegions(size);
+  image->Allocate();
+
+  itk::ImageRegionIteratorWithIndex<TImage> it(image, image->GetLargestPossibleRegion());
+  unsigned int                              state = 4321;
+  for (; !it.IsAtEnd(); ++it)
+  {
+    state = state * 1103515245u + 12345u;
+    const typename TImage::IndexType & idx = it.GetIndex();
+    unsigned int                       value = 20 + (state >> 16) % 40;
+    for (unsigned int d = 0; d < TImage::ImageDimension; ++d)
+    {
+      value += static_cast<unsigned int>((idx[d] / 5) % 3) * 30;
+    }
+    if (idx[0] % 7 == 3 || idx[TImage::ImageDimension - 1] % 9 == 4)
+    {
+      value = 250 - value / 4;
+    }
+    it.Set(static_cast<typename TImage::PixelType>(value % 250));
+  }
+  return image;
+}
+
+// Marker with a few seeds equal to the mask, at both ends of the last
+// dimension, so that the reconstruction crosses the whole image
+template <typename TImage>
+typename TImage::Pointer
+CreateMarker(const TImage * mask, bool dilation)
+{
+  constexpr unsigned int   Last = TImage::ImageDimension - 1;
+  const itk::SizeValueType lastSize = mask->GetLargestPossibleRegion().GetSize(Last);
+
+  auto image = TImage::New();
+  image->SetRegions(mask->GetLargestPossibleRegion());
+  image->Allocate();
+
+  using PixelType = typename TImage::PixelType;
+  itk::ImageRegionIteratorWithIndex<TImage> it(image, image->GetLargestPossibleRegion());
+  itk::ImageRegionConstIterator<TImage>     maskIt(mask, image->GetLargestPossibleRegion());
+  for (; !it.IsAtEnd(); ++it, ++maskIt)
+  {
+    const typename TImage::IndexType & idx = it.GetIndex();
+    bool                               seed = idx[Last] < 3 || idx[Last] + 1 == static_cast<itk::IndexValueType>(lastSize);
+    for (unsigned int d = 0; d < Last; ++d)
+    {
+      seed &= (idx[d] % 11 == 5);
+    }
+    if (dilation)
+    {
+      it.Set(seed ? maskIt.Get() : static_cast<PixelType>(maskIt.Get() / 3));
+    }
+    else
+    {
+      it.Set(seed ? maskIt.Get() : static_cast<PixelType>(255));
+    }
+  }
+  return image;
+}
+
+template <typename TImage>
+bool
+CompareImages(const TImage * image, const TImage * reference, const std::string & description)
+{
+  itk::ImageRegionConstIteratorWithIndex<TImage> it(image, reference->GetLargestPossibleRegion());
+  itk::ImageRegionConstIterator<TImage>          referenceIt(reference, reference->GetLargestPossibleRegion());
+  for (; !referenceIt.IsAtEnd(); ++it, ++referenceIt)
+  {
+    if (it.Get() != referenceIt.Get())
+    {
+      std::cerr << "Test failed for " << description << std::endl;
+      std::cerr << "Error at index " << it.GetIndex() << std::endl;
+      std::cerr << "Expected: " << static_cast<double>(referenceIt.Get())
+                << ", but got: " << static_cast<double>(it.Get()) << std::endl;
+      return false;
+    }
+  }
+  return true;
+}
+
+// Compares the multithreaded reconstruction with the single threaded one
+// computed without internal copy
+template <typename TFilter>
+bool
+CheckReconstruction(const typename TFilter::InputImageType * marker,
+                    const typename TFilter::InputImageType * mask,
+                    const std::string &                      description)
+{
+  using ImageType = typename TFilter::OutputImageType;
+
+  bool passed = true;
+  for (bool fullyConnected : { false, true })
+  {
+    auto reference = TFilter::New();
+    reference->SetMarkerImage(marker);
+    reference->SetMaskImage(mask);
+    reference->SetFullyConnected(fullyConnected);
+    reference->UseInternalCopyOff();
+    reference->Update();
+
+    for (itk::ThreadIdType numberOfWorkUnits : { 1, 3, 8 })
+    {
+      const std::string name = description + (fullyConnected ? ", fully connected, " : ", face connected, ") +
+                               std::to_string(numberOfWorkUnits) + " work units";
+      std::cout << name << std::endl;
+
+      auto filter = TFilter::New();
+      filter->SetMarkerImage(marker);
+      filter->SetMaskImage(mask);
+      filter->SetFullyConnected(fullyConnected);
+      filter->SetNumberOfWorkUnits(numberOfWorkUnits);
+      filter->Update();
+      passed &= CompareImages<ImageType>(filter->GetOutput(), reference->GetOutput(), name);
+    }
+  }
+  return passed;
+}
+
+template <unsigned int VDimension, typename TPixel>
+bool
+CheckReconstructions(const itk::Size<VDimension> & size, const std::string & description)
+{
+  using ImageType = itk::Image<TPixel, VDimension>;
+  using DilationType = itk::ReconstructionByDilationImageFilter<ImageType, ImageType>;
+  using ErosionType = itk::ReconstructionByErosionImageFilter<ImageType, ImageType>;
+
+  const typename ImageType::Pointer mask = CreateMask<ImageType>(size);
+  bool passed = CheckReconstruction<DilationType>(CreateMarker<ImageType>(mask, true), mask, description + " dilation");
+  passed &= CheckReconstruction<ErosionType>(CreateMarker<ImageType>(mask, false), mask, description + " erosion");
+  return passed;
+}
+} // namespace
+
+// Checks the multithreaded reconstruction, and its 8 bit fast path,
+// against the single threaded one for several image dimensions, pixel
+// types, connectivities and numbers of work units.
+int
+itkReconstructionImageFilterTest(int, char *[])
+{
+  bool passed = true;
+
+  passed &= CheckReconstructions<1, unsigned char>(itk::Size<1>{ { 300 } }, "1D 8 bit");
+  passed &= CheckReconstructions<2, unsigned char>(itk::Size<2>{ { 83, 61 } }, "2D 8 bit");
+  passed &= CheckReconstructions<2, float>(itk::Size<2>{ { 83, 61 } }, "2D float");
+  passed &= CheckReconstructions<3, unsigned char>(itk::Size<3>{ { 31, 27, 22 } }, "3D 8 bit");
+  passed &= CheckReconstructions<3, short>(itk::Size<3>{ { 31, 27, 22 } }, "3D 16 bit");
+  // fewer planes than work units
+  passed &= CheckReconstructions<3, unsigned char>(itk::Size<3>{ { 20, 15, 2 } }, "3D 8 bit, 2 planes");
+
+  // Fillhole of a 3D image with holes of several depths
+  {
+    constexpr unsigned int Dimension = 3;
+    using ImageType = itk::Image<unsigned char, Dimension>;
+    using FillholeType = itk::GrayscaleFillholeImageFilter<ImageType, ImageType>;
+
+    ImageType::SizeType      size = { { 40, 30, 25 } };
+    const ImageType::Pointer image = CreateMask<ImageType>(size);
+
+    auto reference = FillholeType::New();
+    reference->SetInput(image);
+    reference->SetNumberOfWorkUnits(1);
+    ITK_TRY_EXPECT_NO_EXCEPTION(reference->Update());
+
+    auto fillhole = FillholeType::New();
+    fillhole->SetInput(image);
+    fillhole->SetNumberOfWorkUnits(6);
+    ITK_TRY_EXPECT_NO_EXCEPTION(fillhole->Update());
+    passed &= CompareImages<ImageType>(fillhole->GetOutput(), reference->GetOutput(), "fillhole");
+  }
+
+  // The marker must be below the mask for a dilation
+  {
+    constexpr unsigned int Dimension = 2;
+    using ImageType = itk::Image<unsigned char, Dimension>;
+    using DilationType = itk::ReconstructionByDilationImageFilter<ImageType, ImageType>;
+
+    ImageType::SizeType      size = { { 20, 20 } };
+    const ImageType::Pointer mask = CreateMask<ImageType>(size);
+    const ImageType::Pointer marker = CreateMarker<ImageType>(mask, true);
+    ImageType::IndexType     index = { { 7, 13 } };
+    marker->SetPixel(index, 255);
+    mask->SetPixel(index, 100);
+
+    auto filter = DilationType::New();
+    filter->SetMarkerImage(marker);
+    filter->SetMaskImage(mask);
+    filter->SetNumberOfWorkUnits(3);
+    ITK_TRY_EXPECT_EXCEPTION(filter->Update());
+  }
+
+  std::cout << "Test finished." << std::endl;
+  return passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -71,6 +71,10 @@ public:
   bool
   CanReadFile(const char *) override;
 
+  /** Files not starting with "BM" are not BMP files. */
+  bool
+  CanReadFileHeader(const char * fileName, const char * header, SizeValueType length) override;
+
   /** Set the spacing and dimension information for the set filename. */
   void
   ReadImageInformation() override;
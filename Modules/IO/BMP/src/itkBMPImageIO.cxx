@@ -147,6 +147,16 @@ BMPImageIO::CanReadFile(const char * filename)
   return true;
 }
 
+bool
+BMPImageIO::CanReadFileHeader(const char * filename, const char * header, SizeValueType length)
+{
+  if (length < 2 || header[0] != 'B' || header[1] != 'M')
+  {
+    return false;
+  }
+  return this->CanReadFile(filename);
+}
+
 bool
 BMPImageIO::CanWriteFile(const char * name)
 {
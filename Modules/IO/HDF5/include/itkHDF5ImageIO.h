@@ -137,6 +137,43 @@ public:
   void
   Write(const void * buffer) override;
 
+  /*-------- This part of the interfaces deals with chunked storage. ----- */
+
+  /** Set/Get the dimensions of the chunks in which the voxel data is
+   * written, in image index order (fastest moving first). A chunk is the
+   * unit which HDF5 compresses and reads. When empty, which is the default,
+   * a chunk holds a slice of the slowest moving dimension. Otherwise one
+   * dimension is required per image dimension; dimensions larger than the
+   * image are clipped to the image size.
+   *
+   * Pieces written by streaming are aligned to whole chunks along the
+   * slowest moving dimension, so that each chunk is compressed once. */
+  void
+  SetChunkDimensions(const std::vector<SizeValueType> & chunkDimensions);
+  const std::vector<SizeValueType> &
+  GetChunkDimensions() const
+  {
+    return m_ChunkDimensions;
+  }
+
+  /** Set/Get the size in bytes of the raw data chunk cache used for the
+   * file. Compressed chunks which do not fit in the cache are decompressed
+   * again by each hyperslab overlapping them, so the cache should hold the
+   * chunks overlapped by a streamed piece. When zero, which is the default,
+   * the default of the HDF5 library (1 MiB) is used. */
+  itkSetMacro(ChunkCacheSize, SizeValueType);
+  itkGetConstMacro(ChunkCacheSize, SizeValueType);
+
+  /** Set/Get whether the deflate-compressed chunks overlapping the region
+   * to read are read from the file without decompression, and then
+   * decompressed in parallel using the global default MultiThreaderBase.
+   * Otherwise the HDF5 library decompresses the chunks one after the
+   * other. Data sets with other filters or with a non-native data type are
+   * always read by the HDF5 library. Off by default. */
+  itkSetMacro(UseParallelDecompression, bool);
+  itkGetConstMacro(UseParallelDecompression, bool);
+  itkBooleanMacro(UseParallelDecompression);
+
 protected:
   HDF5ImageIO();
   ~HDF5ImageIO() override;
@@ -144,6 +181,17 @@ protected:
   SizeType
   GetHeaderSize() const override;
 
+  /** Split the paste region along the slowest moving dimension in
+   * groups of whole chunks. */
+  unsigned int
+  GetActualNumberOfSplitsForWritingCanStreamWrite(unsigned int          numberOfRequestedSplits,
+                                                  const ImageIORegion & pasteRegion) const override;
+
+  ImageIORegion
+  GetSplitRegionForWritingCanStreamWrite(unsigned int          ithPiece,
+                                         unsigned int          numberOfActualSplits,
+                                         const ImageIORegion & pasteRegion) const override;
+
   void
   PrintSelf(std::ostream & os, Indent indent) const override;
 
@@ -203,6 +251,16 @@ private:
   void
   SetupStreaming(H5::DataSpace * imageSpace, H5::DataSpace * slabSpace);
 
+  /** Read the IO region by decompressing the chunks in parallel. Returns
+   * false, without a complete region read, when the data set does not
+   * qualify; the region is then read by the HDF5 library. */
+  bool
+  ReadDeflatedChunksInParallel(void * buffer);
+
+  /** Extent of a chunk along the slowest moving image dimension. */
+  SizeValueType
+  GetChunkExtentOfSlowestDimension() const;
+
   void
   CloseH5File();
   void
@@ -211,6 +269,10 @@ private:
   H5::H5File *  m_H5File{ nullptr };
   H5::DataSet * m_VoxelDataSet{ nullptr };
   bool          m_ImageInformationWritten{ false };
+
+  std::vector<SizeValueType> m_ChunkDimensions;
+  SizeValueType              m_ChunkCacheSize{ 0 };
+  bool                       m_UseParallelDecompression{ false };
 };
 } // end namespace itk
 
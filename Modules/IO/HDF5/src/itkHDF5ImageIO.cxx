@@ -19,10 +19,14 @@
 #include "itkHDF5ImageIO.h"
 #include "itkMetaDataObject.h"
 #include "itkArray.h"
+#include "itkMultiThreaderBase.h"
 #include "itksys/SystemTools.hxx"
 #include "itk_H5Cpp.h"
+#include "itk_zlib.h"
 
 #include <algorithm>
+#include <atomic>
+#include <cstring>
 
 namespace itk
 {
@@ -55,6 +59,24 @@ HDF5ImageIO ::PrintSelf(std::ostream & os, Indent indent) const
   Superclass::PrintSelf(os, indent);
   // just prints out the pointer value.
   os << indent << "H5File: " << this->m_H5File << std::endl;
+  os << indent << "ChunkDimensions: [";
+  for (size_t i = 0; i < this->m_ChunkDimensions.size(); ++i)
+  {
+    os << (i == 0 ? "" : ", ") << this->m_ChunkDimensions[i];
+  }
+  os << "]" << std::endl;
+  os << indent << "ChunkCacheSize: " << this->m_ChunkCacheSize << std::endl;
+  os << indent << "UseParallelDecompression: " << (this->m_UseParallelDecompression ? "On" : "Off") << std::endl;
+}
+
+void
+HDF5ImageIO ::SetChunkDimensions(const std::vector<SizeValueType> & chunkDimensions)
+{
+  if (this->m_ChunkDimensions != chunkDimensions)
+  {
+    this->m_ChunkDimensions = chunkDimensions;
+    this->Modified();
+  }
 }
 
 //
@@ -259,6 +281,36 @@ doesAttrExist(const H5::H5Object & object, const char * const name)
   return (H5Aexists(object.getId(), name) > 0 ? true : false);
 }
 
+// Sets the size of the raw data chunk cache, keeping the defaults of
+// the HDF5 library when the size is zero.
+void
+ConfigureChunkCache(H5::FileAccPropList & fapl, SizeValueType cacheSize)
+{
+  if (cacheSize == 0)
+  {
+    return;
+  }
+  int    metaDataCacheElements = 0;
+  size_t numberOfSlots = 0;
+  size_t numberOfBytes = 0;
+  double preemption = 0.0;
+  fapl.getCache(metaDataCacheElements, numberOfSlots, numberOfBytes, preemption);
+  // HDF5 recommends a prime number of hash table slots, large enough
+  // to avoid collisions between the chunks held by the cache
+  constexpr size_t minimumNumberOfSlots = 10007;
+  fapl.setCache(metaDataCacheElements,
+                std::max(numberOfSlots, minimumNumberOfSlots),
+                static_cast<size_t>(cacheSize),
+                preemption);
+}
+
+// Number of rows of chunks of the given extent overlapped by a range.
+SizeValueType
+GetNumberOfChunkRows(SizeValueType start, SizeValueType size, SizeValueType chunkExtent)
+{
+  return (start + size - 1) / chunkExtent - start / chunkExtent + 1;
+}
+
 } // namespace
 
 void
@@ -661,7 +713,9 @@ HDF5ImageIO ::ReadImageInformation()
   {
     this->CloseH5File();
     this->CloseDataSet();
-    this->m_H5File = new H5::H5File(this->GetFileName(), H5F_ACC_RDONLY);
+    H5::FileAccPropList fapl;
+    ConfigureChunkCache(fapl, this->m_ChunkCacheSize);
+    this->m_H5File = new H5::H5File(this->GetFileName(), H5F_ACC_RDONLY, H5::FileCreatPropList::DEFAULT, fapl);
     this->m_VoxelDataSet = new H5::DataSet();
 
     // not sure what to do with this initially
@@ -950,9 +1004,10 @@ HDF5ImageIO ::SetupStreaming(H5::DataSpace * imageSpace, H5::DataSpace * slabSpa
 void
 HDF5ImageIO ::Read(void * buffer)
 {
-  ImageIORegion            regionToRead = this->GetIORegion();
-  ImageIORegion::SizeType  size = regionToRead.GetSize();
-  ImageIORegion::IndexType start = regionToRead.GetIndex();
+  if (this->m_UseParallelDecompression && this->ReadDeflatedChunksInParallel(buffer))
+  {
+    return;
+  }
 
   H5::DataType  voxelType = this->m_VoxelDataSet->getDataType();
   H5::DataSpace imageSpace = this->m_VoxelDataSet->getSpace();
@@ -962,6 +1017,214 @@ HDF5ImageIO ::Read(void * buffer)
   this->m_VoxelDataSet->read(buffer, voxelType, dspace, imageSpace);
 }
 
+bool
+HDF5ImageIO ::ReadDeflatedChunksInParallel(void * buffer)
+{
+#if (H5_VERS_MAJOR > 1) || (H5_VERS_MAJOR == 1) && (H5_VERS_MINOR > 10) ||                                             \
+  (H5_VERS_MAJOR == 1) && (H5_VERS_MINOR == 10) && (H5_VERS_RELEASE >= 2)
+  // Only the single deflate filter written by this class is decompressed
+  // here, into the native type of the component
+  H5::DSetCreatPropList plist = this->m_VoxelDataSet->getCreatePlist();
+  if (plist.getLayout() != H5D_CHUNKED || plist.getNfilters() != 1)
+  {
+    return false;
+  }
+  unsigned int filterFlags = 0;
+  unsigned int filterValues[8];
+  size_t       numberOfFilterValues = 8;
+  char         filterName[64];
+  unsigned int filterConfig = 0;
+  if (plist.getFilter(
+        0, filterFlags, numberOfFilterValues, filterValues, sizeof(filterName), filterName, filterConfig) !=
+      H5Z_FILTER_DEFLATE)
+  {
+    return false;
+  }
+
+  const H5::PredType memoryType = ComponentToPredType(this->GetComponentType());
+  if (!(this->m_VoxelDataSet->getDataType() == memoryType))
+  {
+    return false;
+  }
+
+  const unsigned int numComponents = this->GetNumberOfComponents();
+  const int          rank = this->m_VoxelDataSet->getSpace().getSimpleExtentNdims();
+  if (rank != static_cast<int>(this->GetNumberOfDimensions() + (numComponents > 1 ? 1 : 0)))
+  {
+    return false;
+  }
+  std::vector<hsize_t> chunkDims(rank);
+  if (plist.getChunk(rank, chunkDims.data()) != rank)
+  {
+    return false;
+  }
+
+  // Region to read in HDF5 order, slowest moving first and the
+  // components of a voxel last, as set up by SetupStreaming
+  const ImageIORegion  regionToRead = this->GetIORegion();
+  std::vector<hsize_t> regionStart(rank, 0);
+  std::vector<hsize_t> regionSize(rank, 1);
+  int                  i = rank - 1;
+  if (numComponents > 1)
+  {
+    regionSize[i--] = numComponents;
+  }
+  for (unsigned int j = 0; j < regionToRead.GetImageDimension() && i >= 0; ++j, --i)
+  {
+    regionStart[i] = regionToRead.GetIndex(j);
+    regionSize[i] = regionToRead.GetSize(j);
+  }
+
+  std::vector<hsize_t> firstChunk(rank);
+  std::vector<hsize_t> lastChunk(rank);
+  std::vector<hsize_t> chunkStrides(rank, 1);
+  std::vector<hsize_t> regionStrides(rank, 1);
+  for (int d = rank - 1; d >= 0; --d)
+  {
+    if (regionSize[d] == 0)
+    {
+      return false;
+    }
+    firstChunk[d] = regionStart[d] / chunkDims[d] * chunkDims[d];
+    lastChunk[d] = (regionStart[d] + regionSize[d] - 1) / chunkDims[d] * chunkDims[d];
+    if (d < rank - 1)
+    {
+      chunkStrides[d] = chunkStrides[d + 1] * chunkDims[d + 1];
+      regionStrides[d] = regionStrides[d + 1] * regionSize[d + 1];
+    }
+  }
+
+  std::vector<std::vector<hsize_t>> chunkOffsets;
+  for (std::vector<hsize_t> chunkOffset = firstChunk;;)
+  {
+    chunkOffsets.push_back(chunkOffset);
+    int d = rank - 1;
+    for (; d >= 0; --d)
+    {
+      if (chunkOffset[d] < lastChunk[d])
+      {
+        chunkOffset[d] += chunkDims[d];
+        break;
+      }
+      chunkOffset[d] = firstChunk[d];
+    }
+    if (d < 0)
+    {
+      break;
+    }
+  }
+
+  const size_t elementSize = memoryType.getSize();
+  const size_t chunkBytes = chunkStrides[0] * chunkDims[0] * elementSize;
+  auto *       outputBuffer = static_cast<unsigned char *>(buffer);
+
+  // Copies the part of a decompressed chunk inside the region to read,
+  // one run of the fastest moving dimension at a time
+  auto copyChunk = [&](const std::vector<hsize_t> & chunkOffset, const unsigned char * chunk) {
+    std::vector<hsize_t> lower(rank);
+    std::vector<hsize_t> upper(rank);
+    for (int d = 0; d < rank; ++d)
+    {
+      lower[d] = std::max(chunkOffset[d], regionStart[d]);
+      upper[d] = std::min(chunkOffset[d] + chunkDims[d], regionStart[d] + regionSize[d]);
+    }
+    const size_t runBytes = (upper[rank - 1] - lower[rank - 1]) * elementSize;
+    for (std::vector<hsize_t> position = lower;;)
+    {
+      hsize_t chunkIndex = 0;
+      hsize_t regionIndex = 0;
+      for (int d = 0; d < rank; ++d)
+      {
+        chunkIndex += (position[d] - chunkOffset[d]) * chunkStrides[d];
+        regionIndex += (position[d] - regionStart[d]) * regionStrides[d];
+      }
+      std::memcpy(outputBuffer + regionIndex * elementSize, chunk + chunkIndex * elementSize, runBytes);
+      int d = rank - 2;
+      for (; d >= 0; --d)
+      {
+        if (++position[d] < upper[d])
+        {
+          break;
+        }
+        position[d] = lower[d];
+      }
+      if (d < 0)
+      {
+        break;
+      }
+    }
+  };
+
+  const hid_t                dataSetId = this->m_VoxelDataSet->getId();
+  MultiThreaderBase::Pointer multiThreader = MultiThreaderBase::New();
+  const size_t               batchSize = 4 * static_cast<size_t>(multiThreader->GetNumberOfWorkUnits());
+
+  std::vector<std::vector<unsigned char>> compressedChunks(batchSize);
+  std::vector<uint32_t>                   filterMasks(batchSize);
+  for (size_t batchStart = 0; batchStart < chunkOffsets.size(); batchStart += batchSize)
+  {
+    const size_t batchEnd = std::min(chunkOffsets.size(), batchStart + batchSize);
+
+    // The HDF5 library is not thread safe, the raw chunks are read one
+    // after the other
+    for (size_t k = batchStart; k < batchEnd; ++k)
+    {
+      std::vector<unsigned char> & compressed = compressedChunks[k - batchStart];
+      hsize_t                      storageSize = 0;
+      if (H5Dget_chunk_storage_size(dataSetId, chunkOffsets[k].data(), &storageSize) < 0 || storageSize == 0)
+      {
+        return false;
+      }
+      compressed.resize(storageSize);
+      const herr_t status =
+        H5Dread_chunk(dataSetId, H5P_DEFAULT, chunkOffsets[k].data(), &filterMasks[k - batchStart], compressed.data());
+      if (status < 0)
+      {
+        return false;
+      }
+    }
+
+    std::atomic<bool> failed{ false };
+    multiThreader->ParallelizeArray(
+      batchStart,
+      batchEnd,
+      [&](SizeValueType k) {
+        const std::vector<unsigned char> & compressed = compressedChunks[k - batchStart];
+        // The first bit of the filter mask is set when the deflate filter
+        // was skipped for the chunk
+        if ((filterMasks[k - batchStart] & 1u) != 0)
+        {
+          if (compressed.size() != chunkBytes)
+          {
+            failed = true;
+            return;
+          }
+          copyChunk(chunkOffsets[k], compressed.data());
+          return;
+        }
+        std::vector<unsigned char> chunk(chunkBytes);
+        auto                       chunkSize = static_cast<uLongf>(chunkBytes);
+        if (uncompress(chunk.data(), &chunkSize, compressed.data(), static_cast<uLong>(compressed.size())) != Z_OK ||
+            chunkSize != chunkBytes)
+        {
+          failed = true;
+          return;
+        }
+        copyChunk(chunkOffsets[k], chunk.data());
+      },
+      nullptr);
+    if (failed)
+    {
+      return false;
+    }
+  }
+  return true;
+#else
+  (void)buffer;
+  return false;
+#endif
+}
+
 template <typename TType>
 bool
 HDF5ImageIO ::WriteMeta(const std::string & name, MetaDataObjectBase * metaObjBase)
@@ -1024,6 +1287,7 @@ HDF5ImageIO ::WriteImageInformation()
 #  error The selected version of HDF5 library does not support setting backwards compatibility at run-time.\
   Please use a different version of HDF5, e.g. the one bundled with ITK (by setting ITK_USE_SYSTEM_HDF5 to OFF).
 #endif
+    ConfigureChunkCache(fapl, this->m_ChunkCacheSize);
     this->m_H5File = new H5::H5File(this->GetFileName(), H5F_ACC_TRUNC, H5::FileCreatPropList::DEFAULT, fapl);
     this->m_VoxelDataSet = new H5::DataSet();
 
@@ -1072,14 +1336,30 @@ HDF5ImageIO ::WriteImageInformation()
     H5::PredType  dataType = ComponentToPredType(this->GetComponentType());
 
     // set up properties for chunked, compressed writes.
-    // in this case, set the chunk size to be the N-1 dimension
+    // by default, set the chunk size to be the N-1 dimension
     // region
     H5::DSetCreatPropList plist;
 
     // we have implicit compression enabled here?
     plist.setDeflate(this->GetCompressionLevel());
 
-    dims[0] = 1;
+    const unsigned int imageDims = this->GetNumberOfDimensions();
+    if (this->m_ChunkDimensions.empty())
+    {
+      dims[0] = 1;
+    }
+    else if (this->m_ChunkDimensions.size() == imageDims)
+    {
+      for (unsigned int i(0), j(imageDims - 1); i < imageDims; i++, j--)
+      {
+        dims[j] = std::min(std::max(this->m_ChunkDimensions[i], SizeValueType{ 1 }), this->m_Dimensions[i]);
+      }
+    }
+    else
+    {
+      itkExceptionMacro(<< "The chunk dimensions have " << this->m_ChunkDimensions.size()
+                        << " elements, but the image has " << imageDims << " dimensions");
+    }
     plist.setChunk(numDims, dims.get());
     dims.reset();
 
@@ -1303,6 +1583,69 @@ HDF5ImageIO ::Write(const void * buffer)
   }
 }
 
+SizeValueType
+HDF5ImageIO ::GetChunkExtentOfSlowestDimension() const
+{
+  const unsigned int numDims = this->GetNumberOfDimensions();
+  if (numDims == 0 || this->m_ChunkDimensions.size() != numDims)
+  {
+    return 1;
+  }
+  return std::min(std::max(this->m_ChunkDimensions[numDims - 1], SizeValueType{ 1 }),
+                  this->m_Dimensions[numDims - 1]);
+}
+
+unsigned int
+HDF5ImageIO ::GetActualNumberOfSplitsForWritingCanStreamWrite(unsigned int          numberOfRequestedSplits,
+                                                              const ImageIORegion & pasteRegion) const
+{
+  const unsigned int numDims = pasteRegion.GetImageDimension();
+  if (numDims == 0 || numDims != this->GetNumberOfDimensions() || pasteRegion.GetSize(numDims - 1) == 0)
+  {
+    return Superclass::GetActualNumberOfSplitsForWritingCanStreamWrite(numberOfRequestedSplits, pasteRegion);
+  }
+
+  const SizeValueType numberOfChunkRows = GetNumberOfChunkRows(
+    pasteRegion.GetIndex(numDims - 1), pasteRegion.GetSize(numDims - 1), this->GetChunkExtentOfSlowestDimension());
+  if (numberOfChunkRows < 2)
+  {
+    // A piece of a single row of chunks has to be split inside the chunks
+    return Superclass::GetActualNumberOfSplitsForWritingCanStreamWrite(numberOfRequestedSplits, pasteRegion);
+  }
+  return static_cast<unsigned int>(std::min<SizeValueType>(numberOfRequestedSplits, numberOfChunkRows));
+}
+
+ImageIORegion
+HDF5ImageIO ::GetSplitRegionForWritingCanStreamWrite(unsigned int          ithPiece,
+                                                     unsigned int          numberOfActualSplits,
+                                                     const ImageIORegion & pasteRegion) const
+{
+  const unsigned int numDims = pasteRegion.GetImageDimension();
+  if (numDims == 0 || numDims != this->GetNumberOfDimensions() || pasteRegion.GetSize(numDims - 1) == 0)
+  {
+    return Superclass::GetSplitRegionForWritingCanStreamWrite(ithPiece, numberOfActualSplits, pasteRegion);
+  }
+
+  const SizeValueType start = pasteRegion.GetIndex(numDims - 1);
+  const SizeValueType size = pasteRegion.GetSize(numDims - 1);
+  const SizeValueType chunkExtent = this->GetChunkExtentOfSlowestDimension();
+  const SizeValueType numberOfChunkRows = GetNumberOfChunkRows(start, size, chunkExtent);
+  if (numberOfChunkRows < 2 || numberOfActualSplits > numberOfChunkRows)
+  {
+    return Superclass::GetSplitRegionForWritingCanStreamWrite(ithPiece, numberOfActualSplits, pasteRegion);
+  }
+
+  // Distribute the rows of chunks evenly over the pieces
+  const SizeValueType firstRow = start / chunkExtent;
+  const SizeValueType pieceBegin = (firstRow + ithPiece * numberOfChunkRows / numberOfActualSplits) * chunkExtent;
+  const SizeValueType pieceEnd = (firstRow + (ithPiece + 1) * numberOfChunkRows / numberOfActualSplits) * chunkExtent;
+
+  ImageIORegion splitRegion = pasteRegion;
+  splitRegion.SetIndex(numDims - 1, std::max(start, pieceBegin));
+  splitRegion.SetSize(numDims - 1, std::min(start + size, pieceEnd) - std::max(start, pieceBegin));
+  return splitRegion;
+}
+
 //
 // GetHeaderSize -- return 0
 ImageIOBase::SizeType
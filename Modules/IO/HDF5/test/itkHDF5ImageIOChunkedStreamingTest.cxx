@@ -0,0 +1,189 @@
+/*=========================================================================
+ *
+ *  Copyright NumFOCUS
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include "itkHDF5ImageIO.h"
+#include "itkImageFileReader.h"
+#include "itkImageFileWriter.h"
+#include "itkImageRegionConstIteratorWithIndex.h"
+#include "itkImageRegionIteratorWithIndex.h"
+#include "itkPipelineMonitorImageFilter.h"
+#include "itkTestingMacros.h"
+
+namespace
+{
+using PixelType = short;
+using ImageType = itk::Image<PixelType, 3>;
+
+PixelType
+ExpectedValue(const ImageType::IndexType & index)
+{
+  return static_cast<PixelType>(index[0] + 20 * index[1] + 300 * index[2]);
+}
+
+bool
+VerifyRegion(const ImageType * image, const ImageType::RegionType & region)
+{
+  itk::ImageRegionConstIteratorWithIndex<ImageType> it(image, region);
+  for (; !it.IsAtEnd(); ++it)
+  {
+    if (it.Get() != ExpectedValue(it.GetIndex()))
+    {
+      std::cerr << "Error in pixel value at index " << it.GetIndex() << std::endl;
+      std::cerr << "Expected: " << ExpectedValue(it.GetIndex()) << ", but got: " << it.Get() << std::endl;
+      return false;
+    }
+  }
+  return true;
+}
+} // namespace
+
+// Streams an image into a file with user defined chunks, checking that
+// the pieces are aligned with the chunks, and reads regions of the file
+// with chunks decompressed in parallel.
+int
+itkHDF5ImageIOChunkedStreamingTest(int argc, char * argv[])
+{
+  if (argc < 2)
+  {
+    std::cerr << "Missing parameters." << std::endl;
+    std::cerr << "Usage: " << itkNameOfTestExecutableMacro(argv);
+    std::cerr << " outputDirectory" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  const std::string inputFileName = std::string(argv[1]) + "/itkHDF5ImageIOChunkedStreamingTestInput.h5";
+  const std::string outputFileName = std::string(argv[1]) + "/itkHDF5ImageIOChunkedStreamingTest.h5";
+
+  using ReaderType = itk::ImageFileReader<ImageType>;
+  using WriterType = itk::ImageFileWriter<ImageType>;
+
+  ImageType::Pointer  image = ImageType::New();
+  ImageType::SizeType size = { { 19, 13, 17 } };
+  image->SetRegions(size);
+  image->Allocate();
+
+  itk::ImageRegionIteratorWithIndex<ImageType> it(image, image->GetLargestPossibleRegion());
+  for (it.GoToBegin(); !it.IsAtEnd(); ++it)
+  {
+    it.Set(ExpectedValue(it.GetIndex()));
+  }
+
+  WriterType::Pointer inputWriter = WriterType::New();
+  inputWriter->SetFileName(inputFileName);
+  inputWriter->SetInput(image);
+  ITK_TRY_EXPECT_NO_EXCEPTION(inputWriter->Update());
+
+  itk::HDF5ImageIO::Pointer io = itk::HDF5ImageIO::New();
+
+  ITK_EXERCISE_BASIC_OBJECT_METHODS(io, HDF5ImageIO, StreamingImageIOBase);
+
+  // Chunks which do not match the image dimension are rejected
+  io->SetChunkDimensions(std::vector<itk::SizeValueType>{ 8, 8 });
+
+  WriterType::Pointer badWriter = WriterType::New();
+  badWriter->SetFileName(outputFileName);
+  badWriter->SetInput(image);
+  badWriter->SetImageIO(io);
+  ITK_TRY_EXPECT_EXCEPTION(badWriter->Update());
+
+  const std::vector<itk::SizeValueType> chunkDimensions{ 8, 8, 4 };
+  io = itk::HDF5ImageIO::New();
+  io->SetChunkDimensions(chunkDimensions);
+  ITK_TEST_EXPECT_TRUE(io->GetChunkDimensions() == chunkDimensions);
+
+  const itk::SizeValueType chunkCacheSize = 4 * 1024 * 1024;
+  io->SetChunkCacheSize(chunkCacheSize);
+  ITK_TEST_SET_GET_VALUE(chunkCacheSize, io->GetChunkCacheSize());
+
+  ReaderType::Pointer reader = ReaderType::New();
+  reader->SetFileName(inputFileName);
+  reader->SetUseStreaming(true);
+
+  using MonitorFilter = itk::PipelineMonitorImageFilter<ImageType>;
+  MonitorFilter::Pointer monitor = MonitorFilter::New();
+  monitor->SetInput(reader->GetOutput());
+
+  // Three pieces over the five rows of chunks of the slowest dimension
+  WriterType::Pointer writer = WriterType::New();
+  writer->SetFileName(outputFileName);
+  writer->SetInput(monitor->GetOutput());
+  writer->SetImageIO(io);
+  writer->SetNumberOfStreamDivisions(3);
+  ITK_TRY_EXPECT_NO_EXCEPTION(writer->Update());
+
+  if (!monitor->VerifyAllInputCanStream(3))
+  {
+    std::cout << monitor << std::endl;
+    std::cerr << "Test failed!" << std::endl;
+    std::cerr << "Pipeline did not execute as expected!" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  const itk::SizeValueType expectedPieceStarts[] = { 0, 4, 12 };
+  const itk::SizeValueType expectedPieceSizes[] = { 4, 8, 5 };
+  for (unsigned int piece = 0; piece < 3; ++piece)
+  {
+    const ImageType::RegionType & region = monitor->GetUpdatedBufferedRegions()[piece];
+    ITK_TEST_EXPECT_EQUAL(static_cast<itk::SizeValueType>(region.GetIndex(2)), expectedPieceStarts[piece]);
+    ITK_TEST_EXPECT_EQUAL(region.GetSize(2), expectedPieceSizes[piece]);
+  }
+
+  // Read the whole image and regions crossing chunk boundaries with
+  // chunks decompressed in parallel
+  for (const bool parallel : { false, true })
+  {
+    itk::HDF5ImageIO::Pointer readIO = itk::HDF5ImageIO::New();
+    ITK_TEST_SET_GET_BOOLEAN(readIO, UseParallelDecompression, parallel);
+    readIO->SetChunkCacheSize(chunkCacheSize);
+
+    ReaderType::Pointer outputReader = ReaderType::New();
+    outputReader->SetFileName(outputFileName);
+    outputReader->SetImageIO(readIO);
+    ITK_TRY_EXPECT_NO_EXCEPTION(outputReader->Update());
+
+    if (outputReader->GetOutput()->GetLargestPossibleRegion() != image->GetLargestPossibleRegion() ||
+        !VerifyRegion(outputReader->GetOutput(), image->GetLargestPossibleRegion()))
+    {
+      std::cerr << "Test failed!" << std::endl;
+      std::cerr << "Error reading " << outputFileName << std::endl;
+      return EXIT_FAILURE;
+    }
+
+    ReaderType::Pointer regionReader = ReaderType::New();
+    regionReader->SetFileName(outputFileName);
+    regionReader->SetImageIO(readIO);
+    regionReader->SetUseStreaming(true);
+    ITK_TRY_EXPECT_NO_EXCEPTION(regionReader->UpdateOutputInformation());
+
+    const ImageType::IndexType  index = { { 5, 3, 2 } };
+    const ImageType::SizeType   regionSize = { { 11, 9, 7 } };
+    const ImageType::RegionType region(index, regionSize);
+    regionReader->GetOutput()->SetRequestedRegion(region);
+    ITK_TRY_EXPECT_NO_EXCEPTION(regionReader->Update());
+
+    if (regionReader->GetOutput()->GetBufferedRegion() != region || !VerifyRegion(regionReader->GetOutput(), region))
+    {
+      std::cerr << "Test failed!" << std::endl;
+      std::cerr << "Error reading region " << region << " of " << outputFileName << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+
+  std::cout << "Test finished." << std::endl;
+  return EXIT_SUCCESS;
+}
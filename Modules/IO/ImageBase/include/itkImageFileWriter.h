@@ -22,9 +22,47 @@
 #include "itkProcessObject.h"
 #include "itkImageIOBase.h"
 #include "itkMacro.h"
+#include "itkNumericTraits.h"
 
 namespace itk
 {
+namespace ImageFileWriterDetail
+{
+template <typename T>
+struct MakeVoid
+{
+  using Type = void;
+};
+
+/** The image whose buffer is passed to the ImageIO. The image types which
+ * have no pixel buffer, such as RLEImage, define the type of the image they
+ * are expanded to as DenseImageType, and are expanded one region at a time.
+ */
+template <typename TImage, typename = void>
+struct IOImage
+{
+  using Type = TImage;
+
+  static const void *
+  GetBufferPointer(const TImage * image)
+  {
+    return image->GetBufferPointer();
+  }
+};
+
+template <typename TImage>
+struct IOImage<TImage, typename MakeVoid<typename TImage::DenseImageType>::Type>
+{
+  using Type = typename TImage::DenseImageType;
+
+  static const void *
+  GetBufferPointer(const TImage *)
+  {
+    return nullptr;
+  }
+};
+} // end namespace ImageFileWriterDetail
+
 /** \brief Base exception class for IO problems during writing.
  *
  * \class ImageFileWriterException
@@ -106,6 +144,11 @@ public:
   using InputImageRegionType = typename InputImageType::RegionType;
   using InputImagePixelType = typename InputImageType::PixelType;
 
+  /** Type of the image whose buffer is passed to the ImageIO. An input
+   * image without a pixel buffer, such as an RLEImage, is expanded into its
+   * DenseImageType one stream region at a time. */
+  using IOImageType = typename ImageFileWriterDetail::IOImage<InputImageType>::Type;
+
   /** Set/Get the image input of this writer.  */
   using Superclass::SetInput;
   void
@@ -210,6 +253,29 @@ public:
   itkGetConstReferenceMacro(UseInputMetaDataDictionary, bool);
   itkBooleanMacro(UseInputMetaDataDictionary);
 
+  /** Set/Get whether streamed pieces are written asynchronously.
+   *
+   * When enabled and the image is written in more than one piece, each
+   * piece is copied once it has been generated and queued for a single
+   * background I/O thread. The upstream pipeline then computes the
+   * next piece while the previous one is being written. Pieces are
+   * always written in order. The regions of the pieces are computed
+   * before the first one is written, so that only the I/O thread
+   * accesses the ImageIO while the pieces are being written. This
+   * requires an ImageIO that supports streamed writing, such as the
+   * StreamingImageIOBase subclasses. Default is off. */
+  itkSetMacro(UseAsynchronousStreaming, bool);
+  itkGetConstReferenceMacro(UseAsynchronousStreaming, bool);
+  itkBooleanMacro(UseAsynchronousStreaming);
+
+  /** Set/Get the maximum number of generated pieces which may be waiting
+   * to be written when UseAsynchronousStreaming is on. Each pending piece
+   * holds a copy of its pixel data, so this bounds the additional memory
+   * used by the writer. The default of 1 gives double buffering: one
+   * piece is written while the next one is computed. */
+  itkSetClampMacro(MaximumNumberOfPendingPieces, unsigned int, 1, NumericTraits<unsigned int>::max());
+  itkGetConstReferenceMacro(MaximumNumberOfPendingPieces, unsigned int);
+
 protected:
   ImageFileWriter() = default;
   ~ImageFileWriter() override = default;
@@ -234,6 +300,9 @@ private:
   bool m_UseCompression{ false };
   int  m_CompressionLevel{ -1 };
   bool m_UseInputMetaDataDictionary{ true };
+
+  bool         m_UseAsynchronousStreaming{ false };
+  unsigned int m_MaximumNumberOfPendingPieces{ 1 };
 };
 } // end namespace itk
 
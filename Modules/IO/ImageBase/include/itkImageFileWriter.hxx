@@ -33,6 +33,12 @@
 #include "itkMatrix.h"
 #include "itkImageAlgorithm.h"
 #include <complex>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <utility>
 
 namespace itk
 {
@@ -262,65 +268,194 @@ ImageFileWriter<TInputImage>::Write()
   numDivisions =
     m_ImageIO->GetActualNumberOfSplitsForWriting(m_NumberOfStreamDivisions, pasteIORegion, largestIORegion);
 
+  // The regions of the pieces are computed before any piece is written, so
+  // that only the I/O thread accesses the ImageIO while writing
+  // asynchronously.
+  std::vector<ImageIORegion> streamIORegions;
+  for (unsigned int i = 0; i < numDivisions; ++i)
+  {
+    streamIORegions.push_back(m_ImageIO->GetSplitRegionForWriting(i, numDivisions, pasteIORegion, largestIORegion));
+  }
+
+  // In asynchronous mode, the pieces which have been handed to the I/O
+  // thread and are not yet written. The I/O thread writes them in order,
+  // and removes each of them from the queue once it is written.
+  struct PendingPiece
+  {
+    typename IOImageType::Pointer Image;
+    ImageIORegion                 IORegion;
+  };
+  std::deque<PendingPiece> pendingPieces;
+  std::mutex               pendingPiecesMutex;
+  std::condition_variable  pendingPiecesCondition;
+  bool                     noMorePieces = false;
+  unsigned int             numberOfWrittenPieces = 0;
+  unsigned int             numberOfReportedPieces = 0;
+  std::exception_ptr       writeException;
+  std::thread              ioThread;
+
+  ImageIOBase * imageIO = m_ImageIO;
+  auto          writePendingPieces = [&]() {
+    std::unique_lock<std::mutex> lock(pendingPiecesMutex);
+    while (true)
+    {
+      pendingPiecesCondition.wait(lock, [&]() { return !pendingPieces.empty() || noMorePieces; });
+      if (pendingPieces.empty())
+      {
+        return;
+      }
+      const PendingPiece & pendingPiece = pendingPieces.front();
+      if (!writeException)
+      {
+        lock.unlock();
+        try
+        {
+          imageIO->SetIORegion(pendingPiece.IORegion);
+          imageIO->Write(pendingPiece.Image->GetBufferPointer());
+        }
+        catch (...)
+        {
+          // do not write after a failed piece
+          lock.lock();
+          writeException = std::current_exception();
+          lock.unlock();
+        }
+        lock.lock();
+      }
+      pendingPieces.pop_front();
+      ++numberOfWrittenPieces;
+      pendingPiecesCondition.notify_all();
+    }
+  };
+
+  // Waits until at most the given number of pieces are pending, and reports
+  // the progress and the errors of the I/O thread
+  auto waitForPendingPieces = [&](size_t maximumNumberOfPendingPieces) {
+    std::unique_lock<std::mutex> lock(pendingPiecesMutex);
+    pendingPiecesCondition.wait(lock, [&]() { return pendingPieces.size() <= maximumNumberOfPendingPieces; });
+    const unsigned int       numberOfPieces = numberOfWrittenPieces;
+    const std::exception_ptr exception = writeException;
+    lock.unlock();
+    if (exception)
+    {
+      std::rethrow_exception(exception);
+    }
+    if (numberOfPieces != numberOfReportedPieces)
+    {
+      numberOfReportedPieces = numberOfPieces;
+      this->UpdateProgress(static_cast<float>(numberOfPieces) / static_cast<float>(numDivisions));
+    }
+  };
+
+  auto stopIOThread = [&]() {
+    if (ioThread.joinable())
+    {
+      {
+        std::lock_guard<std::mutex> lock(pendingPiecesMutex);
+        noMorePieces = true;
+      }
+      pendingPiecesCondition.notify_all();
+      ioThread.join();
+    }
+  };
+
   /**
    * Loop over the number of pieces, execute the upstream pipeline on each
    * piece, and copy the results into the output image.
    */
   unsigned int piece;
 
-  for (piece = 0; piece < numDivisions && !this->GetAbortGenerateData(); piece++)
+  try
   {
-    // get the actual piece to write
-    ImageIORegion streamIORegion =
-      m_ImageIO->GetSplitRegionForWriting(piece, numDivisions, pasteIORegion, largestIORegion);
-
-    // Check whether the paste region is fully contained inside the
-    // largest region or not.
-    if (!pasteIORegion.IsInside(streamIORegion))
+    for (piece = 0; piece < numDivisions && !this->GetAbortGenerateData(); piece++)
     {
-      itkExceptionMacro(<< "ImageIO returns streamable region that is not fully contain in paste IO region"
-                        << "Paste IO region: " << pasteIORegion << "Streamable region: " << streamIORegion);
-    }
+      // get the actual piece to write
+      ImageIORegion streamIORegion = streamIORegions[piece];
 
-    InputImageRegionType streamRegion;
-    ImageIORegionAdaptor<TInputImage::ImageDimension>::Convert(streamIORegion, streamRegion, largestRegion.GetIndex());
+      // Check whether the paste region is fully contained inside the
+      // largest region or not.
+      if (!pasteIORegion.IsInside(streamIORegion))
+      {
+        itkExceptionMacro(<< "ImageIO returns streamable region that is not fully contain in paste IO region"
+                          << "Paste IO region: " << pasteIORegion << "Streamable region: " << streamIORegion);
+      }
 
-    // execute the the upstream pipeline with the requested
-    // region for streaming
-    nonConstInput->SetRequestedRegion(streamRegion);
-    nonConstInput->PropagateRequestedRegion();
-    nonConstInput->UpdateOutputData();
+      InputImageRegionType streamRegion;
+      ImageIORegionAdaptor<TInputImage::ImageDimension>::Convert(
+        streamIORegion, streamRegion, largestRegion.GetIndex());
 
-    if (piece == 0)
-    {
-      // initialize the progress here to mimic the progress behavior of the non
-      // streaming filters, where the progress changes only when the other filters
-      // are done.
-      this->UpdateProgress(0.0f);
-    }
+      // execute the the upstream pipeline with the requested
+      // region for streaming
+      nonConstInput->SetRequestedRegion(streamRegion);
+      nonConstInput->PropagateRequestedRegion();
+      nonConstInput->UpdateOutputData();
 
-    // check to see if we tried to stream but got the largest possible region
-    if (piece == 0 && streamRegion != largestRegion)
-    {
-      InputImageRegionType bufferedRegion = input->GetBufferedRegion();
-      if (bufferedRegion == largestRegion)
+      if (piece == 0)
       {
-        // if so, then just write the entire image
-        itkDebugMacro("Requested stream region  matches largest region input filter may not support streaming well.");
-        itkDebugMacro("Writer is not streaming now!");
-        numDivisions = 1;
-        streamRegion = largestRegion;
-        ImageIORegionAdaptor<TInputImage::ImageDimension>::Convert(
-          streamRegion, streamIORegion, largestRegion.GetIndex());
+        // initialize the progress here to mimic the progress behavior of the non
+        // streaming filters, where the progress changes only when the other filters
+        // are done.
+        this->UpdateProgress(0.0f);
+      }
+
+      // check to see if we tried to stream but got the largest possible region
+      if (piece == 0 && streamRegion != largestRegion)
+      {
+        InputImageRegionType bufferedRegion = input->GetBufferedRegion();
+        if (bufferedRegion == largestRegion)
+        {
+          // if so, then just write the entire image
+          itkDebugMacro("Requested stream region  matches largest region input filter may not support streaming well.");
+          itkDebugMacro("Writer is not streaming now!");
+          numDivisions = 1;
+          streamRegion = largestRegion;
+          ImageIORegionAdaptor<TInputImage::ImageDimension>::Convert(
+            streamRegion, streamIORegion, largestRegion.GetIndex());
+        }
       }
-    }
 
-    m_ImageIO->SetIORegion(streamIORegion);
+      if (m_UseAsynchronousStreaming && numDivisions > 1)
+      {
+        // bound the number of pieces held in memory
+        waitForPendingPieces(m_MaximumNumberOfPendingPieces - 1);
+
+        // the upstream pipeline may reuse its output buffer for the next
+        // piece, so the I/O thread works on a copy
+        typename IOImageType::Pointer pieceImage = IOImageType::New();
+        pieceImage->CopyInformation(input);
+        pieceImage->SetBufferedRegion(streamRegion);
+        pieceImage->Allocate();
+        ImageAlgorithm::Copy(input, pieceImage.GetPointer(), streamRegion, streamRegion);
+
+        {
+          std::lock_guard<std::mutex> lock(pendingPiecesMutex);
+          pendingPieces.push_back(PendingPiece{ std::move(pieceImage), streamIORegion });
+        }
+        pendingPiecesCondition.notify_all();
+        if (!ioThread.joinable())
+        {
+          ioThread = std::thread(writePendingPieces);
+        }
+      }
+      else
+      {
+        m_ImageIO->SetIORegion(streamIORegion);
 
-    // write the data
-    this->GenerateData();
+        // write the data
+        this->GenerateData();
+
+        this->UpdateProgress(static_cast<float>(piece + 1) / static_cast<float>(numDivisions));
+      }
+    }
 
-    this->UpdateProgress(static_cast<float>(piece + 1) / static_cast<float>(numDivisions));
+    waitForPendingPieces(0);
+    stopIOThread();
+  }
+  catch (...)
+  {
+    // the I/O thread must not outlive the writer or the pieces
+    stopIOThread();
+    throw;
   }
 
   // Notify end event observers
@@ -335,14 +470,14 @@ template <typename TInputImage>
 void
 ImageFileWriter<TInputImage>::GenerateData()
 {
-  const InputImageType * input = this->GetInput();
-  InputImageRegionType   largestRegion = input->GetLargestPossibleRegion();
-  InputImagePointer      cacheImage;
+  const InputImageType *        input = this->GetInput();
+  InputImageRegionType          largestRegion = input->GetLargestPossibleRegion();
+  typename IOImageType::Pointer cacheImage;
 
   itkDebugMacro(<< "Writing file: " << m_FileName);
 
   // now extract the data as a raw buffer pointer
-  const auto * dataPtr = (const void *)input->GetBufferPointer();
+  const void * dataPtr = ImageFileWriterDetail::IOImage<InputImageType>::GetBufferPointer(input);
 
   // check that the image's buffered region is the same as
   // ImageIO is expecting and we requested
@@ -352,14 +487,15 @@ ImageFileWriter<TInputImage>::GenerateData()
   InputImageRegionType bufferedRegion = input->GetBufferedRegion();
 
   // before this test, bad stuff would happened when they don't match
-  if (bufferedRegion != ioRegion)
+  if (bufferedRegion != ioRegion || dataPtr == nullptr)
   {
-    if (m_NumberOfStreamDivisions > 1 || m_UserSpecifiedIORegion)
+    // an input which is not dense is always expanded into the cache
+    if (bufferedRegion == ioRegion || m_NumberOfStreamDivisions > 1 || m_UserSpecifiedIORegion)
     {
       itkDebugMacro("Requested stream region does not match generated output");
       itkDebugMacro("input filter may not support streaming well");
 
-      cacheImage = InputImageType::New();
+      cacheImage = IOImageType::New();
       cacheImage->CopyInformation(input);
       cacheImage->SetBufferedRegion(ioRegion);
       cacheImage->Allocate();
@@ -435,6 +571,9 @@ ImageFileWriter<TInputImage>::PrintSelf(std::ostream & os, Indent indent) const
   {
     os << indent << "FactorySpecifiedmageIO: Off\n";
   }
+
+  os << indent << "UseAsynchronousStreaming: " << (m_UseAsynchronousStreaming ? "On" : "Off") << "\n";
+  os << indent << "MaximumNumberOfPendingPieces: " << m_MaximumNumberOfPendingPieces << "\n";
 }
 } // end namespace itk
 
@@ -419,6 +419,19 @@ public:
   virtual bool
   CanReadFile(const char *) = 0;
 
+  /** Determine the file type from the leading bytes of the file, given in
+   * \a header, which holds the first \a length bytes of the file, or all
+   * its bytes when it is shorter. It is called by
+   * ImageIOFactory::CreateImageIOForProbing() instead of CanReadFile(), so
+   * that the ImageIOs whose files start with a signature reject the other
+   * files without opening them. Returns the result of CanReadFile() by
+   * default. */
+  virtual bool
+  CanReadFileHeader(const char * fileName, const char * itkNotUsed(header), SizeValueType itkNotUsed(length))
+  {
+    return this->CanReadFile(fileName);
+  }
+
   /** Determine if the ImageIO can stream reading from the
       current settings. Default is false. If this is queried after
       the header of the file has been read then it will indicate if
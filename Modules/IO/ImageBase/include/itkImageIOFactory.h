@@ -22,6 +22,8 @@
 #include "itkObject.h"
 #include "itkImageIOBase.h"
 #include "ITKIOImageBaseExport.h"
+#include <string>
+#include <vector>
 
 namespace itk
 {
@@ -62,6 +64,65 @@ public:
   static ImageIOBasePointer
   CreateImageIO(const char * path, IOFileModeEnum mode);
 
+  /** Create an ImageIO which can read the file, trying the registered
+   * ImageIOs in the order of their likelihood to succeed: first those
+   * supporting its extension, then the others, each by decreasing number
+   * of files they have been selected for. The leading bytes of the file
+   * are read once and given to ImageIOBase::CanReadFileHeader(), so that
+   * the ImageIOs recognizing the signature of their files reject the
+   * other files without opening them. This avoids opening the file for
+   * most of the registered ImageIOs when indexing many files. When several
+   * ImageIOs can read a file, the one returned may differ from
+   * CreateImageIO(), which follows the order in which the factories are
+   * registered. */
+  static ImageIOBasePointer
+  CreateImageIOForProbing(const char * path);
+
+  /** \class ImageInformation
+   * \brief Header information of an image file.
+   *
+   * Direction[i] is the direction of the i-th axis of the image, as
+   * returned by ImageIOBase::GetDirection(i).
+   * \ingroup ITKIOImageBase
+   */
+  struct ImageInformation
+  {
+    std::string FileName;
+    /** Name of the class of the ImageIO which read the header, empty when
+     * no registered ImageIO can read the file. */
+    std::string ImageIOName;
+    /** Description of the error which occurred while reading the header. */
+    std::string ErrorMessage;
+    unsigned int                     NumberOfDimensions{ 0 };
+    std::vector<SizeValueType>       Size;
+    std::vector<double>              Spacing;
+    std::vector<double>              Origin;
+    std::vector<std::vector<double>> Direction;
+    IOPixelEnum                      PixelType{ IOPixelEnum::UNKNOWNPIXELTYPE };
+    IOComponentEnum                  ComponentType{ IOComponentEnum::UNKNOWNCOMPONENTTYPE };
+    unsigned int                     NumberOfComponents{ 0 };
+
+    /** Whether the header of the file was read successfully. */
+    bool
+    IsValid() const
+    {
+      return !ImageIOName.empty() && ErrorMessage.empty();
+    }
+  };
+
+  /** Read the header of an image file, without reading the pixel data.
+   * The ImageIO is selected with CreateImageIOForProbing(). No exception
+   * is thrown; failures are reported by the returned information. */
+  static ImageInformation
+  ProbeImageInformation(const std::string & path);
+
+  /** Read the headers of several image files in parallel, with a new
+   * MultiThreaderBase of the global default type and number of threads.
+   * The result holds the information of each file, in the order of the
+   * given paths. */
+  static std::vector<ImageInformation>
+  ProbeImageInformation(const std::vector<std::string> & paths);
+
 protected:
   ImageIOFactory();
   ~ImageIOFactory() override;
@@ -17,8 +17,14 @@
  *=========================================================================*/
 
 #include "itkImageIOFactory.h"
+#include "itkMultiThreaderBase.h"
+#include "itksys/SystemTools.hxx"
 
+#include <algorithm>
+#include <fstream>
+#include <list>
 #include <mutex>
+#include <unordered_map>
 
 
 namespace itk
@@ -27,15 +33,43 @@ namespace itk
 namespace
 {
 std::mutex createImageIOLock;
-}
 
-ImageIOBase::Pointer
-ImageIOFactory::CreateImageIO(const char * path, IOFileModeEnum mode)
+// Number of files each ImageIO class has been selected for, guarded by
+// createImageIOLock
+std::unordered_map<std::string, SizeValueType> imageIOSelectionCounts;
+
+// Number of leading bytes of a file given to ImageIOBase::CanReadFileHeader(),
+// which covers the fixed-size headers of the common formats
+constexpr std::size_t probedHeaderLength = 348;
+
+std::string
+ReadFileHeader(const char * path)
 {
-  std::list<ImageIOBase::Pointer> possibleImageIO;
+  std::string   header(probedHeaderLength, '\0');
+  std::ifstream file(path, std::ios::in | std::ios::binary);
+  file.read(&header[0], static_cast<std::streamsize>(header.size()));
+  header.resize(static_cast<std::size_t>(file.gcount()));
+  return header;
+}
 
-  std::lock_guard<std::mutex> mutexHolder(createImageIOLock);
+bool
+HasSupportedExtension(const std::string & lowerCasePath, const ImageIOBase::ArrayOfExtensionsType & extensions)
+{
+  for (const auto & extension : extensions)
+  {
+    if (!extension.empty() &&
+        itksys::SystemTools::StringEndsWith(lowerCasePath, itksys::SystemTools::LowerCase(extension).c_str()))
+    {
+      return true;
+    }
+  }
+  return false;
+}
 
+std::list<ImageIOBase::Pointer>
+CreateAllImageIOs()
+{
+  std::list<ImageIOBase::Pointer> possibleImageIO;
   for (auto & allobject : ObjectFactoryBase::CreateAllInstance("itkImageIOBase"))
   {
     auto * io = dynamic_cast<ImageIOBase *>(allobject.GetPointer());
@@ -48,12 +82,22 @@ ImageIOFactory::CreateImageIO(const char * path, IOFileModeEnum mode)
       std::cerr << "Error ImageIO factory did not return an ImageIOBase: " << allobject->GetNameOfClass() << std::endl;
     }
   }
-  for (auto & k : possibleImageIO)
+  return possibleImageIO;
+}
+} // namespace
+
+ImageIOBase::Pointer
+ImageIOFactory::CreateImageIO(const char * path, IOFileModeEnum mode)
+{
+  std::lock_guard<std::mutex> mutexHolder(createImageIOLock);
+
+  for (auto & k : CreateAllImageIOs())
   {
     if (mode == IOFileModeEnum::ReadMode)
     {
       if (k->CanReadFile(path))
       {
+        ++imageIOSelectionCounts[k->GetNameOfClass()];
         return k;
       }
     }
@@ -68,4 +112,101 @@ ImageIOFactory::CreateImageIO(const char * path, IOFileModeEnum mode)
   return nullptr;
 }
 
+ImageIOBase::Pointer
+ImageIOFactory::CreateImageIOForProbing(const char * path)
+{
+  struct Candidate
+  {
+    ImageIOBase::Pointer ImageIO;
+    unsigned int         Rank;
+    SizeValueType        SelectionCount;
+  };
+
+  const std::string header = ReadFileHeader(path);
+  const std::string lowerCasePath = itksys::SystemTools::LowerCase(path);
+
+  std::vector<Candidate> candidates;
+  {
+    std::lock_guard<std::mutex> mutexHolder(createImageIOLock);
+    for (auto & io : CreateAllImageIOs())
+    {
+      const unsigned int rank = HasSupportedExtension(lowerCasePath, io->GetSupportedReadExtensions()) ? 0 : 1;
+      const auto count = imageIOSelectionCounts.find(io->GetNameOfClass());
+      candidates.push_back({ io, rank, count != imageIOSelectionCounts.end() ? count->second : 0 });
+    }
+  }
+
+  std::stable_sort(candidates.begin(), candidates.end(), [](const Candidate & a, const Candidate & b) {
+    return a.Rank < b.Rank || (a.Rank == b.Rank && a.SelectionCount > b.SelectionCount);
+  });
+
+  // The ImageIOs are distinct instances, so that files can be probed
+  // from several threads at once
+  for (auto & candidate : candidates)
+  {
+    if (candidate.ImageIO->CanReadFileHeader(path, header.data(), header.size()))
+    {
+      std::lock_guard<std::mutex> mutexHolder(createImageIOLock);
+      ++imageIOSelectionCounts[candidate.ImageIO->GetNameOfClass()];
+      return candidate.ImageIO;
+    }
+  }
+  return nullptr;
+}
+
+ImageIOFactory::ImageInformation
+ImageIOFactory::ProbeImageInformation(const std::string & path)
+{
+  ImageInformation information;
+  information.FileName = path;
+
+  try
+  {
+    ImageIOBase::Pointer io = CreateImageIOForProbing(path.c_str());
+    if (io.IsNull())
+    {
+      information.ErrorMessage = "Could not create IO object for reading file " + path;
+      return information;
+    }
+    information.ImageIOName = io->GetNameOfClass();
+
+    io->SetFileName(path);
+    io->ReadImageInformation();
+
+    const unsigned int dimension = io->GetNumberOfDimensions();
+    information.NumberOfDimensions = dimension;
+    for (unsigned int i = 0; i < dimension; ++i)
+    {
+      information.Size.push_back(io->GetDimensions(i));
+      information.Spacing.push_back(io->GetSpacing(i));
+      information.Origin.push_back(io->GetOrigin(i));
+      information.Direction.push_back(io->GetDirection(i));
+    }
+    information.PixelType = io->GetPixelType();
+    information.ComponentType = io->GetComponentType();
+    information.NumberOfComponents = io->GetNumberOfComponents();
+  }
+  catch (const std::exception & e)
+  {
+    information.ErrorMessage = e.what();
+  }
+
+  return information;
+}
+
+std::vector<ImageIOFactory::ImageInformation>
+ImageIOFactory::ProbeImageInformation(const std::vector<std::string> & paths)
+{
+  std::vector<ImageInformation> information(paths.size());
+
+  MultiThreaderBase::Pointer multiThreader = MultiThreaderBase::New();
+  multiThreader->ParallelizeArray(
+    0,
+    paths.size(),
+    [&information, &paths](SizeValueType i) { information[i] = ProbeImageInformation(paths[i]); },
+    nullptr);
+
+  return information;
+}
+
 } // end namespace itk
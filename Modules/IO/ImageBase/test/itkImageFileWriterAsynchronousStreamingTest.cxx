@@ -0,0 +1,128 @@
+/*=========================================================================
+ *
+ *  Copyright NumFOCUS
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include "itkImageFileReader.h"
+#include "itkImageFileWriter.h"
+#include "itkImageRegionConstIterator.h"
+#include "itkImageRegionIteratorWithIndex.h"
+#include "itkPipelineMonitorImageFilter.h"
+#include "itkTestingMacros.h"
+
+// Streams an image through a pipeline which supports streaming and
+// writes it with the pieces written on a background thread, then
+// checks that the file holds the same pixels as the original image.
+int
+itkImageFileWriterAsynchronousStreamingTest(int argc, char * argv[])
+{
+  if (argc < 4)
+  {
+    std::cerr << "Missing parameters." << std::endl;
+    std::cerr << "Usage: " << itkNameOfTestExecutableMacro(argv);
+    std::cerr << " input output numberOfPendingPieces" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  using PixelType = unsigned short;
+  using ImageType = itk::Image<PixelType, 3>;
+
+  using ReaderType = itk::ImageFileReader<ImageType>;
+  using WriterType = itk::ImageFileWriter<ImageType>;
+
+  // Create and write a synthetic input, which is then read back in
+  // pieces by the streaming pipeline
+  ImageType::Pointer  image = ImageType::New();
+  ImageType::SizeType size = { { 31, 27, 19 } };
+  image->SetRegions(size);
+  image->Allocate();
+
+  itk::ImageRegionIteratorWithIndex<ImageType> it(image, image->GetLargestPossibleRegion());
+  for (it.GoToBegin(); !it.IsAtEnd(); ++it)
+  {
+    const ImageType::IndexType & index = it.GetIndex();
+    it.Set(static_cast<PixelType>(index[0] + 37 * index[1] + 1031 * index[2]));
+  }
+
+  WriterType::Pointer inputWriter = WriterType::New();
+  inputWriter->SetFileName(argv[1]);
+  inputWriter->SetInput(image);
+  ITK_TRY_EXPECT_NO_EXCEPTION(inputWriter->Update());
+
+  const unsigned int numberOfDataPieces = 5;
+
+  ReaderType::Pointer reader = ReaderType::New();
+  reader->SetFileName(argv[1]);
+  reader->SetUseStreaming(true);
+
+  using MonitorFilter = itk::PipelineMonitorImageFilter<ImageType>;
+  MonitorFilter::Pointer monitor = MonitorFilter::New();
+  monitor->SetInput(reader->GetOutput());
+
+  WriterType::Pointer writer = WriterType::New();
+
+  ITK_EXERCISE_BASIC_OBJECT_METHODS(writer, ImageFileWriter, ProcessObject);
+
+  writer->SetFileName(argv[2]);
+  writer->SetInput(monitor->GetOutput());
+  writer->SetNumberOfStreamDivisions(numberOfDataPieces);
+
+  ITK_TEST_SET_GET_BOOLEAN(writer, UseAsynchronousStreaming, true);
+
+  auto numberOfPendingPieces = static_cast<unsigned int>(std::stoi(argv[3]));
+  writer->SetMaximumNumberOfPendingPieces(numberOfPendingPieces);
+  ITK_TEST_SET_GET_VALUE(numberOfPendingPieces, writer->GetMaximumNumberOfPendingPieces());
+
+  ITK_TRY_EXPECT_NO_EXCEPTION(writer->Update());
+
+  if (!monitor->VerifyAllInputCanStream(numberOfDataPieces))
+  {
+    std::cout << monitor << std::endl;
+    std::cerr << "Test failed!" << std::endl;
+    std::cerr << "Pipeline did not execute as expected!" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  ReaderType::Pointer outputReader = ReaderType::New();
+  outputReader->SetFileName(argv[2]);
+  ITK_TRY_EXPECT_NO_EXCEPTION(outputReader->Update());
+
+  ImageType::ConstPointer output = outputReader->GetOutput();
+  if (output->GetLargestPossibleRegion() != image->GetLargestPossibleRegion())
+  {
+    std::cerr << "Test failed!" << std::endl;
+    std::cerr << "Error in region of written image" << std::endl;
+    std::cerr << "Expected: " << image->GetLargestPossibleRegion() << std::endl;
+    std::cerr << "Actual: " << output->GetLargestPossibleRegion() << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  itk::ImageRegionConstIterator<ImageType> expectedIt(image, image->GetLargestPossibleRegion());
+  itk::ImageRegionConstIterator<ImageType> outputIt(output, output->GetLargestPossibleRegion());
+  for (; !expectedIt.IsAtEnd(); ++expectedIt, ++outputIt)
+  {
+    if (expectedIt.Get() != outputIt.Get())
+    {
+      std::cerr << "Test failed!" << std::endl;
+      std::cerr << "Error in pixel value at index " << expectedIt.GetIndex() << std::endl;
+      std::cerr << "Expected: " << expectedIt.Get() << ", but got: " << outputIt.Get() << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+
+  std::cout << "Test finished." << std::endl;
+  return EXIT_SUCCESS;
+}
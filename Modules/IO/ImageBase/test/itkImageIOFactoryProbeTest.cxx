@@ -0,0 +1,149 @@
+/*=========================================================================
+ *
+ *  Copyright NumFOCUS
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include "itkImageFileWriter.h"
+#include "itkImageIOFactory.h"
+#include "itkMath.h"
+#include "itkTestingMacros.h"
+#include "itkVectorImage.h"
+
+#include <fstream>
+
+// Writes images of different types and probes their headers, together
+// with files which cannot be read as images, one by one and in bulk.
+int
+itkImageIOFactoryProbeTest(int argc, char * argv[])
+{
+  if (argc < 2)
+  {
+    std::cerr << "Missing parameters." << std::endl;
+    std::cerr << "Usage: " << itkNameOfTestExecutableMacro(argv);
+    std::cerr << " outputDirectory" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  const std::string outputDirectory = argv[1];
+
+  using ScalarImageType = itk::Image<short, 3>;
+  using VectorImageType = itk::VectorImage<float, 2>;
+
+  const std::string scalarFileName = outputDirectory + "/itkImageIOFactoryProbeTestScalar.mha";
+  const std::string vectorFileName = outputDirectory + "/itkImageIOFactoryProbeTestVector.mha";
+  const std::string textFileName = outputDirectory + "/itkImageIOFactoryProbeTestText.txt";
+  const std::string missingFileName = outputDirectory + "/itkImageIOFactoryProbeTestMissing.mha";
+
+  ScalarImageType::Pointer     scalarImage = ScalarImageType::New();
+  ScalarImageType::SizeType    scalarSize = { { 7, 5, 3 } };
+  ScalarImageType::SpacingType scalarSpacing;
+  scalarSpacing[0] = 0.5;
+  scalarSpacing[1] = 0.75;
+  scalarSpacing[2] = 2.0;
+  ScalarImageType::PointType scalarOrigin;
+  scalarOrigin[0] = -1.0;
+  scalarOrigin[1] = 3.0;
+  scalarOrigin[2] = 10.0;
+  scalarImage->SetRegions(scalarSize);
+  scalarImage->SetSpacing(scalarSpacing);
+  scalarImage->SetOrigin(scalarOrigin);
+  scalarImage->Allocate(true);
+  using ScalarWriterType = itk::ImageFileWriter<ScalarImageType>;
+  ScalarWriterType::Pointer scalarWriter = ScalarWriterType::New();
+  scalarWriter->SetFileName(scalarFileName);
+  scalarWriter->SetInput(scalarImage);
+  ITK_TRY_EXPECT_NO_EXCEPTION(scalarWriter->Update());
+
+  VectorImageType::Pointer  vectorImage = VectorImageType::New();
+  VectorImageType::SizeType vectorSize = { { 4, 6 } };
+  vectorImage->SetRegions(vectorSize);
+  vectorImage->SetNumberOfComponentsPerPixel(3);
+  vectorImage->Allocate(true);
+  using VectorWriterType = itk::ImageFileWriter<VectorImageType>;
+  VectorWriterType::Pointer vectorWriter = VectorWriterType::New();
+  vectorWriter->SetFileName(vectorFileName);
+  vectorWriter->SetInput(vectorImage);
+  ITK_TRY_EXPECT_NO_EXCEPTION(vectorWriter->Update());
+
+  {
+    std::ofstream textFile(textFileName.c_str());
+    textFile << "This is not an image." << std::endl;
+  }
+
+  // Single file probing selects the same ImageIO as CreateImageIO
+  itk::ImageIOBase::Pointer probedIO = itk::ImageIOFactory::CreateImageIOForProbing(scalarFileName.c_str());
+  itk::ImageIOBase::Pointer createdIO =
+    itk::ImageIOFactory::CreateImageIO(scalarFileName.c_str(), itk::IOFileModeEnum::ReadMode);
+  ITK_TEST_EXPECT_TRUE(probedIO.IsNotNull());
+  ITK_TEST_EXPECT_TRUE(createdIO.IsNotNull());
+  ITK_TEST_EXPECT_EQUAL(std::string(probedIO->GetNameOfClass()), std::string(createdIO->GetNameOfClass()));
+  // MetaImageIO does not look at the leading bytes given to CanReadFileHeader()
+  ITK_TEST_EXPECT_TRUE(probedIO->CanReadFileHeader(scalarFileName.c_str(), "", 0));
+  ITK_TEST_EXPECT_TRUE(!probedIO->CanReadFileHeader(textFileName.c_str(), "", 0));
+  ITK_TEST_EXPECT_TRUE(itk::ImageIOFactory::CreateImageIOForProbing(textFileName.c_str()).IsNull());
+  ITK_TEST_EXPECT_TRUE(itk::ImageIOFactory::CreateImageIOForProbing(missingFileName.c_str()).IsNull());
+
+  // Probe many files in parallel
+  std::vector<std::string> fileNames;
+  for (unsigned int i = 0; i < 16; ++i)
+  {
+    fileNames.push_back(scalarFileName);
+    fileNames.push_back(vectorFileName);
+    fileNames.push_back(textFileName);
+    fileNames.push_back(missingFileName);
+  }
+
+  const std::vector<itk::ImageIOFactory::ImageInformation> information =
+    itk::ImageIOFactory::ProbeImageInformation(fileNames);
+  ITK_TEST_EXPECT_EQUAL(information.size(), fileNames.size());
+
+  for (unsigned int i = 0; i < information.size(); i += 4)
+  {
+    const itk::ImageIOFactory::ImageInformation & scalar = information[i];
+    ITK_TEST_EXPECT_EQUAL(scalar.FileName, scalarFileName);
+    ITK_TEST_EXPECT_TRUE(scalar.IsValid());
+    ITK_TEST_EXPECT_EQUAL(scalar.NumberOfDimensions, 3u);
+    ITK_TEST_EXPECT_EQUAL(scalar.PixelType, itk::IOPixelEnum::SCALAR);
+    ITK_TEST_EXPECT_EQUAL(scalar.ComponentType, itk::IOComponentEnum::SHORT);
+    ITK_TEST_EXPECT_EQUAL(scalar.NumberOfComponents, 1u);
+    for (unsigned int d = 0; d < 3; ++d)
+    {
+      ITK_TEST_EXPECT_EQUAL(scalar.Size[d], scalarSize[d]);
+      ITK_TEST_EXPECT_TRUE(itk::Math::FloatAlmostEqual(scalar.Spacing[d], scalarSpacing[d]));
+      ITK_TEST_EXPECT_TRUE(itk::Math::FloatAlmostEqual(scalar.Origin[d], scalarOrigin[d]));
+      for (unsigned int k = 0; k < 3; ++k)
+      {
+        ITK_TEST_EXPECT_TRUE(itk::Math::FloatAlmostEqual(scalar.Direction[d][k], d == k ? 1.0 : 0.0));
+      }
+    }
+
+    const itk::ImageIOFactory::ImageInformation & vector = information[i + 1];
+    ITK_TEST_EXPECT_TRUE(vector.IsValid());
+    ITK_TEST_EXPECT_EQUAL(vector.NumberOfDimensions, 2u);
+    ITK_TEST_EXPECT_EQUAL(vector.Size[0], vectorSize[0]);
+    ITK_TEST_EXPECT_EQUAL(vector.Size[1], vectorSize[1]);
+    ITK_TEST_EXPECT_EQUAL(vector.ComponentType, itk::IOComponentEnum::FLOAT);
+    ITK_TEST_EXPECT_EQUAL(vector.NumberOfComponents, 3u);
+
+    ITK_TEST_EXPECT_TRUE(!information[i + 2].IsValid());
+    ITK_TEST_EXPECT_TRUE(information[i + 2].ImageIOName.empty());
+    ITK_TEST_EXPECT_TRUE(!information[i + 3].IsValid());
+    ITK_TEST_EXPECT_TRUE(!information[i + 3].ErrorMessage.empty());
+  }
+
+  std::cout << "Test finished." << std::endl;
+  return EXIT_SUCCESS;
+}
@@ -162,6 +162,17 @@ JPEGImageIO::CanReadFile(const char * file)
   return true;
 }
 
+bool
+JPEGImageIO::CanReadFileHeader(const char * file, const char * header, SizeValueType length)
+{
+  // 0xFF followed by 0xD8
+  if (length < 2 || static_cast<unsigned char>(header[0]) != 0xFF || static_cast<unsigned char>(header[1]) != 0xD8)
+  {
+    return false;
+  }
+  return this->CanReadFile(file);
+}
+
 void
 JPEGImageIO::ReadVolume(void *)
 {}
@@ -20,10 +20,12 @@
 #include "ITKIONRRDExport.h"
 
 
-#include "itkImageIOBase.h"
+#include "itkStreamingImageIOBase.h"
 #include <fstream>
+#include <memory>
 
 struct NrrdEncoding_t;
+struct NrrdIoState_t;
 
 namespace itk
 {
@@ -38,24 +40,32 @@ namespace itk
  * "bzip2".  Only the "gzip" compressor support the compression level
  * in the range 0-9.
  *
+ * Files whose data is stored in a single attached or detached data file
+ * can be read in pieces. Uncompressed (raw) data is read directly from the
+ * requested region; gzip compressed data is decompressed sequentially up
+ * to the requested region, and the decompression state is kept between
+ * pieces so that streaming through the file decompresses it only once.
+ * Streamed writing and pasting are supported for uncompressed binary
+ * output.
+ *
  *  \ingroup IOFilters
  * \ingroup ITKIONRRD
  */
-class ITKIONRRD_EXPORT NrrdImageIO : public ImageIOBase
+class ITKIONRRD_EXPORT NrrdImageIO : public StreamingImageIOBase
 {
 public:
   ITK_DISALLOW_COPY_AND_ASSIGN(NrrdImageIO);
 
   /** Standard class type aliases. */
   using Self = NrrdImageIO;
-  using Superclass = ImageIOBase;
+  using Superclass = StreamingImageIOBase;
   using Pointer = SmartPointer<Self>;
 
   /** Method for creation through the object factory. */
   itkNewMacro(Self);
 
   /** Run-time type information (and related methods). */
-  itkTypeMacro(NrrdImageIO, ImageIOBase);
+  itkTypeMacro(NrrdImageIO, StreamingImageIOBase);
 
   /** The different types of ImageIO's can support data of varying
    * dimensionality. For example, some file formats are strictly 2D
@@ -70,6 +80,10 @@ public:
   bool
   CanReadFile(const char *) override;
 
+  /** Reject the files without the Nrrd magic "NRRD" before opening them. */
+  bool
+  CanReadFileHeader(const char * fileName, const char * header, SizeValueType length) override;
+
   /** Set the spacing and dimension information for the set filename. */
   void
   ReadImageInformation() override;
@@ -92,6 +106,17 @@ public:
   void
   Write(const void * buffer) override;
 
+  /** Returns true if the data of the file read by ReadImageInformation
+   * is stored raw or gzip compressed in a single data file, with any
+   * non-scalar axis being the fastest. */
+  bool
+  CanStreamRead() override;
+
+  /** Returns true unless the data is to be written compressed or as
+   * ASCII text. */
+  bool
+  CanStreamWrite() override;
+
 protected:
   NrrdImageIO();
   ~NrrdImageIO() override;
@@ -109,7 +134,37 @@ protected:
   IOComponentEnum
   NrrdToITKComponentType(const int) const;
 
+  /** Returns the byte offset of the data in the data file, which is
+   * either the file itself or the detached data file. */
+  SizeType
+  GetHeaderSize() const override
+  {
+    return m_DataPosition;
+  }
+
   const NrrdEncoding_t * m_NrrdCompressionEncoding{ nullptr };
+
+private:
+  class GzipDataReader;
+
+  /** Records where the data of the file whose header has just been
+   * loaded or saved with nio is stored, and closes the data file if
+   * nio holds it open. */
+  void
+  SetDataFileLocation(NrrdIoState_t * nio);
+
+  /** Reads the IORegion of gzip compressed data. */
+  void
+  StreamReadGzipData(void * buffer);
+
+  /** Data file of the last file whose header was read or written, or
+   * empty if its data is split into several files. */
+  std::string            m_DataFileName;
+  SizeType               m_DataPosition{ 0 };
+  SizeType               m_DataByteSkip{ 0 };
+  const NrrdEncoding_t * m_DataFileEncoding{ nullptr };
+
+  std::unique_ptr<GzipDataReader> m_GzipDataReader;
 };
 } // end namespace itk
 
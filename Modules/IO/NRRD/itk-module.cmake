@@ -8,6 +8,7 @@ itk_module(ITKIONRRD
     ITKIOImageBase
   PRIVATE_DEPENDS
     ITKNrrdIO
+    ITKZLIB
   TEST_DEPENDS
     ITKTestKernel
   FACTORY_NAMES
@@ -22,11 +22,253 @@
 #include "itkMetaDataObject.h"
 #include "itkIOCommon.h"
 #include "itkFloatingPointExceptions.h"
+#include "itkByteSwapper.h"
+#include "itksys/SystemTools.hxx"
+#include "itk_zlib.h"
+
+#include <cstring>
 
 namespace itk
 {
 #define KEY_PREFIX "NRRD_"
 
+namespace
+{
+// Returns the name of the single file holding the data of the nrrd
+// whose header was loaded or saved with nio, or an empty string if the
+// data is split into several files.
+std::string
+GetNrrdDataFileName(const NrrdIoState * nio, const std::string & headerFileName)
+{
+  if (!nio->dataFNFormat && 0 == nio->dataFNArr->len)
+  {
+    // attached data
+    return headerFileName;
+  }
+  if (nio->dataFNFormat || 1 != nio->dataFNArr->len)
+  {
+    return std::string();
+  }
+
+  // detached data files are relative to the header unless they are
+  // full paths
+  std::string dataFileName = nio->dataFN[0];
+  if (dataFileName == "-")
+  {
+    return std::string();
+  }
+  if (!itksys::SystemTools::FileIsFullPath(dataFileName) && airStrlen(nio->path))
+  {
+    dataFileName = std::string(nio->path) + "/" + dataFileName;
+  }
+  return dataFileName;
+}
+
+// Swaps the components between the system byte order and the given
+// byte order. The swap is its own inverse.
+void
+SwapComponentsFromSystemTo(IOByteOrderEnum byteOrder, void * buffer, size_t componentSize, SizeValueType num)
+{
+  if (byteOrder != IOByteOrderEnum::BigEndian && byteOrder != IOByteOrderEnum::LittleEndian)
+  {
+    return;
+  }
+  const bool toBigEndian = (byteOrder == IOByteOrderEnum::BigEndian);
+  switch (componentSize)
+  {
+    case 1:
+      break;
+    case 2:
+      toBigEndian ? ByteSwapper<uint16_t>::SwapRangeFromSystemToBigEndian(static_cast<uint16_t *>(buffer), num)
+                  : ByteSwapper<uint16_t>::SwapRangeFromSystemToLittleEndian(static_cast<uint16_t *>(buffer), num);
+      break;
+    case 4:
+      toBigEndian ? ByteSwapper<uint32_t>::SwapRangeFromSystemToBigEndian(static_cast<uint32_t *>(buffer), num)
+                  : ByteSwapper<uint32_t>::SwapRangeFromSystemToLittleEndian(static_cast<uint32_t *>(buffer), num);
+      break;
+    case 8:
+      toBigEndian ? ByteSwapper<uint64_t>::SwapRangeFromSystemToBigEndian(static_cast<uint64_t *>(buffer), num)
+                  : ByteSwapper<uint64_t>::SwapRangeFromSystemToLittleEndian(static_cast<uint64_t *>(buffer), num);
+      break;
+    default:
+      itkGenericExceptionMacro(<< "Unknown component size" << componentSize);
+  }
+}
+
+IOByteOrderEnum
+NrrdToITKByteOrder(int endian)
+{
+  switch (endian)
+  {
+    case airEndianLittle:
+      return IOByteOrderEnum::LittleEndian;
+    case airEndianBig:
+      return IOByteOrderEnum::BigEndian;
+    default:
+      return IOByteOrderEnum::OrderNotApplicable;
+  }
+}
+// Loads the header of a nrrd file, keeping a single data file open
+// at the beginning of its data. Returns non-zero on error, as nrrdLoad.
+int
+LoadNrrdHeader(Nrrd * nrrd, NrrdIoState * nio, const char * fileName)
+{
+  // nrrd causes exceptions on purpose, so mask them
+  bool saveFPEState(false);
+  if (FloatingPointExceptions::HasFloatingPointExceptionsSupport())
+  {
+    saveFPEState = FloatingPointExceptions::GetEnabled();
+    FloatingPointExceptions::Disable();
+  }
+
+  // this is the mechanism by which we tell nrrdLoad to read
+  // just the header, and none of the data
+  nrrdIoStateSet(nio, nrrdIoStateSkipData, 1);
+  nrrdIoStateSet(nio, nrrdIoStateKeepNrrdDataFileOpen, 1);
+  const int status = nrrdLoad(nrrd, fileName, nio);
+
+  // restore state
+  if (FloatingPointExceptions::HasFloatingPointExceptionsSupport())
+  {
+    FloatingPointExceptions::SetEnabled(saveFPEState);
+  }
+  return status;
+}
+} // namespace
+
+/** \class GzipDataReader
+ *
+ * Reads ranges of the decompressed data of a gzip encoded data file,
+ * in increasing order. The inflate state is kept between reads, so
+ * that reading the file piece by piece decompresses it only once;
+ * reading backwards restarts the decompression from the beginning of
+ * the data.
+ */
+class NrrdImageIO::GzipDataReader
+{
+public:
+  GzipDataReader(const std::string & fileName, SizeType dataPosition)
+    : m_FileName(fileName)
+    , m_DataPosition(dataPosition)
+    , m_InputBuffer(1 << 16)
+  {
+    m_File.open(fileName.c_str(), std::ios::in | std::ios::binary);
+    m_Stream.zalloc = Z_NULL;
+    m_Stream.zfree = Z_NULL;
+    m_Stream.opaque = Z_NULL;
+    m_Stream.next_in = Z_NULL;
+    m_Stream.avail_in = 0;
+    // 32 enables the detection of the gzip header
+    m_Initialized = (inflateInit2(&m_Stream, 15 + 32) == Z_OK);
+    this->Restart();
+  }
+
+  ~GzipDataReader()
+  {
+    if (m_Initialized)
+    {
+      inflateEnd(&m_Stream);
+    }
+  }
+
+  ITK_DISALLOW_COPY_AND_ASSIGN(GzipDataReader);
+
+  bool
+  IsReading(const std::string & fileName, SizeType dataPosition) const
+  {
+    return m_FileName == fileName && m_DataPosition == dataPosition;
+  }
+
+  /** Reads numberOfBytes decompressed bytes starting at offset. */
+  bool
+  Read(SizeType offset, char * buffer, SizeType numberOfBytes)
+  {
+    if (!m_Initialized || !m_File.is_open())
+    {
+      return false;
+    }
+    if (offset < m_Offset)
+    {
+      this->Restart();
+    }
+
+    // decompress and discard the data before the requested range
+    std::vector<char> skipBuffer;
+    while (m_Offset < offset)
+    {
+      skipBuffer.resize(std::min<SizeType>(offset - m_Offset, m_InputBuffer.size()));
+      if (!this->Inflate(skipBuffer.data(), skipBuffer.size()))
+      {
+        return false;
+      }
+    }
+    return this->Inflate(buffer, numberOfBytes);
+  }
+
+private:
+  void
+  Restart()
+  {
+    m_File.clear();
+    m_File.seekg(m_DataPosition, std::ios::beg);
+    m_Stream.next_in = Z_NULL;
+    m_Stream.avail_in = 0;
+    m_Offset = 0;
+    if (m_Initialized)
+    {
+      inflateReset(&m_Stream);
+    }
+  }
+
+  bool
+  Inflate(char * buffer, SizeType numberOfBytes)
+  {
+    while (numberOfBytes > 0)
+    {
+      if (m_Stream.avail_in == 0)
+      {
+        m_File.read(reinterpret_cast<char *>(m_InputBuffer.data()), m_InputBuffer.size());
+        if (m_File.gcount() <= 0)
+        {
+          // truncated data
+          return false;
+        }
+        m_Stream.next_in = m_InputBuffer.data();
+        m_Stream.avail_in = static_cast<uInt>(m_File.gcount());
+      }
+
+      const auto chunk = static_cast<uInt>(std::min<SizeType>(numberOfBytes, NumericTraits<uInt>::max()));
+      m_Stream.next_out = reinterpret_cast<Bytef *>(buffer);
+      m_Stream.avail_out = chunk;
+
+      const int  status = inflate(&m_Stream, Z_NO_FLUSH);
+      const uInt produced = chunk - m_Stream.avail_out;
+      buffer += produced;
+      numberOfBytes -= produced;
+      m_Offset += produced;
+
+      if (status == Z_STREAM_END)
+      {
+        // the data may be made of several concatenated gzip members
+        inflateReset(&m_Stream);
+      }
+      else if (status != Z_OK && status != Z_BUF_ERROR)
+      {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  std::string                m_FileName;
+  SizeType                   m_DataPosition;
+  std::ifstream              m_File;
+  std::vector<unsigned char> m_InputBuffer;
+  z_stream                   m_Stream;
+  bool                       m_Initialized{ false };
+  SizeType                   m_Offset{ 0 };
+};
+
 NrrdImageIO::NrrdImageIO()
 {
   this->SetNumberOfDimensions(3);
@@ -63,6 +305,58 @@ void
 NrrdImageIO::PrintSelf(std::ostream & os, Indent indent) const
 {
   Superclass::PrintSelf(os, indent);
+
+  os << indent << "DataFileName: " << m_DataFileName << std::endl;
+  os << indent << "DataPosition: " << m_DataPosition << std::endl;
+  os << indent << "DataByteSkip: " << m_DataByteSkip << std::endl;
+  os << indent << "DataFileEncoding: " << (m_DataFileEncoding ? m_DataFileEncoding->name : "(none)") << std::endl;
+}
+
+bool
+NrrdImageIO::CanStreamRead()
+{
+  return m_DataFileEncoding != nullptr;
+}
+
+bool
+NrrdImageIO::CanStreamWrite()
+{
+  bool canStreamWrite = true;
+  canStreamWrite &= !this->GetUseCompression();
+  canStreamWrite &= this->GetFileType() != IOFileEnum::ASCII;
+  return canStreamWrite;
+}
+
+void
+NrrdImageIO::SetDataFileLocation(NrrdIoState_t * nio)
+{
+  m_DataFileName = GetNrrdDataFileName(nio, m_FileName);
+  m_DataPosition = 0;
+  m_DataByteSkip = 0;
+  m_DataFileEncoding = nullptr;
+
+  if (nio->dataFile)
+  {
+    // the data file was kept open at the beginning of the data, after
+    // skipping lines and, for uncompressed data, bytes
+    const long position = ftell(nio->dataFile);
+    if (position >= 0 && !m_DataFileName.empty())
+    {
+      m_DataPosition = static_cast<SizeType>(position);
+      if (nio->encoding == nrrdEncodingRaw)
+      {
+        m_DataFileEncoding = nrrdEncodingRaw;
+      }
+      else if (nio->encoding == nrrdEncodingGzip && nio->byteSkip >= 0)
+      {
+        // bytes are skipped within the decompressed data
+        m_DataByteSkip = static_cast<SizeType>(nio->byteSkip);
+        m_DataFileEncoding = nrrdEncodingGzip;
+      }
+    }
+    airFclose(nio->dataFile);
+    nio->dataFile = nullptr;
+  }
 }
 
 void
@@ -246,6 +540,17 @@ NrrdImageIO::CanReadFile(const char * filename)
   return false;
 }
 
+bool
+NrrdImageIO::CanReadFileHeader(const char * filename, const char * header, SizeValueType length)
+{
+  // The Nrrd magic "NRRD", ignoring the format version
+  if (length < 4 || std::strncmp(header, "NRRD", 4) != 0)
+  {
+    return false;
+  }
+  return this->CanReadFile(filename);
+}
+
 void
 NrrdImageIO::ReadImageInformation()
 {
@@ -267,18 +572,7 @@ NrrdImageIO::ReadImageInformation()
 
   try
   {
-    // nrrd causes exceptions on purpose, so mask them
-    bool saveFPEState(false);
-    if (FloatingPointExceptions::HasFloatingPointExceptionsSupport())
-    {
-      saveFPEState = FloatingPointExceptions::GetEnabled();
-      FloatingPointExceptions::Disable();
-    }
-
-    // this is the mechanism by which we tell nrrdLoad to read
-    // just the header, and none of the data
-    nrrdIoStateSet(nio, nrrdIoStateSkipData, 1);
-    if (nrrdLoad(nrrd, this->GetFileName(), nio) != 0)
+    if (LoadNrrdHeader(nrrd, nio, this->GetFileName()) != 0)
     {
       char * err = biffGetDone(NRRD);
 
@@ -292,12 +586,7 @@ NrrdImageIO::ReadImageInformation()
       throw e_;
     }
 
-    // restore state
-    if (FloatingPointExceptions::HasFloatingPointExceptionsSupport())
-    {
-      FloatingPointExceptions::SetEnabled(saveFPEState);
-    }
-
+    this->SetDataFileLocation(nio);
 
     if (nrrdTypeBlock == nrrd->type)
     {
@@ -444,6 +733,14 @@ NrrdImageIO::ReadImageInformation()
                                                           << " dependent axis (not 1); not currently handled");
     }
 
+    // Read() permutes a non-scalar axis which is not the fastest one,
+    // and crops masked tensors; neither can be done piece by piece
+    if (1 == rangeAxisNum &&
+        (0 != rangeAxisIdx[0] || nrrdKind3DMaskedSymMatrix == nrrd->axis[rangeAxisIdx[0]].kind))
+    {
+      m_DataFileEncoding = nullptr;
+    }
+
     double              spacing;
     double              spaceDir[NRRD_SPACE_DIM_MAX];
     std::vector<double> spaceDirStd(domainAxisNum);
@@ -709,9 +1006,87 @@ NrrdImageIO::ReadImageInformation()
   }
 }
 
+void
+NrrdImageIO::StreamReadGzipData(void * _buffer)
+{
+  if (!m_GzipDataReader || !m_GzipDataReader->IsReading(m_DataFileName, m_DataPosition))
+  {
+    m_GzipDataReader.reset(new GzipDataReader(m_DataFileName, m_DataPosition));
+  }
+
+  auto * buffer = static_cast<char *>(_buffer);
+
+  // compute the number of continuous bytes to be read, as in
+  // StreamReadBufferAsBinary
+  SizeType     sizeOfChunk = 1;
+  unsigned int movingDirection = 0;
+  do
+  {
+    sizeOfChunk *= m_IORegion.GetSize(movingDirection);
+    ++movingDirection;
+  } while (movingDirection < m_IORegion.GetImageDimension() &&
+           m_IORegion.GetSize(movingDirection - 1) == this->GetDimensions(movingDirection - 1));
+  sizeOfChunk *= this->GetPixelSize();
+
+  // the chunks are read in increasing order of their offset
+  ImageIORegion::IndexType currentIndex = m_IORegion.GetIndex();
+  while (m_IORegion.IsInside(currentIndex))
+  {
+    SizeType offset = m_DataByteSkip;
+    SizeType subDimensionQuantity = 1;
+    for (unsigned int i = 0; i < m_IORegion.GetImageDimension(); ++i)
+    {
+      offset += subDimensionQuantity * this->GetPixelSize() * currentIndex[i];
+      subDimensionQuantity *= this->GetDimensions(i);
+    }
+
+    if (!m_GzipDataReader->Read(offset, buffer, sizeOfChunk))
+    {
+      m_GzipDataReader.reset();
+      itkExceptionMacro("Read: Error decompressing data of " << m_DataFileName);
+    }
+    buffer += sizeOfChunk;
+
+    if (movingDirection == m_IORegion.GetImageDimension())
+    {
+      break;
+    }
+
+    // increment index to next chunk
+    ++currentIndex[movingDirection];
+    for (unsigned int i = movingDirection; i < m_IORegion.GetImageDimension() - 1; ++i)
+    {
+      if (static_cast<ImageIORegion::SizeValueType>(currentIndex[i] - m_IORegion.GetIndex(i)) >= m_IORegion.GetSize(i))
+      {
+        currentIndex[i] = m_IORegion.GetIndex(i);
+        ++currentIndex[i + 1];
+      }
+    }
+  }
+}
+
 void
 NrrdImageIO::Read(void * buffer)
 {
+  if (this->RequestedToStream() && this->CanStreamRead())
+  {
+    if (m_DataFileEncoding == nrrdEncodingGzip)
+    {
+      this->StreamReadGzipData(buffer);
+    }
+    else
+    {
+      std::ifstream file;
+      this->OpenFileForReading(file, m_DataFileName);
+      this->StreamReadBufferAsBinary(file, buffer);
+    }
+    SwapComponentsFromSystemTo(this->GetByteOrder(),
+                               buffer,
+                               this->GetComponentSize(),
+                               this->GetIORegion().GetNumberOfPixels() * this->GetNumberOfComponents());
+    return;
+  }
+
   Nrrd * nrrd = nrrdNew();
   bool   nrrdAllocated;
 
@@ -1109,8 +1484,78 @@ NrrdImageIO::Write(const void * buffer)
       break;
   }
 
+  if (this->RequestedToStream())
+  {
+    // Only the IORegion is written, in place. The header, and the space
+    // for the whole data, are written with the first piece;
+    // GetActualNumberOfSplitsForWriting has removed any previous file
+    // unless we are pasting into it.
+    IOByteOrderEnum dataByteOrder = this->GetByteOrder();
+    if (!itksys::SystemTools::FileExists(m_FileName.c_str()))
+    {
+      nrrdIoStateSet(nio, nrrdIoStateSkipData, 1);
+      if (nrrdSave(this->GetFileName(), nrrd, nio))
+      {
+        char * err = biffGetDone(NRRD); // would be nice to free(err)
+        itkExceptionMacro("Write: Error writing header of " << this->GetFileName() << ":\n" << err);
+      }
+      this->SetDataFileLocation(nio);
+      if (m_DataFileName == m_FileName)
+      {
+        m_DataPosition = itksys::SystemTools::FileLength(m_FileName);
+      }
+      m_DataFileEncoding = nrrdEncodingRaw;
+
+      // write one byte at the end of the data to allocate it, as
+      // VTKImageIO does; detached data files are truncated
+      std::ofstream file;
+      this->OpenFileForWriting(file, m_DataFileName, m_DataFileName != m_FileName);
+      file.seekp(static_cast<std::streampos>(m_DataPosition + this->GetImageSizeInBytes() - 1), std::ios::beg);
+      file.write("\0", 1);
+    }
+    else
+    {
+      Nrrd *        fileNrrd = nrrdNew();
+      NrrdIoState * fileNio = nrrdIoStateNew();
+      if (LoadNrrdHeader(fileNrrd, fileNio, this->GetFileName()) != 0)
+      {
+        char * err = biffGetDone(NRRD); // would be nice to free(err)
+        itkExceptionMacro("Write: Error reading header of " << this->GetFileName() << ":\n" << err);
+      }
+      this->SetDataFileLocation(fileNio);
+      dataByteOrder = NrrdToITKByteOrder(fileNio->endian);
+      nrrdNix(fileNrrd);
+      nrrdIoStateNix(fileNio);
+
+      if (m_DataFileEncoding != nrrdEncodingRaw)
+      {
+        itkExceptionMacro("Write: Can only paste into uncompressed data in a single file, which "
+                          << this->GetFileName() << " does not have");
+      }
+    }
+
+    std::ofstream file;
+    this->OpenFileForWriting(file, m_DataFileName, false);
+
+    const SizeValueType numberOfComponents = this->GetIORegion().GetNumberOfPixels() * this->GetNumberOfComponents();
+    const bool          swap =
+      this->GetComponentSize() > 1 &&
+      ((dataByteOrder == IOByteOrderEnum::BigEndian && !ByteSwapper<uint16_t>::SystemIsBigEndian()) ||
+       (dataByteOrder == IOByteOrderEnum::LittleEndian && ByteSwapper<uint16_t>::SystemIsBigEndian()));
+    if (swap)
+    {
+      const auto *      bytes = static_cast<const char *>(buffer);
+      std::vector<char> swapped(bytes, bytes + numberOfComponents * this->GetComponentSize());
+      SwapComponentsFromSystemTo(dataByteOrder, swapped.data(), this->GetComponentSize(), numberOfComponents);
+      this->StreamWriteBufferAsBinary(file, swapped.data());
+    }
+    else
+    {
+      this->StreamWriteBufferAsBinary(file, buffer);
+    }
+  }
   // Write the nrrd to file.
-  if (nrrdSave(this->GetFileName(), nrrd, nio))
+  else if (nrrdSave(this->GetFileName(), nrrd, nio))
   {
     char * err = biffGetDone(NRRD); // would be nice to free(err)
     itkExceptionMacro("Write: Error writing " << this->GetFileName() << ":\n" << err);
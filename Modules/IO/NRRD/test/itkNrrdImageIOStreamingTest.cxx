@@ -0,0 +1,167 @@
+/*=========================================================================
+ *
+ *  Copyright NumFOCUS
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include "itkImageFileReader.h"
+#include "itkImageFileWriter.h"
+#include "itkImageRegionConstIteratorWithIndex.h"
+#include "itkImageRegionIteratorWithIndex.h"
+#include "itkNrrdImageIO.h"
+#include "itkPipelineMonitorImageFilter.h"
+#include "itkTestingMacros.h"
+
+namespace
+{
+using PixelType = short;
+using ImageType = itk::Image<PixelType, 3>;
+
+PixelType
+ExpectedValue(const ImageType::IndexType & index)
+{
+  return static_cast<PixelType>(index[0] - 13 * index[1] + 251 * index[2]);
+}
+
+bool
+VerifyRegion(const ImageType * image, const ImageType::RegionType & region)
+{
+  itk::ImageRegionConstIteratorWithIndex<ImageType> it(image, region);
+  for (; !it.IsAtEnd(); ++it)
+  {
+    if (it.Get() != ExpectedValue(it.GetIndex()))
+    {
+      std::cerr << "Error in pixel value at index " << it.GetIndex() << std::endl;
+      std::cerr << "Expected: " << ExpectedValue(it.GetIndex()) << ", but got: " << it.Get() << std::endl;
+      return false;
+    }
+  }
+  return true;
+}
+} // namespace
+
+// Writes a nrrd file, streams it through a pipeline into a second nrrd
+// file, and reads regions of the first file out of order.
+int
+itkNrrdImageIOStreamingTest(int argc, char * argv[])
+{
+  if (argc < 4)
+  {
+    std::cerr << "Missing parameters." << std::endl;
+    std::cerr << "Usage: " << itkNameOfTestExecutableMacro(argv);
+    std::cerr << " input output useCompression" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  using ReaderType = itk::ImageFileReader<ImageType>;
+  using WriterType = itk::ImageFileWriter<ImageType>;
+
+  const bool useCompression = std::stoi(argv[3]) != 0;
+
+  ImageType::Pointer  image = ImageType::New();
+  ImageType::SizeType size = { { 23, 17, 11 } };
+  image->SetRegions(size);
+  image->Allocate();
+
+  itk::ImageRegionIteratorWithIndex<ImageType> it(image, image->GetLargestPossibleRegion());
+  for (it.GoToBegin(); !it.IsAtEnd(); ++it)
+  {
+    it.Set(ExpectedValue(it.GetIndex()));
+  }
+
+  WriterType::Pointer inputWriter = WriterType::New();
+  inputWriter->SetFileName(argv[1]);
+  inputWriter->SetInput(image);
+  inputWriter->SetUseCompression(useCompression);
+  ITK_TRY_EXPECT_NO_EXCEPTION(inputWriter->Update());
+
+  itk::NrrdImageIO::Pointer io = itk::NrrdImageIO::New();
+  io->SetFileName(argv[1]);
+  ITK_TRY_EXPECT_NO_EXCEPTION(io->ReadImageInformation());
+  ITK_TEST_EXPECT_TRUE(io->CanStreamRead());
+
+  // Stream the file into a second file
+  const unsigned int numberOfDataPieces = 4;
+
+  ReaderType::Pointer reader = ReaderType::New();
+  reader->SetFileName(argv[1]);
+  reader->SetUseStreaming(true);
+
+  using MonitorFilter = itk::PipelineMonitorImageFilter<ImageType>;
+  MonitorFilter::Pointer monitor = MonitorFilter::New();
+  monitor->SetInput(reader->GetOutput());
+
+  WriterType::Pointer writer = WriterType::New();
+  writer->SetFileName(argv[2]);
+  writer->SetInput(monitor->GetOutput());
+  writer->SetNumberOfStreamDivisions(numberOfDataPieces);
+  ITK_TRY_EXPECT_NO_EXCEPTION(writer->Update());
+
+  if (!monitor->VerifyAllInputCanStream(numberOfDataPieces))
+  {
+    std::cout << monitor << std::endl;
+    std::cerr << "Test failed!" << std::endl;
+    std::cerr << "Pipeline did not execute as expected!" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  ReaderType::Pointer outputReader = ReaderType::New();
+  outputReader->SetFileName(argv[2]);
+  ITK_TRY_EXPECT_NO_EXCEPTION(outputReader->Update());
+
+  if (outputReader->GetOutput()->GetLargestPossibleRegion() != image->GetLargestPossibleRegion() ||
+      !VerifyRegion(outputReader->GetOutput(), image->GetLargestPossibleRegion()))
+  {
+    std::cerr << "Test failed!" << std::endl;
+    std::cerr << "Error in streamed output " << argv[2] << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  // Read regions backwards, which restarts the decompression of
+  // compressed data
+  ReaderType::Pointer regionReader = ReaderType::New();
+  regionReader->SetFileName(argv[1]);
+  regionReader->SetUseStreaming(true);
+  ITK_TRY_EXPECT_NO_EXCEPTION(regionReader->UpdateOutputInformation());
+
+  for (int slice = static_cast<int>(size[2]) - 2; slice >= 0; slice -= 3)
+  {
+    ImageType::IndexType  index = { { 3, 2, slice } };
+    ImageType::SizeType   regionSize = { { 11, 9, 2 } };
+    ImageType::RegionType region(index, regionSize);
+
+    regionReader->GetOutput()->SetRequestedRegion(region);
+    ITK_TRY_EXPECT_NO_EXCEPTION(regionReader->Update());
+
+    if (regionReader->GetOutput()->GetBufferedRegion() != region ||
+        !VerifyRegion(regionReader->GetOutput(), region))
+    {
+      std::cerr << "Test failed!" << std::endl;
+      std::cerr << "Error reading region " << region << " of " << argv[1] << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+
+  // The leading bytes of a file decide whether it is a nrrd file
+  itk::NrrdImageIO::Pointer nrrdIO = itk::NrrdImageIO::New();
+  const char                nrrdHeader[] = "NRRD0004";
+  const char                metaHeader[] = "ObjectType = Image";
+  ITK_TEST_EXPECT_TRUE(nrrdIO->CanReadFileHeader(argv[1], nrrdHeader, sizeof(nrrdHeader) - 1));
+  ITK_TEST_EXPECT_TRUE(!nrrdIO->CanReadFileHeader(argv[1], metaHeader, sizeof(metaHeader) - 1));
+  ITK_TEST_EXPECT_TRUE(!nrrdIO->CanReadFileHeader(argv[1], nrrdHeader, 2));
+
+  std::cout << "Test finished." << std::endl;
+  return EXIT_SUCCESS;
+}
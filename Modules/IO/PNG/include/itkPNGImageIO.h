@@ -78,6 +78,11 @@ public:
   bool
   CanReadFile(const char *) override;
 
+  /** Reject the files which do not start with the eight bytes of the PNG
+   * signature, without opening them. */
+  bool
+  CanReadFileHeader(const char * fileName, const char * header, SizeValueType length) override;
+
   /** Set the spacing and dimension information for the set filename. */
   void
   ReadImageInformation() override;
@@ -19,6 +19,7 @@
 #include "itk_png.h"
 #include "itksys/SystemTools.hxx"
 #include <string>
+#include <cstring>
 #include <csetjmp>
 
 namespace itk
@@ -130,6 +131,16 @@ PNGImageIO::CanReadFile(const char * file)
   return true;
 }
 
+bool
+PNGImageIO::CanReadFileHeader(const char * file, const char * header, SizeValueType length)
+{
+  if (length < 8 || std::memcmp(header, "\x89PNG\r\n\x1a\n", 8) != 0)
+  {
+    return false;
+  }
+  return this->CanReadFile(file);
+}
+
 void
 PNGImageIO::ReadVolume(void *)
 {}
@@ -23,6 +23,7 @@
 #include "itkLinearInterpolateImageFunction.h"
 #include "itkCentralDifferenceImageFunction.h"
 #include <mutex>
+#include <typeinfo>
 
 namespace itk
 {
@@ -161,6 +162,25 @@ public:
                 void *                   globalData,
                 const FloatOffsetType &  offset = FloatOffsetType(0.0)) override;
 
+  /** True for DemonsRegistrationFunction itself only: a subclass may
+   * override ComputeUpdate(), which the span would then bypass. */
+  bool
+  SupportsComputeUpdateSpan() const override
+  {
+    return typeid(*this) == typeid(Self);
+  }
+
+  /** This method is called by a finite difference solver image filter for
+   * each line of pixels that do not lie on a data set boundary.  The
+   * gradient of the fixed image is computed from its pixel buffer, a block
+   * of pixels at a time. */
+  void
+  ComputeUpdateSpan(const DisplacementFieldType * field,
+                    const IndexType &             index,
+                    SizeValueType                 length,
+                    PixelType *                   updates,
+                    void *                        globalData) override;
+
   /** Get the metric value. The metric value is the mean square difference
    * in intensity between the fixed image and transforming moving image
    * computed over the the overlapping region between the two images. */
@@ -220,6 +240,11 @@ protected:
   };
 
 private:
+  /** Compute the update from the difference between the fixed and moving
+   * values and the gradient, and update the metric. */
+  PixelType
+  ComputeUpdateFromGradient(double speedValue, const CovariantVectorType & gradient, void * globalData) const;
+
   /** Cache fixed image information. */
   // SpacingType                  m_FixedImageSpacing;
   // PointType                    m_FixedImageOrigin;
@@ -21,6 +21,7 @@
 #include "itkDemonsRegistrationFunction.h"
 #include "itkMacro.h"
 #include "itkMath.h"
+#include <algorithm>
 
 namespace itk
 {
@@ -201,6 +202,133 @@ DemonsRegistrationFunction<TFixedImage, TMovingImage, TDisplacementField>::Compu
     gradient = m_MovingImageGradientCalculator->Evaluate(mappedPoint);
   }
 
+  return this->ComputeUpdateFromGradient(fixedValue - movingValue, gradient, gd);
+}
+
+/**
+ * Compute the updates along a line of pixels
+ */
+template <typename TFixedImage, typename TMovingImage, typename TDisplacementField>
+void
+DemonsRegistrationFunction<TFixedImage, TMovingImage, TDisplacementField>::ComputeUpdateSpan(
+  const DisplacementFieldType * field,
+  const IndexType &             index,
+  SizeValueType                 length,
+  PixelType *                   updates,
+  void *                        gd)
+{
+  const FixedImageType * const  fixedImage = this->GetFixedImage();
+  const auto * const            fixedPixels = fixedImage->GetBufferPointer() + fixedImage->ComputeOffset(index);
+  const OffsetValueType * const fixedStride = fixedImage->GetOffsetTable();
+  const PixelType * const       displacements = field->GetBufferPointer() + field->ComputeOffset(index);
+
+  // The central differences of the fixed image as computed by its gradient
+  // calculator, which are zero on the boundary of the buffer: the range of
+  // the line inside of the boundary, and the scales by the spacing
+  const typename FixedImageType::RegionType & fixedRegion = fixedImage->GetBufferedRegion();
+  OffsetValueType                             insideBegin[ImageDimension];
+  OffsetValueType                             insideEnd[ImageDimension];
+  double                                      derivativeScale[ImageDimension];
+  for (unsigned int dim = 0; dim < ImageDimension; ++dim)
+  {
+    const IndexValueType lower = fixedRegion.GetIndex(dim) + 1;
+    const IndexValueType upper = fixedRegion.GetIndex(dim) + static_cast<OffsetValueType>(fixedRegion.GetSize(dim)) - 2;
+    if (dim == 0)
+    {
+      insideBegin[dim] = lower - index[0];
+      insideEnd[dim] = upper + 1 - index[0];
+    }
+    else
+    {
+      const bool inside = index[dim] >= lower && index[dim] <= upper;
+      insideBegin[dim] = 0;
+      insideEnd[dim] = inside ? static_cast<OffsetValueType>(length) : 0;
+    }
+    derivativeScale[dim] = 0.5 / fixedImage->GetSpacing()[dim];
+  }
+  const bool useImageDirection = m_FixedImageGradientCalculator->GetUseImageDirection();
+
+  constexpr OffsetValueType blockLength = 64;
+  double                    derivative[ImageDimension][blockLength];
+
+  IndexType pixelIndex = index;
+  for (OffsetValueType start = 0; start < static_cast<OffsetValueType>(length); start += blockLength)
+  {
+    const OffsetValueType n = std::min(blockLength, static_cast<OffsetValueType>(length) - start);
+
+    // The derivatives of the block, along each dimension in turn
+    if (!m_UseMovingImageGradient)
+    {
+      for (unsigned int dim = 0; dim < ImageDimension; ++dim)
+      {
+        const auto * const    f = fixedPixels + start;
+        const OffsetValueType s = fixedStride[dim];
+        const OffsetValueType begin = std::min(std::max<OffsetValueType>(insideBegin[dim] - start, 0), n);
+        const OffsetValueType end = std::min(std::max<OffsetValueType>(insideEnd[dim] - start, begin), n);
+        std::fill_n(derivative[dim], n, 0.0);
+        for (OffsetValueType k = begin; k < end; ++k)
+        {
+          derivative[dim][k] = f[k + s];
+          derivative[dim][k] -= f[k - s];
+          derivative[dim][k] *= derivativeScale[dim];
+        }
+      }
+    }
+
+    for (OffsetValueType k = 0; k < n; ++k)
+    {
+      const OffsetValueType pixel = start + k;
+      pixelIndex[0] = index[0] + pixel;
+      const auto fixedValue = static_cast<double>(fixedPixels[pixel]);
+
+      PointType mappedPoint;
+      fixedImage->TransformIndexToPhysicalPoint(pixelIndex, mappedPoint);
+      for (unsigned int j = 0; j < ImageDimension; ++j)
+      {
+        mappedPoint[j] += displacements[pixel][j];
+      }
+
+      if (!m_MovingImageInterpolator->IsInsideBuffer(mappedPoint))
+      {
+        updates[pixel] = m_ZeroUpdateReturn;
+        continue;
+      }
+      const double movingValue = m_MovingImageInterpolator->Evaluate(mappedPoint);
+
+      CovariantVectorType gradient;
+      if (!m_UseMovingImageGradient)
+      {
+        CovariantVectorType localGradient;
+        for (unsigned int dim = 0; dim < ImageDimension; ++dim)
+        {
+          localGradient[dim] = derivative[dim][k];
+        }
+        if (useImageDirection)
+        {
+          fixedImage->TransformLocalVectorToPhysicalVector(localGradient, gradient);
+        }
+        else
+        {
+          gradient = localGradient;
+        }
+      }
+      else
+      {
+        gradient = m_MovingImageGradientCalculator->Evaluate(mappedPoint);
+      }
+
+      updates[pixel] = this->ComputeUpdateFromGradient(fixedValue - movingValue, gradient, gd);
+    }
+  }
+}
+
+template <typename TFixedImage, typename TMovingImage, typename TDisplacementField>
+typename DemonsRegistrationFunction<TFixedImage, TMovingImage, TDisplacementField>::PixelType
+DemonsRegistrationFunction<TFixedImage, TMovingImage, TDisplacementField>::ComputeUpdateFromGradient(
+  double                      speedValue,
+  const CovariantVectorType & gradient,
+  void *                      gd) const
+{
   double gradientSquaredMagnitude = 0;
   for (unsigned int j = 0; j < ImageDimension; j++)
   {
@@ -218,7 +346,6 @@ DemonsRegistrationFunction<TFixedImage, TMovingImage, TDisplacementField>::Compu
    * such that denominator = (g-f)^2/K + grad_mag^2
    * where K = mean square spacing to compensate for the mismatch in units.
    */
-  const double speedValue = fixedValue - movingValue;
   const double sqr_speedValue = itk::Math::sqr(speedValue);
 
   // update the metric
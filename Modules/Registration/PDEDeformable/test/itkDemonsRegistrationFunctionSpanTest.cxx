@@ -0,0 +1,208 @@
+/*=========================================================================
+ *
+ *  Copyright NumFOCUS
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include "itkDemonsRegistrationFilter.h"
+#include "itkImageRegionIteratorWithIndex.h"
+#include "itkTimeProbe.h"
+#include <atomic>
+#include <cmath>
+
+namespace
+{
+// A subclass which only overrides ComputeUpdate(), so that the solver calls
+// it at each pixel rather than computing the updates of whole lines
+template <typename TFixedImage, typename TMovingImage, typename TDisplacementField>
+class PerPixelDemonsRegistrationFunction
+  : public itk::DemonsRegistrationFunction<TFixedImage, TMovingImage, TDisplacementField>
+{
+public:
+  ITK_DISALLOW_COPY_AND_ASSIGN(PerPixelDemonsRegistrationFunction);
+
+  using Self = PerPixelDemonsRegistrationFunction;
+  using Superclass = itk::DemonsRegistrationFunction<TFixedImage, TMovingImage, TDisplacementField>;
+  using Pointer = itk::SmartPointer<Self>;
+  using PixelType = typename Superclass::PixelType;
+  using NeighborhoodType = typename Superclass::NeighborhoodType;
+  using FloatOffsetType = typename Superclass::FloatOffsetType;
+
+  itkNewMacro(Self);
+
+  PixelType
+  ComputeUpdate(const NeighborhoodType & neighborhood,
+                void *                   globalData,
+                const FloatOffsetType &  offset = FloatOffsetType(0.0)) override
+  {
+    ++m_NumberOfComputedUpdates;
+    return Superclass::ComputeUpdate(neighborhood, globalData, offset);
+  }
+
+  std::atomic<itk::SizeValueType> m_NumberOfComputedUpdates{ 0 };
+
+protected:
+  PerPixelDemonsRegistrationFunction() = default;
+};
+
+// A smooth blob centered at the given point, on a rotated grid
+template <typename TImage>
+typename TImage::Pointer
+CreateImage(const typename TImage::SizeType & size, double center)
+{
+  constexpr unsigned int Dimension = TImage::ImageDimension;
+
+  auto image = TImage::New();
+  image->SetRegions(size);
+  typename TImage::SpacingType spacing;
+  for (unsigned int d = 0; d < Dimension; ++d)
+  {
+    spacing[d] = 1.0 + 0.25 * d;
+  }
+  image->SetSpacing(spacing);
+  typename TImage::DirectionType direction;
+  direction.SetIdentity();
+  direction[0][0] = direction[1][1] = std::cos(0.3);
+  direction[0][1] = -std::sin(0.3);
+  direction[1][0] = std::sin(0.3);
+  image->SetDirection(direction);
+  image->Allocate();
+
+  itk::ImageRegionIteratorWithIndex<TImage> it(image, image->GetLargestPossibleRegion());
+  for (; !it.IsAtEnd(); ++it)
+  {
+    double squaredDistance = 0.0;
+    for (unsigned int d = 0; d < Dimension; ++d)
+    {
+      const double x = (it.GetIndex()[d] - center * size[d]) / size[d];
+      squaredDistance += x * x * (1.0 + 0.5 * d);
+    }
+    it.Set(static_cast<typename TImage::PixelType>(100.0 * std::exp(-8.0 * squaredDistance)));
+  }
+  return image;
+}
+
+template <typename TImage>
+bool
+CompareImages(const TImage * image, const TImage * reference, const std::string & description)
+{
+  itk::ImageRegionConstIteratorWithIndex<TImage> it(image, reference->GetLargestPossibleRegion());
+  itk::ImageRegionConstIterator<TImage>          referenceIt(reference, reference->GetLargestPossibleRegion());
+  for (; !referenceIt.IsAtEnd(); ++it, ++referenceIt)
+  {
+    if (it.Get() != referenceIt.Get())
+    {
+      std::cerr << "Test failed for " << description << std::endl;
+      std::cerr << "Error at index " << it.GetIndex() << std::endl;
+      std::cerr << "Expected: " << referenceIt.Get() << ", but got: " << it.Get() << std::endl;
+      return false;
+    }
+  }
+  return true;
+}
+
+// Compares the registration computed a line at a time with the one computed
+// a pixel at a time, with the gradient of either image, and prints the time
+// of both
+template <unsigned int VDimension>
+bool
+CheckSpans(const itk::Size<VDimension> & size, const std::string & description)
+{
+  using ImageType = itk::Image<float, VDimension>;
+  using DisplacementFieldType = itk::Image<itk::Vector<float, VDimension>, VDimension>;
+  using FilterType = itk::DemonsRegistrationFilter<ImageType, ImageType, DisplacementFieldType>;
+  using PerPixelFunctionType = PerPixelDemonsRegistrationFunction<ImageType, ImageType, DisplacementFieldType>;
+
+  const typename ImageType::Pointer fixedImage = CreateImage<ImageType>(size, 0.45);
+  const typename ImageType::Pointer movingImage = CreateImage<ImageType>(size, 0.55);
+
+  bool passed = true;
+  for (bool useMovingImageGradient : { false, true })
+  {
+    const std::string name = description + (useMovingImageGradient ? ", moving image gradient" : "");
+
+    typename FilterType::Pointer filters[2];
+    for (typename FilterType::Pointer & filter : filters)
+    {
+      filter = FilterType::New();
+      filter->SetFixedImage(fixedImage);
+      filter->SetMovingImage(movingImage);
+      filter->SetNumberOfIterations(5);
+      filter->SetStandardDeviations(1.0);
+      filter->SetUseMovingImageGradient(useMovingImageGradient);
+    }
+    const auto perPixelFunction = PerPixelFunctionType::New();
+    filters[1]->SetDifferenceFunction(perPixelFunction);
+
+    itk::TimeProbe perPixelProbe;
+    perPixelProbe.Start();
+    filters[1]->Update();
+    perPixelProbe.Stop();
+
+    itk::TimeProbe probe;
+    probe.Start();
+    filters[0]->Update();
+    probe.Stop();
+
+    std::cout << name << ": " << probe.GetTotal() << " s, a pixel at a time " << perPixelProbe.GetTotal()
+              << " s, metric " << filters[0]->GetMetric() << std::endl;
+    if (filters[0]->GetMetric() != filters[1]->GetMetric() || filters[0]->GetRMSChange() != filters[1]->GetRMSChange())
+    {
+      std::cerr << "Test failed for " << name << std::endl;
+      std::cerr << "Expected metric " << filters[1]->GetMetric() << " and RMS change " << filters[1]->GetRMSChange()
+                << ", but got " << filters[0]->GetMetric() << " and " << filters[0]->GetRMSChange() << std::endl;
+      passed = false;
+    }
+    passed &= CompareImages<DisplacementFieldType>(filters[0]->GetOutput(), filters[1]->GetOutput(), name);
+
+    // The ComputeUpdate() of the subclass was not bypassed
+    const itk::SizeValueType numberOfUpdates = 5 * fixedImage->GetLargestPossibleRegion().GetNumberOfPixels();
+    if (perPixelFunction->m_NumberOfComputedUpdates != numberOfUpdates)
+    {
+      std::cerr << "Test failed for " << name << std::endl;
+      std::cerr << "The subclass computed " << perPixelFunction->m_NumberOfComputedUpdates << " updates instead of "
+                << numberOfUpdates << std::endl;
+      passed = false;
+    }
+  }
+  return passed;
+}
+} // namespace
+
+// Checks that the demons registration computed a line at a time from the
+// pixel buffers gives the same displacement field and metric as the one
+// computed a pixel at a time.
+int
+itkDemonsRegistrationFunctionSpanTest(int, char *[])
+{
+  bool passed = true;
+
+  // Only the class which implements the span uses it
+  using ImageType = itk::Image<float, 2>;
+  using DisplacementFieldType = itk::Image<itk::Vector<float, 2>, 2>;
+  using FunctionType = itk::DemonsRegistrationFunction<ImageType, ImageType, DisplacementFieldType>;
+  using PerPixelFunctionType = PerPixelDemonsRegistrationFunction<ImageType, ImageType, DisplacementFieldType>;
+  if (!FunctionType::New()->SupportsComputeUpdateSpan() || PerPixelFunctionType::New()->SupportsComputeUpdateSpan())
+  {
+    std::cerr << "Test failed: the span is not used by the function only" << std::endl;
+    passed = false;
+  }
+
+  passed &= CheckSpans<2>(itk::Size<2>{ { 150, 97 } }, "2D");
+  passed &= CheckSpans<3>(itk::Size<3>{ { 70, 41, 23 } }, "3D");
+
+  std::cout << "Test finished." << std::endl;
+  return passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -19,6 +19,7 @@
 #define itkConnectedComponentImageFilter_h
 
 #include "itkScanlineFilterCommon.h"
+#include <memory>
 
 namespace itk
 {
@@ -41,11 +42,18 @@ namespace itk
  * component image filter which did not produce consecutive labels or
  * impose any particular ordering.
  *
- * After the filter is executed, ObjectCount holds the number of connected components.
+ * After the filter is executed, ObjectCount holds the number of connected components,
+ * and GetSizeOfObjectsInPixels() their sizes in raster order. With the default
+ * background value, these sizes can be passed to
+ * RelabelComponentImageFilter::SetSizeOfInputObjectsInPixels() so that the
+ * objects are sorted by size without another pass over the image.
  *
- * \sa ImageToImageFilter
+ * All the phases of the filter are multithreaded: the lines are run length
+ * encoded in parallel, then linked with a lock free union-find, and the
+ * consecutive labels and the object sizes are computed in parallel too.
+ *
+ * \sa ImageToImageFilter, RelabelComponentImageFilter
  *
- * \ingroup SingleThreaded
  * \ingroup ITKConnectedComponents
  *
  * \sphinx
@@ -139,6 +147,21 @@ public:
   // only set after completion
   itkGetConstReferenceMacro(ObjectCount, LabelType);
 
+  /** Type used to count the number of pixels in objects. */
+  using ObjectSizeType = SizeValueType;
+  using ObjectSizeInPixelsContainerType = std::vector<ObjectSizeType>;
+
+  /** Get the size in pixels of each object, in the order of their labels.
+   * This information is only valid after the filter has executed. The
+   * size of the background is not calculated. */
+  const ObjectSizeInPixelsContainerType &
+  GetSizeOfObjectsInPixels() const
+  {
+    // The GetConstReferenceMacro can't be used here because this container
+    // doesn't have an ostream<< operator overloaded.
+    return this->m_SizeOfObjectsInPixels;
+  }
+
   itkConceptMacro(OutputImagePixelTypeIsInteger, (Concept::IsInteger<OutputImagePixelType>));
 
   itkSetInputMacro(MaskImage, MaskImageType);
@@ -200,6 +223,9 @@ private:
   OutputPixelType m_BackgroundValue = NumericTraits<OutputPixelType>::ZeroValue();
   LabelType       m_ObjectCount = 0;
 
+  ObjectSizeInPixelsContainerType                m_SizeOfObjectsInPixels;
+  std::unique_ptr<std::atomic<ObjectSizeType>[]> m_ObjectSizeCounters;
+
   typename TInputImage::ConstPointer m_Input;
 };
 } // end namespace itk
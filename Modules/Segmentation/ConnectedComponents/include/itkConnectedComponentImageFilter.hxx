@@ -118,20 +118,15 @@ ConnectedComponentImageFilter<TInputImage, TOutputImage, TMaskImage>::GenerateDa
   // saves complicating the ones that come later
   this->InitUnion(nbOfLabels);
 
-  ProgressTransformer progress2(0.55f, 0.6f, this);
+  // The union-find is lock free, so all the lines can be linked to their
+  // previous neighbor lines at once
+  ProgressTransformer progress2(0.55f, 0.75f, this);
   multiThreader->ParallelizeArray(
     0,
-    this->m_WorkUnitResults.size(),
-    [this](SizeValueType index) { this->ComputeEquivalence(index, true); },
+    this->m_LineMap.size(),
+    [this](SizeValueType lineIndex) { this->ComputeLineEquivalence(lineIndex); },
     progress2.GetProcessObject());
 
-  ProgressTransformer progress3(0.6f, 0.75f, this);
-  multiThreader->ParallelizeArray(
-    0,
-    this->m_WorkUnitResults.size(),
-    [this](SizeValueType index) { this->ComputeEquivalence(index, false); },
-    progress3.GetProcessObject());
-
   // AfterThreadedGenerateData
   SizeValueType numberOfObjects = this->CreateConsecutive(m_BackgroundValue);
   itkAssertOrThrowMacro(numberOfObjects <= this->m_NumberOfLabels,
@@ -146,12 +141,22 @@ ConnectedComponentImageFilter<TInputImage, TOutputImage, TMaskImage>::GenerateDa
   }
   m_ObjectCount = numberOfObjects;
 
-  ProgressTransformer progress4(0.75f, 1.0f, this);
+  // the object sizes are accumulated while writing the output
+  m_ObjectSizeCounters.reset(new std::atomic<ObjectSizeType>[numberOfObjects]());
+
+  ProgressTransformer progress3(0.75f, 1.0f, this);
   multiThreader->template ParallelizeImageRegionRestrictDirection<TOutputImage::ImageDimension>(
     0,
     requestedRegion,
     [this](const RegionType & lambdaRegion) { this->ThreadedWriteOutput(lambdaRegion); },
-    progress4.GetProcessObject());
+    progress3.GetProcessObject());
+
+  m_SizeOfObjectsInPixels.resize(numberOfObjects);
+  for (SizeValueType i = 0; i < numberOfObjects; ++i)
+  {
+    m_SizeOfObjectsInPixels[i] = m_ObjectSizeCounters[i].load(std::memory_order_relaxed);
+  }
+  m_ObjectSizeCounters.reset();
 
   // clear and make sure memory is freed
   std::deque<WorkUnitData>().swap(this->m_WorkUnitResults);
@@ -233,12 +238,28 @@ ConnectedComponentImageFilter<TInputImage, TOutputImage, TMaskImage>::ThreadedWr
 
   WorkUnitData workUnitData = this->CreateWorkUnitData(outputRegionForThread);
 
+  // Consecutive runs mostly belong to the same object, so the size of an
+  // object is accumulated locally until a run of another object is found.
+  SizeValueType  currentObject = NumericTraits<SizeValueType>::max();
+  ObjectSizeType currentObjectSize = 0;
+
   for (SizeValueType thisIdx = workUnitData.firstLine; thisIdx <= workUnitData.lastLine; thisIdx++)
   {
     for (LineEncodingConstIterator cIt = this->m_LineMap[thisIdx].begin(); cIt != this->m_LineMap[thisIdx].end(); ++cIt)
     {
       const SizeValueType   Ilab = this->LookupSet(cIt->label);
       const OutputPixelType lab = this->m_Consecutive[Ilab];
+      const SizeValueType   object = this->LabelToObjectIndex(lab, m_BackgroundValue);
+      if (object != currentObject)
+      {
+        if (currentObjectSize > 0)
+        {
+          m_ObjectSizeCounters[currentObject].fetch_add(currentObjectSize, std::memory_order_relaxed);
+        }
+        currentObject = object;
+        currentObjectSize = 0;
+      }
+      currentObjectSize += cIt->length;
       oit.SetIndex(cIt->where);
       // initialize the non labelled pixels
       for (; fstart != oit; ++fstart)
@@ -254,6 +275,11 @@ ConnectedComponentImageFilter<TInputImage, TOutputImage, TMaskImage>::ThreadedWr
     }
   }
 
+  if (currentObjectSize > 0)
+  {
+    m_ObjectSizeCounters[currentObject].fetch_add(currentObjectSize, std::memory_order_relaxed);
+  }
+
   // fill the rest of the output region with background value
   for (; fstart != fend; ++fstart)
   {
@@ -56,6 +56,12 @@ namespace itk
  * GetSizeOfObjectsInPixels()[0], the size of object #2 is
  * GetSizeOfObjectsInPixels()[1], etc.
  *
+ * When the sizes of the input objects are already known, as from
+ * ConnectedComponentImageFilter::GetSizeOfObjectsInPixels(), they can be
+ * given with SetSizeOfInputObjectsInPixels(). The filter then skips the
+ * pass over the input which counts the pixels of each label, unless the
+ * input was modified since the sizes were set.
+ *
  * If user sets a minimum object size, all objects with fewer pixels
  * than the minimum will be discarded, so that the number of objects
  * reported will be only those remaining. The
@@ -177,6 +183,30 @@ public:
   itkGetConstMacro(SortByObjectSize, bool);
   itkBooleanMacro(SortByObjectSize);
 
+  /** Set the size in pixels of the objects of the input, so that the
+   * filter doesn't have to count them. The size of the input label #1 is
+   * sizes[0], the size of label #2 is sizes[1], etc., and labels with a
+   * size of zero are not in the input. The sizes must describe the input
+   * exactly, as from ConnectedComponentImageFilter with a background
+   * value of zero. An empty container, the default, means that the sizes
+   * are counted from the input. The sizes are ignored, and counted from
+   * the input, when the input was modified after they were set. */
+  void
+  SetSizeOfInputObjectsInPixels(const ObjectSizeInPixelsContainerType & sizes)
+  {
+    m_SizeOfInputObjectsInPixelsTime.Modified();
+    if (sizes != m_SizeOfInputObjectsInPixels)
+    {
+      m_SizeOfInputObjectsInPixels = sizes;
+      this->Modified();
+    }
+  }
+  const ObjectSizeInPixelsContainerType &
+  GetSizeOfInputObjectsInPixels() const
+  {
+    return m_SizeOfInputObjectsInPixels;
+  }
+
   /** Get the size of each object in pixels. This information is only
    * valid after the filter has executed.  Size of the background is
    * not calculated.  Size of object #1 is
@@ -294,6 +324,8 @@ private:
 
   ObjectSizeInPixelsContainerType        m_SizeOfObjectsInPixels;
   ObjectSizeInPhysicalUnitsContainerType m_SizeOfObjectsInPhysicalUnits;
+  ObjectSizeInPixelsContainerType        m_SizeOfInputObjectsInPixels;
+  TimeStamp                              m_SizeOfInputObjectsInPixelsTime;
 };
 } // end namespace itk
 
@@ -140,11 +140,31 @@ RelabelComponentImageFilter<TInputImage, TOutputImage>::GenerateData()
     physicalPixelSize *= input->GetSpacing()[i];
   }
 
-  // Walk the entire input image and compute used labels and the number of each label.
-  this->GetMultiThreader()->template ParallelizeImageRegion<ImageDimension>(
-    input->GetRequestedRegion(),
-    [this](const RegionType & inputRegion) { this->ParallelComputeLabels(inputRegion); },
-    nullptr);
+  // The sizes which were set describe the input as it was when they were
+  // set, so they are stale once it is modified, e.g. by an update of the
+  // filter which computed them.
+  if (m_SizeOfInputObjectsInPixels.empty() || input->GetMTime() > m_SizeOfInputObjectsInPixelsTime.GetMTime())
+  {
+    // Walk the entire input image and compute used labels and the number of each label.
+    this->GetMultiThreader()->template ParallelizeImageRegion<ImageDimension>(
+      input->GetRequestedRegion(),
+      [this](const RegionType & inputRegion) { this->ParallelComputeLabels(inputRegion); },
+      nullptr);
+  }
+  else
+  {
+    // The sizes are known, there is no need to walk the input
+    MapType().swap(m_SizeMap);
+    for (SizeValueType i = 0; i < m_SizeOfInputObjectsInPixels.size(); ++i)
+    {
+      if (m_SizeOfInputObjectsInPixels[i] > 0)
+      {
+        RelabelComponentObjectType object;
+        object.m_SizeInPixels = m_SizeOfInputObjectsInPixels[i];
+        m_SizeMap.insert(m_SizeMap.end(), { static_cast<LabelType>(i + 1), object });
+      }
+    }
+  }
 
 
   // Construct an array of the label, component information pair to sort
@@ -279,6 +299,7 @@ RelabelComponentImageFilter<TInputImage, TOutputImage>::PrintSelf(std::ostream &
   os << indent << "NumberOfObjectsToPrint: " << m_NumberOfObjectsToPrint << std::endl;
   os << indent << "MinimumObjectSizes: " << m_MinimumObjectSize << std::endl;
   os << indent << "SortByObjectSize: " << m_SortByObjectSize << std::endl;
+  os << indent << "SizeOfInputObjectsInPixels: " << m_SizeOfInputObjectsInPixels.size() << " objects" << std::endl;
 
   typename ObjectSizeInPixelsContainerType::const_iterator it;
   ObjectSizeInPhysicalUnitsContainerType::const_iterator   fit;
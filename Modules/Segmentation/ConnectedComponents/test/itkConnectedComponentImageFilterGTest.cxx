@@ -23,8 +23,10 @@ using itk::print_helper::operator<<;
 #include "itkGTest.h"
 #include "itkImage.h"
 #include "itkConnectedComponentImageFilter.h"
+#include "itkRelabelComponentImageFilter.h"
 
 #include <bitset>
+#include <map>
 
 namespace
 {
@@ -50,6 +52,30 @@ CreateTestImageA()
 
   return image;
 }
+
+// A noisy binary image with many tangled objects
+typename itk::Image<unsigned char, 3>::Pointer
+CreateTestImageB()
+{
+  using namespace itk::GTest::TypedefsAndConstructors::Dimension3;
+
+  using PixelType = unsigned char;
+  using ImageType = itk::Image<PixelType, Dimension>;
+
+  auto image = ImageType::New();
+  image->SetRegions(ImageType::RegionType(MakeSize(37u, 23u, 19u)));
+  image->Allocate();
+
+  unsigned int                        seed = 12345;
+  itk::ImageRegionIterator<ImageType> it(image, image->GetLargestPossibleRegion());
+  for (; !it.IsAtEnd(); ++it)
+  {
+    seed = 1103515245u * seed + 12345u;
+    it.Set(((seed >> 16) % 100) < 35 ? 1 : 0);
+  }
+
+  return image;
+}
 } // namespace
 
 
@@ -84,3 +110,158 @@ TEST(ConnectedComponentImageFilter, checkerboard_3D)
   ++it;
   EXPECT_TRUE(it.IsAtEnd());
 }
+
+
+TEST(ConnectedComponentImageFilter, work_units_and_object_sizes)
+{
+  auto image = CreateTestImageB();
+  using ImageType = decltype(image)::ObjectType;
+  using FilterType = itk::ConnectedComponentImageFilter<ImageType, itk::Image<unsigned short, 3>>;
+  using OutputImageType = FilterType::OutputImageType;
+
+  for (bool fullyConnected : { false, true })
+  {
+    auto reference = FilterType::New();
+    reference->SetInput(image);
+    reference->SetFullyConnected(fullyConnected);
+    reference->SetNumberOfWorkUnits(1);
+    reference->Update();
+
+    auto connected = FilterType::New();
+    connected->SetInput(image);
+    connected->SetFullyConnected(fullyConnected);
+    connected->SetNumberOfWorkUnits(7);
+    connected->Update();
+
+    ASSERT_GT(connected->GetObjectCount(), 1u);
+    EXPECT_EQ(connected->GetObjectCount(), reference->GetObjectCount());
+    ASSERT_EQ(connected->GetSizeOfObjectsInPixels().size(), connected->GetObjectCount());
+    EXPECT_EQ(connected->GetSizeOfObjectsInPixels(), reference->GetSizeOfObjectsInPixels());
+
+    // The outputs are identical, the labels are in raster order, and the
+    // sizes are those of the labels
+    std::vector<FilterType::ObjectSizeType> sizes(connected->GetObjectCount(), 0);
+    unsigned short                          maximumLabel = 0;
+
+    itk::ImageRegionConstIterator<OutputImageType> it(connected->GetOutput(),
+                                                      connected->GetOutput()->GetLargestPossibleRegion());
+    itk::ImageRegionConstIterator<OutputImageType> rit(reference->GetOutput(),
+                                                       reference->GetOutput()->GetLargestPossibleRegion());
+    for (; !it.IsAtEnd(); ++it, ++rit)
+    {
+      ASSERT_EQ(it.Get(), rit.Get());
+      if (it.Get() != 0)
+      {
+        ASSERT_LE(it.Get(), maximumLabel + 1);
+        maximumLabel = std::max(maximumLabel, it.Get());
+        ++sizes[it.Get() - 1];
+      }
+    }
+    EXPECT_EQ(connected->GetSizeOfObjectsInPixels(), sizes);
+
+    // Relabeling with the known sizes is the same as counting them
+    using RelabelType = itk::RelabelComponentImageFilter<OutputImageType, OutputImageType>;
+    auto counted = RelabelType::New();
+    counted->SetInput(connected->GetOutput());
+    counted->Update();
+
+    auto known = RelabelType::New();
+    known->SetInput(connected->GetOutput());
+    known->SetSizeOfInputObjectsInPixels(connected->GetSizeOfObjectsInPixels());
+    EXPECT_EQ(known->GetSizeOfInputObjectsInPixels(), connected->GetSizeOfObjectsInPixels());
+    known->Update();
+
+    EXPECT_EQ(known->GetNumberOfObjects(), counted->GetNumberOfObjects());
+    EXPECT_EQ(known->GetSizeOfObjectsInPixels(), counted->GetSizeOfObjectsInPixels());
+
+    itk::ImageRegionConstIterator<OutputImageType> kit(known->GetOutput(),
+                                                       known->GetOutput()->GetLargestPossibleRegion());
+    itk::ImageRegionConstIterator<OutputImageType> cit(counted->GetOutput(),
+                                                       counted->GetOutput()->GetLargestPossibleRegion());
+    for (; !kit.IsAtEnd(); ++kit, ++cit)
+    {
+      ASSERT_EQ(kit.Get(), cit.Get());
+    }
+  }
+}
+
+
+TEST(ConnectedComponentImageFilter, object_sizes_with_background)
+{
+  auto image = CreateTestImageB();
+  using ImageType = decltype(image)::ObjectType;
+  using FilterType = itk::ConnectedComponentImageFilter<ImageType, itk::Image<short, 3>>;
+  using OutputImageType = FilterType::OutputImageType;
+
+  for (short background : { -1, 2 })
+  {
+    auto connected = FilterType::New();
+    connected->SetInput(image);
+    connected->SetBackgroundValue(background);
+    connected->Update();
+
+    // The labels start at 0 and skip the background value
+    std::map<short, FilterType::ObjectSizeType> sizes;
+
+    itk::ImageRegionConstIterator<OutputImageType> it(connected->GetOutput(),
+                                                      connected->GetOutput()->GetLargestPossibleRegion());
+    for (; !it.IsAtEnd(); ++it)
+    {
+      if (it.Get() != background)
+      {
+        ++sizes[it.Get()];
+      }
+    }
+
+    ASSERT_EQ(sizes.size(), connected->GetObjectCount());
+    std::vector<FilterType::ObjectSizeType> expectedSizes;
+    for (const auto & labelSize : sizes)
+    {
+      expectedSizes.push_back(labelSize.second);
+    }
+    EXPECT_EQ(connected->GetSizeOfObjectsInPixels(), expectedSizes);
+    EXPECT_EQ(sizes.begin()->first, 0);
+    EXPECT_EQ(sizes.rbegin()->first, static_cast<short>(sizes.size() - (background >= 0 ? 0 : 1)));
+  }
+}
+
+
+TEST(ConnectedComponentImageFilter, stale_object_sizes)
+{
+  auto image = CreateTestImageB();
+  using ImageType = decltype(image)::ObjectType;
+  using FilterType = itk::ConnectedComponentImageFilter<ImageType, itk::Image<unsigned short, 3>>;
+  using OutputImageType = FilterType::OutputImageType;
+  using RelabelType = itk::RelabelComponentImageFilter<OutputImageType, OutputImageType>;
+
+  auto connected = FilterType::New();
+  connected->SetInput(image);
+  connected->FullyConnectedOff();
+  connected->Update();
+
+  auto known = RelabelType::New();
+  known->SetInput(connected->GetOutput());
+  known->SetSizeOfInputObjectsInPixels(connected->GetSizeOfObjectsInPixels());
+  known->Update();
+
+  // The sizes no longer describe the input once the pipeline updates it, so
+  // they are counted again
+  connected->FullyConnectedOn();
+  known->Update();
+
+  auto counted = RelabelType::New();
+  counted->SetInput(connected->GetOutput());
+  counted->Update();
+
+  ASSERT_NE(connected->GetSizeOfObjectsInPixels(), known->GetSizeOfInputObjectsInPixels());
+  EXPECT_EQ(known->GetNumberOfObjects(), counted->GetNumberOfObjects());
+  EXPECT_EQ(known->GetSizeOfObjectsInPixels(), counted->GetSizeOfObjectsInPixels());
+
+  itk::ImageRegionConstIterator<OutputImageType> kit(known->GetOutput(), known->GetOutput()->GetLargestPossibleRegion());
+  itk::ImageRegionConstIterator<OutputImageType> cit(counted->GetOutput(),
+                                                     counted->GetOutput()->GetLargestPossibleRegion());
+  for (; !kit.IsAtEnd(); ++kit, ++cit)
+  {
+    ASSERT_EQ(kit.Get(), cit.Get());
+  }
+}
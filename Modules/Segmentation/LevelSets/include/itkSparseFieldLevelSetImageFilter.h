@@ -163,6 +163,15 @@ private:
  *  the calculations on the level curve.
  *
  * \par
+ *  The active set is also stored as arrays of indices, buffer offsets and
+ *  nodes, which the computation and the application of the changes traverse
+ *  in the order of their linear index in the image, rather than in the order
+ *  of the linked list.  The indices which join the active set are appended
+ *  to the arrays, and are merged with the sorted ones once they are a
+ *  quarter of the active set, which amortizes the cost of the sorting over
+ *  the iterations.
+ *
+ * \par
  *  Briefly, the sparse field solver algorithm is as follows:
  *
  * \par
@@ -514,6 +523,19 @@ protected:
    *  CalculateChange. */
   UpdateBufferType m_UpdateBuffer;
 
+  /** The active layer as a structure of arrays, in the order of
+   * m_UpdateBuffer: the indices of the nodes, their offsets in the buffers
+   * of the output and the status images, and the nodes of m_Layers[0]. The
+   * first m_ActiveLayerSortedSize elements are sorted by their offset in the
+   * status image, which is their linear index in the requested region, and
+   * the nodes which joined the active layer since the last rebuild follow
+   * them. */
+  std::vector<IndexType>       m_ActiveLayerIndices;
+  std::vector<OffsetValueType> m_ActiveLayerOutputOffsets;
+  std::vector<OffsetValueType> m_ActiveLayerStatusOffsets;
+  std::vector<LayerNodeType *> m_ActiveLayerNodes;
+  SizeValueType                m_ActiveLayerSortedSize{ 0 };
+
   /** The RMS change calculated from each update.  Can be used by a subclass to
    *  determine halting criteria.  Valid only for the previous iteration, not
    *  during the current iteration.  Calculated in ApplyUpdate. */
@@ -532,6 +554,34 @@ private:
   /** This flag is true when methods need to check boundary conditions and
       false when methods do not need to check for boundary conditions. */
   bool m_BoundsCheckingActive{ false };
+
+  /** Computes the offsets of the neighbors of m_NeighborList in the buffer
+   * of an image.  The layers read and write the neighbors of their indices
+   * at these offsets, rather than through neighborhood iterators, which set
+   * the pointers to the whole neighborhood at each index. */
+  template <typename TImage>
+  void
+  ComputeNeighborBufferOffsets(const TImage * image, std::vector<OffsetValueType> & offsets) const;
+
+  /** Whether the neighbor i of m_NeighborList of an index is in the status
+   * image, which is only checked when bounds checking is active. */
+  bool
+  IsNeighborInStatusImage(const IndexType & index, unsigned int i) const;
+
+  /** Appends a node of m_Layers[0] to the arrays of the active layer. */
+  void
+  PushBackActiveLayerNode(LayerNodeType * node);
+
+  /** Sorts the nodes which joined the active layer since the last rebuild,
+   * and merges them with the sorted nodes of the arrays of the active
+   * layer. */
+  void
+  RebuildActiveLayerArrays();
+
+  /** Puts the elements of an array of the active layer in the given order. */
+  template <typename TArray>
+  static void
+  ReorderActiveLayerArray(TArray & array, const std::vector<SizeValueType> & order);
 };
 } // end namespace itk
 
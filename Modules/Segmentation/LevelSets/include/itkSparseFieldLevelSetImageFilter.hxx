@@ -25,6 +25,10 @@
 #include "itkNeighborhoodAlgorithm.h"
 #include "itkMath.h"
 
+#include <algorithm>
+#include <numeric>
+#include <type_traits>
+
 namespace itk
 {
 template <typename TNeighborhoodType>
@@ -204,6 +208,13 @@ SparseFieldLevelSetImageFilter<TInputImage, TOutputImage>::ApplyUpdate(const Tim
   // Finally, we update all of the layer values (excluding the active layer,
   // which has already been updated).
   this->PropagateAllLayerValues();
+
+  // The nodes which joined the active layer follow the sorted ones until they
+  // are a quarter of the active layer.
+  if (4 * (m_ActiveLayerNodes.size() - m_ActiveLayerSortedSize) > m_ActiveLayerNodes.size())
+  {
+    this->RebuildActiveLayerArrays();
+  }
 }
 
 template <typename TInputImage, typename TOutputImage>
@@ -256,6 +267,10 @@ SparseFieldLevelSetImageFilter<TInputImage, TOutputImage>::ProcessStatusList(Lay
     node = InputList->Front(); // Must unlink from the input list
     InputList->PopFront();     // _before_ transferring to another list.
     m_Layers[ChangeToStatus]->PushFront(node);
+    if (ChangeToStatus == 0)
+    {
+      this->PushBackActiveLayerNode(node);
+    }
 
     for (i = 0; i < m_NeighborList.GetSize(); ++i)
     {
@@ -302,34 +317,45 @@ SparseFieldLevelSetImageFilter<TInputImage, TOutputImage>::UpdateActiveLayerValu
   ValueType      new_value, temp_value, rms_change_accumulator;
   LayerNodeType *node, *release_node;
   StatusType     neighbor_status;
-  unsigned int   i, idx, counter;
-  bool           bounds_status, flag;
-
-  typename LayerType::Iterator              layerIt;
-  typename UpdateBufferType::const_iterator updateIt;
-
-  NeighborhoodIterator<OutputImageType> outputIt(
-    m_NeighborList.GetRadius(), this->GetOutput(), this->GetOutput()->GetRequestedRegion());
-
-  NeighborhoodIterator<StatusImageType> statusIt(
-    m_NeighborList.GetRadius(), m_StatusImage, this->GetOutput()->GetRequestedRegion());
-
-  if (m_BoundsCheckingActive == false)
-  {
-    outputIt.NeedToUseBoundaryConditionOff();
-    statusIt.NeedToUseBoundaryConditionOff();
-  }
+  unsigned int   i, counter;
+  bool           flag;
+
+  // The neighbors outside of the image never have the status searched for,
+  // as the boundary condition of the status image gives them the status of
+  // the active layer, so they are skipped when bounds checking is active.
+  std::vector<OffsetValueType> outputNeighborOffsets;
+  std::vector<OffsetValueType> statusNeighborOffsets;
+  this->ComputeNeighborBufferOffsets(this->m_OutputImage, outputNeighborOffsets);
+  this->ComputeNeighborBufferOffsets(m_StatusImage.GetPointer(), statusNeighborOffsets);
+  ValueType * const  outputBuffer = this->m_OutputImage->GetBufferPointer();
+  StatusType * const statusBuffer = m_StatusImage->GetBufferPointer();
+
+  // The nodes which stay in the active layer are moved to the front of its
+  // arrays, in the same order.
+  const SizeValueType activeLayerSize = m_ActiveLayerNodes.size();
+  SizeValueType       keptSize = 0;
+  SizeValueType       keptSortedSize = 0;
+  const auto          keepNode = [this, &keptSize, &keptSortedSize](SizeValueType k) {
+    m_ActiveLayerIndices[keptSize] = m_ActiveLayerIndices[k];
+    m_ActiveLayerOutputOffsets[keptSize] = m_ActiveLayerOutputOffsets[k];
+    m_ActiveLayerStatusOffsets[keptSize] = m_ActiveLayerStatusOffsets[k];
+    m_ActiveLayerNodes[keptSize] = m_ActiveLayerNodes[k];
+    ++keptSize;
+    if (k < m_ActiveLayerSortedSize)
+    {
+      ++keptSortedSize;
+    }
+  };
 
   counter = 0;
   rms_change_accumulator = m_ValueZero;
-  layerIt = m_Layers[0]->Begin();
-  updateIt = m_UpdateBuffer.begin();
-  while (layerIt != m_Layers[0]->End())
+  for (SizeValueType k = 0; k < activeLayerSize; ++k)
   {
-    outputIt.SetLocation(layerIt->m_Value);
-    statusIt.SetLocation(layerIt->m_Value);
+    const IndexType    index = m_ActiveLayerIndices[k];
+    ValueType * const  output = outputBuffer + m_ActiveLayerOutputOffsets[k];
+    StatusType * const status = statusBuffer + m_ActiveLayerStatusOffsets[k];
 
-    new_value = this->CalculateUpdateValue(layerIt->m_Value, dt, outputIt.GetCenterPixel(), *updateIt);
+    new_value = this->CalculateUpdateValue(index, dt, *output, m_UpdateBuffer[k]);
 
     // If this index needs to be moved to another layer, then search its
     // neighborhood for indices that need to be pulled up/down into the
@@ -349,7 +375,11 @@ SparseFieldLevelSetImageFilter<TInputImage, TOutputImage>::UpdateActiveLayerValu
       flag = false;
       for (i = 0; i < m_NeighborList.GetSize(); ++i)
       {
-        if (statusIt.GetPixel(m_NeighborList.GetArrayIndex(i)) == m_StatusActiveChangingDown)
+        if (m_BoundsCheckingActive && !this->IsNeighborInStatusImage(index, i))
+        {
+          continue;
+        }
+        if (status[statusNeighborOffsets[i]] == m_StatusActiveChangingDown)
         {
           flag = true;
           break;
@@ -357,38 +387,40 @@ SparseFieldLevelSetImageFilter<TInputImage, TOutputImage>::UpdateActiveLayerValu
       }
       if (flag == true)
       {
-        ++layerIt;
-        ++updateIt;
+        keepNode(k);
         continue;
       }
 
-      rms_change_accumulator += itk::Math::sqr(new_value - outputIt.GetCenterPixel());
+      rms_change_accumulator += itk::Math::sqr(new_value - *output);
 
       // Search the neighborhood for inside indices.
       temp_value = new_value - m_ConstantGradientValue;
       for (i = 0; i < m_NeighborList.GetSize(); ++i)
       {
-        idx = m_NeighborList.GetArrayIndex(i);
-        neighbor_status = statusIt.GetPixel(idx);
+        if (m_BoundsCheckingActive && !this->IsNeighborInStatusImage(index, i))
+        {
+          continue;
+        }
+        neighbor_status = status[statusNeighborOffsets[i]];
         if (neighbor_status == 1)
         {
           // Keep the smallest possible value for the new active node.  This
           // places the new active layer node closest to the zero level-set.
-          if (outputIt.GetPixel(idx) < LOWER_ACTIVE_THRESHOLD ||
-              ::itk::Math::abs(temp_value) < ::itk::Math::abs(outputIt.GetPixel(idx)))
+          ValueType & neighbor_value = output[outputNeighborOffsets[i]];
+          if (neighbor_value < LOWER_ACTIVE_THRESHOLD ||
+              ::itk::Math::abs(temp_value) < ::itk::Math::abs(neighbor_value))
           {
-            outputIt.SetPixel(idx, temp_value, bounds_status);
+            neighbor_value = temp_value;
           }
         }
       }
       node = m_LayerNodeStore->Borrow();
-      node->m_Value = layerIt->m_Value;
+      node->m_Value = index;
       UpList->PushFront(node);
-      statusIt.SetCenterPixel(m_StatusActiveChangingUp);
+      *status = m_StatusActiveChangingUp;
 
       // Now remove this index from the active list.
-      release_node = layerIt.GetPointer();
-      ++layerIt;
+      release_node = m_ActiveLayerNodes[k];
       m_Layers[0]->Unlink(release_node);
       m_LayerNodeStore->Return(release_node);
     }
@@ -400,7 +432,11 @@ SparseFieldLevelSetImageFilter<TInputImage, TOutputImage>::UpdateActiveLayerValu
       flag = false;
       for (i = 0; i < m_NeighborList.GetSize(); ++i)
       {
-        if (statusIt.GetPixel(m_NeighborList.GetArrayIndex(i)) == m_StatusActiveChangingUp)
+        if (m_BoundsCheckingActive && !this->IsNeighborInStatusImage(index, i))
+        {
+          continue;
+        }
+        if (status[statusNeighborOffsets[i]] == m_StatusActiveChangingUp)
         {
           flag = true;
           break;
@@ -408,51 +444,57 @@ SparseFieldLevelSetImageFilter<TInputImage, TOutputImage>::UpdateActiveLayerValu
       }
       if (flag == true)
       {
-        ++layerIt;
-        ++updateIt;
+        keepNode(k);
         continue;
       }
 
-      rms_change_accumulator += itk::Math::sqr(new_value - outputIt.GetCenterPixel());
+      rms_change_accumulator += itk::Math::sqr(new_value - *output);
 
       // Search the neighborhood for outside indices.
       temp_value = new_value + m_ConstantGradientValue;
       for (i = 0; i < m_NeighborList.GetSize(); ++i)
       {
-        idx = m_NeighborList.GetArrayIndex(i);
-        neighbor_status = statusIt.GetPixel(idx);
+        if (m_BoundsCheckingActive && !this->IsNeighborInStatusImage(index, i))
+        {
+          continue;
+        }
+        neighbor_status = status[statusNeighborOffsets[i]];
         if (neighbor_status == 2)
         {
           // Keep the smallest magnitude value for this active set node.  This
           // places the node closest to the active layer.
-          if (outputIt.GetPixel(idx) >= UPPER_ACTIVE_THRESHOLD ||
-              ::itk::Math::abs(temp_value) < ::itk::Math::abs(outputIt.GetPixel(idx)))
+          ValueType & neighbor_value = output[outputNeighborOffsets[i]];
+          if (neighbor_value >= UPPER_ACTIVE_THRESHOLD ||
+              ::itk::Math::abs(temp_value) < ::itk::Math::abs(neighbor_value))
           {
-            outputIt.SetPixel(idx, temp_value, bounds_status);
+            neighbor_value = temp_value;
           }
         }
       }
       node = m_LayerNodeStore->Borrow();
-      node->m_Value = layerIt->m_Value;
+      node->m_Value = index;
       DownList->PushFront(node);
-      statusIt.SetCenterPixel(m_StatusActiveChangingDown);
+      *status = m_StatusActiveChangingDown;
 
       // Now remove this index from the active list.
-      release_node = layerIt.GetPointer();
-      ++layerIt;
+      release_node = m_ActiveLayerNodes[k];
       m_Layers[0]->Unlink(release_node);
       m_LayerNodeStore->Return(release_node);
     }
     else
     {
-      rms_change_accumulator += itk::Math::sqr(new_value - outputIt.GetCenterPixel());
-      // rms_change_accumulator += (*updateIt) * (*updateIt);
-      outputIt.SetCenterPixel(new_value);
-      ++layerIt;
+      rms_change_accumulator += itk::Math::sqr(new_value - *output);
+      // rms_change_accumulator += m_UpdateBuffer[k] * m_UpdateBuffer[k];
+      *output = new_value;
+      keepNode(k);
     }
-    ++updateIt;
     ++counter;
   }
+  m_ActiveLayerIndices.resize(keptSize);
+  m_ActiveLayerOutputOffsets.resize(keptSize);
+  m_ActiveLayerStatusOffsets.resize(keptSize);
+  m_ActiveLayerNodes.resize(keptSize);
+  m_ActiveLayerSortedSize = keptSortedSize;
 
   // Determine the average change during this iteration.
   if (counter == 0)
@@ -583,6 +625,18 @@ SparseFieldLevelSetImageFilter<TInputImage, TOutputImage>::Initialize()
   // outside of the active layer.
   this->ConstructActiveLayer();
 
+  // Store the active layer in its arrays, sorted by linear index.
+  m_ActiveLayerIndices.clear();
+  m_ActiveLayerOutputOffsets.clear();
+  m_ActiveLayerStatusOffsets.clear();
+  m_ActiveLayerNodes.clear();
+  m_ActiveLayerSortedSize = 0;
+  for (typename LayerType::Iterator activeIt = m_Layers[0]->Begin(); activeIt != m_Layers[0]->End(); ++activeIt)
+  {
+    this->PushBackActiveLayerNode(activeIt.GetPointer());
+  }
+  this->RebuildActiveLayerArrays();
+
   // Construct the rest of the non-active set layers using the first two
   // layers. Inside layers are odd numbers, outside layers are even numbers.
   for (unsigned int i = 1; i < m_Layers.size() - 2; ++i)
@@ -865,7 +919,6 @@ SparseFieldLevelSetImageFilter<TInputImage, TOutputImage>::CalculateChange()
 
   void * globalData = df->GetGlobalDataPointer();
 
-  typename LayerType::ConstIterator     layerIt;
   NeighborhoodIterator<OutputImageType> outputIt(
     df->GetRadius(), this->m_OutputImage, this->m_OutputImage->GetRequestedRegion());
   TimeStepType timeStep;
@@ -876,15 +929,24 @@ SparseFieldLevelSetImageFilter<TInputImage, TOutputImage>::CalculateChange()
   }
 
   m_UpdateBuffer.clear();
-  m_UpdateBuffer.reserve(m_Layers[0]->Size());
+  m_UpdateBuffer.reserve(m_ActiveLayerIndices.size());
 
   // Calculates the update values for the active layer indices in this
-  // iteration.  Iterates through the active layer index list, applying
+  // iteration.  Iterates through the arrays of the active layer, applying
   // the level set function to the output image (level set image) at each
-  // index.  Update values are stored in the update buffer.
-  for (layerIt = m_Layers[0]->Begin(); layerIt != m_Layers[0]->End(); ++layerIt)
+  // index.  Update values are stored in the update buffer.  As the indices
+  // are mostly sorted, the neighborhood is moved from the previous index
+  // rather than set at each index.
+  for (SizeValueType k = 0; k < m_ActiveLayerIndices.size(); ++k)
   {
-    outputIt.SetLocation(layerIt->m_Value);
+    if (k == 0)
+    {
+      outputIt.SetLocation(m_ActiveLayerIndices[0]);
+    }
+    else
+    {
+      outputIt += m_ActiveLayerIndices[k] - m_ActiveLayerIndices[k - 1];
+    }
 
     // Calculate the offset to the surface from the center of this
     // neighborhood.  This is used by some level set functions in sampling a
@@ -1000,26 +1062,26 @@ SparseFieldLevelSetImageFilter<TInputImage, TOutputImage>::PropagateLayerValues(
     delta = m_ConstantGradientValue;
   }
 
-  NeighborhoodIterator<OutputImageType> outputIt(
-    m_NeighborList.GetRadius(), this->m_OutputImage, this->m_OutputImage->GetRequestedRegion());
-  NeighborhoodIterator<StatusImageType> statusIt(
-    m_NeighborList.GetRadius(), m_StatusImage, this->m_OutputImage->GetRequestedRegion());
-
-  if (m_BoundsCheckingActive == false)
-  {
-    outputIt.NeedToUseBoundaryConditionOff();
-    statusIt.NeedToUseBoundaryConditionOff();
-  }
+  // The neighbors outside of the image are never in the "from" layer, as
+  // the boundary condition of the status image gives them the status of the
+  // "to" layer, so they are skipped when bounds checking is active.
+  std::vector<OffsetValueType> outputNeighborOffsets;
+  std::vector<OffsetValueType> statusNeighborOffsets;
+  this->ComputeNeighborBufferOffsets(this->m_OutputImage, outputNeighborOffsets);
+  this->ComputeNeighborBufferOffsets(m_StatusImage.GetPointer(), statusNeighborOffsets);
+  ValueType * const  outputBuffer = this->m_OutputImage->GetBufferPointer();
+  StatusType * const statusBuffer = m_StatusImage->GetBufferPointer();
 
   toIt = m_Layers[to]->Begin();
   while (toIt != m_Layers[to]->End())
   {
-    statusIt.SetLocation(toIt->m_Value);
+    const IndexType &  index = toIt->m_Value;
+    StatusType * const status = statusBuffer + m_StatusImage->ComputeOffset(index);
 
     // Is this index marked for deletion? If the status image has
     // been marked with another layer's value, we need to delete this node
     // from the current list then skip to the next iteration.
-    if (statusIt.GetCenterPixel() != to)
+    if (*status != to)
     {
       node = toIt.GetPointer();
       ++toIt;
@@ -1028,17 +1090,22 @@ SparseFieldLevelSetImageFilter<TInputImage, TOutputImage>::PropagateLayerValues(
       continue;
     }
 
-    outputIt.SetLocation(toIt->m_Value);
+    ValueType * const output = outputBuffer + this->m_OutputImage->ComputeOffset(index);
 
     found_neighbor_flag = false;
     for (i = 0; i < m_NeighborList.GetSize(); ++i)
     {
+      if (m_BoundsCheckingActive && !this->IsNeighborInStatusImage(index, i))
+      {
+        continue;
+      }
+
       // If this neighbor is in the "from" list, compare its absolute value
       // to to any previous values found in the "from" list.  Keep the value
       // that will cause the next layer to be closest to the zero level set.
-      if (statusIt.GetPixel(m_NeighborList.GetArrayIndex(i)) == from)
+      if (status[statusNeighborOffsets[i]] == from)
       {
-        value_temp = outputIt.GetPixel(m_NeighborList.GetArrayIndex(i));
+        value_temp = output[outputNeighborOffsets[i]];
 
         if (found_neighbor_flag == false)
         {
@@ -1070,7 +1137,7 @@ SparseFieldLevelSetImageFilter<TInputImage, TOutputImage>::PropagateLayerValues(
     {
       // Set the new value using the smallest distance
       // found in our "from" neighbors.
-      outputIt.SetCenterPixel(value + delta);
+      *output = value + delta;
       ++toIt;
     }
     else
@@ -1085,17 +1152,94 @@ SparseFieldLevelSetImageFilter<TInputImage, TOutputImage>::PropagateLayerValues(
       if (promote > past_end)
       {
         m_LayerNodeStore->Return(node);
-        statusIt.SetCenterPixel(m_StatusNull);
+        *status = m_StatusNull;
       }
       else
       {
         m_Layers[promote]->PushFront(node);
-        statusIt.SetCenterPixel(promote);
+        *status = promote;
       }
     }
   }
 }
 
+template <typename TInputImage, typename TOutputImage>
+template <typename TImage>
+void
+SparseFieldLevelSetImageFilter<TInputImage, TOutputImage>::ComputeNeighborBufferOffsets(
+  const TImage *                 image,
+  std::vector<OffsetValueType> & offsets) const
+{
+  const OffsetValueType * offsetTable = image->GetOffsetTable();
+
+  offsets.resize(m_NeighborList.GetSize());
+  for (unsigned int i = 0; i < m_NeighborList.GetSize(); ++i)
+  {
+    offsets[i] = 0;
+    for (unsigned int j = 0; j < ImageDimension; ++j)
+    {
+      offsets[i] += m_NeighborList.GetNeighborhoodOffset(i)[j] * offsetTable[j];
+    }
+  }
+}
+
+template <typename TInputImage, typename TOutputImage>
+bool
+SparseFieldLevelSetImageFilter<TInputImage, TOutputImage>::IsNeighborInStatusImage(const IndexType & index,
+                                                                                   unsigned int      i) const
+{
+  return m_StatusImage->GetBufferedRegion().IsInside(index + m_NeighborList.GetNeighborhoodOffset(i));
+}
+
+template <typename TInputImage, typename TOutputImage>
+void
+SparseFieldLevelSetImageFilter<TInputImage, TOutputImage>::PushBackActiveLayerNode(LayerNodeType * node)
+{
+  m_ActiveLayerIndices.push_back(node->m_Value);
+  m_ActiveLayerOutputOffsets.push_back(this->m_OutputImage->ComputeOffset(node->m_Value));
+  m_ActiveLayerStatusOffsets.push_back(m_StatusImage->ComputeOffset(node->m_Value));
+  m_ActiveLayerNodes.push_back(node);
+}
+
+template <typename TInputImage, typename TOutputImage>
+void
+SparseFieldLevelSetImageFilter<TInputImage, TOutputImage>::RebuildActiveLayerArrays()
+{
+  // Sort the positions of the appended nodes, and merge them with the
+  // positions of the sorted nodes, which costs a sort of the appended nodes
+  // and a pass over the arrays.
+  std::vector<SizeValueType> order(m_ActiveLayerNodes.size());
+  std::iota(order.begin(), order.end(), 0);
+  const auto sortedEnd = order.begin() + static_cast<OffsetValueType>(m_ActiveLayerSortedSize);
+  const auto byLinearIndex = [this](SizeValueType a, SizeValueType b) {
+    return m_ActiveLayerStatusOffsets[a] < m_ActiveLayerStatusOffsets[b];
+  };
+  std::sort(sortedEnd, order.end(), byLinearIndex);
+  std::inplace_merge(order.begin(), sortedEnd, order.end(), byLinearIndex);
+
+  ReorderActiveLayerArray(m_ActiveLayerIndices, order);
+  ReorderActiveLayerArray(m_ActiveLayerOutputOffsets, order);
+  ReorderActiveLayerArray(m_ActiveLayerStatusOffsets, order);
+  ReorderActiveLayerArray(m_ActiveLayerNodes, order);
+  m_ActiveLayerSortedSize = m_ActiveLayerNodes.size();
+}
+
+template <typename TInputImage, typename TOutputImage>
+template <typename TArray>
+void
+SparseFieldLevelSetImageFilter<TInputImage, TOutputImage>::ReorderActiveLayerArray(
+  TArray &                           array,
+  const std::vector<SizeValueType> & order)
+{
+  TArray reordered;
+  reordered.reserve(order.size());
+  for (const SizeValueType k : order)
+  {
+    reordered.push_back(array[k]);
+  }
+  array.swap(reordered);
+}
+
 template <typename TInputImage, typename TOutputImage>
 void
 SparseFieldLevelSetImageFilter<TInputImage, TOutputImage>::PostProcessOutput()
@@ -1146,6 +1290,8 @@ SparseFieldLevelSetImageFilter<TInputImage, TOutputImage>::PrintSelf(std::ostrea
   }
   os << indent << "m_UpdateBuffer: size=" << static_cast<SizeValueType>(m_UpdateBuffer.size())
      << " capacity=" << static_cast<SizeValueType>(m_UpdateBuffer.capacity()) << std::endl;
+  os << indent << "m_ActiveLayerNodes: size=" << static_cast<SizeValueType>(m_ActiveLayerNodes.size())
+     << " sorted=" << m_ActiveLayerSortedSize << std::endl;
 }
 } // end namespace itk
 
@@ -0,0 +1,190 @@
+/*=========================================================================
+ *
+ *  Copyright NumFOCUS
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include "itkThresholdSegmentationLevelSetImageFilter.h"
+#include "itkImageRegionIteratorWithIndex.h"
+#include "itkTestingMacros.h"
+
+#include <set>
+
+/*
+ * This test checks the arrays of the active layer of the
+ * SparseFieldLevelSetImageFilter against the linked list of the active layer
+ * and the status image after each iteration of a threshold segmentation,
+ * whose front grows from a small sphere until its layers reach the border of
+ * the image.
+ */
+
+namespace
+{
+using ImageType = itk::Image<float, 3>;
+
+class ActiveLayerCheckingFilter : public itk::ThresholdSegmentationLevelSetImageFilter<ImageType, ImageType>
+{
+public:
+  ITK_DISALLOW_COPY_AND_ASSIGN(ActiveLayerCheckingFilter);
+
+  using Self = ActiveLayerCheckingFilter;
+  using Superclass = itk::ThresholdSegmentationLevelSetImageFilter<ImageType, ImageType>;
+  using Pointer = itk::SmartPointer<Self>;
+
+  itkNewMacro(Self);
+  itkTypeMacro(ActiveLayerCheckingFilter, ThresholdSegmentationLevelSetImageFilter);
+
+  bool         m_Consistent{ true };
+  unsigned int m_NumberOfSortedIterations{ 0 };
+  unsigned int m_NumberOfPartlySortedIterations{ 0 };
+
+protected:
+  ActiveLayerCheckingFilter() = default;
+  ~ActiveLayerCheckingFilter() override = default;
+
+  void
+  ApplyUpdate(const TimeStepType & dt) override
+  {
+    Superclass::ApplyUpdate(dt);
+
+    const itk::SizeValueType size = this->m_ActiveLayerNodes.size();
+    if (this->m_ActiveLayerIndices.size() != size || this->m_ActiveLayerOutputOffsets.size() != size ||
+        this->m_ActiveLayerStatusOffsets.size() != size || this->m_Layers[0]->Size() != size ||
+        this->m_ActiveLayerSortedSize > size)
+    {
+      std::cerr << "The sizes of the active layer arrays are inconsistent" << std::endl;
+      m_Consistent = false;
+      return;
+    }
+
+    // The arrays hold the nodes of the linked list, each once
+    std::set<const LayerNodeType *> listNodes;
+    for (auto it = this->m_Layers[0]->Begin(); it != this->m_Layers[0]->End(); ++it)
+    {
+      listNodes.insert(it.GetPointer());
+    }
+    const std::set<const LayerNodeType *> arrayNodes(this->m_ActiveLayerNodes.begin(), this->m_ActiveLayerNodes.end());
+    if (listNodes != arrayNodes || arrayNodes.size() != size)
+    {
+      std::cerr << "The active layer arrays do not hold the nodes of the active layer" << std::endl;
+      m_Consistent = false;
+      return;
+    }
+
+    for (itk::SizeValueType k = 0; k < size; ++k)
+    {
+      const IndexType & index = this->m_ActiveLayerIndices[k];
+      if (this->m_ActiveLayerNodes[k]->m_Value != index ||
+          this->m_ActiveLayerOutputOffsets[k] != this->GetOutput()->ComputeOffset(index) ||
+          this->m_ActiveLayerStatusOffsets[k] != this->m_StatusImage->ComputeOffset(index) ||
+          this->m_StatusImage->GetPixel(index) != 0)
+      {
+        std::cerr << "The active layer arrays are inconsistent at " << index << std::endl;
+        m_Consistent = false;
+        return;
+      }
+      if (k > 0 && k < this->m_ActiveLayerSortedSize &&
+          this->m_ActiveLayerStatusOffsets[k - 1] >= this->m_ActiveLayerStatusOffsets[k])
+      {
+        std::cerr << "The active layer arrays are not sorted at " << index << std::endl;
+        m_Consistent = false;
+        return;
+      }
+    }
+
+    // All the indices with the status of the active layer are in the arrays
+    itk::SizeValueType numberOfActiveStatus = 0;
+    const StatusType * status = this->m_StatusImage->GetBufferPointer();
+    for (itk::SizeValueType i = 0; i < this->m_StatusImage->GetBufferedRegion().GetNumberOfPixels(); ++i)
+    {
+      numberOfActiveStatus += (status[i] == 0);
+    }
+    if (numberOfActiveStatus != size)
+    {
+      std::cerr << "The status image has " << numberOfActiveStatus << " active indices instead of " << size
+                << std::endl;
+      m_Consistent = false;
+      return;
+    }
+
+    if (this->m_ActiveLayerSortedSize == size)
+    {
+      ++m_NumberOfSortedIterations;
+    }
+    else
+    {
+      ++m_NumberOfPartlySortedIterations;
+    }
+  }
+};
+} // namespace
+
+int
+itkSparseFieldLevelSetImageFilterActiveLayerTest(int, char *[])
+{
+  ImageType::SizeType   size = { { 48, 40, 36 } };
+  ImageType::RegionType region(size);
+
+  // A small sphere as the initial level set, and an ellipsoid and a slab
+  // which touches the border of the image as the thresholded region
+  ImageType::Pointer initialImage = ImageType::New();
+  initialImage->SetRegions(region);
+  initialImage->Allocate();
+  ImageType::Pointer featureImage = ImageType::New();
+  featureImage->SetRegions(region);
+  featureImage->Allocate();
+
+  itk::ImageRegionIteratorWithIndex<ImageType> initialIt(initialImage, region);
+  itk::ImageRegionIteratorWithIndex<ImageType> featureIt(featureImage, region);
+  for (; !initialIt.IsAtEnd(); ++initialIt, ++featureIt)
+  {
+    const ImageType::IndexType & index = initialIt.GetIndex();
+    const double                 x = index[0] - 20.0;
+    const double                 y = index[1] - 20.0;
+    const double                 z = index[2] - 18.0;
+    initialIt.Set(static_cast<float>(std::sqrt(x * x + y * y + z * z) - 4.0));
+    const bool inside = x * x / 300.0 + y * y / 150.0 + z * z / 100.0 < 1.0 || (index[0] > 30 && std::abs(y) < 5.0);
+    featureIt.Set(inside ? 100.0f : 0.0f);
+  }
+
+  ActiveLayerCheckingFilter::Pointer filter = ActiveLayerCheckingFilter::New();
+  filter->SetInput(initialImage);
+  filter->SetFeatureImage(featureImage);
+  filter->SetLowerThreshold(50.0);
+  filter->SetUpperThreshold(150.0);
+  filter->SetCurvatureScaling(0.5);
+  filter->SetPropagationScaling(1.0);
+  filter->SetMaximumRMSError(0.0);
+  filter->SetNumberOfIterations(120);
+
+  ITK_TRY_EXPECT_NO_EXCEPTION(filter->Update());
+
+  std::cout << "Iterations with a sorted active layer: " << filter->m_NumberOfSortedIterations << std::endl;
+  std::cout << "Iterations with appended nodes: " << filter->m_NumberOfPartlySortedIterations << std::endl;
+
+  ITK_TEST_EXPECT_TRUE(filter->m_Consistent);
+  ITK_TEST_EXPECT_EQUAL(filter->GetElapsedIterations(), 120u);
+  // Both the rebuilds of the arrays and the appended nodes were exercised
+  ITK_TEST_EXPECT_TRUE(filter->m_NumberOfSortedIterations > 0);
+  ITK_TEST_EXPECT_TRUE(filter->m_NumberOfPartlySortedIterations > 0);
+
+  // The front went along the slab until its layers reached the border of
+  // the image
+  ImageType::IndexType slabIndex = { { 41, 20, 18 } };
+  ITK_TEST_EXPECT_TRUE(filter->GetOutput()->GetPixel(slabIndex) < 0.0f);
+
+  std::cout << "Test finished." << std::endl;
+  return EXIT_SUCCESS;
+}
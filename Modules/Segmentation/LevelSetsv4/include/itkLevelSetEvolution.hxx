@@ -324,26 +324,24 @@ template <typename TEquationContainer, typename TOutput, unsigned int VDimension
 void
 LevelSetEvolution<TEquationContainer, WhitakerSparseLevelSetImage<TOutput, VDimension>>::UpdateLevelSets()
 {
+  std::vector<UpdateLevelSetFilterPointer> updateLevelSets;
+
   typename LevelSetContainerType::Iterator it = this->m_LevelSetContainer->Begin();
   while (it != this->m_LevelSetContainer->End())
   {
-    typename LevelSetType::Pointer levelSet = it->GetLevelSet();
-
     UpdateLevelSetFilterPointer updateLevelSet = UpdateLevelSetFilterType::New();
-    updateLevelSet->SetInputLevelSet(levelSet);
+    updateLevelSet->SetInputLevelSet(it->GetLevelSet());
     updateLevelSet->SetUpdate(*this->m_UpdateBuffer[it->GetIdentifier()]);
     updateLevelSet->SetEquationContainer(this->m_EquationContainer);
     updateLevelSet->SetTimeStep(this->m_Dt);
     updateLevelSet->SetCurrentLevelSetId(it->GetIdentifier());
-    updateLevelSet->Update();
-
-    levelSet->Graft(updateLevelSet->GetOutputLevelSet());
-
-    this->m_RMSChangeAccumulator = updateLevelSet->GetRMSChangeAccumulator();
+    updateLevelSets.push_back(updateLevelSet);
 
     this->m_UpdateBuffer[it->GetIdentifier()]->clear();
     ++it;
   }
+
+  this->template RunUpdateLevelSetFilters<UpdateLevelSetFilterType>(updateLevelSets);
 }
 
 template <typename TEquationContainer, typename TOutput, unsigned int VDimension>
@@ -359,24 +357,22 @@ template <typename TEquationContainer, unsigned int VDimension>
 void
 LevelSetEvolution<TEquationContainer, ShiSparseLevelSetImage<VDimension>>::UpdateLevelSets()
 {
+  std::vector<UpdateLevelSetFilterPointer> updateLevelSets;
+
   typename LevelSetContainerType::Iterator it = this->m_LevelSetContainer->Begin();
 
   while (it != this->m_LevelSetContainer->End())
   {
-    typename LevelSetType::Pointer levelSet = it->GetLevelSet();
-
     UpdateLevelSetFilterPointer updateLevelSet = UpdateLevelSetFilterType::New();
-    updateLevelSet->SetInputLevelSet(levelSet);
+    updateLevelSet->SetInputLevelSet(it->GetLevelSet());
     updateLevelSet->SetCurrentLevelSetId(it->GetIdentifier());
     updateLevelSet->SetEquationContainer(this->m_EquationContainer);
-    updateLevelSet->Update();
-
-    levelSet->Graft(updateLevelSet->GetOutputLevelSet());
-
-    this->m_RMSChangeAccumulator = updateLevelSet->GetRMSChangeAccumulator();
+    updateLevelSets.push_back(updateLevelSet);
 
     ++it;
   }
+
+  this->template RunUpdateLevelSetFilters<UpdateLevelSetFilterType>(updateLevelSets);
 }
 
 template <typename TEquationContainer, unsigned int VDimension>
@@ -392,25 +388,22 @@ template <typename TEquationContainer, unsigned int VDimension>
 void
 LevelSetEvolution<TEquationContainer, MalcolmSparseLevelSetImage<VDimension>>::UpdateLevelSets()
 {
+  std::vector<UpdateLevelSetFilterPointer> updateLevelSets;
+
   typename LevelSetContainerType::Iterator it = this->m_LevelSetContainer->Begin();
 
   while (it != this->m_LevelSetContainer->End())
   {
-    typename LevelSetType::Pointer levelSet = it->GetLevelSet();
-    LevelSetIdentifierType         levelSetId = it->GetIdentifier();
-
     UpdateLevelSetFilterPointer updateLevelSet = UpdateLevelSetFilterType::New();
-    updateLevelSet->SetInputLevelSet(levelSet);
-    updateLevelSet->SetCurrentLevelSetId(levelSetId);
+    updateLevelSet->SetInputLevelSet(it->GetLevelSet());
+    updateLevelSet->SetCurrentLevelSetId(it->GetIdentifier());
     updateLevelSet->SetEquationContainer(this->m_EquationContainer);
-    updateLevelSet->Update();
-
-    levelSet->Graft(updateLevelSet->GetOutputLevelSet());
-
-    this->m_RMSChangeAccumulator = updateLevelSet->GetRMSChangeAccumulator();
+    updateLevelSets.push_back(updateLevelSet);
 
     ++it;
   }
+
+  this->template RunUpdateLevelSetFilters<UpdateLevelSetFilterType>(updateLevelSets);
 }
 
 template <typename TEquationContainer, unsigned int VDimension>
@@ -20,7 +20,9 @@
 #ifndef itkLevelSetEvolutionBase_h
 #define itkLevelSetEvolutionBase_h
 
+#include <algorithm>
 #include <list>
+#include <vector>
 
 #include "itkImage.h"
 #include "itkDiscreteLevelSetImage.h"
@@ -28,6 +30,7 @@
 #include "itkBinaryThresholdImageFilter.h"
 #include "itkSignedMaurerDistanceMapImageFilter.h"
 #include "itkNumericTraits.h"
+#include "itkMultiThreaderBase.h"
 #include "itkLevelSetEvolutionStoppingCriterion.h"
 
 namespace itk
@@ -112,6 +115,18 @@ public:
   /** Get the number of iterations that have occurred. */
   itkGetConstMacro(NumberOfIterations, IdentifierType);
 
+  /** Set/Get whether the sparse level sets are updated concurrently, one per
+   *  work unit, at the end of each iteration. By default they are updated one
+   *  after the other, so that the update of a level set coupled to others, e.g.
+   *  by a Chan and Vese external term, sees the ones updated before it in the
+   *  same iteration. When updated concurrently, each level set sees the others
+   *  as they were at the beginning of the update, so the results only match
+   *  for uncoupled level sets. The dense level sets ignore it, as the update of
+   *  each one is already split over the work units. */
+  itkSetMacro(UpdateLevelSetsInParallel, bool);
+  itkGetConstMacro(UpdateLevelSetsInParallel, bool);
+  itkBooleanMacro(UpdateLevelSetsInParallel);
+
   /** Update the filter by computing the output level function
    * by calling Evolve() once the instantiation of necessary variables
    * is verified */
@@ -154,6 +169,13 @@ protected:
   virtual void
   UpdateLevelSets() = 0;
 
+  /** Run the filters updating the sparse level sets, one after the other or
+   *  concurrently depending on UpdateLevelSetsInParallel, and graft their
+   *  output into their input level set. */
+  template <typename TUpdateLevelSetFilter>
+  void
+  RunUpdateLevelSetFilters(const std::vector<typename TUpdateLevelSetFilter::Pointer> & updateLevelSets);
+
   virtual void
   UpdateEquations() = 0;
 
@@ -167,6 +189,7 @@ protected:
   LevelSetOutputRealType m_RMSChangeAccumulator;
   bool                   m_UserGloballyDefinedTimeStep;
   IdentifierType         m_NumberOfIterations;
+  bool                   m_UpdateLevelSetsInParallel;
 
   /** Helper members for threading. */
   typename LevelSetContainerType::Iterator m_LevelSetContainerIteratorToProcessWhenThreading;
@@ -21,6 +21,7 @@
 #define itkLevelSetEvolutionBase_hxx
 
 #include "itkLevelSetEvolutionBase.h"
+#include "itkPlatformMultiThreader.h"
 
 namespace itk
 {
@@ -32,6 +33,7 @@ LevelSetEvolutionBase<TEquationContainer, TLevelSet>::LevelSetEvolutionBase()
   this->m_RMSChangeAccumulator = 0.;
   this->m_UserGloballyDefinedTimeStep = false;
   this->m_NumberOfIterations = 0;
+  this->m_UpdateLevelSetsInParallel = false;
 }
 
 template <typename TEquationContainer, typename TLevelSet>
@@ -251,5 +253,47 @@ void
 LevelSetEvolutionBase<TEquationContainer, TLevelSet>::ComputeTimeStepForNextIteration()
 {}
 
+template <typename TEquationContainer, typename TLevelSet>
+template <typename TUpdateLevelSetFilter>
+void
+LevelSetEvolutionBase<TEquationContainer, TLevelSet>::RunUpdateLevelSetFilters(
+  const std::vector<typename TUpdateLevelSetFilter::Pointer> & updateLevelSets)
+{
+  if (this->m_UpdateLevelSetsInParallel && updateLevelSets.size() > 1)
+  {
+    // The filters only read the level sets, and the equations of the other
+    // level sets, so the outputs are grafted once all of them are computed.
+    // They run multi-threaded filters themselves, which wait for the threads
+    // of the default multi-threader, so they are run by threads of their own
+    // rather than by the pool, whose threads would all be waiting.
+    MultiThreaderBase::Pointer multiThreader = PlatformMultiThreader::New();
+    multiThreader->SetNumberOfWorkUnits(
+      std::min(multiThreader->GetMaximumNumberOfThreads(), static_cast<ThreadIdType>(updateLevelSets.size())));
+    multiThreader->ParallelizeArray(
+      0,
+      updateLevelSets.size(),
+      [&updateLevelSets](SizeValueType i) { updateLevelSets[i]->Update(); },
+      nullptr);
+
+    for (const auto & updateLevelSet : updateLevelSets)
+    {
+      updateLevelSet->GetInputLevelSet()->Graft(updateLevelSet->GetOutputLevelSet());
+    }
+  }
+  else
+  {
+    for (const auto & updateLevelSet : updateLevelSets)
+    {
+      updateLevelSet->Update();
+      updateLevelSet->GetInputLevelSet()->Graft(updateLevelSet->GetOutputLevelSet());
+    }
+  }
+
+  if (!updateLevelSets.empty())
+  {
+    this->m_RMSChangeAccumulator = updateLevelSets.back()->GetRMSChangeAccumulator();
+  }
+}
+
 } // namespace itk
 #endif // itkLevelSetEvolutionBase_hxx
@@ -50,7 +50,6 @@ UpdateMalcolmSparseLevelSet<VDimension, TEquationContainer>::Update()
 
   this->m_OutputLevelSet->SetLayer(LevelSetType::ZeroLayer(),
                                    this->m_InputLevelSet->GetLayer(LevelSetType::ZeroLayer()));
-  this->m_OutputLevelSet->SetLabelMap(this->m_InputLevelSet->GetModifiableLabelMap());
   this->m_OutputLevelSet->SetDomainOffset(this->m_Offset);
 
   using LabelMapToLabelImageFilterType = LabelMapToLabelImageFilter<LevelSetLabelMapType, LabelImageType>;
@@ -119,8 +118,7 @@ UpdateMalcolmSparseLevelSet<VDimension, TEquationContainer>::Update()
   labelImageToLabelMapFilter->SetBackgroundValue(LevelSetType::PlusOneLayer());
   labelImageToLabelMapFilter->Update();
 
-  LevelSetLabelMapPointer outputLabelMap = this->m_OutputLevelSet->GetModifiableLabelMap();
-  outputLabelMap->Graft(labelImageToLabelMapFilter->GetOutput());
+  this->m_OutputLevelSet->SetLabelMap(labelImageToLabelMapFilter->GetOutput());
 }
 
 template <unsigned int VDimension, typename TEquationContainer>
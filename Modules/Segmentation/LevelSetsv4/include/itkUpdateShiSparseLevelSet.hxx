@@ -52,7 +52,6 @@ UpdateShiSparseLevelSet<VDimension, TEquationContainer>::Update()
   this->m_OutputLevelSet->SetLayer(LevelSetType::PlusOneLayer(),
                                    this->m_InputLevelSet->GetLayer(LevelSetType::PlusOneLayer()));
 
-  this->m_OutputLevelSet->SetLabelMap(this->m_InputLevelSet->GetModifiableLabelMap());
   this->m_OutputLevelSet->SetDomainOffset(this->m_Offset);
 
   using LabelMapToLabelImageFilterType = LabelMapToLabelImageFilter<LevelSetLabelMapType, LabelImageType>;
@@ -171,8 +170,7 @@ UpdateShiSparseLevelSet<VDimension, TEquationContainer>::Update()
   labelImageToLabelMapFilter->SetBackgroundValue(LevelSetType::PlusThreeLayer());
   labelImageToLabelMapFilter->Update();
 
-  LevelSetLabelMapPointer outputLabelMap = this->m_OutputLevelSet->GetModifiableLabelMap();
-  outputLabelMap->Graft(labelImageToLabelMapFilter->GetOutput());
+  this->m_OutputLevelSet->SetLabelMap(labelImageToLabelMapFilter->GetOutput());
 }
 
 template <unsigned int VDimension, typename TEquationContainer>
@@ -76,7 +76,6 @@ UpdateWhitakerSparseLevelSet<VDimension, TLevelSetValueType, TEquationContainer>
   this->m_OutputLevelSet->SetDomainOffset(this->m_Offset);
   this->m_TempLevelSet->SetDomainOffset(this->m_Offset);
 
-  this->m_OutputLevelSet->SetLabelMap(this->m_InputLevelSet->GetModifiableLabelMap());
 
   typename LabelMapToLabelImageFilterType::Pointer labelMapToLabelImageFilter = LabelMapToLabelImageFilterType::New();
   labelMapToLabelImageFilter->SetInput(this->m_InputLevelSet->GetLabelMap());
@@ -172,7 +171,7 @@ UpdateWhitakerSparseLevelSet<VDimension, TLevelSetValueType, TEquationContainer>
   labelImageToLabelMapFilter->SetBackgroundValue(LevelSetType::PlusThreeLayer());
   labelImageToLabelMapFilter->Update();
 
-  this->m_OutputLevelSet->GetModifiableLabelMap()->Graft(labelImageToLabelMapFilter->GetOutput());
+  this->m_OutputLevelSet->SetLabelMap(labelImageToLabelMapFilter->GetOutput());
   this->m_TempPhi.clear();
 }
 
@@ -0,0 +1,263 @@
+/*=========================================================================
+ *
+ *  Copyright NumFOCUS
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include "itkBinaryImageToLevelSetImageAdaptor.h"
+#include "itkLevelSetContainer.h"
+#include "itkLevelSetDomainMapImageFilter.h"
+#include "itkLevelSetEquationChanAndVeseExternalTerm.h"
+#include "itkLevelSetEquationChanAndVeseInternalTerm.h"
+#include "itkLevelSetEquationContainer.h"
+#include "itkLevelSetEquationTermContainer.h"
+#include "itkLevelSetEvolution.h"
+#include "itkLevelSetEvolutionNumberOfIterationsStoppingCriterion.h"
+#include "itkSinRegularizedHeavisideStepFunction.h"
+#include "itkTestingMacros.h"
+#include "itkTimeProbe.h"
+
+namespace
+{
+constexpr unsigned int Dimension = 2;
+constexpr unsigned int NumberOfLevelSets = 6;
+
+using InputImageType = itk::Image<unsigned short, Dimension>;
+
+// Bright rectangles of several intensities on a noisy background
+InputImageType::Pointer
+CreateImage()
+{
+  auto image = InputImageType::New();
+  image->SetRegions(InputImageType::SizeType{ { 90, 70 } });
+  image->Allocate();
+
+  itk::ImageRegionIteratorWithIndex<InputImageType> it(image, image->GetLargestPossibleRegion());
+  unsigned int                                      state = 1357;
+  for (; !it.IsAtEnd(); ++it)
+  {
+    state = state * 1103515245u + 12345u;
+    const InputImageType::IndexType & idx = it.GetIndex();
+    unsigned int                      value = 20 + (state >> 16) % 30;
+    if ((idx[0] / 15) % 2 == 1 && (idx[1] / 12) % 2 == 1)
+    {
+      value += 100 + 20 * static_cast<unsigned int>(idx[0] / 30);
+    }
+    it.Set(static_cast<InputImageType::PixelType>(value));
+  }
+  return image;
+}
+
+// Evolves level sets initialized with a rectangle inside a different bright
+// rectangle for each one, with the Chan and Vese terms, which couple the
+// level sets where their domains overlap
+template <typename TLevelSet>
+typename itk::LevelSetContainer<itk::IdentifierType, TLevelSet>::Pointer
+Evolve(InputImageType * input, bool coupled, bool inParallel, const std::string & description)
+{
+  using LevelSetContainerType = itk::LevelSetContainer<itk::IdentifierType, TLevelSet>;
+  using InternalTermType = itk::LevelSetEquationChanAndVeseInternalTerm<InputImageType, LevelSetContainerType>;
+  using ExternalTermType = itk::LevelSetEquationChanAndVeseExternalTerm<InputImageType, LevelSetContainerType>;
+  using TermContainerType = itk::LevelSetEquationTermContainer<InputImageType, LevelSetContainerType>;
+  using EquationContainerType = itk::LevelSetEquationContainer<TermContainerType>;
+  using EvolutionType = itk::LevelSetEvolution<EquationContainerType, TLevelSet>;
+  using StoppingCriterionType = itk::LevelSetEvolutionNumberOfIterationsStoppingCriterion<LevelSetContainerType>;
+  using AdaptorType = itk::BinaryImageToLevelSetImageAdaptor<InputImageType, TLevelSet>;
+  using HeavisideType = itk::SinRegularizedHeavisideStepFunction<typename TLevelSet::OutputRealType,
+                                                                 typename TLevelSet::OutputRealType>;
+  using IdListType = std::list<itk::IdentifierType>;
+  using IdListImageType = itk::Image<IdListType, Dimension>;
+  using CacheImageType = itk::Image<short, Dimension>;
+  using DomainMapImageFilterType = itk::LevelSetDomainMapImageFilter<IdListImageType, CacheImageType>;
+
+  // Each level set has its own domain around its bright rectangle, unless
+  // they are coupled, where all of them are defined everywhere. The ids of
+  // the domain map start at 1.
+  auto idImage = IdListImageType::New();
+  idImage->SetRegions(input->GetLargestPossibleRegion());
+  idImage->Allocate();
+
+  itk::ImageRegionIteratorWithIndex<IdListImageType> idIt(idImage, idImage->GetLargestPossibleRegion());
+  for (; !idIt.IsAtEnd(); ++idIt)
+  {
+    IdListType ids;
+    if (coupled)
+    {
+      for (unsigned int i = 0; i < NumberOfLevelSets; ++i)
+      {
+        ids.push_back(i + 1);
+      }
+    }
+    else
+    {
+      const itk::IndexValueType column = idIt.GetIndex()[0] < 37 ? 0 : (idIt.GetIndex()[0] < 67 ? 1 : 2);
+      const itk::IndexValueType row = idIt.GetIndex()[1] < 30 ? 0 : 1;
+      ids.push_back(static_cast<itk::IdentifierType>(column + 3 * row + 1));
+    }
+    idIt.Set(ids);
+  }
+
+  auto domainMapFilter = DomainMapImageFilterType::New();
+  domainMapFilter->SetInput(idImage);
+  domainMapFilter->Update();
+
+  auto heaviside = HeavisideType::New();
+  heaviside->SetEpsilon(1.0);
+
+  auto levelSets = LevelSetContainerType::New();
+  levelSets->SetHeaviside(heaviside);
+  levelSets->SetDomainMapFilter(domainMapFilter);
+
+  auto equations = EquationContainerType::New();
+  equations->SetLevelSetContainer(levelSets);
+
+  for (unsigned int i = 0; i < NumberOfLevelSets; ++i)
+  {
+    auto binary = InputImageType::New();
+    binary->SetRegions(input->GetLargestPossibleRegion());
+    binary->Allocate();
+    binary->FillBuffer(0);
+
+    const itk::IndexValueType                column = i % 3;
+    const itk::IndexValueType                row = i / 3;
+    const InputImageType::IndexType          start = { { 17 + 30 * column, 14 + 24 * row } };
+    itk::ImageRegionIterator<InputImageType> binaryIt(binary, InputImageType::RegionType(start, { { 10, 8 } }));
+    for (; !binaryIt.IsAtEnd(); ++binaryIt)
+    {
+      binaryIt.Set(1);
+    }
+
+    auto adaptor = AdaptorType::New();
+    adaptor->SetInputImage(binary);
+    adaptor->Initialize();
+    levelSets->AddLevelSet(i, adaptor->GetModifiableLevelSet(), false);
+
+    auto internalTerm = InternalTermType::New();
+    internalTerm->SetInput(input);
+    internalTerm->SetCoefficient(1.0);
+
+    auto externalTerm = ExternalTermType::New();
+    externalTerm->SetInput(input);
+    externalTerm->SetCoefficient(1.0);
+
+    auto terms = TermContainerType::New();
+    terms->SetInput(input);
+    terms->SetCurrentLevelSetId(i);
+    terms->SetLevelSetContainer(levelSets);
+    terms->AddTerm(0, internalTerm);
+    terms->AddTerm(1, externalTerm);
+    equations->AddEquation(i, terms);
+  }
+
+  auto criterion = StoppingCriterionType::New();
+  criterion->SetNumberOfIterations(8);
+
+  auto evolution = EvolutionType::New();
+  evolution->SetEquationContainer(equations);
+  evolution->SetStoppingCriterion(criterion);
+  evolution->SetLevelSetContainer(levelSets);
+  evolution->SetUpdateLevelSetsInParallel(inParallel);
+
+  itk::TimeProbe probe;
+  probe.Start();
+  evolution->Update();
+  probe.Stop();
+  std::cout << description << (inParallel ? ", parallel update: " : ", serial update: ") << probe.GetTotal() << " s"
+            << std::endl;
+
+  return levelSets;
+}
+
+// Compares the values and labels of all the level sets over the whole image
+template <typename TLevelSet>
+bool
+CompareLevelSets(const itk::LevelSetContainer<itk::IdentifierType, TLevelSet> * levelSets,
+                 const itk::LevelSetContainer<itk::IdentifierType, TLevelSet> * reference,
+                 const InputImageType *                                         input,
+                 const std::string &                                            description)
+{
+  for (unsigned int i = 0; i < NumberOfLevelSets; ++i)
+  {
+    const TLevelSet * levelSet = levelSets->GetLevelSet(i);
+    const TLevelSet * referenceLevelSet = reference->GetLevelSet(i);
+
+    itk::ImageRegionConstIteratorWithIndex<InputImageType> it(input, input->GetLargestPossibleRegion());
+    for (; !it.IsAtEnd(); ++it)
+    {
+      const InputImageType::IndexType & idx = it.GetIndex();
+      if (levelSet->Evaluate(idx) != referenceLevelSet->Evaluate(idx) ||
+          levelSet->GetLabelMap()->GetPixel(idx) != referenceLevelSet->GetLabelMap()->GetPixel(idx))
+      {
+        std::cerr << "Test failed for " << description << std::endl;
+        std::cerr << "Error for level set " << i << " at index " << idx << std::endl;
+        std::cerr << "Expected: " << referenceLevelSet->Evaluate(idx) << ", but got: " << levelSet->Evaluate(idx)
+                  << std::endl;
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+// Checks that the uncoupled level sets updated concurrently are the same as
+// when updated one after the other, and that the coupled ones can be
+// updated concurrently
+template <typename TLevelSet>
+bool
+CheckParallelUpdate(InputImageType * input, const std::string & description)
+{
+  const auto reference = Evolve<TLevelSet>(input, false, false, description);
+  const auto levelSets = Evolve<TLevelSet>(input, false, true, description);
+  bool       passed = CompareLevelSets<TLevelSet>(levelSets, reference, input, description);
+
+  const std::string coupledDescription = description + ", coupled";
+  Evolve<TLevelSet>(input, true, false, coupledDescription);
+  const auto coupled = Evolve<TLevelSet>(input, true, true, coupledDescription);
+  const auto coupledAgain = Evolve<TLevelSet>(input, true, true, coupledDescription);
+  passed &= CompareLevelSets<TLevelSet>(coupledAgain, coupled, input, coupledDescription + ", parallel update");
+
+  return passed;
+}
+} // namespace
+
+// Checks that updating the sparse level sets concurrently at the end of
+// each iteration gives the same results as updating them one after the
+// other, when the level sets are not coupled, and that the coupled ones
+// updated concurrently do not depend on the scheduling of the updates.
+int
+itkMultiLevelSetSparseParallelUpdateTest(int, char *[])
+{
+  const InputImageType::Pointer input = CreateImage();
+
+  using WhitakerLevelSetType = itk::WhitakerSparseLevelSetImage<float, Dimension>;
+  using ShiLevelSetType = itk::ShiSparseLevelSetImage<Dimension>;
+  using MalcolmLevelSetType = itk::MalcolmSparseLevelSetImage<Dimension>;
+
+  {
+    using LevelSetContainerType = itk::LevelSetContainer<itk::IdentifierType, ShiLevelSetType>;
+    using TermContainerType = itk::LevelSetEquationTermContainer<InputImageType, LevelSetContainerType>;
+    using EvolutionType = itk::LevelSetEvolution<itk::LevelSetEquationContainer<TermContainerType>, ShiLevelSetType>;
+    auto evolution = EvolutionType::New();
+    ITK_TEST_SET_GET_BOOLEAN(evolution, UpdateLevelSetsInParallel, false);
+  }
+
+  bool passed = true;
+  passed &= CheckParallelUpdate<WhitakerLevelSetType>(input, "Whitaker");
+  passed &= CheckParallelUpdate<ShiLevelSetType>(input, "Shi");
+  passed &= CheckParallelUpdate<MalcolmLevelSetType>(input, "Malcolm");
+
+  std::cout << "Test finished." << std::endl;
+  return passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -19,6 +19,9 @@
 #define itkMorphologicalWatershedFromMarkersImageFilter_h
 
 #include "itkImageToImageFilter.h"
+#include <algorithm>
+#include <map>
+#include <vector>
 
 namespace itk
 {
@@ -65,6 +68,15 @@ namespace itk
  * Chapter 9.2 of Pierre Soille's book "Morphological Image Analysis:
  * Principles and Applications", Second Edition, Springer, 2003.
  *
+ * The search of the pixels which start the flooding, at the border of
+ * the markers, is done in parallel over slabs of the image. The flooding
+ * of a gray level proceeds in waves: a wave is made of the pixels reached
+ * by the previous one, and the large waves are flooded in parallel. When
+ * several pixels of a wave reach the same pixel, the first one in the order
+ * of the wave labels it, unless DeterministicOff() is used. For
+ * integer input pixel types of 8 or 16 bits, the hierarchical queue is an
+ * array of FIFOs indexed by gray level.
+ *
  * This code was contributed in the Insight Journal paper:
  * "The watershed transform in ITK - discussion and new developments"
  * by Beare R., Lehmann G.
@@ -162,6 +174,18 @@ public:
   itkGetConstReferenceMacro(MarkWatershedLine, bool);
   itkBooleanMacro(MarkWatershedLine);
 
+  /**
+   * Set/Get whether the labels must be the same as the ones of the serial
+   * flooding, whatever the number of work units. The pixels reached by
+   * several pixels of a wave are then labeled as if the wave was flooded in
+   * order, at the cost of a second pass over the neighbors of the wave.
+   * When off, the label of these pixels depends on the thread schedule.
+   * Default is true.
+   */
+  itkSetMacro(Deterministic, bool);
+  itkGetConstReferenceMacro(Deterministic, bool);
+  itkBooleanMacro(Deterministic);
+
 protected:
   MorphologicalWatershedFromMarkersImageFilter();
   ~MorphologicalWatershedFromMarkersImageFilter() override = default;
@@ -180,7 +204,8 @@ protected:
   void
   EnlargeOutputRequestedRegion(DataObject * itkNotUsed(output)) override;
 
-  /** The filter is single threaded. */
+  /** The initialization and the flooding of the large waves are
+   * multithreaded. */
   void
   GenerateData() override;
 
@@ -188,6 +213,80 @@ private:
   bool m_FullyConnected{ false };
 
   bool m_MarkWatershedLine{ true };
+
+  bool m_Deterministic{ true };
+
+  using BufferOffsetType = typename LabelImageType::OffsetValueType;
+
+  /** Hierarchical queue of pixels, given by their offset in the buffers,
+   * where the pixels of a level are popped all at once, in the order they
+   * were pushed. For input pixel types with at most 65536 values, there is
+   * one FIFO per level in an array, and a map of FIFOs otherwise. */
+  class HierarchicalQueue
+  {
+  public:
+    HierarchicalQueue()
+      : m_UseArray(NumericTraits<InputImagePixelType>::is_integer && sizeof(InputImagePixelType) <= 2)
+      , m_Levels(m_UseArray ? (1u << (8 * std::min<size_t>(sizeof(InputImagePixelType), 2))) : 0)
+    {}
+
+    bool
+    Empty() const
+    {
+      return m_UseArray ? m_Size == 0 : m_Map.empty();
+    }
+
+    void
+    Push(InputImagePixelType value, BufferOffsetType offset)
+    {
+      if (m_UseArray)
+      {
+        const SizeValueType level = GetLevel(value);
+        m_Levels[level].push_back(offset);
+        m_Current = std::min(m_Current, level);
+        ++m_Size;
+      }
+      else
+      {
+        m_Map[value].push_back(offset);
+      }
+    }
+
+    /** Move the pixels of the lowest level to fifo, and return that level. */
+    InputImagePixelType
+    PopLevel(std::vector<BufferOffsetType> & fifo)
+    {
+      fifo.clear();
+      if (m_UseArray)
+      {
+        while (m_Levels[m_Current].empty())
+        {
+          ++m_Current;
+        }
+        fifo.swap(m_Levels[m_Current]);
+        m_Size -= fifo.size();
+        return static_cast<InputImagePixelType>(NumericTraits<InputImagePixelType>::NonpositiveMin() + m_Current);
+      }
+      const auto                level = m_Map.begin();
+      const InputImagePixelType value = level->first;
+      fifo.swap(level->second);
+      m_Map.erase(level);
+      return value;
+    }
+
+  private:
+    static SizeValueType
+    GetLevel(InputImagePixelType value)
+    {
+      return static_cast<SizeValueType>(value - NumericTraits<InputImagePixelType>::NonpositiveMin());
+    }
+
+    bool                                                          m_UseArray;
+    std::vector<std::vector<BufferOffsetType>>                    m_Levels;
+    SizeValueType                                                 m_Current{ 0 };
+    SizeValueType                                                 m_Size{ 0 };
+    std::map<InputImagePixelType, std::vector<BufferOffsetType>> m_Map;
+  };
 }; // end of class
 } // end namespace itk
 
@@ -19,16 +19,12 @@
 #define itkMorphologicalWatershedFromMarkersImageFilter_hxx
 
 #include <algorithm>
-#include <queue>
-#include <list>
+#include <atomic>
+#include <functional>
 #include "itkMorphologicalWatershedFromMarkersImageFilter.h"
 #include "itkProgressReporter.h"
-#include "itkImageRegionIterator.h"
+#include "itkProgressTransformer.h"
 #include "itkImageRegionConstIteratorWithIndex.h"
-#include "itkConstShapedNeighborhoodIterator.h"
-#include "itkConstantBoundaryCondition.h"
-#include "itkSize.h"
-#include "itkConnectedComponentAlgorithm.h"
 
 namespace itk
 {
@@ -86,9 +82,9 @@ MorphologicalWatershedFromMarkersImageFilter<TInputImage, TLabelImage>::Generate
   // The 2 algorithms are very similar and so are integrated in the same filter.
 
   //---------------------------------------------------------------------------
-  // declare the vars common to the 2 algorithms: constants, iterators,
-  // hierarchical queue, progress reporter, and status image
-  // also allocate output images and verify preconditions
+  // declare the vars common to the 2 algorithms: constants, neighbors,
+  // hierarchical queue and status buffer. Also allocate output images and
+  // verify preconditions
   //---------------------------------------------------------------------------
 
   // the label used to find background in the marker image
@@ -102,214 +98,574 @@ MorphologicalWatershedFromMarkersImageFilter<TInputImage, TLabelImage>::Generate
   const InputImageType * inputImage = this->GetInput();
   LabelImageType *       outputImage = this->GetOutput();
 
-  // Set up the progress reporter
-  // we can't found the exact number of pixel to process in the 2nd pass, so we
-  // use the maximum number possible.
-  ProgressReporter progress(this, 0, markerImage->GetRequestedRegion().GetNumberOfPixels() * 2);
-
   // mask and marker must have the same size
   if (markerImage->GetRequestedRegion().GetSize() != inputImage->GetRequestedRegion().GetSize())
   {
     itkExceptionMacro(<< "Marker and input must have the same size.");
   }
 
-  // FAH (in french: File d'Attente Hierarchique)
-  using QueueType = std::queue<IndexType>;
-  using MapType = std::map<InputImagePixelType, QueueType>;
-  MapType fah;
-
-  // the radius which will be used for all the shaped iterators
-  Size<ImageDimension> radius;
-  radius.Fill(1);
-
-  // iterator for the marker image
-  using MarkerIteratorType = ConstShapedNeighborhoodIterator<LabelImageType>;
-  typename MarkerIteratorType::ConstIterator nmIt;
-  MarkerIteratorType                         markerIt(radius, markerImage, markerImage->GetRequestedRegion());
-  // add a boundary constant to avoid adding pixels on the border in the fah
-  ConstantBoundaryCondition<LabelImageType> lcbc;
-  lcbc.SetConstant(NumericTraits<LabelImagePixelType>::max());
-  markerIt.OverrideBoundaryCondition(&lcbc);
-  setConnectivity(&markerIt, m_FullyConnected);
-
-  // iterator for the input image
-  using InputIteratorType = ConstShapedNeighborhoodIterator<InputImageType>;
-  InputIteratorType                         inputIt(radius, inputImage, inputImage->GetRequestedRegion());
-  typename InputIteratorType::ConstIterator niIt;
-  setConnectivity(&inputIt, m_FullyConnected);
-
-  // iterator for the output image
-  using OutputIteratorType = ShapedNeighborhoodIterator<LabelImageType>;
-  using OffsetType = typename OutputIteratorType::OffsetType;
-  typename OutputIteratorType::Iterator noIt;
-  OutputIteratorType                    outputIt(radius, outputImage, outputImage->GetRequestedRegion());
-  setConnectivity(&outputIt, m_FullyConnected);
+  // the three images are accessed through their buffers, with the same
+  // offsets since they have the same size
+  const LabelImageRegionType  region = outputImage->GetBufferedRegion();
+  const LabelImagePixelType * marker = markerImage->GetBufferPointer();
+  const InputImagePixelType * input = inputImage->GetBufferPointer();
+  LabelImagePixelType *       output = outputImage->GetBufferPointer();
+
+  // the neighbors, in the order of the neighborhood, as offsets in the
+  // buffers and as index offsets
+  using OffsetType = typename LabelImageType::OffsetType;
+  std::vector<BufferOffsetType> neighbors;
+  std::vector<OffsetType>       neighborOffsets;
+  {
+    unsigned int numberOfNeighborhoodPixels = 1;
+    for (unsigned int d = 0; d < ImageDimension; ++d)
+    {
+      numberOfNeighborhoodPixels *= 3;
+    }
+    const BufferOffsetType * offsetTable = outputImage->GetOffsetTable();
+    for (unsigned int i = 0; i < numberOfNeighborhoodPixels; ++i)
+    {
+      OffsetType       offset;
+      BufferOffsetType bufferOffset = 0;
+      unsigned int     numberOfNonZero = 0;
+      for (unsigned int d = 0, rest = i; d < ImageDimension; ++d, rest /= 3)
+      {
+        offset[d] = static_cast<OffsetValueType>(rest % 3) - 1;
+        bufferOffset += offset[d] * offsetTable[d];
+        numberOfNonZero += (offset[d] != 0);
+      }
+      if (numberOfNonZero == 0 || (!m_FullyConnected && numberOfNonZero > 1))
+      {
+        continue;
+      }
+      neighbors.push_back(bufferOffset);
+      neighborOffsets.push_back(offset);
+    }
+  }
+
+  // the pixels far enough from the border of the image have all their
+  // neighbors in the image
+  const IndexType &   regionIndex = region.GetIndex();
+  const SizeValueType numberOfNeighbors = neighbors.size();
+  auto                isInner = [&](const IndexType & idx) {
+    for (unsigned int d = 0; d < ImageDimension; ++d)
+    {
+      if (idx[d] <= regionIndex[d] || idx[d] + 1 >= regionIndex[d] + static_cast<IndexValueType>(region.GetSize(d)))
+      {
+        return false;
+      }
+    }
+    return true;
+  };
+
+  // status of the pixels: already processed or in the queue. Pixels out of
+  // the image are considered as processed.
+  std::vector<unsigned char> status;
+  if (m_MarkWatershedLine)
+  {
+    status.assign(region.GetNumberOfPixels(), 0);
+  }
 
   //---------------------------------------------------------------------------
-  // Meyer's algorithm
+  // first stage, in parallel over slabs of the image:
+  //  - copy markers pixels to output image, and the other pixels as
+  //    watershed
+  //  - with Meyer's algorithm, set markers pixels to already processed
+  //    status and find the background pixels with marker pixel(s) in their
+  //    neighborhood
+  //  - with Beucher's algorithm, find the marker pixels with background
+  //    pixel(s) in their neighborhood
+  // Each slab keeps its pixels in raster order, so that the queue is filled
+  // in the same order as with a single thread.
   //---------------------------------------------------------------------------
-  if (m_MarkWatershedLine)
+  constexpr unsigned int SlabDimension = ImageDimension - 1;
+  const SizeValueType    numberOfPlanes = region.GetSize(SlabDimension);
+  const SizeValueType    numberOfSlabs =
+    std::max<SizeValueType>(1, std::min<SizeValueType>(this->GetNumberOfWorkUnits(), numberOfPlanes));
+  std::vector<std::vector<BufferOffsetType>> seeds(numberOfSlabs);
+
+  this->GetMultiThreader()->SetNumberOfWorkUnits(this->GetNumberOfWorkUnits());
   {
-    // first stage:
-    //  - set markers pixels to already processed status
-    //  - copy markers pixels to output image
-    //  - init FAH with indexes of background pixels with marker pixel(s) in
-    //    their neighborhood
-
-    ConstantBoundaryCondition<LabelImageType> lcbc2;
-    // outside pixel are watershed so they won't be use to find real watershed
-    // pixels
-    lcbc2.SetConstant(wsLabel);
-    outputIt.OverrideBoundaryCondition(&lcbc2);
-
-    // create a temporary image to store the state of each pixel (processed or
-    // not)
-    using StatusImageType = Image<bool, ImageDimension>;
-    typename StatusImageType::Pointer statusImage = StatusImageType::New();
-    statusImage->SetRegions(markerImage->GetLargestPossibleRegion());
-    statusImage->Allocate();
-
-    // iterator for the status image
-    using StatusIteratorType = ShapedNeighborhoodIterator<StatusImageType>;
-    typename StatusIteratorType::Iterator      nsIt;
-    StatusIteratorType                         statusIt(radius, statusImage, outputImage->GetRequestedRegion());
-    ConstantBoundaryCondition<StatusImageType> bcbc;
-    bcbc.SetConstant(true); // outside pixel are already processed
-    statusIt.OverrideBoundaryCondition(&bcbc);
-    setConnectivity(&statusIt, m_FullyConnected);
-
-    // the status image must be initialized before the first stage. In the
-    // first stage, the set to true are the neighbors of the marker (and the
-    // marker) so it's difficult (impossible ?) to init the status image at
-    // the same time
-    // the overhead should be small
-    statusImage->FillBuffer(false);
-
-    for (markerIt.GoToBegin(), statusIt.GoToBegin(), outputIt.GoToBegin(), inputIt.GoToBegin(); !markerIt.IsAtEnd();
-         ++markerIt, ++outputIt)
-    {
-      LabelImagePixelType markerPixel = markerIt.GetCenterPixel();
-      if (markerPixel != bgLabel)
-      {
-        IndexType idx = markerIt.GetIndex();
-
-        // move the iterators to the right place
-        OffsetType shift = idx - statusIt.GetIndex();
-        statusIt += shift;
-        inputIt += shift;
-
-        // this pixel belongs to a marker
-        // mark it as already processed
-        statusIt.SetCenterPixel(true);
-        // copy it to the output image
-        outputIt.SetCenterPixel(markerPixel);
-        // and increase progress because this pixel will not be used in the
-        // flooding stage.
-        progress.CompletedPixel();
-
-        // search the background pixels in the neighborhood
-        for (nmIt = markerIt.Begin(), nsIt = statusIt.Begin(), niIt = inputIt.Begin(); nmIt != markerIt.End();
-             nmIt++, nsIt++, niIt++)
+    ProgressTransformer progress(0.0f, 0.5f, this);
+    this->GetMultiThreader()->ParallelizeArray(
+      0,
+      numberOfSlabs,
+      [&](SizeValueType s) {
+        LabelImageRegionType slab = region;
+        slab.SetIndex(SlabDimension,
+                      regionIndex[SlabDimension] + static_cast<IndexValueType>(numberOfPlanes * s / numberOfSlabs));
+        slab.SetSize(SlabDimension, numberOfPlanes * (s + 1) / numberOfSlabs - numberOfPlanes * s / numberOfSlabs);
+
+        ImageRegionConstIteratorWithIndex<LabelImageType> it(markerImage, slab);
+        for (; !it.IsAtEnd(); ++it)
         {
-          if (!nsIt.Get() && nmIt.Get() == bgLabel)
+          const BufferOffsetType p = markerImage->ComputeOffset(it.GetIndex());
+          if (marker[p] == bgLabel)
+          {
+            // Some pixels may be never processed so, by default, non marked
+            // pixels must be marked as watershed
+            output[p] = wsLabel;
+            continue;
+          }
+          // this pixel belongs to a marker: copy it to the output image
+          output[p] = marker[p];
+
+          const IndexType & idx = it.GetIndex();
+          const bool        inner = isInner(idx);
+          if (m_MarkWatershedLine)
+          {
+            // mark it as already processed
+            status[p] = 1;
+            // search the background pixels in the neighborhood, which are
+            // added to the queue by the first marker pixel to see them
+            for (SizeValueType i = 0; i < numberOfNeighbors; ++i)
+            {
+              const IndexType nIdx = idx + neighborOffsets[i];
+              const bool      nInner = isInner(nIdx);
+              if ((!inner && !region.IsInside(nIdx)) || marker[p + neighbors[i]] != bgLabel)
+              {
+                continue;
+              }
+              bool first = true;
+              for (SizeValueType j = 0; j < numberOfNeighbors && first; ++j)
+              {
+                const BufferOffsetType q = p + neighbors[i] + neighbors[j];
+                first = q >= p || (!nInner && !region.IsInside(nIdx + neighborOffsets[j])) || marker[q] == bgLabel;
+              }
+              if (first)
+              {
+                seeds[s].push_back(p + neighbors[i]);
+              }
+            }
+          }
+          else
           {
-            // this neighbor is a background pixel and is not already
-            // processed; add its index to fah
-            fah[niIt.Get()].push(markerIt.GetIndex() + nmIt.GetNeighborhoodOffset());
-            // mark it as already in the fah to avoid adding it several times
-            nsIt.Set(true);
+            // search if it has background pixel in its neighborhood
+            for (SizeValueType i = 0; i < numberOfNeighbors; ++i)
+            {
+              if ((inner || region.IsInside(idx + neighborOffsets[i])) && marker[p + neighbors[i]] == bgLabel)
+              {
+                seeds[s].push_back(p);
+                break;
+              }
+            }
           }
         }
+      },
+      progress.GetProcessObject());
+  }
+
+  // FAH (in french: File d'Attente Hierarchique)
+  HierarchicalQueue fah;
+  for (const std::vector<BufferOffsetType> & slabSeeds : seeds)
+  {
+    for (const BufferOffsetType p : slabSeeds)
+    {
+      if (m_MarkWatershedLine)
+      {
+        // mark it as already in the fah to avoid adding it several times
+        status[p] = 1;
       }
-      else
+      fah.Push(input[p], p);
+    }
+  }
+  seeds.clear();
+
+  // we can't found the exact number of pixel to process in the 2nd pass, so
+  // we use the maximum number possible.
+  ProgressReporter progress(this, 0, region.GetNumberOfPixels(), 100, 0.5f, 0.5f);
+
+  //---------------------------------------------------------------------------
+  // second stage: flooding, level by level. The pixels of a level are
+  // flooded in waves, a wave being made of the pixels added to the level by
+  // the previous wave, which is the order of the FIFO of the serial
+  // algorithm. The large waves are flooded in parallel over chunks of the
+  // wave, and the pixels reached by several pixels of the wave are claimed
+  // in the claims buffer, by the first pixel to reach them, or in the
+  // deterministic mode by the first one in the order of the wave, as in
+  // the serial algorithm. Each chunk keeps the pixels it adds in the order
+  // of the wave, so that the next wave and the queue are filled in that
+  // order in the deterministic mode.
+  //---------------------------------------------------------------------------
+  constexpr SizeValueType minimumParallelWaveSize = 4096;
+  const SizeValueType     numberOfChunks = this->GetNumberOfWorkUnits();
+
+  struct WaveChunk
+  {
+    std::vector<BufferOffsetType>                                   NextWave;
+    std::vector<std::pair<InputImagePixelType, BufferOffsetType>> HigherLevels;
+    std::vector<SizeValueType>                                      Conflicts;
+    std::vector<BufferOffsetType>                                   Claimed;
+  };
+  std::vector<WaveChunk> chunks(numberOfChunks);
+
+  // claims hold the position of the claiming pixel in the waves, counted
+  // from 1 over all the parallel waves, so that they are never reset
+  std::vector<std::atomic<SizeValueType>> claims;
+  SizeValueType                           numberOfClaimingPixels = 0;
+  std::vector<unsigned char>              collided;
+
+  std::vector<BufferOffsetType> wave;
+  std::vector<BufferOffsetType> nextWave;
+
+  // the pixels of the wave which have all their neighbors in the image, so
+  // that their index is only computed once
+  std::vector<unsigned char> innerPixels;
+  auto                       markInnerPixels = [&](SizeValueType first, SizeValueType last) {
+    for (SizeValueType k = first; k < last; ++k)
+    {
+      innerPixels[k] = isInner(outputImage->ComputeIndex(wave[k]));
+    }
+  };
+
+  // calls chunkFunction(chunk, first, last) for the chunks of the wave
+  auto parallelizeWave = [&](const std::function<void(WaveChunk &, SizeValueType, SizeValueType)> & chunkFunction) {
+    this->GetMultiThreader()->ParallelizeArray(
+      0,
+      numberOfChunks,
+      [&](SizeValueType c) {
+        chunkFunction(chunks[c], wave.size() * c / numberOfChunks, wave.size() * (c + 1) / numberOfChunks);
+      },
+      nullptr);
+  };
+
+  // the pixels added by the chunks go to the next wave or to the queue,
+  // in the order of the chunks. Returns the number of added pixels.
+  auto gatherChunks = [&]() {
+    SizeValueType numberOfAddedPixels = 0;
+    for (WaveChunk & chunk : chunks)
+    {
+      numberOfAddedPixels += chunk.NextWave.size() + chunk.HigherLevels.size();
+      nextWave.insert(nextWave.end(), chunk.NextWave.begin(), chunk.NextWave.end());
+      for (const auto & pixel : chunk.HigherLevels)
       {
-        // Some pixels may be never processed so, by default, non marked pixels
-        // must be marked as watershed
-        outputIt.SetCenterPixel(wsLabel);
+        fah.Push(pixel.first, pixel.second);
       }
-      // one more pixel done in the init stage
-      progress.CompletedPixel();
+      chunk.NextWave.clear();
+      chunk.HigherLevels.clear();
+    }
+    return numberOfAddedPixels;
+  };
+
+  // claims the neighbors which are not yet processed, as given by
+  // isAvailable, of the pixels of the wave which propagate their label, as
+  // given by propagates. addPixel(chunk, pixel, claimingPosition) is called
+  // for each claimed pixel, in the order of the wave in the deterministic
+  // mode.
+  auto claimNeighbors = [&](const InputImagePixelType &                                  currentValue,
+                            const std::function<bool(SizeValueType)> &                   propagates,
+                            const std::function<bool(BufferOffsetType)> &                isAvailable,
+                            const std::function<void(BufferOffsetType, SizeValueType)> & addPixel) {
+    if (claims.empty())
+    {
+      claims = std::vector<std::atomic<SizeValueType>>(region.GetNumberOfPixels());
     }
-    // fill the borders of the status image with "true"
-    // FillSides<StatusImageType>(statusImage, true);
-    // Now disable the boundary checks
-    // outputIt.NeedToUseBoundaryConditionOff();
-    // statusIt.NeedToUseBoundaryConditionOff();
-    // inputIt.NeedToUseBoundaryConditionOff();
-    // end of init stage
+    const SizeValueType firstClaimingPixel = numberOfClaimingPixels + 1;
+    numberOfClaimingPixels += wave.size();
 
-    // flooding
-    // init all the iterators
-    outputIt.GoToBegin();
-    statusIt.GoToBegin();
-    inputIt.GoToBegin();
+    auto addNeighbor = [&](WaveChunk & chunk, BufferOffsetType n, SizeValueType k) {
+      addPixel(n, k);
+      const InputImagePixelType GrayVal = input[n];
+      if (GrayVal <= currentValue)
+      {
+        chunk.NextWave.push_back(n);
+      }
+      else
+      {
+        chunk.HigherLevels.emplace_back(GrayVal, n);
+      }
+    };
 
-    // and start flooding
-    while (!fah.empty())
+    if (m_Deterministic)
+    {
+      // the first pixel in the order of the wave wins
+      parallelizeWave([&](WaveChunk &, SizeValueType first, SizeValueType last) {
+        for (SizeValueType k = first; k < last; ++k)
+        {
+          if (!propagates(k))
+          {
+            continue;
+          }
+          const BufferOffsetType p = wave[k];
+          const bool             inner = innerPixels[k];
+          const IndexType        idx = inner ? IndexType() : outputImage->ComputeIndex(p);
+          const SizeValueType    claim = firstClaimingPixel + k;
+          for (SizeValueType i = 0; i < numberOfNeighbors; ++i)
+          {
+            const BufferOffsetType n = p + neighbors[i];
+            if ((inner || region.IsInside(idx + neighborOffsets[i])) && isAvailable(n))
+            {
+              SizeValueType current = claims[n].load(std::memory_order_relaxed);
+              while ((current == 0 || claim < current) &&
+                     !claims[n].compare_exchange_weak(current, claim, std::memory_order_relaxed))
+              {
+              }
+            }
+          }
+        }
+      });
+      parallelizeWave([&](WaveChunk & chunk, SizeValueType first, SizeValueType last) {
+        for (SizeValueType k = first; k < last; ++k)
+        {
+          if (!propagates(k))
+          {
+            continue;
+          }
+          const BufferOffsetType p = wave[k];
+          const bool             inner = innerPixels[k];
+          const IndexType        idx = inner ? IndexType() : outputImage->ComputeIndex(p);
+          const SizeValueType    claim = firstClaimingPixel + k;
+          for (SizeValueType i = 0; i < numberOfNeighbors; ++i)
+          {
+            const BufferOffsetType n = p + neighbors[i];
+            if ((inner || region.IsInside(idx + neighborOffsets[i])) &&
+                claims[n].load(std::memory_order_relaxed) == claim)
+            {
+              addNeighbor(chunk, n, k);
+            }
+          }
+        }
+      });
+    }
+    else
     {
-      // store the current vars
-      InputImagePixelType currentValue = fah.begin()->first;
-      QueueType           currentQueue = fah.begin()->second;
-      // and remove them from the fah
-      fah.erase(fah.begin());
+      // the first pixel to reach a neighbor wins
+      parallelizeWave([&](WaveChunk & chunk, SizeValueType first, SizeValueType last) {
+        for (SizeValueType k = first; k < last; ++k)
+        {
+          if (!propagates(k))
+          {
+            continue;
+          }
+          const BufferOffsetType p = wave[k];
+          const bool             inner = innerPixels[k];
+          const IndexType        idx = inner ? IndexType() : outputImage->ComputeIndex(p);
+          const SizeValueType    claim = firstClaimingPixel + k;
+          for (SizeValueType i = 0; i < numberOfNeighbors; ++i)
+          {
+            const BufferOffsetType n = p + neighbors[i];
+            SizeValueType          unclaimed = 0;
+            if ((inner || region.IsInside(idx + neighborOffsets[i])) && isAvailable(n) &&
+                claims[n].compare_exchange_strong(unclaimed, claim, std::memory_order_relaxed))
+            {
+              chunk.Claimed.push_back(n);
+            }
+          }
+        }
+      });
+      // the claimed pixels are updated once all the neighbors are claimed,
+      // since isAvailable reads the state that addPixel modifies
+      parallelizeWave([&](WaveChunk & chunk, SizeValueType, SizeValueType) {
+        for (const BufferOffsetType n : chunk.Claimed)
+        {
+          addNeighbor(chunk, n, claims[n].load(std::memory_order_relaxed) - firstClaimingPixel);
+        }
+        chunk.Claimed.clear();
+      });
+    }
+  };
 
-      while (!currentQueue.empty())
+  //---------------------------------------------------------------------------
+  // Meyer's algorithm
+  //---------------------------------------------------------------------------
+  if (m_MarkWatershedLine)
+  {
+    // status of the pixels of a wave flooded in parallel, which are not yet
+    // processed for the serial algorithm
+    constexpr unsigned char inWave = 2;
+    constexpr unsigned char inWaveConflict = 3;
+
+    // flooding
+    while (!fah.Empty())
+    {
+      const InputImagePixelType currentValue = fah.PopLevel(wave);
+      while (!wave.empty())
       {
-        IndexType idx = currentQueue.front();
-        currentQueue.pop();
-
-        // move the iterators to the right place
-        OffsetType shift = idx - outputIt.GetIndex();
-        outputIt += shift;
-        statusIt += shift;
-        inputIt += shift;
-
-        // iterate over the neighbors. If there is only one marker value, give
-        // that value to the pixel, else keep it as is (watershed line)
-        LabelImagePixelType marker = wsLabel;
-        bool                collision = false;
-        for (noIt = outputIt.Begin(); noIt != outputIt.End(); noIt++)
+        if (numberOfChunks > 1 && wave.size() >= minimumParallelWaveSize)
         {
-          LabelImagePixelType o = noIt.Get();
-          if (o != wsLabel)
+          innerPixels.resize(wave.size());
+          parallelizeWave([&](WaveChunk &, SizeValueType first, SizeValueType last) {
+            for (SizeValueType k = first; k < last; ++k)
+            {
+              status[wave[k]] = inWave;
+            }
+            markInnerPixels(first, last);
+          });
+
+          // the label of each pixel, given by its neighbors which are not in
+          // the wave, is stored in the output image
+          collided.assign(wave.size(), 0);
+          parallelizeWave([&](WaveChunk &, SizeValueType first, SizeValueType last) {
+            for (SizeValueType k = first; k < last; ++k)
+            {
+              const BufferOffsetType p = wave[k];
+              const bool             inner = innerPixels[k];
+              const IndexType        idx = inner ? IndexType() : outputImage->ComputeIndex(p);
+              LabelImagePixelType    label = wsLabel;
+              for (SizeValueType i = 0; i < numberOfNeighbors; ++i)
+              {
+                const BufferOffsetType n = p + neighbors[i];
+                if ((!inner && !region.IsInside(idx + neighborOffsets[i])) || status[n] >= inWave)
+                {
+                  continue;
+                }
+                const LabelImagePixelType o = output[n];
+                if (o != wsLabel)
+                {
+                  if (label != wsLabel && o != label)
+                  {
+                    collided[k] = 1;
+                    label = wsLabel;
+                    break;
+                  }
+                  label = o;
+                }
+              }
+              output[p] = label;
+            }
+          });
+
+          // a pixel next to a pixel of the wave with another label is a
+          // conflict: the first of the two in the order of the wave may make
+          // the other one a watershed pixel
+          parallelizeWave([&](WaveChunk & chunk, SizeValueType first, SizeValueType last) {
+            chunk.Conflicts.clear();
+            for (SizeValueType k = first; k < last; ++k)
+            {
+              if (collided[k])
+              {
+                continue;
+              }
+              const BufferOffsetType    p = wave[k];
+              const bool                inner = innerPixels[k];
+              const IndexType           idx = inner ? IndexType() : outputImage->ComputeIndex(p);
+              const LabelImagePixelType label = output[p];
+              for (SizeValueType i = 0; i < numberOfNeighbors; ++i)
+              {
+                const BufferOffsetType n = p + neighbors[i];
+                if ((inner || region.IsInside(idx + neighborOffsets[i])) && status[n] >= inWave &&
+                    output[n] != wsLabel && output[n] != label)
+                {
+                  chunk.Conflicts.push_back(k);
+                  break;
+                }
+              }
+            }
+          });
+
+          // the conflicts are solved in the order of the wave, with the
+          // conflicts which come before, as the serial algorithm does. The
+          // other pixels of the wave keep their label.
+          for (const WaveChunk & chunk : chunks)
+          {
+            for (const SizeValueType k : chunk.Conflicts)
+            {
+              status[wave[k]] = inWaveConflict;
+            }
+          }
+          for (const WaveChunk & chunk : chunks)
           {
-            if (marker != wsLabel && o != marker)
+            for (const SizeValueType k : chunk.Conflicts)
             {
-              collision = true;
-              break;
+              const BufferOffsetType    p = wave[k];
+              const bool                inner = innerPixels[k];
+              const IndexType           idx = inner ? IndexType() : outputImage->ComputeIndex(p);
+              const LabelImagePixelType label = output[p];
+              for (SizeValueType i = 0; i < numberOfNeighbors; ++i)
+              {
+                const BufferOffsetType n = p + neighbors[i];
+                if ((inner || region.IsInside(idx + neighborOffsets[i])) && status[n] == 1 &&
+                    output[n] != wsLabel && output[n] != label)
+                {
+                  output[p] = wsLabel;
+                  collided[k] = 1;
+                  break;
+                }
+              }
+              status[p] = 1;
             }
-            else
+          }
+          parallelizeWave([&](WaveChunk &, SizeValueType first, SizeValueType last) {
+            for (SizeValueType k = first; k < last; ++k)
             {
-              marker = o;
+              status[wave[k]] = 1;
             }
+          });
+
+          // propagate to the neighbors
+          claimNeighbors(
+            currentValue,
+            [&](SizeValueType k) { return !collided[k]; },
+            [&](BufferOffsetType n) { return !status[n]; },
+            [&](BufferOffsetType n, SizeValueType) { status[n] = 1; });
+          gatherChunks();
+
+          for (SizeValueType k = 0; k < wave.size(); ++k)
+          {
+            progress.CompletedPixel();
           }
         }
-        if (!collision)
+        else
         {
-          // set the marker value
-          outputIt.SetCenterPixel(marker);
-          // and propagate to the neighbors
-          for (niIt = inputIt.Begin(), nsIt = statusIt.Begin(); niIt != inputIt.End(); niIt++, nsIt++)
+          for (const BufferOffsetType p : wave)
           {
-            if (!nsIt.Get())
+            const IndexType idx = outputImage->ComputeIndex(p);
+            const bool      inner = isInner(idx);
+
+            // iterate over the neighbors. If there is only one marker value,
+            // give that value to the pixel, else keep it as is (watershed
+            // line). Outside pixels are watershed so they won't be used to
+            // find real watershed pixels.
+            LabelImagePixelType label = wsLabel;
+            bool                collision = false;
+            for (SizeValueType i = 0; i < numberOfNeighbors; ++i)
             {
-              // the pixel is not yet processed. add it to the fah
-              InputImagePixelType GrayVal = niIt.Get();
-              if (GrayVal <= currentValue)
+              if (!inner && !region.IsInside(idx + neighborOffsets[i]))
+              {
+                continue;
+              }
+              const LabelImagePixelType o = output[p + neighbors[i]];
+              if (o != wsLabel)
               {
-                currentQueue.push(inputIt.GetIndex() + niIt.GetNeighborhoodOffset());
+                if (label != wsLabel && o != label)
+                {
+                  collision = true;
+                  break;
+                }
+                label = o;
               }
-              else
+            }
+            if (!collision)
+            {
+              // set the marker value
+              output[p] = label;
+              // and propagate to the neighbors
+              for (SizeValueType i = 0; i < numberOfNeighbors; ++i)
               {
-                fah[GrayVal].push(inputIt.GetIndex() + niIt.GetNeighborhoodOffset());
+                const BufferOffsetType n = p + neighbors[i];
+                if ((inner || region.IsInside(idx + neighborOffsets[i])) && !status[n])
+                {
+                  // the pixel is not yet processed. add it to the fah
+                  const InputImagePixelType GrayVal = input[n];
+                  if (GrayVal <= currentValue)
+                  {
+                    nextWave.push_back(n);
+                  }
+                  else
+                  {
+                    fah.Push(GrayVal, n);
+                  }
+                  // mark it as already in the fah
+                  status[n] = 1;
+                }
               }
-              // mark it as already in the fah
-              nsIt.Set(true);
             }
+            // one more pixel in the flooding stage
+            progress.CompletedPixel();
           }
         }
-        // one more pixel in the flooding stage
-        progress.CompletedPixel();
+        wave.swap(nextWave);
+        nextWave.clear();
       }
     }
   }
@@ -319,105 +675,62 @@ MorphologicalWatershedFromMarkersImageFilter<TInputImage, TLabelImage>::Generate
   //---------------------------------------------------------------------------
   else
   {
-    // first stage:
-    //  - copy markers pixels to output image
-    //  - init FAH with indexes of pixels with background pixel in their
-    //    neighborhood
-
-    ConstantBoundaryCondition<LabelImageType> lcbc2;
-    // outside pixel are watershed so they won't be use to find real watershed
-    // pixels
-    lcbc2.SetConstant(NumericTraits<LabelImagePixelType>::max());
-    outputIt.OverrideBoundaryCondition(&lcbc2);
-
-    for (markerIt.GoToBegin(), outputIt.GoToBegin(), inputIt.GoToBegin(); !markerIt.IsAtEnd(); ++markerIt, ++outputIt)
+    // flooding
+    while (!fah.Empty())
     {
-      LabelImagePixelType markerPixel = markerIt.GetCenterPixel();
-      if (markerPixel != bgLabel)
+      const InputImagePixelType currentValue = fah.PopLevel(wave);
+      while (!wave.empty())
       {
-        IndexType  idx = markerIt.GetIndex();
-        OffsetType shift = idx - inputIt.GetIndex();
-        inputIt += shift;
-
-        // this pixels belongs to a marker
-        // copy it to the output image
-        outputIt.SetCenterPixel(markerPixel);
-        // search if it has background pixel in its neighborhood
-        bool haveBgNeighbor = false;
-        for (nmIt = markerIt.Begin(); nmIt != markerIt.End(); nmIt++)
+        if (numberOfChunks > 1 && wave.size() >= minimumParallelWaveSize)
         {
-          if (nmIt.Get() == bgLabel)
+          innerPixels.resize(wave.size());
+          // the pixels of the wave are already labeled, and propagate their
+          // label to the neighbors they claim
+          parallelizeWave([&](WaveChunk &, SizeValueType first, SizeValueType last) { markInnerPixels(first, last); });
+          claimNeighbors(
+            currentValue,
+            [](SizeValueType) { return true; },
+            [&](BufferOffsetType n) { return output[n] == wsLabel; },
+            [&](BufferOffsetType n, SizeValueType k) { output[n] = output[wave[k]]; });
+
+          const SizeValueType numberOfLabeledPixels = gatherChunks();
+          for (SizeValueType k = 0; k < numberOfLabeledPixels; ++k)
           {
-            haveBgNeighbor = true;
-            break;
+            progress.CompletedPixel();
           }
         }
-        if (haveBgNeighbor)
-        {
-          // there is a background pixel in the neighborhood; add to fah
-          fah[inputIt.GetCenterPixel()].push(markerIt.GetIndex());
-        }
         else
         {
-          // increase progress because this pixel will not be used in the
-          // flooding stage.
-          progress.CompletedPixel();
-        }
-      }
-      else
-      {
-        outputIt.SetCenterPixel(wsLabel);
-      }
-      progress.CompletedPixel();
-    }
-    // end of init stage
-
-    // flooding
-    // init all the iterators
-    outputIt.GoToBegin();
-    inputIt.GoToBegin();
-
-    // and start flooding
-    while (!fah.empty())
-    {
-      // store the current vars
-      InputImagePixelType currentValue = fah.begin()->first;
-      QueueType           currentQueue = fah.begin()->second;
-      // and remove them from the fah
-      fah.erase(fah.begin());
-
-      while (!currentQueue.empty())
-      {
-        IndexType idx = currentQueue.front();
-        currentQueue.pop();
-
-        // move the iterators to the right place
-        OffsetType shift = idx - outputIt.GetIndex();
-        outputIt += shift;
-        inputIt += shift;
-
-        LabelImagePixelType currentMarker = outputIt.GetCenterPixel();
-        // get the current value of the pixel
-        // iterate over neighbors to propagate the marker
-        for (noIt = outputIt.Begin(), niIt = inputIt.Begin(); noIt != outputIt.End(); noIt++, niIt++)
-        {
-          if (noIt.Get() == wsLabel)
+          for (const BufferOffsetType p : wave)
           {
-            // the pixel is not yet processed. It can be labeled with the
-            // current label
-            noIt.Set(currentMarker);
-            InputImagePixelType GrayVal = niIt.Get();
-            if (GrayVal <= currentValue)
+            const IndexType           idx = outputImage->ComputeIndex(p);
+            const bool                inner = isInner(idx);
+            const LabelImagePixelType currentMarker = output[p];
+            // iterate over neighbors to propagate the marker
+            for (SizeValueType i = 0; i < numberOfNeighbors; ++i)
             {
-              currentQueue.push(inputIt.GetIndex() + noIt.GetNeighborhoodOffset());
-            }
-            else
-            {
-              fah[GrayVal].push(inputIt.GetIndex() + noIt.GetNeighborhoodOffset());
+              const BufferOffsetType n = p + neighbors[i];
+              if ((inner || region.IsInside(idx + neighborOffsets[i])) && output[n] == wsLabel)
+              {
+                // the pixel is not yet processed. It can be labeled with the
+                // current label
+                output[n] = currentMarker;
+                const InputImagePixelType GrayVal = input[n];
+                if (GrayVal <= currentValue)
+                {
+                  nextWave.push_back(n);
+                }
+                else
+                {
+                  fah.Push(GrayVal, n);
+                }
+                progress.CompletedPixel();
+              }
             }
-            progress.CompletedPixel();
           }
         }
+        wave.swap(nextWave);
+        nextWave.clear();
       }
     }
   }
@@ -433,6 +746,7 @@ MorphologicalWatershedFromMarkersImageFilter<TInputImage, TLabelImage>::PrintSel
 
   os << indent << "FullyConnected: " << m_FullyConnected << std::endl;
   os << indent << "MarkWatershedLine: " << m_MarkWatershedLine << std::endl;
+  os << indent << "Deterministic: " << m_Deterministic << std::endl;
 }
 
 } // end namespace itk
@@ -105,6 +105,15 @@ public:
   itkGetConstReferenceMacro(MarkWatershedLine, bool);
   itkBooleanMacro(MarkWatershedLine);
 
+  /**
+   * Set/Get whether the labels must be the same as the ones of the serial
+   * flooding, whatever the number of work units. Default is true.
+   * \sa MorphologicalWatershedFromMarkersImageFilter::SetDeterministic()
+   */
+  itkSetMacro(Deterministic, bool);
+  itkGetConstReferenceMacro(Deterministic, bool);
+  itkBooleanMacro(Deterministic);
+
   /**
    */
   itkSetMacro(Level, InputImagePixelType);
@@ -136,6 +145,8 @@ private:
 
   bool m_MarkWatershedLine{ true };
 
+  bool m_Deterministic{ true };
+
   InputImagePixelType m_Level;
 }; // end of class
 } // end namespace itk
@@ -20,9 +20,13 @@
 
 
 #include "itkImageToImageFilter.h"
+#include "itkImageRegionSplitterBase.h"
+#include "itkThresholdImageFilter.h"
+#include "itkWatershedBoundaryResolver.h"
 #include "itkWatershedSegmentTreeGenerator.h"
 #include "itkWatershedRelabeler.h"
 #include "itkWatershedMiniPipelineProgressCommand.h"
+#include <vector>
 
 namespace itk
 {
@@ -75,10 +79,35 @@ namespace itk
  * algorithm components in the namespace "watershed").  For a more complete
  * picture of the implementation, refer to the documentation of those components.
  * The component classes were designed to operate in either a data-streaming or
- * a non-data-streaming mode.  The pipeline constructed in this class'
- * GenerateData() method does not support streaming, but is the common use case
+ * a non-data-streaming mode.  By default, the pipeline constructed in this
+ * class' GenerateData() method does not stream, which is the common use case
  * for the components.
  *
+ * \par Streaming
+ * When NumberOfStreamDivisions is larger than one, the input is split into
+ * chunks with the RegionSplitter, and each chunk is segmented separately,
+ * padded by one pixel into its neighbors.  The flow across the faces shared
+ * by neighboring chunks is resolved with a watershed::BoundaryResolver, the
+ * edges across these faces are added to the segment table, and a single merge
+ * tree is generated for the whole image.  Only one chunk of the input and of
+ * the basic segmentation, and the faces of the chunks whose neighbors are not
+ * segmented yet, are held in memory at a time, in addition to the segment
+ * table.  The output is produced for the requested region only, by
+ * segmenting again the chunks which intersect it, so that it can be streamed
+ * downstream, for instance by an ImageFileWriter.  The segment table is kept
+ * until the input or the threshold changes, and the merge tree until the
+ * level is raised above the highest level computed so far.
+ *
+ * \par
+ * The streamed segmentation is the same as the non-streamed one, up to the
+ * values of the labels, except for plateaus which are not local minima and
+ * cross the face between two chunks: such a plateau is not descended into a
+ * neighboring basin but forms a segment of its own in the basic segmentation,
+ * which is then merged with its neighbors by the flooding like any other
+ * segment.  Merges of equal saliency, or a segment with several lowest
+ * edges of the same height, may also be resolved in another order, since
+ * the labels of the segments are not the same.
+ *
  * \par Description of the input to this filter
  * The input to this filter is a scalar itk::Image of any dimensionality.  This
  * input image is assumed to represent some sort of height function or edge map
@@ -245,13 +274,32 @@ public:
   typename watershed::SegmentTreeGenerator<ScalarType>::SegmentTreeType *
   GetSegmentTree()
   {
+    if (m_NumberOfStreamDivisions > 1)
+    {
+      return m_StreamingTreeGenerator->GetOutputSegmentTree();
+    }
     return m_TreeGenerator->GetOutputSegmentTree();
   }
 
-  // Override since the filter produces all of its output
+  /** Set/Get the number of chunks into which the input is split to be
+   * segmented one at a time.  The default of 1 segments the whole input at
+   * once. */
+  itkSetMacro(NumberOfStreamDivisions, unsigned int);
+  itkGetConstMacro(NumberOfStreamDivisions, unsigned int);
+
+  /** Set/Get the splitter used to compute the chunks when streaming.  The
+   * chunks must form a grid.  The default splits the slowest dimension. */
+  itkSetObjectMacro(RegionSplitter, ImageRegionSplitterBase);
+  itkGetModifiableObjectMacro(RegionSplitter, ImageRegionSplitterBase);
+
+  // Override since the filter produces all of its output, unless it streams
   void
   EnlargeOutputRequestedRegion(DataObject * data) override;
 
+  // Override to only request the first chunk of the input when streaming
+  void
+  GenerateInputRequestedRegion() override;
+
 #ifdef ITK_USE_CONCEPT_CHECKING
   // Begin concept checking
   itkConceptMacro(InputEqualityComparableCheck, (Concept::EqualityComparable<ScalarType>));
@@ -301,6 +349,57 @@ private:
   bool m_InputChanged;
 
   TimeStamp m_GenerateDataMTime;
+
+  /** Streaming mode, see the class documentation. */
+  using SegmenterType = watershed::Segmenter<InputImageType>;
+  using SegmentTableType = watershed::SegmentTable<ScalarType>;
+  using BoundaryType = watershed::Boundary<ScalarType, Self::ImageDimension>;
+  using BoundaryResolverType = watershed::BoundaryResolver<ScalarType, Self::ImageDimension>;
+  using ThresholdFilterType = ThresholdImageFilter<InputImageType>;
+
+  /** Returns the chunks of the largest possible region of the input. */
+  std::vector<RegionType>
+  SplitIntoChunks() const;
+
+  /** Returns the chunk padded by one pixel on the faces that it shares with
+   * other chunks, as expected by the segmenter. */
+  RegionType
+  PadChunk(const RegionType & chunk) const;
+
+  /** Brings the given region of an image of the mini-pipeline up to date. */
+  static void
+  UpdateRegion(InputImageType * image, const RegionType & region);
+
+  /** Segments the chunks one after the other, resolves their boundaries and
+   * fills the segment table and the equivalency table of the whole image. */
+  void
+  AnalyzeChunks(const std::vector<RegionType> & chunks, float progressStart, float progressEnd);
+
+  /** Adds the edges between the segments on both sides of the face between
+   * two neighboring chunks, which are not found by the segmenter. */
+  void
+  AddEdgesAcrossFace(BoundaryType *   lowerBoundary,
+                     BoundaryType *   upperBoundary,
+                     unsigned int     dimension,
+                     InputImageType * image);
+
+  void
+  GenerateStreamedData();
+
+  unsigned int                              m_NumberOfStreamDivisions{ 1 };
+  typename ImageRegionSplitterBase::Pointer m_RegionSplitter;
+
+  typename SegmenterType::Pointer                               m_StreamingSegmenter;
+  typename watershed::SegmentTreeGenerator<ScalarType>::Pointer m_StreamingTreeGenerator;
+  typename BoundaryResolverType::Pointer                        m_BoundaryResolver;
+  typename ThresholdFilterType::Pointer                         m_StreamingThreshold;
+
+  /** State cached between the executions in streaming mode. */
+  std::vector<RegionType>            m_Chunks;
+  std::vector<IdentifierType>        m_ChunkFirstLabels;
+  typename SegmentTableType::Pointer m_StreamingSegmentTable;
+  EquivalencyTable::Pointer          m_StreamingEquivalencies;
+  bool                               m_StreamingAnalysisValid{ false };
 };
 } // end namespace itk
 
@@ -18,6 +18,9 @@
 #ifndef itkWatershedImageFilter_hxx
 #define itkWatershedImageFilter_hxx
 #include "itkWatershedImageFilter.h"
+#include "itkImageRegionSplitterSlowDimension.h"
+#include "itkMath.h"
+#include <map>
 
 namespace itk
 {
@@ -101,6 +104,17 @@ WatershedImageFilter<TInputImage>::WatershedImageFilter()
   m_InputChanged = true;
   m_LevelChanged = true;
   m_ThresholdChanged = true;
+
+  // The streaming mini-pipeline only segments the chunks, the rest of the
+  // processing is done in GenerateStreamedData()
+  m_RegionSplitter = ImageRegionSplitterSlowDimension::New();
+  m_StreamingSegmenter = SegmenterType::New();
+  m_StreamingSegmenter->SetDoBoundaryAnalysis(true);
+  m_StreamingSegmenter->SetSortEdgeLists(false);
+  m_StreamingTreeGenerator = watershed::SegmentTreeGenerator<ScalarType>::New();
+  m_StreamingTreeGenerator->SetMerge(true);
+  m_BoundaryResolver = BoundaryResolverType::New();
+  m_StreamingThreshold = ThresholdFilterType::New();
 }
 
 template <typename TInputImage>
@@ -108,7 +122,34 @@ void
 WatershedImageFilter<TInputImage>::EnlargeOutputRequestedRegion(DataObject * data)
 {
   Superclass::EnlargeOutputRequestedRegion(data);
-  data->SetRequestedRegionToLargestPossibleRegion();
+  if (m_NumberOfStreamDivisions <= 1)
+  {
+    data->SetRequestedRegionToLargestPossibleRegion();
+  }
+}
+
+template <typename TInputImage>
+void
+WatershedImageFilter<TInputImage>::GenerateInputRequestedRegion()
+{
+  Superclass::GenerateInputRequestedRegion();
+  if (m_NumberOfStreamDivisions <= 1 || !this->GetInput())
+  {
+    return;
+  }
+
+  // The chunks are pulled from the input one at a time while executing, so
+  // only the first one which is needed is requested here.
+  auto * input = const_cast<InputImageType *>(this->GetInput());
+  for (const RegionType & chunk : this->SplitIntoChunks())
+  {
+    RegionType region = chunk;
+    if (region.Crop(this->GetOutput()->GetRequestedRegion()))
+    {
+      input->SetRequestedRegion(this->PadChunk(chunk));
+      return;
+    }
+  }
 }
 
 template <typename TInputImage>
@@ -137,6 +178,7 @@ WatershedImageFilter<TInputImage>::PrepareOutputs()
     m_Relabeler->PrepareOutputs();
 
     m_TreeGenerator->SetHighestCalculatedFloodLevel(0.0);
+    m_StreamingAnalysisValid = false;
   }
 
   // If the flood level changed but is below the Tree
@@ -165,24 +207,31 @@ template <typename TInputImage>
 void
 WatershedImageFilter<TInputImage>::GenerateData()
 {
-  // Set the largest possible region in the segmenter
-  m_Segmenter->SetLargestPossibleRegion(this->GetInput()->GetLargestPossibleRegion());
-  m_Segmenter->GetOutputImage()->SetRequestedRegion(this->GetInput()->GetLargestPossibleRegion());
-
-  // Setup the progress command
-  WatershedMiniPipelineProgressCommand::Pointer c =
-    dynamic_cast<WatershedMiniPipelineProgressCommand *>(m_TreeGenerator->GetCommand(m_ObserverTag));
-  c->SetCount(0.0);
-  c->SetNumberOfFilters(3);
+  if (m_NumberOfStreamDivisions > 1)
+  {
+    this->GenerateStreamedData();
+  }
+  else
+  {
+    // Set the largest possible region in the segmenter
+    m_Segmenter->SetLargestPossibleRegion(this->GetInput()->GetLargestPossibleRegion());
+    m_Segmenter->GetOutputImage()->SetRequestedRegion(this->GetInput()->GetLargestPossibleRegion());
+
+    // Setup the progress command
+    WatershedMiniPipelineProgressCommand::Pointer c =
+      dynamic_cast<WatershedMiniPipelineProgressCommand *>(m_TreeGenerator->GetCommand(m_ObserverTag));
+    c->SetCount(0.0);
+    c->SetNumberOfFilters(3);
 
-  // Graft our output on the relabeler
-  m_Relabeler->GraftOutput(this->GetOutput());
+    // Graft our output on the relabeler
+    m_Relabeler->GraftOutput(this->GetOutput());
 
-  // Update the mini-pipeline
-  m_Relabeler->Update();
+    // Update the mini-pipeline
+    m_Relabeler->Update();
 
-  // Graft the output of the relabeler back on this filter
-  this->GraftOutput(m_Relabeler->GetOutputImage());
+    // Graft the output of the relabeler back on this filter
+    this->GraftOutput(m_Relabeler->GetOutputImage());
+  }
 
   // Keep track of when we last executed
   m_GenerateDataMTime.Modified();
@@ -200,6 +249,341 @@ WatershedImageFilter<TInputImage>::PrintSelf(std::ostream & os, Indent indent) c
   Superclass::PrintSelf(os, indent);
   os << indent << "Threshold: " << m_Threshold << std::endl;
   os << indent << "Level: " << m_Level << std::endl;
+  os << indent << "NumberOfStreamDivisions: " << m_NumberOfStreamDivisions << std::endl;
+  os << indent << "RegionSplitter: " << m_RegionSplitter << std::endl;
+}
+
+template <typename TInputImage>
+std::vector<typename WatershedImageFilter<TInputImage>::RegionType>
+WatershedImageFilter<TInputImage>::SplitIntoChunks() const
+{
+  const RegionType   largestRegion = this->GetInput()->GetLargestPossibleRegion();
+  const unsigned int numberOfChunks = m_RegionSplitter->GetNumberOfSplits(largestRegion, m_NumberOfStreamDivisions);
+
+  std::vector<RegionType> chunks(numberOfChunks, largestRegion);
+  for (unsigned int i = 0; i < numberOfChunks; ++i)
+  {
+    m_RegionSplitter->GetSplit(i, numberOfChunks, chunks[i]);
+  }
+  return chunks;
+}
+
+template <typename TInputImage>
+typename WatershedImageFilter<TInputImage>::RegionType
+WatershedImageFilter<TInputImage>::PadChunk(const RegionType & chunk) const
+{
+  RegionType region = chunk;
+  region.PadByRadius(1);
+  region.Crop(this->GetInput()->GetLargestPossibleRegion());
+  return region;
+}
+
+template <typename TInputImage>
+void
+WatershedImageFilter<TInputImage>::UpdateRegion(InputImageType * image, const RegionType & region)
+{
+  image->SetRequestedRegion(region);
+  image->PropagateRequestedRegion();
+  image->UpdateOutputData();
+}
+
+template <typename TInputImage>
+void
+WatershedImageFilter<TInputImage>::AnalyzeChunks(const std::vector<RegionType> & chunks,
+                                                 float                           progressStart,
+                                                 float                           progressEnd)
+{
+  auto *           input = const_cast<InputImageType *>(this->GetInput());
+  const RegionType largestRegion = input->GetLargestPossibleRegion();
+  const size_t     numberOfChunks = chunks.size();
+
+  // Find the pairs of chunks which share a face, and resolve each of them
+  // once the last of the two chunks is segmented
+  struct FacePair
+  {
+    size_t       lower;
+    size_t       upper;
+    unsigned int dimension;
+  };
+  std::vector<std::vector<FacePair>> pairsOfLastChunk(numberOfChunks);
+  std::vector<unsigned int>          numberOfUnresolvedFaces(numberOfChunks, 0);
+  for (size_t i = 0; i < numberOfChunks; ++i)
+  {
+    for (unsigned int d = 0; d < ImageDimension; ++d)
+    {
+      const IndexValueType end = chunks[i].GetIndex(d) + static_cast<IndexValueType>(chunks[i].GetSize(d));
+      if (chunks[i].GetIndex(d) != largestRegion.GetIndex(d))
+      {
+        ++numberOfUnresolvedFaces[i];
+      }
+      if (end == largestRegion.GetIndex(d) + static_cast<IndexValueType>(largestRegion.GetSize(d)))
+      {
+        continue;
+      }
+      ++numberOfUnresolvedFaces[i];
+      for (size_t j = 0; j < numberOfChunks; ++j)
+      {
+        RegionType neighbor = chunks[i];
+        neighbor.SetIndex(d, end);
+        neighbor.SetSize(d, chunks[j].GetSize(d));
+        if (neighbor == chunks[j])
+        {
+          pairsOfLastChunk[std::max(i, j)].push_back(FacePair{ i, j, d });
+        }
+      }
+    }
+  }
+  size_t numberOfPairs = 0;
+  size_t numberOfFaces = 0;
+  for (size_t i = 0; i < numberOfChunks; ++i)
+  {
+    numberOfPairs += pairsOfLastChunk[i].size();
+    numberOfFaces += numberOfUnresolvedFaces[i];
+  }
+  if (2 * numberOfPairs != numberOfFaces)
+  {
+    itkExceptionMacro(<< "The chunks computed by the RegionSplitter do not form a grid.");
+  }
+
+  // The threshold and the maximum depth are relative to the range of the
+  // whole input, so when the input is thresholded its range is computed in a
+  // first pass.  Otherwise it is computed while segmenting.
+  auto minimum = NumericTraits<ScalarType>::max();
+  auto maximum = NumericTraits<ScalarType>::NonpositiveMin();
+  auto updateRange = [&minimum, &maximum](const InputImageType * image, const RegionType & region) {
+    for (ImageRegionConstIterator<InputImageType> it(image, region); !it.IsAtEnd(); ++it)
+    {
+      minimum = std::min(minimum, it.Get());
+      maximum = std::max(maximum, it.Get());
+    }
+  };
+  InputImageType * segmenterInput = input;
+  if (m_Threshold > 0.0)
+  {
+    for (const RegionType & chunk : chunks)
+    {
+      Self::UpdateRegion(input, chunk);
+      updateRange(input, chunk);
+    }
+    if (NumericTraits<ScalarType>::IsInteger && Math::ExactlyEquals(maximum, NumericTraits<ScalarType>::max()))
+    {
+      maximum -= NumericTraits<ScalarType>::OneValue();
+    }
+    const auto level = static_cast<ScalarType>((m_Threshold * (maximum - minimum)) + minimum);
+    m_StreamingThreshold->SetInput(input);
+    m_StreamingThreshold->ThresholdBelow(level);
+    m_StreamingThreshold->SetOutsideValue(level);
+    segmenterInput = m_StreamingThreshold->GetOutput();
+  }
+
+  m_StreamingSegmentTable = SegmentTableType::New();
+  m_StreamingEquivalencies = EquivalencyTable::New();
+  m_ChunkFirstLabels.assign(numberOfChunks, 0);
+  std::vector<typename BoundaryType::Pointer> boundaries(numberOfChunks);
+
+  m_StreamingSegmenter->SetInputImage(segmenterInput);
+  m_StreamingSegmenter->SetLargestPossibleRegion(largestRegion);
+  m_StreamingSegmenter->SetSegmentTable(m_StreamingSegmentTable);
+  m_StreamingSegmenter->SetBoundary(BoundaryType::New());
+  m_StreamingSegmenter->SetCurrentLabel(1);
+  for (size_t j = 0; j < numberOfChunks; ++j)
+  {
+    // Segment the chunk, with labels following the ones of the previous
+    // chunks, and keep its boundary away from the next executions
+    m_ChunkFirstLabels[j] = m_StreamingSegmenter->GetCurrentLabel();
+    m_StreamingSegmenter->GetOutputImage()->SetRequestedRegion(this->PadChunk(chunks[j]));
+    m_StreamingSegmenter->Update();
+    boundaries[j] = m_StreamingSegmenter->GetBoundary();
+    m_StreamingSegmenter->SetBoundary(BoundaryType::New());
+
+    Self::UpdateRegion(segmenterInput, this->PadChunk(chunks[j]));
+    if (m_Threshold <= 0.0)
+    {
+      updateRange(segmenterInput, chunks[j]);
+    }
+
+    for (const FacePair & pair : pairsOfLastChunk[j])
+    {
+      m_BoundaryResolver->SetBoundaryA(boundaries[pair.lower]);
+      m_BoundaryResolver->SetBoundaryB(boundaries[pair.upper]);
+      m_BoundaryResolver->SetFace(pair.dimension);
+      m_BoundaryResolver->Update();
+
+      EquivalencyTable * equivalencies = m_BoundaryResolver->GetEquivalencyTable();
+      for (EquivalencyTable::ConstIterator it = equivalencies->Begin(); it != equivalencies->End(); ++it)
+      {
+        m_StreamingEquivalencies->Add(it->first, it->second);
+      }
+      equivalencies->Clear();
+
+      this->AddEdgesAcrossFace(boundaries[pair.lower], boundaries[pair.upper], pair.dimension, segmenterInput);
+
+      for (size_t chunk : { pair.lower, pair.upper })
+      {
+        if (--numberOfUnresolvedFaces[chunk] == 0)
+        {
+          boundaries[chunk] = nullptr;
+        }
+      }
+    }
+    if (numberOfUnresolvedFaces[j] == 0)
+    {
+      boundaries[j] = nullptr;
+    }
+    this->UpdateProgress(progressStart + (progressEnd - progressStart) * static_cast<float>(j + 1) / numberOfChunks);
+  }
+
+  // Detach the segment table of the whole image from the segmenter, which
+  // only fills scratch tables from now on
+  m_StreamingSegmenter->SetSegmentTable(SegmentTableType::New());
+
+  if (m_Threshold <= 0.0 && NumericTraits<ScalarType>::IsInteger &&
+      Math::ExactlyEquals(maximum, NumericTraits<ScalarType>::max()))
+  {
+    maximum -= NumericTraits<ScalarType>::OneValue();
+  }
+  m_StreamingSegmentTable->SetMaximumDepth(maximum - minimum);
+  m_StreamingSegmentTable->Modified();
+  m_StreamingEquivalencies->Flatten();
+  m_StreamingEquivalencies->Modified();
+}
+
+template <typename TInputImage>
+void
+WatershedImageFilter<TInputImage>::AddEdgesAcrossFace(BoundaryType *   lowerBoundary,
+                                                      BoundaryType *   upperBoundary,
+                                                      unsigned int     dimension,
+                                                      InputImageType * image)
+{
+  using FaceType = typename BoundaryType::face_t;
+  const FaceType * lowerFace = lowerBoundary->GetFace(dimension, 1);
+  const FaceType * upperFace = upperBoundary->GetFace(dimension, 0);
+
+  ImageRegionConstIterator<FaceType>       lowerIt(lowerFace, lowerFace->GetRequestedRegion());
+  ImageRegionConstIterator<FaceType>       upperIt(upperFace, upperFace->GetRequestedRegion());
+  ImageRegionConstIterator<InputImageType> lowerValueIt(image, lowerFace->GetRequestedRegion());
+  ImageRegionConstIterator<InputImageType> upperValueIt(image, upperFace->GetRequestedRegion());
+
+  // As in the segmenter, the height of an edge is the lowest of the maxima
+  // of the values of the pairs of adjacent pixels of the two segments, and
+  // the maximum value of an integral type is reduced by one.
+  auto reduce = [](ScalarType value) {
+    if (NumericTraits<ScalarType>::IsInteger && Math::ExactlyEquals(value, NumericTraits<ScalarType>::max()))
+    {
+      return static_cast<ScalarType>(value - NumericTraits<ScalarType>::OneValue());
+    }
+    return value;
+  };
+  std::map<std::pair<IdentifierType, IdentifierType>, ScalarType> edges;
+  for (; !lowerIt.IsAtEnd(); ++lowerIt, ++upperIt, ++lowerValueIt, ++upperValueIt)
+  {
+    // Pixels which flow across the face are in equivalent segments
+    if (lowerIt.Get().flow != SegmenterType::NULL_FLOW || upperIt.Get().flow != SegmenterType::NULL_FLOW)
+    {
+      continue;
+    }
+    const ScalarType height = std::max(reduce(lowerValueIt.Get()), reduce(upperValueIt.Get()));
+    const auto       labels = std::make_pair(lowerIt.Get().label, upperIt.Get().label);
+    const auto       result = edges.insert(std::make_pair(labels, height));
+    if (!result.second && height < result.first->second)
+    {
+      result.first->second = height;
+    }
+  }
+
+  for (const auto & edge : edges)
+  {
+    typename SegmentTableType::segment_t * lowerSegment = m_StreamingSegmentTable->Lookup(edge.first.first);
+    typename SegmentTableType::segment_t * upperSegment = m_StreamingSegmentTable->Lookup(edge.first.second);
+    if (lowerSegment && upperSegment)
+    {
+      lowerSegment->edge_list.push_back(typename SegmentTableType::edge_pair_t(edge.first.second, edge.second));
+      upperSegment->edge_list.push_back(typename SegmentTableType::edge_pair_t(edge.first.first, edge.second));
+    }
+  }
+}
+
+template <typename TInputImage>
+void
+WatershedImageFilter<TInputImage>::GenerateStreamedData()
+{
+  const std::vector<RegionType> chunks = this->SplitIntoChunks();
+  OutputImageType *             output = this->GetOutput();
+  const RegionType              outputRegion = output->GetRequestedRegion();
+
+  std::vector<size_t> outputChunks;
+  for (size_t i = 0; i < chunks.size(); ++i)
+  {
+    RegionType region = chunks[i];
+    if (region.Crop(outputRegion))
+    {
+      outputChunks.push_back(i);
+    }
+  }
+
+  // Segment all the chunks to compute the segment table and the merge tree
+  // of the whole image, unless they are still valid
+  const bool  analyze = !m_StreamingAnalysisValid || chunks != m_Chunks;
+  const float analysisProgress =
+    analyze ? static_cast<float>(chunks.size()) / static_cast<float>(chunks.size() + outputChunks.size()) : 0.0f;
+  if (analyze)
+  {
+    m_StreamingAnalysisValid = false;
+    this->AnalyzeChunks(chunks, 0.0f, analysisProgress);
+    m_Chunks = chunks;
+    m_StreamingAnalysisValid = true;
+
+    m_StreamingTreeGenerator->SetInputSegmentTable(m_StreamingSegmentTable);
+    m_StreamingTreeGenerator->SetInputEquivalencyTable(m_StreamingEquivalencies);
+    m_StreamingTreeGenerator->SetHighestCalculatedFloodLevel(0.0);
+  }
+  m_StreamingTreeGenerator->SetFloodLevel(m_Level);
+  m_StreamingTreeGenerator->Update();
+
+  // Merges of the tree up to the level, as in the relabeler
+  EquivalencyTable::Pointer treeEquivalencies = EquivalencyTable::New();
+  const typename watershed::SegmentTreeGenerator<ScalarType>::SegmentTreeType * tree =
+    m_StreamingTreeGenerator->GetOutputSegmentTree();
+  if (!tree->Empty())
+  {
+    const auto mergeLimit = static_cast<ScalarType>(m_Level * tree->Back().saliency);
+    for (auto it = tree->Begin(); it != tree->End() && it->saliency <= mergeLimit; ++it)
+    {
+      treeEquivalencies->Add(it->from, it->to);
+    }
+  }
+  treeEquivalencies->Flatten();
+
+  // Segment again the chunks which intersect the requested region, with
+  // the same labels as in the analysis, and relabel them
+  this->AllocateOutputs();
+  const typename SegmenterType::OutputImageType * labels = m_StreamingSegmenter->GetOutputImage();
+  for (size_t k = 0; k < outputChunks.size(); ++k)
+  {
+    const RegionType & chunk = chunks[outputChunks[k]];
+    m_StreamingSegmenter->GetSegmentTable()->Clear();
+    m_StreamingSegmenter->SetCurrentLabel(m_ChunkFirstLabels[outputChunks[k]]);
+    m_StreamingSegmenter->GetOutputImage()->SetRequestedRegion(this->PadChunk(chunk));
+    m_StreamingSegmenter->Update();
+
+    RegionType region = chunk;
+    region.Crop(outputRegion);
+    ImageRegionConstIterator<OutputImageType> labelIt(labels, region);
+    ImageRegionIterator<OutputImageType>      outputIt(output, region);
+    IdentifierType                            label = SegmenterType::NULL_LABEL;
+    IdentifierType                            outputLabel = SegmenterType::NULL_LABEL;
+    for (; !labelIt.IsAtEnd(); ++labelIt, ++outputIt)
+    {
+      if (labelIt.Get() != label)
+      {
+        label = labelIt.Get();
+        outputLabel = treeEquivalencies->Lookup(m_StreamingEquivalencies->Lookup(label));
+      }
+      outputIt.Set(outputLabel);
+    }
+    const float chunkProgress = static_cast<float>(k + 1) / static_cast<float>(outputChunks.size());
+    this->UpdateProgress(analysisProgress + (1.0f - analysisProgress) * chunkProgress);
+  }
 }
 } // end namespace itk
 
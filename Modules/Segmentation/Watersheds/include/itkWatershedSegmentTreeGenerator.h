@@ -215,8 +215,9 @@ protected:
    * flood level, recomputing new potential merges as it goes.   */
   void ExtractMergeHierarchy(SegmentTableTypePointer, SegmentTreeTypePointer);
 
-  void
-  MergeEquivalencies();
+  /** Merges the segments of the input equivalency table in the given
+   * segment table. */
+  void MergeEquivalencies(SegmentTableTypePointer);
 
   /** Methods required by the itk pipeline */
   void
@@ -87,7 +87,7 @@ SegmentTreeGenerator<TScalar>::GenerateData()
 
     if (m_Merge == true)
     {
-      this->MergeEquivalencies();
+      this->MergeEquivalencies(input);
     }
 
     this->CompileMergeList(input, mergeList);
@@ -99,7 +99,7 @@ SegmentTreeGenerator<TScalar>::GenerateData()
     seg->SortEdgeLists();
     if (m_Merge == true)
     {
-      this->MergeEquivalencies();
+      this->MergeEquivalencies(seg);
     }
     this->CompileMergeList(seg, mergeList);
     this->ExtractMergeHierarchy(seg, mergeList);
@@ -115,25 +115,23 @@ SegmentTreeGenerator<TScalar>::GenerateData()
 
 template <typename TScalar>
 void
-SegmentTreeGenerator<TScalar>::MergeEquivalencies()
+SegmentTreeGenerator<TScalar>::MergeEquivalencies(SegmentTableTypePointer segTable)
 {
-  typename SegmentTableType::Pointer      segTable = this->GetInputSegmentTable();
   typename EquivalencyTableType::Pointer  eqTable = this->GetInputEquivalencyTable();
   typename EquivalencyTableType::Iterator it;
-  auto threshold = static_cast<ScalarType>(m_FloodLevel * segTable->GetMaximumDepth());
 
   eqTable->Flatten();
   IdentifierType counter = 0;
 
-  segTable->PruneEdgeLists(threshold);
-
+  // The edge lists are not pruned until all the equivalent segments are
+  // merged: a list pruned down to an edge to an equivalent segment would be
+  // left empty by the merge.
   for (it = eqTable->Begin(); it != eqTable->End(); ++it)
   {
     MergeSegments(segTable, m_MergedSegmentsTable, (*it).first, (*it).second); // Merge first INTO second.
     // deletes first
     if ((counter % 10000) == 0)
     {
-      segTable->PruneEdgeLists(threshold);
       m_MergedSegmentsTable->Flatten();
       counter = 0;
     }
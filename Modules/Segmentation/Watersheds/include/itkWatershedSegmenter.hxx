@@ -188,6 +188,15 @@ CLANG_PRAGMA_POP
     {
       maximum -= NumericTraits<InputPixelType>::OneValue();
     }
+  // The boundary analysis looks at the padding of the faces on the true
+  // data set boundary, so build the retaining wall there first.  The
+  // threshold overwrites it on the faces which overlap other chunks.
+  if (m_DoBoundaryAnalysis == true)
+  {
+    this->BuildRetainingWall(
+      thresholdImage, thresholdImage->GetBufferedRegion(), maximum + NumericTraits<InputPixelType>::OneValue());
+  }
+
   // threshold the image.
   Self::Threshold(thresholdImage,
                   input,
@@ -487,15 +496,18 @@ Segmenter<TInputImage>::AnalyzeBoundaryFlow(InputImageTypePointer thresholdImage
       searchIt.GoToBegin();
       labelIt.GoToBegin();
 
+      // The connectivity lists the low neighbors from the last dimension to
+      // the first one, followed by the high neighbors from the first
+      // dimension to the last one
       if ((idx).second == 0)
       {
         // Low face
-        cPos = m_Connectivity.index[(idx).first];
+        cPos = m_Connectivity.index[(ImageDimension - 1) - (idx).first];
       }
       else
       {
         // High face
-        cPos = m_Connectivity.index[(ImageDimension - 1) + (ImageDimension - (idx).first)];
+        cPos = m_Connectivity.index[ImageDimension + (idx).first];
       }
 
       while (!searchIt.IsAtEnd())
@@ -548,11 +560,14 @@ Segmenter<TInputImage>::AnalyzeBoundaryFlow(InputImageTypePointer thresholdImage
         {
           if (searchIt.GetPixel(cPos) < searchIt.GetPixel(nCenter))
           {
+            // As in the gradient descent, ties go to the first neighbor in
+            // the order of the connectivity
             isSteepest = true;
             for (i = 0; i < m_Connectivity.size; i++)
             {
               nPos = m_Connectivity.index[i];
-              if (searchIt.GetPixel(nPos) < searchIt.GetPixel(cPos))
+              if (searchIt.GetPixel(nPos) < searchIt.GetPixel(cPos) ||
+                  (nPos < cPos && !(searchIt.GetPixel(cPos) < searchIt.GetPixel(nPos))))
               {
                 isSteepest = false;
                 break;
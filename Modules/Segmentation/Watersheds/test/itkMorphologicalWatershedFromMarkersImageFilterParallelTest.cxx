@@ -0,0 +1,397 @@
+/*=========================================================================
+ *
+ *  Copyright NumFOCUS
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include "itkImageRegionConstIterator.h"
+#include "itkImageRegionIteratorWithIndex.h"
+#include "itkMorphologicalWatershedFromMarkersImageFilter.h"
+#include "itkTestingMacros.h"
+#include "itkTimeProbe.h"
+#include <map>
+#include <queue>
+
+namespace
+{
+using LabelPixelType = unsigned short;
+
+// Basins of various depths separated by ridges, with noise and plateaus
+template <typename TImage>
+typename TImage::Pointer
+CreateImage(const typename TImage::SizeType & size)
+{
+  auto image = TImage::New();
+  image->SetRegions(size);
+  image->Allocate();
+
+  itk::ImageRegionIteratorWithIndex<TImage> it(image, image->GetLargestPossibleRegion());
+  unsigned int                              state = 2468;
+  for (; !it.IsAtEnd(); ++it)
+  {
+    state = state * 1103515245u + 12345u;
+    const typename TImage::IndexType & idx = it.GetIndex();
+    unsigned int                       value = (state >> 16) % 8;
+    for (unsigned int d = 0; d < TImage::ImageDimension; ++d)
+    {
+      const itk::IndexValueType r = idx[d] % 13;
+      value += static_cast<unsigned int>(r < 6 ? r : 12 - r) * (10 + 5 * d);
+    }
+    // plateaus
+    if (idx[0] % 17 < 4)
+    {
+      value = (value / 20) * 20;
+    }
+    it.Set(static_cast<typename TImage::PixelType>(value));
+  }
+  return image;
+}
+
+// Small blobs of labels near the bottom of some of the basins, and a few
+// labels touching each other
+template <typename TLabelImage>
+typename TLabelImage::Pointer
+CreateMarkers(const typename TLabelImage::SizeType & size)
+{
+  auto image = TLabelImage::New();
+  image->SetRegions(size);
+  image->Allocate();
+
+  itk::ImageRegionIteratorWithIndex<TLabelImage> it(image, image->GetLargestPossibleRegion());
+  for (; !it.IsAtEnd(); ++it)
+  {
+    const typename TLabelImage::IndexType & idx = it.GetIndex();
+    bool                                    inside = true;
+    LabelPixelType                          label = 1;
+    for (unsigned int d = 0; d < TLabelImage::ImageDimension; ++d)
+    {
+      inside &= (idx[d] % 13 < 2);
+      label = static_cast<LabelPixelType>(label * 7 + idx[d] / 13);
+    }
+    if (idx[0] % 41 == 20)
+    {
+      inside = true;
+      label = static_cast<LabelPixelType>(1 + idx[0] % 2 + 2 * (idx[TLabelImage::ImageDimension - 1] / 29));
+    }
+    it.Set(inside ? static_cast<LabelPixelType>(label % 500 + 1) : LabelPixelType{ 0 });
+  }
+  return image;
+}
+
+// Offsets of the neighbors, in the order of the neighborhood
+template <typename TOffset>
+std::vector<TOffset>
+GetNeighbors(bool fullyConnected)
+{
+  constexpr unsigned int Dimension = TOffset::Dimension;
+  std::vector<TOffset>   neighbors;
+  unsigned int           numberOfNeighborhoodPixels = 1;
+  for (unsigned int d = 0; d < Dimension; ++d)
+  {
+    numberOfNeighborhoodPixels *= 3;
+  }
+  for (unsigned int i = 0; i < numberOfNeighborhoodPixels; ++i)
+  {
+    TOffset      offset;
+    unsigned int numberOfNonZero = 0;
+    for (unsigned int d = 0, rest = i; d < Dimension; ++d, rest /= 3)
+    {
+      offset[d] = static_cast<itk::OffsetValueType>(rest % 3) - 1;
+      numberOfNonZero += (offset[d] != 0);
+    }
+    if (numberOfNonZero != 0 && (fullyConnected || numberOfNonZero == 1))
+    {
+      neighbors.push_back(offset);
+    }
+  }
+  return neighbors;
+}
+
+// Straightforward serial implementation of the flooding, with a map of
+// queues of indices, used as a reference for the labels
+template <typename TImage, typename TLabelImage>
+typename TLabelImage::Pointer
+ReferenceWatershed(const TImage * input, const TLabelImage * markers, bool fullyConnected, bool markWatershedLine)
+{
+  constexpr unsigned int Dimension = TImage::ImageDimension;
+  using IndexType = typename TImage::IndexType;
+  using OffsetType = typename TImage::OffsetType;
+  using PixelType = typename TImage::PixelType;
+  const typename TImage::RegionType region = input->GetLargestPossibleRegion();
+
+  const std::vector<OffsetType> neighbors = GetNeighbors<OffsetType>(fullyConnected);
+
+  auto output = TLabelImage::New();
+  output->SetRegions(region);
+  output->Allocate();
+  output->FillBuffer(0);
+
+  using StatusImageType = itk::Image<unsigned char, Dimension>;
+  auto status = StatusImageType::New();
+  status->SetRegions(region);
+  status->Allocate();
+  status->FillBuffer(0);
+
+  std::map<PixelType, std::queue<IndexType>> fah;
+
+  itk::ImageRegionConstIteratorWithIndex<TLabelImage> it(markers, region);
+  for (; !it.IsAtEnd(); ++it)
+  {
+    const IndexType & idx = it.GetIndex();
+    if (it.Get() == 0)
+    {
+      continue;
+    }
+    output->SetPixel(idx, it.Get());
+    status->SetPixel(idx, 1);
+    for (const OffsetType & offset : neighbors)
+    {
+      const IndexType n = idx + offset;
+      if (region.IsInside(n) && markers->GetPixel(n) == 0)
+      {
+        if (markWatershedLine && !status->GetPixel(n))
+        {
+          fah[input->GetPixel(n)].push(n);
+          status->SetPixel(n, 1);
+        }
+        else if (!markWatershedLine)
+        {
+          fah[input->GetPixel(idx)].push(idx);
+          break;
+        }
+      }
+    }
+  }
+
+  while (!fah.empty())
+  {
+    const PixelType       currentValue = fah.begin()->first;
+    std::queue<IndexType> currentQueue = fah.begin()->second;
+    fah.erase(fah.begin());
+    while (!currentQueue.empty())
+    {
+      const IndexType idx = currentQueue.front();
+      currentQueue.pop();
+      if (markWatershedLine)
+      {
+        LabelPixelType label = 0;
+        bool           collision = false;
+        for (const OffsetType & offset : neighbors)
+        {
+          const IndexType n = idx + offset;
+          if (region.IsInside(n) && output->GetPixel(n) != 0)
+          {
+            collision |= (label != 0 && output->GetPixel(n) != label);
+            label = output->GetPixel(n);
+          }
+        }
+        if (collision)
+        {
+          continue;
+        }
+        output->SetPixel(idx, label);
+      }
+      for (const OffsetType & offset : neighbors)
+      {
+        const IndexType n = idx + offset;
+        if (!region.IsInside(n) || (markWatershedLine ? status->GetPixel(n) != 0 : output->GetPixel(n) != 0))
+        {
+          continue;
+        }
+        if (markWatershedLine)
+        {
+          status->SetPixel(n, 1);
+        }
+        else
+        {
+          output->SetPixel(n, output->GetPixel(idx));
+        }
+        if (input->GetPixel(n) <= currentValue)
+        {
+          currentQueue.push(n);
+        }
+        else
+        {
+          fah[input->GetPixel(n)].push(n);
+        }
+      }
+    }
+  }
+  return output;
+}
+
+template <typename TLabelImage>
+bool
+CompareImages(const TLabelImage * image, const TLabelImage * reference, const std::string & description)
+{
+  itk::ImageRegionConstIteratorWithIndex<TLabelImage> it(image, reference->GetLargestPossibleRegion());
+  itk::ImageRegionConstIterator<TLabelImage>          referenceIt(reference, reference->GetLargestPossibleRegion());
+  for (; !referenceIt.IsAtEnd(); ++it, ++referenceIt)
+  {
+    if (it.Get() != referenceIt.Get())
+    {
+      std::cerr << "Test failed for " << description << std::endl;
+      std::cerr << "Error at index " << it.GetIndex() << std::endl;
+      std::cerr << "Expected: " << referenceIt.Get() << ", but got: " << it.Get() << std::endl;
+      return false;
+    }
+  }
+  return true;
+}
+
+// Checks that the labels of a watershed computed with a schedule dependent
+// order are still valid: the markers are kept, the labels which are not
+// markers are separated by watershed pixels if they are marked, and all the
+// pixels are labeled otherwise, as all the basins of the test images have a
+// marker.
+template <typename TLabelImage>
+bool
+CheckLabels(const TLabelImage * image,
+            const TLabelImage * markers,
+            bool                fullyConnected,
+            bool                markWatershedLine,
+            const std::string & description)
+{
+  using IndexType = typename TLabelImage::IndexType;
+  using OffsetType = typename TLabelImage::OffsetType;
+  const typename TLabelImage::RegionType region = markers->GetLargestPossibleRegion();
+
+  const std::vector<OffsetType> neighbors = GetNeighbors<OffsetType>(fullyConnected);
+
+  itk::ImageRegionConstIteratorWithIndex<TLabelImage> it(image, region);
+  for (; !it.IsAtEnd(); ++it)
+  {
+    const IndexType &    idx = it.GetIndex();
+    const LabelPixelType label = it.Get();
+    const LabelPixelType marker = markers->GetPixel(idx);
+    bool                 valid = (marker == 0 || label == marker) && (markWatershedLine || label != 0);
+    if (markWatershedLine && label != 0)
+    {
+      for (const OffsetType & offset : neighbors)
+      {
+        const IndexType n = idx + offset;
+        valid &= !region.IsInside(n) || image->GetPixel(n) == 0 || image->GetPixel(n) == label ||
+                 (marker != 0 && markers->GetPixel(n) != 0);
+      }
+    }
+    if (!valid)
+    {
+      std::cerr << "Test failed for " << description << std::endl;
+      std::cerr << "Invalid label " << label << " at index " << idx << std::endl;
+      return false;
+    }
+  }
+  return true;
+}
+
+// Compares the labels of the filter with the reference for both
+// algorithms, both connectivities and several numbers of work units, and
+// prints the throughput of both. Without the deterministic mode, the
+// labels only have to be valid when several work units are used.
+template <unsigned int VDimension, typename TPixel>
+bool
+CheckWatershed(const itk::Size<VDimension> & size, const std::string & description)
+{
+  using ImageType = itk::Image<TPixel, VDimension>;
+  using LabelImageType = itk::Image<LabelPixelType, VDimension>;
+  using FilterType = itk::MorphologicalWatershedFromMarkersImageFilter<ImageType, LabelImageType>;
+
+  const typename ImageType::Pointer      image = CreateImage<ImageType>(size);
+  const typename LabelImageType::Pointer markers = CreateMarkers<LabelImageType>(size);
+  const double numberOfPixels = static_cast<double>(image->GetLargestPossibleRegion().GetNumberOfPixels());
+
+  bool passed = true;
+  for (bool markWatershedLine : { true, false })
+  {
+    for (bool fullyConnected : { false, true })
+    {
+      const std::string name = description + (markWatershedLine ? ", lines" : ", no lines") +
+                               (fullyConnected ? ", fully connected" : ", face connected");
+
+      itk::TimeProbe referenceProbe;
+      referenceProbe.Start();
+      const typename LabelImageType::Pointer reference =
+        ReferenceWatershed<ImageType, LabelImageType>(image, markers, fullyConnected, markWatershedLine);
+      referenceProbe.Stop();
+      std::cout << name << ": reference " << numberOfPixels / referenceProbe.GetTotal() / 1e6 << " Mpixels/s"
+                << std::endl;
+
+      for (bool deterministic : { true, false })
+      {
+        for (itk::ThreadIdType numberOfWorkUnits : { 1, 3, 8 })
+        {
+          auto filter = FilterType::New();
+          filter->SetInput(image);
+          filter->SetMarkerImage(markers);
+          filter->SetFullyConnected(fullyConnected);
+          filter->SetMarkWatershedLine(markWatershedLine);
+          filter->SetDeterministic(deterministic);
+          filter->SetNumberOfWorkUnits(numberOfWorkUnits);
+
+          itk::TimeProbe probe;
+          probe.Start();
+          filter->Update();
+          probe.Stop();
+
+          const std::string filterName = name + (deterministic ? ", deterministic, " : ", ") +
+                                         std::to_string(numberOfWorkUnits) + " work units";
+          std::cout << filterName << ": filter " << numberOfPixels / probe.GetTotal() / 1e6 << " Mpixels/s"
+                    << std::endl;
+          if (deterministic || numberOfWorkUnits == 1)
+          {
+            passed &= CompareImages<LabelImageType>(filter->GetOutput(), reference, filterName);
+          }
+          else
+          {
+            passed &= CheckLabels<LabelImageType>(
+              filter->GetOutput(), markers, fullyConnected, markWatershedLine, filterName);
+          }
+        }
+      }
+    }
+  }
+  return passed;
+}
+} // namespace
+
+// Checks that the labels of the watershed from markers in the deterministic
+// mode do not depend on the number of work units and are the same as the
+// ones of a serial priority flood, for several image dimensions and pixel
+// types, and prints the throughput of both. The largest image has waves
+// large enough to be flooded in parallel.
+int
+itkMorphologicalWatershedFromMarkersImageFilterParallelTest(int, char *[])
+{
+  bool passed = true;
+
+  // The labels are the ones of the serial flooding by default
+  using FilterType =
+    itk::MorphologicalWatershedFromMarkersImageFilter<itk::Image<unsigned char, 2>, itk::Image<LabelPixelType, 2>>;
+  if (!FilterType::New()->GetDeterministic())
+  {
+    std::cerr << "The watershed is not deterministic by default" << std::endl;
+    passed = false;
+  }
+
+  passed &= CheckWatershed<2, unsigned char>(itk::Size<2>{ { 157, 131 } }, "2D 8 bit");
+  passed &= CheckWatershed<2, float>(itk::Size<2>{ { 157, 131 } }, "2D float");
+  passed &= CheckWatershed<3, unsigned char>(itk::Size<3>{ { 61, 53, 47 } }, "3D 8 bit");
+  passed &= CheckWatershed<3, unsigned short>(itk::Size<3>{ { 61, 53, 47 } }, "3D 16 bit");
+  passed &= CheckWatershed<3, short>(itk::Size<3>{ { 40, 30, 2 } }, "3D signed 16 bit, 2 planes");
+  passed &= CheckWatershed<3, unsigned char>(itk::Size<3>{ { 150, 140, 60 } }, "3D 8 bit, large waves");
+
+  std::cout << "Test finished." << std::endl;
+  return passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,202 @@
+/*=========================================================================
+ *
+ *  Copyright NumFOCUS
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include "itkImageRegionIteratorWithIndex.h"
+#include "itkImageRegionSplitterMultidimensional.h"
+#include "itkStreamingImageFilter.h"
+#include "itkTestingMacros.h"
+#include "itkWatershedImageFilter.h"
+#include <algorithm>
+#include <cmath>
+#include <map>
+
+namespace
+{
+// Smooth hills and valleys, with a little noise so that there are no
+// plateaus
+template <typename TImage>
+typename TImage::Pointer
+CreateImage(const typename TImage::SizeType & size)
+{
+  auto image = TImage::New();
+  image->SetRegions(size);
+  image->Allocate();
+
+  itk::ImageRegionIteratorWithIndex<TImage> it(image, image->GetLargestPossibleRegion());
+  unsigned int                              state = 97531;
+  for (; !it.IsAtEnd(); ++it)
+  {
+    state = state * 1103515245u + 12345u;
+    const typename TImage::IndexType & idx = it.GetIndex();
+    double                             value = 1e-4 * ((state >> 8) % 10000);
+    for (unsigned int d = 0; d < TImage::ImageDimension; ++d)
+    {
+      value += std::sin(0.31 * idx[d] + d) + 0.5 * std::cos(0.17 * idx[d] * (d + 1) + 0.2 * idx[0]);
+    }
+    it.Set(static_cast<typename TImage::PixelType>(value * value));
+  }
+  return image;
+}
+
+// Checks that both label images define the same partition of the image,
+// that is, that their labels are the same up to a one to one mapping.  When
+// the merges of the flooding have ties, which may be resolved differently
+// for the streamed segmentation, only the numbers of segments must be the
+// same, and a few pixels may be in other segments.
+template <typename TLabelImage>
+bool
+ComparePartitions(const TLabelImage * image,
+                  const TLabelImage * reference,
+                  bool                exact,
+                  const std::string & description)
+{
+  using LabelType = typename TLabelImage::PixelType;
+  std::map<std::pair<LabelType, LabelType>, itk::SizeValueType> overlaps;
+  std::map<LabelType, itk::SizeValueType>                       largestOverlaps;
+  std::map<LabelType, itk::SizeValueType>                       referenceLabels;
+
+  itk::ImageRegionConstIterator<TLabelImage> it(image, reference->GetLargestPossibleRegion());
+  itk::ImageRegionConstIterator<TLabelImage> referenceIt(reference, reference->GetLargestPossibleRegion());
+  for (; !referenceIt.IsAtEnd(); ++it, ++referenceIt)
+  {
+    const itk::SizeValueType overlap = ++overlaps[std::make_pair(it.Get(), referenceIt.Get())];
+    largestOverlaps[it.Get()] = std::max(largestOverlaps[it.Get()], overlap);
+    ++referenceLabels[referenceIt.Get()];
+  }
+
+  // Pixels outside of the largest overlap of their segment
+  const itk::SizeValueType numberOfPixels = reference->GetLargestPossibleRegion().GetNumberOfPixels();
+  itk::SizeValueType       mismatches = numberOfPixels;
+  for (const auto & largestOverlap : largestOverlaps)
+  {
+    mismatches -= largestOverlap.second;
+  }
+  std::cout << description << ": " << referenceLabels.size() << " segments, " << mismatches << " mismatches"
+            << std::endl;
+
+  const bool sameNumberOfSegments = largestOverlaps.size() == referenceLabels.size();
+  const bool fewMismatches = exact ? mismatches == 0 : 100 * mismatches <= numberOfPixels;
+  if (!sameNumberOfSegments || !fewMismatches)
+  {
+    std::cerr << "Test failed for " << description << std::endl;
+    std::cerr << largestOverlaps.size() << " segments for " << referenceLabels.size() << " reference segments, "
+              << mismatches << " pixels in other segments" << std::endl;
+    return false;
+  }
+  return true;
+}
+
+// Compares the streamed segmentation with the one of the whole image, for
+// several numbers of chunks and levels, and when the output is streamed too
+template <typename TImage>
+bool
+CheckStreaming(const typename TImage::SizeType & size, double threshold, const std::string & description)
+{
+  using FilterType = itk::WatershedImageFilter<TImage>;
+  using LabelImageType = typename FilterType::OutputImageType;
+
+  const typename TImage::Pointer image = CreateImage<TImage>(size);
+
+  bool passed = true;
+  for (double level : { 0.0, 0.05, 0.3 })
+  {
+    auto reference = FilterType::New();
+    reference->SetInput(image);
+    reference->SetThreshold(threshold);
+    reference->SetLevel(level);
+    reference->Update();
+
+    for (unsigned int numberOfStreamDivisions : { 2, 5 })
+    {
+      for (bool multidimensional : { false, true })
+      {
+        const std::string name = description + ", level " + std::to_string(level) + ", " +
+                                 std::to_string(numberOfStreamDivisions) +
+                                 (multidimensional ? " multidimensional chunks" : " slabs");
+
+        auto filter = FilterType::New();
+        filter->SetInput(image);
+        filter->SetThreshold(threshold);
+        filter->SetLevel(level);
+        filter->SetNumberOfStreamDivisions(numberOfStreamDivisions);
+        if (multidimensional)
+        {
+          filter->SetRegionSplitter(itk::ImageRegionSplitterMultidimensional::New());
+        }
+        filter->Update();
+        passed &= ComparePartitions<LabelImageType>(filter->GetOutput(), reference->GetOutput(), level == 0.0, name);
+
+        // The output streamed downstream, which only segments again the
+        // chunks under each piece
+        using StreamingFilterType = itk::StreamingImageFilter<LabelImageType, LabelImageType>;
+        auto streamer = StreamingFilterType::New();
+        streamer->SetInput(filter->GetOutput());
+        streamer->SetNumberOfStreamDivisions(3);
+        streamer->Update();
+        passed &= ComparePartitions<LabelImageType>(
+          streamer->GetOutput(), reference->GetOutput(), level == 0.0, name + ", streamed");
+      }
+    }
+  }
+  return passed;
+}
+} // namespace
+
+// Checks that the watershed segmentation computed one chunk at a time,
+// with the boundaries between the chunks resolved afterwards, is the same
+// as the one of the whole image.
+int
+itkWatershedImageFilterStreamingTest(int, char *[])
+{
+  bool passed = true;
+
+  passed &= CheckStreaming<itk::Image<float, 2>>(itk::Size<2>{ { 83, 71 } }, 0.0, "2D");
+  passed &= CheckStreaming<itk::Image<float, 2>>(itk::Size<2>{ { 83, 71 } }, 0.1, "2D, thresholded");
+  passed &= CheckStreaming<itk::Image<double, 3>>(itk::Size<3>{ { 31, 27, 23 } }, 0.0, "3D");
+
+  // Lowering the level only relabels with the merge tree computed so far,
+  // and raising it above the highest level computed so far merges more
+  // segments, as without streaming
+  {
+    using ImageType = itk::Image<float, 2>;
+    using FilterType = itk::WatershedImageFilter<ImageType>;
+    const ImageType::Pointer image = CreateImage<ImageType>(itk::Size<2>{ { 60, 50 } });
+
+    auto reference = FilterType::New();
+    reference->SetInput(image);
+    ITK_TEST_SET_GET_VALUE(1u, reference->GetNumberOfStreamDivisions());
+
+    auto filter = FilterType::New();
+    filter->SetInput(image);
+    filter->SetNumberOfStreamDivisions(4);
+    ITK_TEST_SET_GET_VALUE(4u, filter->GetNumberOfStreamDivisions());
+    for (double level : { 0.2, 0.05, 0.4 })
+    {
+      reference->SetLevel(level);
+      ITK_TRY_EXPECT_NO_EXCEPTION(reference->Update());
+
+      filter->SetLevel(level);
+      ITK_TRY_EXPECT_NO_EXCEPTION(filter->Update());
+      passed &= ComparePartitions<FilterType::OutputImageType>(
+        filter->GetOutput(), reference->GetOutput(), false, "level changed to " + std::to_string(level));
+    }
+  }
+
+  std::cout << "Test finished." << std::endl;
+  return passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}